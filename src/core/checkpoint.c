@@ -5,20 +5,34 @@
 // Checkpoint file I/O: open/close, block read/write, file serialization.
 // Extracted from system.c to support multi-machine checkpoint handling.
 //
-// Two on-disk formats:
-//   v2 (GSCHKPT2) — per-block RLE with file/line metadata; used for consolidated checkpoints
-//   v3 (GSCHKPT3) — whole-file RLE, no per-block metadata; used for quick checkpoints
+// On-disk formats:
+//   v2 (GSCHKPT2) — per-block chunked LZ (legacy RLE still read) with file/line metadata;
+//                   used for consolidated checkpoints; in the mapped layout the RAM block
+//                   is stored raw at a 64 KB file offset so restore can mmap it
+//   v3 (GSCHKPT3) — whole-file RLE, no per-block metadata; read-only (former quick format)
+//   v4 (GSCHKPT4) — quick checkpoints: a base record followed by delta records that carry
+//                   only the RAM pages written since the previous record
+//
+// Either kind may also be saved asynchronously: capture fills memory on the
+// caller's thread, and a writer thread produces the same bytes on disk.
 
 #include "checkpoint.h"
 #include "build_id.h"
+#include "chunk_lz.h"
 #include "object.h"
+#include "snapshot_pool.h"
 #include "system.h"
 #include "value.h"
 
+#include <errno.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // v2 signature for consolidated (full export) checkpoints
 static const char CHECKPOINT_MAGIC_V2[] = "GSCHKPT2";
@@ -26,11 +40,28 @@ static const char CHECKPOINT_MAGIC_V2[] = "GSCHKPT2";
 // v3 signature for quick (background auto-save) checkpoints
 static const char CHECKPOINT_MAGIC_V3[] = "GSCHKPT3";
 
-// Both signatures share the same length
+// v4 signature for quick checkpoints with incremental RAM records
+static const char CHECKPOINT_MAGIC_V4[] = "GSCHKPT4";
+
+// All signatures share the same length
 #define CHECKPOINT_MAGIC_LEN 8
 
-// Blocks >= this size use RLE compression (v2 only)
-#define RLE_THRESHOLD 64
+// Blocks >= this size are stored as a chunked LZ stream (v2 only)
+#define COMPRESS_THRESHOLD 64
+
+// File alignment of a mapped RAM block's data (covers 4, 16 and 64 KB host pages)
+#define CHECKPOINT_MAP_ALIGN 65536u
+
+// Pooled checkpoints: blocks >= this size go to the pool, as 4 KB pages (RAM)
+// or 64 KB pieces (everything else)
+#define POOL_MIN_BLOCK  4096u
+#define POOL_PAGE_PIECE 4096u
+#define POOL_BLOB_PIECE CHUNK_LZ_CHUNK_SIZE
+#define POOL_MAX_PIECE  (1024u * 1024u)
+
+// Pooled checkpoints end with the list of objects they reference:
+//   snapshot_hash_t refs[count], uint64 count, magic
+static const char CHECKPOINT_POOL_REFS_MAGIC[] = "GSPOOLRF";
 
 // Fixed-size model ID field in checkpoint headers (null-padded)
 #define MODEL_ID_LEN 16
@@ -48,63 +79,62 @@ static const char CHECKPOINT_MAGIC_V3[] = "GSCHKPT3";
 // Persistent write buffer for quick checkpoints (allocated once, reused)
 static uint8_t *g_quick_write_buf = NULL;
 
-// === RLE Compression ===
-// Format: sequence of chunks, each either:
+// Compressed copy of a quick record payload (grown on demand, reused)
+static uint8_t *g_quick_pack_buf = NULL;
+static size_t g_quick_pack_cap = 0;
+
+// === v4 quick format ===
+// After the header (magic, build ID, model ID, RAM size) a v4 file is a log of
+// records: one BASE record, then DELTA records appended by later quick
+// checkpoints to the same file.  Each record is a header, a payload and a
+// trailer repeating the header.  The payload is a chunk_lz stream of the v3
+// block layout ({uint32 size, bytes} per block); a record whose trailer is missing or wrong (a torn append) ends the
+// log, so a crash mid-append falls back to the previous record.
+//
+// The RAM block is tagged in the payload: {QUICK_RAM_BLOCK, uint32 ram_size,
+// uint32 count} followed by either the raw RAM (count == QUICK_RAM_FULL) or
+// `count` pages of {uint32 page index, page bytes}.  Every other block is
+// stored in full in every record, so the newest record holds all non-RAM
+// state and the reader rebuilds RAM by applying each record's pages in order.
+#define QUICK_REC_BASE  0x45534142u // "BASE"
+#define QUICK_REC_DELTA 0x41544C44u // "DLTA"
+#define QUICK_REC_END   0x21444E45u // "END!"
+#define QUICK_RAM_BLOCK UINT32_MAX // block size field that tags the RAM block
+#define QUICK_RAM_FULL  UINT32_MAX // RAM block page count: raw RAM follows
+#define QUICK_PAGE_SIZE 4096u // RAM page granularity (matches memory.h pages)
+
+// Compaction: the next quick checkpoint rewrites the file as a fresh base once
+// the chain holds this many deltas or its deltas outweigh half the base
+#define QUICK_MAX_DELTAS 32
+
+// Bytes before the first v4 record: magic, build ID, model ID, RAM size
+#define QUICK_HEADER_BYTES (CHECKPOINT_MAGIC_LEN + BUILD_ID_LEN + MODEL_ID_LEN + sizeof(uint32_t))
+
+// Header and trailer of one v4 record
+typedef struct quick_record {
+    uint32_t tag; // QUICK_REC_BASE / QUICK_REC_DELTA (header), QUICK_REC_END (trailer)
+    uint32_t seq; // 0 for the base, +1 per delta
+    uint64_t size; // payload bytes (compressed)
+} quick_record_t;
+
+// The quick checkpoint file that the next quick save may extend
+static struct {
+    bool valid; // false: the next quick save writes a fresh base
+    char *path;
+    char model_id[MODEL_ID_LEN];
+    uint32_t ram_size_kb;
+    uint32_t seq; // seq of the last committed record
+    uint64_t end; // file size after the last committed record
+    uint64_t base_bytes; // stored payload bytes of the base record
+    uint64_t delta_bytes; // stored payload bytes of all deltas since the base
+} g_quick_chain;
+
+// === RLE Decompression ===
+// Blocks written by older builds (v2 flag 0x01, compressed v3 files) use a
+// byte RLE; new files use chunk_lz.  Format: sequence of chunks, each either:
 //   LIT chunk: marker=0x00, uint32_t count, <count raw bytes>
 //   RUN chunk: marker=0x01, uint32_t count, uint8_t value
 
-// RLE-encode data into output buffer. Returns compressed size, 0 on overflow.
-// If out is NULL, performs a dry run and returns the exact compressed size needed.
-static size_t rle_encode(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_cap) {
-    size_t op = 0;
-    size_t i = 0;
-
-    while (i < in_size) {
-        // check for a run of 4+ identical bytes
-        size_t rs = i;
-        uint8_t val = in[i];
-        while (i < in_size && in[i] == val && (i - rs) < 0xFFFFFFFFu)
-            i++;
-        size_t run_len = i - rs;
-
-        if (run_len >= 4) {
-            // emit RUN chunk: marker(1) + count(4) + value(1) = 6 bytes
-            if (out) {
-                if (op + 6 > out_cap)
-                    return 0;
-                out[op] = 0x01;
-                uint32_t c = (uint32_t)run_len;
-                memcpy(out + op + 1, &c, 4);
-                out[op + 5] = val;
-            }
-            op += 6;
-        } else {
-            // collect literal bytes until the next run of 4+
-            i = rs;
-            size_t ls = i;
-            while (i < in_size) {
-                if (i + 3 < in_size && in[i] == in[i + 1] && in[i] == in[i + 2] && in[i] == in[i + 3])
-                    break;
-                i++;
-                if ((i - ls) >= 0xFFFFFFFFu)
-                    break;
-            }
-            size_t lit_len = i - ls;
-            // emit LIT chunk: marker(1) + count(4) + data(lit_len)
-            if (out) {
-                if (op + 5 + lit_len > out_cap)
-                    return 0;
-                out[op] = 0x00;
-                uint32_t c = (uint32_t)lit_len;
-                memcpy(out + op + 1, &c, 4);
-                memcpy(out + op + 5, in + ls, lit_len);
-            }
-            op += 5 + lit_len;
-        }
-    }
-    return op;
-}
-
 // RLE-decode compressed data into output buffer. Returns true on success.
 static bool rle_decode(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size) {
     size_t ip = 0, op = 0;
@@ -158,12 +188,53 @@ struct checkpoint {
     char model_id[MODEL_ID_LEN];
     // RAM size in KB stored in checkpoint header (0 = use machine default)
     uint32_t ram_size_kb;
+    // v4 quick write: target path, and whether this save appends a delta record
+    char *path;
+    bool quick_delta;
+    // Consolidated write: store RAM page-aligned and raw so it can be mapped
+    bool ram_mapped;
+    // Pooled (snapshot store) checkpoint: the object pool next to the file
+    // or in memory (read and write), and the objects written so far (write)
+    char *pool_dir;
+    snapshot_mem_pool_t *mem_pool;
+    snapshot_hash_set_t *pool_refs;
+    // Asynchronous save: a consolidated capture streams into mem (file is an
+    // open_memstream) and the writer copies it to out; a quick capture keeps
+    // using buf, with room reserved for the RAM pages
+    bool async;
+    FILE *out;
+    char *mem;
+    size_t mem_size;
+    // Deferred RAM block: the snapshot reader, where the block goes (offset
+    // in mem, or of its first page in buf), and the pages a delta carries
+    checkpoint_ram_read_fn ram_read;
+    checkpoint_ram_release_fn ram_release; // non-NULL while the snapshot is owned
+    void *ram_ctx;
+    size_t ram_size;
+    size_t ram_at;
+    uint32_t *ram_pages; // NULL = all of RAM
+    uint32_t ram_page_count;
+    const char *ram_file;
+    int ram_line;
+    // Completion hook (checkpoint_close_async)
+    checkpoint_done_fn done;
+    void *done_ctx;
 };
 
+// Asynchronous save bookkeeping: one writer in flight at a time
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t idle; // signalled when busy drops
+    bool busy;
+    checkpoint_save_state_t state;
+    char error[256];
+    char error_copy[256]; // stable copy handed out by checkpoint_last_error
+} g_async = {.lock = PTHREAD_MUTEX_INITIALIZER, .idle = PTHREAD_COND_INITIALIZER};
+
 // === v3 buffer helpers ===
 
-// Append raw bytes to the accumulation buffer, return true on success
-static bool buf_append(checkpoint_t *cp, const void *data, size_t len) {
+// Grow the accumulation buffer by len bytes; returns where they start, or NULL
+static uint8_t *buf_reserve(checkpoint_t *cp, size_t len) {
     if (cp->buf_used + len > cp->buf_cap) {
         // Grow the buffer to fit (double or exact fit, whichever is larger)
         size_t needed = cp->buf_used + len;
@@ -174,7 +245,7 @@ static bool buf_append(checkpoint_t *cp, const void *data, size_t len) {
         if (!new_buf) {
             printf("Error: Quick checkpoint buffer realloc failed (%zu bytes)\n", new_cap);
             cp->error = true;
-            return false;
+            return NULL;
         }
         cp->buf = new_buf;
         cp->buf_cap = new_cap;
@@ -182,8 +253,17 @@ static bool buf_append(checkpoint_t *cp, const void *data, size_t len) {
         if (!cp->buf_owned)
             g_quick_write_buf = new_buf;
     }
-    memcpy(cp->buf + cp->buf_used, data, len);
+    uint8_t *at = cp->buf + cp->buf_used;
     cp->buf_used += len;
+    return at;
+}
+
+// Append raw bytes to the accumulation buffer, return true on success
+static bool buf_append(checkpoint_t *cp, const void *data, size_t len) {
+    uint8_t *at = buf_reserve(cp, len);
+    if (!at)
+        return false;
+    memcpy(at, data, len);
     return true;
 }
 
@@ -199,34 +279,191 @@ static bool buf_read(checkpoint_t *cp, void *data, size_t len) {
     return true;
 }
 
+// === v4 quick chain ===
+
+// Forget the chain: the next quick save writes a fresh base
+static void quick_chain_reset(void) {
+    free(g_quick_chain.path);
+    memset(&g_quick_chain, 0, sizeof(g_quick_chain));
+}
+
+// True when a quick save to filename can append a delta to the current chain
+static bool quick_chain_extends(const char *filename, const char *model_id, uint32_t ram_size_kb) {
+    if (!g_quick_chain.valid || !filename || strcmp(g_quick_chain.path, filename) != 0)
+        return false;
+    if (strncmp(g_quick_chain.model_id, model_id ? model_id : "", MODEL_ID_LEN - 1) != 0 ||
+        g_quick_chain.ram_size_kb != ram_size_kb)
+        return false;
+    // Compaction: fold the deltas back into a fresh base
+    if (g_quick_chain.seq >= QUICK_MAX_DELTAS || g_quick_chain.delta_bytes * 2 > g_quick_chain.base_bytes)
+        return false;
+    // The file must still be exactly what the chain last committed
+    struct stat st;
+    return stat(filename, &st) == 0 && (uint64_t)st.st_size == g_quick_chain.end;
+}
+
+// Write one v4 record (header, payload, trailer); returns true when all of it reached the file
+static bool quick_write_record(FILE *f, uint32_t tag, uint32_t seq, const uint8_t *payload, size_t size) {
+    quick_record_t head = {.tag = tag, .seq = seq, .size = (uint64_t)size};
+    quick_record_t tail = {.tag = QUICK_REC_END, .seq = seq, .size = (uint64_t)size};
+    if (fwrite(&head, 1, sizeof(head), f) != sizeof(head))
+        return false;
+    if (fwrite(payload, 1, size, f) != size)
+        return false;
+    if (fwrite(&tail, 1, sizeof(tail), f) != sizeof(tail))
+        return false;
+    return fflush(f) == 0;
+}
+
+// Compress a record payload into g_quick_pack_buf; *packed receives its size
+static bool quick_pack(const uint8_t *payload, size_t size, size_t *packed) {
+    size_t need = chunk_lz_bound(size);
+    if (need > g_quick_pack_cap) {
+        uint8_t *grown = (uint8_t *)realloc(g_quick_pack_buf, need);
+        if (!grown) {
+            printf("Error: Out of memory for quick checkpoint compression (%zu bytes)\n", need);
+            return false;
+        }
+        g_quick_pack_buf = grown;
+        g_quick_pack_cap = need;
+    }
+    *packed = chunk_lz_encode(payload, size, g_quick_pack_buf, g_quick_pack_cap);
+    return *packed != 0;
+}
+
 // === Block I/O ===
 
-// Read a data block with size validation, source metadata, and RLE decompression
-void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_t size, const char *file, int line) {
-    if (!checkpoint || checkpoint->error || checkpoint->is_writing) {
-        printf("Error: Invalid checkpoint handle for reading\n");
-        if (checkpoint)
-            checkpoint->error = true;
-        return;
+// Store one piece as a pool object and write its hash.  An in-memory
+// checkpoint takes one reference per distinct object it names.
+static bool pool_write_piece(checkpoint_t *checkpoint, const uint8_t *data, size_t len) {
+    snapshot_hash_t hash;
+    bool added = false;
+    if (checkpoint->mem_pool) {
+        snapshot_hash(data, len, &hash);
+        if (!snapshot_hash_set_add(checkpoint->pool_refs, &hash, NULL, &added) ||
+            (added && !snapshot_mem_pool_ref(checkpoint->mem_pool, &hash, data, len)))
+            return false;
+    } else if (!snapshot_pool_put(checkpoint->pool_dir, data, len, &hash) ||
+               !snapshot_hash_set_add(checkpoint->pool_refs, &hash, NULL, NULL)) {
+        return false;
     }
+    return fwrite(&hash, 1, sizeof(hash), checkpoint->file) == sizeof(hash);
+}
 
-    // v3 buffered read: pull size header + raw data from decompressed buffer
-    if (checkpoint->buf) {
-        uint32_t stored_size = 0;
-        if (!buf_read(checkpoint, &stored_size, sizeof(stored_size)))
-            return;
-        if ((size_t)stored_size != size) {
-            printf("Error: v3 checkpoint size mismatch: expected %zu but got %u at %s:%d\n", size, stored_size,
-                   file ? file : "(unknown)", line);
-            checkpoint->error = true;
-            return;
+// Load one pool object of len bytes into dest
+static bool pool_read_piece(checkpoint_t *checkpoint, const snapshot_hash_t *hash, uint8_t *dest, size_t len) {
+    if (checkpoint->mem_pool)
+        return snapshot_mem_pool_get(checkpoint->mem_pool, hash, dest, len);
+    return snapshot_pool_get(checkpoint->pool_dir, hash, dest, len);
+}
+
+// Write a piece list header: uint32 piece size, uint32 count (hashes follow)
+static bool pool_write_list_head(checkpoint_t *checkpoint, uint64_t size, uint32_t piece) {
+    uint32_t count = (uint32_t)((size + piece - 1) / piece);
+    return fwrite(&piece, 1, sizeof(piece), checkpoint->file) == sizeof(piece) &&
+           fwrite(&count, 1, sizeof(count), checkpoint->file) == sizeof(count);
+}
+
+// Store data as pool objects of piece bytes each and write the piece list
+static bool pool_write_pieces(checkpoint_t *checkpoint, const uint8_t *data, uint64_t size, uint32_t piece) {
+    if (!pool_write_list_head(checkpoint, size, piece))
+        return false;
+    for (uint64_t off = 0; off < size; off += piece) {
+        size_t len = size - off < piece ? (size_t)(size - off) : piece;
+        if (!pool_write_piece(checkpoint, data + off, len))
+            return false;
+    }
+    return true;
+}
+
+// Read a piece list describing size bytes and load its objects into dest,
+// keeping the first capacity bytes.  Pieces repeated within the list (zero
+// pages, mostly) are loaded once.
+static bool pool_read_pieces(checkpoint_t *checkpoint, uint8_t *dest, uint64_t size, size_t capacity) {
+    uint32_t piece = 0, count = 0;
+    if (fread(&piece, 1, sizeof(piece), checkpoint->file) != sizeof(piece) ||
+        fread(&count, 1, sizeof(count), checkpoint->file) != sizeof(count) || piece == 0 ||
+        piece > POOL_MAX_PIECE || (uint64_t)count != (size + piece - 1) / piece ||
+        (uint64_t)count * sizeof(snapshot_hash_t) > CHECKPOINT_MAX_ALLOC) {
+        printf("Error: Bad pooled block header in checkpoint\n");
+        return false;
+    }
+    if (!checkpoint->pool_dir && !checkpoint->mem_pool) {
+        printf("Error: Checkpoint references a snapshot pool but has none\n");
+        return false;
+    }
+    snapshot_hash_t *hashes = (snapshot_hash_t *)malloc(count ? count * sizeof(snapshot_hash_t) : 1);
+    uint32_t *first = (uint32_t *)malloc(count ? count * sizeof(uint32_t) : 1);
+    snapshot_hash_set_t *seen = snapshot_hash_set_new();
+    uint8_t *partial = NULL;
+    bool ok = hashes && first && seen && fread(hashes, sizeof(snapshot_hash_t), count, checkpoint->file) == count;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint64_t off = (uint64_t)i * piece;
+        size_t len = size - off < piece ? (size_t)(size - off) : piece;
+        if (!dest || off >= capacity)
+            continue;
+        if (off + len > capacity) {
+            // Only the front of this piece fits
+            partial = partial ? partial : (uint8_t *)malloc(piece);
+            ok = partial && pool_read_piece(checkpoint, &hashes[i], partial, len);
+            if (ok)
+                memcpy(dest + off, partial, capacity - (size_t)off);
+        } else if (len == piece) {
+            size_t index = 0;
+            bool added = false;
+            ok = snapshot_hash_set_add(seen, &hashes[i], &index, &added);
+            if (ok && added) {
+                first[index] = i;
+                ok = pool_read_piece(checkpoint, &hashes[i], dest + off, len);
+            } else if (ok) {
+                memcpy(dest + off, dest + (size_t)first[index] * piece, len);
+            }
+        } else {
+            ok = pool_read_piece(checkpoint, &hashes[i], dest + off, len);
+        }
+        if (!ok) {
+            char hex[SNAPSHOT_HASH_LEN * 2 + 1];
+            snapshot_hash_hex(&hashes[i], hex);
+            printf("Error: Snapshot object %s is missing or damaged\n", hex);
         }
-        if (!buf_read(checkpoint, data, size))
-            return;
-        return;
     }
+    free(hashes);
+    free(first);
+    free(partial);
+    snapshot_hash_set_free(seen);
+    return ok;
+}
+
+// Map a page-aligned raw block copy-on-write over data; false when the
+// platform, alignment or file size rules it out (the caller then reads it)
+static bool v2_map_block(checkpoint_t *checkpoint, void *data, size_t size, uint64_t data_at) {
+#ifdef __EMSCRIPTEN__
+    (void)checkpoint;
+    (void)data;
+    (void)size;
+    (void)data_at;
+    return false;
+#else
+    long page = sysconf(_SC_PAGESIZE);
+    struct stat st;
+    int fd = fileno(checkpoint->file);
+    if (page <= 0 || size == 0 || size % (size_t)page || (uintptr_t)data % (uintptr_t)page ||
+        data_at % (uint64_t)page || fd < 0 || fstat(fd, &st) != 0 || (uint64_t)st.st_size < data_at + size)
+        return false;
+    if (mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, (off_t)data_at) == data)
+        return true;
+    // A failed fixed mapping may already have dropped the old pages
+    mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    return false;
+#endif
+}
 
-    // v2 per-block read path with file/line metadata
+// v2 per-block read path with file/line metadata.  With may_map, a
+// page-aligned raw block is mapped over data instead of copied; returns true
+// when that happened.
+static bool v2_read_block(checkpoint_t *checkpoint, void *data, size_t size, bool may_map, const char *file,
+                          int line) {
+    bool mapped = false;
 
     // Read size header
     uint64_t stored_size = 0;
@@ -234,7 +471,7 @@ void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_
     if (got != sizeof(stored_size)) {
         printf("Error: Failed to read size header from checkpoint (got %zu)\n", got);
         checkpoint->error = true;
-        return;
+        return false;
     }
 
     // Read filename length and filename (for diagnostics)
@@ -243,7 +480,7 @@ void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_
     if (got != sizeof(fname_len)) {
         printf("Error: Failed to read filename length from checkpoint (got %zu)\n", got);
         checkpoint->error = true;
-        return;
+        return false;
     }
 
     char *saved_file = NULL;
@@ -252,14 +489,14 @@ void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_
         if (!saved_file) {
             printf("Error: Out of memory reading checkpoint filename\n");
             checkpoint->error = true;
-            return;
+            return false;
         }
         got = fread(saved_file, 1, fname_len, checkpoint->file);
         if (got != fname_len) {
             printf("Error: Failed to read filename from checkpoint (got %zu, expected %u)\n", got, fname_len);
             free(saved_file);
             checkpoint->error = true;
-            return;
+            return false;
         }
         saved_file[fname_len] = '\0';
     }
@@ -271,7 +508,7 @@ void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_
         if (saved_file)
             free(saved_file);
         checkpoint->error = true;
-        return;
+        return false;
     }
 
     // Reject sizes that can't fit in size_t before comparing — otherwise a
@@ -284,7 +521,7 @@ void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_
         if (saved_file)
             free(saved_file);
         checkpoint->error = true;
-        return;
+        return false;
     }
 
     // Read compression flag
@@ -295,7 +532,7 @@ void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_
         if (saved_file)
             free(saved_file);
         checkpoint->error = true;
-        return;
+        return false;
     }
 
     if (flag == 0x00) {
@@ -305,86 +542,139 @@ void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_
             printf("Error: Failed to read %zu bytes from checkpoint (got %zu)\n", size, nread);
             checkpoint->error = true;
         }
-    } else if (flag == 0x01) {
-        // RLE-compressed: read compressed size then compressed data, decode
+    } else if (flag == 0x01 || flag == 0x02) {
+        // Compressed (0x01 legacy RLE, 0x02 chunked LZ): read compressed size then data, decode
         uint64_t comp_size = 0;
         got = fread(&comp_size, 1, sizeof(comp_size), checkpoint->file);
         if (got != sizeof(comp_size)) {
-            printf("Error: Failed to read RLE compressed size from checkpoint\n");
+            printf("Error: Failed to read compressed size from checkpoint\n");
             if (saved_file)
                 free(saved_file);
             checkpoint->error = true;
-            return;
+            return false;
         }
         if (comp_size > CHECKPOINT_MAX_ALLOC) {
-            printf("Error: v2 RLE compressed size %llu exceeds CHECKPOINT_MAX_ALLOC (%zu)\n",
+            printf("Error: v2 compressed size %llu exceeds CHECKPOINT_MAX_ALLOC (%zu)\n",
                    (unsigned long long)comp_size, (size_t)CHECKPOINT_MAX_ALLOC);
             if (saved_file)
                 free(saved_file);
             checkpoint->error = true;
-            return;
+            return false;
         }
-        uint8_t *comp_buf = (uint8_t *)malloc((size_t)comp_size);
+        uint8_t *comp_buf = (uint8_t *)malloc(comp_size ? (size_t)comp_size : 1);
         if (!comp_buf) {
-            printf("Error: Out of memory for RLE decompression (%llu bytes)\n", (unsigned long long)comp_size);
+            printf("Error: Out of memory for decompression (%llu bytes)\n", (unsigned long long)comp_size);
             if (saved_file)
                 free(saved_file);
             checkpoint->error = true;
-            return;
+            return false;
         }
         got = fread(comp_buf, 1, (size_t)comp_size, checkpoint->file);
         if (got != (size_t)comp_size) {
-            printf("Error: Failed to read %llu RLE bytes from checkpoint (got %zu)\n", (unsigned long long)comp_size,
-                   got);
+            printf("Error: Failed to read %llu compressed bytes from checkpoint (got %zu)\n",
+                   (unsigned long long)comp_size, got);
             free(comp_buf);
             if (saved_file)
                 free(saved_file);
             checkpoint->error = true;
-            return;
+            return false;
         }
-        // Decode RLE into output buffer
-        if (!rle_decode(comp_buf, (size_t)comp_size, (uint8_t *)data, size)) {
-            printf("Error: RLE decompression failed for %zu-byte block at %s:%d\n", size, file ? file : "(unknown)",
-                   line);
+        // Decode into output buffer
+        bool decoded = flag == 0x02 ? chunk_lz_decode(comp_buf, (size_t)comp_size, (uint8_t *)data, size)
+                                    : rle_decode(comp_buf, (size_t)comp_size, (uint8_t *)data, size);
+        if (!decoded) {
+            printf("Error: Decompression failed for %zu-byte block at %s:%d\n", size, file ? file : "(unknown)", line);
             free(comp_buf);
             if (saved_file)
                 free(saved_file);
             checkpoint->error = true;
-            return;
+            return false;
         }
         free(comp_buf);
+    } else if (flag == 0x04) {
+        // Pooled: a piece list naming objects in the snapshot pool
+        if (!pool_read_pieces(checkpoint, (uint8_t *)data, size, size))
+            checkpoint->error = true;
+    } else if (flag == 0x03) {
+        // Page-aligned raw: absolute offset of the data, padding, then the data
+        uint64_t data_at = 0;
+        got = fread(&data_at, 1, sizeof(data_at), checkpoint->file);
+        off_t pos = ftello(checkpoint->file);
+        if (got != sizeof(data_at) || pos < 0 || data_at < (uint64_t)pos) {
+            printf("Error: Bad page-aligned block header in checkpoint\n");
+            if (saved_file)
+                free(saved_file);
+            checkpoint->error = true;
+            return false;
+        }
+        mapped = may_map && v2_map_block(checkpoint, data, size, data_at);
+        if (mapped) {
+            if (fseeko(checkpoint->file, (off_t)(data_at + size), SEEK_SET) != 0)
+                checkpoint->error = true;
+        } else if (fseeko(checkpoint->file, (off_t)data_at, SEEK_SET) != 0 ||
+                   fread(data, 1, size, checkpoint->file) != size) {
+            printf("Error: Failed to read %zu bytes from checkpoint\n", size);
+            checkpoint->error = true;
+        }
     } else {
         printf("Error: Unknown compression flag 0x%02x in checkpoint\n", flag);
         if (saved_file)
             free(saved_file);
         checkpoint->error = true;
-        return;
+        return false;
     }
 
     if (saved_file)
         free(saved_file);
+    return mapped;
 }
 
-// Write a data block with size header, source metadata, and optional RLE compression
-void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data, size_t size, const char *file,
-                                      int line) {
-    if (!checkpoint || checkpoint->error || !checkpoint->is_writing) {
-        printf("Error: Invalid checkpoint handle for writing\n");
+// Read a data block with size validation, source metadata, and decompression
+void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_t size, const char *file, int line) {
+    if (!checkpoint || checkpoint->error || checkpoint->is_writing) {
+        printf("Error: Invalid checkpoint handle for reading\n");
         if (checkpoint)
             checkpoint->error = true;
         return;
     }
 
-    // v3 buffered write: append size + raw data to accumulation buffer
+    // v3 buffered read: pull size header + raw data from decompressed buffer
     if (checkpoint->buf) {
-        uint32_t sz = (uint32_t)size;
-        buf_append(checkpoint, &sz, sizeof(sz));
-        buf_append(checkpoint, data, size);
+        uint32_t stored_size = 0;
+        if (!buf_read(checkpoint, &stored_size, sizeof(stored_size)))
+            return;
+        if ((size_t)stored_size != size) {
+            printf("Error: v3 checkpoint size mismatch: expected %zu but got %u at %s:%d\n", size, stored_size,
+                   file ? file : "(unknown)", line);
+            checkpoint->error = true;
+            return;
+        }
+        if (!buf_read(checkpoint, data, size))
+            return;
         return;
     }
 
-    // v2 per-block write path with file/line metadata and per-block RLE
+    v2_read_block(checkpoint, data, size, false, file, line);
+}
+
+// Read guest RAM; a page-aligned block is mapped over ram when may_map allows
+bool checkpoint_read_ram_loc(checkpoint_t *checkpoint, uint8_t *ram, size_t size, bool may_map, const char *file,
+                             int line) {
+    if (!checkpoint || checkpoint->error || checkpoint->is_writing || checkpoint->buf) {
+        system_read_checkpoint_data_loc(checkpoint, ram, size, file, line);
+        return false;
+    }
+    return v2_read_block(checkpoint, ram, size, may_map, file, line);
+}
 
+// v2 per-block write path with file/line metadata and per-block compression.
+// A pooled checkpoint stores large blocks as pool objects (RAM as 4 KB
+// pages).  Otherwise RAM in the mapped layout is stored raw with its data on
+// a CHECKPOINT_MAP_ALIGN boundary of the file, so a restore can map it.
+static void v2_write_block(checkpoint_t *checkpoint, const void *data, size_t size, bool ram, const char *file,
+                           int line) {
+    bool pooled = (checkpoint->pool_dir || checkpoint->mem_pool) && size >= POOL_MIN_BLOCK;
+    bool aligned = ram && checkpoint->ram_mapped && !pooled;
     // Write 64-bit uncompressed size header for validation on read
     uint64_t store_size = (uint64_t)size;
     size_t w = fwrite(&store_size, 1, sizeof(store_size), checkpoint->file);
@@ -419,8 +709,39 @@ void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data
         return;
     }
 
-    // Choose raw vs RLE based on block size
-    if (size < RLE_THRESHOLD) {
+    // Choose pooled, page-aligned raw, raw or chunked LZ
+    if (pooled) {
+        // flag=4 then the piece list
+        uint8_t flag = 0x04;
+        if (fwrite(&flag, 1, 1, checkpoint->file) != 1 ||
+            !pool_write_pieces(checkpoint, (const uint8_t *)data, size, ram ? POOL_PAGE_PIECE : POOL_BLOB_PIECE))
+            checkpoint->error = true;
+    } else if (aligned) {
+        // flag=3, the absolute file offset of the data, zero padding, data
+        static const uint8_t zeros[4096];
+        off_t pos = ftello(checkpoint->file);
+        uint8_t flag = 0x03;
+        uint64_t data_at = ((uint64_t)pos + 1 + sizeof(uint64_t) + CHECKPOINT_MAP_ALIGN - 1) &
+                           ~(uint64_t)(CHECKPOINT_MAP_ALIGN - 1);
+        if (pos < 0 || fwrite(&flag, 1, 1, checkpoint->file) != 1 ||
+            fwrite(&data_at, 1, sizeof(data_at), checkpoint->file) != sizeof(data_at)) {
+            checkpoint->error = true;
+            return;
+        }
+        for (uint64_t pad = data_at - ((uint64_t)pos + 1 + sizeof(data_at)); pad > 0;) {
+            size_t n = pad < sizeof(zeros) ? (size_t)pad : sizeof(zeros);
+            if (fwrite(zeros, 1, n, checkpoint->file) != n) {
+                checkpoint->error = true;
+                return;
+            }
+            pad -= n;
+        }
+        size_t written = fwrite(data, 1, size, checkpoint->file);
+        if (written != size) {
+            printf("Error: Failed to write %zu bytes to checkpoint (wrote %zu)\n", size, written);
+            checkpoint->error = true;
+        }
+    } else if (size < COMPRESS_THRESHOLD) {
         // Small block: flag=0 then raw data
         uint8_t flag = 0x00;
         w = fwrite(&flag, 1, 1, checkpoint->file);
@@ -434,22 +755,20 @@ void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data
             checkpoint->error = true;
         }
     } else {
-        // Large block: flag=1 then RLE-compressed data
-        // First pass: compute exact compressed size (dry run with NULL output)
-        size_t comp_size = rle_encode((const uint8_t *)data, size, NULL, 0);
-        uint8_t *comp_buf = (uint8_t *)malloc(comp_size);
+        // Large block: flag=2 then a chunked LZ stream (chunks encode in parallel)
+        size_t comp_cap = chunk_lz_bound(size);
+        uint8_t *comp_buf = (uint8_t *)malloc(comp_cap);
         if (!comp_buf) {
-            printf("Error: Out of memory for RLE compression (%zu bytes)\n", comp_size);
+            printf("Error: Out of memory for compression (%zu bytes)\n", comp_cap);
             checkpoint->error = true;
             return;
         }
-        // Second pass: encode into buffer
-        rle_encode((const uint8_t *)data, size, comp_buf, comp_size);
+        size_t comp_size = chunk_lz_encode((const uint8_t *)data, size, comp_buf, comp_cap);
 
         // Write flag + compressed size + compressed data
-        uint8_t flag = 0x01;
+        uint8_t flag = 0x02;
         w = fwrite(&flag, 1, 1, checkpoint->file);
-        if (w != 1) {
+        if (w != 1 || comp_size == 0) {
             free(comp_buf);
             checkpoint->error = true;
             return;
@@ -463,7 +782,7 @@ void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data
         }
         w = fwrite(comp_buf, 1, comp_size, checkpoint->file);
         if (w != comp_size) {
-            printf("Error: Failed to write %zu RLE bytes to checkpoint (wrote %zu)\n", comp_size, w);
+            printf("Error: Failed to write %zu compressed bytes to checkpoint (wrote %zu)\n", comp_size, w);
             free(comp_buf);
             checkpoint->error = true;
             return;
@@ -472,11 +791,289 @@ void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data
     }
 }
 
+// Write a data block with size header, source metadata, and optional LZ compression
+void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data, size_t size, const char *file,
+                                      int line) {
+    if (!checkpoint || checkpoint->error || !checkpoint->is_writing) {
+        printf("Error: Invalid checkpoint handle for writing\n");
+        if (checkpoint)
+            checkpoint->error = true;
+        return;
+    }
+
+    // v3 buffered write: append size + raw data to accumulation buffer
+    if (checkpoint->buf) {
+        uint32_t sz = (uint32_t)size;
+        buf_append(checkpoint, &sz, sizeof(sz));
+        buf_append(checkpoint, data, size);
+        return;
+    }
+
+    v2_write_block(checkpoint, data, size, false, file, line);
+}
+
+// Write guest RAM.  Consolidated checkpoints store it as an ordinary block; a
+// v4 quick base stores all of it, a v4 delta only the pages flagged in dirty
+// (one byte per 4 KB page; NULL = unknown, store everything).
+void checkpoint_write_ram_loc(checkpoint_t *checkpoint, const uint8_t *ram, size_t size, const uint8_t *dirty,
+                              const char *file, int line) {
+    if (!checkpoint || checkpoint->error || !checkpoint->is_writing || !checkpoint->buf) {
+        if (checkpoint && !checkpoint->error && checkpoint->is_writing)
+            v2_write_block(checkpoint, ram, size, true, file, line);
+        else
+            system_write_checkpoint_data_loc(checkpoint, ram, size, file, line);
+        return;
+    }
+    uint32_t pages = (uint32_t)((size + QUICK_PAGE_SIZE - 1) / QUICK_PAGE_SIZE);
+    uint32_t count = 0;
+    if (checkpoint->quick_delta && dirty) {
+        for (uint32_t p = 0; p < pages; p++)
+            count += dirty[p] != 0;
+    } else {
+        count = QUICK_RAM_FULL;
+    }
+    uint32_t head[3] = {QUICK_RAM_BLOCK, (uint32_t)size, count};
+    buf_append(checkpoint, head, sizeof(head));
+    if (count == QUICK_RAM_FULL) {
+        buf_append(checkpoint, ram, size);
+        return;
+    }
+    for (uint32_t p = 0; p < pages && !checkpoint->error; p++) {
+        if (!dirty[p])
+            continue;
+        size_t off = (size_t)p * QUICK_PAGE_SIZE;
+        size_t len = size - off < QUICK_PAGE_SIZE ? size - off : QUICK_PAGE_SIZE;
+        buf_append(checkpoint, &p, sizeof(p));
+        buf_append(checkpoint, ram + off, len);
+    }
+}
+
+// Record a RAM block whose bytes the writer thread reads from a snapshot.
+// The block is laid out exactly as checkpoint_write_ram would lay it out.
+void checkpoint_write_ram_deferred_loc(checkpoint_t *checkpoint, size_t size, const uint8_t *dirty,
+                                       checkpoint_ram_read_fn read, checkpoint_ram_release_fn release, void *ctx,
+                                       const char *file, int line) {
+    if (!checkpoint || checkpoint->error || !checkpoint->is_writing || !checkpoint->async || checkpoint->ram_release) {
+        printf("Error: Invalid checkpoint handle for deferred RAM\n");
+        if (checkpoint)
+            checkpoint->error = true;
+        if (release)
+            release(ctx);
+        return;
+    }
+    checkpoint->ram_read = read;
+    checkpoint->ram_release = release;
+    checkpoint->ram_ctx = ctx;
+    checkpoint->ram_size = size;
+    checkpoint->ram_file = file;
+    checkpoint->ram_line = line;
+
+    // Consolidated: the block is spliced into the captured stream at this offset
+    if (!checkpoint->buf) {
+        if (fflush(checkpoint->file) != 0)
+            checkpoint->error = true;
+        checkpoint->ram_at = checkpoint->mem_size;
+        return;
+    }
+
+    // Quick: write the block headers now and reserve the page bytes
+    uint32_t pages = (uint32_t)((size + QUICK_PAGE_SIZE - 1) / QUICK_PAGE_SIZE);
+    uint32_t count = 0;
+    if (checkpoint->quick_delta && dirty) {
+        for (uint32_t p = 0; p < pages; p++)
+            count += dirty[p] != 0;
+    } else {
+        count = QUICK_RAM_FULL;
+    }
+    uint32_t head[3] = {QUICK_RAM_BLOCK, (uint32_t)size, count};
+    buf_append(checkpoint, head, sizeof(head));
+    checkpoint->ram_at = checkpoint->buf_used;
+    if (count == QUICK_RAM_FULL) {
+        buf_reserve(checkpoint, size);
+        return;
+    }
+    checkpoint->ram_pages = (uint32_t *)malloc((count ? count : 1) * sizeof(uint32_t));
+    if (!checkpoint->ram_pages) {
+        checkpoint->error = true;
+        return;
+    }
+    for (uint32_t p = 0; p < pages && !checkpoint->error; p++) {
+        if (!dirty[p])
+            continue;
+        size_t off = (size_t)p * QUICK_PAGE_SIZE;
+        checkpoint->ram_pages[checkpoint->ram_page_count++] = p;
+        buf_append(checkpoint, &p, sizeof(p));
+        buf_reserve(checkpoint, size - off < QUICK_PAGE_SIZE ? size - off : QUICK_PAGE_SIZE);
+    }
+}
+
+// === v4 quick read ===
+
+// Locate the RAM block in a v4 record payload: *off and *len cover its
+// encoding (len 0 when the payload has none).  Returns false on a malformed payload.
+static bool quick_find_ram(const uint8_t *payload, size_t size, size_t *off, size_t *len) {
+    size_t pos = 0;
+    *off = 0;
+    *len = 0;
+    while (pos < size) {
+        uint32_t block;
+        if (size - pos < sizeof(block))
+            return false;
+        memcpy(&block, payload + pos, sizeof(block));
+        if (block != QUICK_RAM_BLOCK) {
+            if (size - pos - sizeof(block) < block)
+                return false;
+            pos += sizeof(block) + block;
+            continue;
+        }
+        uint32_t head[3];
+        if (*len || size - pos < sizeof(head))
+            return false; // a second RAM block, or a truncated one
+        memcpy(head, payload + pos, sizeof(head));
+        size_t end = pos + sizeof(head);
+        if (head[2] == QUICK_RAM_FULL) {
+            if (size - end < head[1])
+                return false;
+            end += head[1];
+        } else {
+            for (uint32_t i = 0; i < head[2]; i++) {
+                uint32_t page;
+                if (size - end < sizeof(page))
+                    return false;
+                memcpy(&page, payload + end, sizeof(page));
+                size_t page_off = (size_t)page * QUICK_PAGE_SIZE;
+                if (page_off >= head[1])
+                    return false;
+                size_t page_len = head[1] - page_off < QUICK_PAGE_SIZE ? head[1] - page_off : QUICK_PAGE_SIZE;
+                if (size - end - sizeof(page) < page_len)
+                    return false;
+                end += sizeof(page) + page_len;
+            }
+        }
+        *off = pos;
+        *len = end - pos;
+        pos = end;
+    }
+    return true;
+}
+
+// Apply an encoded RAM block (validated by quick_find_ram) to the RAM being rebuilt
+static bool quick_apply_ram(const uint8_t *block, uint8_t **ram, size_t *ram_size) {
+    uint32_t head[3];
+    memcpy(head, block, sizeof(head));
+    const uint8_t *p = block + sizeof(head);
+    if (head[2] == QUICK_RAM_FULL) {
+        uint8_t *full = (uint8_t *)realloc(*ram, head[1] ? head[1] : 1);
+        if (!full)
+            return false;
+        memcpy(full, p, head[1]);
+        *ram = full;
+        *ram_size = head[1];
+        return true;
+    }
+    if (!*ram || *ram_size != head[1])
+        return false; // pages without a full image of the same size to patch
+    for (uint32_t i = 0; i < head[2]; i++) {
+        uint32_t page;
+        memcpy(&page, p, sizeof(page));
+        p += sizeof(page);
+        size_t page_off = (size_t)page * QUICK_PAGE_SIZE;
+        size_t page_len = head[1] - page_off < QUICK_PAGE_SIZE ? head[1] - page_off : QUICK_PAGE_SIZE;
+        memcpy(*ram + page_off, p, page_len);
+        p += page_len;
+    }
+    return true;
+}
+
+// Replay the record log of a v4 file (positioned after its header) into
+// cp->buf: the newest complete record's blocks with the RAM block rebuilt
+// from the base and every delta.  Returns false on error.
+static bool quick_read_records(checkpoint_t *cp, const char *filename) {
+    uint8_t *latest = NULL, *ram = NULL;
+    size_t latest_size = 0, ram_size = 0, ram_off = 0, ram_len = 0;
+    uint32_t seq = 0;
+    bool ok = true;
+    for (;;) {
+        quick_record_t head, tail;
+        if (fread(&head, 1, sizeof(head), cp->file) != sizeof(head))
+            break;
+        if (head.tag != (latest ? QUICK_REC_DELTA : QUICK_REC_BASE) || head.seq != seq ||
+            head.size > CHECKPOINT_MAX_ALLOC)
+            break;
+        uint8_t *packed = (uint8_t *)malloc(head.size ? (size_t)head.size : 1);
+        if (!packed) {
+            printf("Error: Out of memory for v4 record (%llu bytes)\n", (unsigned long long)head.size);
+            ok = false;
+            break;
+        }
+        // A short payload or a bad trailer is a torn append: keep the records before it
+        if (fread(packed, 1, (size_t)head.size, cp->file) != head.size ||
+            fread(&tail, 1, sizeof(tail), cp->file) != sizeof(tail) || tail.tag != QUICK_REC_END ||
+            tail.seq != head.seq || tail.size != head.size) {
+            free(packed);
+            break;
+        }
+        uint64_t raw_size = 0;
+        uint8_t *payload = NULL;
+        if (chunk_lz_raw_size(packed, (size_t)head.size, &raw_size) && raw_size <= CHECKPOINT_MAX_ALLOC)
+            payload = (uint8_t *)malloc(raw_size ? (size_t)raw_size : 1);
+        bool unpacked = payload && chunk_lz_decode(packed, (size_t)head.size, payload, (size_t)raw_size);
+        free(packed);
+        size_t off, len;
+        if (!unpacked || !quick_find_ram(payload, (size_t)raw_size, &off, &len) ||
+            (len && !quick_apply_ram(payload + off, &ram, &ram_size))) {
+            printf("Error: Corrupt v4 record %u in %s\n", seq, filename);
+            free(payload);
+            ok = false;
+            break;
+        }
+        free(latest);
+        latest = payload;
+        latest_size = (size_t)raw_size;
+        ram_off = off;
+        ram_len = len;
+        seq++;
+    }
+    if (ok && !latest) {
+        printf("Error: %s holds no complete v4 base record\n", filename);
+        ok = false;
+    }
+    if (ok) {
+        // Newest blocks, with its RAM block expanded to {uint32 size, RAM}
+        size_t total = latest_size - ram_len + (ram_len ? sizeof(uint32_t) + ram_size : 0);
+        cp->buf = (uint8_t *)malloc(total ? total : 1);
+        if (!cp->buf) {
+            printf("Error: Out of memory for v4 checkpoint data (%zu bytes)\n", total);
+            ok = false;
+        } else {
+            size_t pos = 0;
+            memcpy(cp->buf, latest, ram_off);
+            pos += ram_off;
+            if (ram_len) {
+                uint32_t sz = (uint32_t)ram_size;
+                memcpy(cp->buf + pos, &sz, sizeof(sz));
+                pos += sizeof(sz);
+                memcpy(cp->buf + pos, ram, ram_size);
+                pos += ram_size;
+            }
+            memcpy(cp->buf + pos, latest + ram_off + ram_len, latest_size - ram_off - ram_len);
+            cp->buf_cap = total;
+            cp->buf_used = total;
+            cp->buf_pos = 0;
+            cp->buf_owned = true;
+        }
+    }
+    free(latest);
+    free(ram);
+    return ok;
+}
+
 // === Handle Management ===
 
-// Open a checkpoint file for reading (auto-detects v2 or v3 format)
+// Open a checkpoint file for reading (auto-detects v2, v3 or v4 format)
 checkpoint_t *checkpoint_open_read(const char *filename) {
-    checkpoint_t *cp = (checkpoint_t *)malloc(sizeof(struct checkpoint));
+    checkpoint_async_wait();
+    checkpoint_t *cp = (checkpoint_t *)calloc(1, sizeof(struct checkpoint));
     if (!cp)
         return NULL;
 
@@ -494,6 +1091,8 @@ checkpoint_t *checkpoint_open_read(const char *filename) {
     cp->buf_owned = false;
     memset(cp->model_id, 0, MODEL_ID_LEN);
     cp->ram_size_kb = 0;
+    cp->path = NULL;
+    cp->quick_delta = false;
 
     // Read magic signature to detect format version
     char magic[CHECKPOINT_MAGIC_LEN];
@@ -505,7 +1104,42 @@ checkpoint_t *checkpoint_open_read(const char *filename) {
         return NULL;
     }
 
-    if (memcmp(magic, CHECKPOINT_MAGIC_V3, CHECKPOINT_MAGIC_LEN) == 0) {
+    if (memcmp(magic, CHECKPOINT_MAGIC_V4, CHECKPOINT_MAGIC_LEN) == 0) {
+        // v4 quick format: same header as v3, then a record log replayed into the buffer
+        char file_build_id[BUILD_ID_LEN + 1];
+        got = fread(file_build_id, 1, BUILD_ID_LEN, cp->file);
+        if (got != BUILD_ID_LEN) {
+            printf("Error: Failed to read build ID from %s\n", filename);
+            fclose(cp->file);
+            free(cp);
+            return NULL;
+        }
+        file_build_id[BUILD_ID_LEN] = '\0';
+        if (memcmp(file_build_id, get_build_id(), BUILD_ID_LEN) != 0) {
+            printf("Error: Checkpoint build ID mismatch in %s\n", filename);
+            printf("  checkpoint: %s\n", file_build_id);
+            printf("  current:    %s\n", get_build_id());
+            fclose(cp->file);
+            free(cp);
+            return NULL;
+        }
+        if (fread(cp->model_id, 1, MODEL_ID_LEN, cp->file) != MODEL_ID_LEN ||
+            fread(&cp->ram_size_kb, 1, sizeof(cp->ram_size_kb), cp->file) != sizeof(cp->ram_size_kb)) {
+            printf("Error: Failed to read v4 header from %s\n", filename);
+            fclose(cp->file);
+            free(cp);
+            return NULL;
+        }
+        cp->model_id[MODEL_ID_LEN - 1] = '\0';
+        if (!quick_read_records(cp, filename)) {
+            fclose(cp->file);
+            free(cp);
+            return NULL;
+        }
+        fclose(cp->file);
+        cp->file = NULL;
+        cp->kind = CHECKPOINT_KIND_QUICK;
+    } else if (memcmp(magic, CHECKPOINT_MAGIC_V3, CHECKPOINT_MAGIC_LEN) == 0) {
         // v3 quick format: read build ID, model ID, then sizes, decompress entire payload into buffer
         char file_build_id[BUILD_ID_LEN + 1];
         got = fread(file_build_id, 1, BUILD_ID_LEN, cp->file);
@@ -652,6 +1286,8 @@ checkpoint_t *checkpoint_open_read(const char *filename) {
             return NULL;
         }
         cp->kind = CHECKPOINT_KIND_CONSOLIDATED;
+        // Pooled blocks, if any, name objects in the pool beside the file
+        cp->pool_dir = snapshot_pool_dir_for(filename);
     } else {
         printf("Error: %s is not a valid Granny Smith checkpoint (bad signature)\n", filename);
         fclose(cp->file);
@@ -664,18 +1300,64 @@ checkpoint_t *checkpoint_open_read(const char *filename) {
     return cp;
 }
 
-// Open a checkpoint file for writing
-checkpoint_t *checkpoint_open_write(const char *filename, checkpoint_kind_t kind, const char *model_id,
-                                    uint32_t ram_size_kb) {
-    checkpoint_t *cp = (checkpoint_t *)malloc(sizeof(struct checkpoint));
+// Open a checkpoint for writing; an asynchronous consolidated save captures
+// into a memory stream and writes the file later
+static checkpoint_t *checkpoint_open_write_mode(const char *filename, checkpoint_kind_t kind, const char *model_id,
+                                                uint32_t ram_size_kb, bool async) {
+    checkpoint_async_wait();
+    checkpoint_t *cp = (checkpoint_t *)calloc(1, sizeof(struct checkpoint));
     if (!cp)
         return NULL;
 
-    cp->file = fopen(filename, "wb");
+    // A quick save to the file of the current chain appends a delta record;
+    // any other quick save starts a new chain with a base
+    cp->quick_delta = kind == CHECKPOINT_KIND_QUICK && quick_chain_extends(filename, model_id, ram_size_kb);
+    if (kind == CHECKPOINT_KIND_QUICK && !cp->quick_delta)
+        quick_chain_reset();
+
+    // A machine restored from a mapped checkpoint may still be paging its RAM
+    // in from the old file: replace a regular file rather than truncating it
+    struct stat st;
+    if (!cp->quick_delta && stat(filename, &st) == 0 && S_ISREG(st.st_mode))
+        unlink(filename);
+
+    cp->async = async;
+    cp->ram_mapped = kind == CHECKPOINT_KIND_CONSOLIDATED && checkpoint_get_ram_mapped();
+    if (kind == CHECKPOINT_KIND_CONSOLIDATED && !async && checkpoint_get_pooled()) {
+        cp->pool_dir = snapshot_pool_dir_for(filename);
+        cp->pool_refs = snapshot_hash_set_new();
+        if (!cp->pool_dir || !cp->pool_refs) {
+            free(cp->pool_dir);
+            snapshot_hash_set_free(cp->pool_refs);
+            free(cp);
+            return NULL;
+        }
+    }
+    cp->file = fopen(filename, cp->quick_delta ? "ab" : "wb");
     if (!cp->file) {
         free(cp);
         return NULL;
     }
+    if (async && kind != CHECKPOINT_KIND_QUICK) {
+        cp->out = cp->file;
+        cp->file = open_memstream(&cp->mem, &cp->mem_size);
+        if (!cp->file) {
+            fclose(cp->out);
+            free(cp);
+            return NULL;
+        }
+    }
+    if (kind == CHECKPOINT_KIND_QUICK || async) {
+        cp->path = strdup(filename);
+        if (!cp->path) {
+            fclose(cp->file);
+            if (cp->out)
+                fclose(cp->out);
+            free(cp->mem);
+            free(cp);
+            return NULL;
+        }
+    }
 
     cp->is_writing = true;
     cp->error = false;
@@ -699,12 +1381,13 @@ checkpoint_t *checkpoint_open_write(const char *filename, checkpoint_kind_t kind
     cp->buf_owned = false;
 
     if (kind == CHECKPOINT_KIND_QUICK) {
-        // v3 quick: accumulate data into pre-allocated buffer, write at close
+        // v4 quick: accumulate the record payload into pre-allocated buffer, write at close
         if (!g_quick_write_buf) {
             g_quick_write_buf = (uint8_t *)malloc(QUICK_BUF_CAPACITY);
             if (!g_quick_write_buf) {
                 printf("Error: Failed to allocate quick checkpoint buffer (%d bytes)\n", QUICK_BUF_CAPACITY);
                 fclose(cp->file);
+                free(cp->path);
                 free(cp);
                 return NULL;
             }
@@ -715,30 +1398,25 @@ checkpoint_t *checkpoint_open_write(const char *filename, checkpoint_kind_t kind
         cp->buf_owned = false; // static buffer, not freed on close
     } else {
         // v2 consolidated: write magic + build ID + model ID immediately, data streamed per-block
-        if (fwrite(CHECKPOINT_MAGIC_V2, 1, CHECKPOINT_MAGIC_LEN, cp->file) != CHECKPOINT_MAGIC_LEN) {
-            printf("Error: Failed to write checkpoint signature to %s\n", filename);
-            fclose(cp->file);
-            free(cp);
-            return NULL;
-        }
+        const char *what = NULL;
+        if (fwrite(CHECKPOINT_MAGIC_V2, 1, CHECKPOINT_MAGIC_LEN, cp->file) != CHECKPOINT_MAGIC_LEN)
+            what = "checkpoint signature";
         // Write build ID right after the magic signature
-        if (fwrite(get_build_id(), 1, BUILD_ID_LEN, cp->file) != BUILD_ID_LEN) {
-            printf("Error: Failed to write build ID to %s\n", filename);
-            fclose(cp->file);
-            free(cp);
-            return NULL;
-        }
+        else if (fwrite(get_build_id(), 1, BUILD_ID_LEN, cp->file) != BUILD_ID_LEN)
+            what = "build ID";
         // Write machine model ID (fixed-size, null-padded)
-        if (fwrite(cp->model_id, 1, MODEL_ID_LEN, cp->file) != MODEL_ID_LEN) {
-            printf("Error: Failed to write model ID to %s\n", filename);
-            fclose(cp->file);
-            free(cp);
-            return NULL;
-        }
+        else if (fwrite(cp->model_id, 1, MODEL_ID_LEN, cp->file) != MODEL_ID_LEN)
+            what = "model ID";
         // Write RAM size in KB (uint32_t, fixed 4 bytes)
-        if (fwrite(&cp->ram_size_kb, 1, sizeof(cp->ram_size_kb), cp->file) != sizeof(cp->ram_size_kb)) {
-            printf("Error: Failed to write RAM size to %s\n", filename);
+        else if (fwrite(&cp->ram_size_kb, 1, sizeof(cp->ram_size_kb), cp->file) != sizeof(cp->ram_size_kb))
+            what = "RAM size";
+        if (what) {
+            printf("Error: Failed to write %s to %s\n", what, filename);
             fclose(cp->file);
+            if (cp->out)
+                fclose(cp->out);
+            free(cp->mem);
+            free(cp->path);
             free(cp);
             return NULL;
         }
@@ -747,6 +1425,23 @@ checkpoint_t *checkpoint_open_write(const char *filename, checkpoint_kind_t kind
     return cp;
 }
 
+// Open a checkpoint file for writing
+checkpoint_t *checkpoint_open_write(const char *filename, checkpoint_kind_t kind, const char *model_id,
+                                    uint32_t ram_size_kb) {
+    return checkpoint_open_write_mode(filename, kind, model_id, ram_size_kb, false);
+}
+
+// Open a checkpoint file for an asynchronous save
+checkpoint_t *checkpoint_open_write_async(const char *filename, checkpoint_kind_t kind, const char *model_id,
+                                          uint32_t ram_size_kb) {
+    return checkpoint_open_write_mode(filename, kind, model_id, ram_size_kb, true);
+}
+
+// True for a handle opened by checkpoint_open_write_async
+bool checkpoint_is_async(checkpoint_t *checkpoint) {
+    return checkpoint && checkpoint->async;
+}
+
 // Get the checkpoint kind (consolidated vs quick)
 checkpoint_kind_t checkpoint_get_kind(checkpoint_t *checkpoint) {
     if (!checkpoint)
@@ -768,35 +1463,79 @@ uint32_t checkpoint_get_ram_size_kb(checkpoint_t *checkpoint) {
     return checkpoint->ram_size_kb;
 }
 
-// Close a checkpoint and free its resources
-void checkpoint_close(checkpoint_t *checkpoint) {
-    if (!checkpoint)
-        return;
-
-    // v3 quick write: write buffer directly.  v3 deliberately skips RLE —
-    // the quick-save buffer is dominated by uncompressible RAM state, so the
-    // pass was never paying for itself.  Set compressed_size == uncompressed_size
-    // on disk to mark the payload as raw.  v2 still RLE-encodes per block.
-    if (checkpoint->is_writing && checkpoint->buf && !checkpoint->error) {
-        size_t raw_size = checkpoint->buf_used;
-        // Write v3 header: magic + build ID + model ID + ram_size_kb + uncompressed_size + compressed_size
-        fwrite(CHECKPOINT_MAGIC_V3, 1, CHECKPOINT_MAGIC_LEN, checkpoint->file);
-        fwrite(get_build_id(), 1, BUILD_ID_LEN, checkpoint->file);
-        fwrite(checkpoint->model_id, 1, MODEL_ID_LEN, checkpoint->file);
-        fwrite(&checkpoint->ram_size_kb, 1, sizeof(checkpoint->ram_size_kb), checkpoint->file);
-        uint64_t uc = (uint64_t)raw_size;
-        fwrite(&uc, 1, sizeof(uc), checkpoint->file);
-        uint64_t cs = (uint64_t)raw_size; // "compressed" size = raw size (no compression)
-        fwrite(&cs, 1, sizeof(cs), checkpoint->file);
-        // Write raw payload directly in one call
-        size_t w = fwrite(checkpoint->buf, 1, raw_size, checkpoint->file);
-        if (w != raw_size) {
-            printf("Error: v3 write failed (wrote %zu of %zu)\n", w, raw_size);
-            checkpoint->error = true;
+// Write the v4 quick record: a base starts the file (header + BASE record), a
+// delta appends one DLTA record.  The payload is packed with chunk_lz, whose
+// chunks compress in parallel on the headless build.
+static bool quick_commit(checkpoint_t *checkpoint) {
+    bool ok = !checkpoint->error;
+    FILE *f = checkpoint->file;
+    size_t packed = 0;
+    if (ok)
+        ok = quick_pack(checkpoint->buf, checkpoint->buf_used, &packed);
+    if (ok && !checkpoint->quick_delta) {
+        ok = fwrite(CHECKPOINT_MAGIC_V4, 1, CHECKPOINT_MAGIC_LEN, f) == CHECKPOINT_MAGIC_LEN &&
+             fwrite(get_build_id(), 1, BUILD_ID_LEN, f) == BUILD_ID_LEN &&
+             fwrite(checkpoint->model_id, 1, MODEL_ID_LEN, f) == MODEL_ID_LEN &&
+             fwrite(&checkpoint->ram_size_kb, 1, sizeof(checkpoint->ram_size_kb), f) ==
+                 sizeof(checkpoint->ram_size_kb);
+    }
+    uint32_t seq = checkpoint->quick_delta ? g_quick_chain.seq + 1 : 0;
+    if (ok)
+        ok = quick_write_record(f, checkpoint->quick_delta ? QUICK_REC_DELTA : QUICK_REC_BASE, seq, g_quick_pack_buf,
+                                packed);
+    if (ok) {
+        uint64_t record = 2 * sizeof(quick_record_t) + packed;
+        if (!checkpoint->quick_delta) {
+            quick_chain_reset();
+            g_quick_chain.path = checkpoint->path;
+            checkpoint->path = NULL;
+            memcpy(g_quick_chain.model_id, checkpoint->model_id, MODEL_ID_LEN);
+            g_quick_chain.ram_size_kb = checkpoint->ram_size_kb;
+            g_quick_chain.base_bytes = packed;
+            g_quick_chain.valid = true;
+        } else {
+            g_quick_chain.delta_bytes += packed;
         }
+        g_quick_chain.seq = seq;
+        g_quick_chain.end = (checkpoint->quick_delta ? g_quick_chain.end : QUICK_HEADER_BYTES) + record;
+    } else {
+        // Whatever reached the file, the chain no longer describes it
+        if (!checkpoint->error)
+            printf("Error: v4 quick checkpoint write failed (%zu bytes)\n", checkpoint->buf_used);
+        checkpoint->error = true;
+        quick_chain_reset();
+    }
+    return ok;
+}
+
+// Hand the RAM snapshot back, if the handle still holds it
+static void async_release_ram(checkpoint_t *checkpoint) {
+    if (checkpoint->ram_release) {
+        checkpoint->ram_release(checkpoint->ram_ctx);
+        checkpoint->ram_release = NULL;
     }
+}
+
+// End a pooled checkpoint with the list of objects it references
+static void pool_write_refs(checkpoint_t *checkpoint) {
+    uint64_t count = snapshot_hash_set_count(checkpoint->pool_refs);
+    if (fwrite(snapshot_hash_set_items(checkpoint->pool_refs), sizeof(snapshot_hash_t), (size_t)count,
+               checkpoint->file) != count ||
+        fwrite(&count, 1, sizeof(count), checkpoint->file) != sizeof(count) ||
+        fwrite(CHECKPOINT_POOL_REFS_MAGIC, 1, CHECKPOINT_MAGIC_LEN, checkpoint->file) != CHECKPOINT_MAGIC_LEN)
+        checkpoint->error = true;
+}
 
-    // Free owned buffer (v3 read mode allocates its own buffer)
+// Free a handle and everything it owns
+static void checkpoint_free(checkpoint_t *checkpoint) {
+    async_release_ram(checkpoint);
+    free(checkpoint->path);
+    free(checkpoint->ram_pages);
+    free(checkpoint->mem);
+    free(checkpoint->pool_dir);
+    snapshot_hash_set_free(checkpoint->pool_refs);
+
+    // Free owned buffer (v3/v4 read mode allocates its own buffer)
     if (checkpoint->buf_owned && checkpoint->buf) {
         free(checkpoint->buf);
     }
@@ -804,9 +1543,203 @@ void checkpoint_close(checkpoint_t *checkpoint) {
     if (checkpoint->file) {
         fclose(checkpoint->file);
     }
+    if (checkpoint->out) {
+        fclose(checkpoint->out);
+    }
     free(checkpoint);
 }
 
+// Fill the RAM bytes reserved in a quick capture from the snapshot
+static bool async_fill_quick_ram(checkpoint_t *checkpoint) {
+    uint8_t *at = checkpoint->buf + checkpoint->ram_at;
+    if (!checkpoint->ram_pages)
+        return checkpoint->ram_read(checkpoint->ram_ctx, 0, at, checkpoint->ram_size);
+    for (uint32_t i = 0; i < checkpoint->ram_page_count; i++) {
+        size_t off = (size_t)checkpoint->ram_pages[i] * QUICK_PAGE_SIZE;
+        size_t len = checkpoint->ram_size - off < QUICK_PAGE_SIZE ? checkpoint->ram_size - off : QUICK_PAGE_SIZE;
+        at += sizeof(uint32_t);
+        if (!checkpoint->ram_read(checkpoint->ram_ctx, off, at, len))
+            return false;
+        at += len;
+    }
+    return true;
+}
+
+// Write a consolidated capture to its file, splicing the RAM block in where
+// it was deferred
+static bool async_write_consolidated(checkpoint_t *checkpoint, char *error, size_t error_cap) {
+    size_t at = checkpoint->ram_read ? checkpoint->ram_at : checkpoint->mem_size;
+    FILE *out = checkpoint->out;
+    if (fwrite(checkpoint->mem, 1, at, out) != at) {
+        snprintf(error, error_cap, "write failed: %s", strerror(errno));
+        return false;
+    }
+    if (checkpoint->ram_read) {
+        uint8_t *ram = (uint8_t *)malloc(checkpoint->ram_size ? checkpoint->ram_size : 1);
+        bool ok = ram && checkpoint->ram_read(checkpoint->ram_ctx, 0, ram, checkpoint->ram_size);
+        async_release_ram(checkpoint);
+        if (!ok) {
+            free(ram);
+            snprintf(error, error_cap, "RAM snapshot unavailable");
+            return false;
+        }
+        // The block goes straight to the file through the ordinary v2 path
+        checkpoint->file = out;
+        v2_write_block(checkpoint, ram, checkpoint->ram_size, true, checkpoint->ram_file, checkpoint->ram_line);
+        checkpoint->file = NULL;
+        free(ram);
+        if (checkpoint->error) {
+            snprintf(error, error_cap, "write failed: %s", strerror(errno));
+            return false;
+        }
+    }
+    if (fwrite(checkpoint->mem + at, 1, checkpoint->mem_size - at, out) != checkpoint->mem_size - at) {
+        snprintf(error, error_cap, "write failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Finish an asynchronous capture: write, sync and close the file, then free
+// the handle.  Returns false with a reason in error on failure.
+static bool async_write(checkpoint_t *checkpoint, char *error, size_t error_cap) {
+    bool ok = !checkpoint->error;
+    if (!ok)
+        snprintf(error, error_cap, "capture failed");
+    if (ok && !checkpoint->buf) {
+        // The capture stream's buffer is final once the stream is closed
+        ok = fclose(checkpoint->file) == 0;
+        checkpoint->file = NULL;
+        if (!ok)
+            snprintf(error, error_cap, "capture stream failed");
+        else
+            ok = async_write_consolidated(checkpoint, error, error_cap);
+    } else if (ok) {
+        ok = !checkpoint->ram_read || async_fill_quick_ram(checkpoint);
+        async_release_ram(checkpoint);
+        if (!ok)
+            snprintf(error, error_cap, "RAM snapshot unavailable");
+        else if (!(ok = quick_commit(checkpoint)))
+            snprintf(error, error_cap, "write failed: %s", strerror(errno));
+    }
+    // The capture consumed the RAM dirty marks, so a failed quick save breaks the chain
+    if (!ok && checkpoint->buf)
+        quick_chain_reset();
+    FILE *f = checkpoint->buf ? checkpoint->file : checkpoint->out;
+    if (ok && (fflush(f) != 0 || fsync(fileno(f)) != 0)) {
+        snprintf(error, error_cap, "sync failed: %s", strerror(errno));
+        ok = false;
+    }
+    if (f) {
+        if (fclose(f) != 0 && ok) {
+            snprintf(error, error_cap, "close failed: %s", strerror(errno));
+            ok = false;
+        }
+        if (checkpoint->buf)
+            checkpoint->file = NULL;
+        else
+            checkpoint->out = NULL;
+    }
+    if (!ok)
+        printf("Error: Checkpoint %s not saved (%s)\n", checkpoint->path ? checkpoint->path : "", error);
+    checkpoint_free(checkpoint);
+    return ok;
+}
+
+// Writer thread: finish the save, run the completion hook, publish the outcome
+static void *async_writer_main(void *arg) {
+    checkpoint_t *checkpoint = (checkpoint_t *)arg;
+    checkpoint_done_fn done = checkpoint->done;
+    void *done_ctx = checkpoint->done_ctx;
+    char error[sizeof(g_async.error)] = "";
+    bool ok = async_write(checkpoint, error, sizeof(error));
+    if (done && !done(ok, done_ctx) && ok) {
+        snprintf(error, sizeof(error), "completion failed");
+        ok = false;
+    }
+    pthread_mutex_lock(&g_async.lock);
+    g_async.state = ok ? CHECKPOINT_SAVE_DONE : CHECKPOINT_SAVE_FAILED;
+    memcpy(g_async.error, error, sizeof(error));
+    g_async.busy = false;
+    pthread_cond_broadcast(&g_async.idle);
+    pthread_mutex_unlock(&g_async.lock);
+    return NULL;
+}
+
+// Close a checkpoint and free its resources
+void checkpoint_close(checkpoint_t *checkpoint) {
+    if (!checkpoint)
+        return;
+
+    // An asynchronous capture closed this way is finished on the spot
+    if (checkpoint->async) {
+        char error[sizeof(g_async.error)];
+        async_write(checkpoint, error, sizeof(error));
+        return;
+    }
+    if (checkpoint->is_writing && checkpoint->buf)
+        quick_commit(checkpoint);
+    if (checkpoint->is_writing && checkpoint->pool_refs && !checkpoint->error)
+        pool_write_refs(checkpoint);
+    checkpoint_free(checkpoint);
+}
+
+// Hand an asynchronous capture to a writer thread
+void checkpoint_close_async(checkpoint_t *checkpoint, checkpoint_done_fn done, void *ctx) {
+    if (!checkpoint)
+        return;
+    if (!checkpoint->async) {
+        bool ok = !checkpoint->error;
+        checkpoint_close(checkpoint);
+        if (done)
+            done(ok, ctx);
+        return;
+    }
+    checkpoint->done = done;
+    checkpoint->done_ctx = ctx;
+    pthread_mutex_lock(&g_async.lock);
+    g_async.busy = true;
+    g_async.state = CHECKPOINT_SAVE_PENDING;
+    g_async.error[0] = '\0';
+    pthread_mutex_unlock(&g_async.lock);
+
+    // Without a thread the save still completes, just not in the background
+    pthread_attr_t attr;
+    pthread_t thread;
+    bool started = false;
+    if (pthread_attr_init(&attr) == 0) {
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        started = pthread_create(&thread, &attr, async_writer_main, checkpoint) == 0;
+        pthread_attr_destroy(&attr);
+    }
+    if (!started)
+        async_writer_main(checkpoint);
+}
+
+// Block until the asynchronous save in flight, if any, has finished
+void checkpoint_async_wait(void) {
+    pthread_mutex_lock(&g_async.lock);
+    while (g_async.busy)
+        pthread_cond_wait(&g_async.idle, &g_async.lock);
+    pthread_mutex_unlock(&g_async.lock);
+}
+
+// State of the most recent asynchronous save
+checkpoint_save_state_t checkpoint_save_state(void) {
+    pthread_mutex_lock(&g_async.lock);
+    checkpoint_save_state_t state = g_async.state;
+    pthread_mutex_unlock(&g_async.lock);
+    return state;
+}
+
+// Failure reason of the most recent asynchronous save ("" if none)
+const char *checkpoint_last_error(void) {
+    pthread_mutex_lock(&g_async.lock);
+    memcpy(g_async.error_copy, g_async.error, sizeof(g_async.error_copy));
+    pthread_mutex_unlock(&g_async.lock);
+    return g_async.error_copy;
+}
+
 // Check if a checkpoint encountered an error during read/write
 bool checkpoint_has_error(checkpoint_t *checkpoint) {
     return checkpoint ? checkpoint->error : true;
@@ -818,6 +1751,77 @@ void checkpoint_set_error(checkpoint_t *checkpoint) {
         checkpoint->error = true;
 }
 
+// === In-memory checkpoints ===
+
+// Open an in-memory checkpoint: a headerless v2 stream in a memory stream
+// whose large blocks go to pool
+checkpoint_t *checkpoint_open_write_mem(checkpoint_kind_t kind, const char *model_id, uint32_t ram_size_kb,
+                                        snapshot_mem_pool_t *pool) {
+    checkpoint_t *cp = (checkpoint_t *)calloc(1, sizeof(struct checkpoint));
+    if (!cp)
+        return NULL;
+    cp->pool_refs = snapshot_hash_set_new();
+    cp->file = cp->pool_refs ? open_memstream(&cp->mem, &cp->mem_size) : NULL;
+    if (!cp->file) {
+        snapshot_hash_set_free(cp->pool_refs);
+        free(cp);
+        return NULL;
+    }
+    cp->mem_pool = pool;
+    cp->is_writing = true;
+    cp->kind = kind;
+    if (model_id)
+        snprintf(cp->model_id, MODEL_ID_LEN, "%s", model_id);
+    cp->ram_size_kb = ram_size_kb;
+    return cp;
+}
+
+// Finish an in-memory checkpoint and hand over its stream and references
+bool checkpoint_close_mem(checkpoint_t *checkpoint, void **data, size_t *size, snapshot_hash_set_t **refs) {
+    *data = NULL;
+    *size = 0;
+    *refs = NULL;
+    if (!checkpoint)
+        return false;
+    bool ok = checkpoint->mem_pool && checkpoint->is_writing && !checkpoint->error;
+    if (fclose(checkpoint->file) != 0)
+        ok = false;
+    checkpoint->file = NULL;
+    if (ok) {
+        *data = checkpoint->mem;
+        *size = checkpoint->mem_size;
+        *refs = checkpoint->pool_refs;
+        checkpoint->mem = NULL;
+        checkpoint->pool_refs = NULL;
+    } else if (checkpoint->mem_pool && checkpoint->pool_refs) {
+        snapshot_mem_pool_release(checkpoint->mem_pool, snapshot_hash_set_items(checkpoint->pool_refs),
+                                  snapshot_hash_set_count(checkpoint->pool_refs));
+    }
+    checkpoint_free(checkpoint);
+    return ok;
+}
+
+// Open a stream from checkpoint_close_mem for reading
+checkpoint_t *checkpoint_open_read_mem(const void *data, size_t size, checkpoint_kind_t kind, const char *model_id,
+                                       uint32_t ram_size_kb, snapshot_mem_pool_t *pool) {
+    if (!data || !size)
+        return NULL;
+    checkpoint_t *cp = (checkpoint_t *)calloc(1, sizeof(struct checkpoint));
+    if (!cp)
+        return NULL;
+    cp->file = fmemopen((void *)data, size, "rb");
+    if (!cp->file) {
+        free(cp);
+        return NULL;
+    }
+    cp->mem_pool = pool;
+    cp->kind = kind;
+    if (model_id)
+        snprintf(cp->model_id, MODEL_ID_LEN, "%s", model_id);
+    cp->ram_size_kb = ram_size_kb;
+    return cp;
+}
+
 // === File Serialization ===
 
 // Save mode: whether files are stored by value (contents) or by reference (path only)
@@ -831,6 +1835,53 @@ bool checkpoint_get_files_as_refs(void) {
     return g_checkpoint_files_as_refs;
 }
 
+// Save mode: whether consolidated checkpoints store RAM page-aligned and raw
+static bool g_checkpoint_ram_mapped = false;
+
+void checkpoint_set_ram_mapped(bool mapped) {
+    g_checkpoint_ram_mapped = mapped;
+}
+
+bool checkpoint_get_ram_mapped(void) {
+    return g_checkpoint_ram_mapped;
+}
+
+// Save mode: whether consolidated checkpoints keep large blocks in the snapshot pool
+static bool g_checkpoint_pooled = false;
+
+void checkpoint_set_pooled(bool pooled) {
+    g_checkpoint_pooled = pooled;
+}
+
+bool checkpoint_get_pooled(void) {
+    return g_checkpoint_pooled;
+}
+
+// Add the pool objects a pooled checkpoint references to refs
+bool checkpoint_pool_refs(const char *filename, snapshot_hash_set_t *refs) {
+    FILE *f = fopen(filename, "rb");
+    if (!f)
+        return false;
+    char magic[CHECKPOINT_MAGIC_LEN];
+    uint64_t count = 0;
+    bool ok = fseeko(f, 0, SEEK_END) == 0;
+    off_t end = ok ? ftello(f) : -1;
+    ok = end >= (off_t)(CHECKPOINT_MAGIC_LEN + sizeof(count)) &&
+         fseeko(f, end - (off_t)(CHECKPOINT_MAGIC_LEN + sizeof(count)), SEEK_SET) == 0 &&
+         fread(&count, 1, sizeof(count), f) == sizeof(count) && fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+         memcmp(magic, CHECKPOINT_POOL_REFS_MAGIC, CHECKPOINT_MAGIC_LEN) == 0;
+    uint64_t list_bytes = count * sizeof(snapshot_hash_t);
+    ok = ok && count <= (uint64_t)end / sizeof(snapshot_hash_t) &&
+         (uint64_t)end >= list_bytes + CHECKPOINT_MAGIC_LEN + sizeof(count) &&
+         fseeko(f, end - (off_t)(list_bytes + CHECKPOINT_MAGIC_LEN + sizeof(count)), SEEK_SET) == 0;
+    for (uint64_t i = 0; ok && i < count; i++) {
+        snapshot_hash_t hash;
+        ok = fread(&hash, 1, sizeof(hash), f) == sizeof(hash) && snapshot_hash_set_add(refs, &hash, NULL, NULL);
+    }
+    fclose(f);
+    return ok;
+}
+
 // Write a file to the checkpoint (either content or reference mode)
 void checkpoint_write_file_loc(checkpoint_t *checkpoint, const char *path, const char *file, int line) {
     if (!checkpoint || checkpoint->error || !checkpoint->is_writing) {
@@ -884,6 +1935,7 @@ void checkpoint_write_file_loc(checkpoint_t *checkpoint, const char *path, const
     uint64_t payload_size = 0;
     uint64_t content_size = 0;
     uint32_t name_len = (path && path[0]) ? (uint32_t)strlen(path) : 0;
+    bool pooled = false;
 
     if (include_content) {
         if (path && path[0]) {
@@ -897,6 +1949,12 @@ void checkpoint_write_file_loc(checkpoint_t *checkpoint, const char *path, const
             }
         }
         payload_size = 4 + name_len + 1 + 8 + content_size;
+        if (checkpoint->pool_dir && content_size >= POOL_MIN_BLOCK) {
+            // Pooled content: the piece list replaces the bytes
+            pooled = true;
+            payload_size = 4 + name_len + 1 + 8 + 8 +
+                           (content_size + POOL_BLOB_PIECE - 1) / POOL_BLOB_PIECE * sizeof(snapshot_hash_t);
+        }
     } else {
         payload_size = 4 + name_len + 1;
     }
@@ -941,8 +1999,8 @@ void checkpoint_write_file_loc(checkpoint_t *checkpoint, const char *path, const
             return;
         }
     }
-    // Content flag
-    uint8_t has_content = include_content ? 1 : 0;
+    // Content flag (2 = content held in the snapshot pool)
+    uint8_t has_content = pooled ? 2 : include_content ? 1 : 0;
     w = fwrite(&has_content, 1, 1, checkpoint->file);
     if (w != 1) {
         checkpoint->error = true;
@@ -965,6 +2023,17 @@ void checkpoint_write_file_loc(checkpoint_t *checkpoint, const char *path, const
                 printf("Error: cannot read '%s' for checkpoint write: source file missing\n", path);
                 checkpoint->error = true;
                 return;
+            } else if (pooled) {
+                uint8_t *piece = (uint8_t *)malloc(POOL_BLOB_PIECE);
+                bool ok = piece && pool_write_list_head(checkpoint, content_size, POOL_BLOB_PIECE);
+                for (uint64_t off = 0; ok && off < content_size; off += POOL_BLOB_PIECE) {
+                    size_t len = content_size - off < POOL_BLOB_PIECE ? (size_t)(content_size - off) : POOL_BLOB_PIECE;
+                    ok = fread(piece, 1, len, f) == len && pool_write_piece(checkpoint, piece, len);
+                }
+                free(piece);
+                fclose(f);
+                if (!ok)
+                    checkpoint->error = true;
             } else {
                 uint8_t buf[8192];
                 size_t r;
@@ -1136,7 +2205,15 @@ size_t checkpoint_read_file_loc(checkpoint_t *checkpoint, uint8_t *dest, size_t
     }
 
     size_t loaded = 0;
-    if (has_content) {
+    if (has_content == 2) {
+        uint64_t content_size = 0;
+        got = fread(&content_size, 1, sizeof(content_size), checkpoint->file);
+        if (got != sizeof(content_size) || !pool_read_pieces(checkpoint, dest, content_size, dest ? capacity : 0)) {
+            checkpoint->error = true;
+            return 0;
+        }
+        loaded = dest ? (content_size < capacity ? (size_t)content_size : capacity) : 0;
+    } else if (has_content) {
         uint64_t content_size = 0;
         got = fread(&content_size, 1, sizeof(content_size), checkpoint->file);
         if (got != sizeof(content_size)) {
@@ -1189,12 +2266,13 @@ bool checkpoint_validate_build_id(const char *filename) {
         return false;
     }
     if (memcmp(magic, CHECKPOINT_MAGIC_V2, CHECKPOINT_MAGIC_LEN) != 0 &&
-        memcmp(magic, CHECKPOINT_MAGIC_V3, CHECKPOINT_MAGIC_LEN) != 0) {
+        memcmp(magic, CHECKPOINT_MAGIC_V3, CHECKPOINT_MAGIC_LEN) != 0 &&
+        memcmp(magic, CHECKPOINT_MAGIC_V4, CHECKPOINT_MAGIC_LEN) != 0) {
         fclose(f);
         return false;
     }
 
-    // Read build ID (immediately follows magic in both formats)
+    // Read build ID (immediately follows magic in every format)
     char file_build_id[BUILD_ID_LEN];
     if (fread(file_build_id, 1, BUILD_ID_LEN, f) != BUILD_ID_LEN) {
         fclose(f);
@@ -1206,6 +2284,31 @@ bool checkpoint_validate_build_id(const char *filename) {
     return memcmp(file_build_id, get_build_id(), BUILD_ID_LEN) == 0;
 }
 
+// True when a quick checkpoint written to filename would append a delta record
+bool checkpoint_quick_appends(const char *filename) {
+    checkpoint_async_wait();
+    return quick_chain_extends(filename, g_quick_chain.model_id, g_quick_chain.ram_size_kb);
+}
+
+// Rename a quick checkpoint file, carrying the delta chain along with it
+int checkpoint_quick_rename(const char *from, const char *to) {
+    int rc = rename(from, to);
+    if (rc != 0 || !g_quick_chain.valid)
+        return rc;
+    if (strcmp(g_quick_chain.path, from) == 0) {
+        char *path = strdup(to);
+        if (!path) {
+            quick_chain_reset();
+            return rc;
+        }
+        free(g_quick_chain.path);
+        g_quick_chain.path = path;
+    } else if (strcmp(g_quick_chain.path, to) == 0) {
+        quick_chain_reset(); // the chain's file was replaced
+    }
+    return rc;
+}
+
 // ============================================================================
 // Object-model class descriptor
 // ============================================================================
@@ -1247,23 +2350,39 @@ static value_t checkpoint_method_load(struct object *self, const member_t *m, in
     return val_bool(cmd_load_checkpoint(1, fake_argv) == 0);
 }
 
-// `checkpoint.save(path, [mode])` — write a consolidated checkpoint to
-// the given path. `mode` is "content" (default; embed image bytes) or
-// "refs" (record paths only — smaller file, requires the same images
-// to exist on restore).
+// `checkpoint.save(path, [mode], [async], [mapped])` — write a
+// consolidated checkpoint to the given path. `mode` is "content" (default;
+// embed image bytes) or "refs" (record paths only — smaller file, requires
+// the same images to exist on restore). With `async` the call returns once
+// the machine is captured; `save_state` / `last_error` / `wait()` follow the
+// background write. With `mapped` RAM is stored uncompressed and page-aligned
+// so restores can map it instead of reading it.
 static value_t checkpoint_method_save(struct object *self, const member_t *m, int argc, const value_t *argv) {
     (void)self;
     (void)m;
     const char *path = argv[0].s;
-    char *fake_argv[3] = {"--save", (char *)path, NULL};
+    char *fake_argv[5] = {"--save", (char *)path, NULL, NULL, NULL};
     int fake_argc = 2;
-    if (argc >= 2 && argv[1].s && *argv[1].s) {
-        fake_argv[2] = (char *)argv[1].s;
-        fake_argc = 3;
-    }
+    if (argc >= 2 && argv[1].s && *argv[1].s)
+        fake_argv[fake_argc++] = (char *)argv[1].s;
+    if (argc >= 3 && argv[2].b)
+        fake_argv[fake_argc++] = "--async";
+    if (argc >= 4 && argv[3].b)
+        fake_argv[fake_argc++] = "--mapped";
     return val_bool(cmd_save_checkpoint(fake_argc, fake_argv) == 0);
 }
 
+// `checkpoint.wait()` — block until a background save has been written;
+// returns false when it failed
+static value_t checkpoint_method_wait(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    (void)argv;
+    checkpoint_async_wait();
+    return val_bool(checkpoint_save_state() != CHECKPOINT_SAVE_FAILED);
+}
+
 // `checkpoint.snapshot(name)` — capture a quick (background) checkpoint
 // under the given label. Routes to the platform-specific
 // gs_background_checkpoint (WASM implements via save_quick_checkpoint;
@@ -1290,6 +2409,22 @@ static value_t checkpoint_attr_auto_set(struct object *self, const member_t *m,
     return val_none();
 }
 
+// `checkpoint.save_state` (V_STRING, RO) — outcome of the most recent
+// background save: "idle", "pending", "done" or "failed"
+static value_t checkpoint_attr_save_state(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    static const char *const names[] = {"idle", "pending", "done", "failed"};
+    return val_str(names[checkpoint_save_state()]);
+}
+
+// `checkpoint.last_error` (V_STRING, RO) — why that save failed ("" if it did not)
+static value_t checkpoint_attr_last_error(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_str(checkpoint_last_error());
+}
+
 static const arg_decl_t checkpoint_load_args[] = {
     {.name = "path",
      .kind = V_STRING,
@@ -1303,6 +2438,14 @@ static const arg_decl_t checkpoint_save_args[] = {
      .kind = V_STRING,
      .validation_flags = OBJ_ARG_OPTIONAL,
      .doc = "\"content\" (default) or \"refs\""},
+    {.name = "async",
+     .kind = V_BOOL,
+     .validation_flags = OBJ_ARG_OPTIONAL,
+     .doc = "true = capture now, write the file in the background"},
+    {.name = "mapped",
+     .kind = V_BOOL,
+     .validation_flags = OBJ_ARG_OPTIONAL,
+     .doc = "true = store RAM raw and page-aligned for mapped restores"},
 };
 
 static const arg_decl_t checkpoint_snapshot_args[] = {
@@ -1315,6 +2458,16 @@ static const member_t checkpoint_members[] = {
      .doc = "Background auto-checkpoint loop enabled (WASM only)",
      .flags = 0,
      .attr = {.type = V_BOOL, .get = checkpoint_attr_auto_get, .set = checkpoint_attr_auto_set}},
+    {.kind = M_ATTR,
+     .name = "save_state",
+     .doc = "Most recent background save: idle, pending, done or failed",
+     .flags = VAL_RO,
+     .attr = {.type = V_STRING, .get = checkpoint_attr_save_state, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "last_error",
+     .doc = "Why the most recent background save failed (empty if it did not)",
+     .flags = VAL_RO,
+     .attr = {.type = V_STRING, .get = checkpoint_attr_last_error, .set = NULL}},
     {.kind = M_METHOD,
      .name = "probe",
      .doc = "True if a valid checkpoint exists for the active machine",
@@ -1330,7 +2483,11 @@ static const member_t checkpoint_members[] = {
     {.kind = M_METHOD,
      .name = "save",
      .doc = "Save the current machine state to a checkpoint file",
-     .method = {.args = checkpoint_save_args, .nargs = 2, .result = V_BOOL, .fn = checkpoint_method_save}},
+     .method = {.args = checkpoint_save_args, .nargs = 4, .result = V_BOOL, .fn = checkpoint_method_save}},
+    {.kind = M_METHOD,
+     .name = "wait",
+     .doc = "Wait for a background save to finish; false if it failed",
+     .method = {.args = NULL, .nargs = 0, .result = V_BOOL, .fn = checkpoint_method_wait}},
     {.kind = M_METHOD,
      .name = "snapshot",
      .doc = "Capture a quick (background) checkpoint under the given label",
@@ -1357,6 +2514,11 @@ void checkpoint_init(void) {
         object_attach(object_root(), s_checkpoint_object);
 }
 
+// The `checkpoint` object (NULL before checkpoint_init)
+struct object *checkpoint_object(void) {
+    return s_checkpoint_object;
+}
+
 void checkpoint_delete(void) {
     if (s_checkpoint_object) {
         object_detach(s_checkpoint_object);
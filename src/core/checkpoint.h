@@ -13,10 +13,13 @@
 #include <stddef.h>
 #include <stdint.h>
 
-// Checkpoint kind: quick (auto-save) vs consolidated (full export)
+// Checkpoint kind: quick (auto-save) vs consolidated (full export), plus the
+// in-memory snapshots of reverse execution (history: files by reference, disk
+// deltas by content, nothing committed)
 typedef enum {
     CHECKPOINT_KIND_QUICK = 0,
     CHECKPOINT_KIND_CONSOLIDATED = 1,
+    CHECKPOINT_KIND_HISTORY = 2,
 } checkpoint_kind_t;
 
 // === Checkpoint Handle Management ===
@@ -61,6 +64,99 @@ void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data
 #define system_write_checkpoint_data(cp, data, size)                                                                   \
     system_write_checkpoint_data_loc((cp), (data), (size), __FILE__, __LINE__)
 
+// Writes guest RAM (one byte per 4 KB page in dirty, non-zero = written since
+// the previous quick checkpoint; NULL = unknown).  A quick checkpoint that
+// extends the file's record chain stores only the dirty pages; every other
+// checkpoint stores all of RAM.  Read back with system_read_checkpoint_data.
+void checkpoint_write_ram_loc(checkpoint_t *checkpoint, const uint8_t *ram, size_t size, const uint8_t *dirty,
+                              const char *file, int line);
+
+#define checkpoint_write_ram(cp, ram, size, dirty)                                                                     \
+    checkpoint_write_ram_loc((cp), (ram), (size), (dirty), __FILE__, __LINE__)
+
+// Reads guest RAM written by checkpoint_write_ram.  When may_map is set and
+// the block was saved in the mapped layout, the file range is mapped
+// MAP_PRIVATE over ram (which must be page-aligned memory the caller obtained
+// from mmap) instead of being copied: pages fault in lazily, are shared with
+// every other process mapping the same file, and are copied only on write.
+// Returns true when ram was mapped, false when it was read (or on error).
+bool checkpoint_read_ram_loc(checkpoint_t *checkpoint, uint8_t *ram, size_t size, bool may_map, const char *file,
+                             int line);
+
+#define checkpoint_read_ram(cp, ram, size, may_map)                                                                    \
+    checkpoint_read_ram_loc((cp), (ram), (size), (may_map), __FILE__, __LINE__)
+
+// === Incremental quick checkpoints ===
+// A quick checkpoint written to the same path as the previous one appends a
+// delta record instead of rewriting the file; after QUICK_MAX_DELTAS deltas,
+// or once the deltas outweigh half the base, the next one compacts the file
+// into a fresh base.
+
+// Returns true if a quick checkpoint written to filename would append a delta
+bool checkpoint_quick_appends(const char *filename);
+
+// rename(2) for quick checkpoint files: keeps the delta chain attached to the
+// file under its new name.  Returns rename's result.
+int checkpoint_quick_rename(const char *from, const char *to);
+
+// === Asynchronous save ===
+// An asynchronous save splits a checkpoint in two.  Capture runs on the
+// calling thread: device state serialises into memory as usual, and guest RAM
+// is handed over as a deferred block together with a reader for a snapshot of
+// it (memory_ram_cow_read).  checkpoint_close_async then leaves compression,
+// the file write and fsync to a background writer thread while the guest runs
+// on.  One save is in flight at a time; opening any checkpoint, and
+// checkpoint_quick_appends, first wait for it.
+
+// Outcome of the most recent asynchronous save
+typedef enum {
+    CHECKPOINT_SAVE_IDLE = 0, // none started yet
+    CHECKPOINT_SAVE_PENDING, // captured, still being written
+    CHECKPOINT_SAVE_DONE, // written and synced
+    CHECKPOINT_SAVE_FAILED, // see checkpoint_last_error
+} checkpoint_save_state_t;
+
+// Copies [off, off + len) of a RAM snapshot into dst; false if the snapshot is unusable
+typedef bool (*checkpoint_ram_read_fn)(void *ctx, size_t off, uint8_t *dst, size_t len);
+
+// Releases a RAM snapshot once the writer has read all of it
+typedef void (*checkpoint_ram_release_fn)(void *ctx);
+
+// Runs on the writer thread once the file is synced and closed (ok = so far
+// so good); its return value is the outcome of the save
+typedef bool (*checkpoint_done_fn)(bool ok, void *ctx);
+
+// Like checkpoint_open_write, for a save finished by checkpoint_close_async
+checkpoint_t *checkpoint_open_write_async(const char *filename, checkpoint_kind_t kind, const char *model_id,
+                                          uint32_t ram_size_kb);
+
+// True for a handle from checkpoint_open_write_async
+bool checkpoint_is_async(checkpoint_t *checkpoint);
+
+// Asynchronous counterpart of checkpoint_write_ram: records a RAM block of
+// size bytes whose contents the writer pulls through read.  The dirty map is
+// copied now.  The checkpoint owns the snapshot from here on and calls
+// release exactly once, on every path.
+void checkpoint_write_ram_deferred_loc(checkpoint_t *checkpoint, size_t size, const uint8_t *dirty,
+                                       checkpoint_ram_read_fn read, checkpoint_ram_release_fn release, void *ctx,
+                                       const char *file, int line);
+
+#define checkpoint_write_ram_deferred(cp, size, dirty, read, release, ctx)                                             \
+    checkpoint_write_ram_deferred_loc((cp), (size), (dirty), (read), (release), (ctx), __FILE__, __LINE__)
+
+// Hands an asynchronous handle to the writer thread and returns at once; the
+// handle is gone afterwards.  done (may be NULL) runs when the file is written.
+void checkpoint_close_async(checkpoint_t *checkpoint, checkpoint_done_fn done, void *ctx);
+
+// Blocks until no asynchronous save is in flight
+void checkpoint_async_wait(void);
+
+// State of the most recent asynchronous save
+checkpoint_save_state_t checkpoint_save_state(void);
+
+// Why the most recent asynchronous save failed ("" if it did not)
+const char *checkpoint_last_error(void);
+
 // === File Serialization (content or reference mode) ===
 
 // Writes a file to the checkpoint (either embedded or as reference)
@@ -83,6 +179,54 @@ void checkpoint_set_files_as_refs(bool refs);
 // Returns the current file-as-reference mode setting
 bool checkpoint_get_files_as_refs(void);
 
+// Sets whether consolidated checkpoints store RAM in the mapped layout: raw
+// and aligned in the file so a restore can map it (larger file, near-instant
+// restore on hosts with mmap)
+void checkpoint_set_ram_mapped(bool mapped);
+
+// Returns the current mapped-layout setting
+bool checkpoint_get_ram_mapped(void);
+
+// === Snapshot pool ===
+// A pooled consolidated checkpoint keeps every block of 4 KB or more in the
+// content-addressed pool beside the file (snapshot_pool.h) and stores only
+// object hashes; RAM is split into 4 KB pages, other blocks into 64 KB
+// pieces.  It ends with the list of objects it references.
+
+// Sets whether synchronous consolidated checkpoints are pooled
+void checkpoint_set_pooled(bool pooled);
+
+// Returns the current pooled setting
+bool checkpoint_get_pooled(void);
+
+struct snapshot_hash_set;
+
+// Adds the objects a pooled checkpoint references to refs.  Returns false
+// when the file cannot be read or is not a complete pooled checkpoint.
+bool checkpoint_pool_refs(const char *filename, struct snapshot_hash_set *refs);
+
+// === In-memory checkpoints ===
+// A checkpoint can also be a headerless consolidated stream in memory whose
+// large blocks live in an in-memory pool (snapshot_pool.h).  Each checkpoint
+// holds one pool reference per distinct object it names; whoever keeps the
+// stream releases them with snapshot_mem_pool_release when dropping it.
+
+struct snapshot_mem_pool;
+
+// Opens an in-memory checkpoint for writing into pool
+checkpoint_t *checkpoint_open_write_mem(checkpoint_kind_t kind, const char *model_id, uint32_t ram_size_kb,
+                                        struct snapshot_mem_pool *pool);
+
+// Closes an in-memory checkpoint: on success hands over the malloc'd stream
+// and the set of objects it references (the caller now owns both references
+// and memory).  On failure drops the references and returns false.
+bool checkpoint_close_mem(checkpoint_t *checkpoint, void **data, size_t *size, struct snapshot_hash_set **refs);
+
+// Opens a stream from checkpoint_close_mem for reading; data must outlive
+// the handle, which is closed with checkpoint_close
+checkpoint_t *checkpoint_open_read_mem(const void *data, size_t size, checkpoint_kind_t kind, const char *model_id,
+                                       uint32_t ram_size_kb, struct snapshot_mem_pool *pool);
+
 // Validate that a checkpoint file's build ID matches the current build.
 // Opens the file, reads magic + build ID, compares with current build.
 // Returns true if the build IDs match, false on mismatch or error.
@@ -92,14 +236,20 @@ bool checkpoint_validate_build_id(const char *filename);
 //
 // `checkpoint` is a process-singleton namespace registered at shell_init
 // (alongside rom / vrom / machine). It exposes save / load / clear /
-// probe / snapshot methods plus the auto_checkpoint attribute so
-// callers can drive the checkpoint subsystem without going through the
-// legacy `checkpoint --foo` shell-form parser.
+// probe / snapshot / wait methods plus the auto_checkpoint attribute and
+// the save_state / last_error report of background saves, so callers can
+// drive the checkpoint subsystem without going through the legacy
+// `checkpoint --foo` shell-form parser. The snapshot store hangs off it as
+// `checkpoint.store`.
 
 struct class_desc;
+struct object;
 extern const struct class_desc checkpoint_class;
 
 void checkpoint_init(void);
 void checkpoint_delete(void);
 
+// The `checkpoint` object, or NULL before checkpoint_init
+struct object *checkpoint_object(void);
+
 #endif // CHECKPOINT_H
@@ -0,0 +1,467 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// chunk_lz.c
+// Chunked LZ compression for checkpoint blocks: the per-chunk LZ77 codec, the
+// chunk stream container, and the thread pool that runs chunks in parallel.
+
+#include "chunk_lz.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(__EMSCRIPTEN__) && !defined(GS_CHUNK_LZ_SERIAL)
+#define CHUNK_LZ_PARALLEL 1
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Stream header: raw size, chunk size, chunk count
+#define CHUNK_LZ_HEADER_BYTES (sizeof(uint64_t) + 2 * sizeof(uint32_t))
+
+// Upper bound on pool size (the main thread counts as one)
+#define CHUNK_LZ_MAX_THREADS 8
+
+// === LZ codec ===
+// A chunk is a sequence of {token, literals, offset, match} records.  The
+// token's high nibble is the literal count and its low nibble the match length
+// minus LZ_MIN_MATCH; 15 in either nibble means more length bytes follow
+// (each adds 0-255, a 255 continues).  The offset is 16-bit little-endian and
+// counts back from the current output position.  The last record has literals
+// only: the chunk ends right after them.
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 14
+
+// Unaligned 32-bit load
+static inline uint32_t lz_load32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Multiplicative hash of the 4 bytes at a position
+static inline uint32_t lz_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Length of the common prefix of a and b, at most max bytes
+static inline size_t lz_common(const uint8_t *a, const uint8_t *b, size_t max) {
+    size_t n = 0;
+    while (n + 8 <= max) {
+        uint64_t x, y;
+        memcpy(&x, a + n, sizeof(x));
+        memcpy(&y, b + n, sizeof(y));
+        if (x != y) {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return n + ((size_t)__builtin_ctzll(x ^ y) >> 3);
+#else
+            break;
+#endif
+        }
+        n += 8;
+    }
+    while (n < max && a[n] == b[n])
+        n++;
+    return n;
+}
+
+// Bytes needed for an extended length of n (n already minus the nibble's 15)
+static inline size_t lz_len_bytes(size_t n) {
+    return n / 255 + 1;
+}
+
+// Write an extended length (n already minus the nibble's 15)
+static inline uint8_t *lz_put_len(uint8_t *op, size_t n) {
+    while (n >= 255) {
+        *op++ = 255;
+        n -= 255;
+    }
+    *op++ = (uint8_t)n;
+    return op;
+}
+
+// Emit one record; mlen 0 makes it the final, literal-only record.  Returns
+// false when it would not fit in out[*op..cap).
+static bool lz_emit(uint8_t *out, size_t cap, size_t *op, const uint8_t *lit, size_t lit_len, size_t offset,
+                    size_t mlen) {
+    size_t mcode = mlen ? mlen - LZ_MIN_MATCH : 0;
+    size_t need = 1 + lit_len + (lit_len >= 15 ? lz_len_bytes(lit_len - 15) : 0);
+    if (mlen)
+        need += 2 + (mcode >= 15 ? lz_len_bytes(mcode - 15) : 0);
+    if (need > cap - *op)
+        return false;
+    uint8_t *p = out + *op;
+    *p++ = (uint8_t)((lit_len < 15 ? lit_len : 15) << 4 | (mcode < 15 ? mcode : 15));
+    if (lit_len >= 15)
+        p = lz_put_len(p, lit_len - 15);
+    memcpy(p, lit, lit_len);
+    p += lit_len;
+    if (mlen) {
+        *p++ = (uint8_t)offset;
+        *p++ = (uint8_t)(offset >> 8);
+        if (mcode >= 15)
+            p = lz_put_len(p, mcode - 15);
+    }
+    *op = (size_t)(p - out);
+    return true;
+}
+
+// Compress one chunk (len <= 64 KB) into out[0..cap).  Greedy hash-chain-free
+// matching; the search step grows across misses so incompressible data costs
+// little.  Returns the compressed size, or 0 when it does not fit in cap.
+static size_t lz_encode_chunk(const uint8_t *in, size_t len, uint8_t *out, size_t cap) {
+    // Per thread rather than on the stack: WASM worker stacks are small
+    static _Thread_local uint16_t table[1u << LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+    size_t ip = 0, anchor = 0, op = 0;
+    unsigned misses = 0;
+    while (len >= LZ_MIN_MATCH && ip <= len - LZ_MIN_MATCH) {
+        uint32_t seq = lz_load32(in + ip);
+        uint32_t h = lz_hash(seq);
+        size_t cand = table[h];
+        table[h] = (uint16_t)ip;
+        if (cand >= ip || lz_load32(in + cand) != seq) {
+            ip += 1 + (misses++ >> 5);
+            continue;
+        }
+        size_t mlen = LZ_MIN_MATCH + lz_common(in + cand + LZ_MIN_MATCH, in + ip + LZ_MIN_MATCH,
+                                               len - ip - LZ_MIN_MATCH);
+        while (ip > anchor && cand > 0 && in[ip - 1] == in[cand - 1]) {
+            ip--;
+            cand--;
+            mlen++;
+        }
+        if (!lz_emit(out, cap, &op, in + anchor, ip - anchor, ip - cand, mlen))
+            return 0;
+        ip += mlen;
+        anchor = ip;
+        misses = 0;
+        if (ip >= 2 && ip - 2 <= len - LZ_MIN_MATCH)
+            table[lz_hash(lz_load32(in + ip - 2))] = (uint16_t)(ip - 2);
+    }
+    if (!lz_emit(out, cap, &op, in + anchor, len - anchor, 0, 0))
+        return 0;
+    return op;
+}
+
+// Read an extended length, adding it to *len
+static bool lz_get_len(const uint8_t *in, size_t in_len, size_t *ip, size_t *len) {
+    uint8_t b;
+    do {
+        if (*ip >= in_len)
+            return false;
+        b = in[(*ip)++];
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+// Decompress one chunk; it must produce exactly out_len bytes
+static bool lz_decode_chunk(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_len) {
+    size_t ip = 0, op = 0;
+    for (;;) {
+        if (ip >= in_len)
+            return false;
+        uint8_t token = in[ip++];
+        size_t lit = token >> 4;
+        if (lit == 15 && !lz_get_len(in, in_len, &ip, &lit))
+            return false;
+        if (lit > in_len - ip || lit > out_len - op)
+            return false;
+        memcpy(out + op, in + ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == in_len)
+            return op == out_len;
+        if (in_len - ip < 2)
+            return false;
+        size_t offset = (size_t)in[ip] | (size_t)in[ip + 1] << 8;
+        ip += 2;
+        size_t mlen = token & 15;
+        if (mlen == 15 && !lz_get_len(in, in_len, &ip, &mlen))
+            return false;
+        mlen += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || mlen > out_len - op)
+            return false;
+        // Overlapping copies repeat the offset-long pattern: copy whole
+        // periods from its start, doubling each time
+        const uint8_t *base = out + op - offset;
+        if (offset >= mlen) {
+            memcpy(out + op, base, mlen);
+        } else {
+            size_t done = 0;
+            while (done < mlen) {
+                size_t n = offset + done;
+                if (n > mlen - done)
+                    n = mlen - done;
+                memcpy(out + op + done, base, n);
+                done += n;
+            }
+        }
+        op += mlen;
+    }
+}
+
+// === Thread pool ===
+// chunk_lz_run() hands `count` independent jobs to the pool; the calling
+// thread works too and returns once every job has finished.  Jobs are claimed
+// from an atomic counter, so a slow or absent worker never stalls a batch.
+
+// One parallel call: job callback and the claim/finish counters
+typedef struct chunk_batch {
+    void (*fn)(void *ctx, uint32_t index);
+    void *ctx;
+    uint32_t count;
+    uint32_t next; // next unclaimed job (atomic)
+    uint32_t done; // finished jobs (atomic)
+} chunk_batch_t;
+
+static unsigned g_thread_limit = 0; // 0 = auto
+
+#ifdef CHUNK_LZ_PARALLEL
+
+static struct {
+    pthread_mutex_t run; // one batch at a time
+    pthread_mutex_t lock; // guards everything below
+    pthread_cond_t wake; // a new batch was posted
+    pthread_cond_t idle; // a batch finished or a worker left it
+    unsigned workers; // threads started
+    unsigned busy; // workers inside the current batch
+    unsigned limit; // workers allowed to join the current batch
+    uint64_t generation; // bumped per batch
+    chunk_batch_t *batch;
+} g_pool = {.run = PTHREAD_MUTEX_INITIALIZER,
+            .lock = PTHREAD_MUTEX_INITIALIZER,
+            .wake = PTHREAD_COND_INITIALIZER,
+            .idle = PTHREAD_COND_INITIALIZER};
+
+// Run jobs from the batch until none are left
+static void batch_drain(chunk_batch_t *b) {
+    for (;;) {
+        uint32_t i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED);
+        if (i >= b->count)
+            return;
+        b->fn(b->ctx, i);
+        if (__atomic_add_fetch(&b->done, 1, __ATOMIC_ACQ_REL) == b->count) {
+            pthread_mutex_lock(&g_pool.lock);
+            pthread_cond_broadcast(&g_pool.idle);
+            pthread_mutex_unlock(&g_pool.lock);
+        }
+    }
+}
+
+// Pool thread: wait for a batch, help drain it, repeat
+static void *pool_worker(void *arg) {
+    (void)arg;
+    uint64_t seen = 0;
+    pthread_mutex_lock(&g_pool.lock);
+    for (;;) {
+        while (g_pool.generation == seen)
+            pthread_cond_wait(&g_pool.wake, &g_pool.lock);
+        seen = g_pool.generation;
+        chunk_batch_t *b = g_pool.batch;
+        if (!b || g_pool.busy >= g_pool.limit)
+            continue;
+        g_pool.busy++;
+        pthread_mutex_unlock(&g_pool.lock);
+        batch_drain(b);
+        pthread_mutex_lock(&g_pool.lock);
+        if (--g_pool.busy == 0)
+            pthread_cond_broadcast(&g_pool.idle);
+    }
+    return NULL;
+}
+
+// Threads to use for one call, including the caller
+static unsigned pool_threads(void) {
+    if (g_thread_limit)
+        return g_thread_limit < CHUNK_LZ_MAX_THREADS ? g_thread_limit : CHUNK_LZ_MAX_THREADS;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        return 1;
+    return cpus < CHUNK_LZ_MAX_THREADS ? (unsigned)cpus : CHUNK_LZ_MAX_THREADS;
+}
+
+// Run count jobs, in parallel when there is more than one
+static void chunk_lz_run(void (*fn)(void *, uint32_t), void *ctx, uint32_t count) {
+    unsigned threads = pool_threads();
+    if (count < 2 || threads < 2) {
+        for (uint32_t i = 0; i < count; i++)
+            fn(ctx, i);
+        return;
+    }
+    chunk_batch_t b = {.fn = fn, .ctx = ctx, .count = count};
+    pthread_mutex_lock(&g_pool.run);
+    pthread_mutex_lock(&g_pool.lock);
+    // Workers start lazily; a failed pthread_create only means fewer helpers
+    while (g_pool.workers < threads - 1) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, pool_worker, NULL) != 0)
+            break;
+        pthread_detach(t);
+        g_pool.workers++;
+    }
+    g_pool.limit = threads - 1;
+    g_pool.batch = &b;
+    g_pool.generation++;
+    pthread_cond_broadcast(&g_pool.wake);
+    pthread_mutex_unlock(&g_pool.lock);
+
+    batch_drain(&b);
+
+    pthread_mutex_lock(&g_pool.lock);
+    while (__atomic_load_n(&b.done, __ATOMIC_ACQUIRE) < count || g_pool.busy > 0)
+        pthread_cond_wait(&g_pool.idle, &g_pool.lock);
+    g_pool.batch = NULL;
+    pthread_mutex_unlock(&g_pool.lock);
+    pthread_mutex_unlock(&g_pool.run);
+}
+
+#else // serial build (WASM)
+
+// Run count jobs in order on the calling thread
+static void chunk_lz_run(void (*fn)(void *, uint32_t), void *ctx, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++)
+        fn(ctx, i);
+}
+
+#endif
+
+void chunk_lz_set_threads(unsigned threads) {
+    g_thread_limit = threads;
+}
+
+// === Chunk stream ===
+
+// Shared state of one encode or decode call
+typedef struct chunk_job {
+    const uint8_t *in;
+    uint8_t *out;
+    size_t size; // raw bytes
+    size_t slots; // encode: offset of chunk 0's slot in out
+    const size_t *offsets; // decode: offset of each chunk's data in in
+    uint32_t *stored; // stored-size table
+    bool failed; // decode: set by any chunk that fails (atomic)
+} chunk_job_t;
+
+// Raw bytes in chunk i of a size-byte input
+static inline size_t chunk_len(size_t size, uint32_t i) {
+    size_t off = (size_t)i * CHUNK_LZ_CHUNK_SIZE;
+    return size - off < CHUNK_LZ_CHUNK_SIZE ? size - off : CHUNK_LZ_CHUNK_SIZE;
+}
+
+// Encode chunk i into its worst-case slot (raw when compression does not pay)
+static void encode_job(void *ctx, uint32_t i) {
+    chunk_job_t *job = (chunk_job_t *)ctx;
+    size_t off = (size_t)i * CHUNK_LZ_CHUNK_SIZE;
+    size_t len = chunk_len(job->size, i);
+    uint8_t *slot = job->out + job->slots + off;
+    size_t n = lz_encode_chunk(job->in + off, len, slot, len - 1);
+    if (n) {
+        job->stored[i] = (uint32_t)n;
+    } else {
+        memcpy(slot, job->in + off, len);
+        job->stored[i] = (uint32_t)len | CHUNK_LZ_RAW;
+    }
+}
+
+// Decode chunk i into its place in the output
+static void decode_job(void *ctx, uint32_t i) {
+    chunk_job_t *job = (chunk_job_t *)ctx;
+    size_t len = chunk_len(job->size, i);
+    uint8_t *dst = job->out + (size_t)i * CHUNK_LZ_CHUNK_SIZE;
+    const uint8_t *src = job->in + job->offsets[i];
+    uint32_t stored = job->stored[i];
+    bool ok;
+    if (stored & CHUNK_LZ_RAW) {
+        ok = (stored & ~CHUNK_LZ_RAW) == len;
+        if (ok)
+            memcpy(dst, src, len);
+    } else {
+        ok = lz_decode_chunk(src, stored, dst, len);
+    }
+    if (!ok)
+        __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+}
+
+size_t chunk_lz_bound(size_t size) {
+    size_t count = (size + CHUNK_LZ_CHUNK_SIZE - 1) / CHUNK_LZ_CHUNK_SIZE;
+    return CHUNK_LZ_HEADER_BYTES + count * sizeof(uint32_t) + size;
+}
+
+size_t chunk_lz_encode(const uint8_t *in, size_t size, uint8_t *out, size_t cap) {
+    if (cap < chunk_lz_bound(size))
+        return 0;
+    uint32_t count = (uint32_t)((size + CHUNK_LZ_CHUNK_SIZE - 1) / CHUNK_LZ_CHUNK_SIZE);
+    uint32_t *stored = (uint32_t *)malloc(count ? count * sizeof(uint32_t) : 1);
+    if (!stored)
+        return 0;
+    size_t table = CHUNK_LZ_HEADER_BYTES;
+    size_t slots = table + (size_t)count * sizeof(uint32_t);
+
+    // Each chunk lands in its own raw-sized slot, so jobs never share bytes
+    chunk_job_t job = {.in = in, .out = out, .size = size, .slots = slots, .stored = stored};
+    chunk_lz_run(encode_job, &job, count);
+
+    // Pack the chunks down behind the table (each slot is no earlier than its final place)
+    size_t pos = slots;
+    for (uint32_t i = 0; i < count; i++) {
+        size_t n = stored[i] & ~CHUNK_LZ_RAW;
+        memmove(out + pos, out + slots + (size_t)i * CHUNK_LZ_CHUNK_SIZE, n);
+        pos += n;
+    }
+    uint64_t raw = (uint64_t)size;
+    uint32_t chunk_size = CHUNK_LZ_CHUNK_SIZE;
+    memcpy(out, &raw, sizeof(raw));
+    memcpy(out + sizeof(raw), &chunk_size, sizeof(chunk_size));
+    memcpy(out + sizeof(raw) + sizeof(chunk_size), &count, sizeof(count));
+    memcpy(out + table, stored, (size_t)count * sizeof(uint32_t));
+    free(stored);
+    return pos;
+}
+
+bool chunk_lz_raw_size(const uint8_t *in, size_t in_size, uint64_t *raw_size) {
+    if (in_size < CHUNK_LZ_HEADER_BYTES)
+        return false;
+    memcpy(raw_size, in, sizeof(*raw_size));
+    return true;
+}
+
+bool chunk_lz_decode(const uint8_t *in, size_t in_size, uint8_t *out, size_t size) {
+    uint64_t raw;
+    uint32_t chunk_size, count;
+    if (!chunk_lz_raw_size(in, in_size, &raw) || raw != (uint64_t)size)
+        return false;
+    memcpy(&chunk_size, in + sizeof(raw), sizeof(chunk_size));
+    memcpy(&count, in + sizeof(raw) + sizeof(chunk_size), sizeof(count));
+    if (chunk_size != CHUNK_LZ_CHUNK_SIZE || (uint64_t)count != (raw + chunk_size - 1) / chunk_size)
+        return false;
+    size_t table = CHUNK_LZ_HEADER_BYTES;
+    if ((in_size - table) / sizeof(uint32_t) < count)
+        return false;
+
+    // Chunk data offsets follow from the stored sizes; they must use the input exactly
+    uint32_t *stored = (uint32_t *)malloc(count ? count * sizeof(uint32_t) : 1);
+    size_t *offsets = (size_t *)malloc(count ? count * sizeof(size_t) : 1);
+    bool ok = stored && offsets;
+    if (ok) {
+        memcpy(stored, in + table, (size_t)count * sizeof(uint32_t));
+        size_t pos = table + (size_t)count * sizeof(uint32_t);
+        for (uint32_t i = 0; i < count && ok; i++) {
+            size_t n = stored[i] & ~CHUNK_LZ_RAW;
+            offsets[i] = pos;
+            ok = n <= in_size - pos;
+            pos += ok ? n : 0;
+        }
+        ok = ok && pos == in_size;
+    }
+    if (ok) {
+        chunk_job_t job = {.in = in, .out = out, .size = size, .offsets = offsets, .stored = stored};
+        chunk_lz_run(decode_job, &job, count);
+        ok = !job.failed;
+    }
+    free(stored);
+    free(offsets);
+    return ok;
+}
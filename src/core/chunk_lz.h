@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// chunk_lz.h
+// Chunked LZ compression for checkpoint blocks.
+//
+// A stream splits its input into fixed-size chunks and compresses each one
+// independently with a byte-oriented LZ77 codec (LZ4-style sequences: token,
+// literals, 16-bit offset, extended lengths).  Independent chunks are what
+// make the work parallel: the headless build encodes and decodes them on a
+// small thread pool, WASM (and GS_CHUNK_LZ_SERIAL builds) walk them in order.
+//
+// Stream layout (little-endian host order, like the rest of the checkpoint):
+//   uint64 raw_size, uint32 chunk_size, uint32 chunk_count,
+//   uint32 stored[chunk_count]   (bytes of each chunk; CHUNK_LZ_RAW bit = stored raw)
+//   chunk data, in order
+
+#ifndef CHUNK_LZ_H
+#define CHUNK_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Raw bytes per chunk (offsets within a chunk fit the codec's 16-bit offsets)
+#define CHUNK_LZ_CHUNK_SIZE (64u * 1024u)
+
+// Flag in a stored-size entry: the chunk is kept uncompressed
+#define CHUNK_LZ_RAW 0x80000000u
+
+// Worst-case stream size for `size` input bytes
+size_t chunk_lz_bound(size_t size);
+
+// Compress `size` bytes into out (capacity cap >= chunk_lz_bound(size)).
+// Returns the stream size, or 0 when cap is too small.
+size_t chunk_lz_encode(const uint8_t *in, size_t size, uint8_t *out, size_t cap);
+
+// Raw size recorded in a stream header; false when the header is truncated
+bool chunk_lz_raw_size(const uint8_t *in, size_t in_size, uint64_t *raw_size);
+
+// Decompress a whole stream into out, which must hold exactly `size` bytes.
+// Returns false on any malformed or mismatching input.
+bool chunk_lz_decode(const uint8_t *in, size_t in_size, uint8_t *out, size_t size);
+
+// Limit the worker threads used per call (0 = one per online CPU, capped;
+// 1 = serial).  Has no effect in serial builds.
+void chunk_lz_set_threads(unsigned threads);
+
+#endif // CHUNK_LZ_H
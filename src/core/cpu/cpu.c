@@ -27,6 +27,9 @@ LOG_USE_CATEGORY_NAME("cpu");
 void cpu_run_68000(cpu_t *restrict cpu, uint32_t *instructions);
 void cpu_run_68030(cpu_t *restrict cpu, uint32_t *instructions);
 
+// Pending lazy condition-code record (see cpu_internal.h; idle unless GS_LAZY_FLAGS)
+lazy_flags_t g_lazy_flags;
+
 // === Public Accessors ===
 
 // Get the value of address register An (n=0-7)
@@ -115,6 +118,85 @@ void cpu_poll_interrupt(cpu_t *restrict cpu) {
     cpu_check_interrupt(cpu);
 }
 
+// === Idle-Loop Detection ===
+//
+// A polling loop is provably idle when one pass over it returns the CPU to a
+// bit-identical state (registers, SR, PC, latched IR) without storing to
+// memory and without touching anything outside the SoA fast path: every
+// further pass then reads the same RAM/ROM words and makes the same
+// decisions, until an event changes memory or raises the IPL.  Stores are
+// ruled out by only accepting a small set of opcodes that write registers
+// and flags at most; device accesses (and anything else that reaches the
+// slow path, which is where all I/O lives) by g_mem_slowpath_count.
+
+// State captured by cpu_idle_mark
+static struct {
+    struct cpu mark;
+    uint64_t slowpath_count;
+} g_idle;
+
+// True if the instruction writes at most registers and flags: the polling
+// idioms (TST/CMP/BTST/MOVE-to-register, ADDQ/SUBQ/LEA on registers, then
+// Bcc/DBcc) and nothing that can store, push or change SR.  Exceptions (bad
+// EA, odd address) change the state and so never look like a loop.
+static bool idle_read_only_opcode(uint16_t op) {
+    uint32_t size = (op >> 6) & 3;
+    uint32_t opmode = (op >> 6) & 7;
+    uint32_t mode = (op >> 3) & 7;
+    switch (op >> 12) {
+    case 0x0: // CMPI, BTST #n, BTST Dn (MOVEP reads share the pattern)
+        return ((op & 0xFF00) == 0x0C00 && size != 3) || (op & 0xFFC0) == 0x0800 || (op & 0xF1C0) == 0x0100;
+    case 0x1:
+    case 0x2:
+    case 0x3: // MOVE/MOVEA to Dn/An
+        return opmode <= 1;
+    case 0x4: // TST, LEA, NOP
+        return ((op & 0xFF00) == 0x4A00 && size != 3) || (op & 0xF1C0) == 0x41C0 || op == 0x4E71;
+    case 0x5: // ADDQ/SUBQ to Dn/An, DBcc
+        return (size != 3 && mode <= 1) || (op & 0xF0F8) == 0x50C8;
+    case 0x6: // Bcc/BRA, not BSR
+        return (op & 0x0F00) != 0x0100;
+    case 0x7: // MOVEQ
+        return (op & 0x0100) == 0;
+    case 0x8:
+    case 0x9:
+    case 0xC:
+    case 0xD: // OR/SUB/AND/ADD <ea>,Dn
+        return opmode <= 2;
+    case 0xB: // CMP <ea>,Dn, CMPA
+        return opmode <= 3 || opmode == 7;
+    default:
+        return false;
+    }
+}
+
+// Classify the instruction at PC (fetched without side effects)
+static cpu_idle_t idle_check_next(cpu_t *restrict cpu) {
+    if (g_active_read == NULL)
+        return CPU_IDLE_NO;
+    uint32_t masked = cpu->pc & g_address_mask;
+    uintptr_t base = memory_soa_get(g_active_read, masked >> PAGE_SHIFT);
+    if (base == 0 || (masked & 1))
+        return CPU_IDLE_NO;
+    return idle_read_only_opcode(LOAD_BE16((uint8_t *)(base + masked))) ? CPU_IDLE_MAYBE : CPU_IDLE_NO;
+}
+
+// Snapshot the CPU as a candidate idle-loop head
+cpu_idle_t cpu_idle_mark(cpu_t *restrict cpu) {
+    memcpy(&g_idle.mark, cpu, sizeof(g_idle.mark));
+    g_idle.slowpath_count = g_mem_slowpath_count;
+    return idle_check_next(cpu);
+}
+
+// Classify the state after one more single step since cpu_idle_mark
+cpu_idle_t cpu_idle_step(cpu_t *restrict cpu) {
+    if (g_mem_slowpath_count != g_idle.slowpath_count)
+        return CPU_IDLE_NO;
+    if (memcmp(cpu, &g_idle.mark, sizeof(g_idle.mark)) == 0)
+        return CPU_IDLE_LOOP;
+    return idle_check_next(cpu);
+}
+
 // Get the vector base register (68010+)
 uint32_t cpu_get_vbr(cpu_t *restrict cpu) {
     return cpu->vbr;
@@ -211,6 +293,7 @@ extern cpu_t *cpu_init(int cpu_model, checkpoint_t *checkpoint) {
         return NULL;
 
     memset(cpu, 0, sizeof(cpu_t));
+    g_lazy_flags.op = LAZY_FLAGS_NONE; // never carry a record across machines
 
     // Load from checkpoint if provided
     if (checkpoint) {
@@ -144,6 +144,15 @@ void cpu_set_ipl(cpu_t *restrict cpu, uint32_t value);
 bool cpu_is_stopped(cpu_t *restrict cpu);
 void cpu_poll_interrupt(cpu_t *restrict cpu);
 
+// Idle-loop detection support for the scheduler's idle fast-forward (see
+// cpu.c).  cpu_idle_mark snapshots the CPU as a candidate loop head; after
+// each single step cpu_idle_step reports whether the CPU is back at the mark
+// having only run read-only instructions that never left the memory fast
+// path (CPU_IDLE_LOOP), may still get there (CPU_IDLE_MAYBE), or cannot.
+typedef enum { CPU_IDLE_NO, CPU_IDLE_MAYBE, CPU_IDLE_LOOP } cpu_idle_t;
+cpu_idle_t cpu_idle_mark(cpu_t *restrict cpu);
+cpu_idle_t cpu_idle_step(cpu_t *restrict cpu);
+
 // Get/set vector base register (68010+)
 uint32_t cpu_get_vbr(cpu_t *restrict cpu);
 
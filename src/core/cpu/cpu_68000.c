@@ -7,6 +7,7 @@
 // the shared cpu_ops.h and cpu_decode.h templates to generate cpu_run_68000().
 
 #include "cpu_internal.h"
+#include "cpu_dispatch.h"
 
 #include "log.h"
 #include "system.h"
@@ -28,11 +29,11 @@ LOG_USE_CATEGORY_NAME("cpu");
 #define FETCH32()                                    fetch_32(cpu, true)
 #define FETCH16_NO_INC()                             fetch_16(cpu, false)
 #define FETCH32_NO_INC()                             fetch_32(cpu, false)
-#define CC_C                                         cpu->carry
-#define CC_X                                         cpu->extend
-#define CC_N                                         cpu->negative
-#define CC_V                                         cpu->overflow
-#define CC_Z                                         cpu->zero
+#define CC_C                                         CPU_FLAGS(cpu)->carry
+#define CC_X                                         CPU_FLAGS(cpu)->extend
+#define CC_N                                         CPU_FLAGS(cpu)->negative
+#define CC_V                                         CPU_FLAGS(cpu)->overflow
+#define CC_Z                                         CPU_FLAGS(cpu)->zero
 #define GET_USP()                                    (cpu->usp)
 #define SET_USP(value_)                              (cpu->usp = (value_))
 #define IS_SUPERVISOR()                              (cpu->supervisor != 0)
@@ -59,6 +60,9 @@ LOG_USE_CATEGORY_NAME("cpu");
 
 #include "cpu_ops.h"
 
+// Dispatch table for this decoder (see cpu_dispatch.h)
+CPU_DISPATCH_STORAGE;
+
 // Generate the cpu_run_68000 decoder function
 #define CPU_DECODER_NAME        cpu_run_68000
 #define CPU_DECODER_ARGS        cpu_t *restrict cpu, uint32_t *instructions
@@ -80,6 +84,8 @@ LOG_USE_CATEGORY_NAME("cpu");
      * unrelated (supervisor / MMU-setup) code, where it was delivered with the wrong                                  \
      * context and vectored through the ROM, resetting the machine. */                                                 \
     g_bus_error_instr_ptr = instructions;                                                                              \
+    /* SoA entries may have been rewritten between sprints: refill the code window */                                  \
+    CPU_DISPATCH_ENTER();                                                                                              \
     while (*instructions > 0) {                                                                                        \
         /* The MC68000 has a 24-bit address bus (A0-A23); bits 24-31 of the PC are                                     \
          * not driven.  Control transfers through a pointer whose high byte is a                                       \
@@ -90,7 +96,11 @@ LOG_USE_CATEGORY_NAME("cpu");
          * mis-delivered as a line-F instead of demand-loading the segment).  No-op                                    \
          * for the Mac Plus, whose PC never exceeds 24 bits. */                                                        \
         cpu->pc &= 0x00FFFFFFu;                                                                                        \
-        uint32_t fetch = memory_read_uint32(cpu->pc);                                                                  \
+        /* Debugger PC watch: may end the sprint before this instruction */                                            \
+        if (__builtin_expect(g_debug_pc_hook, 0) && debug_pc_hook(cpu->pc))                                            \
+            break;                                                                                                     \
+        uint32_t fetch;                                                                                                \
+        CPU_DISPATCH_FETCH(fetch, cpu->pc);                                                                            \
         uint16_t opcode = fetch >> 16;                                                                                 \
         uint16_t ext_word = fetch & 0xFFFF;                                                                            \
         /* Record the address of the instruction being decoded.  The group-0                                           \
@@ -113,9 +123,12 @@ LOG_USE_CATEGORY_NAME("cpu");
             cpu->last_bus_error_pc = 0;                                                                                \
         cpu->pc += 2;                                                                                                  \
         if (*instructions > 0)                                                                                         \
-            (*instructions)--;
+            (*instructions)--;                                                                                         \
+        CPU_DISPATCH(fetch)
 #define CPU_DECODER_EPILOGUE                                                                                           \
     }                                                                                                                  \
+    /* Settle lazy condition codes: nothing outside the loop sees a record. */                                         \
+    CPU_FLAGS_SYNC(cpu);                                                                                               \
     /* Deferred DATA bus error.  A memory access during the instruction faulted    */                                  \
     /* (the memory layer set g_bus_error_pending and zeroed *instructions to break  */                                 \
     /* out of the sprint).  Unlike an instruction-FETCH fault — which decodes as a   */                              \
@@ -11,6 +11,7 @@
 #define CPU_DECODER_IS_68030 1
 
 #include "cpu_internal.h"
+#include "cpu_dispatch.h"
 #include "fpu.h"
 #include "mmu.h"
 
@@ -35,11 +36,11 @@ LOG_USE_CATEGORY_NAME("cpu");
 #define FETCH32()                                    fetch_32(cpu, true)
 #define FETCH16_NO_INC()                             fetch_16(cpu, false)
 #define FETCH32_NO_INC()                             fetch_32(cpu, false)
-#define CC_C                                         cpu->carry
-#define CC_X                                         cpu->extend
-#define CC_N                                         cpu->negative
-#define CC_V                                         cpu->overflow
-#define CC_Z                                         cpu->zero
+#define CC_C                                         CPU_FLAGS(cpu)->carry
+#define CC_X                                         CPU_FLAGS(cpu)->extend
+#define CC_N                                         CPU_FLAGS(cpu)->negative
+#define CC_V                                         CPU_FLAGS(cpu)->overflow
+#define CC_Z                                         CPU_FLAGS(cpu)->zero
 #define GET_USP()                                    (cpu->usp)
 #define SET_USP(value_)                              (cpu->usp = (value_))
 #define IS_SUPERVISOR()                              (cpu->supervisor != 0)
@@ -66,6 +67,9 @@ LOG_USE_CATEGORY_NAME("cpu");
 
 #include "cpu_ops.h"
 
+// Dispatch table for this decoder (see cpu_dispatch.h)
+CPU_DISPATCH_STORAGE;
+
 // ============================================================================
 // 68030 MMU instruction dispatcher (PMOVE/PFLUSH/PTEST/PLOAD)
 // ============================================================================
@@ -495,6 +499,8 @@ static __attribute__((noinline, cold)) void cpu_hardware_reset(cpu_t *restrict c
     /* Set SoA active pointers based on current supervisor mode */                                                     \
     g_active_read = cpu->supervisor ? g_supervisor_read : g_user_read;                                                 \
     g_active_write = cpu->supervisor ? g_supervisor_write : g_user_write;                                              \
+    /* SoA entries may have been rewritten between sprints: refill the code window */                                  \
+    CPU_DISPATCH_ENTER();                                                                                              \
     cpu_check_interrupt(cpu);                                                                                          \
     g_bus_error_instr_ptr = instructions; /* let memory slow paths force exit */                                       \
     /* Capture trace state before execution; clamp to 1 instruction if T1 set */                                       \
@@ -510,7 +516,11 @@ static __attribute__((noinline, cold)) void cpu_hardware_reset(cpu_t *restrict c
      * reconcile_sprint on any SE/30 sprint that ended its last instruction                                            \
      * on a slow I/O access. */                                                                                        \
     while (*instructions > 0) {                                                                                        \
-        uint32_t fetch = memory_read_uint32(cpu->pc);                                                                  \
+        /* Debugger PC watch: may end the sprint before this instruction */                                            \
+        if (__builtin_expect(g_debug_pc_hook, 0) && debug_pc_hook(cpu->pc))                                            \
+            break;                                                                                                     \
+        uint32_t fetch;                                                                                                \
+        CPU_DISPATCH_FETCH(fetch, cpu->pc);                                                                            \
         uint16_t opcode = fetch >> 16;                                                                                 \
         uint16_t ext_word = fetch & 0xFFFF;                                                                            \
         cpu->instruction_pc = cpu->pc;                                                                                 \
@@ -528,9 +538,12 @@ static __attribute__((noinline, cold)) void cpu_hardware_reset(cpu_t *restrict c
             cpu->last_bus_error_pc = 0;                                                                                \
         cpu->pc += 2;                                                                                                  \
         if (*instructions > 0)                                                                                         \
-            (*instructions)--;
+            (*instructions)--;                                                                                         \
+        CPU_DISPATCH(fetch)
 #define CPU_DECODER_EPILOGUE                                                                                           \
     }                                                                                                                  \
+    /* Settle lazy condition codes: nothing outside the loop sees a record. */                                         \
+    CPU_FLAGS_SYNC(cpu);                                                                                               \
     /* Exception priority order (MC68030 UM §8.1): bus error > address error > reset > */                             \
     /* trace > interrupt. Handle deferred bus error first so it preempts a trace */                                    \
     /* that the same instruction would otherwise have raised. */                                                       \
@@ -14,6 +14,12 @@
 // - CPU_DECODER_ARGS:     Formal parameter list for the decoder (e.g., uint16_t opcode)
 // - CPU_DECODER_PROLOGUE: Code emitted at function start (e.g., prefetch, locals)
 // - CPU_DECODER_EPILOGUE: Code emitted before returning (e.g., commit/writeback)
+//
+// The execution decoders cache which OP site an instruction reaches
+// (cpu_dispatch.h), so the decode conditions below must depend only on
+// `opcode` and `ext_word` — never on CPU or machine state.  A case that looks
+// at `ext_word` must invoke CPU_DECODER_EXT_WORD_DEPENDENT first so the
+// opcode-indexed table leaves that opcode on the switch.
 
 // clang-format off
 
@@ -37,6 +43,9 @@
 #error "Decoder prologue macro not defined"
 #endif
 
+#if !defined(CPU_DECODER_EXT_WORD_DEPENDENT)
+#define CPU_DECODER_EXT_WORD_DEPENDENT ((void)0)
+#endif
 #if !defined(CPU_DECODER_EPILOGUE)
 #define CPU_DECODER_EPILOGUE assert(0)
 #error "Decoder epilogue macro not defined"
@@ -89,9 +98,9 @@ CPU_DECODER_RETURN_TYPE CPU_DECODER_NAME(CPU_DECODER_ARGS) {
         case 0x32: OP_CMPI_L_DATA_EA; break;
         case 0x33: if (((opcode) & 0x3F) == 0x003C) { OP_CAS2_W_DC_DU_RN; } else { OP_CAS_W_DC_DU_EA; } break;
 
-        case 0x38: if (ext_word & 0x0800) { OP_MOVES_B_RN_EA; } else { OP_MOVES_B_EA_RN; } break;
-        case 0x39: if (ext_word & 0x0800) { OP_MOVES_W_RN_EA; } else { OP_MOVES_W_EA_RN; } break;
-        case 0x3A: if (ext_word & 0x0800) { OP_MOVES_L_RN_EA; } else { OP_MOVES_L_EA_RN; } break;
+        case 0x38: CPU_DECODER_EXT_WORD_DEPENDENT; if (ext_word & 0x0800) { OP_MOVES_B_RN_EA; } else { OP_MOVES_B_EA_RN; } break;
+        case 0x39: CPU_DECODER_EXT_WORD_DEPENDENT; if (ext_word & 0x0800) { OP_MOVES_W_RN_EA; } else { OP_MOVES_W_EA_RN; } break;
+        case 0x3A: CPU_DECODER_EXT_WORD_DEPENDENT; if (ext_word & 0x0800) { OP_MOVES_L_RN_EA; } else { OP_MOVES_L_EA_RN; } break;
         case 0x3B: if (((opcode) & 0x3F) == 0x003C) { OP_CAS2_L_DC_DU_RN; } else { OP_CAS_L_DC_DU_EA; } break;
 
         default:
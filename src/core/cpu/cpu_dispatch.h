@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// cpu_dispatch.h
+// Dispatch back ends for the cpu_decode.h interpreters.
+//
+// Every decode of an instruction ends at exactly one OP_* site in
+// cpu_decode.h, and which site it reaches is a pure function of the opcode
+// word and the first extension word (MOVES is the only form that looks past
+// the opcode).  On GNU-compatible compilers cpu_ops.h labels every OP site;
+// when the decoder arms `dispatch_site` before falling into the switch, the
+// site reached records its own label address there.  The table back end
+// builds on that; the plain switch remains available for benchmarking and
+// cross-checks:
+//
+//   table     (default)             One 65536-entry table of OP-site labels
+//                                   per decoder (i.e. per CPU model), filled
+//                                   by running the decode tree once for each
+//                                   opcode value the first time it executes.
+//                                   The hot loop then does a single computed
+//                                   goto.  Opcodes whose decode depends on the
+//                                   extension word stay NULL and always walk
+//                                   the switch.
+//
+//   switch    (-DGS_DECODER_SWITCH) The nested switch alone.  Also used for
+//                                   Emscripten and non-GNU compilers, which
+//                                   lack labels-as-values.
+//
+// On top of the table sits the decoded-page cache (memory.h), unless built
+// with -DGS_NO_BLOCK_CACHE.  For each RAM/ROM page the decoder runs from, a
+// block records per halfword the OP site and the opcode/extension longword
+// decoded there.  A warm slot skips the fetch and the table lookup; a cold one
+// takes them and fills the slot from the table entry, or from the OP site the
+// switch reaches on a table miss.  Since a slot is tied to the exact words at
+// its address, MOVES gets cached too.  The memory layer drops a page's block
+// before anything changes the page, and a page that keeps being rewritten is
+// left to the table.
+//
+// Decoders include this header before cpu_ops.h, call CPU_DISPATCH_ENTER at
+// sprint entry, CPU_DISPATCH_FETCH for the opcode fetch and CPU_DISPATCH right
+// before the switch.
+
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include "memory.h"
+
+#include <stdint.h>
+
+#if !defined(__GNUC__) || defined(__EMSCRIPTEN__) || defined(GS_DECODER_SWITCH)
+// plain switch decoder
+#else
+#define CPU_DISPATCH_TABLE 1
+#define CPU_OP_SITES       1 // cpu_ops.h labels each OP site
+#endif
+
+#if defined(CPU_DISPATCH_TABLE) && !defined(GS_NO_BLOCK_CACHE)
+#define CPU_DISPATCH_BLOCKS 1
+#endif
+
+#if defined(CPU_DISPATCH_BLOCKS)
+
+// Per-decoder opcode table (labels are local to the decoder function)
+#define CPU_DISPATCH_STORAGE static const void *dispatch_table[0x10000]
+
+// Refill the code window and take over the blocks if another decoder had them
+#define CPU_DISPATCH_ENTER() (memory_code_window_flush(), memory_code_blocks_claim(dispatch_table))
+
+// Block covering an opcode fetch at pc, or NULL when the fetch must go to
+// memory (slow-path page, uncached page, or a longword straddling the page end)
+static inline code_block_t *cpu_dispatch_block(uint32_t pc) {
+    uint32_t masked = pc & g_address_mask;
+    if ((masked & PAGE_MASK) > MEM_PAGE_SIZE - 4 || memory_code_base(masked) == 0)
+        return NULL;
+    return g_code_block;
+}
+
+// Serve the fetch from a warm block slot, or read it and note the slot to fill
+#define CPU_DISPATCH_FETCH(fetch_, pc_)                                                                                \
+    code_block_t *dispatch_block = cpu_dispatch_block(pc_);                                                            \
+    uint32_t dispatch_slot = ((pc_)&PAGE_MASK) >> 1;                                                                   \
+    const void *dispatch_hit = dispatch_block ? dispatch_block->site[dispatch_slot] : NULL;                            \
+    (fetch_) = dispatch_hit ? dispatch_block->fetch[dispatch_slot] : memory_fetch_uint32(pc_)
+
+// Jump to the block slot's site, else through the opcode table (filling the
+// slot); an empty table entry walks the switch once with dispatch_site armed,
+// and the OP site reached fills the table entry and the slot.
+#define CPU_DISPATCH(fetch_)                                                                                           \
+    const void **dispatch_site = NULL;                                                                                 \
+    if (__builtin_expect(dispatch_hit != NULL, 1))                                                                     \
+        goto *dispatch_hit;                                                                                            \
+    if (dispatch_block)                                                                                                \
+        dispatch_block->fetch[dispatch_slot] = (fetch_);                                                               \
+    if (__builtin_expect(dispatch_table[(fetch_) >> 16] != NULL, 1)) {                                                 \
+        if (dispatch_block)                                                                                            \
+            dispatch_block->site[dispatch_slot] = dispatch_table[(fetch_) >> 16];                                      \
+        goto *dispatch_table[(fetch_) >> 16];                                                                          \
+    }                                                                                                                  \
+    dispatch_site = &dispatch_table[(fetch_) >> 16];
+
+// Reached on the switch walk only: record the OP site for later dispatch
+#define CPU_DISPATCH_RECORD(site_)                                                                                     \
+    if (__builtin_expect(dispatch_site != NULL, 0)) {                                                                  \
+        *dispatch_site = (site_);                                                                                      \
+        dispatch_site = NULL;                                                                                          \
+    }                                                                                                                  \
+    if (__builtin_expect(dispatch_block != NULL, 0)) {                                                                 \
+        dispatch_block->site[dispatch_slot] = (site_);                                                                 \
+        dispatch_block = NULL;                                                                                         \
+    }
+
+// Decode depends on ext_word: never record a table entry for this opcode (the
+// block slot still records it, being tied to this very extension word)
+#define CPU_DECODER_EXT_WORD_DEPENDENT (dispatch_site = NULL)
+
+#elif defined(CPU_DISPATCH_TABLE)
+
+// Per-decoder opcode table (labels are local to the decoder function)
+#define CPU_DISPATCH_STORAGE static const void *dispatch_table[0x10000]
+
+#define CPU_DISPATCH_ENTER()            memory_code_window_flush()
+#define CPU_DISPATCH_FETCH(fetch_, pc_) (fetch_) = memory_fetch_uint32(pc_)
+
+// Jump through the opcode table; an empty entry walks the switch once with
+// dispatch_site armed so the OP site reached fills it in.
+#define CPU_DISPATCH(fetch_)                                                                                           \
+    const void **dispatch_site = NULL;                                                                                 \
+    if (__builtin_expect(dispatch_table[(fetch_) >> 16] != NULL, 1))                                                   \
+        goto *dispatch_table[(fetch_) >> 16];                                                                          \
+    dispatch_site = &dispatch_table[(fetch_) >> 16];
+
+// Reached on the switch walk only: record the OP site for later dispatch
+#define CPU_DISPATCH_RECORD(site_)                                                                                     \
+    if (__builtin_expect(dispatch_site != NULL, 0)) {                                                                  \
+        *dispatch_site = (site_);                                                                                      \
+        dispatch_site = NULL;                                                                                          \
+    }
+
+// Decode depends on ext_word: never record a table entry for this opcode
+#define CPU_DECODER_EXT_WORD_DEPENDENT (dispatch_site = NULL)
+
+#else // plain switch
+
+#define CPU_DISPATCH_STORAGE            extern int cpu_dispatch_unused_
+#define CPU_DISPATCH_ENTER()            memory_code_window_flush()
+#define CPU_DISPATCH_FETCH(fetch_, pc_) (fetch_) = memory_fetch_uint32(pc_)
+#define CPU_DISPATCH(fetch_)
+#define CPU_DECODER_EXT_WORD_DEPENDENT ((void)0)
+
+#endif
+
+#endif // CPU_DISPATCH_H
@@ -109,10 +109,119 @@ struct cpu {
     struct object *mmu_object;
 };
 
+// ============================================================================
+// Lazy Condition Codes (GS_LAZY_FLAGS)
+// ============================================================================
+//
+// With GS_LAZY_FLAGS the hottest flag producers in cpu_ops.h (ADD, SUB, CMP
+// and the MOVE/TST/logical "NZ, clear VC" family) only record what they did:
+// the operation kind, operand size, and operands/result.  The five flag
+// fields in struct cpu are brought up to date on demand — by any CC_* access
+// in cpu_ops.h (Bcc/Scc/DBcc go through conditional_test, MOVE from SR/CCR
+// through read_ccr), by exception entry (cpu_get_sr), and unconditionally at
+// the end of every sprint, so code outside the decoder loop (debugger,
+// checkpointing, the object tree) always sees materialised flags and the
+// checkpointed struct is byte-identical to an eager build.
+//
+// The pending record is process-global rather than a struct cpu field so
+// the checkpoint layout does not change; it never outlives a sprint.
+
+// Pending flag-producing operation (op == 0: flags in struct cpu are current)
+typedef struct lazy_flags {
+    uint32_t op; // LAZY_FLAGS_* kind | operand size in bytes << 4
+    uint32_t dst; // destination operand (ADD/SUB/CMP)
+    uint32_t src; // source operand (ADD/SUB/CMP)
+    uint32_t res; // result
+} lazy_flags_t;
+
+#define LAZY_FLAGS_NONE  0 // nothing pending
+#define LAZY_FLAGS_ADD   1 // NZVC of dst + src
+#define LAZY_FLAGS_SUB   2 // NZVC of dst - src
+#define LAZY_FLAGS_LOGIC 3 // NZ of res, V = C = 0
+#define LAZY_FLAGS_X     8 // kind also sets X = C (ADD/SUB, not CMP)
+
+#define LAZY_FLAGS_OP(kind, size) ((kind) | ((uint32_t)(size) << 4))
+
+extern lazy_flags_t g_lazy_flags;
+
+#ifdef GS_LAZY_FLAGS
+
+// Carry of the pending ADD/SUB record, truncated to its operand size
+static inline uint32_t lazy_flags_carry(uint32_t op, uint32_t dst, uint32_t res) {
+    if ((op & 7) == LAZY_FLAGS_ADD)
+        return res < dst;
+    return res > dst;
+}
+
+// Compute the five flag fields exactly as the eager cpu_ops.h macros would
+static inline void lazy_flags_materialise(cpu_t *restrict cpu) {
+    uint32_t op = g_lazy_flags.op;
+    uint32_t shift = ((op >> 4) * 8) - 1;
+    uint32_t mask = (uint32_t)((2ull << shift) - 1);
+    uint32_t dst = g_lazy_flags.dst & mask;
+    uint32_t src = g_lazy_flags.src & mask;
+    uint32_t res = g_lazy_flags.res & mask;
+
+    cpu->negative = res & 1u << shift;
+    cpu->zero = !res;
+    switch (op & 7) {
+    case LAZY_FLAGS_ADD:
+        cpu->carry = res < dst;
+        cpu->overflow = (~(dst ^ src) & (dst ^ res) & mask) >> shift;
+        break;
+    case LAZY_FLAGS_SUB:
+        cpu->carry = res > dst;
+        cpu->overflow = ((dst ^ src) & (dst ^ res)) >> shift;
+        break;
+    default: // LAZY_FLAGS_LOGIC
+        cpu->carry = cpu->overflow = 0;
+        break;
+    }
+    if (op & LAZY_FLAGS_X)
+        cpu->extend = cpu->carry;
+    g_lazy_flags.op = LAZY_FLAGS_NONE;
+}
+
+// Bring the flag fields up to date before reading or partially writing them
+static inline __attribute__((always_inline)) cpu_t *cpu_flags(cpu_t *restrict cpu) {
+    if (__builtin_expect(g_lazy_flags.op != LAZY_FLAGS_NONE, 0))
+        lazy_flags_materialise(cpu);
+    return cpu;
+}
+
+// Record a flag-producing operation.  A kind that leaves X alone must first
+// settle an X still owed by a pending ADD/SUB.
+static inline __attribute__((always_inline)) void lazy_flags_record(cpu_t *restrict cpu, uint32_t op, uint32_t dst,
+                                                                    uint32_t src, uint32_t res) {
+    uint32_t prev = g_lazy_flags.op;
+    if (!(op & LAZY_FLAGS_X) && __builtin_expect(prev & LAZY_FLAGS_X, 0)) {
+        uint32_t mask = (uint32_t)((2ull << (((prev >> 4) * 8) - 1)) - 1);
+        cpu->extend = lazy_flags_carry(prev, g_lazy_flags.dst & mask, g_lazy_flags.res & mask);
+    }
+    g_lazy_flags.op = op;
+    g_lazy_flags.dst = dst;
+    g_lazy_flags.src = src;
+    g_lazy_flags.res = res;
+}
+
+#define CPU_FLAGS(cpu_)         cpu_flags(cpu_)
+#define CPU_FLAGS_SYNC(cpu_)    ((void)cpu_flags(cpu_))
+#define CPU_FLAGS_DISCARD(cpu_) (g_lazy_flags.op = LAZY_FLAGS_NONE)
+
+#else // eager flags
+
+#define CPU_FLAGS(cpu_)         (cpu_)
+#define CPU_FLAGS_SYNC(cpu_)    ((void)0)
+#define CPU_FLAGS_DISCARD(cpu_) ((void)0)
+
+#endif // GS_LAZY_FLAGS
+
 // Read the condition code register from CPU flags
 static inline uint8_t read_ccr(cpu_t *restrict cpu) {
     uint8_t ccr = 0;
 
+    CPU_FLAGS_SYNC(cpu);
+
     if (cpu->extend)
         ccr |= 1 << 4;
     if (cpu->negative)
@@ -129,6 +238,7 @@ static inline uint8_t read_ccr(cpu_t *restrict cpu) {
 
 // Update condition code register flags from 16-bit value
 static inline void write_ccr(cpu_t *restrict cpu, uint16_t ccr) {
+    CPU_FLAGS_DISCARD(cpu); // all five flags are overwritten below
     cpu->extend = ccr >> 4 & 1;
     cpu->negative = ccr >> 3 & 1;
     cpu->zero = ccr >> 2 & 1;
@@ -138,7 +248,7 @@ static inline void write_ccr(cpu_t *restrict cpu, uint16_t ccr) {
 
 // Fetch a 16-bit word from PC, optionally advancing PC
 static inline uint16_t fetch_16(cpu_t *restrict cpu, bool increment) {
-    uint16_t w = memory_read_uint16(cpu->pc);
+    uint16_t w = memory_fetch_uint16(cpu->pc);
     if (increment)
         cpu->pc += 2;
     return w;
@@ -146,7 +256,7 @@ static inline uint16_t fetch_16(cpu_t *restrict cpu, bool increment) {
 
 // Fetch a 32-bit long word from PC, optionally advancing PC
 static inline uint32_t fetch_32(cpu_t *restrict cpu, bool increment) {
-    uint32_t l = memory_read_uint32(cpu->pc);
+    uint32_t l = memory_fetch_uint32(cpu->pc);
     if (increment)
         cpu->pc += 4;
     return l;
@@ -573,6 +683,7 @@ static inline void movem_from_register(cpu_t *restrict cpu, uint16_t opcode, int
 
 // ABCD: add decimal with extend (based on research at https://gendev.spritesmind.net/forum/viewtopic.php?t=1964)
 static inline uint8_t abcd(cpu_t *restrict cpu, uint8_t xx, uint8_t yy) {
+    CPU_FLAGS_SYNC(cpu);
     uint8_t ss = xx + yy + !!cpu->extend;
     uint8_t dc = (ss + 0x66 ^ ss) >> 1;
     uint8_t bc = (xx & yy) | ((xx | yy) & ~ss);
@@ -588,6 +699,7 @@ static inline uint8_t abcd(cpu_t *restrict cpu, uint8_t xx, uint8_t yy) {
 
 // SBCD: subtract decimal with extend (based on research at https://gendev.spritesmind.net/forum/viewtopic.php?t=1964)
 static inline uint8_t sbcd(cpu_t *restrict cpu, uint8_t xx, uint8_t yy) {
+    CPU_FLAGS_SYNC(cpu);
     uint8_t dd = xx - yy - !!cpu->extend;
     uint8_t bc = ((~xx & yy) | ((~xx | yy) & dd)) & 0x88;
     uint8_t rr = dd - bc + (bc >> 2);
@@ -602,6 +714,7 @@ static inline uint8_t sbcd(cpu_t *restrict cpu, uint8_t xx, uint8_t yy) {
 // Test CPU condition codes (M68000PRM table 3-19)
 static inline __attribute__((always_inline)) bool conditional_test(cpu_t *restrict cpu, uint8_t test) {
     assert(test < 16);
+    CPU_FLAGS_SYNC(cpu);
 
     switch (test) {
     case 0x0:
@@ -1148,7 +1261,7 @@ static inline void f_trap(cpu_t *restrict cpu) {
         return;
     }
     uint32_t fetch_page = cpu->instruction_pc >> PAGE_SHIFT;
-    if (__builtin_expect(g_active_read && (int)fetch_page < g_page_count && g_active_read[fetch_page] == 0, 0)) {
+    if (__builtin_expect(g_active_read && (int)fetch_page < g_page_count && memory_soa_get(g_active_read, fetch_page) == 0, 0)) {
         // Instruction page has no SoA entry — fetch returned $FF from unmapped
         // physical memory.  Treat as bus error (matching real hardware behavior).
         cpu->pc = cpu->instruction_pc;
@@ -182,7 +182,16 @@
 #define UPDATE_N(res)           CC_N = res & 1u << (BITS(res) - 1)
 #define UPDATE_Z(res)           CC_Z = !(res)
 #define UPDATE_NZ_CLEAR_V(res)  UPDATE_N(res), UPDATE_Z(res), CC_V = 0
+#ifdef GS_LAZY_FLAGS
+// Lazy producers record (kind, size, operands) instead of storing flags; see
+// "Lazy Condition Codes" in cpu_internal.h.  Size comes from the result type,
+// exactly as BITS(res) does for the eager macros.
+#define LAZY_FLAGS(kind, dst, src, res)                                                                                \
+    lazy_flags_record(cpu, LAZY_FLAGS_OP(kind, sizeof(res)), (uint32_t)(dst), (uint32_t)(src), (uint32_t)(res))
+#define UPDATE_NZ_CLEAR_CV(res) LAZY_FLAGS(LAZY_FLAGS_LOGIC, 0, 0, res)
+#else
 #define UPDATE_NZ_CLEAR_CV(res) UPDATE_N(res), UPDATE_Z(res), CC_C = CC_V = 0
+#endif
 
 // Helper macros to update condition codes for specific operations
 #define UPDATE_V_SUB(dst, src, res)        CC_V = ((((dst) ^ (src)) & ((dst) ^ (res))) >> (BITS(res) - 1))
@@ -196,6 +205,16 @@
 #define UPDATE_C_SHIFT_R(data, count, res) CC_C = count && (count > BITS(data) ? res : data & 1u << (count - 1))
 
 // Generic SUB
+#ifdef GS_LAZY_FLAGS
+#define GENERIC_SUB(dst, src, res)                                                                                     \
+    res = dst - src;                                                                                                   \
+    LAZY_FLAGS(LAZY_FLAGS_SUB, dst, src, res);
+
+#define SUB(bits, dst, src, res)                                                                                       \
+    UINT(bits) res;                                                                                                    \
+    res = dst - src;                                                                                                   \
+    LAZY_FLAGS(LAZY_FLAGS_SUB | LAZY_FLAGS_X, dst, src, res);
+#else
 #define GENERIC_SUB(dst, src, res)                                                                                     \
     res = dst - src;                                                                                                   \
     UPDATE_C_SUB(dst, src, res);                                                                                       \
@@ -207,6 +226,7 @@
     UINT(bits) res;                                                                                                    \
     GENERIC_SUB(dst, src, res);                                                                                        \
     CC_X = CC_C;
+#endif
 
 #define SUB_EA_DN(bits, mode)                                                                                          \
     VALID_EA(mode);                                                                                                    \
@@ -368,10 +388,17 @@
     UPDATE_N(res);                                                                                                     \
     UPDATE_Z(res);
 
+#ifdef GS_LAZY_FLAGS
+#define ADD(bits, dst, src, res)                                                                                       \
+    UINT(bits) res;                                                                                                    \
+    res = dst + src;                                                                                                   \
+    LAZY_FLAGS(LAZY_FLAGS_ADD | LAZY_FLAGS_X, dst, src, res);
+#else
 #define ADD(bits, dst, src, res)                                                                                       \
     UINT(bits) res;                                                                                                    \
     GENERIC_ADD(dst, src, res);                                                                                        \
     CC_X = CC_C;
+#endif
 
 // ADD.[BWL] <ea>,Dn
 #define ADD_EA_DN(bits, mode)                                                                                          \
@@ -694,8 +721,22 @@
     x = READ32(SP);                                                                                                    \
     SP += 4;
 
+#ifdef CPU_OP_SITES
+// Every OP site carries a unique label (see cpu_dispatch.h).  When the
+// decoder walked the switch on a miss, the site reached records its own
+// address so later executions can jump straight here.
+#define OP(...)         OP_SITE(__COUNTER__, __VA_ARGS__)
+#define OP_SITE(n, ...) OP_SITE_(n, __VA_ARGS__)
+#define OP_SITE_(n, ...)                                                                                               \
+    {                                                                                                                  \
+        CPU_DISPATCH_RECORD(&&op_site_##n);                                                                            \
+    op_site_##n:;                                                                                                      \
+        __VA_ARGS__;                                                                                                   \
+    }
+#else
 #define OP(x)                                                                                                          \
     { x; }
+#endif
 
 #define SUPER(x)                                                                                                       \
     if (IS_SUPERVISOR()) {                                                                                             \
@@ -1236,13 +1277,13 @@ static inline uint32_t bf_insert_reg(uint32_t dst, int32_t offset, uint32_t w, u
 #define OP_CHK_W_EA_DN                                                                                                 \
     OP(                                                                                                                \
         VALID_EA(ea_data); LOAD_EA_WITH_UPDATE(16, _src); int32_t _dn = (int32_t)(int16_t)(uint16_t)DX;                \
-        int32_t _b = (int32_t)(int16_t)_src; cpu->negative = (_dn < 0);                                                \
+        int32_t _b = (int32_t)(int16_t)_src; CC_N = (_dn < 0);                                                         \
         if (_dn < 0) { EXC_CHK(); } else if (_dn > _b) { EXC_CHK(); })
 
 #define OP_CHK_L_EA_DN                                                                                                 \
     OP(                                                                                                                \
         VALID_EA(ea_data); LOAD_EA_WITH_UPDATE(32, _bound); int32_t _dn = (int32_t)DX; int32_t _b = (int32_t)_bound;   \
-        cpu->negative = (_dn < 0); if (_dn < 0) { EXC_CHK(); } else if (_dn > _b) { EXC_CHK(); })
+        CC_N = (_dn < 0); if (_dn < 0) { EXC_CHK(); } else if (_dn > _b) { EXC_CHK(); })
 
 // --- CHK2/CMP2: Compare with bounds ---
 // Extension word: Dn/An:Rn at bits 15:12, IS bit 11 (0=CMP2, 1=CHK2)
@@ -1692,7 +1733,7 @@ static inline uint32_t bf_insert_reg(uint32_t dst, int32_t offset, uint32_t w, u
             uint32_t _da = (_ext >> 15) & 1u;                                                                          \
             uint32_t _rn = (_ext >> 12) & 7u;                                                                          \
             MOVES_EA_WITH_RETRY_SAFE(1, _ea);                                                                          \
-            uintptr_t *_saved = g_active_write;                                                                        \
+            soa_table_t _saved = g_active_write;                                                                       \
             g_active_write = MOVES_ALT_WRITE(cpu->dfc);                                                                \
             WRITE8(_ea, (uint8_t)MOVES_RN_SRC(1, _da, _rn, _ea));                                                      \
             g_active_write = _saved;                                                                                   \
@@ -1710,7 +1751,7 @@ static inline uint32_t bf_insert_reg(uint32_t dst, int32_t offset, uint32_t w, u
             uint32_t _da = (_ext >> 15) & 1u;                                                                          \
             uint32_t _rn = (_ext >> 12) & 7u;                                                                          \
             MOVES_EA_WITH_RETRY_SAFE(2, _ea);                                                                          \
-            uintptr_t *_saved = g_active_write;                                                                        \
+            soa_table_t _saved = g_active_write;                                                                       \
             g_active_write = MOVES_ALT_WRITE(cpu->dfc);                                                                \
             WRITE16(_ea, (uint16_t)MOVES_RN_SRC(2, _da, _rn, _ea));                                                    \
             g_active_write = _saved;                                                                                   \
@@ -1728,7 +1769,7 @@ static inline uint32_t bf_insert_reg(uint32_t dst, int32_t offset, uint32_t w, u
             uint32_t _da = (_ext >> 15) & 1u;                                                                          \
             uint32_t _rn = (_ext >> 12) & 7u;                                                                          \
             MOVES_EA_WITH_RETRY_SAFE(4, _ea);                                                                          \
-            uintptr_t *_saved = g_active_write;                                                                        \
+            soa_table_t _saved = g_active_write;                                                                       \
             g_active_write = MOVES_ALT_WRITE(cpu->dfc);                                                                \
             WRITE32(_ea, MOVES_RN_SRC(4, _da, _rn, _ea));                                                              \
             g_active_write = _saved;                                                                                   \
@@ -1746,7 +1787,7 @@ static inline uint32_t bf_insert_reg(uint32_t dst, int32_t offset, uint32_t w, u
             uint32_t _da = (_ext >> 15) & 1u;                                                                          \
             uint32_t _rn = (_ext >> 12) & 7u;                                                                          \
             MOVES_EA_WITH_RETRY_SAFE(1, _ea);                                                                          \
-            uintptr_t *_saved = g_active_read;                                                                         \
+            soa_table_t _saved = g_active_read;                                                                        \
             g_active_read = MOVES_ALT_READ(cpu->sfc);                                                                  \
             uint8_t _v = READ8(_ea);                                                                                   \
             g_active_read = _saved;                                                                                    \
@@ -1768,7 +1809,7 @@ static inline uint32_t bf_insert_reg(uint32_t dst, int32_t offset, uint32_t w, u
             uint32_t _da = (_ext >> 15) & 1u;                                                                          \
             uint32_t _rn = (_ext >> 12) & 7u;                                                                          \
             MOVES_EA_WITH_RETRY_SAFE(2, _ea);                                                                          \
-            uintptr_t *_saved = g_active_read;                                                                         \
+            soa_table_t _saved = g_active_read;                                                                        \
             g_active_read = MOVES_ALT_READ(cpu->sfc);                                                                  \
             uint16_t _v = READ16(_ea);                                                                                 \
             g_active_read = _saved;                                                                                    \
@@ -1790,7 +1831,7 @@ static inline uint32_t bf_insert_reg(uint32_t dst, int32_t offset, uint32_t w, u
             uint32_t _da = (_ext >> 15) & 1u;                                                                          \
             uint32_t _rn = (_ext >> 12) & 7u;                                                                          \
             MOVES_EA_WITH_RETRY_SAFE(4, _ea);                                                                          \
-            uintptr_t *_saved = g_active_read;                                                                         \
+            soa_table_t _saved = g_active_read;                                                                        \
             g_active_read = MOVES_ALT_READ(cpu->sfc);                                                                  \
             uint32_t _v = READ32(_ea);                                                                                 \
             g_active_read = _saved;                                                                                    \
@@ -127,6 +127,8 @@ struct logpoint {
 // Static Helpers
 // ============================================================================
 
+static void pc_watch_update(debug_t *debug);
+
 static uint16_t cpu_get_uint16(uint32_t addr) {
     if (!system_memory())
         return 0;
@@ -158,6 +160,7 @@ breakpoint_t *set_breakpoint(debug_t *debug, uint32_t addr, addr_space_t space)
     debug->breakpoints = bp;
 
     debug->active = true;
+    pc_watch_update(debug);
 
     return bp;
 }
@@ -279,6 +282,7 @@ logpoint_t *set_logpoint(debug_t *debug, uint32_t addr, uint32_t end_addr, log_c
     debug->logpoints = lp;
 
     debug->active = true;
+    pc_watch_update(debug);
 
     return lp;
 }
@@ -490,7 +494,7 @@ void debug_exc_trace_dump(int filter) {
 // pages only — unrelated accesses take the fast path and never reach here.
 static void debug_memory_logpoint_hook(uint32_t addr, unsigned size, uint32_t value, bool is_write) {
     debug_t *debug = system_debug();
-    if (!debug)
+    if (!debug || debug->replaying)
         return;
     uint32_t phys_addr = addr;
     bool phys_computed = false;
@@ -616,8 +620,139 @@ void debugger_disasm_pc(char *buf, size_t buf_size) {
     debugger_disasm(buf, buf_size, cpu_get_pc(cpu));
 }
 
-// Check if execution should break and trace current instruction
+// ============================================================================
+// Decoder PC Watch
+// ============================================================================
+
+// One bit per 4 KB page of a 32-bit address space
+#define PC_WATCH_BYTES (1u << (32 - PAGE_SHIFT - 3))
+
+bool g_debug_pc_hook = false;
+
+static debug_t *s_watch_debug; // debugger the page maps were built from
+static uint8_t s_pc_pages[PC_WATCH_BYTES]; // logical pages with a breakpoint or PC logpoint
+static uint8_t s_phys_pc_pages[PC_WATCH_BYTES]; // physical pages (P: breakpoints, logpoint aliases)
+static bool s_phys_watch; // s_phys_pc_pages has any page marked
+static bool s_pc_stop; // the hook ended a sprint at a marked page
+static bool s_pc_armed; // the next hook call at s_pc_armed_pc runs unchecked
+static uint32_t s_pc_armed_pc;
+
+// Physical-watch result for the last logical page translated (MMU walks are
+// too slow for every instruction; the PC changes page far less often)
+static uint32_t s_xlate_page = UINT32_MAX;
+static soa_table_t s_xlate_table; // g_active_read at translation time
+static uint32_t s_xlate_gen; // g_mmu_generation at translation time
+static bool s_xlate_marked;
+
+// Test a page bit
+static inline bool page_marked(const uint8_t *map, uint32_t page) {
+    return (map[page >> 3] >> (page & 7)) & 1;
+}
+
+// Set the bits for pages first..last
+static void mark_pages(uint8_t *map, uint32_t first, uint32_t last) {
+    for (uint32_t page = first;; page++) {
+        map[page >> 3] |= (uint8_t)(1u << (page & 7));
+        if (page == last)
+            break;
+    }
+}
+
+// Rebuild the page maps and the decoder hook flag after a breakpoint or logpoint change
+static void pc_watch_update(debug_t *debug) {
+    memset(s_pc_pages, 0, sizeof(s_pc_pages));
+    memset(s_phys_pc_pages, 0, sizeof(s_phys_pc_pages));
+    s_phys_watch = false;
+    s_xlate_page = UINT32_MAX;
+
+    for (breakpoint_t *bp = debug->breakpoints; bp != NULL; bp = bp->next) {
+        if (bp->space == ADDR_LOGICAL) {
+            mark_pages(s_pc_pages, bp->addr >> PAGE_SHIFT, bp->addr >> PAGE_SHIFT);
+        } else {
+            mark_pages(s_phys_pc_pages, bp->addr >> PAGE_SHIFT, bp->addr >> PAGE_SHIFT);
+            s_phys_watch = true;
+        }
+    }
+    for (logpoint_t *lp = debug->logpoints; lp != NULL; lp = lp->next) {
+        if (lp->kind != LP_KIND_PC)
+            continue;
+        mark_pages(s_pc_pages, lp->addr >> PAGE_SHIFT, lp->end_addr >> PAGE_SHIFT);
+        if (lp->start_phys_page <= lp->end_phys_page) {
+            mark_pages(s_phys_pc_pages, lp->start_phys_page, lp->end_phys_page);
+            s_phys_watch = true;
+        }
+    }
+
+    s_watch_debug = debug;
+    g_debug_pc_hook = debug_active(debug);
+}
+
+// Whether pc lies on a marked logical page, or on a logical page that
+// currently maps to a marked physical page
+static bool pc_watch_marked(uint32_t pc) {
+    uint32_t page = pc >> PAGE_SHIFT;
+    if (page_marked(s_pc_pages, page))
+        return true;
+    if (!s_phys_watch)
+        return false;
+    if (page != s_xlate_page || g_active_read != s_xlate_table || g_mmu_generation != s_xlate_gen) {
+        bool is_identity, valid;
+        uint32_t phys_pc = debug_translate_address(pc, &is_identity, NULL, &valid);
+        s_xlate_page = page;
+        s_xlate_table = g_active_read;
+        s_xlate_gen = g_mmu_generation;
+        s_xlate_marked = valid && page_marked(s_phys_pc_pages, phys_pc >> PAGE_SHIFT);
+    }
+    return s_xlate_marked;
+}
+
+// Append a PC to both trace buffers
+static void trace_record_pc(debug_t *debug, uint32_t pc) {
+    if (debug->trace_buffer) {
+        // Standard ring buffer: advance tail past the slot we're about to
+        // clobber BEFORE the write, so the just-written entry survives the
+        // wrap.  Previous order (write then check-and-advance-tail) lost
+        // the newest entry the moment the buffer first filled.
+        int next_head = (debug->trace_head + 1) % debug->trace_buffer_size;
+        if (next_head == debug->trace_tail)
+            debug->trace_tail = (debug->trace_tail + 1) % debug->trace_buffer_size;
+        debug->trace_buffer[debug->trace_head] = pc;
+        debug->trace_head = next_head;
+    }
+
+    // Record PC in new trace entries buffer
+    if (debug->trace_entries)
+        trace_add_pc_entry(debug, pc);
+}
+
+// Per-instruction decoder hook (see debug.h)
+bool debug_pc_hook(uint32_t pc) {
+    bool armed = s_pc_armed && pc == s_pc_armed_pc;
+    s_pc_armed = false;
+    if (!armed && pc_watch_marked(pc)) {
+        // Stop before the instruction: close the sprint at the instructions
+        // already run and leave the check to debug_break_and_trace
+        s_pc_stop = true;
+        cpu_reschedule();
+        return true;
+    }
+    if (s_watch_debug != NULL)
+        trace_record_pc(s_watch_debug, pc);
+    return false;
+}
+
+// Let the instruction at pc run without stopping
+void debug_pc_watch_arm(uint32_t pc) {
+    s_pc_armed = true;
+    s_pc_armed_pc = pc;
+    s_xlate_page = UINT32_MAX; // mappings may have changed since the last sprint
+}
+
+// Check breakpoints and PC logpoints after a sprint the PC watch ended
 int debug_break_and_trace(void) {
+    if (!s_pc_stop)
+        return false;
+    s_pc_stop = false;
     debug_t *debug = system_debug();
     cpu_t *cpu = system_cpu();
     if (!debug || !cpu)
@@ -650,6 +785,16 @@ int debug_break_and_trace(void) {
                     bp = bp->next;
                     continue;
                 }
+                // History replay only notes where the hit falls and runs on,
+                // so the replayed frames keep their original budgets
+                if (debug->replaying) {
+                    uint64_t at = cpu_instr_count();
+                    if (at < debug->replay_before) {
+                        debug->replay_hits++;
+                        debug->replay_last_hit = at;
+                    }
+                    break;
+                }
                 bp->hit_count++;
                 if (bp->space == ADDR_PHYSICAL) {
                     printf("breakpoint hit at P:$%08X (PC=$%08X)\n", bp->addr, current_pc);
@@ -673,7 +818,7 @@ int debug_break_and_trace(void) {
     uint32_t phys_pc_page = 0;
     bool phys_pc_resolved = false;
     bool phys_pc_valid = false;
-    while (lp != NULL) {
+    while (lp != NULL && !debug->replaying) {
         if (lp->kind == LP_KIND_PC) {
             bool hit = (current_pc >= lp->addr && current_pc <= lp->end_addr);
             if (!hit && lp->start_phys_page <= lp->end_phys_page) {
@@ -702,23 +847,9 @@ int debug_break_and_trace(void) {
         lp = lp->next;
     }
 
-    if (debug->trace_buffer) {
-        // Standard ring buffer: advance tail past the slot we're about to
-        // clobber BEFORE the write, so the just-written entry survives the
-        // wrap.  Previous order (write then check-and-advance-tail) lost
-        // the newest entry the moment the buffer first filled.
-        int next_head = (debug->trace_head + 1) % debug->trace_buffer_size;
-        if (next_head == debug->trace_tail)
-            debug->trace_tail = (debug->trace_tail + 1) % debug->trace_buffer_size;
-        debug->trace_buffer[debug->trace_head] = current_pc;
-        debug->trace_head = next_head;
-    }
-
-    // Record PC in new trace entries buffer
-    if (debug->trace_entries) {
-        trace_add_pc_entry(debug, current_pc);
-    }
-
+    // Nothing stopped here: the next sprint runs this instruction
+    if (!stop)
+        debug_pc_watch_arm(current_pc);
     return stop;
 }
 
@@ -752,6 +883,7 @@ bool delete_breakpoint(debug_t *debug, uint32_t addr, addr_space_t space) {
                 prev->next = bp->next;
             }
             free_breakpoint(bp);
+            pc_watch_update(debug);
             return true;
         }
         prev = bp;
@@ -770,6 +902,7 @@ static bool delete_breakpoint_by_id(debug_t *debug, int id) {
             breakpoint_t *bp = *pp;
             *pp = bp->next;
             free_breakpoint(bp);
+            pc_watch_update(debug);
             return true;
         }
         pp = &(*pp)->next;
@@ -790,6 +923,7 @@ int delete_all_breakpoints(debug_t *debug) {
         count++;
     }
     debug->breakpoints = NULL;
+    pc_watch_update(debug);
     return count;
 }
 
@@ -827,11 +961,18 @@ int debug_trace_is_active(void) {
     return debug->trace_entries != NULL;
 }
 
-// Check if debug functionality is engaged (breakpoints, logpoints, or tracing)
+// Check if the PC watch is needed (breakpoints, PC logpoints, or tracing).
+// Memory logpoints fire from the memory slow path and need no PC watch.
 bool debug_active(debug_t *debug) {
     if (!debug)
         return false;
-    return debug->breakpoints != NULL || debug->logpoints != NULL || debug->trace_buffer != NULL;
+    if (debug->breakpoints != NULL || debug->trace_buffer != NULL || debug->trace_entries != NULL)
+        return true;
+    for (logpoint_t *lp = debug->logpoints; lp != NULL; lp = lp->next) {
+        if (lp->kind == LP_KIND_PC)
+            return true;
+    }
+    return false;
 }
 
 // Capture a log message to the trace buffer
@@ -1870,6 +2011,7 @@ static int delete_logpoint_by_id(debug_t *debug, int id) {
             logpoint_t *lp = *pp;
             *pp = lp->next;
             free_logpoint(lp);
+            pc_watch_update(debug);
             return 0;
         }
         pp = &(*pp)->next;
@@ -1888,8 +2030,10 @@ int delete_all_logpoints(debug_t *debug) {
         lp = next;
         count++;
     }
-    if (debug)
+    if (debug) {
         debug->logpoints = NULL;
+        pc_watch_update(debug);
+    }
     return count;
 }
 
@@ -2081,6 +2225,24 @@ debug_t *debug_init(void) {
     return debug;
 }
 
+// Re-install the watches of a debugger that moved to a rebuilt machine
+// (history rewind): memory logpoints force their pages through the new
+// memory map's slow path again, and the decoder PC watch is re-armed.
+void debug_reinstall(debug_t *debug) {
+    if (!debug)
+        return;
+    for (logpoint_t *lp = debug->logpoints; lp; lp = lp->next) {
+        if (lp->kind == LP_KIND_PC)
+            continue;
+        if (lp->space == ADDR_LOGICAL)
+            memory_logpoint_install(lp->addr >> PAGE_SHIFT, lp->end_addr >> PAGE_SHIFT);
+        if (lp->end_phys_page >= lp->start_phys_page)
+            memory_logpoint_install_phys(lp->start_phys_page, lp->end_phys_page);
+    }
+    g_mem_logpoint_hook = debug_memory_logpoint_hook;
+    pc_watch_update(debug);
+}
+
 // ============================================================================
 // Lifecycle: Destructor
 // ============================================================================
@@ -2137,6 +2299,10 @@ void debug_cleanup(debug_t *debug) {
     }
     debug->logpoints = NULL;
     g_mem_logpoint_hook = NULL;
+    if (s_watch_debug == debug) {
+        g_debug_pc_hook = false;
+        s_watch_debug = NULL;
+    }
 
     // Free trace log buffer entries
     if (debug->trace_log_buffer) {
@@ -80,6 +80,12 @@ struct debug {
     uint32_t trace_entries_size;
     uint32_t trace_entries_head;
     uint32_t trace_entries_tail;
+    // History replay (debug/history.c): breakpoints do not stop but record
+    // hits before instruction replay_before; logpoints stay silent
+    bool replaying;
+    uint64_t replay_before;
+    uint64_t replay_hits;
+    uint64_t replay_last_hit; // instruction count of the latest recorded hit
     // Platform-specific assertion callback (e.g., for test integration)
     void (*assertion_callback)(const char *expr, const char *file, int line, const char *func);
     // Object-tree binding — lifetime tied to debug_init / debug_cleanup.
@@ -103,6 +109,10 @@ breakpoint_t *set_breakpoint(debug_t *debug, uint32_t addr, addr_space_t space);
 
 bool delete_breakpoint(debug_t *debug, uint32_t addr, addr_space_t space);
 
+// Re-install the memory logpoints and PC watch of a debugger handed over to a
+// machine rebuilt from a snapshot (see debug/history.h)
+void debug_reinstall(debug_t *debug);
+
 // Bulk break/logpoint management — used by typed root wrappers as direct
 // implementations (no shell_dispatch indirection). list_* prints to
 // stdout; delete_all_* returns the count of entries removed.
@@ -191,6 +201,8 @@ void debugger_disasm_pc(char *buf, size_t buf_size);
 
 int debugger_disasm(char *buf, size_t buf_size, uint32_t addr);
 
+// Check breakpoints and PC logpoints after a sprint the PC watch ended;
+// returns true when execution should stop
 int debug_break_and_trace(void);
 
 void debug_print_target_trace(void);
@@ -199,8 +211,26 @@ void debug_trace_capture_log(const char *line);
 
 int debug_trace_is_active(void);
 
+// True while any breakpoint, PC logpoint or trace buffer needs the PC watch
 bool debug_active(debug_t *debug);
 
+// === Decoder PC watch ===
+// Breakpoints and PC logpoints mark the 4 KB pages they live on (logical
+// pages, plus physical pages for P: breakpoints and logpoint aliases).  While
+// debug_active() holds, the CPU decoders call debug_pc_hook() before every
+// instruction: it feeds the trace buffers and, when the PC enters a marked
+// page, ends the sprint before the instruction runs so the scheduler can call
+// debug_break_and_trace().  Code on unmarked pages runs in full-length sprints.
+
+extern bool g_debug_pc_hook; // set while the decoders must call debug_pc_hook
+
+// Per-instruction hook; true when the sprint was ended at a marked page
+bool debug_pc_hook(uint32_t pc);
+
+// Let the instruction at pc run without stopping (it was just checked, or
+// execution is resuming there)
+void debug_pc_watch_arm(uint32_t pc);
+
 // Check if prompt/status line is enabled (IMP-308)
 bool debug_prompt_enabled(void);
 
@@ -0,0 +1,619 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// history.c
+// Reverse execution: in-memory snapshot ring, frame log and deterministic
+// replay to a target instruction (see history.h).
+
+#include "history.h"
+
+#include "checkpoint.h"
+#include "cpu.h"
+#include "debug.h"
+#include "image.h"
+#include "log.h"
+#include "object.h"
+#include "scheduler.h"
+#include "snapshot_pool.h"
+#include "storage.h"
+#include "system.h"
+#include "system_config.h"
+#include "value.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_USE_CATEGORY_NAME("history");
+
+#define HISTORY_DEFAULT_CAPACITY 32
+#define HISTORY_MAX_CAPACITY     4096
+
+// One snapshot of the ring
+typedef struct {
+    uint64_t instr; // timeline position it was taken at
+    uint64_t frame; // index of the frame it precedes
+    void *data; // checkpoint stream (checkpoint_close_mem)
+    size_t size;
+    snapshot_hash_set_t *refs; // pool objects the stream references
+} history_snap_t;
+
+// One frame-unit run by scheduler_run_frame
+typedef struct {
+    uint64_t start, end; // timeline positions before the VBL and after the run
+    uint64_t cycles; // cycle counter at the start (replay cross-check)
+    bool full; // ran its whole period (not stopped early)
+} history_frame_t;
+
+static struct {
+    uint32_t interval; // frame-units between snapshots; 0 = off
+    uint32_t capacity; // snapshots kept
+    snapshot_mem_pool_t *pool;
+    history_snap_t *snaps; // oldest first
+    uint32_t count;
+    history_frame_t *frames; // frames[i] is frame frame_base + i
+    size_t n_frames, cap_frames;
+    uint64_t frame_base;
+    uint32_t since; // frames begun since the newest snapshot
+    bool open; // the last frame has begun but not ended
+    bool busy; // restoring or replaying: hooks stay out of the way
+    config_t *config; // machine the history belongs to
+    const char *model_id;
+    uint32_t ram_size_kb;
+    uint64_t bias; // timeline position minus cpu_instr_count()
+} g_history = {.capacity = HISTORY_DEFAULT_CAPACITY};
+
+// ============================================================================
+// Ring
+// ============================================================================
+
+uint64_t history_position(void) {
+    return cpu_instr_count() + g_history.bias;
+}
+
+static void snap_free(history_snap_t *snap) {
+    snapshot_mem_pool_release(g_history.pool, snapshot_hash_set_items(snap->refs), snapshot_hash_set_count(snap->refs));
+    snapshot_hash_set_free(snap->refs);
+    free(snap->data);
+}
+
+// Drop frames logged before the oldest snapshot; replay never starts there
+static void trim_frames(void) {
+    uint64_t keep = g_history.count ? g_history.snaps[0].frame : g_history.frame_base + g_history.n_frames;
+    if (keep <= g_history.frame_base)
+        return;
+    size_t drop = (size_t)(keep - g_history.frame_base);
+    if (drop > g_history.n_frames)
+        drop = g_history.n_frames;
+    memmove(g_history.frames, g_history.frames + drop, (g_history.n_frames - drop) * sizeof(history_frame_t));
+    g_history.n_frames -= drop;
+    g_history.frame_base += drop;
+}
+
+static void evict_oldest(void) {
+    if (!g_history.count)
+        return;
+    snap_free(&g_history.snaps[0]);
+    g_history.count--;
+    memmove(g_history.snaps, g_history.snaps + 1, g_history.count * sizeof(history_snap_t));
+    trim_frames();
+}
+
+void history_discard(const char *why) {
+    if (g_history.busy)
+        return;
+    if (g_history.count && why)
+        LOG(1, "history discarded: %s", why);
+    while (g_history.count)
+        evict_oldest();
+    free(g_history.snaps);
+    free(g_history.frames);
+    snapshot_mem_pool_free(g_history.pool);
+    g_history.snaps = NULL;
+    g_history.frames = NULL;
+    g_history.pool = NULL;
+    g_history.n_frames = g_history.cap_frames = 0;
+    g_history.frame_base = 0;
+    g_history.since = 0;
+    g_history.open = false;
+    g_history.config = NULL;
+    g_history.bias = 0;
+}
+
+void history_forget(config_t *config, const char *why) {
+    if (config && config == g_history.config)
+        history_discard(why);
+}
+
+// Snapshot the machine at the current position, ahead of frame frame
+static bool take_snapshot(uint64_t frame) {
+    if (!g_history.pool && !(g_history.pool = snapshot_mem_pool_new()))
+        return false;
+    if (!g_history.snaps) {
+        g_history.snaps = (history_snap_t *)calloc(g_history.capacity, sizeof(history_snap_t));
+        if (!g_history.snaps)
+            return false;
+    }
+    checkpoint_t *cp = checkpoint_open_write_mem(CHECKPOINT_KIND_HISTORY, g_history.model_id, g_history.ram_size_kb,
+                                                 g_history.pool);
+    if (!cp)
+        return false;
+    system_checkpoint_write(cp);
+    history_snap_t snap = {.instr = history_position(), .frame = frame};
+    if (!checkpoint_close_mem(cp, &snap.data, &snap.size, &snap.refs))
+        return false;
+
+    if (g_history.count == g_history.capacity)
+        evict_oldest();
+    g_history.snaps[g_history.count++] = snap;
+    return true;
+}
+
+void history_frame_begin(config_t *config) {
+    if (!g_history.interval || g_history.busy || !config->machine)
+        return;
+    if (config != g_history.config) {
+        history_discard("machine changed");
+        g_history.config = config;
+        g_history.model_id = config->machine->id;
+        g_history.ram_size_kb = config->ram_size / 1024;
+    }
+    uint64_t index = g_history.frame_base + g_history.n_frames;
+    if (!g_history.count || g_history.since >= g_history.interval) {
+        if (take_snapshot(index))
+            g_history.since = 0;
+        else
+            LOG(0, "history: snapshot failed");
+    }
+    if (!g_history.count)
+        return;
+
+    if (g_history.n_frames == g_history.cap_frames) {
+        size_t cap = g_history.cap_frames ? g_history.cap_frames * 2 : 256;
+        history_frame_t *grown = (history_frame_t *)realloc(g_history.frames, cap * sizeof(history_frame_t));
+        if (!grown) {
+            history_discard("out of memory");
+            return;
+        }
+        g_history.frames = grown;
+        g_history.cap_frames = cap;
+    }
+    uint64_t now = history_position();
+    g_history.frames[g_history.n_frames++] =
+        (history_frame_t){.start = now, .end = now, .cycles = scheduler_cpu_cycles(config->scheduler)};
+    g_history.since++;
+    g_history.open = true;
+}
+
+void history_frame_end(config_t *config) {
+    if (!g_history.open || config != g_history.config)
+        return;
+    history_frame_t *f = &g_history.frames[g_history.n_frames - 1];
+    f->end = history_position();
+    f->full = scheduler_is_running(config->scheduler);
+    g_history.open = false;
+}
+
+// ============================================================================
+// Restore and replay
+// ============================================================================
+
+// Rebuild the machine from snapshot i; the debugger (breakpoints, logpoints)
+// moves over to the new machine
+static bool restore_snapshot(uint32_t i) {
+    history_snap_t *snap = &g_history.snaps[i];
+    config_t *old = global_emulator;
+
+    // Same-file delta instances are opened again by the restore; let them see
+    // everything written so far
+    for (int k = 0; k < old->n_images; k++)
+        if (old->images[k])
+            storage_flush(old->images[k]->storage);
+
+    checkpoint_t *cp = checkpoint_open_read_mem(snap->data, snap->size, CHECKPOINT_KIND_HISTORY, g_history.model_id,
+                                                g_history.ram_size_kb, g_history.pool);
+    if (!cp)
+        return false;
+    g_history.busy = true;
+    config_t *fresh = system_restore_from(cp);
+    checkpoint_close(cp);
+    if (!fresh) {
+        g_history.busy = false;
+        return false;
+    }
+
+    global_emulator = fresh;
+    debug_t *carried = old->debugger;
+    old->debugger = fresh->debugger;
+    fresh->debugger = carried;
+    g_history.config = fresh;
+    system_destroy(old);
+    debug_reinstall(carried);
+    extern void frontend_force_redraw(void);
+    frontend_force_redraw();
+
+    g_history.bias = snap->instr - cpu_instr_count();
+    g_history.busy = false;
+    return true;
+}
+
+// Run instructions until the timeline reaches stop
+static bool run_until(scheduler_t *s, uint64_t stop) {
+    while (history_position() < stop) {
+        uint64_t before = history_position();
+        scheduler_run_instructions(s, stop - before);
+        if (history_position() == before)
+            return false;
+    }
+    return history_position() == stop;
+}
+
+// Re-execute the logged frames from frame (where the machine stands now) up
+// to target.  Frames starting before target run as recorded; the frame
+// holding target is cut short there.  *reached receives the index of the
+// first frame not run.
+static bool replay_to(uint64_t frame, uint64_t target, uint64_t *reached) {
+    config_t *cfg = global_emulator;
+    scheduler_t *s = cfg->scheduler;
+    debug_t *debug = cfg->debugger;
+    size_t j = (size_t)(frame - g_history.frame_base);
+    bool ok = true;
+
+    g_history.busy = true;
+    if (debug) {
+        debug->replaying = true;
+        debug->last_breakpoint_pc = 0;
+    }
+    while (ok) {
+        uint64_t now = history_position();
+        history_frame_t *f = j < g_history.n_frames && g_history.frames[j].start < target ? &g_history.frames[j] : NULL;
+        if (f && f->start == now) {
+            if (scheduler_cpu_cycles(s) != f->cycles) {
+                ok = false;
+                break;
+            }
+            if (f->full && f->end <= target) {
+                scheduler_replay_frame(s, cfg);
+                ok = history_position() == f->end;
+            } else {
+                trigger_vbl(cfg);
+                ok = run_until(s, f->end < target ? f->end : target);
+            }
+            j++;
+            continue;
+        }
+        if (now >= target)
+            break;
+        uint64_t stop = f ? f->start : target;
+        ok = stop > now && run_until(s, stop);
+    }
+    scheduler_stop(s);
+    if (debug)
+        debug->replaying = false;
+    g_history.busy = false;
+    *reached = g_history.frame_base + j;
+    return ok && history_position() == target;
+}
+
+// Drop what lies beyond the current position (now, before frame reached): it
+// is no longer the past
+static void truncate_future(uint64_t now, uint64_t reached) {
+    while (g_history.count && (g_history.snaps[g_history.count - 1].instr > now ||
+                               g_history.snaps[g_history.count - 1].frame > reached)) {
+        g_history.count--;
+        snap_free(&g_history.snaps[g_history.count]);
+    }
+    size_t keep = (size_t)(reached - g_history.frame_base);
+    g_history.n_frames = keep;
+    if (keep && g_history.frames[keep - 1].end > now) {
+        g_history.frames[keep - 1].end = now;
+        g_history.frames[keep - 1].full = false;
+    }
+    g_history.open = false;
+    if (g_history.count)
+        g_history.since = (uint32_t)(g_history.frame_base + keep - g_history.snaps[g_history.count - 1].frame);
+}
+
+// Newest snapshot at or before instr, or -1
+static int snapshot_before(uint64_t instr) {
+    for (int i = (int)g_history.count - 1; i >= 0; i--)
+        if (g_history.snaps[i].instr <= instr)
+            return i;
+    return -1;
+}
+
+// Restore snapshot i and replay to target; a failure leaves no usable history
+static int rewind_to(int i, uint64_t target) {
+    if (!restore_snapshot((uint32_t)i)) {
+        printf("history: cannot restore the snapshot at %" PRIu64 "\n", g_history.snaps[i].instr);
+        return GS_ERROR;
+    }
+    uint64_t reached;
+    if (!replay_to(g_history.snaps[i].frame, target, &reached)) {
+        printf("history: replay diverged before %" PRIu64 " (now at %" PRIu64 "); history discarded\n", target,
+               history_position());
+        history_discard(NULL);
+        return GS_ERROR;
+    }
+    truncate_future(target, reached);
+    return GS_SUCCESS;
+}
+
+// A command may arrive with the last frame still open (e.g. from inside it)
+static bool history_ready(void) {
+    if (!g_history.count || global_emulator != g_history.config) {
+        printf("history: nothing recorded (set history.interval to start)\n");
+        return false;
+    }
+    if (g_history.open)
+        history_frame_end(g_history.config);
+    return true;
+}
+
+int history_seek(uint64_t instr) {
+    if (!history_ready())
+        return GS_ERROR;
+    uint64_t now = history_position();
+    int i = snapshot_before(instr);
+    if (i < 0 || instr > now) {
+        printf("history: %" PRIu64 " is outside the recorded range %" PRIu64 "..%" PRIu64 "\n", instr,
+               g_history.snaps[0].instr, now);
+        return GS_ERROR;
+    }
+    return rewind_to(i, instr);
+}
+
+int history_step_back(uint64_t count) {
+    if (!history_ready())
+        return GS_ERROR;
+    uint64_t now = history_position();
+    if (count > now - g_history.snaps[0].instr) {
+        printf("history: only %" PRIu64 " instructions recorded\n", now - g_history.snaps[0].instr);
+        return GS_ERROR;
+    }
+    return history_seek(now - count);
+}
+
+int history_continue_back(void) {
+    if (!history_ready())
+        return GS_ERROR;
+    debug_t *debug = system_debug();
+    if (!debug || !debug->breakpoints) {
+        printf("history: no breakpoints set\n");
+        return GS_ERROR;
+    }
+    uint64_t now = history_position();
+
+    // Replay the intervals between snapshots newest first, each up to where
+    // the previous scan began, until one of them hits a breakpoint.  Every
+    // scan ends where it started from, so a miss leaves the machine at now.
+    uint64_t limit = now, at = now;
+    for (int i = snapshot_before(now); i >= 0; i--) {
+        if (g_history.snaps[i].instr >= limit)
+            continue;
+        if (!restore_snapshot((uint32_t)i))
+            return GS_ERROR;
+        debug = system_debug();
+        debug->replay_before = limit - g_history.bias;
+        debug->replay_hits = 0;
+        uint64_t reached;
+        bool ok = replay_to(g_history.snaps[i].frame, limit, &reached);
+        uint64_t hits = debug->replay_hits;
+        uint64_t hit = debug->replay_last_hit + g_history.bias;
+        if (!ok) {
+            printf("history: replay diverged; history discarded\n");
+            history_discard(NULL);
+            return GS_ERROR;
+        }
+        if (hits) {
+            if (rewind_to(i, hit) != GS_SUCCESS)
+                return GS_ERROR;
+            cpu_t *cpu = system_cpu();
+            system_debug()->last_breakpoint_pc = cpu_get_pc(cpu);
+            printf("breakpoint hit at $%08X (history %" PRIu64 ")\n", cpu_get_pc(cpu), hit);
+            return GS_SUCCESS;
+        }
+        at = limit;
+        limit = g_history.snaps[i].instr;
+    }
+    // The scans ran forward again; put the machine back where it was
+    if (at != now) {
+        int i = snapshot_before(now);
+        if (rewind_to(i, now) != GS_SUCCESS)
+            return GS_ERROR;
+    }
+    printf("history: no breakpoint hit in the recorded past\n");
+    return GS_ERROR;
+}
+
+// ============================================================================
+// Object-model class descriptor
+// ============================================================================
+
+static value_t history_attr_interval(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(4, g_history.interval);
+}
+
+static value_t history_attr_interval_set(struct object *self, const member_t *m, value_t in) {
+    (void)self;
+    (void)m;
+    if (in.u > UINT32_MAX)
+        return val_err("history.interval: %llu out of range", (unsigned long long)in.u);
+    if (in.u == 0)
+        history_discard("disabled");
+    g_history.interval = (uint32_t)in.u;
+    return val_none();
+}
+
+static value_t history_attr_capacity(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(4, g_history.capacity);
+}
+
+static value_t history_attr_capacity_set(struct object *self, const member_t *m, value_t in) {
+    (void)self;
+    (void)m;
+    if (in.u < 1 || in.u > HISTORY_MAX_CAPACITY)
+        return val_err("history.capacity: %llu out of range (1..%d)", (unsigned long long)in.u, HISTORY_MAX_CAPACITY);
+    while (g_history.count > in.u)
+        evict_oldest();
+    if (g_history.snaps) {
+        history_snap_t *grown = (history_snap_t *)realloc(g_history.snaps, (size_t)in.u * sizeof(history_snap_t));
+        if (!grown)
+            return val_err("history.capacity: out of memory");
+        g_history.snaps = grown;
+    }
+    g_history.capacity = (uint32_t)in.u;
+    return val_none();
+}
+
+static value_t history_attr_count(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(4, g_history.count);
+}
+
+// Streams plus the pooled objects they share
+static value_t history_attr_bytes(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    uint64_t bytes = g_history.pool ? snapshot_mem_pool_bytes(g_history.pool) : 0;
+    for (uint32_t i = 0; i < g_history.count; i++)
+        bytes += g_history.snaps[i].size;
+    return val_uint(8, bytes);
+}
+
+static value_t history_attr_oldest(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(8, g_history.count ? g_history.snaps[0].instr : 0);
+}
+
+static value_t history_attr_position(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(8, history_position());
+}
+
+static value_t history_method_step_back(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    int64_t count = (argc >= 1) ? argv[0].i : 1;
+    if (count <= 0)
+        return val_err("history.step_back: count must be positive");
+    return val_bool(history_step_back((uint64_t)count) == GS_SUCCESS);
+}
+
+static value_t history_method_continue_back(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    (void)argv;
+    return val_bool(history_continue_back() == GS_SUCCESS);
+}
+
+static value_t history_method_seek(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    return val_bool(history_seek(argv[0].u) == GS_SUCCESS);
+}
+
+static value_t history_method_clear(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    (void)argv;
+    history_discard(NULL);
+    return val_none();
+}
+
+static const arg_decl_t history_step_back_args[] = {
+    {.name = "count", .kind = V_INT, .validation_flags = OBJ_ARG_OPTIONAL, .doc = "Number of instructions (default 1)"},
+};
+
+static const arg_decl_t history_seek_args[] = {
+    {.name = "position", .kind = V_UINT, .doc = "History position (an instruction count, see history.position)"},
+};
+
+static const member_t history_members[] = {
+    {.kind = M_ATTR,
+     .name = "interval",
+     .doc = "Frame-units between snapshots; 0 turns recording off and drops the history",
+     .flags = 0,
+     .attr = {.type = V_UINT, .get = history_attr_interval, .set = history_attr_interval_set}},
+    {.kind = M_ATTR,
+     .name = "capacity",
+     .doc = "Snapshots kept; the oldest goes first (1..4096)",
+     .flags = 0,
+     .attr = {.type = V_UINT, .get = history_attr_capacity, .set = history_attr_capacity_set}},
+    {.kind = M_ATTR,
+     .name = "count",
+     .doc = "Snapshots held",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = history_attr_count, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "bytes",
+     .doc = "Memory the snapshots occupy, shared pages counted once",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = history_attr_bytes, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "oldest",
+     .doc = "Earliest position that can be reached",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = history_attr_oldest, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "position",
+     .doc = "Current position (instructions on the history timeline)",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = history_attr_position, .set = NULL}},
+    {.kind = M_METHOD,
+     .name = "step_back",
+     .doc = "Go back N instructions (default 1)",
+     .method = {.args = history_step_back_args, .nargs = 1, .result = V_BOOL, .fn = history_method_step_back}},
+    {.kind = M_METHOD,
+     .name = "continue_back",
+     .doc = "Go back to the most recent breakpoint hit",
+     .method = {.args = NULL, .nargs = 0, .result = V_BOOL, .fn = history_method_continue_back}},
+    {.kind = M_METHOD,
+     .name = "seek",
+     .doc = "Go to a recorded position",
+     .method = {.args = history_seek_args, .nargs = 1, .result = V_BOOL, .fn = history_method_seek}},
+    {.kind = M_METHOD,
+     .name = "clear",
+     .doc = "Drop every snapshot",
+     .method = {.args = NULL, .nargs = 0, .result = V_NONE, .fn = history_method_clear}},
+};
+
+const class_desc_t history_class = {
+    .name = "history",
+    .members = history_members,
+    .n_members = sizeof(history_members) / sizeof(history_members[0]),
+};
+
+// ============================================================================
+// Lifecycle (process-singleton, idempotent)
+// ============================================================================
+
+static struct object *s_history_object = NULL;
+
+void history_init(void) {
+    if (s_history_object)
+        return;
+    s_history_object = object_new(&history_class, NULL, "history");
+    if (s_history_object)
+        object_attach(object_root(), s_history_object);
+}
+
+void history_delete(void) {
+    history_discard(NULL);
+    if (s_history_object) {
+        object_detach(s_history_object);
+        object_delete(s_history_object);
+        s_history_object = NULL;
+    }
+}
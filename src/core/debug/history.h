@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// history.h
+// Reverse execution: a ring of in-memory snapshots of the running machine
+// plus a log of the frame-units run since the oldest one.
+//
+// Every `interval` frame-units, scheduler_run_frame snapshots the machine
+// through the checkpoint serialisers into memory (CHECKPOINT_KIND_HISTORY).
+// RAM pages and other large blocks go to a reference-counted in-memory pool
+// (snapshot_pool.h), so consecutive snapshots share every page that did not
+// change.  Stepping back restores the nearest snapshot at or before the
+// target and re-executes the logged frames forward to the exact instruction.
+//
+// Positions are instruction counts on the history's own timeline: a restored
+// machine rebuilds its instruction counter from the cycle counter, so the
+// history carries the offset across rewinds.  Host input and media changes
+// cannot be replayed and discard the history.
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "common.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct config config_t;
+
+// Frame-unit hooks called by scheduler_run_frame around each frame
+void history_frame_begin(config_t *config);
+void history_frame_end(config_t *config);
+
+// Drop every snapshot and the frame log (why is logged when there was any)
+void history_discard(const char *why);
+
+// history_discard, but only when the history belongs to config (the machine
+// being destroyed or given new media)
+void history_forget(config_t *config, const char *why);
+
+// Current position on the history timeline
+uint64_t history_position(void);
+
+// Rewind (or fast-forward within the recorded past) to position instr.
+// Returns GS_SUCCESS, or GS_ERROR with nothing changed when instr is out of
+// the recorded range, and GS_ERROR after a divergent replay (the history is
+// discarded then).
+int history_seek(uint64_t instr);
+
+// Go back count instructions
+int history_step_back(uint64_t count);
+
+// Go back to the most recent breakpoint hit before the current position
+int history_continue_back(void);
+
+// === Object-model class descriptor =========================================
+//
+// `history` exposes interval / capacity and the ring's size, plus
+// step_back / continue_back / seek / clear.
+
+struct class_desc;
+extern const struct class_desc history_class;
+
+void history_init(void);
+void history_delete(void);
+
+#endif // HISTORY_H
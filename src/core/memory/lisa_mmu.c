@@ -116,6 +116,27 @@ struct lisa_mmu {
 
 lisa_mmu_t *g_lisa_mmu = NULL;
 
+// === Software TLB ==========================================================
+//
+// Plain RAM and ROM pages are cached in the generic SoA fast-path tables: the
+// supervisor tables translate through context 0, the user tables through the
+// SEG1/SEG2 latch context.  lisa_soa_fill (below lisa_resolve) installs a page
+// after a slow-path access; everything that can change a cached translation
+// calls lisa_soa_invalidate.
+
+// Drop the SoA fills of the supervisor and/or user tables
+static void lisa_soa_invalidate(bool supervisor, bool user) {
+    memory_code_window_flush();
+    if (supervisor) {
+        memory_soa_clear(g_supervisor_read);
+        memory_soa_clear(g_supervisor_write);
+    }
+    if (user) {
+        memory_soa_clear(g_user_read);
+        memory_soa_clear(g_user_write);
+    }
+}
+
 // === Lifecycle =============================================================
 
 lisa_mmu_t *lisa_mmu_init(uint8_t *ram, uint32_t ram_size, uint8_t *rom, uint32_t rom_size, bool ram_high,
@@ -148,6 +169,7 @@ lisa_mmu_t *lisa_mmu_init(uint8_t *ram, uint32_t ram_size, uint8_t *rom, uint32_
     m->vidlatch = 0;
     m->bad_par_gran = 0xFFFFFFFFu; // no bad-parity location
     g_lisa_mmu = m;
+    lisa_soa_invalidate(true, true);
     if (cp)
         lisa_mmu_checkpoint(m, cp); // restore (same field order as save)
     return m;
@@ -156,8 +178,10 @@ lisa_mmu_t *lisa_mmu_init(uint8_t *ram, uint32_t ram_size, uint8_t *rom, uint32_
 void lisa_mmu_delete(lisa_mmu_t *m) {
     if (!m)
         return;
-    if (g_lisa_mmu == m)
+    if (g_lisa_mmu == m) {
         g_lisa_mmu = NULL;
+        lisa_soa_invalidate(true, true); // fills point into this machine's RAM/ROM
+    }
     free(m);
 }
 
@@ -215,9 +239,8 @@ void lisa_mmu_set_clock(lisa_mmu_t *m, struct scheduler *sched) {
 
 // === Control-block strobes & registers ($00E000-$00FFFF physical) ==========
 
-// Strobe a control latch.  Triggered by ANY access (read or write) to a strobe
-// address in $00E000-$00E01E; the data value is ignored.
-static void lisa_strobe(lisa_mmu_t *m, uint32_t phys) {
+// Apply a control-latch strobe to the latch state alone
+static void lisa_strobe_latch(lisa_mmu_t *m, uint32_t phys) {
     switch (phys & 0x1E) {
     case 0x08:
         m->seg1 = 0;
@@ -269,6 +292,20 @@ static void lisa_strobe(lisa_mmu_t *m, uint32_t phys) {
     }
 }
 
+// Strobe a control latch.  Triggered by ANY access (read or write) to a strobe
+// address in $00E000-$00E01E; the data value is ignored.  START changes and
+// DG2ON (every write must mark parity) drop all SoA fills; a SEG1/SEG2 change
+// drops the user-context fills.
+static void lisa_strobe(lisa_mmu_t *m, uint32_t phys) {
+    bool start = m->start;
+    int latch_ctx = (m->seg2 << 1) | m->seg1;
+    lisa_strobe_latch(m, phys);
+    if (m->start != start || (phys & 0x1E) == 0x06)
+        lisa_soa_invalidate(true, true);
+    else if (((m->seg2 << 1) | m->seg1) != latch_ctx)
+        lisa_soa_invalidate(false, true);
+}
+
 // Set the level-7 parity-NMI callback (machine routes it to cpu_set_ipl).
 void lisa_mmu_set_nmi(lisa_mmu_t *m, void (*cb)(void *, bool), void *ctx) {
     if (!m)
@@ -518,6 +555,48 @@ static lisa_resolved_t lisa_resolve(lisa_mmu_t *m, uint32_t addr, bool superviso
     return r;
 }
 
+// Host address backing the whole emulator page at `page_addr`, or NULL when
+// any byte of it needs the slow path.  A 4 KB emulator page is 8 Lisa pages
+// inside one 128 KB segment, so it is one contiguous physical run whenever its
+// first and last bytes resolve to the same space 4095 bytes apart (the limit
+// window is contiguous, so every page in between is valid too).
+static uint8_t *lisa_page_host(lisa_mmu_t *m, uint32_t page_addr, bool supervisor, bool is_write) {
+    // Parity self-test: reads of the bad granule raise the NMI, writes mark it
+    if (m->wwp_on || m->bad_par_gran != 0xFFFFFFFFu)
+        return NULL;
+    if (lisa_is_serial(m, page_addr))
+        return NULL;
+    lisa_resolved_t first = lisa_resolve(m, page_addr, supervisor, is_write);
+    lisa_resolved_t last = lisa_resolve(m, page_addr + MEM_PAGE_SIZE - 1, supervisor, is_write);
+    if (first.route != last.route || last.phys - first.phys != MEM_PAGE_SIZE - 1)
+        return NULL;
+    if (first.route == L_RAM && first.phys >= m->ram_min && last.phys < m->ram_max)
+        return m->ram + (first.phys - m->ram_min);
+    if (first.route == L_ROM && !is_write && last.phys < m->rom_size)
+        return m->rom + first.phys;
+    return NULL; // I/O, descriptor RAM, fault, or beyond installed RAM/ROM
+}
+
+// Cache the page holding `addr` in the SoA table for this mode and direction
+static void lisa_soa_fill(lisa_mmu_t *m, uint32_t addr, bool supervisor, bool is_write) {
+    uint32_t page_addr = addr & 0x00FFFFFFu & ~(uint32_t)PAGE_MASK;
+    uint32_t page = page_addr >> PAGE_SHIFT;
+    if (page >= g_page_count || (g_mem_logpoint_page_count && g_mem_logpoint_page_count[page]))
+        return;
+    uint8_t *host = lisa_page_host(m, page_addr, supervisor, is_write);
+    if (!host)
+        return;
+    soa_table_t table;
+    if (is_write)
+        table = supervisor ? g_supervisor_write : g_user_write;
+    else
+        table = supervisor ? g_supervisor_read : g_user_read;
+    if (!table)
+        return;
+    memory_code_window_drop(page);
+    memory_soa_set(table, page, (uintptr_t)host - page_addr);
+}
+
 // Latch a 68000 bus error for the faulting access (group-0 exception; not a
 // PMMU descriptor retry, so the decoder skips the faulting instruction).
 static void lisa_raise_bus_error(uint32_t addr, bool is_read, bool supervisor) {
@@ -572,6 +651,7 @@ static void lisa_ram_write(lisa_mmu_t *m, uint32_t phys, unsigned size, uint32_t
         return; // outside installed RAM: dropped
     }
     uint32_t off = phys - m->ram_min;
+    memory_ram_mark_dirty(m->ram + off, size);
     for (unsigned i = 0; i < size; i++)
         m->ram[off + i] = (uint8_t)(value >> ((size - 1 - i) * 8));
 }
@@ -615,11 +695,15 @@ static uint16_t lisa_mmureg_read(const lisa_mmu_t *m, const lisa_resolved_t *r)
     return v & 0x0FFF;
 }
 
+// 12-bit descriptor register write.  A changed descriptor drops the fills
+// that translate through its context: context 0 backs the supervisor tables,
+// the latch context the user tables.
 static void lisa_mmureg_write(lisa_mmu_t *m, const lisa_resolved_t *r, uint16_t value) {
-    if (r->reg_is_sor)
-        m->sor[r->ctx][r->seg] = value & 0x0FFF;
-    else
-        m->slr[r->ctx][r->seg] = value & 0x0FFF;
+    uint16_t *reg = r->reg_is_sor ? &m->sor[r->ctx][r->seg] : &m->slr[r->ctx][r->seg];
+    if (*reg == (value & 0x0FFF))
+        return;
+    *reg = value & 0x0FFF;
+    lisa_soa_invalidate(r->ctx == 0, r->ctx == ((m->seg2 << 1) | m->seg1));
 }
 
 // === CPU slow-path delegates ===============================================
@@ -648,9 +732,11 @@ static uint32_t lisa_read(uint32_t addr, unsigned size, bool supervisor) {
     switch (r.route) {
     case L_RAM:
         v = lisa_ram_read(m, r.phys, size);
+        lisa_soa_fill(m, addr, supervisor, false);
         break;
     case L_ROM:
         v = lisa_rom_read(m, r.phys, size);
+        lisa_soa_fill(m, addr, supervisor, false);
         break;
     case L_IO:
         v = lisa_io_read(m, r.phys, size);
@@ -673,6 +759,7 @@ static void lisa_write(uint32_t addr, unsigned size, bool supervisor, uint32_t v
     switch (r.route) {
     case L_RAM:
         lisa_ram_write(m, r.phys, size, value);
+        lisa_soa_fill(m, addr, supervisor, true);
         break;
     case L_IO:
         lisa_io_write(m, r.phys, size, value);
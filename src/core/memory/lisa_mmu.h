@@ -9,11 +9,11 @@
 // pages and a power-on START (setup) mode that bypasses translation.  See
 // docs/machines/lisa/lisa.md §4-5 and proposal-machine-lisa-xl.md §4.2 for the model.
 //
-// Integration seam: the Lisa machine routes ALL CPU memory accesses through
-// this module via the slow path in memory.c (gated on g_lisa_mmu != NULL).
-// The Lisa fast-path SoA cache is intentionally left empty in this first cut,
-// so every access takes the slow path and is fully translated here; SoA
-// fast-path filling is a later performance optimisation.
+// Integration seam: every SoA miss on the Lisa reaches this module via the
+// slow path in memory.c (gated on g_lisa_mmu != NULL) and is fully translated
+// here.  Plain RAM and ROM pages are then filled into the SoA fast-path tables
+// for the current mode (supervisor = context 0, user = the SEG1/SEG2 context);
+// SETUP strobes, context-latch strobes and descriptor writes invalidate them.
 
 #ifndef LISA_MMU_H
 #define LISA_MMU_H
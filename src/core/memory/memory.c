@@ -31,28 +31,51 @@ extern const class_desc_t mem_peek_class;
 extern const class_desc_t mem_poke_class;
 
 #include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 // ============================================================================
 // Constants and Macros
 // ============================================================================
 
 // Page table globals (defined here, declared extern in memory.h)
-page_entry_t *g_page_table = NULL;
+page_entry_t **g_page_table = NULL;
 uint32_t g_address_mask = 0; // set by memory_map_init; 0 here means "pre-init, do not use"
 uint32_t g_page_count = 0; // number of pages in current page table
 
 // SoA fast-path arrays (adjusted-base entries; zero = slow path)
-uintptr_t *g_supervisor_read = NULL;
-uintptr_t *g_supervisor_write = NULL;
-uintptr_t *g_user_read = NULL;
-uintptr_t *g_user_write = NULL;
+soa_table_t g_supervisor_read = NULL;
+soa_table_t g_supervisor_write = NULL;
+soa_table_t g_user_read = NULL;
+soa_table_t g_user_write = NULL;
 
 // Active pointers (switched per sprint based on SR.S bit)
-uintptr_t *g_active_read = NULL;
-uintptr_t *g_active_write = NULL;
+soa_table_t g_active_read = NULL;
+soa_table_t g_active_write = NULL;
+
+// Shared all-zero leaves behind every unpopulated directory slot.  Never
+// written: memory_page_mut / memory_soa_set swap in a private leaf first.
+static page_entry_t g_page_zero_leaf[PAGE_LEAF_SIZE];
+#ifdef GS_SPARSE_SOA
+static uintptr_t g_soa_zero_leaf[PAGE_LEAF_SIZE];
+#endif
+
+// Instruction-fetch code window (see memory.h)
+uint32_t g_code_page = CODE_PAGE_NONE;
+uintptr_t g_code_base = 0;
+soa_table_t g_code_table = NULL;
+
+// Decoded-page cache (see memory.h)
+code_block_t **g_code_blocks = NULL;
+uintptr_t g_code_blocks_host = 0;
+uint32_t g_code_blocks_pages = 0;
+const void *g_code_blocks_owner = NULL;
+code_block_t *g_code_block = NULL;
+static uint8_t *g_code_block_drops = NULL; // per image page, saturates at CODE_BLOCK_MAX_DROPS
 
 // Deferred bus error signal: set by slow paths on unmapped MMU accesses.
 // Zeroing *g_bus_error_instr_ptr forces the decoder loop to exit early.
@@ -93,6 +116,22 @@ uint8_t *g_mem_logpoint_page_count = NULL;
 uint8_t *g_mem_logpoint_phys_page_count = NULL;
 memory_logpoint_hook_t g_mem_logpoint_hook = NULL;
 
+// RAM dirty-page map for incremental quick checkpoints (see memory.h)
+uint8_t *g_ram_dirty = NULL;
+uintptr_t g_ram_dirty_host = 0;
+uint32_t g_ram_dirty_size = 0;
+
+// Copy-on-write RAM snapshot (see memory.h).  saved[] outlives each snapshot
+// so memory_ram_cow_preserve can test it without taking the lock.
+int g_ram_cow_active = 0;
+static struct {
+    pthread_mutex_t lock;
+    uint8_t *saved; // per RAM page: non-zero once the page has been preserved
+    uint8_t **copies; // per RAM page: contents at begin, or NULL while unwritten
+    size_t pages;
+    bool failed; // a page could not be preserved; the snapshot is unusable
+} g_ram_cow = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
 // Slow-path access counter (diagnostic; exposed as memory.slowpath_count)
 uint64_t g_mem_slowpath_count = 0;
 // 1 MB-granularity histogram of slow-path addresses (24-bit space = 16 buckets)
@@ -137,9 +176,10 @@ typedef struct memory {
     mapping_t *map;
 
     uint8_t *image; // flat RAM+ROM buffer
+    bool image_mmapped; // image came from mmap (a restore), release with munmap
 
     // Per-instance page table (points to g_page_table when active)
-    page_entry_t *page_table;
+    page_entry_t **page_table;
     int page_count;
 
     // Machine-parameterised sizes (set by memory_map_init)
@@ -158,6 +198,387 @@ typedef struct memory {
 
 } memory_map_t;
 
+// ============================================================================
+// Page Table Storage
+// ============================================================================
+// Directories hold g_page_count >> PAGE_LEAF_BITS slots (4 for a 24-bit map,
+// 1024 for a 32-bit one).  Private leaves are only freed at teardown.
+//
+// SoA tables keep, for every PAGE_LEAF_SIZE-page chunk, the range of entries
+// populated since the last clear and a list of the chunks that have one, so
+// memory_soa_clear never walks the whole address space.  Flat tables zero
+// those ranges on the spot.  GS_SPARSE_SOA tables only point the listed
+// slots back at the zero leaf and keep the leaves, so the MMU refill doesn't
+// reallocate them; a detached leaf zeroes its range when a miss-path store
+// reattaches it.
+
+// Populated range of one SoA chunk (with GS_SPARSE_SOA, its private leaf)
+typedef struct soa_leaf {
+#ifdef GS_SPARSE_SOA
+    uintptr_t *entries; // NULL until the slot's first non-zero store
+#endif
+    uint16_t lo, hi; // entries [lo, hi] may be non-zero; empty when lo > hi
+} soa_leaf_t;
+
+// SoA table: the entries the fast path indexes plus their chunk bookkeeping.
+// Tables are handed out as pointers to `table`.
+typedef struct soa_dir {
+    soa_leaf_t *leaves; // per-chunk populated range
+    uint16_t *attached; // chunks listed for the next clear
+    uint32_t attached_count;
+#ifdef GS_SPARSE_SOA
+    uintptr_t *table[]; // directory: private leaf or g_soa_zero_leaf
+#else
+    uintptr_t table[]; // g_page_count entries
+#endif
+} soa_dir_t;
+
+// Number of directory slots covering the current page count
+static uint32_t page_dir_slots(void) {
+    return (g_page_count + PAGE_LEAF_SIZE - 1) >> PAGE_LEAF_BITS;
+}
+
+// Allocate an AoS directory with every slot on the shared zero leaf
+static page_entry_t **page_dir_alloc(void) {
+    uint32_t slots = page_dir_slots();
+    page_entry_t **dir = (page_entry_t **)malloc(slots * sizeof(page_entry_t *));
+    GS_ASSERTF(dir != NULL, "memory_map_init: out of memory allocating page directory");
+    for (uint32_t i = 0; i < slots; i++)
+        dir[i] = g_page_zero_leaf;
+    return dir;
+}
+
+// Free an AoS directory and its private leaves
+static void page_dir_free(page_entry_t **dir, uint32_t slots) {
+    if (!dir)
+        return;
+    for (uint32_t i = 0; i < slots; i++)
+        if (dir[i] != g_page_zero_leaf)
+            free(dir[i]);
+    free(dir);
+}
+
+// Recover the SoA header from a table pointer
+static soa_dir_t *soa_dir_of(soa_table_t table) {
+    return (soa_dir_t *)((char *)table - offsetof(soa_dir_t, table));
+}
+
+// Bytes of the table the fast path indexes
+static size_t soa_table_size(void) {
+#ifdef GS_SPARSE_SOA
+    return page_dir_slots() * sizeof(uintptr_t *);
+#else
+    return (size_t)g_page_count * sizeof(uintptr_t);
+#endif
+}
+
+// Allocate an all-zero SoA table (GS_SPARSE_SOA: every slot on the zero leaf)
+static soa_table_t soa_dir_alloc(void) {
+    uint32_t slots = page_dir_slots();
+    soa_dir_t *dir = (soa_dir_t *)calloc(1, sizeof(soa_dir_t) + soa_table_size());
+    GS_ASSERTF(dir != NULL, "memory_map_init: out of memory allocating SoA table");
+    dir->leaves = (soa_leaf_t *)calloc(slots, sizeof(soa_leaf_t));
+    dir->attached = (uint16_t *)malloc(slots * sizeof(uint16_t));
+    GS_ASSERTF(dir->leaves && dir->attached, "memory_map_init: out of memory allocating SoA table");
+    for (uint32_t i = 0; i < slots; i++) {
+        dir->leaves[i].lo = PAGE_LEAF_SIZE;
+#ifdef GS_SPARSE_SOA
+        dir->table[i] = g_soa_zero_leaf;
+#endif
+    }
+    return dir->table;
+}
+
+// Free an SoA table and its private leaves
+static void soa_dir_free(soa_table_t table) {
+    if (!table)
+        return;
+    soa_dir_t *dir = soa_dir_of(table);
+#ifdef GS_SPARSE_SOA
+    uint32_t slots = page_dir_slots();
+    for (uint32_t i = 0; i < slots; i++)
+        free(dir->leaves[i].entries);
+#endif
+    free(dir->leaves);
+    free(dir->attached);
+    free(dir);
+}
+
+// Host bytes held by one SoA table (entries, bookkeeping and private leaves)
+static size_t soa_dir_bytes(soa_table_t table) {
+    if (!table)
+        return 0;
+    uint32_t slots = page_dir_slots();
+    size_t bytes = sizeof(soa_dir_t) + soa_table_size() + slots * (sizeof(soa_leaf_t) + sizeof(uint16_t));
+#ifdef GS_SPARSE_SOA
+    soa_dir_t *dir = soa_dir_of(table);
+    for (uint32_t i = 0; i < slots; i++)
+        if (dir->leaves[i].entries)
+            bytes += PAGE_LEAF_SIZE * sizeof(uintptr_t);
+#endif
+    return bytes;
+}
+
+// Entries of chunk s (GS_SPARSE_SOA: its private leaf)
+static uintptr_t *soa_chunk(soa_dir_t *dir, uint32_t s) {
+#ifdef GS_SPARSE_SOA
+    return dir->leaves[s].entries;
+#else
+    return dir->table + ((size_t)s << PAGE_LEAF_BITS);
+#endif
+}
+
+#ifdef GS_SPARSE_SOA
+// Point slot s at its private leaf, allocating it or zeroing what the last
+// generation left in it
+static void soa_leaf_attach(soa_dir_t *dir, uint32_t s) {
+    soa_leaf_t *leaf = &dir->leaves[s];
+    if (!leaf->entries) {
+        leaf->entries = (uintptr_t *)calloc(PAGE_LEAF_SIZE, sizeof(uintptr_t));
+        GS_ASSERTF(leaf->entries != NULL, "memory_soa_set: out of memory allocating SoA leaf");
+    } else if (leaf->lo <= leaf->hi) {
+        memset(leaf->entries + leaf->lo, 0, (size_t)(leaf->hi - leaf->lo + 1) * sizeof(uintptr_t));
+    }
+    leaf->lo = PAGE_LEAF_SIZE;
+    leaf->hi = 0;
+    dir->table[s] = leaf->entries;
+    dir->attached[dir->attached_count++] = (uint16_t)s;
+}
+#endif
+
+page_entry_t *memory_page_mut(uint32_t p) {
+    page_entry_t **slot = &g_page_table[p >> PAGE_LEAF_BITS];
+    if (*slot == g_page_zero_leaf) {
+        *slot = (page_entry_t *)calloc(PAGE_LEAF_SIZE, sizeof(page_entry_t));
+        GS_ASSERTF(*slot != NULL, "memory_page_mut: out of memory allocating page-table leaf");
+    }
+    return &(*slot)[p & PAGE_LEAF_MASK];
+}
+
+void memory_soa_set(soa_table_t table, uint32_t p, uintptr_t value) {
+    soa_dir_t *dir = soa_dir_of(table);
+    uint32_t s = p >> PAGE_LEAF_BITS;
+    uint32_t i = p & PAGE_LEAF_MASK;
+#ifdef GS_SPARSE_SOA
+    if (table[s] == g_soa_zero_leaf) {
+        if (value == 0)
+            return; // already zero
+        soa_leaf_attach(dir, s);
+    }
+    table[s][i] = value;
+#else
+    table[p] = value;
+#endif
+    if (value) {
+        soa_leaf_t *leaf = &dir->leaves[s];
+#ifndef GS_SPARSE_SOA
+        if (leaf->lo > leaf->hi)
+            dir->attached[dir->attached_count++] = (uint16_t)s;
+#endif
+        if (i < leaf->lo)
+            leaf->lo = (uint16_t)i;
+        if (i > leaf->hi)
+            leaf->hi = (uint16_t)i;
+        // Every fast-path write to a page goes through an entry installed here
+        if (table == g_supervisor_write || table == g_user_write)
+            memory_ram_mark_dirty((const void *)(value + ((uintptr_t)p << PAGE_SHIFT)), MEM_PAGE_SIZE);
+    }
+}
+
+void memory_soa_clear(soa_table_t table) {
+    if (!table)
+        return;
+    soa_dir_t *dir = soa_dir_of(table);
+    for (uint32_t k = 0; k < dir->attached_count; k++) {
+        uint32_t s = dir->attached[k];
+#ifdef GS_SPARSE_SOA
+        table[s] = g_soa_zero_leaf;
+#else
+        soa_leaf_t *leaf = &dir->leaves[s];
+        memset(soa_chunk(dir, s) + leaf->lo, 0, (size_t)(leaf->hi - leaf->lo + 1) * sizeof(uintptr_t));
+        leaf->lo = PAGE_LEAF_SIZE;
+        leaf->hi = 0;
+#endif
+    }
+    dir->attached_count = 0;
+}
+
+// Zero the entries of one write table that point into host range
+// [host, host + len) (other host pages, e.g. VRAM, keep their fills)
+static void soa_drop_host_entries(soa_table_t table, uintptr_t host, size_t len) {
+    if (!table)
+        return;
+    soa_dir_t *dir = soa_dir_of(table);
+    for (uint32_t k = 0; k < dir->attached_count; k++) {
+        uint32_t s = dir->attached[k];
+        soa_leaf_t *leaf = &dir->leaves[s];
+        uintptr_t *entries = soa_chunk(dir, s);
+        for (uint32_t i = leaf->lo; i <= leaf->hi && i < PAGE_LEAF_SIZE; i++) {
+            uintptr_t value = entries[i];
+            uintptr_t page = value + ((uintptr_t)((s << PAGE_LEAF_BITS) | i) << PAGE_SHIFT);
+            if (value && page - host < len)
+                entries[i] = 0;
+        }
+    }
+}
+
+void memory_ram_dirty_rearm(void) {
+    if (!g_ram_dirty)
+        return;
+    memset(g_ram_dirty, 0, (g_ram_dirty_size + MEM_PAGE_SIZE - 1) >> PAGE_SHIFT);
+    soa_drop_host_entries(g_supervisor_write, g_ram_dirty_host, g_ram_dirty_size);
+    soa_drop_host_entries(g_user_write, g_ram_dirty_host, g_ram_dirty_size);
+}
+
+code_block_t *memory_code_block_create(uint32_t p) {
+    if (g_code_block_drops[p] >= CODE_BLOCK_MAX_DROPS)
+        return NULL;
+    code_block_t *block = (code_block_t *)calloc(1, sizeof(code_block_t));
+    if (!block)
+        return NULL; // run the page from the opcode table
+    // From here on every store into the page misses the fast path, and the
+    // fill that reinstalls its write entry drops the block again
+    uintptr_t host = g_code_blocks_host + ((uintptr_t)p << PAGE_SHIFT);
+    soa_drop_host_entries(g_supervisor_write, host, MEM_PAGE_SIZE);
+    soa_drop_host_entries(g_user_write, host, MEM_PAGE_SIZE);
+    g_code_blocks[p] = block;
+    return block;
+}
+
+void memory_code_block_drop(uint32_t p) {
+    code_block_t *block = g_code_blocks[p];
+    if (!block)
+        return;
+    if (block == g_code_block) {
+        g_code_block = NULL;
+        memory_code_window_flush();
+    }
+    g_code_blocks[p] = NULL;
+    free(block);
+    if (g_code_block_drops[p] < CODE_BLOCK_MAX_DROPS)
+        g_code_block_drops[p]++;
+}
+
+void memory_code_blocks_flush(void) {
+    for (uint32_t p = 0; p < g_code_blocks_pages; p++) {
+        free(g_code_blocks[p]);
+        g_code_blocks[p] = NULL;
+    }
+    g_code_block = NULL;
+    memory_code_window_flush();
+}
+
+void memory_code_blocks_reset(const void *owner) {
+    memory_code_blocks_flush();
+    g_code_blocks_owner = owner;
+}
+
+void memory_ram_cow_preserve(uintptr_t off, uintptr_t last) {
+    for (uintptr_t p = off >> PAGE_SHIFT; p <= last >> PAGE_SHIFT; p++) {
+        if (__atomic_load_n(&g_ram_cow.saved[p], __ATOMIC_ACQUIRE))
+            continue;
+        pthread_mutex_lock(&g_ram_cow.lock);
+        if (g_ram_cow_active && !g_ram_cow.saved[p]) {
+            size_t base = (size_t)p << PAGE_SHIFT;
+            size_t len = g_ram_dirty_size - base < MEM_PAGE_SIZE ? g_ram_dirty_size - base : MEM_PAGE_SIZE;
+            uint8_t *copy = (uint8_t *)malloc(MEM_PAGE_SIZE);
+            if (copy)
+                memcpy(copy, (const uint8_t *)g_ram_dirty_host + base, len);
+            else
+                g_ram_cow.failed = true;
+            g_ram_cow.copies[p] = copy;
+            __atomic_store_n(&g_ram_cow.saved[p], 1, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&g_ram_cow.lock);
+    }
+}
+
+void memory_ram_cow_end(void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&g_ram_cow.lock);
+    if (g_ram_cow_active) {
+        __atomic_store_n(&g_ram_cow_active, 0, __ATOMIC_RELAXED);
+        for (size_t p = 0; p < g_ram_cow.pages; p++) {
+            free(g_ram_cow.copies[p]);
+            g_ram_cow.copies[p] = NULL;
+            __atomic_store_n(&g_ram_cow.saved[p], 0, __ATOMIC_RELAXED);
+        }
+        g_ram_cow.failed = false;
+    }
+    pthread_mutex_unlock(&g_ram_cow.lock);
+}
+
+// Free the snapshot bookkeeping (the RAM it describes is going away)
+static void ram_cow_free(void) {
+    memory_ram_cow_end(NULL);
+    free(g_ram_cow.saved);
+    free(g_ram_cow.copies);
+    g_ram_cow.saved = NULL;
+    g_ram_cow.copies = NULL;
+    g_ram_cow.pages = 0;
+}
+
+bool memory_ram_cow_begin(void) {
+    memory_ram_cow_end(NULL);
+    size_t pages = ((size_t)g_ram_dirty_size + MEM_PAGE_SIZE - 1) >> PAGE_SHIFT;
+    if (!g_ram_dirty || pages == 0)
+        return false;
+    if (pages != g_ram_cow.pages) {
+        ram_cow_free();
+        g_ram_cow.saved = (uint8_t *)calloc(pages, 1);
+        g_ram_cow.copies = (uint8_t **)calloc(pages, sizeof(uint8_t *));
+        if (!g_ram_cow.saved || !g_ram_cow.copies) {
+            ram_cow_free();
+            return false;
+        }
+        g_ram_cow.pages = pages;
+    }
+    // Every later store to RAM now passes through memory_ram_mark_dirty first
+    soa_drop_host_entries(g_supervisor_write, g_ram_dirty_host, g_ram_dirty_size);
+    soa_drop_host_entries(g_user_write, g_ram_dirty_host, g_ram_dirty_size);
+    __atomic_store_n(&g_ram_cow_active, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool memory_ram_cow_read(void *ctx, size_t off, uint8_t *dst, size_t len) {
+    (void)ctx;
+    if (off > g_ram_dirty_size || len > g_ram_dirty_size - off)
+        return false;
+    while (len > 0) {
+        size_t p = off >> PAGE_SHIFT;
+        size_t in_page = off & PAGE_MASK;
+        size_t n = MEM_PAGE_SIZE - in_page < len ? MEM_PAGE_SIZE - in_page : len;
+        // Under the lock an unpreserved page cannot be mid-store: the store
+        // would first have to preserve it
+        pthread_mutex_lock(&g_ram_cow.lock);
+        bool ok = g_ram_cow_active && !g_ram_cow.failed;
+        if (ok) {
+            const uint8_t *copy = g_ram_cow.copies[p];
+            memcpy(dst, copy ? copy + in_page : (const uint8_t *)g_ram_dirty_host + off, n);
+        }
+        pthread_mutex_unlock(&g_ram_cow.lock);
+        if (!ok)
+            return false;
+        off += n;
+        dst += n;
+        len -= n;
+    }
+    return true;
+}
+
+size_t memory_page_tables_bytes(void) {
+    if (!g_page_table)
+        return 0;
+    uint32_t slots = page_dir_slots();
+    size_t bytes = slots * sizeof(page_entry_t *);
+    for (uint32_t i = 0; i < slots; i++)
+        if (g_page_table[i] != g_page_zero_leaf)
+            bytes += PAGE_LEAF_SIZE * sizeof(page_entry_t);
+    bytes += soa_dir_bytes(g_supervisor_read) + soa_dir_bytes(g_supervisor_write);
+    bytes += soa_dir_bytes(g_user_read) + soa_dir_bytes(g_user_write);
+    return bytes;
+}
+
 // ============================================================================
 // Page Table Slow Paths
 // ============================================================================
@@ -168,7 +589,7 @@ typedef struct memory {
 
 // Forward declaration: lazy-install identity SoA for a host-backed page when
 // the MMU is disabled.  Defined further down in this file.
-static void rebuild_soa_page(uint32_t p);
+static void rebuild_soa_page(uint32_t p, bool write);
 
 // Returns true iff the page can take a direct identity host mapping under
 // the current state (MMU disabled, host-backed, not a device, no logpoint).
@@ -210,7 +631,7 @@ static bool logpoint_lookup(uint32_t addr, uint8_t **host_out, bool *writable_ou
         *host_out = base ? base + (phys_addr & PAGE_MASK) : NULL;
         *writable_out = base ? mmu_phys_is_writable(g_mmu, phys_addr) : false;
     } else {
-        page_entry_t *pe = &g_page_table[page];
+        const page_entry_t *pe = memory_page(page);
         *host_out = pe->host_base ? pe->host_base + (addr & PAGE_MASK) : NULL;
         *writable_out = pe->writable;
     }
@@ -264,11 +685,11 @@ uint8_t memory_read_uint8_slow(uint32_t addr) {
     g_mem_slowpath_count++;
     g_mem_slowpath_hist[(addr >> 20) & 0xF]++;
     // Lisa segment MMU owns translation, routing, and bus errors for Lisa/XL
-    // machines (its SoA stays empty so every access reaches here).
+    // machines (it fills the SoA itself for plain RAM/ROM pages).
     if (__builtin_expect(g_lisa_mmu != NULL, 0))
         return lisa_mmu_read8(addr, g_active_read == g_supervisor_read);
     uint32_t page = addr >> PAGE_SHIFT;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
     // Memory logpoint: page is forced to slow path but backed by RAM/ROM.
     // Read via the MMU-translated host pointer, then notify the hook.
     uint8_t *lp_host;
@@ -281,7 +702,7 @@ uint8_t memory_read_uint8_slow(uint32_t addr) {
     }
     // Lazy-install identity SoA for a host-backed page when the MMU is off.
     if (can_lazy_install(page, pe)) {
-        rebuild_soa_page(page);
+        rebuild_soa_page(page, false);
         return LOAD_BE8(pe->host_base + (addr & PAGE_MASK));
     }
     // Gate logical-device dispatch via dispatch_device_at_logical(): identity /
@@ -306,7 +727,7 @@ uint8_t memory_read_uint8_slow(uint32_t addr) {
         if (pe->dev && mmu_check_tt(g_mmu, addr, false, supervisor))
             return pe->dev->read_uint8(pe->dev_context, addr - pe->base_addr);
         if (mmu_handle_fault(g_mmu, addr, false, supervisor)) {
-            uintptr_t base = g_active_read[addr >> PAGE_SHIFT];
+            uintptr_t base = memory_soa_get(g_active_read, addr >> PAGE_SHIFT);
             if (base != 0)
                 return LOAD_BE8((uint8_t *)(base + addr));
             // SoA still 0: physical page is device, unmapped, or logpointed.
@@ -315,7 +736,7 @@ uint8_t memory_read_uint8_slow(uint32_t addr) {
             uint32_t phys = mmu_translate_debug(g_mmu, addr, supervisor);
             uint32_t phys_page = phys >> PAGE_SHIFT;
             if ((int)phys_page < g_page_count) {
-                page_entry_t *phys_pe = &g_page_table[phys_page];
+                const page_entry_t *phys_pe = memory_page(phys_page);
                 if (phys_pe->dev)
                     return phys_pe->dev->read_uint8(phys_pe->dev_context, phys - phys_pe->base_addr);
             }
@@ -359,7 +780,7 @@ uint16_t memory_read_uint16_slow(uint32_t addr) {
     if (__builtin_expect(g_lisa_mmu != NULL, 0))
         return lisa_mmu_read16(addr, g_active_read == g_supervisor_read);
     uint32_t page = addr >> PAGE_SHIFT;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
 
     // Memory logpoint: forced slow path on RAM/ROM page
     uint8_t *lp_host;
@@ -373,7 +794,7 @@ uint16_t memory_read_uint16_slow(uint32_t addr) {
 
     // Lazy-install identity SoA for in-page accesses to host-backed pages.
     if ((addr & PAGE_MASK) <= MEM_PAGE_SIZE - 2 && can_lazy_install(page, pe)) {
-        rebuild_soa_page(page);
+        rebuild_soa_page(page, false);
         return LOAD_BE16(pe->host_base + (addr & PAGE_MASK));
     }
 
@@ -391,13 +812,13 @@ uint16_t memory_read_uint16_slow(uint32_t addr) {
         if (pe->dev && mmu_check_tt(g_mmu, addr, false, supervisor))
             return pe->dev->read_uint16(pe->dev_context, addr - pe->base_addr);
         if (mmu_handle_fault(g_mmu, addr, false, supervisor)) {
-            uintptr_t base = g_active_read[addr >> PAGE_SHIFT];
+            uintptr_t base = memory_soa_get(g_active_read, addr >> PAGE_SHIFT);
             if (base != 0)
                 return LOAD_BE16((uint8_t *)(base + addr));
             uint32_t phys = mmu_translate_debug(g_mmu, addr, supervisor);
             uint32_t phys_page = phys >> PAGE_SHIFT;
             if ((int)phys_page < g_page_count) {
-                page_entry_t *phys_pe = &g_page_table[phys_page];
+                const page_entry_t *phys_pe = memory_page(phys_page);
                 if (phys_pe->dev)
                     return phys_pe->dev->read_uint16(phys_pe->dev_context, phys - phys_pe->base_addr);
             }
@@ -437,7 +858,7 @@ uint32_t memory_read_uint32_slow(uint32_t addr) {
     if (__builtin_expect(g_lisa_mmu != NULL, 0))
         return lisa_mmu_read32(addr, g_active_read == g_supervisor_read);
     uint32_t page = addr >> PAGE_SHIFT;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
 
     // Memory logpoint: forced slow path on RAM/ROM page
     uint8_t *lp_host;
@@ -451,7 +872,7 @@ uint32_t memory_read_uint32_slow(uint32_t addr) {
 
     // Lazy-install identity SoA for in-page accesses to host-backed pages.
     if ((addr & PAGE_MASK) <= MEM_PAGE_SIZE - 4 && can_lazy_install(page, pe)) {
-        rebuild_soa_page(page);
+        rebuild_soa_page(page, false);
         return LOAD_BE32(pe->host_base + (addr & PAGE_MASK));
     }
 
@@ -469,13 +890,13 @@ uint32_t memory_read_uint32_slow(uint32_t addr) {
         if (pe->dev && mmu_check_tt(g_mmu, addr, false, supervisor))
             return pe->dev->read_uint32(pe->dev_context, addr - pe->base_addr);
         if (mmu_handle_fault(g_mmu, addr, false, supervisor)) {
-            uintptr_t base = g_active_read[addr >> PAGE_SHIFT];
+            uintptr_t base = memory_soa_get(g_active_read, addr >> PAGE_SHIFT);
             if (base != 0)
                 return LOAD_BE32((uint8_t *)(base + addr));
             uint32_t phys = mmu_translate_debug(g_mmu, addr, supervisor);
             uint32_t phys_page = phys >> PAGE_SHIFT;
             if ((int)phys_page < g_page_count) {
-                page_entry_t *phys_pe = &g_page_table[phys_page];
+                const page_entry_t *phys_pe = memory_page(phys_page);
                 if (phys_pe->dev)
                     return phys_pe->dev->read_uint32(phys_pe->dev_context, phys - phys_pe->base_addr);
             }
@@ -534,7 +955,7 @@ uint8_t memory_debug_read_uint8(uint32_t addr) {
     uint32_t page = phys >> PAGE_SHIFT;
     if ((int)page >= g_page_count)
         return 0xFF;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
     if (pe->host_base)
         return LOAD_BE8(pe->host_base + (phys & PAGE_MASK));
     if (pe->dev)
@@ -554,7 +975,7 @@ uint16_t memory_debug_read_uint16(uint32_t addr) {
             return 0xFFFF;
         uint32_t page = phys >> PAGE_SHIFT;
         if ((int)page < g_page_count) {
-            page_entry_t *pe = &g_page_table[page];
+            const page_entry_t *pe = memory_page(page);
             if (pe->host_base)
                 return LOAD_BE16(pe->host_base + (phys & PAGE_MASK));
             if (pe->dev)
@@ -575,7 +996,7 @@ uint32_t memory_debug_read_uint32(uint32_t addr) {
             return 0xFFFFFFFFu;
         uint32_t page = phys >> PAGE_SHIFT;
         if ((int)page < g_page_count) {
-            page_entry_t *pe = &g_page_table[page];
+            const page_entry_t *pe = memory_page(page);
             if (pe->host_base)
                 return LOAD_BE32(pe->host_base + (phys & PAGE_MASK));
             if (pe->dev)
@@ -609,7 +1030,7 @@ void memory_debug_read_block(uint32_t addr, uint8_t *dst, uint32_t len) {
             if (ok) {
                 uint32_t page = phys >> PAGE_SHIFT;
                 if ((int)page < g_page_count) {
-                    page_entry_t *pe = &g_page_table[page];
+                    const page_entry_t *pe = memory_page(page);
                     if (pe->host_base && !pe->dev) {
                         memcpy(dst, pe->host_base + (phys & PAGE_MASK), chunk);
                         dst += chunk;
@@ -644,10 +1065,11 @@ bool memory_debug_write_uint8(uint32_t addr, uint8_t value) {
     uint32_t page = phys >> PAGE_SHIFT;
     if ((int)page >= g_page_count)
         return false;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
     if (pe->host_base) {
         if (!pe->writable)
             return false; // ROM/VROM — drop silently
+        memory_ram_mark_dirty(pe->host_base + (phys & PAGE_MASK), 1);
         STORE_BE8(pe->host_base + (phys & PAGE_MASK), value);
         return true;
     }
@@ -668,10 +1090,11 @@ bool memory_debug_write_uint16(uint32_t addr, uint16_t value) {
             return false;
         uint32_t page = phys >> PAGE_SHIFT;
         if ((int)page < g_page_count) {
-            page_entry_t *pe = &g_page_table[page];
+            const page_entry_t *pe = memory_page(page);
             if (pe->host_base) {
                 if (!pe->writable)
                     return false;
+                memory_ram_mark_dirty(pe->host_base + (phys & PAGE_MASK), 2);
                 STORE_BE16(pe->host_base + (phys & PAGE_MASK), value);
                 return true;
             }
@@ -697,10 +1120,11 @@ bool memory_debug_write_uint32(uint32_t addr, uint32_t value) {
             return false;
         uint32_t page = phys >> PAGE_SHIFT;
         if ((int)page < g_page_count) {
-            page_entry_t *pe = &g_page_table[page];
+            const page_entry_t *pe = memory_page(page);
             if (pe->host_base) {
                 if (!pe->writable)
                     return false;
+                memory_ram_mark_dirty(pe->host_base + (phys & PAGE_MASK), 4);
                 STORE_BE32(pe->host_base + (phys & PAGE_MASK), value);
                 return true;
             }
@@ -725,11 +1149,12 @@ void memory_write_uint8_slow(uint32_t addr, uint8_t value) {
         return;
     }
     uint32_t page = addr >> PAGE_SHIFT;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
     // Memory logpoint: forced slow path for RAM write on logged page
     uint8_t *lp_host;
     bool lp_writable;
     if (logpoint_lookup(addr, &lp_host, &lp_writable) && lp_host && lp_writable) {
+        memory_ram_mark_dirty(lp_host, 1);
         STORE_BE8(lp_host, value);
         if (g_mem_logpoint_hook)
             g_mem_logpoint_hook(addr, 1, value, true);
@@ -738,7 +1163,7 @@ void memory_write_uint8_slow(uint32_t addr, uint8_t value) {
     // Lazy-install identity SoA for a writable host-backed page when MMU off.
     // Read-only pages (ROM) still drop the write silently via the fall-through.
     if (can_lazy_install(page, pe)) {
-        rebuild_soa_page(page);
+        rebuild_soa_page(page, true);
         if (pe->writable)
             STORE_BE8(pe->host_base + (addr & PAGE_MASK), value);
         return;
@@ -766,7 +1191,7 @@ void memory_write_uint8_slow(uint32_t addr, uint8_t value) {
             return;
         }
         if (mmu_handle_fault(g_mmu, addr, true, supervisor)) {
-            uintptr_t base = g_active_write[addr >> PAGE_SHIFT];
+            uintptr_t base = memory_soa_get(g_active_write, addr >> PAGE_SHIFT);
             if (base != 0) {
                 STORE_BE8((uint8_t *)(base + addr), value);
                 return;
@@ -777,7 +1202,7 @@ void memory_write_uint8_slow(uint32_t addr, uint8_t value) {
             uint32_t phys = mmu_translate_debug(g_mmu, addr, supervisor);
             uint32_t phys_page = phys >> PAGE_SHIFT;
             if ((int)phys_page < g_page_count) {
-                page_entry_t *phys_pe = &g_page_table[phys_page];
+                const page_entry_t *phys_pe = memory_page(phys_page);
                 if (phys_pe->dev) {
                     phys_pe->dev->write_uint8(phys_pe->dev_context, phys - phys_pe->base_addr, value);
                     return;
@@ -786,6 +1211,7 @@ void memory_write_uint8_slow(uint32_t addr, uint8_t value) {
             // Re-check logpoint now that the fault has run — physical-space
             // logpoints are only detectable after mmu_translate_debug.
             if (logpoint_lookup(addr, &lp_host, &lp_writable) && lp_host && lp_writable) {
+                memory_ram_mark_dirty(lp_host, 1);
                 STORE_BE8(lp_host, value);
                 if (g_mem_logpoint_hook)
                     g_mem_logpoint_hook(addr, 1, value, true);
@@ -821,13 +1247,14 @@ void memory_write_uint16_slow(uint32_t addr, uint16_t value) {
         return;
     }
     uint32_t page = addr >> PAGE_SHIFT;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
 
     // Memory logpoint: forced slow path for RAM write on logged page
     uint8_t *lp_host;
     bool lp_writable;
     if ((addr & PAGE_MASK) <= MEM_PAGE_SIZE - 2 && logpoint_lookup(addr, &lp_host, &lp_writable) && lp_host &&
         lp_writable) {
+        memory_ram_mark_dirty(lp_host, 2);
         STORE_BE16(lp_host, value);
         if (g_mem_logpoint_hook)
             g_mem_logpoint_hook(addr, 2, value, true);
@@ -836,7 +1263,7 @@ void memory_write_uint16_slow(uint32_t addr, uint16_t value) {
 
     // Lazy-install identity SoA for in-page writes to host-backed pages.
     if ((addr & PAGE_MASK) <= MEM_PAGE_SIZE - 2 && can_lazy_install(page, pe)) {
-        rebuild_soa_page(page);
+        rebuild_soa_page(page, true);
         if (pe->writable)
             STORE_BE16(pe->host_base + (addr & PAGE_MASK), value);
         return;
@@ -858,7 +1285,7 @@ void memory_write_uint16_slow(uint32_t addr, uint16_t value) {
             return;
         }
         if (mmu_handle_fault(g_mmu, addr, true, supervisor)) {
-            uintptr_t base = g_active_write[addr >> PAGE_SHIFT];
+            uintptr_t base = memory_soa_get(g_active_write, addr >> PAGE_SHIFT);
             if (base != 0) {
                 STORE_BE16((uint8_t *)(base + addr), value);
                 return;
@@ -866,13 +1293,14 @@ void memory_write_uint16_slow(uint32_t addr, uint16_t value) {
             uint32_t phys = mmu_translate_debug(g_mmu, addr, supervisor);
             uint32_t phys_page = phys >> PAGE_SHIFT;
             if ((int)phys_page < g_page_count) {
-                page_entry_t *phys_pe = &g_page_table[phys_page];
+                const page_entry_t *phys_pe = memory_page(phys_page);
                 if (phys_pe->dev) {
                     phys_pe->dev->write_uint16(phys_pe->dev_context, phys - phys_pe->base_addr, value);
                     return;
                 }
             }
             if (logpoint_lookup(addr, &lp_host, &lp_writable) && lp_host && lp_writable) {
+                memory_ram_mark_dirty(lp_host, 2);
                 STORE_BE16(lp_host, value);
                 if (g_mem_logpoint_hook)
                     g_mem_logpoint_hook(addr, 2, value, true);
@@ -911,13 +1339,14 @@ void memory_write_uint32_slow(uint32_t addr, uint32_t value) {
         return;
     }
     uint32_t page = addr >> PAGE_SHIFT;
-    page_entry_t *pe = &g_page_table[page];
+    const page_entry_t *pe = memory_page(page);
 
     // Memory logpoint: forced slow path for RAM write on logged page
     uint8_t *lp_host;
     bool lp_writable;
     if ((addr & PAGE_MASK) <= MEM_PAGE_SIZE - 4 && logpoint_lookup(addr, &lp_host, &lp_writable) && lp_host &&
         lp_writable) {
+        memory_ram_mark_dirty(lp_host, 4);
         STORE_BE32(lp_host, value);
         if (g_mem_logpoint_hook)
             g_mem_logpoint_hook(addr, 4, value, true);
@@ -926,7 +1355,7 @@ void memory_write_uint32_slow(uint32_t addr, uint32_t value) {
 
     // Lazy-install identity SoA for in-page writes to host-backed pages.
     if ((addr & PAGE_MASK) <= MEM_PAGE_SIZE - 4 && can_lazy_install(page, pe)) {
-        rebuild_soa_page(page);
+        rebuild_soa_page(page, true);
         if (pe->writable)
             STORE_BE32(pe->host_base + (addr & PAGE_MASK), value);
         return;
@@ -948,7 +1377,7 @@ void memory_write_uint32_slow(uint32_t addr, uint32_t value) {
             return;
         }
         if (mmu_handle_fault(g_mmu, addr, true, supervisor)) {
-            uintptr_t base = g_active_write[addr >> PAGE_SHIFT];
+            uintptr_t base = memory_soa_get(g_active_write, addr >> PAGE_SHIFT);
             if (base != 0) {
                 STORE_BE32((uint8_t *)(base + addr), value);
                 return;
@@ -956,13 +1385,14 @@ void memory_write_uint32_slow(uint32_t addr, uint32_t value) {
             uint32_t phys = mmu_translate_debug(g_mmu, addr, supervisor);
             uint32_t phys_page = phys >> PAGE_SHIFT;
             if ((int)phys_page < g_page_count) {
-                page_entry_t *phys_pe = &g_page_table[phys_page];
+                const page_entry_t *phys_pe = memory_page(phys_page);
                 if (phys_pe->dev) {
                     phys_pe->dev->write_uint32(phys_pe->dev_context, phys - phys_pe->base_addr, value);
                     return;
                 }
             }
             if (logpoint_lookup(addr, &lp_host, &lp_writable) && lp_host && lp_writable) {
+                memory_ram_mark_dirty(lp_host, 4);
                 STORE_BE32(lp_host, value);
                 if (g_mem_logpoint_hook)
                     g_mem_logpoint_hook(addr, 4, value, true);
@@ -1037,11 +1467,13 @@ void memory_write(unsigned int size, uint32_t addr, uint32_t value) {
 // for host-backed pages when the MMU is disabled — replaces the eager-fill
 // loop that used to live in mmu_invalidate_tlb. Safe to call from anywhere;
 // no-ops when the page can't take a direct identity mapping (MMU enabled,
-// device page, unmapped page, or page covered by a memory logpoint).
-static void rebuild_soa_page(uint32_t p) {
+// device page, unmapped page, or page covered by a memory logpoint).  `write`
+// is false unless a store is waiting: a page with a decoded block then keeps
+// its write entries empty (see memory.h).
+static void rebuild_soa_page(uint32_t p, bool write) {
     if (p >= g_page_count)
         return;
-    page_entry_t *pe = &g_page_table[p];
+    const page_entry_t *pe = memory_page(p);
     // MMU-mapped pages rebuild themselves via mmu_handle_fault on next access.
     if (g_mmu && g_mmu->enabled)
         return;
@@ -1051,16 +1483,16 @@ static void rebuild_soa_page(uint32_t p) {
         return; // logpoint: must keep SoA = 0 to fire the hook on every access
     uint32_t guest_base = p << PAGE_SHIFT;
     uintptr_t adjusted = (uintptr_t)pe->host_base - guest_base;
-    tlb_track_page(p); // ensure the next mmu_invalidate_tlb zeroes this entry
+    memory_code_window_drop(p);
     if (g_supervisor_read)
-        g_supervisor_read[p] = adjusted;
+        memory_soa_set(g_supervisor_read, p, adjusted);
     if (g_user_read)
-        g_user_read[p] = adjusted;
-    if (pe->writable) {
+        memory_soa_set(g_user_read, p, adjusted);
+    if (pe->writable && (write || !memory_code_block_at(pe->host_base))) {
         if (g_supervisor_write)
-            g_supervisor_write[p] = adjusted;
+            memory_soa_set(g_supervisor_write, p, adjusted);
         if (g_user_write)
-            g_user_write[p] = adjusted;
+            memory_soa_set(g_user_write, p, adjusted);
     }
 }
 
@@ -1071,14 +1503,15 @@ void memory_logpoint_install(uint32_t start_page, uint32_t end_page) {
         if (g_mem_logpoint_page_count[p] < 0xFF)
             g_mem_logpoint_page_count[p]++;
         // Zero the SoA entries to force slow path for this page
+        memory_code_window_drop(p);
         if (g_supervisor_read)
-            g_supervisor_read[p] = 0;
+            memory_soa_set(g_supervisor_read, p, 0);
         if (g_supervisor_write)
-            g_supervisor_write[p] = 0;
+            memory_soa_set(g_supervisor_write, p, 0);
         if (g_user_read)
-            g_user_read[p] = 0;
+            memory_soa_set(g_user_read, p, 0);
         if (g_user_write)
-            g_user_write[p] = 0;
+            memory_soa_set(g_user_write, p, 0);
     }
 }
 
@@ -1089,7 +1522,7 @@ void memory_logpoint_uninstall(uint32_t start_page, uint32_t end_page) {
         if (g_mem_logpoint_page_count[p])
             g_mem_logpoint_page_count[p]--;
         if (g_mem_logpoint_page_count[p] == 0)
-            rebuild_soa_page(p);
+            rebuild_soa_page(p, false);
     }
 }
 
@@ -1105,14 +1538,15 @@ void memory_logpoint_install_phys(uint32_t start_page, uint32_t end_page) {
     // arrays.  All logical pages re-walk on next access, and the fill path
     // (mmu_fill_soa_entry) suppresses any alias hitting the watched physical.
     // One-time cost at install; fast-path unaffected once entries repopulate.
+    memory_code_window_flush();
     if (g_supervisor_read)
-        memset(g_supervisor_read, 0, (size_t)g_page_count * sizeof(uintptr_t));
+        memory_soa_clear(g_supervisor_read);
     if (g_supervisor_write)
-        memset(g_supervisor_write, 0, (size_t)g_page_count * sizeof(uintptr_t));
+        memory_soa_clear(g_supervisor_write);
     if (g_user_read)
-        memset(g_user_read, 0, (size_t)g_page_count * sizeof(uintptr_t));
+        memory_soa_clear(g_user_read);
     if (g_user_write)
-        memset(g_user_write, 0, (size_t)g_page_count * sizeof(uintptr_t));
+        memory_soa_clear(g_user_write);
 }
 
 void memory_logpoint_uninstall_phys(uint32_t start_page, uint32_t end_page) {
@@ -1153,21 +1587,23 @@ void memory_map_add(memory_map_t *mem, uint32_t addr, uint32_t size, const char
         assert(start_page < g_page_count && "device start address exceeds page table bounds");
         for (uint32_t p = start_page; p <= end_page && p < g_page_count; p++) {
             // AoS cold-path: register device handler
-            g_page_table[p].host_base = NULL;
-            g_page_table[p].dev = &map->memory_interface;
-            g_page_table[p].dev_context = device;
-            g_page_table[p].base_addr = addr;
-            g_page_table[p].writable = false;
+            page_entry_t *pe = memory_page_mut(p);
+            pe->host_base = NULL;
+            pe->dev = &map->memory_interface;
+            pe->dev_context = device;
+            pe->base_addr = addr;
+            pe->writable = false;
 
             // SoA fast-path: zero entries force slow path for device I/O
+            memory_code_window_drop(p);
             if (g_supervisor_read)
-                g_supervisor_read[p] = 0;
+                memory_soa_set(g_supervisor_read, p, 0);
             if (g_supervisor_write)
-                g_supervisor_write[p] = 0;
+                memory_soa_set(g_supervisor_write, p, 0);
             if (g_user_read)
-                g_user_read[p] = 0;
+                memory_soa_set(g_user_read, p, 0);
             if (g_user_write)
-                g_user_write[p] = 0;
+                memory_soa_set(g_user_write, p, 0);
         }
     }
 }
@@ -1181,12 +1617,13 @@ static void clear_page_table_for_mapping(uint32_t addr, uint32_t size, const mem
     uint32_t start_page = (addr & g_address_mask) >> PAGE_SHIFT;
     uint32_t end_page = ((addr + size - 1) & g_address_mask) >> PAGE_SHIFT;
     for (uint32_t p = start_page; p <= end_page && p < g_page_count; p++) {
-        if (g_page_table[p].dev == iface_ptr) {
-            g_page_table[p].host_base = NULL;
-            g_page_table[p].dev = NULL;
-            g_page_table[p].dev_context = NULL;
-            g_page_table[p].base_addr = 0;
-            g_page_table[p].writable = false;
+        if (memory_page(p)->dev == iface_ptr) {
+            page_entry_t *pe = memory_page_mut(p);
+            pe->host_base = NULL;
+            pe->dev = NULL;
+            pe->dev_context = NULL;
+            pe->base_addr = 0;
+            pe->writable = false;
         }
     }
 }
@@ -1256,6 +1693,7 @@ size_t memory_install_rom(memory_map_t *mem, const uint8_t *data, size_t size, c
         return 0;
     size_t copy_size = size < mem->rom_size ? size : mem->rom_size;
     memcpy(mem->image + mem->ram_size, data, copy_size);
+    memory_code_blocks_flush();
     calculate_checksum(mem);
     if (mem->rom_filename) {
         free(mem->rom_filename);
@@ -1291,6 +1729,7 @@ uint32_t memory_rom_checksum(memory_map_t *mem) {
 void memory_populate_pages(memory_map_t *mem, uint32_t rom_start_addr, uint32_t rom_region_end) {
     if (!g_page_table || !mem->image)
         return;
+    memory_code_window_flush();
 
     uint32_t ram_size = mem->ram_size;
     uint32_t rom_size = mem->rom_size;
@@ -1304,20 +1743,21 @@ void memory_populate_pages(memory_map_t *mem, uint32_t rom_start_addr, uint32_t
         uintptr_t adjusted = (uintptr_t)host_ptr - guest_base;
 
         // AoS cold-path entry (device dispatch)
-        g_page_table[p].host_base = host_ptr;
-        g_page_table[p].dev = NULL;
-        g_page_table[p].dev_context = NULL;
-        g_page_table[p].writable = true;
+        page_entry_t *pe = memory_page_mut(p);
+        pe->host_base = host_ptr;
+        pe->dev = NULL;
+        pe->dev_context = NULL;
+        pe->writable = true;
 
         // SoA fast-path entries: RAM is readable and writable by all
         if (g_supervisor_read)
-            g_supervisor_read[p] = adjusted;
+            memory_soa_set(g_supervisor_read, p, adjusted);
         if (g_supervisor_write)
-            g_supervisor_write[p] = adjusted;
+            memory_soa_set(g_supervisor_write, p, adjusted);
         if (g_user_read)
-            g_user_read[p] = adjusted;
+            memory_soa_set(g_user_read, p, adjusted);
         if (g_user_write)
-            g_user_write[p] = adjusted;
+            memory_soa_set(g_user_write, p, adjusted);
     }
 
     // ROM pages: rom_start_addr – rom_region_end (read-only, mirrored)
@@ -1344,16 +1784,17 @@ void memory_populate_pages(memory_map_t *mem, uint32_t rom_start_addr, uint32_t
         uintptr_t adjusted = (uintptr_t)host_ptr - guest_base;
 
         // AoS cold-path entry
-        g_page_table[p].host_base = host_ptr;
-        g_page_table[p].dev = NULL;
-        g_page_table[p].dev_context = NULL;
-        g_page_table[p].writable = false;
+        page_entry_t *pe = memory_page_mut(p);
+        pe->host_base = host_ptr;
+        pe->dev = NULL;
+        pe->dev_context = NULL;
+        pe->writable = false;
 
         // SoA fast-path entries: ROM is read-only (write entries stay 0 → slow path)
         if (g_supervisor_read)
-            g_supervisor_read[p] = adjusted;
+            memory_soa_set(g_supervisor_read, p, adjusted);
         if (g_user_read)
-            g_user_read[p] = adjusted;
+            memory_soa_set(g_user_read, p, adjusted);
     }
 }
 
@@ -1370,6 +1811,7 @@ void memory_populate_ram_mirror(memory_map_t *mem, uint32_t mirror_start, uint32
         return;
     if (mirror_end <= mirror_start)
         return;
+    memory_code_window_flush();
 
     uint32_t ram_size = mem->ram_size;
     uint32_t start_page = (mirror_start & g_address_mask) >> PAGE_SHIFT;
@@ -1383,20 +1825,21 @@ void memory_populate_ram_mirror(memory_map_t *mem, uint32_t mirror_start, uint32
 
         // AoS cold-path entry: same RAM image, just aliased at a different
         // guest base.  Marked writable so the slow path treats it like RAM.
-        g_page_table[p].host_base = host_ptr;
-        g_page_table[p].dev = NULL;
-        g_page_table[p].dev_context = NULL;
-        g_page_table[p].writable = true;
+        page_entry_t *pe = memory_page_mut(p);
+        pe->host_base = host_ptr;
+        pe->dev = NULL;
+        pe->dev_context = NULL;
+        pe->writable = true;
 
         // SoA fast-path: full read+write on both supervisor and user sides.
         if (g_supervisor_read)
-            g_supervisor_read[p] = adjusted;
+            memory_soa_set(g_supervisor_read, p, adjusted);
         if (g_supervisor_write)
-            g_supervisor_write[p] = adjusted;
+            memory_soa_set(g_supervisor_write, p, adjusted);
         if (g_user_read)
-            g_user_read[p] = adjusted;
+            memory_soa_set(g_user_read, p, adjusted);
         if (g_user_write)
-            g_user_write[p] = adjusted;
+            memory_soa_set(g_user_write, p, adjusted);
     }
 }
 
@@ -1425,9 +1868,22 @@ memory_map_t *memory_map_init(int address_bits, uint32_t ram_size, uint32_t rom_
     mem->ram_size = ram_size;
     mem->rom_size = rom_size;
 
-    // Allocate the flat RAM+ROM image (ram_size + rom_size bytes)
+    // Allocate the flat RAM+ROM image (ram_size + rom_size bytes).  A restore
+    // on a host with mmap takes anonymous pages so a mapped checkpoint RAM
+    // block can replace the front of the image in place.
     size_t image_size = (size_t)ram_size + (size_t)rom_size;
-    mem->image = calloc(1, image_size);
+    mem->image = NULL;
+#ifndef __EMSCRIPTEN__
+    if (checkpoint) {
+        void *image = mmap(NULL, image_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (image != MAP_FAILED) {
+            mem->image = (uint8_t *)image;
+            mem->image_mmapped = true;
+        }
+    }
+#endif
+    if (!mem->image)
+        mem->image = calloc(1, image_size);
     GS_ASSERTF(mem->image != NULL, "memory_map_init: out of memory allocating %zu-byte image", image_size);
 
     // Allocate page table sized for the given address space
@@ -1440,18 +1896,16 @@ memory_map_t *memory_map_init(int address_bits, uint32_t ram_size, uint32_t rom_
         g_page_count = 1 << (24 - PAGE_SHIFT); // 4,096 pages
     }
 
-    // AoS cold-path page table (device dispatch)
-    g_page_table = (page_entry_t *)calloc(g_page_count, sizeof(page_entry_t));
-    assert(g_page_table != NULL && "failed to allocate page table");
+    // AoS cold-path page table (device dispatch); leaves materialise on population
+    g_page_table = page_dir_alloc();
     mem->page_table = g_page_table;
     mem->page_count = g_page_count;
 
-    // SoA fast-path arrays (calloc → zero = slow path for all pages initially)
-    g_supervisor_read = (uintptr_t *)calloc(g_page_count, sizeof(uintptr_t));
-    g_supervisor_write = (uintptr_t *)calloc(g_page_count, sizeof(uintptr_t));
-    g_user_read = (uintptr_t *)calloc(g_page_count, sizeof(uintptr_t));
-    g_user_write = (uintptr_t *)calloc(g_page_count, sizeof(uintptr_t));
-    assert(g_supervisor_read && g_supervisor_write && g_user_read && g_user_write);
+    // SoA fast-path tables (shared zero leaf → slow path for all pages initially)
+    g_supervisor_read = soa_dir_alloc();
+    g_supervisor_write = soa_dir_alloc();
+    g_user_read = soa_dir_alloc();
+    g_user_write = soa_dir_alloc();
 
     // Memory logpoint reference-count array (zero = no logpoint on that page)
     g_mem_logpoint_page_count = (uint8_t *)calloc(g_page_count, sizeof(uint8_t));
@@ -1462,17 +1916,34 @@ memory_map_t *memory_map_init(int address_bits, uint32_t ram_size, uint32_t rom_
     g_mem_logpoint_phys_page_count = (uint8_t *)calloc(g_page_count, sizeof(uint8_t));
     assert(g_mem_logpoint_phys_page_count);
 
+    // RAM dirty-page map, all-dirty until the first quick checkpoint rearms it
+    size_t ram_pages = ((size_t)ram_size + MEM_PAGE_SIZE - 1) >> PAGE_SHIFT;
+    g_ram_dirty = (uint8_t *)malloc(ram_pages ? ram_pages : 1);
+    assert(g_ram_dirty);
+    memset(g_ram_dirty, 1, ram_pages);
+    g_ram_dirty_host = (uintptr_t)mem->image;
+    g_ram_dirty_size = ram_size;
+
+    // Decoded-page cache: no blocks until a decoder claims it
+    g_code_blocks_pages = (uint32_t)((image_size + MEM_PAGE_SIZE - 1) >> PAGE_SHIFT);
+    g_code_blocks = (code_block_t **)calloc(g_code_blocks_pages ? g_code_blocks_pages : 1, sizeof(code_block_t *));
+    g_code_block_drops = (uint8_t *)calloc(g_code_blocks_pages ? g_code_blocks_pages : 1, 1);
+    assert(g_code_blocks && g_code_block_drops);
+    g_code_blocks_host = (uintptr_t)mem->image;
+    g_code_blocks_owner = NULL;
+
     // Default active pointers: supervisor mode
     g_active_read = g_supervisor_read;
     g_active_write = g_supervisor_write;
+    memory_code_window_flush();
 
     // Note: rom command is registered once from setup_init() so it's
     // available before any machine is created (deferred boot).
 
     // Load from checkpoint if provided
     if (checkpoint) {
-        // Restore RAM
-        system_read_checkpoint_data(checkpoint, mem->image, ram_size);
+        // Restore RAM (mapped from the file when it was saved in the mapped layout)
+        checkpoint_read_ram(checkpoint, mem->image, ram_size, mem->image_mmapped);
         // Restore ROM (content or reference)
         char *restored_path = NULL;
         size_t got = checkpoint_read_file(checkpoint, mem->image + ram_size, rom_size, &restored_path);
@@ -1513,6 +1984,8 @@ memory_map_t *memory_map_init(int address_bits, uint32_t ram_size, uint32_t rom_
 void memory_map_delete(memory_map_t *mem) {
     if (!mem)
         return;
+    // A background checkpoint may still be reading this RAM
+    checkpoint_async_wait();
     if (mem->peek_object) {
         object_detach(mem->peek_object);
         object_delete(mem->peek_object);
@@ -1542,32 +2015,51 @@ void memory_map_delete(memory_map_t *mem) {
         // Only clear globals if this instance owns the active page table
         if (g_page_table == mem->page_table) {
             g_page_table = NULL;
-            g_page_count = 0;
 
-            // Free SoA fast-path arrays
-            free(g_supervisor_read);
+            // Free SoA fast-path tables (sized by g_page_count, so before it is cleared)
+            soa_dir_free(g_supervisor_read);
             g_supervisor_read = NULL;
-            free(g_supervisor_write);
+            soa_dir_free(g_supervisor_write);
             g_supervisor_write = NULL;
-            free(g_user_read);
+            soa_dir_free(g_user_read);
             g_user_read = NULL;
-            free(g_user_write);
+            soa_dir_free(g_user_write);
             g_user_write = NULL;
+            g_page_count = 0;
             g_active_read = NULL;
             g_active_write = NULL;
+            memory_code_window_flush();
 
             // Free logpoint page-count arrays
             free(g_mem_logpoint_page_count);
             g_mem_logpoint_page_count = NULL;
             free(g_mem_logpoint_phys_page_count);
             g_mem_logpoint_phys_page_count = NULL;
+            ram_cow_free();
+            free(g_ram_dirty);
+            g_ram_dirty = NULL;
+            g_ram_dirty_host = 0;
+            g_ram_dirty_size = 0;
+            memory_code_blocks_flush();
+            free(g_code_blocks);
+            g_code_blocks = NULL;
+            free(g_code_block_drops);
+            g_code_block_drops = NULL;
+            g_code_blocks_host = 0;
+            g_code_blocks_pages = 0;
+            g_code_blocks_owner = NULL;
         }
-        free(mem->page_table);
+        page_dir_free(mem->page_table, ((uint32_t)mem->page_count + PAGE_LEAF_SIZE - 1) >> PAGE_LEAF_BITS);
         mem->page_table = NULL;
     }
     // Free RAM/ROM image buffer
     if (mem->image) {
-        free(mem->image);
+#ifndef __EMSCRIPTEN__
+        if (mem->image_mmapped)
+            munmap(mem->image, (size_t)mem->ram_size + (size_t)mem->rom_size);
+        else
+#endif
+            free(mem->image);
         mem->image = NULL;
     }
     // Free ROM filename if present
@@ -1587,8 +2079,21 @@ void memory_map_checkpoint(memory_map_t *restrict mem, checkpoint_t *checkpoint)
     if (!mem || !checkpoint)
         return;
 
-    // Write RAM contents
-    system_write_checkpoint_data(checkpoint, mem->image, mem->ram_size);
+    // Write RAM contents; a quick checkpoint that extends an existing chain
+    // stores only the pages marked since the previous quick checkpoint.  An
+    // asynchronous save defers RAM to its writer thread, which reads it from
+    // a copy-on-write snapshot while the guest runs on.
+    if (checkpoint_is_async(checkpoint) && mem->image == (uint8_t *)g_ram_dirty_host && memory_ram_cow_begin()) {
+        checkpoint_write_ram_deferred(checkpoint, mem->ram_size, g_ram_dirty, memory_ram_cow_read, memory_ram_cow_end,
+                                      NULL);
+        // The snapshot dropped the RAM write entries, which completes a rearm
+        if (checkpoint_get_kind(checkpoint) == CHECKPOINT_KIND_QUICK)
+            memset(g_ram_dirty, 0, ((size_t)g_ram_dirty_size + MEM_PAGE_SIZE - 1) >> PAGE_SHIFT);
+    } else {
+        checkpoint_write_ram(checkpoint, mem->image, mem->ram_size, g_ram_dirty);
+        if (checkpoint_get_kind(checkpoint) == CHECKPOINT_KIND_QUICK)
+            memory_ram_dirty_rearm();
+    }
 
     // Write ROM: either inline contents (default) or by filename reference depending on save mode
     checkpoint_write_file(checkpoint, mem->rom_filename ? mem->rom_filename : "");
@@ -1746,7 +2251,7 @@ static value_t method_mem_translate(struct object *self, const member_t *m, int
         uint32_t page = addr >> PAGE_SHIFT;
         const char *backing = "unmapped";
         if ((int)page < g_page_count) {
-            page_entry_t *pe = &g_page_table[page];
+            const page_entry_t *pe = memory_page(page);
             backing = pe->host_base ? "ram/rom" : (pe->dev ? "device" : "unmapped");
         }
         snprintf(buf, sizeof(buf), "mmu=off phys=0x%08x backing=%s", addr, backing);
@@ -1758,7 +2263,7 @@ static value_t method_mem_translate(struct object *self, const member_t *m, int
     const char *backing_s = "unmapped";
     uint32_t page_s = pa_s >> PAGE_SHIFT;
     if (ok_s && (int)page_s < g_page_count) {
-        page_entry_t *pe = &g_page_table[page_s];
+        const page_entry_t *pe = memory_page(page_s);
         backing_s = pe->host_base ? "ram/rom" : (pe->dev ? "device" : "unmapped");
     }
     snprintf(buf, sizeof(buf), "mmu=on super=%s phys_s=0x%08x user=%s phys_u=0x%08x backing_s=%s",
@@ -1776,6 +2281,12 @@ static value_t attr_mem_slowpath_count(struct object *self, const member_t *m) {
     return val_uint(8, g_mem_slowpath_count);
 }
 
+static value_t attr_mem_table_bytes(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(8, memory_page_tables_bytes());
+}
+
 static value_t attr_mem_slowpath_hist(struct object *self, const member_t *m) {
     (void)self;
     (void)m;
@@ -1806,6 +2317,11 @@ static const member_t memory_members[] = {
      .name = "rom_size",
      .flags = VAL_RO,
      .attr = {.type = V_UINT, .get = attr_mem_rom_size, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "table_bytes",
+     .flags = VAL_RO,
+     .doc = "Host bytes held by the sparse page table and SoA tables (directories plus populated leaves)",
+     .attr = {.type = V_UINT, .get = attr_mem_table_bytes, .set = NULL}},
     {.kind = M_METHOD,
      .name = "read_cstring",
      .doc = "Read a quoted, escape-encoded C string at addr",
@@ -133,8 +133,28 @@ typedef struct page_entry {
     bool writable; // true for RAM pages, false for ROM/I/O
 } page_entry_t;
 
+// The AoS page table is two-level: a directory of PAGE_LEAF_SIZE-entry
+// leaves.  Directory slots whose pages are all empty share one read-only
+// all-zero leaf, so a 32-bit map only pays for the leaves it populates.
+// Readers index through both levels; writers go through memory_page_mut,
+// which materialises a private leaf on the first non-zero store.
+//
+// The four SoA fast-path tables are flat arrays indexed by page number, so
+// every fast-path access costs one table load.  Building with GS_SPARSE_SOA
+// gives them the same two-level layout as the AoS (a few hundred KB instead
+// of 32 MB on a 32-bit map) at the price of a second dependent load.
+#define PAGE_LEAF_BITS 10
+#define PAGE_LEAF_SIZE (1u << PAGE_LEAF_BITS) // 1024 pages = 4 MB of address space
+#define PAGE_LEAF_MASK (PAGE_LEAF_SIZE - 1)
+
+#ifdef GS_SPARSE_SOA
+typedef uintptr_t **soa_table_t; // directory of PAGE_LEAF_SIZE-entry leaves
+#else
+typedef uintptr_t *soa_table_t; // one entry per page
+#endif
+
 // Global page table and address mask (set by memory_map_init)
-extern page_entry_t *g_page_table;
+extern page_entry_t **g_page_table;
 extern uint32_t g_address_mask; // 0x00FFFFFF for 24-bit, 0xFFFFFFFF for 32-bit
 extern uint32_t g_page_count; // total number of pages in the current page table
 
@@ -142,14 +162,45 @@ extern uint32_t g_page_count; // total number of pages in the current page table
 // Each entry stores an adjusted host address: (uintptr_t)host_base - page_guest_base
 // so that (uint8_t *)(entry + masked_addr) yields the correct host pointer directly.
 // Zero entry = slow path (device I/O, unmapped, or MMU miss).
-extern uintptr_t *g_supervisor_read; // supervisor-mode read mapping
-extern uintptr_t *g_supervisor_write; // supervisor-mode write mapping (RAM only)
-extern uintptr_t *g_user_read; // user-mode read mapping
-extern uintptr_t *g_user_write; // user-mode write mapping
+extern soa_table_t g_supervisor_read; // supervisor-mode read mapping
+extern soa_table_t g_supervisor_write; // supervisor-mode write mapping (RAM only)
+extern soa_table_t g_user_read; // user-mode read mapping
+extern soa_table_t g_user_write; // user-mode write mapping
 
 // Active pointers switched per sprint based on SR.S bit
-extern uintptr_t *g_active_read;
-extern uintptr_t *g_active_write;
+extern soa_table_t g_active_read;
+extern soa_table_t g_active_write;
+
+// AoS entry for page p (read-only: unpopulated pages alias the shared zero leaf)
+static inline const page_entry_t *memory_page(uint32_t p) {
+    return &g_page_table[p >> PAGE_LEAF_BITS][p & PAGE_LEAF_MASK];
+}
+
+// Writable AoS entry for page p (materialises its leaf on first use)
+page_entry_t *memory_page_mut(uint32_t p);
+
+// SoA entry for page p in one of the four tables
+static inline uintptr_t memory_soa_get(soa_table_t table, uint32_t p) {
+#ifdef GS_SPARSE_SOA
+    return table[p >> PAGE_LEAF_BITS][p & PAGE_LEAF_MASK];
+#else
+    return table[p];
+#endif
+}
+
+// Store an SoA entry (GS_SPARSE_SOA: storing 0 into an unpopulated leaf
+// allocates nothing)
+void memory_soa_set(soa_table_t table, uint32_t p, uintptr_t value);
+
+// Zero every entry of an SoA table.  Each table tracks the populated range of
+// every PAGE_LEAF_SIZE-page chunk, so the cost follows what was filled since
+// the last clear, not the size of the address space.  GS_SPARSE_SOA detaches
+// the leaves instead (O(leaves in use)); each is wiped lazily when a later
+// store reattaches it.
+void memory_soa_clear(soa_table_t table);
+
+// Host bytes held by the AoS and SoA tables and their bookkeeping
+size_t memory_page_tables_bytes(void);
 
 // Deferred bus error: slow paths signal unmapped MMU accesses by setting
 // the pending flag AND zeroing *g_bus_error_instr_ptr, which forces the
@@ -245,6 +296,10 @@ void memory_write_uint8_slow(uint32_t addr, uint8_t value);
 void memory_write_uint16_slow(uint32_t addr, uint16_t value);
 void memory_write_uint32_slow(uint32_t addr, uint32_t value);
 
+// Count of slow-path accesses since start (diagnostic, and the idle-loop
+// detector's proof that a polling loop touched nothing but RAM/ROM)
+extern uint64_t g_mem_slowpath_count;
+
 // Side-effect-free reads for debug/inspection commands (memory.peek/.dump,
 // find.*): translate via mmu_translate_checked, read host RAM/ROM or dispatch
 // the device read, return all-ones for unmapped/invalid, and NEVER fault,
@@ -318,13 +373,151 @@ void memory_logpoint_uninstall(uint32_t start_page, uint32_t end_page);
 void memory_logpoint_install_phys(uint32_t start_page, uint32_t end_page);
 void memory_logpoint_uninstall_phys(uint32_t start_page, uint32_t end_page);
 
+// === Decoded-Page Cache ===
+// The table decoder (cpu_dispatch.h) keeps a decoded block for each page of
+// the RAM+ROM image it executes from.  A block holds, per instruction
+// halfword, the OP site that decode reached and the opcode/extension longword
+// it decoded, so a repeat execution needs neither the fetch nor the table
+// lookup.  Blocks are keyed by host page, so every logical alias of a page
+// (MMU mappings, 24-bit mirrors) shares one block.
+//
+// A block is valid only while its page is unchanged.  Creating it zeroes the
+// write-table entries that point into the page, so a guest store to it misses;
+// whichever fill path then reinstalls the entry goes through memory_soa_set,
+// which marks the page dirty.  Every other store that bypasses the write
+// tables already calls memory_ram_mark_dirty (see below), and marking a page
+// dirty drops its block.  Read fills leave the write entries of a page with a
+// block alone, so a TLB refill does not drop code that was never written.  A
+// page whose block has been dropped CODE_BLOCK_MAX_DROPS times (code sharing
+// a page with live data) is left uncached and runs from the opcode table.
+
+#define CODE_BLOCK_SLOTS     (MEM_PAGE_SIZE / 2) // one per instruction halfword
+#define CODE_BLOCK_MAX_DROPS 16 // drops after which a page stays uncached
+
+typedef struct code_block {
+    const void *site[CODE_BLOCK_SLOTS]; // decoded entry point, NULL = not decoded yet
+    uint32_t fetch[CODE_BLOCK_SLOTS]; // opcode and first extension word at the halfword
+} code_block_t;
+
+extern code_block_t **g_code_blocks; // per image page, NULL = no block
+extern uintptr_t g_code_blocks_host; // host address of image offset 0 (RAM first)
+extern uint32_t g_code_blocks_pages; // image pages covered by g_code_blocks
+extern const void *g_code_blocks_owner; // decoder that filled the blocks (NULL = cache off)
+extern code_block_t *g_code_block; // block for the code window's page (NULL = none)
+
+// Create the block for image page p (NULL if the page is left uncached)
+code_block_t *memory_code_block_create(uint32_t p);
+
+// Drop the block for image page p (its contents are about to change)
+void memory_code_block_drop(uint32_t p);
+
+// Drop every block (image rewritten wholesale, or a new owner)
+void memory_code_blocks_flush(void);
+
+// Drop every block and hand the cache to a decoder (NULL turns it off)
+void memory_code_blocks_reset(const void *owner);
+
+// Called by a decoder at sprint entry: blocks filled by another decoder hold
+// that decoder's entry points, so a change of owner starts over
+static inline void memory_code_blocks_claim(const void *owner) {
+    if (__builtin_expect(g_code_blocks_owner != owner, 0))
+        memory_code_blocks_reset(owner);
+}
+
+// Block for the host page starting at host, created on first use (NULL when
+// the page lies outside the image or is left uncached)
+static inline code_block_t *memory_code_block_lookup(uintptr_t host) {
+    uintptr_t p = (host - g_code_blocks_host) >> PAGE_SHIFT;
+    if (p >= g_code_blocks_pages)
+        return NULL;
+    code_block_t *block = g_code_blocks[p];
+    return block ? block : memory_code_block_create((uint32_t)p);
+}
+
+// True if the host page containing host has a block (read fills then leave
+// its write entries empty)
+static inline bool memory_code_block_at(const void *host) {
+    uintptr_t p = ((uintptr_t)host - g_code_blocks_host) >> PAGE_SHIFT;
+    return p < g_code_blocks_pages && g_code_blocks[p] != NULL;
+}
+
+// === RAM Dirty-Page Tracking ===
+// Quick checkpoints store only the RAM pages written since the previous quick
+// checkpoint.  Like memory logpoints, tracking costs the fast path nothing:
+// memory_ram_dirty_rearm clears the marks and zeroes every write-table entry
+// that points into RAM, so the first write to a clean page misses; whichever
+// fill path reinstalls its entry goes through memory_soa_set, which marks the
+// page.  Stores that bypass the write tables (slow-path logpoint stores, Lisa
+// RAM, debug pokes, physical writes, DMA) call memory_ram_mark_dirty before
+// they store.  Marks may over-approximate (a read miss that also fills the
+// write entry marks the page); they never miss a written page.  Marking a
+// page also drops its decoded block (see above).
+
+// One byte per 4 KB RAM page, non-zero = written since the last rearm.  Starts
+// all-dirty, since nothing is known about writes before the first rearm.
+extern uint8_t *g_ram_dirty;
+extern uintptr_t g_ram_dirty_host; // host address of RAM offset 0
+extern uint32_t g_ram_dirty_size; // RAM bytes covered by g_ram_dirty
+
+// Non-zero while a copy-on-write RAM snapshot is open (see below)
+extern int g_ram_cow_active;
+
+// Preserve the snapshot copy of the RAM pages overlapping [off, last]
+void memory_ram_cow_preserve(uintptr_t off, uintptr_t last);
+
+// Mark the RAM pages overlapping [host, host + len) as about to be written
+// (no-op outside RAM).  Call before the store, so an open snapshot can keep
+// the old contents.
+static inline void memory_ram_mark_dirty(const void *host, size_t len) {
+    uintptr_t off = (uintptr_t)host - g_ram_dirty_host;
+    if (!g_ram_dirty || off >= g_ram_dirty_size || len == 0)
+        return;
+    uintptr_t last = off + len - 1;
+    if (last >= g_ram_dirty_size)
+        last = g_ram_dirty_size - 1;
+    if (__atomic_load_n(&g_ram_cow_active, __ATOMIC_RELAXED))
+        memory_ram_cow_preserve(off, last);
+    // RAM starts the image, so RAM page p is image page p
+    for (uintptr_t p = off >> PAGE_SHIFT; p <= last >> PAGE_SHIFT; p++) {
+        g_ram_dirty[p] = 1;
+        if (g_code_blocks[p])
+            memory_code_block_drop((uint32_t)p);
+    }
+}
+
+// Start a new tracking interval: clear every mark and drop the RAM entries of
+// both write tables so the next write to each page is observed
+void memory_ram_dirty_rearm(void);
+
+// === RAM Copy-on-Write Snapshots ===
+// An asynchronous checkpoint reads RAM on its writer thread while the guest
+// keeps running.  The snapshot rides on the dirty-tracking hooks above:
+// memory_ram_cow_begin drops the RAM write entries, so the first store to each
+// page after it passes through memory_ram_mark_dirty, which copies the page
+// before the store lands.  The writer reads through memory_ram_cow_read and
+// sees RAM exactly as it was at begin.  Only the emulation thread begins a
+// snapshot or stores to RAM; the reader and memory_ram_cow_end may run on any
+// thread.
+
+// Open a snapshot of RAM as it is now (closes any snapshot still open).
+// Returns false when there is no RAM or no memory for the bookkeeping.
+bool memory_ram_cow_begin(void);
+
+// Copy [off, off + len) of the snapshot into dst; false when no snapshot is
+// open or a page could not be preserved (ctx unused; a checkpoint_ram_read_fn)
+bool memory_ram_cow_read(void *ctx, size_t off, uint8_t *dst, size_t len);
+
+// Close the snapshot and free the preserved pages (ctx unused; a
+// checkpoint_ram_release_fn)
+void memory_ram_cow_end(void *ctx);
+
 // === Inline Accessors (SoA fast-path with adjusted-base trick) ===
 // Non-zero entry in g_active_read/write = adjusted host address.
 // Zero entry = slow path (device I/O, unmapped, or MMU TLB miss).
 
 static inline uint8_t memory_read_uint8(uint32_t addr) {
     uint32_t masked = addr & g_address_mask;
-    uintptr_t base = g_active_read[masked >> PAGE_SHIFT];
+    uintptr_t base = memory_soa_get(g_active_read, masked >> PAGE_SHIFT);
     if (__builtin_expect(base != 0, 1))
         return LOAD_BE8((uint8_t *)(base + masked));
     return memory_read_uint8_slow(masked);
@@ -332,7 +525,7 @@ static inline uint8_t memory_read_uint8(uint32_t addr) {
 
 static inline uint16_t memory_read_uint16(uint32_t addr) {
     uint32_t masked = addr & g_address_mask;
-    uintptr_t base = g_active_read[masked >> PAGE_SHIFT];
+    uintptr_t base = memory_soa_get(g_active_read, masked >> PAGE_SHIFT);
     // Fast path: non-zero entry and access doesn't cross page boundary
     if (__builtin_expect(base != 0 && (masked & PAGE_MASK) <= MEM_PAGE_SIZE - 2, 1))
         return LOAD_BE16((uint8_t *)(base + masked));
@@ -341,7 +534,7 @@ static inline uint16_t memory_read_uint16(uint32_t addr) {
 
 static inline uint32_t memory_read_uint32(uint32_t addr) {
     uint32_t masked = addr & g_address_mask;
-    uintptr_t base = g_active_read[masked >> PAGE_SHIFT];
+    uintptr_t base = memory_soa_get(g_active_read, masked >> PAGE_SHIFT);
     // Fast path: non-zero entry and access doesn't cross page boundary
     if (__builtin_expect(base != 0 && (masked & PAGE_MASK) <= MEM_PAGE_SIZE - 4, 1)) {
         return LOAD_BE32((uint8_t *)(base + masked));
@@ -351,7 +544,7 @@ static inline uint32_t memory_read_uint32(uint32_t addr) {
 
 static inline void memory_write_uint8(uint32_t addr, uint8_t value) {
     uint32_t masked = addr & g_address_mask;
-    uintptr_t base = g_active_write[masked >> PAGE_SHIFT];
+    uintptr_t base = memory_soa_get(g_active_write, masked >> PAGE_SHIFT);
     if (__builtin_expect(g_value_trap_active && g_value_trap_size == 1 && (uint8_t)value == (uint8_t)g_value_trap_value,
                          0))
         value_trap_check(masked, value, 1);
@@ -364,7 +557,7 @@ static inline void memory_write_uint8(uint32_t addr, uint8_t value) {
 
 static inline void memory_write_uint16(uint32_t addr, uint16_t value) {
     uint32_t masked = addr & g_address_mask;
-    uintptr_t base = g_active_write[masked >> PAGE_SHIFT];
+    uintptr_t base = memory_soa_get(g_active_write, masked >> PAGE_SHIFT);
     if (__builtin_expect(
             g_value_trap_active && g_value_trap_size == 2 && (uint16_t)value == (uint16_t)g_value_trap_value, 0))
         value_trap_check(masked, value, 2);
@@ -378,7 +571,7 @@ static inline void memory_write_uint16(uint32_t addr, uint16_t value) {
 
 static inline void memory_write_uint32(uint32_t addr, uint32_t value) {
     uint32_t masked = addr & g_address_mask;
-    uintptr_t base = g_active_write[masked >> PAGE_SHIFT];
+    uintptr_t base = memory_soa_get(g_active_write, masked >> PAGE_SHIFT);
     if (__builtin_expect(g_value_trap_active && g_value_trap_size == 4 && value == g_value_trap_value, 0))
         value_trap_check(masked, value, 4);
     // Fast path: non-zero entry and access doesn't cross page boundary
@@ -389,4 +582,69 @@ static inline void memory_write_uint32(uint32_t addr, uint32_t value) {
     memory_write_uint32_slow(masked, value);
 }
 
+// === Instruction-Fetch Code Window ===
+// Instruction fetches go through a one-page window onto the current code page:
+// the page number, the SoA table it was read from and that table's adjusted
+// base.  Sequential fetches and branches within the page skip the SoA load;
+// crossing a page or switching g_active_read (supervisor/user) refills it.
+// Every writer of a read-side SoA entry must drop the window for that page
+// (or flush it outright) so a stale base is never used.  While a decoder owns
+// the decoded-page cache, the window also carries the block of its host page;
+// dropping a block empties the window.
+
+#define CODE_PAGE_NONE UINT32_MAX // window empty: the next fetch refills it
+
+extern uint32_t g_code_page; // page number covered by the window
+extern uintptr_t g_code_base; // adjusted base for g_code_page (never 0)
+extern soa_table_t g_code_table; // SoA table g_code_base was read from
+
+// Empty the code window (bulk SoA changes, memory map teardown, new sprint)
+static inline void memory_code_window_flush(void) {
+    g_code_page = CODE_PAGE_NONE;
+}
+
+// Empty the code window if it covers page p (single-page SoA change)
+static inline void memory_code_window_drop(uint32_t p) {
+    if (p == g_code_page)
+        g_code_page = CODE_PAGE_NONE;
+}
+
+// Refill the window for a masked address; returns the SoA base (0 = slow path,
+// in which case the window stays empty so the next fetch re-checks the SoA)
+static inline uintptr_t memory_code_window_fill(uint32_t masked) {
+    uintptr_t base = memory_soa_get(g_active_read, masked >> PAGE_SHIFT);
+    g_code_page = base ? masked >> PAGE_SHIFT : CODE_PAGE_NONE;
+    g_code_base = base;
+    g_code_table = g_active_read;
+    g_code_block = NULL;
+    if (base && g_code_blocks_owner)
+        g_code_block = memory_code_block_lookup(base + (masked & ~(uint32_t)PAGE_MASK));
+    return base;
+}
+
+// Adjusted base for an instruction fetch at a masked address (0 = slow path)
+static inline uintptr_t memory_code_base(uint32_t masked) {
+    if (__builtin_expect((masked >> PAGE_SHIFT) == g_code_page && g_code_table == g_active_read, 1))
+        return g_code_base;
+    return memory_code_window_fill(masked);
+}
+
+// Instruction-stream word fetch through the code window
+static inline uint16_t memory_fetch_uint16(uint32_t addr) {
+    uint32_t masked = addr & g_address_mask;
+    uintptr_t base = memory_code_base(masked);
+    if (__builtin_expect(base != 0 && (masked & PAGE_MASK) <= MEM_PAGE_SIZE - 2, 1))
+        return LOAD_BE16((uint8_t *)(base + masked));
+    return memory_read_uint16_slow(masked);
+}
+
+// Instruction-stream long fetch through the code window
+static inline uint32_t memory_fetch_uint32(uint32_t addr) {
+    uint32_t masked = addr & g_address_mask;
+    uintptr_t base = memory_code_base(masked);
+    if (__builtin_expect(base != 0 && (masked & PAGE_MASK) <= MEM_PAGE_SIZE - 4, 1))
+        return LOAD_BE32((uint8_t *)(base + masked));
+    return memory_read_uint32_slow(masked);
+}
+
 #endif // MEMORY_H
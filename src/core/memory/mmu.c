@@ -24,33 +24,8 @@ mmu_state_t *g_mmu = NULL;
 // entry.  Cleared when the MMU is destroyed.
 uint64_t g_last_user_crp = 0;
 
-// ============================================================================
-// TLB population tracking (for fast invalidation)
-// ============================================================================
-
-// Instead of zeroing all 1M+ page entries on every TLB invalidation (32 MB of
-// memset on a 32-bit address space), track which pages have been populated and
-// only zero those.  Typical working sets are ~2000-3000 pages (8-12 MB of RAM
-// + ROM + VRAM), reducing invalidation cost from O(address_space) to O(working_set).
-#define TLB_TRACK_MAX 8192 // max tracked pages before fallback to full memset
-
-static uint32_t g_tlb_track[TLB_TRACK_MAX]; // populated page indices
-static int g_tlb_track_count = 0; // entries in tracking list
-// Start in overflow mode so the first invalidation (after memory_init
-// populates entries without tracking) does a full memset.  Subsequent
-// invalidations use the fast tracked path.
-static bool g_tlb_track_overflow = true;
-
-// Record that a page index has been populated in the SoA TLB arrays
-void tlb_track_page(uint32_t page_index) {
-    if (g_tlb_track_overflow)
-        return; // already in fallback mode
-    if (g_tlb_track_count >= TLB_TRACK_MAX) {
-        g_tlb_track_overflow = true;
-        return;
-    }
-    g_tlb_track[g_tlb_track_count++] = page_index;
-}
+// Translation generation (see mmu.h)
+uint32_t g_mmu_generation = 0;
 
 // ============================================================================
 // ATC-style block-descriptor cache
@@ -445,9 +420,11 @@ static mmu_walk_result_t mmu_table_walk(mmu_state_t *mmu, uint32_t logical_addr,
 // When TC.SRE=1 (separate supervisor/user roots), the super and user MMU tables
 // may map the same logical page to different physical pages, so we only
 // populate the SoA matching the walk's FC.  When SRE=0, a single walk
-// produces the mapping for both FCs so we populate both tables.
+// produces the mapping for both FCs so we populate both tables.  `write` is
+// the faulting access; a read leaves the write entries of a page with a
+// decoded block empty (see memory.h).
 static void mmu_fill_soa_entry(mmu_state_t *mmu, uint32_t logical_page, uint32_t physical_page, bool supervisor_only,
-                               bool write_protected, bool supervisor, bool tt_match) {
+                               bool write_protected, bool supervisor, bool tt_match, bool write) {
     // Get host pointer for the physical page
     uint8_t *host_ptr = phys_to_host(mmu, physical_page);
     if (!host_ptr)
@@ -477,9 +454,6 @@ static void mmu_fill_soa_entry(mmu_state_t *mmu, uint32_t logical_page, uint32_t
     // but we want (uintptr_t)(base + logical_addr) to yield the host address.
     uintptr_t adjusted = (uintptr_t)host_ptr - logical_page;
 
-    // Track this page for fast invalidation
-    tlb_track_page(page_index);
-
     // Fill rules:
     //   TT match: TT registers are FC-specific (supervisor-only or user-only),
     //     so fill ONLY the SoA matching the walk's FC.  Filling both would
@@ -494,18 +468,21 @@ static void mmu_fill_soa_entry(mmu_state_t *mmu, uint32_t logical_page, uint32_t
     if (!tt_match && supervisor_only)
         fill_user = false;
 
+    bool fill_write = !write_protected && host_writable && (write || !memory_code_block_at(host_ptr));
+
+    memory_code_window_drop(page_index);
     if (fill_super) {
         if (g_supervisor_read)
-            g_supervisor_read[page_index] = adjusted;
-        if (g_supervisor_write && !write_protected && host_writable)
-            g_supervisor_write[page_index] = adjusted;
+            memory_soa_set(g_supervisor_read, page_index, adjusted);
+        if (g_supervisor_write && fill_write)
+            memory_soa_set(g_supervisor_write, page_index, adjusted);
     }
 
     if (fill_user) {
         if (g_user_read)
-            g_user_read[page_index] = adjusted;
-        if (g_user_write && !write_protected && host_writable)
-            g_user_write[page_index] = adjusted;
+            memory_soa_set(g_user_read, page_index, adjusted);
+        if (g_user_write && fill_write)
+            memory_soa_set(g_user_write, page_index, adjusted);
     }
 }
 
@@ -541,12 +518,6 @@ void mmu_delete(mmu_state_t *mmu) {
         // Clear the user-CRP snapshot so a fresh machine doesn't inherit
         // a stale CRP from the previous instance.
         g_last_user_crp = 0;
-        // Reset TLB-tracker state. Stale indices from this machine could
-        // index past the next machine's smaller SoA arrays. Setting
-        // overflow=true also makes the first post-init invalidate fall
-        // back to a full memset (matches the file-scope default).
-        g_tlb_track_count = 0;
-        g_tlb_track_overflow = true;
         // Cached block descriptors belong to this machine's tables too.
         atc_flush();
     }
@@ -647,10 +618,10 @@ void memory_set_bus_error_range(memory_map_t *m, uint32_t start, uint32_t end) {
     g_mmu->nubus_berr_end = end;
 }
 
-// Invalidate the software TLB.  Uses the tracking list to zero only
-// populated entries — typically ~2000-3000 pages vs 1M+ for a full memset.
-// Falls back to full memset if the tracking list overflowed.
+// Invalidate the software TLB.  memory_soa_clear only touches the SoA chunks
+// populated since the last invalidation, never the whole address space.
 void mmu_invalidate_tlb(mmu_state_t *mmu) {
+    g_mmu_generation++;
     // Fast path: when the MMU is disabled and was disabled the previous
     // time we ran (no enabled→disabled transition), the SoA fast-path
     // already holds the direct host-backed mappings the boot ROM relies
@@ -672,44 +643,19 @@ void mmu_invalidate_tlb(mmu_state_t *mmu) {
     // block descriptors along with the SoA fill.  (The dis→dis early-out above
     // and the FD PMOVE forms — which never call here — both preserve them.)
     atc_flush();
-    if (g_tlb_track_overflow) {
-        // Tracking overflowed — fall back to zeroing everything
-        size_t sz = (size_t)g_page_count * sizeof(uintptr_t);
-        if (g_supervisor_read)
-            memset(g_supervisor_read, 0, sz);
-        if (g_supervisor_write)
-            memset(g_supervisor_write, 0, sz);
-        if (g_user_read)
-            memset(g_user_read, 0, sz);
-        if (g_user_write)
-            memset(g_user_write, 0, sz);
-    } else {
-        // Fast path: zero only pages that were actually populated.
-        // Bounds-check each index in case the tracker carries entries from a
-        // previous machine with a larger page table (see mmu_delete's reset).
-        for (int i = 0; i < g_tlb_track_count; i++) {
-            uint32_t p = g_tlb_track[i];
-            if (p >= g_page_count)
-                continue;
-            if (g_supervisor_read)
-                g_supervisor_read[p] = 0;
-            if (g_supervisor_write)
-                g_supervisor_write[p] = 0;
-            if (g_user_read)
-                g_user_read[p] = 0;
-            if (g_user_write)
-                g_user_write[p] = 0;
-        }
-    }
-
-    // Reset tracking state
-    g_tlb_track_count = 0;
-    g_tlb_track_overflow = false;
+    memory_code_window_flush();
+    // Detaching the SoA leaves costs the same whether a handful of pages or
+    // the whole working set was filled since the last invalidation; the miss
+    // path wipes each leaf as it refills it.
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_clear(g_supervisor_write);
+    memory_soa_clear(g_user_read);
+    memory_soa_clear(g_user_write);
 
     // When the MMU is disabled, host-backed pages (RAM/ROM/VRAM) are
     // installed lazily on first access by the memory.c slow path via
     // rebuild_soa_page. The eager repopulate that used to live here did a
-    // linear scan of all g_page_count AoS slots (32 MB for SE/30) to find
+    // linear scan of all g_page_count AoS slots (then a flat 32 MB) to find
     // ~1500 host-backed pages — that scan dominated SE/30 boot at 37% of
     // CPU time. See docs/notes/mmu-tlb-invalidate-perf.md.
 }
@@ -727,8 +673,8 @@ void mmu_invalidate_tlb(mmu_state_t *mmu) {
 static inline bool mmu_fault_epilogue(mmu_state_t *mmu, uint32_t emu_page, uint32_t phys_page, bool write) {
     uint32_t page_index = emu_page >> PAGE_SHIFT;
     if ((int)page_index < g_page_count) {
-        uintptr_t *active = write ? g_active_write : g_active_read;
-        if (active && active[page_index] == 0) {
+        soa_table_t active = write ? g_active_write : g_active_read;
+        if (active && memory_soa_get(active, page_index) == 0) {
             // For closer ranges (e.g., $006DB000 from corrupted page tables),
             // the f_trap handler detects unmapped instruction fetches separately.
             if (phys_page >= mmu->ram_size_max && phys_page < mmu->rom_phys_base)
@@ -753,7 +699,7 @@ static bool mmu_handle_fault_internal(mmu_state_t *mmu, uint32_t logical_addr, b
     // Check transparent translation first
     if (mmu_check_tt(mmu, logical_addr, write, supervisor)) {
         // TT match: identity mapping (logical = physical)
-        mmu_fill_soa_entry(mmu, emu_page, emu_page, false, false, supervisor, true);
+        mmu_fill_soa_entry(mmu, emu_page, emu_page, false, false, supervisor, true, write);
         // If phys_to_host returned NULL (unmapped physical), the SoA entry
         // stays zero.  For reads, only bus error within the configured NuBus
         // expansion slot range (e.g. $F9-$FD on SE/30).  Outside that range,
@@ -761,8 +707,9 @@ static bool mmu_handle_fault_internal(mmu_state_t *mmu, uint32_t logical_addr, b
         // pseudo-slots like slot $F.  Writes are always silently dropped.
         if (!write) {
             uint32_t page_index = emu_page >> PAGE_SHIFT;
-            if ((int)page_index < g_page_count && g_supervisor_read && g_supervisor_read[page_index] == 0 &&
-                logical_addr >= mmu->nubus_berr_start && logical_addr <= mmu->nubus_berr_end) {
+            if ((int)page_index < g_page_count && g_supervisor_read &&
+                memory_soa_get(g_supervisor_read, page_index) == 0 && logical_addr >= mmu->nubus_berr_start &&
+                logical_addr <= mmu->nubus_berr_end) {
                 // TT + unmapped physical = plain bus timeout; ROM handlers
                 // expect skip semantics (Format $A).
                 g_bus_error_is_pmmu = false;
@@ -783,7 +730,8 @@ static bool mmu_handle_fault_internal(mmu_state_t *mmu, uint32_t logical_addr, b
         atc_block_t *b = atc_probe(mmu, logical_addr, supervisor);
         if (b && !(b->supervisor_only && !supervisor) && !(b->write_protected && write)) {
             uint32_t phys_page = b->phys_base + (emu_page - b->log_base);
-            mmu_fill_soa_entry(mmu, emu_page, phys_page, b->supervisor_only, b->write_protected, supervisor, false);
+            mmu_fill_soa_entry(mmu, emu_page, phys_page, b->supervisor_only, b->write_protected, supervisor, false,
+                               write);
             return mmu_fault_epilogue(mmu, emu_page, phys_page, write);
         }
     }
@@ -834,7 +782,8 @@ static bool mmu_handle_fault_internal(mmu_state_t *mmu, uint32_t logical_addr, b
     // The physical address from the walk gives us the physical page base.
     // We need to map the emulator's 4KB page granularity.
     uint32_t phys_page = result.physical_addr & ~(uint32_t)PAGE_MASK;
-    mmu_fill_soa_entry(mmu, emu_page, phys_page, result.supervisor_only, result.write_protected, supervisor, false);
+    mmu_fill_soa_entry(mmu, emu_page, phys_page, result.supervisor_only, result.write_protected, supervisor, false,
+                       write);
 
     // When the descriptor covers more than one emulator 4KB page (e.g. an
     // early-termination page descriptor at level A with 32 MB coverage), the
@@ -1028,6 +977,7 @@ bool mmu_write_physical_uint8(mmu_state_t *mmu, uint32_t phys_addr, uint8_t valu
     uint8_t *host = phys_to_host(mmu, phys_addr);
     if (!host)
         return false;
+    memory_ram_mark_dirty(host, 1);
     *host = value;
     return true;
 }
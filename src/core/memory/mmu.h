@@ -148,11 +148,6 @@ void mmu_delete(mmu_state_t *mmu);
 // Called on PMOVE to TC/CRP/SRP and PFLUSHA.
 void mmu_invalidate_tlb(mmu_state_t *mmu);
 
-// Record that page p has been written into one of the four SoA arrays since
-// the last invalidation. Callers in the slow path of memory.c use this when
-// lazy-installing an identity mapping for an MMU-disabled access.
-void tlb_track_page(uint32_t page_index);
-
 // === Address Translation ===
 
 // Handle a TLB miss: perform table walk (or TT check), fill SoA entry.
@@ -244,4 +239,9 @@ extern struct mmu_state *g_mmu;
 // has been observed yet.
 extern uint64_t g_last_user_crp;
 
+// Bumped by every mmu_invalidate_tlb call (PMOVE to TC/CRP/SRP/TTx, PFLUSH,
+// reset), including the dis→dis fast path.  Caches of logical→physical
+// translations held outside the SoA compare against it to notice remaps.
+extern uint32_t g_mmu_generation;
+
 #endif // MMU_H
@@ -11,6 +11,7 @@
 #include "scheduler.h"
 
 #include "cpu.h"
+#include "history.h"
 #include "log.h"
 #include "memory.h"
 #include "object.h"
@@ -40,6 +41,9 @@ LOG_USE_CATEGORY_NAME("scheduler");
 #define MAC_CPU_FREQUENCY        7833600.0
 #define MAX_EVENT_TYPES          32
 #define MAX_SANE_EVENTS          10000 // upper bound for event queue length sanity checks
+#define EVENT_NOT_QUEUED         UINT32_MAX // heap_pos of an event that is not pending
+#define EVENT_TYPE_UNREGISTERED  MAX_EVENT_TYPES // type chain for unregistered (callback, source) pairs
+#define EVENT_HEAP_MIN           64 // initial heap capacity
 
 // Paced mode: hard cap on frame-units executed per host tick. A slow or
 // stalled host makes vbl_acc_error grow; without a cap, each oversized burst
@@ -87,6 +91,15 @@ LOG_USE_CATEGORY_NAME("scheduler");
 static const uint32_t gov_ladder_x256[] = {256, 384, 512, 768, 1024, 1536, 2048};
 #define GOV_NUM_RUNGS ((int)(sizeof(gov_ladder_x256) / sizeof(gov_ladder_x256[0])))
 
+// Idle-loop fast-forward (scheduler.idle). A probe single-steps at most
+// IDLE_PROBE_MAX instructions looking for a pass that returns the CPU to its
+// starting state; probes only start when the coming sprint is long enough to
+// repay them, and a failed probe backs off for up to IDLE_BACKOFF_MAX sprints
+// so busy code pays almost nothing.
+#define IDLE_PROBE_MAX   32
+#define IDLE_MIN_SPRINT  256
+#define IDLE_BACKOFF_MAX 64
+
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
 // ============================================================================
@@ -95,11 +108,15 @@ static const uint32_t gov_ladder_x256[] = {256, 384, 512, 768, 1024, 1536, 2048}
 
 // A single scheduled event in the priority queue
 struct event {
-    event_t *next;
     uint64_t timestamp;
+    uint64_t seq; // insertion order; breaks timestamp ties first-in, first-out
     event_callback_t callback;
     void *source;
     uint64_t data;
+    uint32_t heap_pos; // index in the scheduler heap, EVENT_NOT_QUEUED when not pending
+    int type; // index into event_types, EVENT_TYPE_UNREGISTERED if none
+    event_t *type_prev; // pending events of the same type (doubly linked)
+    event_t *type_next; // ... also the event pool's free-list link
 };
 
 // Checkpoint-friendly representation of an event (names instead of pointers)
@@ -167,6 +184,15 @@ struct scheduler {
     double gov_dwell_secs; // host seconds spent at the current rung
     double gov_holdoff_secs; // remaining post-back-off climb holdoff
 
+    // Idle-loop detector state — live, never checkpointed, and reset at every
+    // scheduler_run_instructions entry (host input and VBL injection between
+    // runs can change what a polling loop reads)
+    uint32_t idle_probe_steps; // single steps taken since cpu_idle_mark; 0 = not probing
+    uint32_t idle_loop_len; // confirmed loop length at the mark, in instructions; 0 = none
+    uint32_t idle_cooldown; // sprints to sit out before the next probe
+    uint32_t idle_backoff; // cooldown applied after the next failed probe
+    bool idle_verify_pending; // verify mode: the sprint just run must end at the mark
+
     // Sprint execution counters (previously file-scope globals)
     uint64_t total_instructions; // accumulated instructions from completed sprints
     uint32_t sprint_total; // instructions planned for current sprint
@@ -174,7 +200,16 @@ struct scheduler {
 
     // Pointers last
     struct cpu *cpu;
-    event_t *cpu_events; // priority queue sorted by timestamp
+
+    // Pending events: a binary min-heap on (timestamp, seq) in which every
+    // event records its own index, so any event can be unlinked in O(log n).
+    // type_events chains the pending events of each registered type, so
+    // remove_event visits only the events it removes.
+    event_t **events;
+    uint32_t num_events;
+    uint32_t events_cap;
+    uint64_t event_seq; // sequence number of the next inserted event
+    event_t *type_events[MAX_EVENT_TYPES + 1];
 
     // Temporary storage used during checkpoint restore
     unsigned int tmp_num_events;
@@ -186,6 +221,11 @@ struct scheduler {
     struct object *object;
 };
 
+// Queue order: earlier timestamp first, insertion order among equal timestamps
+static inline bool event_before(const event_t *a, const event_t *b) {
+    return a->timestamp < b->timestamp || (a->timestamp == b->timestamp && a->seq < b->seq);
+}
+
 // Read a POSIX clock as nanoseconds.  CLOCK_PROCESS_CPUTIME_ID measures
 // pure user-mode CPU time consumed by this process across all threads;
 // CLOCK_MONOTONIC measures wall time.  On platforms that don't expose
@@ -363,25 +403,21 @@ static void scheduler_check_invariants(struct scheduler *s, const char *context)
     GS_ASSERTF(s->cycle_frac_x256 < 256, "[%s] cycle_frac_x256 out of range (%u)", context, s->cycle_frac_x256);
 
     // Event queue: first event must not be too far in the past (allow CPI overshoot)
-    if (s->cpu_events != NULL) {
+    if (s->num_events != 0) {
         uint64_t now = current_cpu_cycles(s);
         uint32_t max_past = avg_cycles_per_instr(s);
-        GS_ASSERTF(s->cpu_events->timestamp + max_past >= now, "[%s] first event too far in past: ts=%llu now=%llu",
-                   context, (unsigned long long)s->cpu_events->timestamp, (unsigned long long)now);
+        GS_ASSERTF(s->events[0]->timestamp + max_past >= now, "[%s] first event too far in past: ts=%llu now=%llu",
+                   context, (unsigned long long)s->events[0]->timestamp, (unsigned long long)now);
     }
 
-    // Event queue internal ordering: timestamps must be non-decreasing, callbacks non-NULL
-    if (s->cpu_events != NULL) {
-        uint64_t prev_ts = 0;
-        int idx = 0;
-        for (event_t *e = s->cpu_events; e != NULL; e = e->next) {
-            GS_ASSERTF(e->timestamp >= prev_ts, "[%s] event queue not sorted at index %d", context, idx);
-            GS_ASSERTF(e->callback != NULL, "[%s] NULL callback at index %d", context, idx);
-            prev_ts = e->timestamp;
-            idx++;
-            // Guard against corrupted list
-            GS_ASSERTF(idx <= MAX_SANE_EVENTS, "[%s] event queue too long or loop detected", context);
-        }
+    // Event queue internal ordering: heap order and positions hold, callbacks non-NULL
+    GS_ASSERTF(s->num_events <= MAX_SANE_EVENTS, "[%s] event queue too long (%u)", context, s->num_events);
+    for (uint32_t i = 0; i < s->num_events; i++) {
+        event_t *e = s->events[i];
+        GS_ASSERTF(e->heap_pos == i, "[%s] event heap position mismatch at index %u", context, i);
+        GS_ASSERTF(i == 0 || !event_before(e, s->events[(i - 1) / 2]), "[%s] event heap not ordered at index %u",
+                   context, i);
+        GS_ASSERTF(e->callback != NULL, "[%s] NULL callback at index %u", context, i);
     }
 
     // Timing accumulator sanity (warning only, not a hard assert)
@@ -454,31 +490,34 @@ static void validate_cpu_events(struct scheduler *s) {
     GS_ASSERT(s != NULL);
 
     uint32_t max_past = avg_cycles_per_instr(s);
-    uint64_t prev_ts = 0;
-    int count = 0;
 
-    for (event_t *e = s->cpu_events; e != NULL; e = e->next) {
-        count++;
-        GS_ASSERTF(count <= MAX_SANE_EVENTS, "event queue too long or infinite loop (count=%d)", count);
+    GS_ASSERTF(s->num_events <= MAX_SANE_EVENTS, "event queue too long (count=%u)", s->num_events);
+    for (uint32_t i = 0; i < s->num_events; i++) {
+        event_t *e = s->events[i];
         GS_ASSERT(e->callback != NULL);
-        GS_ASSERTF(e->timestamp >= prev_ts, "timestamp not increasing (%llu < %llu)", (unsigned long long)e->timestamp,
-                   (unsigned long long)prev_ts);
+        GS_ASSERT(e->heap_pos == i);
+        GS_ASSERTF(i == 0 || !event_before(e, s->events[(i - 1) / 2]), "event heap not ordered at index %u", i);
         GS_ASSERTF(e->timestamp + max_past >= s->cpu_cycles, "timestamp too far in past (%llu vs cpu_cycles %llu)",
                    (unsigned long long)e->timestamp, (unsigned long long)s->cpu_cycles);
-        prev_ts = e->timestamp;
     }
 }
 #endif // GS_FAST
 
+// Index of the registered event type for a source+callback pair, or EVENT_TYPE_UNREGISTERED
+static int event_type_index(struct scheduler *s, void *source, event_callback_t cb) {
+    for (int i = 0; i < s->num_event_types; i++) {
+        if (s->event_types[i].source == source && s->event_types[i].callback == cb)
+            return i;
+    }
+    return EVENT_TYPE_UNREGISTERED;
+}
+
 // Look up registered event type names for a given source+callback pair
 static const event_type_t *find_event_type(struct scheduler *s, void *source, event_callback_t cb) {
     if (!s)
         return NULL;
-    for (int i = 0; i < s->num_event_types; i++) {
-        if (s->event_types[i].source == source && s->event_types[i].callback == cb)
-            return &s->event_types[i];
-    }
-    return NULL;
+    int type = event_type_index(s, source, cb);
+    return type != EVENT_TYPE_UNREGISTERED ? &s->event_types[type] : NULL;
 }
 
 // ============================================================================
@@ -492,14 +531,14 @@ static const event_type_t *find_event_type(struct scheduler *s, void *source, ev
 // no per-scheduler state) and bounded; the live queue stays ~5 entries deep,
 // so the cap covers any realistic burst.
 #define EVENT_POOL_MAX 64
-static event_t *g_event_pool = NULL; // LIFO free list, linked via ->next
+static event_t *g_event_pool = NULL; // LIFO free list, linked via ->type_next
 static int g_event_pool_count = 0; // entries currently pooled
 
 // Pop a recycled event (zeroed, like calloc) or fall back to the allocator.
 static event_t *event_alloc(void) {
     event_t *e = g_event_pool;
     if (e != NULL) {
-        g_event_pool = e->next;
+        g_event_pool = e->type_next;
         g_event_pool_count--;
         memset(e, 0, sizeof(*e));
         return e;
@@ -510,7 +549,7 @@ static event_t *event_alloc(void) {
 // Return an event to the pool (or to the allocator once the pool is full).
 static void event_free(event_t *e) {
     if (g_event_pool_count < EVENT_POOL_MAX) {
-        e->next = g_event_pool;
+        e->type_next = g_event_pool;
         g_event_pool = e;
         g_event_pool_count++;
         return;
@@ -518,31 +557,150 @@ static void event_free(event_t *e) {
     free(e);
 }
 
-// Insert an event into the queue, maintaining timestamp order
-static event_t *insert_event_queue(event_t *queue, event_t *new_event) {
+// ============================================================================
+// Event queue (binary min-heap)
+// ============================================================================
+
+// Store an event at a heap index and record the index in the event
+static inline void heap_place(struct scheduler *s, event_t *e, uint32_t pos) {
+    s->events[pos] = e;
+    e->heap_pos = pos;
+}
+
+// Move the event at pos towards the root until its parent precedes it
+static void heap_sift_up(struct scheduler *s, uint32_t pos) {
+    event_t *e = s->events[pos];
+    while (pos > 0) {
+        uint32_t parent = (pos - 1) / 2;
+        if (!event_before(e, s->events[parent]))
+            break;
+        heap_place(s, s->events[parent], pos);
+        pos = parent;
+    }
+    heap_place(s, e, pos);
+}
+
+// Move the event at pos towards the leaves until it precedes both children
+static void heap_sift_down(struct scheduler *s, uint32_t pos) {
+    event_t *e = s->events[pos];
+    for (;;) {
+        uint32_t child = 2 * pos + 1;
+        if (child >= s->num_events)
+            break;
+        if (child + 1 < s->num_events && event_before(s->events[child + 1], s->events[child]))
+            child++;
+        if (!event_before(s->events[child], e))
+            break;
+        heap_place(s, s->events[child], pos);
+        pos = child;
+    }
+    heap_place(s, e, pos);
+}
+
+// Earliest pending event, or NULL when the queue is empty
+static inline event_t *next_event(struct scheduler *s) {
+    return s->num_events != 0 ? s->events[0] : NULL;
+}
+
+// Insert an event into the queue behind every pending event with the same timestamp
+static void insert_event_queue(struct scheduler *s, event_t *new_event) {
     GS_ASSERT(new_event != NULL);
     GS_ASSERT(new_event->callback != NULL);
-    GS_ASSERT(new_event->next == NULL);
+    GS_ASSERT(new_event->heap_pos == EVENT_NOT_QUEUED);
+    GS_ASSERT(new_event->type >= 0 && new_event->type <= EVENT_TYPE_UNREGISTERED);
+
+    if (s->num_events == s->events_cap) {
+        uint32_t cap = s->events_cap ? s->events_cap * 2 : EVENT_HEAP_MIN;
+        event_t **events = (event_t **)realloc(s->events, (size_t)cap * sizeof(event_t *));
+        GS_ASSERT(events != NULL);
+        s->events = events;
+        s->events_cap = cap;
+    }
+
+    new_event->seq = s->event_seq++;
+    heap_place(s, new_event, s->num_events++);
+    heap_sift_up(s, new_event->heap_pos);
+
+    event_t **chain = &s->type_events[new_event->type];
+    new_event->type_prev = NULL;
+    new_event->type_next = *chain;
+    if (*chain != NULL)
+        (*chain)->type_prev = new_event;
+    *chain = new_event;
+}
+
+// Unlink a pending event from the heap and its type chain (the caller owns it afterwards)
+static void unlink_event(struct scheduler *s, event_t *e) {
+    uint32_t pos = e->heap_pos;
+    GS_ASSERT(pos < s->num_events && s->events[pos] == e);
+
+    event_t *last = s->events[--s->num_events];
+    if (last != e) {
+        heap_place(s, last, pos);
+        if (pos > 0 && event_before(last, s->events[(pos - 1) / 2]))
+            heap_sift_up(s, pos);
+        else
+            heap_sift_down(s, pos);
+    }
+    e->heap_pos = EVENT_NOT_QUEUED;
 
-    // Insert at head if queue is empty or new event fires first
-    if (queue == NULL || new_event->timestamp < queue->timestamp) {
-        new_event->next = queue;
-        return new_event;
+    if (e->type_prev != NULL)
+        e->type_prev->type_next = e->type_next;
+    else
+        s->type_events[e->type] = e->type_next;
+    if (e->type_next != NULL)
+        e->type_next->type_prev = e->type_prev;
+    e->type_prev = e->type_next = NULL;
+}
+
+// Drop the pending events on one type chain that match callback/source (and data, if match_data)
+static void remove_chain_events(struct scheduler *s, int type, event_callback_t callback, void *source,
+                                bool match_data, uint64_t data) {
+    event_t *e = s->type_events[type];
+    while (e != NULL) {
+        event_t *next = e->type_next;
+        if (e->callback == callback && (e->source == source || source == NULL) && (!match_data || e->data == data)) {
+            unlink_event(s, e);
+            event_free(e);
+        }
+        e = next;
+    }
+}
+
+// Drop every pending event matching callback/source (and data, if match_data).
+// A source pins down a single registered type; without one, every type of the
+// callback is visited.  Unregistered pairs (only possible with asserts off)
+// share one chain that is always checked.
+static void remove_matching_events(struct scheduler *s, event_callback_t callback, void *source, bool match_data,
+                                   uint64_t data) {
+    for (int i = 0; i < s->num_event_types; i++) {
+        if (s->event_types[i].callback == callback && (s->event_types[i].source == source || source == NULL))
+            remove_chain_events(s, i, callback, source, match_data, data);
     }
+    remove_chain_events(s, EVENT_TYPE_UNREGISTERED, callback, source, match_data, data);
+}
 
-    // Walk to insertion point
-    event_t *cur = queue;
-    while (cur->next != NULL && cur->next->timestamp <= new_event->timestamp)
-        cur = cur->next;
+// Order two pending events for qsort (queue order)
+static int event_compare(const void *a, const void *b) {
+    const event_t *ea = *(const event_t *const *)a;
+    const event_t *eb = *(const event_t *const *)b;
+    return event_before(ea, eb) ? -1 : event_before(eb, ea) ? 1 : 0;
+}
 
-    new_event->next = cur->next;
-    cur->next = new_event;
-    return queue;
+// Copy the pending events in fire order (caller frees; NULL when the queue is empty)
+static event_t **sorted_events(struct scheduler *s) {
+    if (s->num_events == 0)
+        return NULL;
+    event_t **sorted = (event_t **)malloc((size_t)s->num_events * sizeof(event_t *));
+    GS_ASSERT(sorted != NULL);
+    memcpy(sorted, s->events, (size_t)s->num_events * sizeof(event_t *));
+    qsort(sorted, s->num_events, sizeof(event_t *), event_compare);
+    return sorted;
 }
 
 // Create and insert a new event into the scheduler queue
-static event_t *add_event_internal(struct scheduler *restrict s, event_callback_t callback, void *source, uint64_t data,
-                                   uint64_t cycles, uint64_t ns) {
+static event_t *add_event_internal(struct scheduler *restrict s, int type, event_callback_t callback, void *source,
+                                   uint64_t data, uint64_t cycles, uint64_t ns) {
     // Exactly one of cycles/ns must be non-zero
     GS_ASSERTF(cycles != 0 || ns != 0, "both cycles and ns are 0");
     GS_ASSERTF(!(cycles != 0 && ns != 0), "both cycles and ns are set");
@@ -560,13 +718,15 @@ static event_t *add_event_internal(struct scheduler *restrict s, event_callback_
     event->callback = callback;
     event->source = source;
     event->data = data;
+    event->type = type;
+    event->heap_pos = EVENT_NOT_QUEUED;
 
     // Timestamp relative to current time including in-sprint progress
     uint64_t now = current_cpu_cycles(s);
     event->timestamp = cycles + now;
     GS_ASSERT(event->timestamp >= now);
 
-    s->cpu_events = insert_event_queue(s->cpu_events, event);
+    insert_event_queue(s, event);
     return event;
 }
 
@@ -575,12 +735,12 @@ static event_t *add_event_internal(struct scheduler *restrict s, event_callback_
 uint64_t g_sched_events_fired = 0;
 
 // Process all events in the queue that are due at or before current_time
-static void process_event_queue(event_t **queue, uint64_t current_time) {
-    GS_ASSERT(queue != NULL);
+static void process_event_queue(struct scheduler *s, uint64_t current_time) {
+    GS_ASSERT(s != NULL);
 
-    while (*queue != NULL && (*queue)->timestamp <= current_time) {
-        event_t *e = *queue;
-        *queue = e->next;
+    while (s->num_events != 0 && s->events[0]->timestamp <= current_time) {
+        event_t *e = s->events[0];
+        unlink_event(s, e);
         g_sched_events_fired++;
         (e->callback)(e->source, e->data);
         event_free(e);
@@ -589,10 +749,101 @@ static void process_event_queue(event_t **queue, uint64_t current_time) {
 
 // Count events in the queue
 static int num_events_in_queue(struct scheduler *restrict s) {
-    int count = 0;
-    for (event_t *e = s->cpu_events; e != NULL; e = e->next)
-        count++;
-    return count;
+    return (int)s->num_events;
+}
+
+// ============================================================================
+// Idle-Loop Fast-Forward
+// ============================================================================
+
+// Guest polling loops (a TST/CMP of a RAM flag and a Bcc back, waiting for an
+// interrupt handler to change it) burn whole frames re-executing the same
+// few instructions.  cpu_idle_mark/cpu_idle_step (cpu.c) prove that one pass
+// of such a loop leaves the CPU bit-identical and touches only RAM/ROM it
+// does not write, so until the next event every further pass does the same.
+// Once a probe confirms a loop, the next sprint accounts its whole passes as
+// executed slots without running them — instruction count, cycles and event
+// timing come out exactly as in a normal run, in the same way a STOPped CPU
+// fast-forwards to its next event.  Verify mode runs those passes instead and
+// checks the CPU really is back at the mark afterwards.  Process-global, like
+// the event pool, so the setting survives checkpoint restores.
+static enum idle_mode g_idle_mode = idle_off;
+static uint64_t g_idle_loops; // loops confirmed by a probe
+static uint64_t g_idle_skipped; // instructions accounted without being run
+static uint64_t g_idle_verify_failures; // verify mode: predicted passes that diverged
+
+// A probe failed: sit out a growing number of sprints before the next one
+static void idle_probe_failed(struct scheduler *s) {
+    s->idle_probe_steps = 0;
+    s->idle_cooldown = s->idle_backoff;
+    s->idle_backoff = MIN(s->idle_backoff * 2 + 1, IDLE_BACKOFF_MAX);
+}
+
+// Shape the coming sprint: single-step while probing, or cover the whole
+// passes of a confirmed loop.  Returns the slots to account without running.
+static uint32_t idle_plan_sprint(struct scheduler *s, uint32_t *instr_to_exec) {
+    if (s->idle_loop_len != 0) {
+        // At the loop head (the mark) with a confirmed loop
+        uint32_t slots = *instr_to_exec / s->idle_loop_len * s->idle_loop_len;
+        s->idle_loop_len = 0;
+        if (slots == 0)
+            return 0;
+        if (g_idle_mode == idle_verify) {
+            *instr_to_exec = slots;
+            s->idle_verify_pending = true;
+            return 0;
+        }
+        g_idle_skipped += slots;
+        return slots;
+    }
+    if (s->idle_probe_steps != 0) {
+        *instr_to_exec = 1;
+        return 0;
+    }
+    if (*instr_to_exec < IDLE_MIN_SPRINT)
+        return 0;
+    if (s->idle_cooldown != 0) {
+        s->idle_cooldown--;
+        return 0;
+    }
+    if (cpu_idle_mark(s->cpu) == CPU_IDLE_NO) {
+        idle_probe_failed(s);
+        return 0;
+    }
+    s->idle_probe_steps = 1;
+    *instr_to_exec = 1;
+    return 0;
+}
+
+// Classify the CPU after a sprint shaped by idle_plan_sprint.  Runs before
+// the sprint's due events fire: those may raise the IPL or change memory, so
+// the caller abandons any probe or confirmed loop when one does.
+static void idle_after_sprint(struct scheduler *s) {
+    if (s->idle_verify_pending) {
+        s->idle_verify_pending = false;
+        if (cpu_idle_step(s->cpu) != CPU_IDLE_LOOP) {
+            g_idle_verify_failures++;
+            LOG(1, "idle verify: loop at pc=$%08X did not repeat", cpu_get_pc(s->cpu));
+        }
+        return;
+    }
+    if (s->idle_probe_steps == 0)
+        return;
+    switch (cpu_idle_step(s->cpu)) {
+    case CPU_IDLE_LOOP:
+        s->idle_loop_len = s->idle_probe_steps;
+        s->idle_probe_steps = 0;
+        s->idle_backoff = 0;
+        g_idle_loops++;
+        break;
+    case CPU_IDLE_MAYBE:
+        if (++s->idle_probe_steps <= IDLE_PROBE_MAX)
+            break;
+        // fall through
+    default:
+        idle_probe_failed(s);
+        break;
+    }
 }
 
 // ============================================================================
@@ -648,8 +899,9 @@ uint64_t cmd_events(int argc, char *argv[]) {
 
     printf("#   when(cyc)      +Δcyc     +Δµs    source.event                       data\n");
 
-    int idx = 0;
-    for (event_t *e = s->cpu_events; e; e = e->next) {
+    event_t **sorted = sorted_events(s);
+    for (int idx = 0; idx < count; idx++) {
+        const event_t *e = sorted[idx];
         int64_t delta_cycles = (int64_t)e->timestamp - (int64_t)s->cpu_cycles;
         uint64_t abs_delta = (delta_cycles >= 0) ? (uint64_t)delta_cycles : (uint64_t)(-delta_cycles);
 
@@ -668,8 +920,8 @@ uint64_t cmd_events(int argc, char *argv[]) {
 
         printf("%-3d %-13llu %-9lld %8.3f  %-30s  0x%016llx\n", idx, (unsigned long long)e->timestamp,
                (long long)delta_cycles, delta_us, namebuf, (unsigned long long)e->data);
-        idx++;
     }
+    free(sorted);
 
     return 0;
 }
@@ -688,7 +940,6 @@ struct scheduler *scheduler_init(struct cpu *cpu, checkpoint_t *checkpoint) {
         return NULL;
 
     s->cpu = cpu;
-    s->cpu_events = NULL;
     s->running = false;
     s->vbl_acc_error = 0;
     s->previous_time = host_time();
@@ -799,12 +1050,9 @@ void scheduler_delete(struct scheduler *scheduler) {
 
     // Free pending CPU events (through the pool so a follow-up scheduler
     // instance can recycle them)
-    event_t *e = scheduler->cpu_events;
-    while (e) {
-        event_t *next = e->next;
-        event_free(e);
-        e = next;
-    }
+    for (uint32_t i = 0; i < scheduler->num_events; i++)
+        event_free(scheduler->events[i]);
+    free(scheduler->events);
 
     // Free temporary checkpoint restore data
     if (scheduler->tmp_events) {
@@ -841,9 +1089,10 @@ void scheduler_checkpoint(struct scheduler *restrict scheduler, checkpoint_t *ch
     event_as_checkpoint_t *events_to_save =
         num_events ? (event_as_checkpoint_t *)calloc(num_events, sizeof(event_as_checkpoint_t)) : NULL;
 
-    event_t *e = scheduler->cpu_events;
+    // Saved in fire order, so restore re-inserts them with the same tie order
+    event_t **sorted = sorted_events(scheduler);
     for (unsigned int i = 0; i < num_events; i++) {
-        GS_ASSERT(e != NULL);
+        const event_t *e = sorted[i];
         events_to_save[i].timestamp = e->timestamp;
         events_to_save[i].data = e->data;
 
@@ -860,9 +1109,8 @@ void scheduler_checkpoint(struct scheduler *restrict scheduler, checkpoint_t *ch
             }
         }
         GS_ASSERTF(found, "event at timestamp %llu has no registered type", (unsigned long long)e->timestamp);
-
-        e = e->next;
     }
+    free(sorted);
 
     if (num_events) {
         system_write_checkpoint_data(checkpoint, events_to_save, num_events * sizeof(event_as_checkpoint_t));
@@ -916,8 +1164,10 @@ void scheduler_start(struct scheduler *restrict s) {
         e->callback = s->event_types[found].callback;
         e->source = s->event_types[found].source;
         e->data = saved->data;
+        e->type = found;
+        e->heap_pos = EVENT_NOT_QUEUED;
 
-        s->cpu_events = insert_event_queue(s->cpu_events, e);
+        insert_event_queue(s, e);
     }
 
     // Cleanup temporary storage
@@ -980,21 +1230,15 @@ event_t *scheduler_new_cpu_event(struct scheduler *restrict scheduler, event_cal
     // Asserting here fingers the offending caller directly. Cost is
     // O(num_event_types), typically <30 entries; trivial vs. the bug
     // class it prevents.
-    bool registered = false;
-    for (int i = 0; i < scheduler->num_event_types; i++) {
-        if (scheduler->event_types[i].callback == callback && scheduler->event_types[i].source == source) {
-            registered = true;
-            break;
-        }
-    }
-    GS_ASSERTF(registered, "scheduler_new_cpu_event: event type not registered "
+    int type = event_type_index(scheduler, source, callback);
+    GS_ASSERTF(type != EVENT_TYPE_UNREGISTERED, "scheduler_new_cpu_event: event type not registered "
                            "(call scheduler_new_event_type first for this (callback, source) pair)");
 
     CHECK_INVARIANTS(scheduler);
     validate_cpu_events(scheduler);
     reconcile_sprint(scheduler);
 
-    event_t *result = add_event_internal(scheduler, callback, source, data, cycles, ns);
+    event_t *result = add_event_internal(scheduler, type, callback, source, data, cycles, ns);
     CHECK_INVARIANTS(scheduler);
     return result;
 }
@@ -1004,16 +1248,7 @@ void remove_event(struct scheduler *restrict scheduler, event_callback_t callbac
     GS_ASSERT(scheduler != NULL);
     GS_ASSERT(callback != NULL);
 
-    event_t **ev = &scheduler->cpu_events;
-    while (*ev != NULL) {
-        if ((*ev)->callback == callback && ((*ev)->source == source || source == NULL)) {
-            event_t *to_remove = *ev;
-            *ev = to_remove->next;
-            event_free(to_remove);
-        } else {
-            ev = &(*ev)->next;
-        }
-    }
+    remove_matching_events(scheduler, callback, source, false, 0);
 }
 
 // Remove events matching callback, source, AND data value
@@ -1022,16 +1257,18 @@ void remove_event_by_data(struct scheduler *restrict scheduler, event_callback_t
     GS_ASSERT(scheduler != NULL);
     GS_ASSERT(callback != NULL);
 
-    event_t **ev = &scheduler->cpu_events;
-    while (*ev != NULL) {
-        if ((*ev)->callback == callback && ((*ev)->source == source || source == NULL) && (*ev)->data == data) {
-            event_t *to_remove = *ev;
-            *ev = to_remove->next;
-            event_free(to_remove);
-        } else {
-            ev = &(*ev)->next;
-        }
-    }
+    remove_matching_events(scheduler, callback, source, true, data);
+}
+
+// Cancel one pending event by the handle scheduler_new_cpu_event returned
+void scheduler_cancel_event(struct scheduler *restrict scheduler, event_t *event) {
+    GS_ASSERT(scheduler != NULL);
+    GS_ASSERT(event != NULL);
+    GS_ASSERTF(event->heap_pos < scheduler->num_events && scheduler->events[event->heap_pos] == event,
+               "scheduler_cancel_event: event is not pending");
+
+    unlink_event(scheduler, event);
+    event_free(event);
 }
 
 // Check if an event with the given callback is currently scheduled
@@ -1039,7 +1276,11 @@ bool has_event(struct scheduler *restrict scheduler, event_callback_t callback)
     GS_ASSERT(scheduler != NULL);
     GS_ASSERT(callback != NULL);
 
-    for (event_t *e = scheduler->cpu_events; e != NULL; e = e->next) {
+    for (int i = 0; i < scheduler->num_event_types; i++) {
+        if (scheduler->event_types[i].callback == callback && scheduler->type_events[i] != NULL)
+            return true;
+    }
+    for (event_t *e = scheduler->type_events[EVENT_TYPE_UNREGISTERED]; e != NULL; e = e->type_next) {
         if (e->callback == callback)
             return true;
     }
@@ -1193,6 +1434,12 @@ void scheduler_set_cpi(struct scheduler *restrict s, uint32_t cpi) {
     scheduler_update_cpi_eff(s);
 }
 
+// Select the idle-loop fast-forward mode (process-wide)
+void scheduler_set_idle_mode(struct scheduler *restrict s, enum idle_mode mode) {
+    (void)s;
+    g_idle_mode = mode;
+}
+
 // Run the scheduler for a specified number of instructions
 void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
     GS_ASSERT(s != NULL);
@@ -1201,15 +1448,29 @@ void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
 
     CHECK_INVARIANTS(s);
 
-    if (s->cpu_events != NULL)
-        GS_ASSERT(s->cpu_events->timestamp >= s->cpu_cycles);
+    if (next_event(s) != NULL)
+        GS_ASSERT(next_event(s)->timestamp >= s->cpu_cycles);
 
     cpu_t *cpu = s->cpu;
     s->running = true;
 
-    // Check once at loop entry whether debugger is engaged
+    // Check once at loop entry whether debugger is engaged.  Sprints run at
+    // full length; the decoders' PC watch ends one early when the PC enters a
+    // page holding a breakpoint or PC logpoint.  The instruction at the entry
+    // PC runs unchecked, as a resumed breakpoint must.
     debug_t *debugger = system_debug();
     bool debugger_active = debug_active(debugger);
+    if (debugger_active)
+        debug_pc_watch_arm(cpu_get_pc(cpu));
+
+    // Idle detection stays off under the debugger: skipped passes never reach
+    // debug_pc_hook, so a breakpoint or PC logpoint inside the loop would not
+    // fire and the trace buffer would lose them.  It always starts over: the
+    // machine may have changed since the last run
+    bool idle_active = g_idle_mode != idle_off && !debugger_active;
+    s->idle_probe_steps = 0;
+    s->idle_loop_len = 0;
+    s->idle_verify_pending = false;
 
     // Cycle budget at the effective CPI (exactly n * cpi when it is the
     // authentic integer CPI — paced/turbo budgets stay bit-identical)
@@ -1229,14 +1490,14 @@ void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
             // skip past (and clear) that window, dropping the heartbeat.
             cpu_poll_interrupt(cpu);
             if (cpu_is_stopped(cpu)) { // still halted: sleep until the next event
-                if (s->cpu_events == NULL)
+                event_t *next = next_event(s);
+                if (next == NULL)
                     break; // nothing scheduled can ever wake it; end the run
-                uint64_t cte =
-                    (s->cpu_events->timestamp > s->cpu_cycles) ? (s->cpu_events->timestamp - s->cpu_cycles) : 0;
+                uint64_t cte = (next->timestamp > s->cpu_cycles) ? (next->timestamp - s->cpu_cycles) : 0;
                 uint64_t advance = MIN(cte, remaining_cycles);
                 remaining_cycles -= advance;
                 s->cpu_cycles += advance;
-                process_event_queue(&s->cpu_events, s->cpu_cycles);
+                process_event_queue(s, s->cpu_cycles);
                 cpu_poll_interrupt(cpu); // event may have raised the IPL → take it (clears stopped)
             }
             continue;
@@ -1245,11 +1506,11 @@ void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
         uint64_t cycles_to_execute = remaining_cycles;
 
         // Clamp to next event if one exists
-        if (s->cpu_events != NULL) {
-            GS_ASSERT(s->cpu_events->timestamp >= s->cpu_cycles);
+        event_t *next = next_event(s);
+        if (next != NULL) {
+            GS_ASSERT(next->timestamp >= s->cpu_cycles);
 
-            uint64_t cycles_to_event =
-                (s->cpu_events->timestamp > s->cpu_cycles) ? s->cpu_events->timestamp - s->cpu_cycles : 0;
+            uint64_t cycles_to_event = (next->timestamp > s->cpu_cycles) ? next->timestamp - s->cpu_cycles : 0;
             cycles_to_execute = MIN(cycles_to_event, remaining_cycles);
         }
 
@@ -1258,13 +1519,13 @@ void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
         if (cycles_to_execute > 0 && instr_to_exec == 0)
             instr_to_exec = 1;
 
-        // Single-step when debugger is active
-        if (debugger_active)
-            instr_to_exec = 1;
+        // Idle fast-forward: probe steps, or whole passes of a proven idle
+        // loop that count as executed without running (see idle_plan_sprint)
+        uint32_t idle_skip = idle_active ? idle_plan_sprint(s, &instr_to_exec) : 0;
 
         // Execute sprint — expose burndown pointer and CPI for I/O penalty mechanism
         s->sprint_total = instr_to_exec;
-        s->sprint_burndown = instr_to_exec;
+        s->sprint_burndown = instr_to_exec - idle_skip;
         g_sprint_burndown_ptr = &s->sprint_burndown;
         g_io_cpi_x256 = s->cpi_eff_x256;
         g_io_phantom_instructions = 0;
@@ -1295,7 +1556,7 @@ void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
         s->cycle_frac_x256 = (uint32_t)(advance_x256 & 0xFF);
 
         // Overshoot check: allow up to one (authentic-CPI) instruction of overshoot
-        if (s->cpu_events != NULL) {
+        if (next_event(s) != NULL) {
             GS_ASSERT(executed_cycles <= cycles_to_execute + avg_cycles_per_instr(s));
         }
 
@@ -1313,25 +1574,32 @@ void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
         s->cpu_cycles += executed_cycles;
 
         // Verify event queue integrity after advancing cycles
-        if (s->cpu_events != NULL) {
-            GS_ASSERT(s->cpu_events->timestamp + avg_cycles_per_instr(s) >= s->cpu_cycles);
+        if (next_event(s) != NULL) {
+            GS_ASSERT(next_event(s)->timestamp + avg_cycles_per_instr(s) >= s->cpu_cycles);
         }
 
-        // Handle debugger single-step
-        if (debugger_active) {
-            if (debug_break_and_trace()) {
-                remaining_cycles = 0;
-                s->running = false;
-                break;
-            }
+        if (idle_active)
+            idle_after_sprint(s);
+
+        // Handle a sprint the debugger's PC watch ended (checked even when the
+        // watch was off at entry, so one installed mid-run cannot stall)
+        if (debug_break_and_trace()) {
+            remaining_cycles = 0;
+            s->running = false;
+            break;
         }
 
         // Fire any events that are now due
-        process_event_queue(&s->cpu_events, s->cpu_cycles);
+        uint64_t fired_before = g_sched_events_fired;
+        process_event_queue(s, s->cpu_cycles);
+        if (idle_active && g_sched_events_fired != fired_before) {
+            s->idle_probe_steps = 0;
+            s->idle_loop_len = 0;
+        }
 
         // Verify event callbacks didn't schedule events in the past
-        if (s->cpu_events != NULL)
-            GS_ASSERT(s->cpu_events->timestamp >= s->cpu_cycles);
+        if (next_event(s) != NULL)
+            GS_ASSERT(next_event(s)->timestamp >= s->cpu_cycles);
 
         if (!s->running) {
             reconcile_sprint(s);
@@ -1340,8 +1608,8 @@ void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n) {
     }
 
     GS_ASSERT(s->sprint_burndown <= s->sprint_total);
-    if (s->cpu_events != NULL)
-        GS_ASSERT(s->cpu_events->timestamp >= s->cpu_cycles);
+    if (next_event(s) != NULL)
+        GS_ASSERT(next_event(s)->timestamp >= s->cpu_cycles);
 
     CHECK_INVARIANTS(s);
 }
@@ -1353,8 +1621,8 @@ void scheduler_run(struct scheduler *restrict s, double time) {
 
     CHECK_INVARIANTS(s);
 
-    if (s->cpu_events != NULL)
-        GS_ASSERT(s->cpu_events->timestamp >= s->cpu_cycles);
+    if (next_event(s) != NULL)
+        GS_ASSERT(next_event(s)->timestamp >= s->cpu_cycles);
 
     s->running = true;
 
@@ -1374,8 +1642,8 @@ void scheduler_run_usecs(struct scheduler *restrict s, uint64_t usecs) {
 
     CHECK_INVARIANTS(s);
 
-    if (s->cpu_events != NULL)
-        GS_ASSERT(s->cpu_events->timestamp >= s->cpu_cycles);
+    if (next_event(s) != NULL)
+        GS_ASSERT(next_event(s)->timestamp >= s->cpu_cycles);
 
     s->running = true;
 
@@ -1390,8 +1658,19 @@ void scheduler_run_usecs(struct scheduler *restrict s, uint64_t usecs) {
 // caller decides how many frame-units to run and at what pace; this just does
 // one.  scheduler_run() clamps to the next event, so a run_stop_event or a
 // breakpoint inside the period stops the frame early (running goes false), and
-// the caller's loop sees it.
+// the caller's loop sees it.  It is also the unit the reverse-execution
+// history records and snapshots between (debug/history.c).
 void scheduler_run_frame(struct scheduler *restrict s, config_t *config) {
+    GS_ASSERT(s != NULL);
+    GS_ASSERT(config != NULL);
+    history_frame_begin(config);
+    trigger_vbl(config);
+    scheduler_run(s, MAC_VBL_PERIOD);
+    history_frame_end(config);
+}
+
+// One frame-unit outside the history (its replay runs recorded frames here)
+void scheduler_replay_frame(struct scheduler *restrict s, config_t *config) {
     GS_ASSERT(s != NULL);
     GS_ASSERT(config != NULL);
     trigger_vbl(config);
@@ -1609,6 +1888,59 @@ static value_t sched_attr_max_speed_set(struct object *self, const member_t *m,
     return val_none();
 }
 
+static const char *idle_label(enum idle_mode mode) {
+    switch (mode) {
+    case idle_on:
+        return "on";
+    case idle_verify:
+        return "verify";
+    default:
+        return "off";
+    }
+}
+
+static value_t sched_attr_idle_get(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_str(idle_label(g_idle_mode));
+}
+static value_t sched_attr_idle_set(struct object *self, const member_t *m, value_t in) {
+    (void)m;
+    enum idle_mode mode;
+    if (strcmp(in.s, "off") == 0)
+        mode = idle_off;
+    else if (strcmp(in.s, "on") == 0)
+        mode = idle_on;
+    else if (strcmp(in.s, "verify") == 0)
+        mode = idle_verify;
+    else {
+        value_t e = val_err("scheduler.idle: unknown mode '%s' (valid: off, on, verify)", in.s);
+        value_free(&in);
+        return e;
+    }
+    value_free(&in);
+    scheduler_set_idle_mode(sched_self_from(self), mode);
+    return val_none();
+}
+
+static value_t sched_attr_idle_loops(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(8, g_idle_loops);
+}
+
+static value_t sched_attr_idle_skipped(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(8, g_idle_skipped);
+}
+
+static value_t sched_attr_idle_verify_failures(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(8, g_idle_verify_failures);
+}
+
 static value_t sched_attr_cycles(struct object *self, const member_t *m) {
     (void)m;
     return val_uint(8, scheduler_cpu_cycles(sched_self_from(self)));
@@ -1714,6 +2046,27 @@ static const member_t scheduler_members[] = {
      .doc = "Cap on the accelerated-mode multiplier (1.0..8.0): the adaptive governor's ceiling, and pinned "
             "speeds are clamped to it. Persisted", .flags = 0,
      .attr = {.type = V_FLOAT, .get = sched_attr_max_speed, .set = sched_attr_max_speed_set}},
+    {.kind = M_ATTR,
+     .name = "idle",
+     .doc = "Idle-loop fast-forward ('off' | 'on' | 'verify'): skip passes of provably idle polling loops up to "
+            "the next event (bit-identical), or in 'verify' run them and check the prediction. Process-wide",
+     .flags = 0,
+     .attr = {.type = V_STRING, .get = sched_attr_idle_get, .set = sched_attr_idle_set}},
+    {.kind = M_ATTR,
+     .name = "idle_loops",
+     .doc = "Idle loops confirmed by the detector since process start",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = sched_attr_idle_loops, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "idle_skipped",
+     .doc = "Instructions fast-forwarded by the idle detector since process start",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = sched_attr_idle_skipped, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "idle_verify_failures",
+     .doc = "Verify mode: predicted idle passes that did not leave the CPU unchanged (should stay 0)",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = sched_attr_idle_verify_failures, .set = NULL}},
     {.kind = M_ATTR,
      .name = "cycles",
      .doc = "Total CPU cycles executed so far",
@@ -43,6 +43,14 @@ typedef void (*event_callback_t)(void *source, uint64_t data);
 // per frame-unit scale with the speed setting.
 enum schedule_mode { schedule_paced, schedule_unthrottled, schedule_accelerated };
 
+// Idle-loop fast-forward (scheduler.idle, headless --idle=):
+//   idle_off    — default; every instruction executes
+//   idle_on     — polling loops proven idle (see scheduler.c) are fast-forwarded
+//                 to the next event; the run stays bit-identical
+//   idle_verify — detect the same loops but execute them, checking each
+//                 prediction (failures are logged and counted)
+enum idle_mode { idle_off, idle_on, idle_verify };
+
 struct scheduler;
 typedef struct scheduler scheduler_t;
 
@@ -74,6 +82,10 @@ void remove_event(struct scheduler *restrict scheduler, event_callback_t callbac
 // Remove events matching callback, source, and data value
 void remove_event_by_data(struct scheduler *restrict scheduler, event_callback_t callback, void *source, uint64_t data);
 
+// Cancel one pending event by its handle.  The handle is only valid until the
+// event fires or is removed; callers that keep one must drop it then.
+void scheduler_cancel_event(struct scheduler *restrict scheduler, event_t *event);
+
 // Register a new event type for checkpoint save/restore
 void scheduler_new_event_type(struct scheduler *restrict scheduler, const char *source_name, void *source,
                               const char *event_name, event_callback_t callback);
@@ -101,6 +113,11 @@ void scheduler_main_loop(config_t *restrict config, double now_msecs);
 // targets, differing only in how fast the host issues the ticks.
 void scheduler_run_frame(struct scheduler *restrict s, config_t *config);
 
+// scheduler_run_frame() without the reverse-execution hooks (debug/history.h):
+// the frame is neither recorded nor able to take a snapshot.  History replay
+// re-executes recorded frames through this.
+void scheduler_replay_frame(struct scheduler *restrict s, config_t *config);
+
 // Run the scheduler for a specified number of instructions
 void scheduler_run_instructions(struct scheduler *restrict s, uint64_t n);
 
@@ -149,6 +166,10 @@ void scheduler_set_frequency(struct scheduler *restrict s, uint32_t frequency_hz
 // in every pacing mode — one guest timeline.
 void scheduler_set_cpi(struct scheduler *restrict s, uint32_t cpi);
 
+// Select the idle-loop fast-forward mode. Process-wide and not checkpointed,
+// so it survives restores; the scheduler argument is for symmetry.
+void scheduler_set_idle_mode(struct scheduler *restrict s, enum idle_mode mode);
+
 // Get the total number of CPU instructions executed so far
 uint64_t cpu_instr_count(void);
 
@@ -5,9 +5,9 @@
 // Recursive `cp` command built on the VFS.  Copying between any two
 // backends works because both source reads and destination writes go
 // through vfs_* — copying out of an auto-mounted image into OPFS or the
-// host filesystem is the primary Phase 2 user story.  Destination is
-// always the host backend in v1 (image writes return -EROFS
-// structurally; see §2.9 in proposal-image-vfs.md).
+// host filesystem is the primary Phase 2 user story.  A destination inside
+// a writable image (classic HFS, see image_vfs.h) takes each file whole
+// through vfs_put_file, forks and Finder info included.
 //
 // Fork handling: a file copied OUT of an image that carries a resource fork
 // and/or non-trivial Finder Info is materialised as an AppleDouble pair — the
@@ -15,7 +15,10 @@
 // the resource fork (entry 2) + Finder Info (entry 9).  This is lossless (an
 // NDIF `.img`, whose block map lives in the resource fork, survives a
 // round-trip) and interoperates with macOS/Netatalk/tar.  Data-only files stay
-// single clean streams.  See proposal-appledouble-support.md §4.3.
+// single clean streams.  See proposal-appledouble-support.md §4.3.  Copying
+// INTO an image reverses this: the forks come from the source's /rsrc/_raw
+// and /finf (image sources) or its "._<name>" sidecar (host sources), and
+// the sidecars themselves are not copied as files.
 
 #include "appledouble.h"
 #include "shell.h"
@@ -34,6 +37,7 @@ struct cp_stats {
     uint64_t files_copied;
     uint64_t bytes_copied;
     uint64_t dirs_created;
+    bool into_image; // destination backend takes whole files (vfs_put_file)
     // Precise failure detail (which side failed, path, offset) set on the
     // first error so callers can distinguish a source read from a dest write.
     char detail[320];
@@ -177,9 +181,96 @@ static int maybe_write_fork_sidecar(const char *src, const char *dst, struct cp_
     return 0;
 }
 
+// Read the resource fork and Finder info to carry into an image: the
+// source's own forks when it lives in an image, else its AppleDouble
+// "._<name>" sidecar.  Either output may come back empty.
+static void read_source_forks(const char *src, uint8_t **rsrc, size_t *rsrc_len, uint8_t finder[AD_FINDER_INFO_SIZE],
+                              bool *has_finder) {
+    char path[VFS_PATH_MAX];
+    uint8_t *finf = NULL;
+    size_t finf_len = 0;
+    *has_finder = false;
+    snprintf(path, sizeof(path), "%s/rsrc/_raw", src);
+    int rrc = read_vfs_file_all(path, rsrc, rsrc_len);
+    snprintf(path, sizeof(path), "%s/finf", src);
+    int frc = read_vfs_file_all(path, &finf, &finf_len);
+    if (frc == 0 && finf_len == AD_FINDER_INFO_SIZE) {
+        memcpy(finder, finf, AD_FINDER_INFO_SIZE);
+        *has_finder = true;
+    }
+    free(finf);
+    if (rrc == 0 || frc == 0)
+        return;
+
+    const char *slash = strrchr(src, '/');
+    if (slash)
+        snprintf(path, sizeof(path), "%.*s/._%s", (int)(slash - src), src, slash + 1);
+    else
+        snprintf(path, sizeof(path), "._%s", src);
+    uint8_t *hdr = NULL;
+    size_t hdr_len = 0;
+    ad_file_t ad;
+    if (read_vfs_file_all(path, &hdr, &hdr_len) != 0 || ad_parse(hdr, hdr_len, &ad) != 0) {
+        free(hdr);
+        return;
+    }
+    if (ad.rsrc_len && (*rsrc = malloc(ad.rsrc_len)) != NULL) {
+        memcpy(*rsrc, ad.rsrc, ad.rsrc_len);
+        *rsrc_len = ad.rsrc_len;
+    }
+    if (ad.finder && ad.finder_len >= AD_FINDER_INFO_SIZE) {
+        memcpy(finder, ad.finder, AD_FINDER_INFO_SIZE);
+        *has_finder = true;
+    }
+    free(hdr);
+}
+
+// Copy a file into an image in one vfs_put_file call: data fork, resource
+// fork and Finder info.
+static int put_file_into_image(const char *src, const char *dst, struct cp_stats *s) {
+    uint8_t *data = NULL, *rsrc = NULL;
+    size_t data_len = 0, rsrc_len = 0;
+    uint8_t finder[AD_FINDER_INFO_SIZE];
+    bool has_finder = false;
+    int rc = read_vfs_file_all(src, &data, &data_len);
+    if (rc < 0) {
+        snprintf(s->detail, sizeof(s->detail), "cannot read source '%s': %s", src, strerror(-rc));
+        return rc;
+    }
+    read_source_forks(src, &rsrc, &rsrc_len, finder, &has_finder);
+    vfs_put_t put = {
+        .data = data,
+        .data_len = data_len,
+        .rsrc = rsrc,
+        .rsrc_len = rsrc_len,
+        .finder_info = has_finder ? finder : NULL,
+    };
+    rc = vfs_put_file(dst, &put);
+    free(data);
+    free(rsrc);
+    if (rc < 0) {
+        snprintf(s->detail, sizeof(s->detail), "cannot write '%s': %s", dst, strerror(-rc));
+        return rc;
+    }
+    s->files_copied++;
+    s->bytes_copied += data_len + rsrc_len;
+    return 0;
+}
+
+// True if `path` resolves to a backend that takes whole files (an image).
+static bool takes_whole_files(const char *path) {
+    char resolved[VFS_PATH_MAX];
+    const vfs_backend_t *be = NULL;
+    void *ctx = NULL;
+    const char *tail = NULL;
+    return vfs_resolve(path, resolved, sizeof(resolved), &be, &ctx, &tail) == 0 && be->put_file;
+}
+
 // Copy bytes from a single source file to a single destination path.
 // Returns 0 on success, a negative errno on failure.  Writes counters.
 static int copy_file(const char *src, const char *dst, struct cp_stats *s) {
+    if (s->into_image)
+        return put_file_into_image(src, dst, s);
     vfs_file_t *in = NULL;
     const vfs_backend_t *in_be = NULL;
     int rc = vfs_open(src, &in, &in_be);
@@ -278,6 +369,9 @@ static int copy_recursive(const char *src, const char *dst, struct cp_stats *s)
     while ((r = be->readdir(d, &e)) > 0) {
         if (strcmp(e.name, ".") == 0 || strcmp(e.name, "..") == 0)
             continue;
+        // AppleDouble sidecars travel with their file, not as files of their own
+        if (s->into_image && strncmp(e.name, "._", 2) == 0)
+            continue;
         if (n == cap) {
             size_t ncap = cap ? cap * 2 : 32;
             char(*nb)[256] = realloc(names, ncap * 256);
@@ -350,6 +444,7 @@ int shell_cp(const char *src, const char *dst, bool recursive, char *err_buf, si
     }
 
     struct cp_stats s = {0};
+    s.into_image = takes_whole_files(final_dst);
     rc = copy_recursive(src, final_dst, &s);
     if (rc < 0) {
         if (err_buf && err_cap) {
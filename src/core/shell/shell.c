@@ -536,6 +536,8 @@ int shell_init(void) {
     extern void vrom_init(void);
     extern void machine_init(void);
     extern void checkpoint_init(void);
+    extern void snapshot_store_init(void);
+    extern void history_init(void);
     extern void archive_init(void);
     extern void mouse_class_register(void);
     extern void keyboard_class_register(void);
@@ -547,6 +549,8 @@ int shell_init(void) {
     vrom_init();
     machine_init();
     checkpoint_init();
+    snapshot_store_init();
+    history_init();
     archive_init();
     mouse_class_register();
     keyboard_class_register();
@@ -0,0 +1,558 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// snapshot_pool.c
+// Content-addressed object pool for snapshot checkpoints: the content hash,
+// hash sets, object storage, the sweep half of garbage collection, and the
+// reference-counted in-memory pool.
+
+#include "snapshot_pool.h"
+#include "chunk_lz.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Longest object path: pool dir + "/xx/" + 30 hex digits + ".tmp"
+#define OBJECT_PATH_EXTRA (4 + SNAPSHOT_HASH_LEN * 2 + 5)
+
+// === Content hash ===
+// MurmurHash3 x64_128 (public domain, Austin Appleby) over host-order words,
+// like the rest of the checkpoint format.
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDull;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+void snapshot_hash(const void *data, size_t size, snapshot_hash_t *out) {
+    const uint64_t c1 = 0x87C37B91114253D5ull;
+    const uint64_t c2 = 0x4CF5AD432745937Full;
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h1 = 0x9E3779B97F4A7C15ull;
+    uint64_t h2 = 0x9E3779B97F4A7C15ull;
+    size_t blocks = size / 16;
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t k1, k2;
+        memcpy(&k1, p + i * 16, 8);
+        memcpy(&k2, p + i * 16 + 8, 8);
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52DCE729;
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495AB5;
+    }
+
+    // Tail: the last 0-15 bytes, zero-extended
+    size_t rest = size & 15;
+    if (rest) {
+        uint8_t tail[16] = {0};
+        memcpy(tail, p + blocks * 16, rest);
+        uint64_t k1, k2;
+        memcpy(&k1, tail, 8);
+        memcpy(&k2, tail + 8, 8);
+        if (rest > 8) {
+            k2 *= c2;
+            k2 = rotl64(k2, 33);
+            k2 *= c1;
+            h2 ^= k2;
+        }
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= (uint64_t)size;
+    h2 ^= (uint64_t)size;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+    memcpy(out->bytes, &h1, 8);
+    memcpy(out->bytes + 8, &h2, 8);
+}
+
+void snapshot_hash_hex(const snapshot_hash_t *hash, char out[SNAPSHOT_HASH_LEN * 2 + 1]) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < SNAPSHOT_HASH_LEN; i++) {
+        out[i * 2] = digits[hash->bytes[i] >> 4];
+        out[i * 2 + 1] = digits[hash->bytes[i] & 15];
+    }
+    out[SNAPSHOT_HASH_LEN * 2] = '\0';
+}
+
+// Parse 32 hex digits back into a hash
+static bool hash_parse(const char *hex, snapshot_hash_t *out) {
+    for (int i = 0; i < SNAPSHOT_HASH_LEN * 2; i++) {
+        char c = hex[i];
+        int v = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (v < 0)
+            return false;
+        if (i & 1)
+            out->bytes[i / 2] |= (uint8_t)v;
+        else
+            out->bytes[i / 2] = (uint8_t)(v << 4);
+    }
+    return hex[SNAPSHOT_HASH_LEN * 2] == '\0';
+}
+
+// === Hash sets ===
+// Open addressing over the (already uniform) first eight hash bytes; slots
+// hold item index + 1, zero = empty.  Grown at half load.
+
+struct snapshot_hash_set {
+    snapshot_hash_t *items;
+    size_t count;
+    size_t items_cap;
+    uint32_t *slots;
+    size_t slot_mask;
+};
+
+snapshot_hash_set_t *snapshot_hash_set_new(void) {
+    snapshot_hash_set_t *set = (snapshot_hash_set_t *)calloc(1, sizeof(*set));
+    if (!set)
+        return NULL;
+    set->slots = (uint32_t *)calloc(64, sizeof(uint32_t));
+    if (!set->slots) {
+        free(set);
+        return NULL;
+    }
+    set->slot_mask = 63;
+    return set;
+}
+
+void snapshot_hash_set_free(snapshot_hash_set_t *set) {
+    if (!set)
+        return;
+    free(set->items);
+    free(set->slots);
+    free(set);
+}
+
+// Slot index to probe first for hash
+static size_t set_home(const snapshot_hash_set_t *set, const snapshot_hash_t *hash) {
+    uint64_t key;
+    memcpy(&key, hash->bytes, sizeof(key));
+    return (size_t)key & set->slot_mask;
+}
+
+// Slot holding hash, or the empty slot where it would go
+static size_t set_find(const snapshot_hash_set_t *set, const snapshot_hash_t *hash) {
+    size_t i = set_home(set, hash);
+    while (set->slots[i] && memcmp(&set->items[set->slots[i] - 1], hash, sizeof(*hash)) != 0)
+        i = (i + 1) & set->slot_mask;
+    return i;
+}
+
+// Double the slot table and reinsert every item
+static bool set_grow(snapshot_hash_set_t *set) {
+    size_t cap = (set->slot_mask + 1) * 2;
+    uint32_t *slots = (uint32_t *)calloc(cap, sizeof(uint32_t));
+    if (!slots)
+        return false;
+    free(set->slots);
+    set->slots = slots;
+    set->slot_mask = cap - 1;
+    for (size_t n = 0; n < set->count; n++)
+        set->slots[set_find(set, &set->items[n])] = (uint32_t)(n + 1);
+    return true;
+}
+
+bool snapshot_hash_set_add(snapshot_hash_set_t *set, const snapshot_hash_t *hash, size_t *index, bool *added) {
+    size_t slot = set_find(set, hash);
+    if (set->slots[slot]) {
+        if (index)
+            *index = set->slots[slot] - 1;
+        if (added)
+            *added = false;
+        return true;
+    }
+    if (set->count + 1 > (set->slot_mask + 1) / 2) {
+        if (set->count >= UINT32_MAX - 1 || !set_grow(set))
+            return false;
+        slot = set_find(set, hash);
+    }
+    if (set->count == set->items_cap) {
+        size_t cap = set->items_cap ? set->items_cap * 2 : 64;
+        snapshot_hash_t *items = (snapshot_hash_t *)realloc(set->items, cap * sizeof(*items));
+        if (!items)
+            return false;
+        set->items = items;
+        set->items_cap = cap;
+    }
+    set->items[set->count] = *hash;
+    set->slots[slot] = (uint32_t)(set->count + 1);
+    if (index)
+        *index = set->count;
+    if (added)
+        *added = true;
+    set->count++;
+    return true;
+}
+
+bool snapshot_hash_set_has(const snapshot_hash_set_t *set, const snapshot_hash_t *hash) {
+    return set->slots[set_find(set, hash)] != 0;
+}
+
+size_t snapshot_hash_set_count(const snapshot_hash_set_t *set) {
+    return set->count;
+}
+
+const snapshot_hash_t *snapshot_hash_set_items(const snapshot_hash_set_t *set) {
+    return set->items;
+}
+
+// === Pool ===
+
+// Objects this process has written or found in g_known_dir, so repeated
+// saves skip the existence check; dropped whenever the pool is swept
+static snapshot_hash_set_t *g_known;
+static char *g_known_dir;
+
+// Known-object set for pool_dir (reset when another pool is used)
+static snapshot_hash_set_t *known_for(const char *pool_dir) {
+    if (g_known && g_known_dir && strcmp(g_known_dir, pool_dir) == 0)
+        return g_known;
+    snapshot_hash_set_free(g_known);
+    free(g_known_dir);
+    g_known = snapshot_hash_set_new();
+    g_known_dir = strdup(pool_dir);
+    if (!g_known || !g_known_dir) {
+        snapshot_hash_set_free(g_known);
+        free(g_known_dir);
+        g_known = NULL;
+        g_known_dir = NULL;
+    }
+    return g_known;
+}
+
+char *snapshot_pool_dir_for(const char *checkpoint_path) {
+    const char *slash = strrchr(checkpoint_path, '/');
+    size_t dir_len = slash ? (size_t)(slash - checkpoint_path) : 1;
+    char *out = (char *)malloc(dir_len + sizeof("/pool"));
+    if (!out)
+        return NULL;
+    if (slash)
+        memcpy(out, checkpoint_path, dir_len);
+    else
+        out[0] = '.';
+    memcpy(out + dir_len, "/pool", sizeof("/pool"));
+    return out;
+}
+
+// Path of an object (out holds strlen(pool_dir) + OBJECT_PATH_EXTRA bytes)
+static void object_path(char *out, size_t cap, const char *pool_dir, const snapshot_hash_t *hash) {
+    char hex[SNAPSHOT_HASH_LEN * 2 + 1];
+    snapshot_hash_hex(hash, hex);
+    snprintf(out, cap, "%s/%.2s/%s", pool_dir, hex, hex + 2);
+}
+
+// Write size bytes to path through a temporary file and a rename
+static bool write_object(const char *path, const uint8_t *data, size_t size) {
+    size_t len = strlen(path);
+    char *tmp = (char *)malloc(len + 5);
+    if (!tmp)
+        return false;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    FILE *f = fopen(tmp, "wb");
+    bool ok = f && fwrite(data, 1, size, f) == size;
+    if (f && fclose(f) != 0)
+        ok = false;
+    if (ok && rename(tmp, path) != 0)
+        ok = false;
+    if (!ok)
+        unlink(tmp);
+    free(tmp);
+    return ok;
+}
+
+bool snapshot_pool_put(const char *pool_dir, const void *data, size_t size, snapshot_hash_t *hash) {
+    snapshot_hash(data, size, hash);
+    snapshot_hash_set_t *known = known_for(pool_dir);
+    if (known && snapshot_hash_set_has(known, hash))
+        return true;
+
+    size_t cap = strlen(pool_dir) + OBJECT_PATH_EXTRA;
+    char *path = (char *)malloc(cap);
+    if (!path)
+        return false;
+    object_path(path, cap, pool_dir, hash);
+    struct stat st;
+    bool ok = stat(path, &st) == 0;
+    if (!ok) {
+        // Create the pool and fan-out directories on demand
+        char *sep = strrchr(path, '/');
+        *sep = '\0';
+        if (mkdir(path, 0777) != 0 && errno == ENOENT) {
+            mkdir(pool_dir, 0777);
+            mkdir(path, 0777);
+        }
+        *sep = '/';
+
+        size_t comp_cap = chunk_lz_bound(size);
+        uint8_t *comp = (uint8_t *)malloc(comp_cap);
+        size_t comp_size = comp ? chunk_lz_encode((const uint8_t *)data, size, comp, comp_cap) : 0;
+        ok = comp_size && write_object(path, comp, comp_size);
+        free(comp);
+        if (!ok)
+            printf("Error: Failed to store snapshot object %s\n", path);
+    }
+    if (ok && known)
+        snapshot_hash_set_add(known, hash, NULL, NULL);
+    free(path);
+    return ok;
+}
+
+bool snapshot_pool_get(const char *pool_dir, const snapshot_hash_t *hash, void *data, size_t size) {
+    size_t cap = strlen(pool_dir) + OBJECT_PATH_EXTRA;
+    char *path = (char *)malloc(cap);
+    if (!path)
+        return false;
+    object_path(path, cap, pool_dir, hash);
+    FILE *f = fopen(path, "rb");
+    free(path);
+    if (!f)
+        return false;
+
+    // Objects are small (at most one 64 KB piece plus stream overhead)
+    size_t comp_cap = chunk_lz_bound(size) + 1;
+    uint8_t *comp = (uint8_t *)malloc(comp_cap);
+    size_t comp_size = comp ? fread(comp, 1, comp_cap, f) : 0;
+    fclose(f);
+    bool ok = comp_size > 0 && comp_size < comp_cap && chunk_lz_decode(comp, comp_size, (uint8_t *)data, size);
+    free(comp);
+    if (ok) {
+        // The name is the content: catch damaged or misfiled objects
+        snapshot_hash_t check;
+        snapshot_hash(data, size, &check);
+        ok = memcmp(&check, hash, sizeof(check)) == 0;
+    }
+    return ok;
+}
+
+long snapshot_pool_sweep(const char *pool_dir, const snapshot_hash_set_t *live, uint64_t *freed) {
+    // Whatever this process remembered may be about to go
+    snapshot_hash_set_free(g_known);
+    free(g_known_dir);
+    g_known = NULL;
+    g_known_dir = NULL;
+
+    DIR *top = opendir(pool_dir);
+    if (!top)
+        return errno == ENOENT ? 0 : -1;
+    long removed = 0;
+    size_t cap = strlen(pool_dir) + OBJECT_PATH_EXTRA + 256;
+    char *path = (char *)malloc(cap);
+    if (!path) {
+        closedir(top);
+        return -1;
+    }
+    struct dirent *de;
+    while ((de = readdir(top)) != NULL) {
+        if (strlen(de->d_name) != 2 || !strchr("0123456789abcdef", de->d_name[0]) ||
+            !strchr("0123456789abcdef", de->d_name[1]))
+            continue;
+        snprintf(path, cap, "%s/%s", pool_dir, de->d_name);
+        DIR *sub = opendir(path);
+        if (!sub)
+            continue;
+        struct dirent *ent;
+        while ((ent = readdir(sub)) != NULL) {
+            if (ent->d_name[0] == '.')
+                continue;
+            char hex[SNAPSHOT_HASH_LEN * 2 + 1];
+            snapshot_hash_t hash;
+            bool object = strlen(ent->d_name) == SNAPSHOT_HASH_LEN * 2 - 2;
+            if (object) {
+                memcpy(hex, de->d_name, 2);
+                memcpy(hex + 2, ent->d_name, SNAPSHOT_HASH_LEN * 2 - 1);
+                object = hash_parse(hex, &hash);
+            }
+            if (object && live && snapshot_hash_set_has(live, &hash))
+                continue;
+            // Unreferenced object, or a temporary file left by a failed write
+            snprintf(path, cap, "%s/%s/%s", pool_dir, de->d_name, ent->d_name);
+            struct stat st;
+            uint64_t bytes = stat(path, &st) == 0 ? (uint64_t)st.st_size : 0;
+            if (unlink(path) == 0 && object) {
+                removed++;
+                if (freed)
+                    *freed += bytes;
+            }
+        }
+        closedir(sub);
+        snprintf(path, cap, "%s/%s", pool_dir, de->d_name);
+        rmdir(path); // only succeeds once empty
+    }
+    closedir(top);
+    free(path);
+    return removed;
+}
+
+// === In-memory pool ===
+// Chained buckets indexed like the hash sets; each object holds its chunk_lz
+// stream.  Grown at load 1.
+
+typedef struct mem_object {
+    struct mem_object *next;
+    snapshot_hash_t hash;
+    uint32_t refs;
+    uint32_t size; // raw bytes
+    uint32_t packed; // stored bytes
+    uint8_t data[];
+} mem_object_t;
+
+struct snapshot_mem_pool {
+    mem_object_t **buckets;
+    size_t bucket_mask;
+    size_t count;
+    uint64_t bytes;
+};
+
+snapshot_mem_pool_t *snapshot_mem_pool_new(void) {
+    snapshot_mem_pool_t *pool = (snapshot_mem_pool_t *)calloc(1, sizeof(*pool));
+    if (!pool)
+        return NULL;
+    pool->buckets = (mem_object_t **)calloc(1024, sizeof(*pool->buckets));
+    if (!pool->buckets) {
+        free(pool);
+        return NULL;
+    }
+    pool->bucket_mask = 1023;
+    return pool;
+}
+
+void snapshot_mem_pool_free(snapshot_mem_pool_t *pool) {
+    if (!pool)
+        return;
+    for (size_t i = 0; i <= pool->bucket_mask; i++) {
+        mem_object_t *obj = pool->buckets[i];
+        while (obj) {
+            mem_object_t *next = obj->next;
+            free(obj);
+            obj = next;
+        }
+    }
+    free(pool->buckets);
+    free(pool);
+}
+
+// Bucket for hash
+static mem_object_t **mem_bucket(const snapshot_mem_pool_t *pool, const snapshot_hash_t *hash) {
+    uint64_t key;
+    memcpy(&key, hash->bytes, sizeof(key));
+    return &pool->buckets[(size_t)key & pool->bucket_mask];
+}
+
+// Link that points at the object named hash (or at NULL where it would go)
+static mem_object_t **mem_find(const snapshot_mem_pool_t *pool, const snapshot_hash_t *hash) {
+    mem_object_t **link = mem_bucket(pool, hash);
+    while (*link && memcmp(&(*link)->hash, hash, sizeof(*hash)) != 0)
+        link = &(*link)->next;
+    return link;
+}
+
+// Double the bucket table (keeps the old one when out of memory)
+static void mem_grow(snapshot_mem_pool_t *pool) {
+    size_t cap = (pool->bucket_mask + 1) * 2;
+    mem_object_t **buckets = (mem_object_t **)calloc(cap, sizeof(*buckets));
+    if (!buckets)
+        return;
+    mem_object_t **old = pool->buckets;
+    size_t old_cap = pool->bucket_mask + 1;
+    pool->buckets = buckets;
+    pool->bucket_mask = cap - 1;
+    for (size_t i = 0; i < old_cap; i++) {
+        mem_object_t *obj = old[i];
+        while (obj) {
+            mem_object_t *next = obj->next;
+            mem_object_t **head = mem_bucket(pool, &obj->hash);
+            obj->next = *head;
+            *head = obj;
+            obj = next;
+        }
+    }
+    free(old);
+}
+
+bool snapshot_mem_pool_ref(snapshot_mem_pool_t *pool, const snapshot_hash_t *hash, const void *data, size_t size) {
+    mem_object_t **link = mem_find(pool, hash);
+    if (*link) {
+        (*link)->refs++;
+        return true;
+    }
+    if (size > UINT32_MAX)
+        return false;
+    size_t cap = chunk_lz_bound(size);
+    mem_object_t *obj = (mem_object_t *)malloc(sizeof(*obj) + cap);
+    size_t packed = obj ? chunk_lz_encode((const uint8_t *)data, size, obj->data, cap) : 0;
+    if (!packed) {
+        free(obj);
+        return false;
+    }
+    // Give back the worst-case slack
+    mem_object_t *fit = (mem_object_t *)realloc(obj, sizeof(*obj) + packed);
+    obj = fit ? fit : obj;
+    obj->hash = *hash;
+    obj->refs = 1;
+    obj->size = (uint32_t)size;
+    obj->packed = (uint32_t)packed;
+    obj->next = *link;
+    *link = obj;
+    pool->count++;
+    pool->bytes += packed;
+    if (pool->count > pool->bucket_mask + 1)
+        mem_grow(pool);
+    return true;
+}
+
+bool snapshot_mem_pool_get(const snapshot_mem_pool_t *pool, const snapshot_hash_t *hash, void *data, size_t size) {
+    const mem_object_t *obj = *mem_find(pool, hash);
+    return obj && obj->size == size && chunk_lz_decode(obj->data, obj->packed, (uint8_t *)data, size);
+}
+
+void snapshot_mem_pool_release(snapshot_mem_pool_t *pool, const snapshot_hash_t *hashes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        mem_object_t **link = mem_find(pool, &hashes[i]);
+        mem_object_t *obj = *link;
+        if (!obj || --obj->refs > 0)
+            continue;
+        *link = obj->next;
+        pool->count--;
+        pool->bytes -= obj->packed;
+        free(obj);
+    }
+}
+
+size_t snapshot_mem_pool_count(const snapshot_mem_pool_t *pool) {
+    return pool ? pool->count : 0;
+}
+
+uint64_t snapshot_mem_pool_bytes(const snapshot_mem_pool_t *pool) {
+    return pool ? pool->bytes : 0;
+}
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// snapshot_pool.h
+// Content-addressed object pool shared by the checkpoints of a snapshot store.
+//
+// An object is a piece of checkpoint data (a 4 KB RAM page, or up to 64 KB of
+// any other block) named by a 128-bit hash of its bytes.  Pooled checkpoints
+// store hashes instead of data, so a page or ROM block that appears in many
+// snapshots is kept once.  Objects are chunk_lz streams in a two-level fan-out:
+//   <pool>/<first 2 hex digits>/<remaining 30 hex digits>
+// The pool lives next to the checkpoints that reference it (see
+// snapshot_pool_dir_for); snapshot_pool_sweep removes unreferenced objects.
+// The in-memory pool keeps the same objects in process memory with reference
+// counts, for the snapshot ring of reverse execution (debug/history.h).
+
+#ifndef SNAPSHOT_POOL_H
+#define SNAPSHOT_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SNAPSHOT_HASH_LEN 16
+
+// Content hash of one pool object
+typedef struct snapshot_hash {
+    uint8_t bytes[SNAPSHOT_HASH_LEN];
+} snapshot_hash_t;
+
+// Insertion-ordered set of hashes
+typedef struct snapshot_hash_set snapshot_hash_set_t;
+
+// Hash size bytes of data (128-bit, non-cryptographic)
+void snapshot_hash(const void *data, size_t size, snapshot_hash_t *out);
+
+// Format a hash as 32 lowercase hex digits plus a terminator
+void snapshot_hash_hex(const snapshot_hash_t *hash, char out[SNAPSHOT_HASH_LEN * 2 + 1]);
+
+// === Hash sets ===
+
+snapshot_hash_set_t *snapshot_hash_set_new(void);
+void snapshot_hash_set_free(snapshot_hash_set_t *set);
+
+// Add a hash.  index (optional) receives its insertion position, added
+// (optional) whether it was new.  Returns false when out of memory.
+bool snapshot_hash_set_add(snapshot_hash_set_t *set, const snapshot_hash_t *hash, size_t *index, bool *added);
+
+// True if the set holds hash
+bool snapshot_hash_set_has(const snapshot_hash_set_t *set, const snapshot_hash_t *hash);
+
+// Number of hashes, and the hashes in insertion order
+size_t snapshot_hash_set_count(const snapshot_hash_set_t *set);
+const snapshot_hash_t *snapshot_hash_set_items(const snapshot_hash_set_t *set);
+
+// === Pool ===
+
+// Pool directory for a checkpoint file: "<directory of path>/pool" (malloc'd)
+char *snapshot_pool_dir_for(const char *checkpoint_path);
+
+// Hash data into *hash and store it as an object unless the pool already
+// has it.  Returns false on I/O errors.
+bool snapshot_pool_put(const char *pool_dir, const void *data, size_t size, snapshot_hash_t *hash);
+
+// Load the object named hash into data, which must hold exactly size bytes.
+// Returns false when it is missing, damaged or of another size.
+bool snapshot_pool_get(const char *pool_dir, const snapshot_hash_t *hash, void *data, size_t size);
+
+// Delete every object (and leftover temporary file) not in live.  Returns
+// the number of objects removed and adds their bytes to *freed (optional),
+// or -1 when the pool cannot be listed.
+long snapshot_pool_sweep(const char *pool_dir, const snapshot_hash_set_t *live, uint64_t *freed);
+
+// === In-memory pool ===
+
+typedef struct snapshot_mem_pool snapshot_mem_pool_t;
+
+snapshot_mem_pool_t *snapshot_mem_pool_new(void);
+void snapshot_mem_pool_free(snapshot_mem_pool_t *pool);
+
+// Take a reference on the object named hash, storing size bytes of data as
+// it when the pool does not hold it yet.  Returns false when out of memory.
+bool snapshot_mem_pool_ref(snapshot_mem_pool_t *pool, const snapshot_hash_t *hash, const void *data, size_t size);
+
+// Load the object named hash into data, which must hold exactly size bytes.
+// Returns false when the pool does not hold it or it is of another size.
+bool snapshot_mem_pool_get(const snapshot_mem_pool_t *pool, const snapshot_hash_t *hash, void *data, size_t size);
+
+// Drop one reference on each of count objects; unreferenced objects are freed
+void snapshot_mem_pool_release(snapshot_mem_pool_t *pool, const snapshot_hash_t *hashes, size_t count);
+
+// Number of objects held, and the bytes they occupy (compressed)
+size_t snapshot_mem_pool_count(const snapshot_mem_pool_t *pool);
+uint64_t snapshot_mem_pool_bytes(const snapshot_mem_pool_t *pool);
+
+#endif // SNAPSHOT_POOL_H
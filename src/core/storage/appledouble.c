@@ -173,3 +173,41 @@ int ad_build_sidecar(const uint8_t *rsrc, size_t rsrc_len, const uint8_t *finder
         return -EINVAL;
     return ad_build(false, entries, n, out, out_len);
 }
+
+int ad_build_sidecar_header(size_t rsrc_len, const uint8_t *finder, uint8_t **out, size_t *out_len) {
+    if (!out || !out_len)
+        return -EINVAL;
+    if (!finder && !rsrc_len)
+        return -EINVAL;
+    if (rsrc_len > UINT32_MAX)
+        return -EINVAL;
+    size_t n = (finder ? 1 : 0) + (rsrc_len ? 1 : 0);
+    size_t hdr = (size_t)AD_HDR_FIXED + n * AD_DESC_SIZE;
+    size_t total = hdr + (finder ? AD_FINDER_INFO_SIZE : 0);
+
+    uint8_t *buf = (uint8_t *)calloc(1, total);
+    if (!buf)
+        return -ENOMEM;
+
+    // Same layout as ad_build_sidecar: Finder Info first, resource fork last.
+    wr32(buf, APPLEDOUBLE_MAGIC);
+    wr32(buf + 4, APPLE_FORK_VERSION);
+    wr16(buf + AD_NENTRIES_OFF, (uint16_t)n);
+    uint8_t *d = buf + AD_HDR_FIXED;
+    if (finder) {
+        wr32(d, AD_ENTRY_FINDER);
+        wr32(d + 4, (uint32_t)hdr);
+        wr32(d + 8, AD_FINDER_INFO_SIZE);
+        memcpy(buf + hdr, finder, AD_FINDER_INFO_SIZE);
+        d += AD_DESC_SIZE;
+    }
+    if (rsrc_len) {
+        wr32(d, AD_ENTRY_RSRC);
+        wr32(d + 4, (uint32_t)total);
+        wr32(d + 8, (uint32_t)rsrc_len);
+    }
+
+    *out = buf;
+    *out_len = total;
+    return 0;
+}
@@ -112,4 +112,11 @@ int ad_build(bool applesingle, const ad_entry_t *entries, size_t n_entries, uint
 int ad_build_sidecar(const uint8_t *rsrc, size_t rsrc_len, const uint8_t *finder /* 32 bytes or NULL */, uint8_t **out,
                      size_t *out_len);
 
+// Streaming form of ad_build_sidecar: everything up to (not including) the
+// resource fork bytes, which the caller appends itself — exactly `rsrc_len` of
+// them — to get the same file ad_build_sidecar would have built.  Lets a fork
+// that arrives in pieces (archive extraction) go straight to disk.
+int ad_build_sidecar_header(size_t rsrc_len, const uint8_t *finder /* 32 bytes or NULL */, uint8_t **out,
+                            size_t *out_len);
+
 #endif // GS_APPLEDOUBLE_H
@@ -17,6 +17,7 @@
 #include <errno.h>
 #include <libgen.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,9 +28,17 @@
 // Extraction helpers
 // ============================================================================
 
+// Extraction state: where files go, and the file being written right now.
+// Files arrive one fork at a time from peel_stream_path(), so only the open
+// data file and sidecar are held — never a whole fork.
 typedef struct {
     const char *output_dir;
     int file_count;
+    bool failed; // a write failed and was already reported
+    FILE *data; // data fork of the current file
+    FILE *rsrc; // its AppleDouble sidecar, positioned at the resource fork
+    char data_path[1024];
+    char sidecar_path[1024];
 } archive_ctx_t;
 
 // mkdir -p: create `path` and any missing parents.  Returns 0 on success or
@@ -115,123 +124,155 @@ static bool build_finder_info(const peel_file_meta_t *m, uint8_t out[32]) {
     return m->mac_type || m->mac_creator || m->finder_flags;
 }
 
-// Write an AppleDouble "._<name>" header sidecar next to the extracted data
-// file at `data_full_path`, carrying the resource fork (entry 2) and Finder
-// Info (entry 9).  This keeps a Mac file lossless on the flat host FS — e.g. a
+// Open the AppleDouble "._<name>" sidecar beside the data file at
+// ctx->data_path and write everything ahead of the resource fork (entry 2):
+// the header and Finder Info (entry 9).  The resource fork bytes are appended
+// as they arrive.  This keeps a Mac file lossless on the flat host FS — e.g. a
 // StuffIt/MacBinary-wrapped NDIF disk image unpacks to a mountable pair — and
 // interoperates with macOS/Netatalk (proposal-appledouble-support.md §Phase 3).
 // A file with neither a resource fork nor Finder Info gets no sidecar.
 // Returns 0 on success (including the no-sidecar case), -1 on write failure.
-static int write_ad_sidecar(const char *data_full_path, const peel_file_t *file) {
+static int open_ad_sidecar(archive_ctx_t *ctx, const peel_file_meta_t *meta, uint64_t rsrc_len) {
     uint8_t finder[32];
-    bool finder_set = build_finder_info(&file->meta, finder);
-    if (file->resource_fork.size == 0 && !finder_set)
+    bool finder_set = build_finder_info(meta, finder);
+    if (rsrc_len == 0 && !finder_set)
         return 0; // data-only file: nothing to preserve
+    if (rsrc_len > UINT32_MAX) {
+        fprintf(stderr, "archive: resource fork of '%s' too large for AppleDouble\n", ctx->data_path);
+        return -1;
+    }
 
     uint8_t *hdr = NULL;
     size_t hdr_len = 0;
-    if (ad_build_sidecar(file->resource_fork.data, file->resource_fork.size, finder_set ? finder : NULL, &hdr,
-                         &hdr_len) != 0)
+    if (ad_build_sidecar_header((size_t)rsrc_len, finder_set ? finder : NULL, &hdr, &hdr_len) != 0)
         return 0;
 
-    char sidecar[1024];
-    const char *slash = strrchr(data_full_path, '/');
-    int n = slash ? snprintf(sidecar, sizeof(sidecar), "%.*s._%s", (int)(slash - data_full_path + 1), data_full_path,
+    const char *path = ctx->data_path;
+    const char *slash = strrchr(path, '/');
+    int n = slash ? snprintf(ctx->sidecar_path, sizeof(ctx->sidecar_path), "%.*s._%s", (int)(slash - path + 1), path,
                              slash + 1)
-                  : snprintf(sidecar, sizeof(sidecar), "._%s", data_full_path);
-    if (n < 0 || n >= (int)sizeof(sidecar)) {
+                  : snprintf(ctx->sidecar_path, sizeof(ctx->sidecar_path), "._%s", path);
+    if (n < 0 || n >= (int)sizeof(ctx->sidecar_path)) {
         free(hdr);
         fprintf(stderr, "archive: sidecar path too long\n");
         return -1;
     }
 
-    FILE *fp = fopen(sidecar, "wb");
-    if (!fp) {
+    ctx->rsrc = fopen(ctx->sidecar_path, "wb");
+    if (!ctx->rsrc) {
         free(hdr);
-        fprintf(stderr, "archive: cannot create '%s': %s\n", sidecar, strerror(errno));
+        fprintf(stderr, "archive: cannot create '%s': %s\n", ctx->sidecar_path, strerror(errno));
         return -1;
     }
-    size_t written = fwrite(hdr, 1, hdr_len, fp);
-    int close_rc = fclose(fp);
+    size_t written = fwrite(hdr, 1, hdr_len, ctx->rsrc);
     free(hdr);
-    if (written != hdr_len || close_rc != 0) {
-        remove(sidecar);
-        fprintf(stderr, "archive: write error on sidecar '%s'\n", sidecar);
+    if (written != hdr_len) {
+        fprintf(stderr, "archive: write error on sidecar '%s'\n", ctx->sidecar_path);
         return -1;
     }
     return 0;
 }
 
-// Write a single extracted file to disk under ctx->output_dir: the data fork
-// under its name, and — when the file carries a resource fork and/or Finder
-// Info — an AppleDouble "._<name>" sidecar beside it so the fork is preserved
-// (see write_ad_sidecar).
-static int write_extracted_file(const archive_ctx_t *ctx, const peel_file_t *file) {
-    const char *name = file->meta.name;
+// Close the current file's outputs.  Returns -1 if a close failed; an
+// incomplete sidecar is removed rather than left half-written.
+static int close_extracted_file(archive_ctx_t *ctx, bool complete) {
+    int rc = 0;
+    if (ctx->data) {
+        if (fclose(ctx->data) != 0) {
+            fprintf(stderr, "archive: write error on '%s'\n", ctx->data_path);
+            rc = -1;
+        }
+        ctx->data = NULL;
+    }
+    if (ctx->rsrc) {
+        if (fclose(ctx->rsrc) != 0 || !complete) {
+            if (complete)
+                fprintf(stderr, "archive: write error on sidecar '%s'\n", ctx->sidecar_path);
+            remove(ctx->sidecar_path);
+            rc = -1;
+        }
+        ctx->rsrc = NULL;
+    }
+    return rc;
+}
+
+// Sink callback: create the data file (and sidecar, when the file carries a
+// resource fork and/or Finder Info) for the next extracted file under
+// ctx->output_dir.
+static int sink_begin(void *opaque, const peel_file_meta_t *meta, uint64_t data_len, uint64_t rsrc_len) {
+    archive_ctx_t *ctx = opaque;
+    (void)data_len;
+    const char *name = meta->name;
     if (!name[0])
         name = "untitled";
 
+    ctx->failed = true; // until the outputs are open
     if (ensure_dir_exists(ctx, name) != 0)
         return -1;
 
-    char full_path[1024];
-    if (snprintf(full_path, sizeof(full_path), "%s/%s", ctx->output_dir, name) >= (int)sizeof(full_path)) {
+    if (snprintf(ctx->data_path, sizeof(ctx->data_path), "%s/%s", ctx->output_dir, name) >=
+        (int)sizeof(ctx->data_path)) {
         fprintf(stderr, "archive: path too long\n");
         return -1;
     }
 
-    FILE *fp = fopen(full_path, "wb");
-    if (!fp) {
-        fprintf(stderr, "archive: cannot create file '%s': %s\n", full_path, strerror(errno));
+    ctx->data = fopen(ctx->data_path, "wb");
+    if (!ctx->data) {
+        fprintf(stderr, "archive: cannot create file '%s': %s\n", ctx->data_path, strerror(errno));
         return -1;
     }
 
-    if (file->data_fork.size > 0) {
-        size_t written = fwrite(file->data_fork.data, 1, file->data_fork.size, fp);
-        if (written != file->data_fork.size) {
-            fprintf(stderr, "archive: write error: %s\n", strerror(errno));
-            fclose(fp);
-            return -1;
-        }
-    }
+    // Preserve the resource fork + Finder Info as a sibling AppleDouble sidecar.
+    if (open_ad_sidecar(ctx, meta, rsrc_len) != 0)
+        return -1;
+    ctx->failed = false;
+    return 0;
+}
 
-    fclose(fp);
+// Sink callback: append fork bytes to the data file or the sidecar.
+static int sink_write(void *opaque, peel_fork_t fork, const uint8_t *buf, size_t len) {
+    archive_ctx_t *ctx = opaque;
+    FILE *fp = fork == PEEL_RESOURCE_FORK ? ctx->rsrc : ctx->data;
+    if (!fp || fwrite(buf, 1, len, fp) != len) {
+        fprintf(stderr, "archive: write error: %s\n", strerror(errno));
+        ctx->failed = true;
+        return -1;
+    }
+    return 0;
+}
 
-    // Preserve the resource fork + Finder Info as a sibling AppleDouble sidecar.
-    return write_ad_sidecar(full_path, file);
+// Sink callback: finish the current file.
+static int sink_end(void *opaque) {
+    archive_ctx_t *ctx = opaque;
+    if (close_extracted_file(ctx, true) != 0) {
+        ctx->failed = true;
+        return -1;
+    }
+    ctx->file_count++;
+    return 0;
 }
 
+// Stream every file out of the archive at filepath into ctx->output_dir.
 static int process_archive(archive_ctx_t *ctx, const char *filepath) {
+    peel_sink_t sink = {.begin = sink_begin, .write = sink_write, .end = sink_end, .ctx = ctx};
     peel_err_t *err = NULL;
-    peel_file_list_t list = peel_path(filepath, &err);
+    int count = peel_stream_path(filepath, &sink, &err);
 
-    if (err) {
-        fprintf(stderr, "archive: failed to extract '%s': %s\n", filepath, peel_err_msg(err));
+    if (count < 0) {
+        close_extracted_file(ctx, false);
+        // A failed write has been reported already; peeler's error adds nothing
+        if (!ctx->failed)
+            fprintf(stderr, "archive: failed to extract '%s': %s\n", filepath, peel_err_msg(err));
         peel_err_free(err);
         return -1;
     }
 
-    if (list.count == 0) {
+    if (count == 0) {
         fprintf(stderr, "archive: no files extracted from '%s'\n", filepath);
-        peel_file_list_free(&list);
         return -1;
     }
 
-    int status = 0;
-    for (int i = 0; i < list.count; i++) {
-        if (write_extracted_file(ctx, &list.files[i]) != 0) {
-            status = -1;
-            break;
-        }
-    }
-
-    int count = list.count;
-    peel_file_list_free(&list);
-
-    if (status == 0)
-        ctx->file_count += count;
-
-    return status;
+    return 0;
 }
 
 // ============================================================================
@@ -241,15 +282,7 @@ static int process_archive(archive_ctx_t *ctx, const char *filepath) {
 const char *archive_identify_file(const char *path) {
     if (!path || !*path)
         return NULL;
-    peel_err_t *err = NULL;
-    peel_buf_t buf = peel_read_file(path, &err);
-    if (err) {
-        peel_err_free(err);
-        return NULL;
-    }
-    const char *format = peel_detect(buf.data, buf.size);
-    peel_free(&buf);
-    return format;
+    return peel_detect_path(path);
 }
 
 int archive_extract_file(const char *path, const char *out_dir) {
@@ -199,6 +199,7 @@ void image_close(image_t *image) {
         return;
     if (image->storage)
         storage_delete(image->storage);
+    ndif_reader_close(image->ndif);
     free(image->tags);
     // Ghost (read-only) instances were placed in a scratch dir; remove their
     // delta+journal so we don't leave clutter behind.
@@ -341,6 +342,11 @@ static void image_load_diskcopy_tags(image_t *image) {
     image->tag_count = count;
 }
 
+// Storage base reader for an NDIF image: decodes the chunks a read touches.
+static int image_ndif_base_read(void *context, uint64_t offset, void *buffer, size_t len) {
+    return ndif_reader_read((ndif_reader_t *)context, offset, buffer, len) == 0 ? GS_SUCCESS : GS_ERROR;
+}
+
 static int image_attach_storage(image_t *image, bool is_diskcopy) {
     storage_config_t config = {0};
     config.base_path = image->filename; // NULL for a blank no-base image
@@ -349,6 +355,10 @@ static int image_attach_storage(image_t *image, bool is_diskcopy) {
     config.block_count = image->raw_size / image->block_size;
     config.block_size = image->block_size;
     config.base_data_offset = is_diskcopy ? DISKCOPY_HEADER_SIZE : 0;
+    if (image->ndif) {
+        config.base_read = image_ndif_base_read;
+        config.base_context = image->ndif;
+    }
     int rc = storage_new(&config, &image->storage);
     if (rc == GS_SUCCESS && is_diskcopy)
         image_load_diskcopy_tags(image);
@@ -378,14 +388,14 @@ size_t disk_write_tag(image_t *disk, size_t sector, const uint8_t *buf, size_t s
 // Scratch directory for read-only image deltas (kept volatile).
 #define IMAGE_RO_SCRATCH_DIR "/tmp/gs-image-ro"
 
-// === AppleDouble fork acquisition + host-file NDIF materialisation =========
+// === AppleDouble fork acquisition + host-file NDIF bases ====================
 // A host `.img` file has only a data fork, but a Disk Copy 6 / NDIF image keeps
 // its block map ('bcem') in the resource fork.  When such a file was copied out
 // of an HFS volume as an AppleDouble pair, the resource fork lives in a sibling
 // "._<name>" (or legacy "%<name>", or a raw "<name>.rsrc").  This reunites the
-// forks and, when the data fork is NDIF-encoded, decodes it to a scratch raw
-// image so the rest of image.c opens it as an ordinary base.  See
-// proposal-appledouble-support.md §4.4.
+// forks and, when the data fork is NDIF-encoded, gives the storage engine a
+// reader that decodes chunks as blocks are read, so nothing is decoded up
+// front and no scratch copy is made.  See proposal-appledouble-support.md §4.4.
 #define IMAGE_FORK_READ_CAP (16u * 1024u * 1024u)
 
 // Read up to `cap` bytes of a host file into a malloc'd buffer. 0 / -errno.
@@ -469,116 +479,43 @@ static uint8_t *acquire_resource_fork(const char *base_path, size_t *out_len) {
     return NULL;
 }
 
-// Decode an NDIF data fork (host file `base_path`, block map `map`) into a
-// freshly created scratch raw file `scratch`. 0 / -errno.
-static int materialize_ndif_host(const char *base_path, ndif_map_t *map, const char *scratch) {
-    FILE *df = fopen(base_path, "rb");
-    if (!df)
-        return -errno;
-    FILE *out = fopen(scratch, "wb");
-    if (!out) {
-        int e = errno;
-        fclose(df);
-        return e ? -e : -EIO;
-    }
-    int rc = 0;
-    if (ftruncate(fileno(out), (off_t)map->sectors * 512) != 0) {
-        rc = -EIO;
-        goto done;
-    }
-    for (size_t i = 0; i < map->n_chunks; i++) {
-        ndif_chunk_t *c = &map->chunks[i];
-        if (c->type == NDIF_CHUNK_ZERO || c->count == 0)
-            continue; // ftruncate already zero-filled the gap
-        size_t need = (size_t)c->count * 512;
-        uint8_t *dbuf = (uint8_t *)malloc(need);
-        uint8_t *cbuf = c->length ? (uint8_t *)malloc(c->length) : NULL;
-        if (!dbuf || (c->length && !cbuf)) {
-            free(dbuf);
-            free(cbuf);
-            rc = -ENOMEM;
-            break;
-        }
-        size_t clen = 0;
-        if (c->length) {
-            if (fseek(df, (long)c->offset, SEEK_SET) != 0) {
-                free(dbuf);
-                free(cbuf);
-                rc = -EIO;
-                break;
-            }
-            clen = fread(cbuf, 1, c->length, df);
-        }
-        if (ndif_decode_chunk(c, cbuf, clen, dbuf, need) == 0) {
-            if (fseek(out, (long)c->sector * 512, SEEK_SET) != 0 || fwrite(dbuf, 1, need, out) != need)
-                rc = -EIO;
-        } else {
-            rc = -EINVAL;
-        }
-        free(dbuf);
-        free(cbuf);
-        if (rc != 0)
-            break;
-    }
-done:
-    fclose(df);
-    if (fclose(out) != 0 && rc == 0)
-        rc = -EIO;
-    return rc;
-}
-
-// FNV-1a over a NUL-terminated string, seeded, for scratch-name derivation.
-static uint32_t fork_hash_str(const char *s, uint32_t h) {
-    for (; *s; s++)
-        h = (h ^ (uint8_t)*s) * 0x01000193u;
-    return h;
-}
-
 // If base_path is an NDIF image whose block map can be recovered from a fork
-// sidecar, decode it to a cached scratch raw file and return that path
-// (malloc'd, caller frees / image takes ownership).  Otherwise return a copy of
-// base_path.  NULL only on allocation failure.
-static char *resolve_base_image(const char *base_path) {
+// sidecar, return a reader that decodes its chunks on demand; otherwise NULL
+// (the file is opened as an ordinary flat or DiskCopy 4.2 base).
+static ndif_reader_t *open_ndif_base(const char *base_path) {
     size_t rlen = 0;
     uint8_t *rfork = acquire_resource_fork(base_path, &rlen);
     if (!rfork)
-        return dup_string(base_path);
-
-    char *result = NULL;
-    if (ndif_detect(rfork, rlen)) {
-        ndif_map_t *map = NULL;
-        if (ndif_parse(rfork, rlen, &map) == 0) {
-            // Deterministic scratch name from path + size + mtime, so repeated
-            // inserts reuse the decode and a changed source re-decodes.
-            struct stat sb;
-            uint32_t h = fork_hash_str(base_path, 0x811c9dc5u);
-            if (stat(base_path, &sb) == 0) {
-                h = fork_hash_str("\x1f", h);
-                char meta[64];
-                snprintf(meta, sizeof(meta), "%lld:%lld", (long long)sb.st_size, (long long)sb.st_mtime);
-                h = fork_hash_str(meta, h);
-            }
-            char scratch[PATH_MAX];
-            snprintf(scratch, sizeof(scratch), "%s/ndif-%08x.img", IMAGE_RO_SCRATCH_DIR, h);
-
-            struct stat cached;
-            if (stat(scratch, &cached) == 0 && cached.st_size == (off_t)map->sectors * 512) {
-                result = dup_string(scratch); // already materialised
-            } else {
-                mkdir_recursive(IMAGE_RO_SCRATCH_DIR);
-                if (materialize_ndif_host(base_path, map, scratch) == 0) {
-                    LOG(3, "decoded NDIF '%s' -> '%s' (%u sectors)", base_path, scratch, map->sectors);
-                    result = dup_string(scratch);
-                } else {
-                    remove(scratch);
-                    LOG(1, "NDIF decode failed for '%s'", base_path);
-                }
-            }
-            ndif_map_free(map);
-        }
+        return NULL;
+
+    ndif_reader_t *reader = NULL;
+    ndif_map_t *map = NULL;
+    if (ndif_detect(rfork, rlen) && ndif_parse(rfork, rlen, &map) == 0) {
+        if (ndif_reader_open(base_path, map, &reader) == 0)
+            LOG(3, "NDIF base '%s' (%u sectors, %zu chunks)", base_path, map->sectors, map->n_chunks);
+        else
+            LOG(1, "NDIF image '%s' cannot be decoded", base_path);
     }
     free(rfork);
-    return result ? result : dup_string(base_path);
+    return reader;
+}
+
+// Identify the base image at base_path: an NDIF image gets a chunk reader
+// (*ndif), anything else is probed as a flat or DiskCopy 4.2 file.  0 / -1.
+static int open_base_image(const char *base_path, uint32_t block_size, size_t *out_raw_size, bool *out_is_diskcopy,
+                           ndif_reader_t **ndif) {
+    *ndif = open_ndif_base(base_path);
+    if (!*ndif)
+        return probe_base_image(base_path, block_size, out_raw_size, out_is_diskcopy);
+    uint64_t size = ndif_reader_size(*ndif);
+    if (size == 0 || size > SIZE_MAX || size % block_size != 0) {
+        ndif_reader_close(*ndif);
+        *ndif = NULL;
+        return -1;
+    }
+    *out_raw_size = (size_t)size;
+    *out_is_diskcopy = false;
+    return 0;
 }
 
 image_t *image_open_readonly(const char *base_path) {
@@ -590,23 +527,19 @@ image_t *image_open_readonly_with_geometry(const char *base_path, image_geometry
         return NULL;
     uint32_t block_size = geometry_block_size(geom);
 
-    char *effective = resolve_base_image(base_path);
-    if (!effective)
-        return NULL;
-
     size_t raw_size = 0;
     bool is_diskcopy = false;
-    if (probe_base_image(effective, block_size, &raw_size, &is_diskcopy) != 0) {
-        free(effective);
+    ndif_reader_t *ndif = NULL;
+    if (open_base_image(base_path, block_size, &raw_size, &is_diskcopy, &ndif) != 0)
         return NULL;
-    }
 
     image_t *image = (image_t *)calloc(1, sizeof(image_t));
     if (!image) {
-        free(effective);
+        ndif_reader_close(ndif);
         return NULL;
     }
-    image->filename = effective; // owns the (possibly NDIF-materialised) base path
+    image->filename = dup_string(base_path);
+    image->ndif = ndif;
     image->raw_size = raw_size;
     image->block_size = block_size;
     image->type = classify_image(raw_size);
@@ -650,16 +583,11 @@ image_t *image_create_with_geometry(const char *base_path, const char *delta_dir
     // mounts). The probe that used to live here had no effect on subsequent
     // behaviour.
 
-    char *effective = resolve_base_image(base_path);
-    if (!effective)
-        return NULL;
-
     size_t raw_size = 0;
     bool is_diskcopy = false;
-    if (probe_base_image(effective, block_size, &raw_size, &is_diskcopy) != 0) {
-        free(effective);
+    ndif_reader_t *ndif = NULL;
+    if (open_base_image(base_path, block_size, &raw_size, &is_diskcopy, &ndif) != 0)
         return NULL;
-    }
 
     // Default delta_dir to the directory containing the (original) base image.
     // Headless callers may pass NULL when they have no machine-id concept (§2.4).
@@ -671,7 +599,7 @@ image_t *image_create_with_geometry(const char *base_path, const char *delta_dir
     if (mkdir_recursive(delta_dir) != 0) {
         printf("image_create: cannot create delta directory: %s\n", delta_dir);
         free(derived_dir);
-        free(effective);
+        ndif_reader_close(ndif);
         return NULL;
     }
 
@@ -681,10 +609,11 @@ image_t *image_create_with_geometry(const char *base_path, const char *delta_dir
     image_t *image = (image_t *)calloc(1, sizeof(image_t));
     if (!image) {
         free(derived_dir);
-        free(effective);
+        ndif_reader_close(ndif);
         return NULL;
     }
-    image->filename = effective; // owns the (possibly NDIF-materialised) base path
+    image->filename = dup_string(base_path);
+    image->ndif = ndif;
     image->raw_size = raw_size;
     image->block_size = block_size;
     image->type = classify_image(raw_size);
@@ -717,23 +646,19 @@ image_t *image_open_with_geometry(const char *base_path, const char *instance_pa
         return NULL;
     uint32_t block_size = geometry_block_size(geom);
 
-    char *effective = resolve_base_image(base_path);
-    if (!effective)
-        return NULL;
-
     size_t raw_size = 0;
     bool is_diskcopy = false;
-    if (probe_base_image(effective, block_size, &raw_size, &is_diskcopy) != 0) {
-        free(effective);
+    ndif_reader_t *ndif = NULL;
+    if (open_base_image(base_path, block_size, &raw_size, &is_diskcopy, &ndif) != 0)
         return NULL;
-    }
 
     image_t *image = (image_t *)calloc(1, sizeof(image_t));
     if (!image) {
-        free(effective);
+        ndif_reader_close(ndif);
         return NULL;
     }
-    image->filename = effective; // owns the (possibly NDIF-materialised) base path
+    image->filename = dup_string(base_path);
+    image->ndif = ndif;
     image->raw_size = raw_size;
     image->block_size = block_size;
     image->type = classify_image(raw_size);
@@ -827,13 +752,11 @@ size_t disk_read_data(image_t *disk, size_t offset, uint8_t *buf, size_t size) {
             "disk_read_data: %zu-byte read at offset %zu runs past image end (raw_size=%zu); zero-filled %zu-byte tail",
             size, offset, disk->raw_size, size - backed);
     }
-    size_t transferred = 0;
-    while (transferred < backed) {
-        int rc = storage_read_block(disk->storage, offset + transferred, buf + transferred);
-        GS_ASSERTF(rc == GS_SUCCESS, "storage_read_block failed (%d)", rc);
+    if (backed) {
+        int rc = storage_read_blocks(disk->storage, offset, buf, backed / disk->block_size);
+        GS_ASSERTF(rc == GS_SUCCESS, "storage_read_blocks failed (%d)", rc);
         if (rc != GS_SUCCESS)
-            return transferred; // genuine in-bounds backing-store failure
-        transferred += disk->block_size;
+            return 0; // genuine in-bounds backing-store failure
     }
     // Buffer fully populated: real data plus any zero-filled tail past EOF.
     return size;
@@ -856,13 +779,11 @@ size_t disk_write_data(image_t *disk, size_t offset, uint8_t *buf, size_t size)
         LOG(1,
             "disk_write_data: %zu-byte write at offset %zu runs past image end (raw_size=%zu); dropped %zu-byte tail",
             size, offset, disk->raw_size, size - backed);
-    size_t transferred = 0;
-    while (transferred < backed) {
-        int rc = storage_write_block(disk->storage, offset + transferred, buf + transferred);
-        GS_ASSERTF(rc == GS_SUCCESS, "storage_write_block failed (%d)", rc);
+    if (backed) {
+        int rc = storage_write_blocks(disk->storage, offset, buf, backed / disk->block_size);
+        GS_ASSERTF(rc == GS_SUCCESS, "storage_write_blocks failed (%d)", rc);
         if (rc != GS_SUCCESS)
-            return transferred; // genuine in-bounds backing-store failure
-        transferred += disk->block_size;
+            return 0; // genuine in-bounds backing-store failure
     }
     // Accepted the write; any portion past EOF was intentionally dropped.
     return size;
@@ -881,7 +802,7 @@ static int file_write_cb(void *ctx, const void *data, size_t size) {
 size_t image_save(image_t *image) {
     if (!image || !image->storage || !image->filename)
         return (size_t)-1;
-    if (image->from_diskcopy) {
+    if (image->from_diskcopy || image->ndif) {
         LOG(1, "image_save: exporting DiskCopy images is not supported (%s)", image->filename);
         return (size_t)-1;
     }
@@ -894,6 +815,144 @@ size_t image_save(image_t *image) {
     return (rc == GS_SUCCESS) ? 0 : (size_t)-1;
 }
 
+bool image_base_writable(const image_t *image) {
+    if (!image || !image->storage || !image->filename || image->from_diskcopy || image->ndif ||
+        access(image->filename, W_OK) != 0)
+        return false;
+    // image_write_back creates its scratch copy next to the base
+    char *target = realpath(image->filename, NULL);
+    char *dir = target ? dirname_of(target) : NULL;
+    bool ok = dir && access(dir, W_OK) == 0;
+    free(dir);
+    free(target);
+    return ok;
+}
+
+// pwrite all of len bytes at offset at
+static int pwrite_all(int fd, const void *data, size_t len, off_t at) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t w = pwrite(fd, p, len, at);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return -1;
+        p += w;
+        at += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+// fsync, retrying on EINTR
+static int fsync_all(int fd) {
+    while (fsync(fd) != 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+    return 0;
+}
+
+// Copy the whole of src into dst
+static int copy_fd(int src, int dst) {
+    const size_t chunk = 1u << 20;
+    uint8_t *buf = (uint8_t *)malloc(chunk);
+    if (!buf)
+        return -1;
+    int rc = 0;
+    for (off_t at = 0;;) {
+        ssize_t n = pread(src, buf, chunk, at);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            rc = n < 0 ? -1 : 0;
+            break;
+        }
+        if (pwrite_all(dst, buf, (size_t)n, at) != 0) {
+            rc = -1;
+            break;
+        }
+        at += n;
+    }
+    free(buf);
+    return rc;
+}
+
+// Destination of image_write_back
+struct write_back {
+    int fd;
+    uint32_t block_size;
+};
+
+// pwrite one run of changed blocks at its place in the scratch copy
+static int write_back_run(void *ctx, uint64_t lba, const void *data, size_t count) {
+    const struct write_back *wb = ctx;
+    return pwrite_all(wb->fd, data, count * wb->block_size, (off_t)(lba * wb->block_size));
+}
+
+// Build target's replacement in tmp (a mkstemp template): the base bytes,
+// the changed runs on top, the base's permission bits, all synced.  Returns 0,
+// or -1 with tmp removed.
+static int write_back_scratch(image_t *image, const char *target, char *tmp) {
+    int src = open(target, O_RDONLY);
+    if (src < 0)
+        return -1;
+    struct write_back wb = {.fd = mkstemp(tmp), .block_size = image->block_size};
+    if (wb.fd < 0) {
+        close(src);
+        return -1;
+    }
+    struct stat st;
+    int rc = (fstat(src, &st) == 0 && fchmod(wb.fd, st.st_mode & 07777) == 0 && copy_fd(src, wb.fd) == 0) ? 0 : -1;
+    close(src);
+    if (rc == 0 && storage_changed_runs(image->storage, &wb, write_back_run) != GS_SUCCESS)
+        rc = -1;
+    if (rc == 0 && fsync_all(wb.fd) != 0)
+        rc = -1;
+    if (close(wb.fd) != 0)
+        rc = -1;
+    if (rc != 0)
+        unlink(tmp);
+    return rc;
+}
+
+int image_write_back(image_t *image) {
+    if (!image_base_writable(image))
+        return -1;
+    // The changes go into a copy that is renamed over the base once synced,
+    // so a failure or crash part-way leaves the base exactly as it was
+    char *target = realpath(image->filename, NULL); // replace a symlink's target, not the link
+    char *tmp = target ? str_printf("%s.wb-XXXXXX", target) : NULL;
+    int rc = tmp ? write_back_scratch(image, target, tmp) : -1;
+    if (rc == 0 && rename(tmp, target) != 0) {
+        unlink(tmp);
+        rc = -1;
+    }
+    if (rc != 0) {
+        LOG(1, "image_write_back: cannot update %s", image->filename);
+    } else {
+        // The rename is done; a lost directory entry only delays durability
+        char *dir = dirname_of(target);
+        int dfd = dir ? open(dir, O_RDONLY) : -1;
+        if (dfd < 0 || fsync_all(dfd) != 0)
+            LOG(1, "image_write_back: cannot sync the directory of %s", image->filename);
+        if (dfd >= 0)
+            close(dfd);
+        free(dir);
+    }
+    free(tmp);
+    free(target);
+    if (rc != 0)
+        return -1;
+    return storage_clear_rollback(image->storage) == GS_SUCCESS ? 0 : -1;
+}
+
+int image_discard_changes(image_t *image) {
+    if (!image || !image->storage)
+        return -1;
+    return storage_apply_rollback(image->storage) == GS_SUCCESS ? 0 : -1;
+}
+
 // Export the full disk content (base + delta) to a new file at dest_path.
 int image_export_to(image_t *image, const char *dest_path) {
     if (!image || !image->storage || !dest_path || !*dest_path)
@@ -42,6 +42,7 @@ struct image {
     bool ghost_instance; // True when delta+journal are ephemeral scratch (read-only mounts)
     enum image_type type; // Detected image type (floppy, hd, ...)
     bool from_diskcopy; // True if the source file was DiskCopy 4.2
+    struct ndif_reader *ndif; // Chunk decoder the storage engine reads an NDIF base through, or NULL
 
     // DiskCopy 4.2 per-sector tags (read-only metadata).  The Lisa boot ROM and
     // OS read these (e.g. the boot block's FILEID = $AAAA); loaded from the
@@ -151,6 +152,21 @@ int image_create_blank_floppy(const char *filename, bool overwrite, bool high_de
 // already exists, -1 on any other error.
 int image_create_blank_profile(const char *filename, uint32_t block_count);
 
+// True when the base file is a flat image that image_write_back can update:
+// not DiskCopy, not NDIF, and both it and its directory writable by us.
+bool image_base_writable(const image_t *image);
+
+// Write the blocks changed since the last write-back into the base file itself
+// and commit them, so they survive the (possibly ephemeral) delta.  Used by
+// host-side edits of a read-only mount.  The base is replaced atomically: the
+// changes go into a synced copy that is renamed over it, so on failure (or a
+// crash) the base is left untouched and the changes stay uncommitted in the
+// delta.  Returns 0 on success, -1 on failure.
+int image_write_back(image_t *image);
+
+// Drop the changes made since the last write-back.  Returns 0 or -1.
+int image_discard_changes(image_t *image);
+
 // Export the full disk content (base + delta) of an open image to a new file.
 // Returns 0 on success, -1 on failure.
 int image_export_to(image_t *image, const char *dest_path);
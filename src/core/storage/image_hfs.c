@@ -5,11 +5,14 @@
 // Read-only HFS / HFS+ catalog walker.  Loads the catalog file into memory
 // on open, scans every leaf node to collect catalog records in a flat
 // array, and answers directory enumeration / path lookup / fork reads
-// against that snapshot.  This trades a one-time O(n) scan for O(log n)
-// lookups against a full walk — realistic volumes (System 6/7 floppies,
-// 800 KB–400 MB A/UX-era HFS partitions, HFS+ CD-ROMs) have at most a few
-// thousand catalog entries, so the snapshot fits comfortably in RAM and
-// lookups are instant.
+// against that snapshot.  The scan also indexes the records: a hash on
+// (parent CNID, case-folded name) makes a path component one probe, and
+// each folder's children are chained in catalog order, so enumerating a
+// folder costs its own size rather than the whole catalog's — a 100k-file
+// HFS+ volume walks as fast as a floppy, per entry.  Catalogs larger than
+// HFS_EAGER_CATALOG_MAX are not loaded at all: lookups and enumerations
+// descend the B-tree's index nodes on demand through a small node cache,
+// so mounting a CD-ROM costs the same as mounting a floppy.
 //
 // HFS and HFS+ share the snapshot machinery (the flat cat_rec_t / xt_rec
 // arrays, lookup, readdir, and the extent-walking fork reader); only the
@@ -21,6 +24,7 @@
 
 #include "image_hfs.h"
 #include "image.h"
+#include "image_hfs_internal.h"
 #include "macroman.h"
 #include "storage.h"
 
@@ -215,6 +219,55 @@ typedef struct hfs_xt_rec {
     } extents[HFS_FORK_EXTENTS]; // 3 used by HFS, up to 8 by HFS+
 } hfs_xt_rec_t;
 
+// Record-index terminator for the catalog index chains.
+#define CAT_NONE UINT32_MAX
+
+// A folder in the catalog index: its children are a chain through
+// cat_index_t.sibling_next, in catalog order.
+typedef struct cat_dir {
+    uint32_t cnid;
+    uint32_t first_child; // record index, CAT_NONE when empty
+    uint32_t n_children;
+    uint32_t next; // next folder in the same dir_buckets chain
+} cat_dir_t;
+
+// Hash index over vol->records, built by index_catalog.  Both tables have
+// `mask + 1` buckets holding record / folder indices (CAT_NONE = empty).
+typedef struct cat_index {
+    uint32_t mask;
+    uint32_t *name_buckets; // by (parent CNID, folded name)
+    uint32_t *name_next; // per record: next record in its name bucket
+    uint32_t *sibling_next; // per record: next child of the same parent
+    uint32_t *dir_buckets; // by parent CNID, into dirs
+    cat_dir_t *dirs;
+    size_t n_dirs;
+} cat_index_t;
+
+// Catalog B-tree nodes kept by a lazy volume.
+#define CAT_NODE_CACHE 32
+
+// One slot of the node cache.
+typedef struct cat_node {
+    uint32_t node; // catalog node number, CAT_NONE when the slot is free
+    uint64_t stamp; // LRU clock at last use
+    uint8_t *data; // node_size bytes
+} cat_node_t;
+
+// A catalog walked on demand: lookups and enumerations descend the B-tree
+// from its root, reading nodes through an LRU cache.
+typedef struct cat_tree {
+    hfs_fork_t fork; // the catalog file
+    bool plus; // HFS+ keys and leaf records (else classic HFS)
+    size_t node_size;
+    uint32_t n_nodes;
+    uint32_t root;
+    uint32_t root_valence; // from the root folder record
+    uint64_t clock;
+    cat_node_t cache[CAT_NODE_CACHE];
+    cat_rec_t *scratch; // leaf records decoded by lookups, reused across them
+    size_t scratch_cap;
+} cat_tree_t;
+
 struct hfs_volume {
     image_t *img;
     uint64_t partition_off; // byte offset of the partition inside the image
@@ -224,6 +277,9 @@ struct hfs_volume {
     char volume_name[256]; // UTF-8; sized to hold a full HFS+ name
     cat_rec_t *records;
     size_t n_records;
+    cat_index_t index; // lookup structures over records
+    bool lazy; // catalog too large to load: records/index unused, walk `tree`
+    cat_tree_t tree;
     // Extents Overflow snapshot.  Loaded eagerly at hfs_open time using
     // the EO file's own inline extents (drXTExtRec in the MDB); the EO
     // file is small enough in practice (usually < 8 KB) that walking it
@@ -232,12 +288,22 @@ struct hfs_volume {
     // load — same compromise as the catalog file.
     hfs_xt_rec_t *xt_records;
     size_t n_xt_records;
+    uint32_t generation; // bumped by hfs_refresh; iterators from before it go stale
 };
 
+// Catalog size above which hfs_open goes lazy (hfs_set_eager_catalog_limit).
+static size_t eager_catalog_limit = HFS_EAGER_CATALOG_MAX;
+
 struct hfs_dir_iter {
-    const hfs_volume_t *vol;
+    hfs_volume_t *vol;
+    uint32_t generation; // vol->generation at opendir
     uint32_t parent_cnid;
-    size_t cursor;
+    uint32_t cursor; // record index of the next child, CAT_NONE at the end
+    // Lazy volumes decode the folder's children one leaf node at a time.
+    uint32_t next_leaf; // leaf to decode next, 0 at the end of the key range
+    uint32_t hops; // leaves decoded so far (bounds an fLink cycle)
+    cat_rec_t *batch; // children from the last decoded leaf
+    size_t n_batch, cap_batch, pos;
 };
 
 // ---- Helpers --------------------------------------------------------------
@@ -550,6 +616,8 @@ static const hfs_xt_rec_t *find_xt_record(const hfs_volume_t *vol, uint8_t fork_
     return best;
 }
 
+static int index_catalog(hfs_volume_t *vol);
+
 // Walk the catalog B-tree's leaf chain starting from firstLeaf.
 static int collect_catalog_records(hfs_volume_t *vol, const uint8_t *cat_buf, size_t cat_size, size_t node_size,
                                    uint32_t first_leaf) {
@@ -579,7 +647,7 @@ static int collect_catalog_records(hfs_volume_t *vol, const uint8_t *cat_buf, si
 
     vol->records = dst;
     vol->n_records = n;
-    return 0;
+    return index_catalog(vol);
 }
 
 // ---- Comparison / lookup --------------------------------------------------
@@ -648,6 +716,101 @@ static void fill_dirent(const cat_rec_t *r, hfs_dirent_t *out) {
     memcpy(out->finder_info, r->finder_info, 32);
 }
 
+// ---- Catalog index --------------------------------------------------------
+
+// FNV-1a over a parent CNID and a name folded as name_matches compares it,
+// so names that match hash alike.
+static uint32_t cat_key_hash(uint32_t parent_cnid, const char *name) {
+    uint32_t h = 0x811c9dc5u;
+    for (int i = 0; i < 4; i++)
+        h = (h ^ (uint8_t)(parent_cnid >> (i * 8))) * 0x01000193u;
+    for (const uint8_t *p = (const uint8_t *)name; *p; p++)
+        h = (h ^ hfs_fold_byte(*p)) * 0x01000193u;
+    return h;
+}
+
+// Spread a CNID over the folder buckets.
+static uint32_t cat_dir_hash(uint32_t cnid) {
+    return cnid * 0x9E3779B1u;
+}
+
+// The index entry of folder `cnid`, or NULL when nothing has it as parent.
+static cat_dir_t *find_dir(const hfs_volume_t *vol, uint32_t cnid) {
+    const cat_index_t *x = &vol->index;
+    if (!x->dir_buckets)
+        return NULL;
+    for (uint32_t d = x->dir_buckets[cat_dir_hash(cnid) & x->mask]; d != CAT_NONE; d = x->dirs[d].next)
+        if (x->dirs[d].cnid == cnid)
+            return &x->dirs[d];
+    return NULL;
+}
+
+static void free_index(cat_index_t *x) {
+    free(x->name_buckets);
+    free(x->name_next);
+    free(x->sibling_next);
+    free(x->dir_buckets);
+    free(x->dirs);
+    memset(x, 0, sizeof(*x));
+}
+
+// Build vol->index over vol->records.  Records are linked in reverse, so
+// every chain comes out in catalog order: duplicate names resolve to the
+// first record, and folders enumerate in on-disk (name) order.  On failure
+// the records are released too.  0 / -errno.
+static int index_catalog(hfs_volume_t *vol) {
+    cat_index_t *x = &vol->index;
+    size_t n = vol->n_records;
+    if (n >= CAT_NONE) {
+        free(vol->records);
+        vol->records = NULL;
+        vol->n_records = 0;
+        return -EFBIG;
+    }
+    size_t buckets = 16;
+    while (buckets < n)
+        buckets <<= 1;
+    x->mask = (uint32_t)(buckets - 1);
+    x->name_buckets = malloc(buckets * sizeof(uint32_t));
+    x->dir_buckets = malloc(buckets * sizeof(uint32_t));
+    x->name_next = malloc((n ? n : 1) * sizeof(uint32_t));
+    x->sibling_next = malloc((n ? n : 1) * sizeof(uint32_t));
+    x->dirs = malloc((n ? n : 1) * sizeof(cat_dir_t));
+    if (!x->name_buckets || !x->dir_buckets || !x->name_next || !x->sibling_next || !x->dirs) {
+        free_index(x);
+        free(vol->records);
+        vol->records = NULL;
+        vol->n_records = 0;
+        return -ENOMEM;
+    }
+    memset(x->name_buckets, 0xFF, buckets * sizeof(uint32_t));
+    memset(x->dir_buckets, 0xFF, buckets * sizeof(uint32_t));
+
+    for (size_t i = n; i-- > 0;) {
+        const cat_rec_t *r = &vol->records[i];
+        uint32_t h = cat_key_hash(r->parent_cnid, r->name) & x->mask;
+        x->name_next[i] = x->name_buckets[h];
+        x->name_buckets[h] = (uint32_t)i;
+
+        cat_dir_t *d = find_dir(vol, r->parent_cnid);
+        if (!d) {
+            uint32_t b = cat_dir_hash(r->parent_cnid) & x->mask;
+            d = &x->dirs[x->n_dirs];
+            d->cnid = r->parent_cnid;
+            d->first_child = CAT_NONE;
+            d->n_children = 0;
+            d->next = x->dir_buckets[b];
+            x->dir_buckets[b] = (uint32_t)x->n_dirs++;
+        }
+        x->sibling_next[i] = d->first_child;
+        d->first_child = (uint32_t)i;
+        d->n_children++;
+    }
+    return 0;
+}
+
+static int open_lazy_catalog(hfs_volume_t *vol, const hfs_fork_t *fork, bool plus);
+
 // ---- Classic HFS open -----------------------------------------------------
 
 // Open a classic HFS volume.  `mdb` is the already-read 512-byte Master
@@ -675,19 +838,52 @@ static hfs_volume_t *open_classic(image_t *img, uint64_t partition_byte_offset,
         vn_len = 27;
     macroman_to_utf8(mdb + MDB_OFF_VN + 1, vn_len, vol->volume_name, sizeof(vol->volume_name));
 
+    // Extents Overflow file — populates vol->xt_records for any fork
+    // that spills past its 3 inline extents (the catalog file included).
+    // Empty / missing EO file is not an error; many small volumes have
+    // nothing in it.  We tolerate partial reads of the EO file itself for
+    // the same reason we tolerate partial reads of the catalog: realistic
+    // volumes keep these special files small enough to fit in their
+    // inline extents.
+    uint8_t *xt = NULL;
+    size_t xt_size = 0;
+    if (load_xt_file(vol, mdb, &xt, &xt_size) == 0 && xt != NULL && xt_size >= 14 + HDR_OFF_NODE_SIZE + 2) {
+        size_t xt_node_size = be16(xt + 14 + HDR_OFF_NODE_SIZE);
+        if (xt_node_size > 0 && xt_node_size <= xt_size) {
+            uint32_t xt_first_leaf = be32(xt + 14 + HDR_OFF_FIRST_LEAF);
+            if (collect_xt_records(vol, xt, xt_size, xt_node_size, xt_first_leaf) < 0) {
+                // Non-fatal — fall through with whatever (if anything)
+                // we did manage to collect.
+            }
+        }
+    }
+    free(xt);
+
+    // A catalog past the eager limit is walked on demand instead of loaded.
+    if (be32(mdb + MDB_OFF_CT_FL_SIZE) > eager_catalog_limit) {
+        hfs_fork_t cat_fork;
+        memset(&cat_fork, 0, sizeof(cat_fork));
+        parse_fork(mdb, MDB_OFF_CT_FL_SIZE, MDB_OFF_CT_EXT_REC, HFSP_CATALOG_FILE_ID, 0x00, &cat_fork);
+        if (open_lazy_catalog(vol, &cat_fork, false) < 0) {
+            hfs_close(vol);
+            return NULL;
+        }
+        return vol;
+    }
+
     // Load catalog file.
     uint8_t *cat = NULL;
     size_t cat_size = 0;
     int rc = load_catalog_file(vol, mdb, &cat, &cat_size);
     if (rc < 0) {
-        free(vol);
+        hfs_close(vol);
         return NULL;
     }
 
     // Parse B-tree header node (node 0).  Standard HFS node size is 512.
     if (cat_size < 14 + 106) {
         free(cat);
-        free(vol);
+        hfs_close(vol);
         return NULL;
     }
     // The header record starts right after the 14-byte node descriptor.
@@ -697,14 +893,14 @@ static hfs_volume_t *open_classic(image_t *img, uint64_t partition_byte_offset,
     if (node_size < 512 || node_size > 8192 || (node_size & (node_size - 1)) != 0) {
         // node_size must be a power of two in [512, 8192].
         free(cat);
-        free(vol);
+        hfs_close(vol);
         return NULL;
     }
     // Reject volumes whose catalog file is shorter than one B-tree node —
     // otherwise the leaf-chain walker below reads garbage past EOF.
     if (cat_size < node_size) {
         free(cat);
-        free(vol);
+        hfs_close(vol);
         return NULL;
     }
     uint32_t first_leaf = be32(cat + 14 + HDR_OFF_FIRST_LEAF);
@@ -712,30 +908,9 @@ static hfs_volume_t *open_classic(image_t *img, uint64_t partition_byte_offset,
     rc = collect_catalog_records(vol, cat, cat_size, node_size, first_leaf);
     free(cat);
     if (rc < 0) {
-        free(vol->records);
-        free(vol);
+        hfs_close(vol);
         return NULL;
     }
-
-    // Extents Overflow file — populates vol->xt_records for any fork
-    // that spills past its 3 inline extents.  Empty / missing EO file is
-    // not an error; many small volumes have nothing in it.  We tolerate
-    // partial reads of the EO file itself for the same reason we
-    // tolerate partial reads of the catalog: realistic volumes keep
-    // these special files small enough to fit in their inline extents.
-    uint8_t *xt = NULL;
-    size_t xt_size = 0;
-    if (load_xt_file(vol, mdb, &xt, &xt_size) == 0 && xt != NULL && xt_size >= 14 + HDR_OFF_NODE_SIZE + 2) {
-        size_t xt_node_size = be16(xt + 14 + HDR_OFF_NODE_SIZE);
-        if (xt_node_size > 0 && xt_node_size <= xt_size) {
-            uint32_t xt_first_leaf = be32(xt + 14 + HDR_OFF_FIRST_LEAF);
-            if (collect_xt_records(vol, xt, xt_size, xt_node_size, xt_first_leaf) < 0) {
-                // Non-fatal — fall through with whatever (if anything)
-                // we did manage to collect.
-            }
-        }
-    }
-    free(xt);
     return vol;
 }
 
@@ -1011,7 +1186,7 @@ static int collect_hfsplus_catalog(hfs_volume_t *vol, const uint8_t *cat_buf, si
     }
     vol->records = dst;
     vol->n_records = n;
-    return 0;
+    return index_catalog(vol);
 }
 
 // Validate a B-tree node size read from a header record: power of two in
@@ -1020,6 +1195,280 @@ static bool node_size_ok(size_t node_size, size_t file_size) {
     return node_size >= 512 && node_size <= 32768 && (node_size & (node_size - 1)) == 0 && node_size <= file_size;
 }
 
+// ---- Lazy catalog ---------------------------------------------------------
+//
+// Catalogs larger than the eager limit are not loaded.  The B-tree is walked
+// from its root node instead, a handful of nodes per request, through a
+// small LRU node cache: opening the volume costs the header node plus the
+// root folder's leaf, whatever the catalog's size.
+
+void hfs_set_eager_catalog_limit(size_t bytes) {
+    eager_catalog_limit = bytes;
+}
+
+// Catalog node `idx` through the node cache, or NULL on a read error.  The
+// pointer stays valid until the next call.
+static const uint8_t *cat_node(hfs_volume_t *vol, uint32_t idx) {
+    cat_tree_t *t = &vol->tree;
+    if (idx >= t->n_nodes)
+        return NULL;
+    cat_node_t *slot = &t->cache[0];
+    for (int i = 0; i < CAT_NODE_CACHE; i++) {
+        cat_node_t *c = &t->cache[i];
+        if (c->node == idx) {
+            c->stamp = ++t->clock;
+            return c->data;
+        }
+        if (c->stamp < slot->stamp)
+            slot = c;
+    }
+    if (!slot->data && !(slot->data = malloc(t->node_size)))
+        return NULL;
+    slot->node = CAT_NONE;
+    size_t got = 0;
+    int rc = hfs_read_fork(vol, &t->fork, (uint64_t)idx * t->node_size, slot->data, t->node_size, &got);
+    if (rc < 0 || got != t->node_size)
+        return NULL;
+    uint16_t nrecs = be16(slot->data + NODE_OFF_NRECS);
+    if (t->node_size < 14 + (size_t)(nrecs + 1) * 2)
+        return NULL;
+    slot->node = idx;
+    slot->stamp = ++t->clock;
+    return slot->data;
+}
+
+// Record `i` of a node and its length, or NULL when its offsets are bad.
+static const uint8_t *node_record(const uint8_t *node, size_t node_size, uint16_t i, size_t *len) {
+    uint16_t off = be16(node + node_size - (size_t)(i + 1) * 2);
+    uint16_t next = be16(node + node_size - (size_t)(i + 2) * 2);
+    if (off < 14 || next > node_size || next <= off)
+        return NULL;
+    *len = next - off;
+    return node + off;
+}
+
+// Decode the catalog key at the start of a `len`-byte record: its parent
+// CNID and, when `name` is non-NULL, its UTF-8 name.  Returns the size of
+// the key area (the record data or child pointer follows it), or 0 when
+// the key is malformed.
+static size_t read_key(const cat_tree_t *t, const uint8_t *rec, size_t len, uint32_t *parent, char *name,
+                       size_t name_cap) {
+    if (t->plus) {
+        if (len < 8)
+            return 0;
+        size_t area = 2 + (size_t)be16(rec);
+        uint16_t units = be16(rec + HFSP_KEY_OFF_NAMELEN);
+        if (area < 8 || area > len || units > 255 || HFSP_KEY_OFF_NAME + (size_t)units * 2 > area)
+            return 0;
+        *parent = be32(rec + HFSP_KEY_OFF_PARENT);
+        if (name)
+            utf16be_to_utf8(rec + HFSP_KEY_OFF_NAME, units, name, name_cap);
+        return area;
+    }
+    // Classic: keyLen(1) reserved(1) parID(4) nameLen(1) name[], padded to even.
+    if (len < 7 || rec[0] < 6)
+        return 0;
+    size_t area = (2 + (size_t)rec[0]) & ~(size_t)1;
+    uint8_t name_len = rec[6];
+    if (area > len || name_len > 31 || 7 + (size_t)name_len > 1 + (size_t)rec[0])
+        return 0;
+    *parent = be32(rec + 2);
+    if (name)
+        macroman_to_utf8(rec + 7, name_len, name, name_cap);
+    return area;
+}
+
+// Order two UTF-8 names the way catalog keys sort, as far as ASCII goes:
+// HFS+ compares code points case-folded to lower case, and UTF-8 byte order
+// is code point order.  Classic HFS's MacRoman table and HFSX's binary
+// order differ in places; lookups that land on the wrong leaf because of it
+// fall back to scanning the folder (see lazy_find_child).
+static int name_order(const char *a, const char *b) {
+    for (;; a++, b++) {
+        uint8_t ca = (uint8_t)*a, cb = (uint8_t)*b;
+        if (ca >= 'A' && ca <= 'Z')
+            ca += 32;
+        if (cb >= 'A' && cb <= 'Z')
+            cb += 32;
+        if (ca == ':')
+            ca = '/';
+        if (cb == ':')
+            cb = '/';
+        if (ca != cb || ca == 0)
+            return (int)ca - (int)cb;
+    }
+}
+
+// Descend from the root to the leaf where key (parent_cnid, name) sorts:
+// each index node sends us to its last child whose first key is not
+// greater.  An empty name finds the start of the folder's key range (its
+// thread record).  0 / -errno.
+static int tree_descend(hfs_volume_t *vol, uint32_t parent_cnid, const char *name, uint32_t *out_leaf) {
+    cat_tree_t *t = &vol->tree;
+    char key_name[256];
+    uint32_t idx = t->root;
+    for (int depth = 0; depth < 16; depth++) {
+        const uint8_t *node = cat_node(vol, idx);
+        if (!node)
+            return -EIO;
+        if (node[NODE_OFF_KIND] == NODE_KIND_LEAF) {
+            *out_leaf = idx;
+            return 0;
+        }
+        if (node[NODE_OFF_KIND] != NODE_KIND_INDEX)
+            return -EIO;
+        // Binary search for the last record whose key is <= the search key.
+        uint16_t nrecs = be16(node + NODE_OFF_NRECS);
+        int lo = 0, hi = (int)nrecs - 1, pick = 0;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            size_t len = 0;
+            uint32_t parent = 0;
+            const uint8_t *rec = node_record(node, t->node_size, (uint16_t)mid, &len);
+            size_t area = rec ? read_key(t, rec, len, &parent, key_name, sizeof(key_name)) : 0;
+            if (!area || area + 4 > len)
+                return -EIO;
+            int cmp = (parent != parent_cnid) ? (parent < parent_cnid ? -1 : 1) : name_order(key_name, name);
+            if (cmp <= 0) {
+                pick = mid;
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        size_t len = 0;
+        uint32_t parent = 0;
+        const uint8_t *rec = node_record(node, t->node_size, (uint16_t)pick, &len);
+        if (!rec)
+            return -EIO;
+        idx = be32(rec + read_key(t, rec, len, &parent, NULL, 0));
+    }
+    return -EIO; // deeper than any real catalog: an index cycle
+}
+
+// Point an iterator at the leaf where folder `parent_cnid`'s children start.
+static int lazy_dir_start(hfs_dir_iter_t *it, uint32_t parent_cnid) {
+    it->parent_cnid = parent_cnid;
+    it->n_batch = it->pos = 0;
+    it->hops = 0;
+    return tree_descend(it->vol, parent_cnid, "", &it->next_leaf);
+}
+
+// Decode leaves from it->next_leaf on until the batch holds children of the
+// iterator's folder or its key range has ended (batch left empty).
+// 0 / -errno.
+static int lazy_refill(hfs_dir_iter_t *it) {
+    hfs_volume_t *vol = it->vol;
+    cat_tree_t *t = &vol->tree;
+    it->n_batch = it->pos = 0;
+    while (it->n_batch == 0 && it->next_leaf != 0) {
+        if (it->hops++ > t->n_nodes)
+            return -EIO; // fLink cycle
+        const uint8_t *node = cat_node(vol, it->next_leaf);
+        if (!node)
+            return -EIO;
+        if (node[NODE_OFF_KIND] != NODE_KIND_LEAF)
+            return -EIO;
+        // The range ends in this leaf when its last key has a later parent.
+        uint16_t nrecs = be16(node + NODE_OFF_NRECS);
+        uint32_t last_parent = 0;
+        size_t len = 0;
+        const uint8_t *last = nrecs ? node_record(node, t->node_size, (uint16_t)(nrecs - 1), &len) : NULL;
+        if (last && !read_key(t, last, len, &last_parent, NULL, 0))
+            last_parent = 0;
+        it->next_leaf = (last_parent > it->parent_cnid) ? 0 : be32(node + NODE_OFF_F_LINK);
+
+        int rc = t->plus ? parse_hfsplus_catalog_leaf(node, t->node_size, &it->batch, &it->n_batch,
+                                                      &it->cap_batch, NULL, 0)
+                         : parse_leaf_node(node, t->node_size, &it->batch, &it->n_batch, &it->cap_batch);
+        if (rc < 0)
+            return rc;
+        size_t kept = 0;
+        for (size_t i = 0; i < it->n_batch; i++)
+            if (it->batch[i].parent_cnid == it->parent_cnid)
+                it->batch[kept++] = it->batch[i];
+        it->n_batch = kept;
+    }
+    return 0;
+}
+
+// Find child `name` of folder `parent_cnid` in a lazy catalog and copy it to
+// *out: the leaf its key sorts into holds it, unless the volume collates the
+// name differently than name_order, in which case the folder's whole key
+// range is scanned.  0, -ENOENT, or -errno.
+static int lazy_find_child(hfs_volume_t *vol, uint32_t parent_cnid, const char *name, cat_rec_t *out) {
+    cat_tree_t *t = &vol->tree;
+    hfs_dir_iter_t it = {.vol = vol, .parent_cnid = parent_cnid, .batch = t->scratch, .cap_batch = t->scratch_cap};
+    int rc = tree_descend(vol, parent_cnid, name, &it.next_leaf);
+    bool found = false;
+    // Pass 0 decodes the leaf the key sorts into, pass 1 the whole folder.
+    for (int pass = 0; rc == 0 && !found && pass < 2; pass++) {
+        if (pass == 1)
+            rc = lazy_dir_start(&it, parent_cnid);
+        while (!found && rc == 0 && (rc = lazy_refill(&it)) == 0 && it.n_batch != 0) {
+            for (size_t i = 0; i < it.n_batch && !found; i++) {
+                if ((found = name_matches(it.batch[i].name, name)))
+                    *out = it.batch[i];
+            }
+            if (pass == 0)
+                break;
+        }
+    }
+    t->scratch = it.batch;
+    t->scratch_cap = it.cap_batch;
+    return rc < 0 ? rc : found ? 0 : -ENOENT;
+}
+
+// Switch a volume to the lazy catalog: read the B-tree header, then the
+// root folder record (for the root valence and, on HFS+, the volume name).
+// 0 / -errno.
+static int open_lazy_catalog(hfs_volume_t *vol, const hfs_fork_t *fork, bool plus) {
+    cat_tree_t *t = &vol->tree;
+    uint8_t hdr[512];
+    size_t got = 0;
+    int rc = hfs_read_fork(vol, fork, 0, hdr, sizeof(hdr), &got);
+    if (rc < 0)
+        return rc;
+    size_t node_size = be16(hdr + 14 + HDR_OFF_NODE_SIZE);
+    if (!plus && node_size == 0)
+        node_size = 512; // classic HFS catalogs always use 512-byte nodes
+    if (got != sizeof(hdr) || !node_size_ok(node_size, fork->logical_size))
+        return -EINVAL;
+    t->fork = *fork;
+    t->plus = plus;
+    t->node_size = node_size;
+    t->n_nodes = (uint32_t)(fork->logical_size / node_size);
+    t->root = be32(hdr + 14 + HDR_OFF_ROOT);
+    if (t->root == 0 || t->root >= t->n_nodes)
+        return -EINVAL;
+    for (int i = 0; i < CAT_NODE_CACHE; i++)
+        t->cache[i].node = CAT_NONE;
+    vol->lazy = true;
+
+    // The root folder is the child of HFSP_ROOT_PARENT_ID (1 on HFS as well).
+    hfs_dir_iter_t it = {.vol = vol};
+    rc = lazy_dir_start(&it, HFSP_ROOT_PARENT_ID);
+    while (rc == 0 && (rc = lazy_refill(&it)) == 0 && it.n_batch != 0) {
+        for (size_t i = 0; i < it.n_batch; i++) {
+            const cat_rec_t *r = &it.batch[i];
+            if (r->record_type != CAT_REC_FOLDER || r->cnid != HFS_ROOT_CNID)
+                continue;
+            t->root_valence = r->valence;
+            if (vol->volume_name[0] == '\0')
+                snprintf(vol->volume_name, sizeof(vol->volume_name), "%s", r->name);
+        }
+    }
+    free(it.batch);
+    return rc;
+}
+
+// Release the node cache.
+static void close_lazy_catalog(cat_tree_t *t) {
+    for (int i = 0; i < CAT_NODE_CACHE; i++)
+        free(t->cache[i].data);
+    free(t->scratch);
+}
+
 // Open an HFS+ / HFSX volume whose Volume Header sits at offset 1024 from
 // `partition_byte_offset`.  Returns NULL on any error.
 static hfs_volume_t *open_plus(image_t *img, uint64_t partition_byte_offset, uint64_t partition_byte_size) {
@@ -1069,6 +1518,16 @@ static hfs_volume_t *open_plus(image_t *img, uint64_t partition_byte_offset, uin
     // 2) Catalog file (now able to follow overflow extents).
     hfs_fork_t cat_fork;
     parse_hfsplus_fork(vh + VH_OFF_CAT_FORK, HFSP_CATALOG_FILE_ID, 0x00, &cat_fork);
+    if (cat_fork.logical_size > eager_catalog_limit) {
+        // Too large to load: walk the B-tree on demand.
+        if (open_lazy_catalog(vol, &cat_fork, true) < 0) {
+            hfs_close(vol);
+            return NULL;
+        }
+        if (vol->volume_name[0] == '\0')
+            snprintf(vol->volume_name, sizeof(vol->volume_name), "HFS+");
+        return vol;
+    }
     uint8_t *cat = NULL;
     size_t cat_size = 0;
     if (read_fork_to_buffer(vol, &cat_fork, 128u * 1024 * 1024, &cat, &cat_size) < 0) {
@@ -1145,26 +1604,56 @@ hfs_volume_t *hfs_open(image_t *img, uint64_t partition_byte_offset, uint64_t pa
     return NULL;
 }
 
+// Free everything a volume holds but the handle itself.
+static void release_volume(hfs_volume_t *vol) {
+    free_index(&vol->index);
+    close_lazy_catalog(&vol->tree);
+    free(vol->records);
+    free(vol->xt_records);
+}
+
 void hfs_close(hfs_volume_t *vol) {
     if (!vol)
         return;
-    free(vol->records);
-    free(vol->xt_records);
+    release_volume(vol);
     free(vol);
 }
 
+int hfs_refresh(hfs_volume_t *vol) {
+    if (!vol)
+        return -EINVAL;
+    // Reopen on the same span and move the result into the caller's handle
+    hfs_volume_t *fresh = hfs_open(vol->img, vol->partition_off, vol->partition_size);
+    if (!fresh)
+        return -EIO;
+    uint32_t generation = vol->generation + 1;
+    release_volume(vol);
+    *vol = *fresh;
+    free(fresh);
+    vol->generation = generation;
+    return 0;
+}
+
+void hfs_volume_span(const hfs_volume_t *vol, image_t **img, uint64_t *offset, uint64_t *size) {
+    *img = vol->img;
+    *offset = vol->partition_off;
+    *size = vol->partition_size;
+}
+
 const char *hfs_volume_name(const hfs_volume_t *vol) {
     return vol ? vol->volume_name : "";
 }
 
-// Find a record with the given parent CNID and UTF-8 name.  O(n) scan; fine
-// for realistic catalog sizes.
+// Find a record with the given parent CNID and UTF-8 name: one probe of the
+// (parent, folded name) hash.
 static const cat_rec_t *find_child(const hfs_volume_t *vol, uint32_t parent_cnid, const char *name) {
-    for (size_t i = 0; i < vol->n_records; i++) {
+    const cat_index_t *x = &vol->index;
+    if (!x->name_buckets)
+        return NULL;
+    uint32_t i = x->name_buckets[cat_key_hash(parent_cnid, name) & x->mask];
+    for (; i != CAT_NONE; i = x->name_next[i]) {
         const cat_rec_t *r = &vol->records[i];
-        if (r->parent_cnid != parent_cnid)
-            continue;
-        if (name_matches(r->name, name))
+        if (r->parent_cnid == parent_cnid && name_matches(r->name, name))
             return r;
     }
     return NULL;
@@ -1180,18 +1669,23 @@ int hfs_lookup(hfs_volume_t *vol, const char *const *components, size_t nc, hfs_
         snprintf(out->name, sizeof(out->name), "%s", vol->volume_name);
         out->is_dir = true;
         out->cnid = HFS_ROOT_CNID;
-        // Count root-level children to populate valence.
-        for (size_t i = 0; i < vol->n_records; i++)
-            if (vol->records[i].parent_cnid == HFS_ROOT_CNID)
-                out->valence++;
+        // Valence is the number of root-level children.
+        const cat_dir_t *root = find_dir(vol, HFS_ROOT_CNID);
+        out->valence = vol->lazy ? vol->tree.root_valence : root ? root->n_children : 0;
         return 0;
     }
     uint32_t parent = HFS_ROOT_CNID;
     const cat_rec_t *r = NULL;
+    cat_rec_t found;
     for (size_t i = 0; i < nc; i++) {
-        r = find_child(vol, parent, components[i]);
-        if (!r)
+        if (vol->lazy) {
+            int rc = lazy_find_child(vol, parent, components[i], &found);
+            if (rc < 0)
+                return rc;
+            r = &found;
+        } else if (!(r = find_child(vol, parent, components[i]))) {
             return -ENOENT;
+        }
         // Descend only if this isn't the last component.
         if (i + 1 < nc) {
             if (r->record_type != CAT_REC_FOLDER)
@@ -1210,26 +1704,47 @@ hfs_dir_iter_t *hfs_opendir_cnid(hfs_volume_t *vol, uint32_t parent_cnid) {
     if (!iter)
         return NULL;
     iter->vol = vol;
+    iter->generation = vol->generation;
     iter->parent_cnid = parent_cnid;
-    iter->cursor = 0;
+    if (vol->lazy) {
+        if (lazy_dir_start(iter, parent_cnid) < 0) {
+            free(iter);
+            return NULL;
+        }
+        return iter;
+    }
+    const cat_dir_t *dir = find_dir(vol, parent_cnid);
+    iter->cursor = dir ? dir->first_child : CAT_NONE;
     return iter;
 }
 
 int hfs_readdir_next(hfs_dir_iter_t *iter, hfs_dirent_t *out) {
     if (!iter || !out)
         return -EINVAL;
-    const hfs_volume_t *vol = iter->vol;
-    while (iter->cursor < vol->n_records) {
-        const cat_rec_t *r = &vol->records[iter->cursor++];
-        if (r->parent_cnid != iter->parent_cnid)
-            continue;
-        fill_dirent(r, out);
+    if (iter->generation != iter->vol->generation)
+        return -ESTALE;
+    if (iter->vol->lazy) {
+        if (iter->pos == iter->n_batch) {
+            int rc = lazy_refill(iter);
+            if (rc < 0)
+                return rc;
+            if (iter->n_batch == 0)
+                return 0;
+        }
+        fill_dirent(&iter->batch[iter->pos++], out);
         return 1;
     }
-    return 0;
+    if (iter->cursor == CAT_NONE)
+        return 0;
+    const hfs_volume_t *vol = iter->vol;
+    fill_dirent(&vol->records[iter->cursor], out);
+    iter->cursor = vol->index.sibling_next[iter->cursor];
+    return 1;
 }
 
 void hfs_closedir_iter(hfs_dir_iter_t *iter) {
+    if (iter)
+        free(iter->batch);
     free(iter);
 }
 
@@ -5,10 +5,11 @@
 // Read-only HFS / HFS+ catalog walker.  Given an image_t plus the byte
 // offset and size of a partition, opens the volume (classic HFS Master
 // Directory Block or an HFS Plus Volume Header), loads the catalog file
-// into RAM, and exposes path-lookup, directory-enumerate, and fork-read
-// entry points for the image_vfs backend.  HFS and HFS+ share the same
-// opaque handle and public types; hfs_open sniffs the on-disk signature
-// and routes to the right parser, so callers don't distinguish the two.
+// into RAM (or, past HFS_EAGER_CATALOG_MAX, walks it on disk), and exposes
+// path-lookup, directory-enumerate, and fork-read entry points for the
+// image_vfs backend.  HFS and HFS+ share the same opaque handle and public
+// types; hfs_open sniffs the on-disk signature and routes to the right
+// parser, so callers don't distinguish the two.
 //
 // Scope:
 //   - 400K / 800K / 1.4M floppies with no partition map (partition_offset=0).
@@ -17,6 +18,9 @@
 //   - Data and resource forks via the inline file-record extents (3 for
 //     HFS, 8 for HFS+) plus the extents-overflow file for fragmented forks.
 //   - MacRoman (HFS) / UTF-16 (HFS+) -> UTF-8 transcoding on enumeration.
+//
+// Classic HFS volumes can also be written from the host (image_hfs_write.c):
+// files and folders created and deleted, forks written, Finder info set.
 
 #pragma once
 
@@ -72,6 +76,15 @@ typedef struct hfs_dirent {
 // Opaque volume handle.
 typedef struct hfs_volume hfs_volume_t;
 
+// Catalog files up to this many bytes (every floppy and most hard disks) are
+// read whole at hfs_open and indexed in memory.  Larger ones are left on
+// disk and their B-tree is walked per lookup / enumeration through a small
+// node cache, so opening a multi-GB volume costs a few node reads.
+#define HFS_EAGER_CATALOG_MAX (1024 * 1024)
+
+// Change that limit for volumes opened from now on.
+void hfs_set_eager_catalog_limit(size_t bytes);
+
 // Open an HFS volume backed by `img`.  `partition_byte_offset` is the byte
 // offset within the image at which the volume starts (0 for a bare floppy;
 // start_block*512 for an APM partition).  `partition_byte_size` caps reads.
@@ -102,4 +115,47 @@ void hfs_closedir_iter(hfs_dir_iter_t *iter);
 // returns a negated errno on read failure.
 int hfs_read_fork(hfs_volume_t *vol, const hfs_fork_t *fork, uint64_t off, void *buf, size_t n, size_t *nread);
 
+// Re-read the volume after its image changed underneath the handle.  The
+// handle stays valid; directory iterators opened before the call fail with
+// -ESTALE.  Returns 0, or a negated errno (the handle is unchanged then).
+int hfs_refresh(hfs_volume_t *vol);
+
+// ---- Writing (classic HFS) ----
+//
+// Each call edits the catalog and extents B-trees, the volume bitmap and the
+// MDB through disk_write_data and then refreshes the handle.  A call that
+// fails may have written part of its change: callers needing atomicity stage
+// the writes (image_vfs keeps them in the image's delta until the call
+// succeeds) and call hfs_refresh after discarding them.  HFS+ volumes,
+// including one embedded in an HFS wrapper, return -EROFS.  Names are UTF-8
+// and must encode to 1..31 MacRoman bytes (':' stands for an on-disk '/').
+
+// Contents for hfs_put_file.  `finder_info` (FInfo + FXInfo, 32 bytes) may
+// be NULL: a new file then gets zeros, a replaced one keeps its own.
+typedef struct hfs_put {
+    const void *data;
+    uint64_t data_len;
+    const void *rsrc;
+    uint64_t rsrc_len;
+    const uint8_t *finder_info;
+} hfs_put_t;
+
+// True if the hfs_* writers accept this volume.
+bool hfs_writable(const hfs_volume_t *vol);
+
+// Create the folder named by the last component.  -EEXIST if the name is
+// taken, -ENOSPC when the catalog has no free node for it.
+int hfs_mkdir(hfs_volume_t *vol, const char *const *components, size_t nc);
+
+// Create a file, or replace the forks of an existing one, with `put`.
+// -EISDIR if the name is a folder, -ENOSPC when the volume or its B-trees
+// are full (the catalog and extents files are never grown).
+int hfs_put_file(hfs_volume_t *vol, const char *const *components, size_t nc, const hfs_put_t *put);
+
+// Replace the 32-byte Finder info of a file or folder.
+int hfs_set_finder_info(hfs_volume_t *vol, const char *const *components, size_t nc, const uint8_t finder_info[32]);
+
+// Delete a file (both forks) or an empty folder (-ENOTEMPTY otherwise).
+int hfs_remove(hfs_volume_t *vol, const char *const *components, size_t nc);
+
 #endif // IMAGE_HFS_H
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// image_hfs_internal.h
+// Shared internals of the HFS catalog walker (image_hfs.c) and the classic
+// HFS writer (image_hfs_write.c).  Not part of the public API.
+
+#ifndef IMAGE_HFS_INTERNAL_H
+#define IMAGE_HFS_INTERNAL_H
+
+#include "image.h"
+#include "image_hfs.h"
+
+#include <stdint.h>
+
+// The image and the byte range of it a volume was opened on
+void hfs_volume_span(const hfs_volume_t *vol, image_t **img, uint64_t *offset, uint64_t *size);
+
+#endif // IMAGE_HFS_INTERNAL_H
@@ -0,0 +1,1275 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// image_hfs_write.c
+// Host-side writer for classic HFS volumes.  Creates and deletes files and
+// folders, writes data and resource forks and sets Finder info by editing
+// the on-disk structures directly: the catalog and extents-overflow
+// B-trees (insert with node splits, delete with node release), the volume
+// bitmap and the Master Directory Block.  Every change goes through
+// disk_write_data, so it lands in the image's storage delta like a guest
+// write would; each public call ends with hfs_refresh so the handle's
+// read-side view matches the disk.
+//
+// Limits, chosen to keep the writer small: B-tree nodes are the 512 bytes
+// every classic HFS volume uses, the catalog and extents files are never
+// grown (a full one is -ENOSPC), and neither may itself spill into the
+// extents-overflow file.  Fork data is allocated first-fit, contiguous when
+// a free run is large enough, and any extents past the three inline ones go
+// to the extents-overflow file.  Catalog keys are ordered the way the File
+// Manager orders them: case-insensitive, accented letters next to their
+// base letter.
+
+#include "image_hfs.h"
+#include "image.h"
+#include "image_hfs_internal.h"
+#include "macroman.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ---- On-disk layout -------------------------------------------------------
+
+#define NODE_SIZE     512 // classic HFS B-tree node
+#define MDB_OFFSET    1024 // Master Directory Block, from the volume start
+#define WR_MAX_DEPTH  8
+#define WR_MAX_RECS   ((NODE_SIZE - 14) / 4) // records in a node, as an upper bound
+#define MAC_EPOCH_GAP 2082844800u // seconds from 1904-01-01 to 1970-01-01
+
+// MDB fields
+#define MDB_SIG         0
+#define MDB_LS_MOD      6
+#define MDB_ATRB        10
+#define MDB_NM_FLS      12 // files in the root folder
+#define MDB_VBM_ST      14 // first 512-byte block of the volume bitmap
+#define MDB_NM_AL_BLKS  18
+#define MDB_AL_BLK_SIZ  20
+#define MDB_AL_BL_ST    28
+#define MDB_NXT_CNID    30
+#define MDB_FREE_BKS    34
+#define MDB_WR_CNT      70
+#define MDB_NM_RT_DIRS  82 // folders in the root folder
+#define MDB_FIL_CNT     84
+#define MDB_DIR_CNT     88
+#define MDB_EMBED_SIG   124
+#define MDB_XT_EXT_REC  134
+#define MDB_CT_EXT_REC  150
+#define ATRB_LOCKED     0x8080 // hardware | software lock
+
+// Node descriptor
+#define ND_F_LINK 0
+#define ND_B_LINK 4
+#define ND_KIND   8
+#define ND_HEIGHT 9
+#define ND_NRECS  10
+#define KIND_INDEX 0x00
+#define KIND_LEAF  0xFF
+
+// Header record, after the node descriptor of node 0
+#define HR_DEPTH     (14 + 0)
+#define HR_ROOT      (14 + 2)
+#define HR_NRECS     (14 + 6)
+#define HR_FIRST     (14 + 10)
+#define HR_LAST      (14 + 14)
+#define HR_NODE_SIZE (14 + 18)
+#define HR_NNODES    (14 + 22)
+#define HR_FREE      (14 + 26)
+
+// Catalog records
+#define REC_FOLDER        1
+#define REC_FILE          2
+#define REC_FOLDER_THREAD 3
+#define REC_FILE_THREAD   4
+#define FOLDER_REC_SIZE   70
+#define FILE_REC_SIZE     102
+#define THREAD_REC_SIZE   46
+#define CAT_KEY_LEN       37 // keyLen of every catalog index key
+#define EXT_KEY_LEN       7
+
+#define FOLDER_VALENCE 4
+#define FOLDER_ID      6
+#define FOLDER_CR_DAT  10
+#define FOLDER_MD_DAT  14
+#define FOLDER_USR     22 // DInfo(16) + DXInfo(16)
+#define FILE_FINFO     4
+#define FILE_ID        20
+#define FILE_ST_BLK    24
+#define FILE_LG_LEN    26 // data fork logical / physical length
+#define FILE_R_ST_BLK  34
+#define FILE_R_LG_LEN  36
+#define FILE_CR_DAT    44
+#define FILE_MD_DAT    48
+#define FILE_FXINFO    56
+#define FILE_EXT       74
+#define FILE_R_EXT     86
+#define THREAD_PAR_ID  10
+#define THREAD_NAME    14
+
+// ---- Big-endian helpers ----------------------------------------------------
+
+static uint16_t be16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put16(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// ---- Writer state ---------------------------------------------------------
+
+struct hfs_wr;
+
+// One B-tree (catalog or extents overflow) of the volume being written.
+typedef struct wr_tree {
+    struct hfs_wr *w;
+    uint16_t ext[HFS_INLINE_EXTENTS][2]; // the tree file's extents (start, count)
+    uint32_t n_nodes;
+    uint8_t hdr[NODE_SIZE]; // node 0, written back by wr_finish
+    bool hdr_dirty;
+    uint8_t index_key_len;
+    int (*compare)(const uint8_t *a, const uint8_t *b); // keys, from their length byte
+} wr_tree_t;
+
+// State of one write call.
+typedef struct hfs_wr {
+    hfs_volume_t *vol;
+    image_t *img;
+    uint64_t off, size; // volume span within the image
+    uint8_t mdb[512];
+    uint32_t ab_size;
+    uint64_t ab0; // volume offset of allocation block 0
+    uint32_t n_ab;
+    uint8_t *bitmap; // volume bitmap, loaded on first use
+    size_t bitmap_len;
+    bool bitmap_dirty;
+    wr_tree_t cat, ext;
+} hfs_wr_t;
+
+// Path from the root to a leaf: node and record index per level.
+typedef struct wr_path {
+    uint32_t node[WR_MAX_DEPTH];
+    uint16_t idx[WR_MAX_DEPTH];
+    int depth;
+} wr_path_t;
+
+// A record borrowed from a node buffer.
+typedef struct wr_rec {
+    const uint8_t *p;
+    size_t len;
+} wr_rec_t;
+
+// One run of allocation blocks.
+typedef struct wr_extent {
+    uint32_t start, count;
+} wr_extent_t;
+
+// Read or write len bytes at a 512-aligned volume offset.
+static int wr_disk(hfs_wr_t *w, uint64_t off, void *buf, size_t len, bool write) {
+    if (off + len > w->size)
+        return -EIO;
+    size_t done = write ? disk_write_data(w->img, (size_t)(w->off + off), buf, len)
+                        : disk_read_data(w->img, (size_t)(w->off + off), buf, len);
+    return done == len ? 0 : -EIO;
+}
+
+// Current time in Mac (1904-based) seconds.
+static uint32_t mac_now(void) {
+    return (uint32_t)((uint64_t)time(NULL) + MAC_EPOCH_GAP);
+}
+
+// ---- Key order ------------------------------------------------------------
+
+// Sort weights of the MacRoman letters 0x80..0xFF: base letter in the high
+// byte, accent in the low one; case is ignored.  Zero entries (symbols)
+// sort by their own code, after every ASCII character.
+#define W(c, accent) (uint16_t)(((c) << 8) | (accent))
+static const uint16_t hi_weight[128] = {
+    [0x00] = W('A', 4), [0x01] = W('A', 6), [0x02] = W('C', 7), [0x03] = W('E', 1), [0x04] = W('N', 5),
+    [0x05] = W('O', 4), [0x06] = W('U', 4), [0x07] = W('A', 1), [0x08] = W('A', 2), [0x09] = W('A', 3),
+    [0x0A] = W('A', 4), [0x0B] = W('A', 5), [0x0C] = W('A', 6), [0x0D] = W('C', 7), [0x0E] = W('E', 1),
+    [0x0F] = W('E', 2), [0x10] = W('E', 3), [0x11] = W('E', 4), [0x12] = W('I', 1), [0x13] = W('I', 2),
+    [0x14] = W('I', 3), [0x15] = W('I', 4), [0x16] = W('N', 5), [0x17] = W('O', 1), [0x18] = W('O', 2),
+    [0x19] = W('O', 3), [0x1A] = W('O', 4), [0x1B] = W('O', 5), [0x1C] = W('U', 1), [0x1D] = W('U', 2),
+    [0x1E] = W('U', 3), [0x1F] = W('U', 4), [0x27] = W('S', 9), [0x2E] = W('A', 9), [0x2F] = W('O', 8),
+    [0x3E] = W('A', 9), [0x3F] = W('O', 8), [0x4B] = W('A', 2), [0x4C] = W('A', 5), [0x4D] = W('O', 5),
+    [0x4E] = W('O', 9), [0x4F] = W('O', 9), [0x58] = W('Y', 4), [0x59] = W('Y', 4), [0x65] = W('A', 3),
+    [0x66] = W('E', 3), [0x67] = W('A', 1), [0x68] = W('E', 4), [0x69] = W('E', 2), [0x6A] = W('I', 1),
+    [0x6B] = W('I', 3), [0x6C] = W('I', 4), [0x6D] = W('I', 2), [0x6E] = W('O', 1), [0x6F] = W('O', 3),
+    [0x71] = W('O', 2), [0x72] = W('U', 1), [0x73] = W('U', 3), [0x74] = W('U', 2),
+};
+#undef W
+
+static uint16_t sort_weight(uint8_t c) {
+    if (c >= 0x80)
+        return hi_weight[c - 0x80] ? hi_weight[c - 0x80] : (uint16_t)(c << 8);
+    if (c >= 'a' && c <= 'z')
+        c -= 32;
+    return (uint16_t)(c << 8);
+}
+
+// Catalog key order: parent CNID, then name.
+static int cat_compare(const uint8_t *a, const uint8_t *b) {
+    uint32_t pa = be32(a + 2), pb = be32(b + 2);
+    if (pa != pb)
+        return pa < pb ? -1 : 1;
+    size_t la = a[6] > 31 ? 31 : a[6];
+    size_t lb = b[6] > 31 ? 31 : b[6];
+    for (size_t i = 0; i < la && i < lb; i++) {
+        if (a[7 + i] == b[7 + i])
+            continue;
+        uint16_t wa = sort_weight(a[7 + i]), wb = sort_weight(b[7 + i]);
+        if (wa != wb)
+            return wa < wb ? -1 : 1;
+    }
+    return la == lb ? 0 : la < lb ? -1 : 1;
+}
+
+// Extents key order: file ID, fork type, first logical block.
+static int ext_compare(const uint8_t *a, const uint8_t *b) {
+    uint32_t fa = be32(a + 2), fb = be32(b + 2);
+    if (fa != fb)
+        return fa < fb ? -1 : 1;
+    if (a[1] != b[1])
+        return a[1] < b[1] ? -1 : 1;
+    uint16_t sa = be16(a + 6), sb = be16(b + 6);
+    return sa == sb ? 0 : sa < sb ? -1 : 1;
+}
+
+// Build a catalog key; returns its size.
+static size_t cat_key(uint8_t *key, uint32_t parent, const uint8_t *name, size_t len) {
+    key[0] = (uint8_t)(6 + len);
+    key[1] = 0;
+    put32(key + 2, parent);
+    key[6] = (uint8_t)len;
+    if (len)
+        memcpy(key + 7, name, len);
+    return 7 + len;
+}
+
+// Build an extents key; returns its size.
+static size_t ext_key(uint8_t *key, uint32_t file_id, uint8_t fork_type, uint32_t start) {
+    key[0] = EXT_KEY_LEN;
+    key[1] = fork_type;
+    put32(key + 2, file_id);
+    put16(key + 6, start);
+    return 8;
+}
+
+// Bytes from the start of a record to its data (the key, padded to even).
+static size_t key_area(const uint8_t *rec) {
+    return ((size_t)rec[0] + 2) & ~(size_t)1;
+}
+
+// Assemble key + data into one record; returns its size.
+static size_t make_record(uint8_t *out, const uint8_t *key, const void *data, size_t data_len) {
+    size_t k = key_area(key);
+    memset(out, 0, k);
+    memcpy(out, key, (size_t)key[0] + 1);
+    memcpy(out + k, data, data_len);
+    return k + data_len;
+}
+
+// ---- Nodes ----------------------------------------------------------------
+
+// Read or write node `idx` of a tree.
+static int node_io(wr_tree_t *t, uint32_t idx, uint8_t *buf, bool write) {
+    if (idx >= t->n_nodes)
+        return -EIO;
+    uint64_t pos = (uint64_t)idx * NODE_SIZE;
+    for (int i = 0; i < HFS_INLINE_EXTENTS; i++) {
+        uint64_t bytes = (uint64_t)t->ext[i][1] * t->w->ab_size;
+        if (pos < bytes)
+            return wr_disk(t->w, t->w->ab0 + (uint64_t)t->ext[i][0] * t->w->ab_size + pos, buf, NODE_SIZE, write);
+        pos -= bytes;
+    }
+    return -EIO;
+}
+
+// Split a node into its records.  Returns 0, or -EIO when its offsets are bad.
+static int node_records(const uint8_t *node, wr_rec_t *recs, size_t *n) {
+    size_t count = be16(node + ND_NRECS);
+    if (count > WR_MAX_RECS)
+        return -EIO;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t off = be16(node + NODE_SIZE - (i + 1) * 2);
+        uint16_t next = be16(node + NODE_SIZE - (i + 2) * 2);
+        if (off < 14 || next <= off || next > NODE_SIZE - (count + 1) * 2)
+            return -EIO;
+        recs[i].p = node + off;
+        recs[i].len = next - off;
+    }
+    *n = count;
+    return 0;
+}
+
+// Bytes n records take in a node, offsets included.
+static size_t records_size(const wr_rec_t *recs, size_t n) {
+    size_t total = 14 + 2 * (n + 1);
+    for (size_t i = 0; i < n; i++)
+        total += recs[i].len;
+    return total;
+}
+
+// Lay records out in `node` after its (already set) descriptor.  Returns
+// false, leaving the node unusable, when they do not fit.
+static bool node_fill(uint8_t *node, const wr_rec_t *recs, size_t n) {
+    if (records_size(recs, n) > NODE_SIZE)
+        return false;
+    memset(node + 14, 0, NODE_SIZE - 14);
+    size_t off = 14;
+    for (size_t i = 0; i < n; i++) {
+        put16(node + NODE_SIZE - (i + 1) * 2, (uint32_t)off);
+        memcpy(node + off, recs[i].p, recs[i].len);
+        off += recs[i].len;
+    }
+    put16(node + NODE_SIZE - (n + 1) * 2, (uint32_t)off);
+    put16(node + ND_NRECS, (uint32_t)n);
+    return true;
+}
+
+// Index record pointing at `child`, keyed by the first record of that child.
+static size_t index_record(const wr_tree_t *t, const uint8_t *first, uint32_t child, uint8_t *out) {
+    size_t k = (size_t)t->index_key_len + 1;
+    memset(out, 0, k);
+    memcpy(out, first, (size_t)first[0] + 1 > k ? k : (size_t)first[0] + 1);
+    out[0] = t->index_key_len;
+    k = key_area(out);
+    put32(out + k, child);
+    return k + 4;
+}
+
+// ---- Header and node map --------------------------------------------------
+
+static uint32_t hdr32(const wr_tree_t *t, size_t off) {
+    return be32(t->hdr + off);
+}
+
+static void set_hdr32(wr_tree_t *t, size_t off, uint32_t v) {
+    put32(t->hdr + off, v);
+    t->hdr_dirty = true;
+}
+
+// Allocate a node (*idx = UINT32_MAX on entry) or release node *idx, through
+// the map records: record 2 of the header node, then the map nodes chained
+// from it.
+static int node_map(wr_tree_t *t, uint32_t *idx, bool alloc) {
+    uint8_t buf[NODE_SIZE];
+    uint32_t node = 0, base = 0;
+    for (uint32_t hops = 0;; hops++) {
+        uint8_t *n = node == 0 ? t->hdr : buf;
+        wr_rec_t recs[WR_MAX_RECS];
+        size_t count = 0;
+        unsigned rec = node == 0 ? 2 : 0;
+        if (node_records(n, recs, &count) < 0 || count <= rec)
+            return -EIO;
+        uint8_t *map = n + (recs[rec].p - n);
+        uint32_t bits = (uint32_t)recs[rec].len * 8;
+        for (uint32_t b = 0; alloc && b < bits && base + b < t->n_nodes; b++) {
+            if (!(map[b >> 3] & (0x80 >> (b & 7)))) {
+                map[b >> 3] |= (uint8_t)(0x80 >> (b & 7));
+                *idx = base + b;
+                break;
+            }
+        }
+        if (!alloc && *idx < base + bits) {
+            uint32_t b = *idx - base;
+            map[b >> 3] &= (uint8_t)~(0x80 >> (b & 7));
+        }
+        if (!alloc || *idx != UINT32_MAX) {
+            if (node == 0) {
+                t->hdr_dirty = true;
+                return 0;
+            }
+            return node_io(t, node, buf, true);
+        }
+        base += bits;
+        node = be32(n + ND_F_LINK);
+        if (!node || hops > t->n_nodes)
+            return alloc ? -ENOSPC : -EIO;
+        int rc = node_io(t, node, buf, false);
+        if (rc < 0)
+            return rc;
+    }
+}
+
+// Take a free node for a new tree node.
+static int node_alloc(wr_tree_t *t, uint32_t *idx) {
+    if (hdr32(t, HR_FREE) == 0)
+        return -ENOSPC;
+    *idx = UINT32_MAX;
+    int rc = node_map(t, idx, true);
+    if (rc == 0)
+        set_hdr32(t, HR_FREE, hdr32(t, HR_FREE) - 1);
+    return rc;
+}
+
+// Return a node to the free pool, zeroing it on disk.
+static int node_release(wr_tree_t *t, uint32_t idx) {
+    int rc = node_map(t, &idx, false);
+    if (rc < 0)
+        return rc;
+    set_hdr32(t, HR_FREE, hdr32(t, HR_FREE) + 1);
+    uint8_t zero[NODE_SIZE] = {0};
+    return node_io(t, idx, zero, true);
+}
+
+// ---- Search ---------------------------------------------------------------
+
+// Descend from the root towards `key`.  Leaves the path to the leaf where
+// the key is or would go (path->depth 0 for an empty tree) and sets *exact
+// when the leaf record at path->idx matches.
+static int tree_search(wr_tree_t *t, const uint8_t *key, wr_path_t *path, bool *exact) {
+    uint8_t node[NODE_SIZE];
+    uint32_t idx = hdr32(t, HR_ROOT);
+    path->depth = 0;
+    *exact = false;
+    if (be16(t->hdr + HR_DEPTH) == 0)
+        return 0;
+    for (int level = 0; level < WR_MAX_DEPTH; level++) {
+        wr_rec_t recs[WR_MAX_RECS];
+        size_t n = 0;
+        int rc = node_io(t, idx, node, false);
+        if (rc < 0 || (rc = node_records(node, recs, &n)) < 0)
+            return rc;
+        path->node[level] = idx;
+        if (node[ND_KIND] == KIND_LEAF) {
+            size_t pos = 0;
+            int cmp = 1;
+            while (pos < n && (cmp = t->compare(recs[pos].p, key)) < 0)
+                pos++;
+            *exact = pos < n && cmp == 0;
+            path->idx[level] = (uint16_t)pos;
+            path->depth = level + 1;
+            return 0;
+        }
+        if (node[ND_KIND] != KIND_INDEX || n == 0)
+            return -EIO;
+        // Last child whose first key is not above the search key (else the first)
+        size_t i = 0;
+        while (i + 1 < n && t->compare(recs[i + 1].p, key) <= 0)
+            i++;
+        if (key_area(recs[i].p) + 4 > recs[i].len)
+            return -EIO;
+        path->idx[level] = (uint16_t)i;
+        idx = be32(recs[i].p + key_area(recs[i].p));
+    }
+    return -EIO;
+}
+
+// Copy the record with exactly `key` into out (NODE_SIZE bytes).  -ENOENT if absent.
+static int tree_find(wr_tree_t *t, const uint8_t *key, uint8_t *out, size_t *len) {
+    wr_path_t path;
+    bool exact;
+    int rc = tree_search(t, key, &path, &exact);
+    if (rc < 0)
+        return rc;
+    if (!exact)
+        return -ENOENT;
+    uint8_t node[NODE_SIZE];
+    wr_rec_t recs[WR_MAX_RECS];
+    size_t n = 0;
+    if ((rc = node_io(t, path.node[path.depth - 1], node, false)) < 0 || (rc = node_records(node, recs, &n)) < 0)
+        return rc;
+    const wr_rec_t *r = &recs[path.idx[path.depth - 1]];
+    memcpy(out, r->p, r->len);
+    *len = r->len;
+    return 0;
+}
+
+// Copy the first record at or after `key` into out.  -ENOENT past the end.
+static int tree_seek(wr_tree_t *t, const uint8_t *key, uint8_t *out, size_t *len) {
+    wr_path_t path;
+    bool exact;
+    int rc = tree_search(t, key, &path, &exact);
+    if (rc < 0)
+        return rc;
+    if (path.depth == 0)
+        return -ENOENT;
+    uint8_t node[NODE_SIZE];
+    wr_rec_t recs[WR_MAX_RECS];
+    size_t n = 0;
+    uint32_t idx = path.node[path.depth - 1];
+    size_t pos = path.idx[path.depth - 1];
+    for (uint32_t hops = 0; hops <= t->n_nodes; hops++) {
+        if ((rc = node_io(t, idx, node, false)) < 0 || (rc = node_records(node, recs, &n)) < 0)
+            return rc;
+        if (pos < n) {
+            memcpy(out, recs[pos].p, recs[pos].len);
+            *len = recs[pos].len;
+            return 0;
+        }
+        if (!(idx = be32(node + ND_F_LINK)))
+            return -ENOENT;
+        pos = 0;
+    }
+    return -EIO;
+}
+
+// ---- Insert / update / delete ---------------------------------------------
+
+// Re-key the parent's pointer to path->node[level] after that node's first
+// record changed, up the tree while the change is to a first record.
+static int fix_parent_key(wr_tree_t *t, const wr_path_t *path, int level) {
+    for (; level > 0; level--) {
+        uint8_t child[NODE_SIZE], parent[NODE_SIZE];
+        wr_rec_t recs[WR_MAX_RECS];
+        size_t n = 0;
+        int rc = node_io(t, path->node[level], child, false);
+        if (rc < 0 || (rc = node_records(child, recs, &n)) < 0)
+            return rc;
+        if (n == 0)
+            return -EIO;
+        uint8_t irec[64];
+        size_t ilen = index_record(t, recs[0].p, path->node[level], irec);
+        if ((rc = node_io(t, path->node[level - 1], parent, false)) < 0 || (rc = node_records(parent, recs, &n)) < 0)
+            return rc;
+        size_t i = path->idx[level - 1];
+        if (i >= n || recs[i].len != ilen)
+            return -EIO;
+        memcpy(parent + (recs[i].p - parent), irec, ilen);
+        if ((rc = node_io(t, path->node[level - 1], parent, true)) < 0)
+            return rc;
+        if (i != 0)
+            return 0;
+    }
+    return 0;
+}
+
+// Insert a record at position pos of the node at `level` of the path,
+// splitting it (and, in turn, its ancestors) when it is full.
+static int insert_at(wr_tree_t *t, const wr_path_t *path, int level, size_t pos, const uint8_t *rec, size_t len) {
+    uint8_t old[NODE_SIZE], left[NODE_SIZE], right[NODE_SIZE];
+    wr_rec_t recs[WR_MAX_RECS + 1];
+    size_t n = 0;
+    uint32_t id = path->node[level];
+    int rc = node_io(t, id, old, false);
+    if (rc < 0 || (rc = node_records(old, recs, &n)) < 0)
+        return rc;
+    if (pos > n)
+        return -EIO;
+    memmove(recs + pos + 1, recs + pos, (n - pos) * sizeof(recs[0]));
+    recs[pos] = (wr_rec_t){rec, len};
+    n++;
+
+    memcpy(left, old, 14);
+    if (node_fill(left, recs, n)) {
+        if ((rc = node_io(t, id, left, true)) < 0)
+            return rc;
+        return pos == 0 ? fix_parent_key(t, path, level) : 0;
+    }
+
+    // Split where the two halves come out closest in size
+    size_t k = 0, best = SIZE_MAX;
+    for (size_t i = 1; i < n; i++) {
+        size_t l = records_size(recs, i), r = records_size(recs + i, n - i);
+        size_t diff = l > r ? l - r : r - l;
+        if (l <= NODE_SIZE && r <= NODE_SIZE && diff < best) {
+            best = diff;
+            k = i;
+        }
+    }
+    if (k == 0)
+        return -EIO;
+    uint32_t rid;
+    if ((rc = node_alloc(t, &rid)) < 0)
+        return rc;
+    memcpy(right, old, 14);
+    put32(right + ND_B_LINK, id);
+    put32(left + ND_F_LINK, rid);
+    node_fill(left, recs, k);
+    node_fill(right, recs + k, n - k);
+    uint32_t next = be32(old + ND_F_LINK);
+    if (next) {
+        uint8_t buf[NODE_SIZE];
+        if ((rc = node_io(t, next, buf, false)) < 0)
+            return rc;
+        put32(buf + ND_B_LINK, rid);
+        if ((rc = node_io(t, next, buf, true)) < 0)
+            return rc;
+    } else if (old[ND_KIND] == KIND_LEAF) {
+        set_hdr32(t, HR_LAST, rid);
+    }
+    if ((rc = node_io(t, id, left, true)) < 0 || (rc = node_io(t, rid, right, true)) < 0)
+        return rc;
+    if (pos == 0 && (rc = fix_parent_key(t, path, level)) < 0)
+        return rc;
+
+    uint8_t irec[64];
+    size_t ilen = index_record(t, recs[k].p, rid, irec);
+    if (level > 0)
+        return insert_at(t, path, level - 1, path->idx[level - 1] + 1, irec, ilen);
+
+    // The root split: a new root above the two halves
+    uint8_t lrec[64], root[NODE_SIZE] = {0};
+    uint32_t nid;
+    if ((rc = node_alloc(t, &nid)) < 0)
+        return rc;
+    root[ND_KIND] = KIND_INDEX;
+    root[ND_HEIGHT] = (uint8_t)(old[ND_HEIGHT] + 1);
+    wr_rec_t top[2] = {{lrec, index_record(t, recs[0].p, id, lrec)}, {irec, ilen}};
+    node_fill(root, top, 2);
+    if ((rc = node_io(t, nid, root, true)) < 0)
+        return rc;
+    set_hdr32(t, HR_ROOT, nid);
+    put16(t->hdr + HR_DEPTH, be16(t->hdr + HR_DEPTH) + 1);
+    return 0;
+}
+
+// Insert a record (key + data).  -EEXIST if its key is taken.
+static int tree_insert(wr_tree_t *t, const uint8_t *rec, size_t len) {
+    wr_path_t path;
+    bool exact;
+    int rc = tree_search(t, rec, &path, &exact);
+    if (rc < 0)
+        return rc;
+    if (exact)
+        return -EEXIST;
+    if (path.depth == 0) {
+        // Empty tree: the record becomes the only leaf
+        uint8_t node[NODE_SIZE] = {0};
+        uint32_t idx;
+        if ((rc = node_alloc(t, &idx)) < 0)
+            return rc;
+        node[ND_KIND] = KIND_LEAF;
+        node[ND_HEIGHT] = 1;
+        wr_rec_t r = {rec, len};
+        node_fill(node, &r, 1);
+        if ((rc = node_io(t, idx, node, true)) < 0)
+            return rc;
+        set_hdr32(t, HR_ROOT, idx);
+        set_hdr32(t, HR_FIRST, idx);
+        set_hdr32(t, HR_LAST, idx);
+        put16(t->hdr + HR_DEPTH, 1);
+    } else if ((rc = insert_at(t, &path, path.depth - 1, path.idx[path.depth - 1], rec, len)) < 0) {
+        return rc;
+    }
+    set_hdr32(t, HR_NRECS, hdr32(t, HR_NRECS) + 1);
+    return 0;
+}
+
+// Overwrite the data of an existing record of the same size.
+static int tree_update(wr_tree_t *t, const uint8_t *rec, size_t len) {
+    wr_path_t path;
+    bool exact;
+    int rc = tree_search(t, rec, &path, &exact);
+    if (rc < 0)
+        return rc;
+    if (!exact)
+        return -ENOENT;
+    uint8_t node[NODE_SIZE];
+    wr_rec_t recs[WR_MAX_RECS];
+    size_t n = 0;
+    uint32_t idx = path.node[path.depth - 1];
+    if ((rc = node_io(t, idx, node, false)) < 0 || (rc = node_records(node, recs, &n)) < 0)
+        return rc;
+    const wr_rec_t *r = &recs[path.idx[path.depth - 1]];
+    if (r->len != len)
+        return -EIO;
+    memcpy(node + (r->p - node), rec, len);
+    return node_io(t, idx, node, true);
+}
+
+// Remove record pos of the node at `level`; a node left empty is unlinked
+// from its siblings and released, and its pointer removed from the parent.
+static int delete_at(wr_tree_t *t, const wr_path_t *path, int level, size_t pos) {
+    uint8_t node[NODE_SIZE], out[NODE_SIZE], buf[NODE_SIZE];
+    wr_rec_t recs[WR_MAX_RECS];
+    size_t n = 0;
+    uint32_t id = path->node[level];
+    int rc = node_io(t, id, node, false);
+    if (rc < 0 || (rc = node_records(node, recs, &n)) < 0)
+        return rc;
+    if (pos >= n)
+        return -EIO;
+    memmove(recs + pos, recs + pos + 1, (n - pos - 1) * sizeof(recs[0]));
+    n--;
+    if (n > 0) {
+        memcpy(out, node, 14);
+        node_fill(out, recs, n);
+        if ((rc = node_io(t, id, out, true)) < 0)
+            return rc;
+        return pos == 0 ? fix_parent_key(t, path, level) : 0;
+    }
+
+    bool leaf = node[ND_KIND] == KIND_LEAF;
+    uint32_t prev = be32(node + ND_B_LINK), next = be32(node + ND_F_LINK);
+    if (prev) {
+        if ((rc = node_io(t, prev, buf, false)) < 0)
+            return rc;
+        put32(buf + ND_F_LINK, next);
+        if ((rc = node_io(t, prev, buf, true)) < 0)
+            return rc;
+    } else if (leaf) {
+        set_hdr32(t, HR_FIRST, next);
+    }
+    if (next) {
+        if ((rc = node_io(t, next, buf, false)) < 0)
+            return rc;
+        put32(buf + ND_B_LINK, prev);
+        if ((rc = node_io(t, next, buf, true)) < 0)
+            return rc;
+    } else if (leaf) {
+        set_hdr32(t, HR_LAST, prev);
+    }
+    if ((rc = node_release(t, id)) < 0)
+        return rc;
+    if (level > 0)
+        return delete_at(t, path, level - 1, path->idx[level - 1]);
+    // The root itself emptied: the tree is empty
+    set_hdr32(t, HR_ROOT, 0);
+    put16(t->hdr + HR_DEPTH, 0);
+    return 0;
+}
+
+// Delete the record with exactly `key`.  -ENOENT if absent.
+static int tree_delete(wr_tree_t *t, const uint8_t *key) {
+    wr_path_t path;
+    bool exact;
+    int rc = tree_search(t, key, &path, &exact);
+    if (rc < 0)
+        return rc;
+    if (!exact)
+        return -ENOENT;
+    if ((rc = delete_at(t, &path, path.depth - 1, path.idx[path.depth - 1])) < 0)
+        return rc;
+    set_hdr32(t, HR_NRECS, hdr32(t, HR_NRECS) - 1);
+
+    // Drop index roots left with a single child
+    while (be16(t->hdr + HR_DEPTH) > 1) {
+        uint8_t root[NODE_SIZE];
+        wr_rec_t recs[WR_MAX_RECS];
+        size_t n = 0;
+        uint32_t idx = hdr32(t, HR_ROOT);
+        if ((rc = node_io(t, idx, root, false)) < 0 || (rc = node_records(root, recs, &n)) < 0)
+            return rc;
+        if (n != 1)
+            break;
+        set_hdr32(t, HR_ROOT, be32(recs[0].p + key_area(recs[0].p)));
+        put16(t->hdr + HR_DEPTH, be16(t->hdr + HR_DEPTH) - 1);
+        if ((rc = node_release(t, idx)) < 0)
+            return rc;
+    }
+    return 0;
+}
+
+// ---- Volume bitmap --------------------------------------------------------
+
+// Load the volume bitmap on first use.
+static int bitmap_load(hfs_wr_t *w) {
+    if (w->bitmap)
+        return 0;
+    w->bitmap_len = ((size_t)(w->n_ab + 7) / 8 + 511) & ~(size_t)511;
+    if (!(w->bitmap = malloc(w->bitmap_len)))
+        return -ENOMEM;
+    return wr_disk(w, (uint64_t)be16(w->mdb + MDB_VBM_ST) * 512, w->bitmap, w->bitmap_len, false);
+}
+
+static bool block_used(const hfs_wr_t *w, uint32_t b) {
+    return (w->bitmap[b >> 3] & (0x80 >> (b & 7))) != 0;
+}
+
+static void mark_blocks(hfs_wr_t *w, uint32_t start, uint32_t count, bool used) {
+    for (uint32_t b = start; b < start + count; b++) {
+        if (used)
+            w->bitmap[b >> 3] |= (uint8_t)(0x80 >> (b & 7));
+        else
+            w->bitmap[b >> 3] &= (uint8_t)~(0x80 >> (b & 7));
+    }
+    uint32_t free_bks = be16(w->mdb + MDB_FREE_BKS);
+    put16(w->mdb + MDB_FREE_BKS, used ? free_bks - count : free_bks + count);
+    w->bitmap_dirty = true;
+}
+
+// Free run at or after block `from`: its start in *start, its length returned (0 at the end).
+static uint32_t next_free_run(const hfs_wr_t *w, uint32_t from, uint32_t *start) {
+    while (from < w->n_ab && block_used(w, from))
+        from++;
+    *start = from;
+    uint32_t end = from;
+    while (end < w->n_ab && !block_used(w, end))
+        end++;
+    return end - from;
+}
+
+// Allocate `need` blocks: one run when a free run is that large, else the
+// free runs from the start of the volume.  *ext is malloc'd.
+static int alloc_blocks(hfs_wr_t *w, uint32_t need, wr_extent_t **ext, size_t *n_ext) {
+    *ext = NULL;
+    *n_ext = 0;
+    if (need == 0)
+        return 0;
+    int rc = bitmap_load(w);
+    if (rc < 0)
+        return rc;
+    if (need > be16(w->mdb + MDB_FREE_BKS))
+        return -ENOSPC;
+    uint32_t start, len;
+    for (uint32_t at = 0; (len = next_free_run(w, at, &start)) != 0; at = start + len) {
+        if (len >= need) {
+            if (!(*ext = malloc(sizeof(**ext))))
+                return -ENOMEM;
+            (*ext)[0] = (wr_extent_t){start, need};
+            *n_ext = 1;
+            mark_blocks(w, start, need, true);
+            return 0;
+        }
+    }
+    size_t cap = 0;
+    for (uint32_t at = 0; need > 0 && (len = next_free_run(w, at, &start)) != 0; at = start + len) {
+        if (*n_ext == cap) {
+            cap = cap ? cap * 2 : 8;
+            wr_extent_t *grown = realloc(*ext, cap * sizeof(**ext));
+            if (!grown)
+                return -ENOMEM;
+            *ext = grown;
+        }
+        uint32_t take = len < need ? len : need;
+        (*ext)[(*n_ext)++] = (wr_extent_t){start, take};
+        mark_blocks(w, start, take, true);
+        need -= take;
+    }
+    return need ? -ENOSPC : 0;
+}
+
+// Free one extent, checking it lies inside the volume.
+static int free_blocks(hfs_wr_t *w, uint32_t start, uint32_t count) {
+    int rc = bitmap_load(w);
+    if (rc < 0)
+        return rc;
+    if ((uint64_t)start + count > w->n_ab)
+        return -EIO;
+    mark_blocks(w, start, count, false);
+    return 0;
+}
+
+// ---- Forks ----------------------------------------------------------------
+
+// Release a file's fork: its inline extents (three 4-byte start/count pairs
+// at ext) and its extents-overflow records.
+static int free_fork(hfs_wr_t *w, uint32_t cnid, uint8_t fork_type, const uint8_t *ext) {
+    int rc;
+    for (int i = 0; i < HFS_INLINE_EXTENTS; i++) {
+        if (be16(ext + i * 4 + 2) && (rc = free_blocks(w, be16(ext + i * 4), be16(ext + i * 4 + 2))) < 0)
+            return rc;
+    }
+    uint8_t key[8], rec[NODE_SIZE];
+    ext_key(key, cnid, fork_type, 0);
+    for (;;) {
+        size_t len = 0;
+        rc = tree_seek(&w->ext, key, rec, &len);
+        if (rc == -ENOENT)
+            return 0;
+        if (rc < 0)
+            return rc;
+        if (len < 8 + 12 || be32(rec + 2) != cnid || rec[1] != fork_type)
+            return 0;
+        for (int i = 0; i < HFS_INLINE_EXTENTS; i++) {
+            const uint8_t *e = rec + 8 + i * 4;
+            if (be16(e + 2) && (rc = free_blocks(w, be16(e), be16(e + 2))) < 0)
+                return rc;
+        }
+        if ((rc = tree_delete(&w->ext, rec)) < 0)
+            return rc;
+    }
+}
+
+// Copy len bytes of fork data into an extent, zero-filling its tail.
+static int write_extent(hfs_wr_t *w, const wr_extent_t *e, const uint8_t *data, uint64_t len) {
+    uint64_t at = w->ab0 + (uint64_t)e->start * w->ab_size;
+    uint64_t bytes = (uint64_t)e->count * w->ab_size;
+    uint64_t direct = (len < bytes ? len : bytes) & ~(uint64_t)511;
+    int rc = direct ? wr_disk(w, at, (uint8_t *)data, (size_t)direct, true) : 0;
+    if (rc < 0 || direct == bytes)
+        return rc;
+    uint8_t *tail = calloc(1, (size_t)(bytes - direct));
+    if (!tail)
+        return -ENOMEM;
+    if (len > direct)
+        memcpy(tail, data + direct, (size_t)((len < bytes ? len : bytes) - direct));
+    rc = wr_disk(w, at + direct, tail, (size_t)(bytes - direct), true);
+    free(tail);
+    return rc;
+}
+
+// Allocate and write a fork, filling the file record's lengths at len_off,
+// first block at st_off and inline extents at ext_off; extents past the
+// inline three go to the extents-overflow file.
+static int write_fork(hfs_wr_t *w, uint32_t cnid, uint8_t fork_type, const uint8_t *data, uint64_t len,
+                      uint8_t *file, size_t st_off, size_t len_off, size_t ext_off) {
+    uint64_t need = (len + w->ab_size - 1) / w->ab_size;
+    if (len > UINT32_MAX || need > w->n_ab)
+        return len > UINT32_MAX ? -EFBIG : -ENOSPC;
+    wr_extent_t *ext = NULL;
+    size_t n_ext = 0;
+    int rc = alloc_blocks(w, (uint32_t)need, &ext, &n_ext);
+    uint64_t done = 0;
+    uint32_t logical = 0;
+    memset(file + ext_off, 0, 12);
+    for (size_t i = 0; rc == 0 && i < n_ext; i++) {
+        uint64_t bytes = (uint64_t)ext[i].count * w->ab_size;
+        rc = write_extent(w, &ext[i], data + done, len - done < bytes ? len - done : bytes);
+        done += bytes < len - done ? bytes : len - done;
+        if (rc < 0)
+            break;
+        if (i < HFS_INLINE_EXTENTS) {
+            put16(file + ext_off + i * 4, ext[i].start);
+            put16(file + ext_off + i * 4 + 2, ext[i].count);
+        } else if ((i - HFS_INLINE_EXTENTS) % 3 == 0) {
+            // An extents-overflow record for the next three
+            uint8_t key[8], body[12] = {0}, rec[20];
+            for (size_t j = 0; j < 3 && i + j < n_ext; j++) {
+                put16(body + j * 4, ext[i + j].start);
+                put16(body + j * 4 + 2, ext[i + j].count);
+            }
+            ext_key(key, cnid, fork_type, logical);
+            rc = tree_insert(&w->ext, rec, make_record(rec, key, body, sizeof(body)));
+        }
+        logical += ext[i].count;
+    }
+    free(ext);
+    if (rc < 0)
+        return rc;
+    put16(file + st_off, n_ext ? be16(file + ext_off) : 0);
+    put32(file + len_off, (uint32_t)len);
+    put32(file + len_off + 4, (uint32_t)(need * w->ab_size));
+    return 0;
+}
+
+// ---- Session --------------------------------------------------------------
+
+// Open a tree from its MDB extent record.
+static int tree_open(hfs_wr_t *w, wr_tree_t *t, size_t ext_off, uint8_t index_key_len,
+                     int (*compare)(const uint8_t *, const uint8_t *)) {
+    memset(t, 0, sizeof(*t));
+    t->w = w;
+    t->index_key_len = index_key_len;
+    t->compare = compare;
+    uint64_t covered = 0;
+    for (int i = 0; i < HFS_INLINE_EXTENTS; i++) {
+        t->ext[i][0] = be16(w->mdb + ext_off + i * 4);
+        t->ext[i][1] = be16(w->mdb + ext_off + i * 4 + 2);
+        covered += (uint64_t)t->ext[i][1] * w->ab_size;
+    }
+    t->n_nodes = 1;
+    int rc = node_io(t, 0, t->hdr, false);
+    if (rc < 0)
+        return rc;
+    t->n_nodes = hdr32(t, HR_NNODES);
+    // Trees spilling into the extents-overflow file are not written
+    if (be16(t->hdr + HR_NODE_SIZE) != NODE_SIZE || (uint64_t)t->n_nodes * NODE_SIZE > covered ||
+        be16(t->hdr + HR_DEPTH) > WR_MAX_DEPTH)
+        return -ENOTSUP;
+    return 0;
+}
+
+// Start a write call: read the MDB and both trees' header nodes.
+static int wr_begin(hfs_volume_t *vol, hfs_wr_t *w) {
+    memset(w, 0, sizeof(*w));
+    if (!vol)
+        return -EINVAL;
+    w->vol = vol;
+    hfs_volume_span(vol, &w->img, &w->off, &w->size);
+    int rc = wr_disk(w, MDB_OFFSET, w->mdb, sizeof(w->mdb), false);
+    if (rc < 0)
+        return rc;
+    if (be16(w->mdb + MDB_SIG) != HFS_SIG_BD || be16(w->mdb + MDB_EMBED_SIG) == HFS_SIG_HP ||
+        (be16(w->mdb + MDB_ATRB) & ATRB_LOCKED))
+        return -EROFS;
+    w->ab_size = be32(w->mdb + MDB_AL_BLK_SIZ);
+    w->ab0 = (uint64_t)be16(w->mdb + MDB_AL_BL_ST) * 512;
+    w->n_ab = be16(w->mdb + MDB_NM_AL_BLKS);
+    if (w->ab_size == 0 || w->ab_size % 512 != 0)
+        return -EIO;
+    if ((rc = tree_open(w, &w->cat, MDB_CT_EXT_REC, CAT_KEY_LEN, cat_compare)) < 0)
+        return rc;
+    return tree_open(w, &w->ext, MDB_XT_EXT_REC, EXT_KEY_LEN, ext_compare);
+}
+
+// End a write call: on success write back the tree headers, the bitmap and
+// the MDB; either way release the state and re-read the volume.
+static int wr_finish(hfs_wr_t *w, int rc) {
+    if (rc == 0 && w->cat.hdr_dirty)
+        rc = node_io(&w->cat, 0, w->cat.hdr, true);
+    if (rc == 0 && w->ext.hdr_dirty)
+        rc = node_io(&w->ext, 0, w->ext.hdr, true);
+    if (rc == 0 && w->bitmap_dirty)
+        rc = wr_disk(w, (uint64_t)be16(w->mdb + MDB_VBM_ST) * 512, w->bitmap, w->bitmap_len, true);
+    if (rc == 0) {
+        put32(w->mdb + MDB_LS_MOD, mac_now());
+        put32(w->mdb + MDB_WR_CNT, be32(w->mdb + MDB_WR_CNT) + 1);
+        rc = wr_disk(w, MDB_OFFSET, w->mdb, sizeof(w->mdb), true);
+    }
+    free(w->bitmap);
+    if (w->vol) {
+        int refresh = hfs_refresh(w->vol);
+        if (rc == 0)
+            rc = refresh;
+    }
+    return rc;
+}
+
+// Add delta to a 16- or 32-bit MDB counter.
+static void mdb_count(hfs_wr_t *w, size_t off, bool wide, int delta) {
+    if (wide)
+        put32(w->mdb + off, be32(w->mdb + off) + (uint32_t)delta);
+    else
+        put16(w->mdb + off, (uint32_t)(be16(w->mdb + off) + delta));
+}
+
+// ---- Catalog operations ---------------------------------------------------
+
+// Resolve the folder holding the last component, and encode that component
+// as an on-disk name.
+static int wr_target(hfs_wr_t *w, const char *const *components, size_t nc, uint32_t *parent, uint8_t *name,
+                     size_t *len) {
+    if (nc == 0)
+        return -EINVAL;
+    hfs_dirent_t d;
+    int rc = hfs_lookup(w->vol, components, nc - 1, &d);
+    if (rc < 0)
+        return rc;
+    if (!d.is_dir)
+        return -ENOTDIR;
+    *parent = d.cnid;
+    uint8_t buf[256];
+    int n = components[nc - 1][0] ? utf8_to_macroman(components[nc - 1], buf, sizeof(buf)) : -1;
+    if (n <= 0)
+        return n == 0 || !components[nc - 1][0] ? -EINVAL : -EILSEQ;
+    if (n > 31)
+        return -ENAMETOOLONG;
+    // ':' is the HFS path separator; a '/' in a name is shown as ':'
+    for (int i = 0; i < n; i++)
+        name[i] = buf[i] == ':' ? '/' : buf[i];
+    *len = (size_t)n;
+    return 0;
+}
+
+// Find the catalog record of `name` in `parent`: the whole record in rec
+// (NODE_SIZE bytes), *data pointing at its data.
+static int cat_get(hfs_wr_t *w, uint32_t parent, const uint8_t *name, size_t len, uint8_t *rec, uint8_t **data) {
+    uint8_t key[40];
+    size_t rec_len = 0;
+    cat_key(key, parent, name, len);
+    int rc = tree_find(&w->cat, key, rec, &rec_len);
+    if (rc < 0)
+        return rc;
+    *data = rec + key_area(rec);
+    uint8_t type = (*data)[0];
+    size_t need = type == REC_FILE ? FILE_REC_SIZE : type == REC_FOLDER ? FOLDER_REC_SIZE : THREAD_REC_SIZE;
+    return key_area(rec) + need <= rec_len ? 0 : -EIO;
+}
+
+// Adjust a folder's valence and modification date, finding its record
+// through its thread.
+static int cat_adjust_folder(hfs_wr_t *w, uint32_t folder, int delta) {
+    uint8_t thread[NODE_SIZE], rec[NODE_SIZE], *t, *data;
+    int rc = cat_get(w, folder, NULL, 0, thread, &t);
+    if (rc < 0)
+        return rc == -ENOENT ? -EIO : rc;
+    if (t[0] != REC_FOLDER_THREAD || t[THREAD_NAME] > 31)
+        return -EIO;
+    if ((rc = cat_get(w, be32(t + THREAD_PAR_ID), t + THREAD_NAME + 1, t[THREAD_NAME], rec, &data)) < 0)
+        return rc == -ENOENT ? -EIO : rc;
+    if (data[0] != REC_FOLDER)
+        return -EIO;
+    put16(data + FOLDER_VALENCE, (uint32_t)(be16(data + FOLDER_VALENCE) + delta));
+    put32(data + FOLDER_MD_DAT, mac_now());
+    return tree_update(&w->cat, rec, (size_t)(data - rec) + FOLDER_REC_SIZE);
+}
+
+// Insert a new file or folder record plus the folder's thread, and count it.
+static int cat_create(hfs_wr_t *w, uint32_t parent, const uint8_t *name, size_t len, const uint8_t *data,
+                      size_t data_len) {
+    uint8_t key[40], rec[NODE_SIZE];
+    cat_key(key, parent, name, len);
+    int rc = tree_insert(&w->cat, rec, make_record(rec, key, data, data_len));
+    if (rc < 0)
+        return rc;
+    bool folder = data[0] == REC_FOLDER;
+    if (folder) {
+        uint8_t thread[THREAD_REC_SIZE] = {REC_FOLDER_THREAD};
+        put32(thread + THREAD_PAR_ID, parent);
+        thread[THREAD_NAME] = (uint8_t)len;
+        memcpy(thread + THREAD_NAME + 1, name, len);
+        cat_key(key, be32(data + FOLDER_ID), NULL, 0);
+        if ((rc = tree_insert(&w->cat, rec, make_record(rec, key, thread, sizeof(thread)))) < 0)
+            return rc;
+    }
+    if ((rc = cat_adjust_folder(w, parent, 1)) < 0)
+        return rc;
+    mdb_count(w, folder ? MDB_DIR_CNT : MDB_FIL_CNT, true, 1);
+    if (parent == HFS_ROOT_CNID)
+        mdb_count(w, folder ? MDB_NM_RT_DIRS : MDB_NM_FLS, false, 1);
+    return 0;
+}
+
+// Take the next catalog node ID.
+static uint32_t next_cnid(hfs_wr_t *w) {
+    uint32_t id = be32(w->mdb + MDB_NXT_CNID);
+    put32(w->mdb + MDB_NXT_CNID, id + 1);
+    return id;
+}
+
+// ---- Public API -----------------------------------------------------------
+
+bool hfs_writable(const hfs_volume_t *vol) {
+    hfs_wr_t w;
+    int rc = wr_begin((hfs_volume_t *)vol, &w);
+    free(w.bitmap);
+    return rc == 0;
+}
+
+int hfs_mkdir(hfs_volume_t *vol, const char *const *components, size_t nc) {
+    hfs_wr_t w;
+    int rc = wr_begin(vol, &w);
+    if (rc < 0)
+        return rc;
+    uint32_t parent;
+    uint8_t name[32], rec[NODE_SIZE], *data;
+    size_t len;
+    if ((rc = wr_target(&w, components, nc, &parent, name, &len)) == 0) {
+        rc = cat_get(&w, parent, name, len, rec, &data);
+        rc = rc == 0 ? -EEXIST : rc == -ENOENT ? 0 : rc;
+    }
+    if (rc == 0) {
+        uint8_t folder[FOLDER_REC_SIZE] = {REC_FOLDER};
+        uint32_t now = mac_now();
+        put32(folder + FOLDER_ID, next_cnid(&w));
+        put32(folder + FOLDER_CR_DAT, now);
+        put32(folder + FOLDER_MD_DAT, now);
+        rc = cat_create(&w, parent, name, len, folder, sizeof(folder));
+    }
+    return wr_finish(&w, rc);
+}
+
+int hfs_put_file(hfs_volume_t *vol, const char *const *components, size_t nc, const hfs_put_t *put) {
+    if (!put || (put->data_len && !put->data) || (put->rsrc_len && !put->rsrc))
+        return -EINVAL;
+    hfs_wr_t w;
+    int rc = wr_begin(vol, &w);
+    if (rc < 0)
+        return rc;
+    uint32_t parent;
+    uint8_t name[32], rec[NODE_SIZE], *data = NULL;
+    size_t len;
+    bool exists = false;
+    if ((rc = wr_target(&w, components, nc, &parent, name, &len)) == 0) {
+        rc = cat_get(&w, parent, name, len, rec, &data);
+        exists = rc == 0;
+        if (rc == -ENOENT)
+            rc = 0;
+        else if (rc == 0 && data[0] != REC_FILE)
+            rc = -EISDIR;
+    }
+    uint8_t file[FILE_REC_SIZE] = {REC_FILE};
+    uint32_t cnid = 0;
+    if (rc == 0 && exists) {
+        // Replace the forks of the existing file, keeping its ID and dates
+        memcpy(file, data, sizeof(file));
+        cnid = be32(file + FILE_ID);
+        rc = free_fork(&w, cnid, 0x00, file + FILE_EXT);
+        if (rc == 0)
+            rc = free_fork(&w, cnid, 0xFF, file + FILE_R_EXT);
+    } else if (rc == 0) {
+        cnid = next_cnid(&w);
+        put32(file + FILE_ID, cnid);
+        put32(file + FILE_CR_DAT, mac_now());
+    }
+    if (rc == 0) {
+        put32(file + FILE_MD_DAT, mac_now());
+        if (put->finder_info) {
+            memcpy(file + FILE_FINFO, put->finder_info, 16);
+            memcpy(file + FILE_FXINFO, put->finder_info + 16, 16);
+        }
+        rc = write_fork(&w, cnid, 0x00, put->data, put->data_len, file, FILE_ST_BLK, FILE_LG_LEN, FILE_EXT);
+    }
+    if (rc == 0)
+        rc = write_fork(&w, cnid, 0xFF, put->rsrc, put->rsrc_len, file, FILE_R_ST_BLK, FILE_R_LG_LEN, FILE_R_EXT);
+    if (rc == 0 && exists) {
+        memcpy(data, file, sizeof(file));
+        rc = tree_update(&w.cat, rec, (size_t)(data - rec) + FILE_REC_SIZE);
+    } else if (rc == 0) {
+        rc = cat_create(&w, parent, name, len, file, sizeof(file));
+    }
+    return wr_finish(&w, rc);
+}
+
+int hfs_set_finder_info(hfs_volume_t *vol, const char *const *components, size_t nc, const uint8_t finder_info[32]) {
+    if (!finder_info)
+        return -EINVAL;
+    hfs_wr_t w;
+    int rc = wr_begin(vol, &w);
+    if (rc < 0)
+        return rc;
+    uint32_t parent;
+    uint8_t name[32], rec[NODE_SIZE], *data;
+    size_t len;
+    if ((rc = wr_target(&w, components, nc, &parent, name, &len)) == 0 &&
+        (rc = cat_get(&w, parent, name, len, rec, &data)) == 0) {
+        if (data[0] == REC_FILE) {
+            memcpy(data + FILE_FINFO, finder_info, 16);
+            memcpy(data + FILE_FXINFO, finder_info + 16, 16);
+            rc = tree_update(&w.cat, rec, (size_t)(data - rec) + FILE_REC_SIZE);
+        } else {
+            memcpy(data + FOLDER_USR, finder_info, 32);
+            rc = tree_update(&w.cat, rec, (size_t)(data - rec) + FOLDER_REC_SIZE);
+        }
+    }
+    return wr_finish(&w, rc);
+}
+
+int hfs_remove(hfs_volume_t *vol, const char *const *components, size_t nc) {
+    hfs_wr_t w;
+    int rc = wr_begin(vol, &w);
+    if (rc < 0)
+        return rc;
+    uint32_t parent;
+    uint8_t name[32], rec[NODE_SIZE], key[40], *data;
+    size_t len;
+    bool folder = false;
+    if ((rc = wr_target(&w, components, nc, &parent, name, &len)) == 0 &&
+        (rc = cat_get(&w, parent, name, len, rec, &data)) == 0) {
+        folder = data[0] == REC_FOLDER;
+        if (folder && be16(data + FOLDER_VALENCE) != 0) {
+            rc = -ENOTEMPTY;
+        } else if (folder) {
+            cat_key(key, be32(data + FOLDER_ID), NULL, 0);
+            rc = tree_delete(&w.cat, key);
+        } else {
+            uint32_t cnid = be32(data + FILE_ID);
+            rc = free_fork(&w, cnid, 0x00, data + FILE_EXT);
+            if (rc == 0)
+                rc = free_fork(&w, cnid, 0xFF, data + FILE_R_EXT);
+            // A file thread is optional
+            cat_key(key, cnid, NULL, 0);
+            if (rc == 0 && (rc = tree_delete(&w.cat, key)) == -ENOENT)
+                rc = 0;
+        }
+    }
+    if (rc == 0)
+        rc = tree_delete(&w.cat, rec);
+    if (rc == 0)
+        rc = cat_adjust_folder(&w, parent, -1);
+    if (rc == 0) {
+        mdb_count(&w, folder ? MDB_DIR_CNT : MDB_FIL_CNT, true, -1);
+        if (parent == HFS_ROOT_CNID)
+            mdb_count(&w, folder ? MDB_NM_RT_DIRS : MDB_NM_FLS, false, -1);
+    }
+    return wr_finish(&w, rc);
+}
@@ -10,8 +10,10 @@
 #include "resource_fork.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define NDIF_SECTOR_SIZE 512u
 // 'bcem' resource, ID 128 (Aaru: NDIF_RESOURCE / NDIF_RESOURCEID).
@@ -188,3 +190,194 @@ int ndif_decode_chunk(const ndif_chunk_t *chunk, const uint8_t *src, size_t src_
         return -EINVAL; // KenCode / RLE / LZH / StuffIt not implemented
     }
 }
+
+// === Random-access reader ===================================================
+
+// One decoded ADC chunk held by the reader
+typedef struct {
+    size_t chunk; // index into map->chunks (SIZE_MAX = empty)
+    uint64_t stamp; // last use, for LRU eviction
+    uint8_t *data;
+    size_t cap;
+} ndif_cached_chunk_t;
+
+struct ndif_reader {
+    int fd; // data fork
+    ndif_map_t *map;
+    uint8_t *src; // compressed bytes of the chunk being decoded
+    size_t src_cap;
+    uint64_t clock;
+    uint64_t decodes;
+    ndif_cached_chunk_t cache[NDIF_READER_CACHE_CHUNKS];
+};
+
+int ndif_reader_open(const char *data_path, ndif_map_t *map, ndif_reader_t **out) {
+    if (!data_path || !map || !out) {
+        ndif_map_free(map);
+        return -EINVAL;
+    }
+    *out = NULL;
+    for (size_t i = 0; i < map->n_chunks; i++) {
+        const ndif_chunk_t *c = &map->chunks[i];
+        if (c->count == 0 || c->type == NDIF_CHUNK_ZERO)
+            continue;
+        bool supported = c->type == NDIF_CHUNK_COPY || c->type == NDIF_CHUNK_ADC;
+        if (!supported || (uint64_t)c->count * NDIF_SECTOR_SIZE > NDIF_READER_MAX_CHUNK ||
+            c->length > NDIF_READER_MAX_CHUNK) {
+            ndif_map_free(map);
+            return -EINVAL;
+        }
+    }
+    ndif_reader_t *r = calloc(1, sizeof(*r));
+    if (!r) {
+        ndif_map_free(map);
+        return -ENOMEM;
+    }
+    r->map = map;
+    for (size_t i = 0; i < NDIF_READER_CACHE_CHUNKS; i++)
+        r->cache[i].chunk = SIZE_MAX;
+    r->fd = open(data_path, O_RDONLY);
+    if (r->fd < 0) {
+        int e = errno;
+        ndif_reader_close(r);
+        return e ? -e : -EIO;
+    }
+    *out = r;
+    return 0;
+}
+
+uint64_t ndif_reader_size(const ndif_reader_t *r) {
+    return r ? (uint64_t)r->map->sectors * NDIF_SECTOR_SIZE : 0;
+}
+
+uint64_t ndif_reader_decodes(const ndif_reader_t *r) {
+    return r ? r->decodes : 0;
+}
+
+void ndif_reader_close(ndif_reader_t *r) {
+    if (!r)
+        return;
+    if (r->fd >= 0)
+        close(r->fd);
+    for (size_t i = 0; i < NDIF_READER_CACHE_CHUNKS; i++)
+        free(r->cache[i].data);
+    free(r->src);
+    ndif_map_free(r->map);
+    free(r);
+}
+
+// Read exactly len bytes at offset of the data fork
+static int read_fork(int fd, void *buf, size_t len, uint64_t offset) {
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        ssize_t got = pread(fd, p, len, (off_t)offset);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return got < 0 ? -errno : -EIO;
+        p += got;
+        len -= (size_t)got;
+        offset += (uint64_t)got;
+    }
+    return 0;
+}
+
+// Index of the chunk holding sector, or of the first chunk after it
+// (n_chunks if none); chunks are in ascending sector order
+static size_t find_chunk(const ndif_map_t *m, uint32_t sector) {
+    size_t lo = 0, hi = m->n_chunks;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const ndif_chunk_t *c = &m->chunks[mid];
+        if ((uint64_t)c->sector + c->count <= sector)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Decoded contents of ADC chunk i, from the cache or decompressed into it
+static const uint8_t *decoded_chunk(ndif_reader_t *r, size_t i) {
+    ndif_cached_chunk_t *slot = &r->cache[0];
+    for (size_t k = 0; k < NDIF_READER_CACHE_CHUNKS; k++) {
+        if (r->cache[k].chunk == i) {
+            r->cache[k].stamp = ++r->clock;
+            return r->cache[k].data;
+        }
+        if (r->cache[k].stamp < slot->stamp)
+            slot = &r->cache[k];
+    }
+
+    const ndif_chunk_t *c = &r->map->chunks[i];
+    size_t need = (size_t)c->count * NDIF_SECTOR_SIZE;
+    slot->chunk = SIZE_MAX;
+    if (slot->cap < need) {
+        uint8_t *grown = realloc(slot->data, need);
+        if (!grown)
+            return NULL;
+        slot->data = grown;
+        slot->cap = need;
+    }
+    if (r->src_cap < c->length) {
+        uint8_t *grown = realloc(r->src, c->length);
+        if (!grown)
+            return NULL;
+        r->src = grown;
+        r->src_cap = c->length;
+    }
+    if (read_fork(r->fd, r->src, c->length, c->offset) != 0 ||
+        ndif_decode_chunk(c, r->src, c->length, slot->data, need) != 0)
+        return NULL;
+    r->decodes++;
+    slot->chunk = i;
+    slot->stamp = ++r->clock;
+    return slot->data;
+}
+
+int ndif_reader_read(ndif_reader_t *r, uint64_t offset, void *buf, size_t len) {
+    if (!r || (!buf && len))
+        return -EINVAL;
+    uint8_t *out = (uint8_t *)buf;
+    uint64_t size = ndif_reader_size(r);
+    while (len > 0) {
+        if (offset >= size) {
+            memset(out, 0, len);
+            return 0;
+        }
+        uint32_t sector = (uint32_t)(offset / NDIF_SECTOR_SIZE);
+        size_t i = find_chunk(r->map, sector);
+        const ndif_chunk_t *c = i < r->map->n_chunks ? &r->map->chunks[i] : NULL;
+        uint64_t start = c ? (uint64_t)c->sector * NDIF_SECTOR_SIZE : size;
+        if (start > offset) {
+            // A gap before the next chunk (or the end) reads as zeros
+            size_t n = start - offset < len ? (size_t)(start - offset) : len;
+            memset(out, 0, n);
+            out += n;
+            offset += n;
+            len -= n;
+            continue;
+        }
+        uint64_t within = offset - start;
+        uint64_t avail = (uint64_t)c->count * NDIF_SECTOR_SIZE - within;
+        size_t n = avail < len ? (size_t)avail : len;
+        if (c->type == NDIF_CHUNK_ZERO) {
+            memset(out, 0, n);
+        } else if (c->type == NDIF_CHUNK_COPY) {
+            if (within + n > c->length)
+                return -EINVAL;
+            int rc = read_fork(r->fd, out, n, (uint64_t)c->offset + within);
+            if (rc != 0)
+                return rc;
+        } else {
+            const uint8_t *data = decoded_chunk(r, i);
+            if (!data)
+                return -EIO;
+            memcpy(out, data + within, n);
+        }
+        out += n;
+        offset += n;
+        len -= n;
+    }
+    return 0;
+}
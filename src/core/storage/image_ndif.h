@@ -68,4 +68,35 @@ void ndif_map_free(ndif_map_t *m);
 // error.  Returns 0 on success.
 int ndif_decode_chunk(const ndif_chunk_t *chunk, const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len);
 
+// === Random-access reader ===================================================
+//
+// Reads the decoded image straight from an NDIF data fork, without decoding
+// it up front: a read decodes only the chunks it touches.  Zero chunks are
+// filled in and raw chunks read in place; ADC chunks are decompressed into a
+// small LRU cache of decoded chunks (NDIF_READER_CACHE_CHUNKS).
+
+#define NDIF_READER_CACHE_CHUNKS 8
+// Largest decoded ADC chunk accepted (Disk Copy 6 writes at most a few hundred sectors).
+#define NDIF_READER_MAX_CHUNK (16u * 1024u * 1024u)
+
+typedef struct ndif_reader ndif_reader_t;
+
+// Open the data fork at `data_path` for reading through `map`, which the
+// reader takes over (freed by ndif_reader_close, and on failure).  Fails with
+// -EINVAL when a chunk uses an unsupported encoding or is oversized.  Returns
+// 0 and sets *out, or a negative errno.
+int ndif_reader_open(const char *data_path, ndif_map_t *map, ndif_reader_t **out);
+
+// Size of the decoded image in bytes.
+uint64_t ndif_reader_size(const ndif_reader_t *r);
+
+// Read `len` bytes at byte `offset` of the decoded image.  Sectors no chunk
+// covers, and anything past the end, read as zeros.  0 or a negative errno.
+int ndif_reader_read(ndif_reader_t *r, uint64_t offset, void *buf, size_t len);
+
+// Number of ADC chunk decodes so far (cache misses).
+uint64_t ndif_reader_decodes(const ndif_reader_t *r);
+
+void ndif_reader_close(ndif_reader_t *r);
+
 #endif // GS_IMAGE_NDIF_H
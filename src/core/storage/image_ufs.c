@@ -9,6 +9,12 @@
 // persistent snapshot of the filesystem is loaded at open time — A/UX
 // volumes can reach 35 000+ inodes, but `cp -r` touches each one at most
 // once, so per-inode disk reads are the right granularity.
+//
+// What a recursive copy does touch repeatedly stays in bounded per-volume
+// caches: dinodes (a miss reads the whole sector, so the neighbours a
+// readdir asks for next come along), parsed directories with a name hash
+// for lookups, and the logical-to-fragment block map of recently read
+// files, so a sequential read doesn't walk the indirect blocks per call.
 
 #include "image_ufs.h"
 #include "image.h"
@@ -22,6 +28,8 @@
 
 // ---- Disk-read helper (byte-granular over 512-aligned blocks) ------------
 
+// Whole blocks go to disk_read_data in one call; only a partial first or
+// last block is bounced.
 static int disk_read_bytes(image_t *img, uint64_t off, void *buf, size_t n) {
     uint8_t *dst = buf;
     size_t done = 0;
@@ -34,7 +42,8 @@ static int disk_read_bytes(image_t *img, uint64_t off, void *buf, size_t n) {
         if (take > n - done)
             take = n - done;
         if (in_block == 0 && take == STORAGE_BLOCK_SIZE) {
-            if (disk_read_data(img, (size_t)block_off, dst + done, STORAGE_BLOCK_SIZE) != STORAGE_BLOCK_SIZE)
+            take = (n - done) & ~(size_t)(STORAGE_BLOCK_SIZE - 1);
+            if (disk_read_data(img, (size_t)block_off, dst + done, take) != take)
                 return -EIO;
         } else {
             if (disk_read_data(img, (size_t)block_off, blk, STORAGE_BLOCK_SIZE) != STORAGE_BLOCK_SIZE)
@@ -108,6 +117,38 @@ static uint32_t be32(const uint8_t *p) {
 #define UFS_IFIFO  0x1000
 #define UFS_IFSOCK 0xC000
 
+// ---- Caches --------------------------------------------------------------
+
+#define UFS_INODE_CACHE     1024 // dinodes, direct-mapped by inode number (128 KB)
+#define UFS_DIR_CACHE       64 // parsed directories, LRU ...
+#define UFS_DIR_CACHE_BYTES (4u * 1024 * 1024) // ... holding at most this much directory data
+#define UFS_BMAP_CACHE      16 // file block maps, LRU
+#define UFS_BMAP_MAX_BLOCKS (64u * 1024) // larger files resolve through their indirect blocks per read
+
+// Dinodes sharing one 512-byte sector, all loaded by a miss.
+#define INODES_PER_SECTOR (STORAGE_BLOCK_SIZE / DI_SIZE)
+
+typedef struct inode_slot {
+    uint32_t ino; // 0 = empty
+    uint8_t di[DI_SIZE];
+} inode_slot_t;
+
+typedef struct dir_slot {
+    uint32_t ino; // 0 = empty
+    uint64_t stamp; // LRU clock at last use
+    uint8_t *buf; // directory contents (NULL when empty)
+    uint64_t size;
+    uint32_t *hash; // open-addressed by name: entry offset + 1, 0 = empty bucket
+    uint32_t mask;
+} dir_slot_t;
+
+typedef struct bmap_slot {
+    uint32_t ino; // 0 = empty
+    uint64_t stamp;
+    uint32_t n_blocks;
+    uint32_t *frag; // fragment address of each logical block, 0 = hole
+} bmap_slot_t;
+
 // ---- Volume state --------------------------------------------------------
 
 struct ufs_volume {
@@ -127,6 +168,13 @@ struct ufs_volume {
     uint32_t nindir; // block pointers per indirect block
     uint32_t inopb; // inodes per fs block (bsize / DI_SIZE)
     uint32_t fsbtodb; // shift: frags to 512-byte sectors
+
+    uint64_t clock; // LRU clock of the directory and block-map caches
+    inode_slot_t inodes[UFS_INODE_CACHE];
+    dir_slot_t dirs[UFS_DIR_CACHE];
+    size_t dir_bytes; // directory data held by dirs
+    bmap_slot_t bmaps[UFS_BMAP_CACHE];
+    ufs_cache_stats_t stats;
 };
 
 struct ufs_dir_iter {
@@ -164,14 +212,41 @@ static uint64_t inode_byte_offset(const ufs_volume_t *vol, uint32_t ino) {
     return frag * (uint64_t)vol->fsize + (uint64_t)within * DI_SIZE;
 }
 
-// Load one dinode into `di[DI_SIZE]`.
+// Load one dinode into `di[DI_SIZE]`, through the inode cache.
 static int load_dinode(ufs_volume_t *vol, uint32_t ino, uint8_t *di) {
     // Compute the limit in 64-bit to dodge `ncg * ipg` int32 overflow on a
     // hostile / corrupted superblock that survived `ufs_open`'s sanity check.
     uint64_t inode_limit = (uint64_t)vol->ncg * (uint64_t)vol->ipg;
     if (ino < UFS_ROOT_INO || (uint64_t)ino >= inode_limit)
         return -ENOENT;
-    return read_partition(vol, inode_byte_offset(vol, ino), di, DI_SIZE);
+    inode_slot_t *slot = &vol->inodes[ino % UFS_INODE_CACHE];
+    if (slot->ino == ino) {
+        vol->stats.inode_hits++;
+        memcpy(di, slot->di, DI_SIZE);
+        return 0;
+    }
+    vol->stats.inode_misses++;
+
+    // Read the dinode's whole sector (never past the end of its group's
+    // inode table) and cache every valid inode in it.
+    uint32_t within = ino % vol->ipg;
+    uint32_t first = ino - within % INODES_PER_SECTOR;
+    uint32_t count = INODES_PER_SECTOR;
+    if (within - within % INODES_PER_SECTOR + count > vol->ipg)
+        count = vol->ipg - (within - within % INODES_PER_SECTOR);
+    uint8_t sector[STORAGE_BLOCK_SIZE];
+    int rc = read_partition(vol, inode_byte_offset(vol, first), sector, (size_t)count * DI_SIZE);
+    if (rc < 0)
+        return rc;
+    for (uint32_t k = 0; k < count; k++) {
+        if (first + k < UFS_ROOT_INO)
+            continue;
+        inode_slot_t *s = &vol->inodes[(first + k) % UFS_INODE_CACHE];
+        s->ino = first + k;
+        memcpy(s->di, sector + (size_t)k * DI_SIZE, DI_SIZE);
+    }
+    memcpy(di, sector + (size_t)(ino - first) * DI_SIZE, DI_SIZE);
+    return 0;
 }
 
 // ---- Block address resolution -------------------------------------------
@@ -261,10 +336,34 @@ static int resolve_block(ufs_volume_t *vol, const uint8_t *di, uint64_t off, siz
     return 1;
 }
 
+// Like resolve_block, from a file's block map: the mapped length runs on
+// across the following blocks while they are contiguous on disk.
+static int resolve_mapped(const ufs_volume_t *vol, const bmap_slot_t *map, uint64_t off, size_t want_len,
+                          uint64_t *out_phys, size_t *out_len) {
+    uint32_t lbn = (uint32_t)(off / vol->bsize);
+    uint32_t in_blk = (uint32_t)(off % vol->bsize);
+    uint32_t frag_addr = lbn < map->n_blocks ? map->frag[lbn] : 0;
+    size_t len = vol->bsize - in_blk;
+    *out_phys = (uint64_t)frag_addr * vol->fsize + in_blk;
+    if (frag_addr == 0) {
+        *out_len = len;
+        return 0;
+    }
+    for (uint32_t k = 1; len < want_len && lbn + k < map->n_blocks; k++) {
+        if (map->frag[lbn + k] != frag_addr + k * vol->frag)
+            break;
+        len += vol->bsize;
+    }
+    *out_len = len;
+    return 1;
+}
+
 // Read `n` bytes from file with dinode `di` at logical offset `off` into
-// `buf`.  Handles holes (zero-fill) and clamps against di_size.  Returns
-// the number of bytes actually filled.
-static int read_file_by_dinode(ufs_volume_t *vol, const uint8_t *di, uint64_t off, void *buf, size_t n, size_t *nread) {
+// `buf`, mapping blocks through `map` when given (see get_bmap).  Handles
+// holes (zero-fill) and clamps against di_size.  Returns the number of
+// bytes actually filled.
+static int read_file_by_dinode(ufs_volume_t *vol, const uint8_t *di, const bmap_slot_t *map, uint64_t off, void *buf,
+                               size_t n, size_t *nread) {
     uint32_t size = be32(di + DI_OFF_SIZE);
     if (nread)
         *nread = 0;
@@ -279,7 +378,8 @@ static int read_file_by_dinode(ufs_volume_t *vol, const uint8_t *di, uint64_t of
     while (done < n) {
         uint64_t phys = 0;
         size_t seg = 0;
-        int rc = resolve_block(vol, di, off + done, n - done, &phys, &seg);
+        int rc = map ? resolve_mapped(vol, map, off + done, n - done, &phys, &seg)
+                     : resolve_block(vol, di, off + done, n - done, &phys, &seg);
         if (rc < 0)
             return rc;
         size_t take = seg < (n - done) ? seg : (n - done);
@@ -297,6 +397,97 @@ static int read_file_by_dinode(ufs_volume_t *vol, const uint8_t *di, uint64_t of
     return 0;
 }
 
+// ---- Block-map cache -----------------------------------------------------
+
+// Copy `count` block pointers from the indirect block at fragment
+// `frag_addr` into `dst` (a zero pointer maps a hole).  `tmp` holds nindir
+// pointers.  0 / -errno.
+static int read_indirect(ufs_volume_t *vol, uint32_t frag_addr, uint8_t *tmp, uint32_t *dst, uint32_t count) {
+    if (frag_addr == 0)
+        return 0;
+    int rc = read_partition(vol, (uint64_t)frag_addr * vol->fsize, tmp, (size_t)vol->nindir * 4);
+    if (rc < 0)
+        return rc;
+    for (uint32_t i = 0; i < count; i++)
+        dst[i] = be32(tmp + (size_t)i * 4);
+    return 0;
+}
+
+// Build the fragment address of every logical block of the file with
+// dinode `di`: its direct pointers plus its single- and double-indirect
+// blocks, each read whole.  Returns a calloc'd array of *out_n entries, or
+// NULL on error.
+static uint32_t *build_bmap(ufs_volume_t *vol, const uint8_t *di, uint32_t n) {
+    uint32_t *frag = calloc(n ? n : 1, sizeof(uint32_t));
+    uint8_t *tmp = malloc((size_t)vol->nindir * 4);
+    if (!frag || !tmp) {
+        free(frag);
+        free(tmp);
+        return NULL;
+    }
+    uint32_t nindir = vol->nindir;
+    for (uint32_t lbn = 0; lbn < n && lbn < UFS_NDADDR; lbn++)
+        frag[lbn] = be32(di + DI_OFF_DB + lbn * 4);
+    int rc = 0;
+    if (n > UFS_NDADDR) {
+        uint32_t count = n - UFS_NDADDR < nindir ? n - UFS_NDADDR : nindir;
+        rc = read_indirect(vol, be32(di + DI_OFF_IB), tmp, frag + UFS_NDADDR, count);
+    }
+    if (rc == 0 && n > UFS_NDADDR + nindir) {
+        // Double indirect: the level-1 block names a level-2 block per
+        // nindir data blocks.
+        uint32_t rest = n - UFS_NDADDR - nindir;
+        uint32_t n_l2 = (rest + nindir - 1) / nindir;
+        uint32_t *l1 = calloc(n_l2, sizeof(uint32_t));
+        if (!l1)
+            rc = -ENOMEM;
+        else
+            rc = read_indirect(vol, be32(di + DI_OFF_IB + 4), tmp, l1, n_l2 < nindir ? n_l2 : nindir);
+        for (uint32_t hi = 0; rc == 0 && hi < n_l2 && hi < nindir; hi++) {
+            uint32_t count = rest - hi * nindir < nindir ? rest - hi * nindir : nindir;
+            rc = read_indirect(vol, l1[hi], tmp, frag + UFS_NDADDR + nindir + hi * nindir, count);
+        }
+        free(l1);
+        // Blocks past double indirect (triple indirect) stay holes, as in resolve_block.
+    }
+    free(tmp);
+    if (rc < 0) {
+        free(frag);
+        return NULL;
+    }
+    return frag;
+}
+
+// The block map of file `ino` (dinode `di`) through the block-map cache, or
+// NULL when the file is too large to map or the map can't be read; reads
+// then walk the indirect blocks themselves.
+static const bmap_slot_t *get_bmap(ufs_volume_t *vol, uint32_t ino, const uint8_t *di) {
+    bmap_slot_t *slot = &vol->bmaps[0];
+    for (int i = 0; i < UFS_BMAP_CACHE; i++) {
+        bmap_slot_t *b = &vol->bmaps[i];
+        if (b->ino == ino) {
+            vol->stats.bmap_hits++;
+            b->stamp = ++vol->clock;
+            return b;
+        }
+        if (b->stamp < slot->stamp)
+            slot = b;
+    }
+    uint64_t n = ((uint64_t)be32(di + DI_OFF_SIZE) + vol->bsize - 1) / vol->bsize;
+    if (n > UFS_BMAP_MAX_BLOCKS)
+        return NULL;
+    vol->stats.bmap_misses++;
+    uint32_t *frag = build_bmap(vol, di, (uint32_t)n);
+    if (!frag)
+        return NULL;
+    free(slot->frag);
+    slot->ino = ino;
+    slot->stamp = ++vol->clock;
+    slot->n_blocks = (uint32_t)n;
+    slot->frag = frag;
+    return slot;
+}
+
 // ---- Superblock probe + open --------------------------------------------
 
 bool ufs_probe(image_t *img, uint64_t partition_byte_offset, uint64_t partition_byte_size) {
@@ -356,10 +547,23 @@ ufs_volume_t *ufs_open(image_t *img, uint64_t partition_byte_offset, uint64_t pa
     return vol;
 }
 
+static void dir_slot_clear(ufs_volume_t *vol, dir_slot_t *d);
+
 void ufs_close(ufs_volume_t *vol) {
+    if (!vol)
+        return;
+    for (int i = 0; i < UFS_DIR_CACHE; i++)
+        dir_slot_clear(vol, &vol->dirs[i]);
+    for (int i = 0; i < UFS_BMAP_CACHE; i++)
+        free(vol->bmaps[i].frag);
     free(vol);
 }
 
+void ufs_cache_stats(const ufs_volume_t *vol, ufs_cache_stats_t *out) {
+    if (out)
+        *out = vol ? vol->stats : (ufs_cache_stats_t){0};
+}
+
 // ---- Directory walking ---------------------------------------------------
 
 // Load the full contents of directory inode `ino` into memory.  Returns a
@@ -386,7 +590,7 @@ static int load_directory(ufs_volume_t *vol, uint32_t ino, uint8_t **out_buf, ui
     if (!buf)
         return -ENOMEM;
     size_t got = 0;
-    rc = read_file_by_dinode(vol, di, 0, buf, size, &got);
+    rc = read_file_by_dinode(vol, di, NULL, 0, buf, size, &got);
     if (rc < 0 || got != size) {
         free(buf);
         return rc < 0 ? rc : -EIO;
@@ -414,6 +618,113 @@ static int parse_direct(const uint8_t *buf, uint64_t bufsize, uint64_t off, uint
     return reclen;
 }
 
+// ---- Directory cache -----------------------------------------------------
+
+// FNV-1a over a directory entry name.
+static uint32_t name_hash(const char *name, size_t len) {
+    uint32_t h = 0x811c9dc5u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (uint8_t)name[i]) * 0x01000193u;
+    return h;
+}
+
+// Empty a directory slot.
+static void dir_slot_clear(ufs_volume_t *vol, dir_slot_t *d) {
+    vol->dir_bytes -= (size_t)d->size;
+    free(d->buf);
+    free(d->hash);
+    memset(d, 0, sizeof(*d));
+}
+
+// Hash every live entry of a loaded directory by name.  Entries go in in
+// directory order, so a duplicate name resolves to its first entry, as a
+// linear scan would.  0 / -ENOMEM.
+static int index_directory(dir_slot_t *d) {
+    size_t entries = 0;
+    uint32_t d_ino = 0;
+    uint16_t d_namlen = 0;
+    const char *name = NULL;
+    for (uint64_t off = 0; off < d->size;) {
+        int reclen = parse_direct(d->buf, d->size, off, &d_ino, &d_namlen, &name);
+        if (reclen <= 0)
+            break;
+        entries += (d_ino != 0);
+        off += (uint64_t)reclen;
+    }
+    size_t buckets = 8;
+    while (buckets < entries * 2)
+        buckets <<= 1;
+    d->hash = calloc(buckets, sizeof(uint32_t));
+    if (!d->hash)
+        return -ENOMEM;
+    d->mask = (uint32_t)(buckets - 1);
+    for (uint64_t off = 0; off < d->size;) {
+        int reclen = parse_direct(d->buf, d->size, off, &d_ino, &d_namlen, &name);
+        if (reclen <= 0)
+            break;
+        if (d_ino != 0) {
+            uint32_t i = name_hash(name, d_namlen) & d->mask;
+            while (d->hash[i])
+                i = (i + 1) & d->mask;
+            d->hash[i] = (uint32_t)off + 1;
+        }
+        off += (uint64_t)reclen;
+    }
+    return 0;
+}
+
+// Directory inode `ino` through the directory cache.  *out stays valid
+// until the next call.  0 / -errno (-ENOTDIR for a non-directory).
+static int get_directory(ufs_volume_t *vol, uint32_t ino, dir_slot_t **out) {
+    dir_slot_t *slot = NULL;
+    for (int i = 0; i < UFS_DIR_CACHE; i++) {
+        dir_slot_t *d = &vol->dirs[i];
+        if (d->ino == ino) {
+            vol->stats.dir_hits++;
+            d->stamp = ++vol->clock;
+            *out = d;
+            return 0;
+        }
+    }
+    vol->stats.dir_misses++;
+    uint8_t *buf = NULL;
+    uint64_t size = 0;
+    int rc = load_directory(vol, ino, &buf, &size);
+    if (rc < 0)
+        return rc;
+
+    // Evict least recently used directories until this one fits the byte
+    // budget and a slot is free.
+    for (;;) {
+        dir_slot_t *lru = NULL;
+        slot = NULL;
+        for (int i = 0; i < UFS_DIR_CACHE; i++) {
+            dir_slot_t *d = &vol->dirs[i];
+            if (d->ino == 0)
+                slot = slot ? slot : d;
+            else if (!lru || d->stamp < lru->stamp)
+                lru = d;
+        }
+        if (slot && vol->dir_bytes + size <= UFS_DIR_CACHE_BYTES)
+            break;
+        if (!lru)
+            break; // an empty cache always takes it (load_directory caps the size)
+        dir_slot_clear(vol, lru);
+    }
+    slot->ino = ino;
+    slot->stamp = ++vol->clock;
+    slot->buf = buf;
+    slot->size = size;
+    vol->dir_bytes += (size_t)size;
+    rc = index_directory(slot);
+    if (rc < 0) {
+        dir_slot_clear(vol, slot);
+        return rc;
+    }
+    *out = slot;
+    return 0;
+}
+
 // ---- Public: lookup / readdir / read ------------------------------------
 
 // Fill a ufs_dirent_t for the given inode number.
@@ -446,28 +757,21 @@ static bool name_equals(const char *a, size_t la, const char *b) {
 // Find a child with name `want` under directory inode `dir_ino`.  Returns
 // the child's inode number on hit, 0 on miss, negative on error.
 static int lookup_child(ufs_volume_t *vol, uint32_t dir_ino, const char *want, uint32_t *out_child_ino) {
-    uint8_t *buf = NULL;
-    uint64_t size = 0;
-    int rc = load_directory(vol, dir_ino, &buf, &size);
+    dir_slot_t *d = NULL;
+    int rc = get_directory(vol, dir_ino, &d);
     if (rc < 0)
         return rc;
-    uint64_t off = 0;
-    while (off < size) {
+    *out_child_ino = 0;
+    for (uint32_t i = name_hash(want, strlen(want)) & d->mask; d->hash[i]; i = (i + 1) & d->mask) {
         uint32_t d_ino = 0;
         uint16_t d_namlen = 0;
         const char *name = NULL;
-        int reclen = parse_direct(buf, size, off, &d_ino, &d_namlen, &name);
-        if (reclen <= 0)
-            break;
-        if (d_ino != 0 && name_equals(name, d_namlen, want)) {
+        if (parse_direct(d->buf, d->size, d->hash[i] - 1, &d_ino, &d_namlen, &name) > 0 &&
+            name_equals(name, d_namlen, want)) {
             *out_child_ino = d_ino;
-            free(buf);
             return 1;
         }
-        off += (uint64_t)reclen;
     }
-    free(buf);
-    *out_child_ino = 0;
     return 0;
 }
 
@@ -508,11 +812,22 @@ ufs_dir_iter_t *ufs_opendir_ino(ufs_volume_t *vol, uint32_t ino) {
         return NULL;
     iter->vol = vol;
     iter->ino = ino;
-    int rc = load_directory(vol, ino, &iter->dir_buf, &iter->dir_size);
-    if (rc < 0) {
+    // The iterator keeps its own copy: lookups in between may evict the
+    // cached one.
+    dir_slot_t *d = NULL;
+    if (get_directory(vol, ino, &d) < 0) {
         free(iter);
         return NULL;
     }
+    if (d->size) {
+        iter->dir_buf = malloc((size_t)d->size);
+        if (!iter->dir_buf) {
+            free(iter);
+            return NULL;
+        }
+        memcpy(iter->dir_buf, d->buf, (size_t)d->size);
+        iter->dir_size = d->size;
+    }
     return iter;
 }
 
@@ -577,5 +892,5 @@ int ufs_read_file(ufs_volume_t *vol, uint32_t ino, uint64_t off, void *buf, size
     // immediately returns 0 bytes — which matches the semantics a recursive
     // copy wants (treat the special file as an empty file rather than an
     // error; preserving device numbers is not modelled here).
-    return read_file_by_dinode(vol, di, off, buf, n, nread);
+    return read_file_by_dinode(vol, di, get_bmap(vol, ino, di), off, buf, n, nread);
 }
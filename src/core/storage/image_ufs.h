@@ -5,7 +5,9 @@
 // Read-only UFS-1 walker.  Given an image_t plus the byte offset and size of
 // a partition, opens the BSD FFS superblock, caches the parameters needed
 // for inode and block address math, and exposes path-lookup, directory
-// enumerate, and file-read entry points for the image_vfs backend.
+// enumerate, and file-read entry points for the image_vfs backend.  Each
+// volume keeps bounded caches of dinodes, directories and file block maps
+// (see ufs_cache_stats).
 //
 // Scope:
 //   - A/UX 3.0.x UFS-1 partitions (big-endian on 68k). Targets the
@@ -53,6 +55,15 @@ typedef struct ufs_dirent {
     uint16_t mode; // raw dinode mode field (S_IFMT + perms)
 } ufs_dirent_t;
 
+// Per-volume cache counters.  A miss is a load from the image: a sector of
+// dinodes, a whole directory, or a file's direct and indirect block
+// pointers.
+typedef struct ufs_cache_stats {
+    uint64_t inode_hits, inode_misses;
+    uint64_t dir_hits, dir_misses;
+    uint64_t bmap_hits, bmap_misses;
+} ufs_cache_stats_t;
+
 // Cheap probe: does byte offset `partition_byte_offset + UFS_SBOFF` look
 // like a UFS superblock?  Reads a single 512-byte sector.  Returns true on
 // a valid FS_MAGIC in either byte order (A/UX writes big-endian, but we
@@ -65,6 +76,9 @@ ufs_volume_t *ufs_open(image_t *img, uint64_t partition_byte_offset, uint64_t pa
 // Release the volume and all cached state.  Safe on NULL.
 void ufs_close(ufs_volume_t *vol);
 
+// Fill *out with the volume's cache counters.
+void ufs_cache_stats(const ufs_volume_t *vol, ufs_cache_stats_t *out);
+
 // Look up a path (list of UTF-8 components) relative to the volume root.
 // `nc == 0` returns the root directory entry.  Returns 0 on hit, -ENOENT on
 // miss, -ENOTDIR when a non-terminal component isn't a directory, or
@@ -2,7 +2,7 @@
 // Copyright (c) pappadf
 
 // macroman.c
-// MacRoman -> UTF-8 transcoder. See macroman.h.
+// MacRoman <-> UTF-8 transcoder. See macroman.h.
 
 #include "macroman.h"
 
@@ -45,3 +45,32 @@ void macroman_to_utf8(const uint8_t *src, size_t src_len, char *dst, size_t dst_
     }
     dst[o] = '\0';
 }
+
+int utf8_to_macroman(const char *src, uint8_t *dst, size_t dst_cap) {
+    const uint8_t *s = (const uint8_t *)src;
+    size_t o = 0;
+    while (*s) {
+        // Decode one code point (1-3 byte sequences; MacRoman has nothing past the BMP)
+        uint32_t cp;
+        if (s[0] < 0x80) {
+            cp = *s++;
+        } else if ((s[0] & 0xE0) == 0xC0 && (s[1] & 0xC0) == 0x80) {
+            cp = ((uint32_t)(s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+            s += 2;
+        } else if ((s[0] & 0xF0) == 0xE0 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80) {
+            cp = ((uint32_t)(s[0] & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+            s += 3;
+        } else {
+            return -1;
+        }
+        int c = cp < 0x80 ? (int)cp : -1;
+        for (int i = 0; c < 0 && i < 128; i++) {
+            if (macroman_hi[i] == cp)
+                c = 0x80 + i;
+        }
+        if (c < 0 || o >= dst_cap)
+            return -1;
+        dst[o++] = (uint8_t)c;
+    }
+    return (int)o;
+}
@@ -2,7 +2,7 @@
 // Copyright (c) pappadf
 
 // macroman.h
-// MacRoman -> UTF-8 transcoder.  Lives in its own translation unit so
+// MacRoman <-> UTF-8 transcoder.  Lives in its own translation unit so
 // any future consumers (resource-fork parser, HFS+ catalog walker, ...)
 // can share one table without forcing image_hfs.c to expose its
 // internals.  The table covers 0x80..0xFF; bytes < 0x80 round-trip as
@@ -21,4 +21,10 @@
 // Unsupported bytes never appear because the table covers all 256 values.
 void macroman_to_utf8(const uint8_t *src, size_t src_len, char *dst, size_t dst_cap);
 
+// Encode the NUL-terminated UTF-8 string `src` as MacRoman into `dst` of
+// capacity `dst_cap` (no terminator is written).  Returns the number of
+// bytes produced, or -1 when a character has no MacRoman equivalent, the
+// UTF-8 is malformed, or the result does not fit.
+int utf8_to_macroman(const char *src, uint8_t *dst, size_t dst_cap);
+
 #endif // GS_MACROMAN_H
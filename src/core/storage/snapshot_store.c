@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// snapshot_store.c
+// Named snapshots of the active machine, stored as pooled consolidated
+// checkpoints that share one content-addressed pool, plus mark-and-sweep GC.
+
+#include "snapshot_store.h"
+
+#include "checkpoint.h"
+#include "checkpoint_machine.h"
+#include "log.h"
+#include "object.h"
+#include "snapshot_pool.h"
+#include "system.h"
+#include "value.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+LOG_USE_CATEGORY_NAME("checkpoint")
+
+#define SNAPSHOT_NAME_MAX 64
+#define SNAPSHOT_EXT      ".snap"
+
+// ============================================================================
+// Paths
+// ============================================================================
+
+bool snapshot_store_name_valid(const char *name) {
+    if (!name || !*name || name[0] == '.')
+        return false;
+    size_t n = 0;
+    for (const char *p = name; *p; p++, n++) {
+        char c = *p;
+        bool ok = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '.' || c == '_' ||
+                  c == '-';
+        if (!ok || n >= SNAPSHOT_NAME_MAX)
+            return false;
+    }
+    return true;
+}
+
+// "<machine_dir>/snapshots" into out; false when no machine is set
+static bool store_dir(char *out, size_t cap) {
+    const char *machine = checkpoint_machine_dir();
+    if (!machine) {
+        fprintf(stderr, "snapshot: no machine directory (set one with --checkpoint-dir)\n");
+        return false;
+    }
+    int n = snprintf(out, cap, "%s/snapshots", machine);
+    return n > 0 && (size_t)n < cap;
+}
+
+// "<store>/<name><suffix>" into out; false for bad names or no store
+static bool snapshot_path(const char *name, const char *suffix, char *out, size_t cap) {
+    if (!snapshot_store_name_valid(name)) {
+        fprintf(stderr, "snapshot: invalid name '%s'\n", name ? name : "");
+        return false;
+    }
+    char dir[1024];
+    if (!store_dir(dir, sizeof(dir)))
+        return false;
+    int n = snprintf(out, cap, "%s/%s%s", dir, name, suffix);
+    return n > 0 && (size_t)n < cap;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+int snapshot_store_save(const char *name) {
+    char dir[1024], path[1200], tmp[1200];
+    if (!store_dir(dir, sizeof(dir)) || !snapshot_path(name, SNAPSHOT_EXT, path, sizeof(path)) ||
+        !snapshot_path(name, SNAPSHOT_EXT ".tmp", tmp, sizeof(tmp)))
+        return -1;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "snapshot: cannot create %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    // Snapshots embed their images so they survive later disk changes
+    bool was_pooled = checkpoint_get_pooled();
+    bool was_refs = checkpoint_get_files_as_refs();
+    checkpoint_set_pooled(true);
+    checkpoint_set_files_as_refs(false);
+    int rc = system_checkpoint(tmp, CHECKPOINT_KIND_CONSOLIDATED);
+    checkpoint_set_pooled(was_pooled);
+    checkpoint_set_files_as_refs(was_refs);
+
+    // Only a complete pooled file (refs trailer present) replaces the old one
+    snapshot_hash_set_t *refs = snapshot_hash_set_new();
+    bool ok = rc == 0 && refs && checkpoint_pool_refs(tmp, refs);
+    snapshot_hash_set_free(refs);
+    if (!ok || rename(tmp, path) != 0) {
+        fprintf(stderr, "snapshot: failed to save '%s'\n", name);
+        unlink(tmp);
+        return -1;
+    }
+    LOG(1, "snapshot: saved %s", path);
+    return 0;
+}
+
+int snapshot_store_restore(const char *name) {
+    char path[1200];
+    if (!snapshot_path(name, SNAPSHOT_EXT, path, sizeof(path)))
+        return -1;
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "snapshot: no snapshot named '%s'\n", name);
+        return -1;
+    }
+    char *argv[2] = {"--load", path};
+    return cmd_load_checkpoint(2, argv) == 0 ? 0 : -1;
+}
+
+int snapshot_store_remove(const char *name) {
+    char path[1200];
+    if (!snapshot_path(name, SNAPSHOT_EXT, path, sizeof(path)))
+        return -1;
+    if (unlink(path) != 0) {
+        fprintf(stderr, "snapshot: cannot remove '%s': %s\n", name, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int name_cmp(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+int snapshot_store_list(char ***names) {
+    *names = NULL;
+    char dir[1024];
+    if (!store_dir(dir, sizeof(dir)))
+        return -1;
+    DIR *d = opendir(dir);
+    if (!d)
+        return errno == ENOENT ? 0 : -1;
+
+    char **out = NULL;
+    int count = 0, cap = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        size_t len = strlen(ent->d_name);
+        size_t ext = sizeof(SNAPSHOT_EXT) - 1;
+        if (len <= ext || strcmp(ent->d_name + len - ext, SNAPSHOT_EXT) != 0)
+            continue;
+        char *name = strndup(ent->d_name, len - ext);
+        if (!name || !snapshot_store_name_valid(name)) {
+            free(name);
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? cap * 2 : 8;
+            char **grown = (char **)realloc(out, (size_t)cap * sizeof(*out));
+            if (!grown) {
+                free(name);
+                break;
+            }
+            out = grown;
+        }
+        out[count++] = name;
+    }
+    closedir(d);
+    if (count > 1)
+        qsort(out, (size_t)count, sizeof(*out), name_cmp);
+    *names = out;
+    return count;
+}
+
+void snapshot_store_list_free(char **names, int count) {
+    for (int i = 0; i < count; i++)
+        free(names[i]);
+    free(names);
+}
+
+long snapshot_store_gc(uint64_t *freed) {
+    char dir[1024], pool[1100];
+    if (!store_dir(dir, sizeof(dir)))
+        return -1;
+    snprintf(pool, sizeof(pool), "%s/pool", dir);
+
+    char **names = NULL;
+    int count = snapshot_store_list(&names);
+    if (count < 0)
+        return -1;
+
+    // Mark: every object some snapshot references.  An unreadable snapshot
+    // aborts the collection rather than losing the objects it needs.
+    snapshot_hash_set_t *live = snapshot_hash_set_new();
+    bool ok = live != NULL;
+    for (int i = 0; ok && i < count; i++) {
+        char path[1200];
+        snprintf(path, sizeof(path), "%s/%s%s", dir, names[i], SNAPSHOT_EXT);
+        if (!checkpoint_pool_refs(path, live)) {
+            fprintf(stderr, "snapshot: cannot read '%s'; gc skipped\n", names[i]);
+            ok = false;
+        }
+    }
+    snapshot_store_list_free(names, count);
+
+    // Sweep
+    long removed = ok ? snapshot_pool_sweep(pool, live, freed) : -1;
+    snapshot_hash_set_free(live);
+    return removed;
+}
+
+// ============================================================================
+// Object-model class descriptor
+// ============================================================================
+
+// `checkpoint.store.list()` — names of the stored snapshots, sorted
+static value_t store_method_list(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    (void)argv;
+    char **names = NULL;
+    int count = snapshot_store_list(&names);
+    value_t *items = NULL;
+    size_t len = 0, cap = 0;
+    for (int i = 0; i < count; i++)
+        val_list_push(&items, &len, &cap, val_str(names[i]));
+    if (count > 0)
+        snapshot_store_list_free(names, count);
+    return val_list(items, len);
+}
+
+// `checkpoint.store.save(name)` — snapshot the running machine
+static value_t store_method_save(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    return val_bool(snapshot_store_save(argv[0].s) == 0);
+}
+
+// `checkpoint.store.restore(name)` — load a stored snapshot
+static value_t store_method_restore(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    return val_bool(snapshot_store_restore(argv[0].s) == 0);
+}
+
+// `checkpoint.store.remove(name)` — forget a snapshot (space returns at gc)
+static value_t store_method_remove(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    return val_bool(snapshot_store_remove(argv[0].s) == 0);
+}
+
+// `checkpoint.store.gc()` — delete unreferenced pool objects; returns how
+// many were removed, or -1 when the store could not be scanned
+static value_t store_method_gc(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    (void)argv;
+    uint64_t freed = 0;
+    long removed = snapshot_store_gc(&freed);
+    if (removed >= 0)
+        printf("snapshot gc: removed %ld object%s, freed %" PRIu64 " bytes\n", removed, removed == 1 ? "" : "s",
+               freed);
+    return val_int(removed);
+}
+
+static const arg_decl_t store_name_arg[] = {
+    {.name = "name", .kind = V_STRING, .doc = "Snapshot name ([A-Za-z0-9._-], up to 64 characters)"},
+};
+
+static const member_t store_members[] = {
+    {.kind = M_METHOD,
+     .name = "list",
+     .doc = "Names of the stored snapshots",
+     .method = {.args = NULL, .nargs = 0, .result = V_LIST, .fn = store_method_list}},
+    {.kind = M_METHOD,
+     .name = "save",
+     .doc = "Save the running machine as a deduplicated snapshot",
+     .method = {.args = store_name_arg, .nargs = 1, .result = V_BOOL, .fn = store_method_save}},
+    {.kind = M_METHOD,
+     .name = "restore",
+     .doc = "Restore a stored snapshot",
+     .method = {.args = store_name_arg, .nargs = 1, .result = V_BOOL, .fn = store_method_restore}},
+    {.kind = M_METHOD,
+     .name = "remove",
+     .doc = "Delete a stored snapshot (its space is reclaimed by gc)",
+     .method = {.args = store_name_arg, .nargs = 1, .result = V_BOOL, .fn = store_method_remove}},
+    {.kind = M_METHOD,
+     .name = "gc",
+     .doc = "Delete pool objects no snapshot references; returns the count",
+     .method = {.args = NULL, .nargs = 0, .result = V_INT, .fn = store_method_gc}},
+};
+
+const class_desc_t snapshot_store_class = {
+    .name = "store",
+    .members = store_members,
+    .n_members = sizeof(store_members) / sizeof(store_members[0]),
+};
+
+// ============================================================================
+// Lifecycle (process-singleton, idempotent)
+// ============================================================================
+
+static struct object *s_store_object = NULL;
+
+// Attach `store` under the `checkpoint` object (call after checkpoint_init)
+void snapshot_store_init(void) {
+    if (s_store_object || !checkpoint_object())
+        return;
+    s_store_object = object_new(&snapshot_store_class, NULL, "store");
+    if (s_store_object)
+        object_attach(checkpoint_object(), s_store_object);
+}
+
+void snapshot_store_delete(void) {
+    if (s_store_object) {
+        object_detach(s_store_object);
+        object_delete(s_store_object);
+        s_store_object = NULL;
+    }
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// snapshot_store.h
+// Named, deduplicated machine snapshots kept under the machine directory:
+//   <machine_dir>/snapshots/<name>.snap   pooled consolidated checkpoints
+//   <machine_dir>/snapshots/pool/         objects they share (snapshot_pool.h)
+// Saving many snapshots of one machine costs roughly the pages that changed
+// between them.  Objects stay until snapshot_store_gc finds them unreferenced.
+
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// True if name is usable as a snapshot name: 1-64 of [A-Za-z0-9._-], not
+// starting with '.'
+bool snapshot_store_name_valid(const char *name);
+
+// Save the running machine as snapshot name, replacing any snapshot of that
+// name.  Returns 0 on success, -1 on failure (nothing is replaced).
+int snapshot_store_save(const char *name);
+
+// Restore snapshot name into the running machine.  Returns 0 on success.
+int snapshot_store_restore(const char *name);
+
+// Delete snapshot name; its objects go at the next gc.  Returns 0 on success.
+int snapshot_store_remove(const char *name);
+
+// Names of the stored snapshots in sorted order.  Returns the count and a
+// malloc'd array of malloc'd names in *names (free with
+// snapshot_store_list_free), or -1 when there is no store.
+int snapshot_store_list(char ***names);
+void snapshot_store_list_free(char **names, int count);
+
+// Remove pool objects no snapshot references.  Returns the number of
+// objects removed and adds their bytes to *freed (optional), or -1 when a
+// snapshot cannot be read (nothing is removed then).
+long snapshot_store_gc(uint64_t *freed);
+
+// === Object-model class descriptor =========================================
+//
+// `checkpoint.store` exposes list / save / restore / remove / gc over the
+// store of the active machine.
+
+struct class_desc;
+extern const struct class_desc snapshot_store_class;
+
+void snapshot_store_init(void);
+void snapshot_store_delete(void);
+
+#endif // SNAPSHOT_STORE_H
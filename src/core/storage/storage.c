@@ -4,16 +4,27 @@
 // storage.c
 // Delta-file storage engine implementation.
 //
-// Layout of the delta file:
-//   [0..23]                      Fixed header (magic, version, block_count, block_size)
-//   [24 .. 24+bm-1]             Current bitmap (1 bit per block)
-//   [24+bm .. 24+2*bm-1]        Committed bitmap
-//   [24+2*bm .. EOF]             Block data area (block_count * block_size bytes, sparse)
+// Layout of the delta file (version 2):
+//   [0..63]                      Header (magic, version, geometry, extent area size, index location)
+//   [64..511]                    Reserved
+//   [512 .. 512+slots*bs-1]      Extent area: slots of block_size bytes, in allocation order
+//
+// A modified block lives in a slot; the LBA→slot index is kept in memory and
+// written into the extent area at commit time, after which the header is
+// pointed at it.  The delta therefore grows with the blocks written, not with
+// the disk.  Slots freed by a commit are reused by later writes, and a commit
+// that finds more dead slots than live ones rewrites the delta compactly.
+// Version 1 deltas (bitmaps plus a block area addressed by LBA) are migrated
+// on open.
 //
 // Journal format (append-only):
 //   Each entry: [uint32_t LBA][block_size bytes data] = 4 + block_size bytes per
 //   entry.  The header records block_size, so reopen self-describes the entry
 //   stride — no fixed entry size.
+//
+// Block data goes through the raw descriptors with pread/pwrite, a run of
+// blocks that are contiguous in one file per call; stdio is kept for scanning
+// the journal.
 
 #include "storage.h"
 
@@ -24,12 +35,14 @@ LOG_USE_CATEGORY_NAME("storage");
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 // ============================================================================
@@ -38,13 +51,35 @@ LOG_USE_CATEGORY_NAME("storage");
 
 #define DELTA_MAGIC       "GSDL"
 #define DELTA_MAGIC_SIZE  4
-#define DELTA_VERSION     1
-#define DELTA_HEADER_SIZE 24 // magic(4) + version(4) + block_count(8) + block_size(4) + reserved(4)
+#define DELTA_VERSION     2
+#define DELTA_V1_VERSION  1
+#define DELTA_V1_HEADER   24 // magic(4) + version(4) + block_count(8) + block_size(4) + reserved(4)
+#define DELTA_DATA_OFFSET 512 // start of the extent area
+
+// A commit compacts the delta when its dead slots outnumber the live ones
+// and there are at least this many of them
+#define DELTA_COMPACT_MIN_SLOTS 2048
+
+// The LBA→slot index is a table of pages, allocated when a block in them is mapped
+#define SLOT_PAGE_BITS 10
+#define SLOT_PAGE_SIZE (1u << SLOT_PAGE_BITS)
 
 // One journal entry = LBA(4) + one block of data.  Block size is per-instance
 // (storage->block_size), so the stride is computed at runtime, not fixed.
 #define JOURNAL_ENTRY_SIZE(s) (4 + (size_t)(s)->block_size)
 
+// Journal entries appended per writev call (two iovecs each)
+#define JOURNAL_BATCH 32
+
+// Preimages captured per read when a multi-block write overwrites committed blocks
+#define PREIMAGE_BATCH 64
+
+// Block cache: no entry, blocks read back to back before readahead starts,
+// and the most blocks loaded ahead of a sequential reader
+#define CACHE_NONE        UINT32_MAX
+#define READAHEAD_TRIGGER 16
+#define READAHEAD_MAX     128
+
 #define STORAGE_SNAPSHOT_VERSION 2
 
 // ============================================================================
@@ -54,22 +89,97 @@ LOG_USE_CATEGORY_NAME("storage");
 // Snapshot header written to checkpoint stream
 typedef struct {
     uint32_t version;
-    uint8_t has_data; // 1 = consolidated (all blocks), 0 = quick (bitmap only)
+    uint8_t has_data; // SNAPSHOT_BITMAP, SNAPSHOT_BLOCKS or SNAPSHOT_DELTA
     uint8_t reserved[3];
     uint64_t block_count;
     uint32_t block_size;
 } storage_snapshot_header_t;
 
-// Context for checkpoint streaming callbacks
+// What a snapshot carries: quick checkpoints the delta bitmap, consolidated
+// ones every block, history snapshots the bitmap plus the runs holding
+// modified blocks (the delta's contents, which a rewind has to put back)
+#define SNAPSHOT_BITMAP 0
+#define SNAPSHOT_BLOCKS 1
+#define SNAPSHOT_DELTA  2
+
+// Bytes of consolidated block data per checkpoint block (rounded down to whole
+// storage blocks); large runs compress well and are pooled by snapshot saves
+#define STORAGE_CHECKPOINT_RUN 65536u
+
+// Context for checkpoint streaming callbacks: storage blocks are gathered
+// into runs, one checkpoint block per run
 typedef struct {
     checkpoint_t *checkpoint;
+    uint8_t *run;
+    size_t run_cap; // bytes per full run
+    size_t run_used; // bytes gathered (write) or available (read)
+    size_t run_pos; // read cursor
+    uint64_t remaining; // bytes not yet read from the checkpoint (read)
 } checkpoint_stream_ctx_t;
 
+// Delta file header (version 2).  The first 24 bytes match version 1.
+typedef struct {
+    char magic[DELTA_MAGIC_SIZE];
+    uint32_t version;
+    uint64_t block_count;
+    uint32_t block_size;
+    uint32_t reserved0;
+    uint64_t slot_count; // slots in the extent area
+    uint64_t index_slot; // first slot of the committed index
+    uint64_t index_entries; // entries in the committed index
+    uint32_t index_checksum; // FNV-1a of the index entries
+    uint32_t reserved1;
+    uint64_t reserved2;
+} delta_header_t;
+
+_Static_assert(sizeof(delta_header_t) == 64, "delta header must stay 64 bytes");
+
+// One committed block: its LBA and the slot holding it.  The index is sorted by LBA.
+typedef struct {
+    uint32_t lba;
+    uint32_t slot;
+} delta_entry_t;
+
+// One cached block
+typedef struct {
+    uint32_t lba;
+    uint32_t prev, next; // LRU list, most recently used first
+    uint32_t hash_next; // Next entry in the same bucket
+} cache_entry_t;
+
+// LRU cache of current block contents.  Writes update it, paths that change
+// blocks wholesale (rollback, restores) empty it.
+typedef struct {
+    cache_entry_t *entries;
+    uint8_t *data; // capacity blocks
+    uint32_t *buckets; // Hash chain heads, bucket_mask + 1 of them
+    uint32_t bucket_mask;
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t head, tail; // Most and least recently used entries
+    uint64_t hits, misses, readahead;
+    uint32_t seq_next; // Block after the last read
+    uint32_t seq_blocks; // Blocks read back to back up to seq_next
+    uint32_t ra_lba, ra_count; // Readahead queued for storage_tick
+    uint32_t ra_end; // End of the last readahead queued
+} block_cache_t;
+
+// Growable list of slot numbers
+typedef struct {
+    uint32_t *items;
+    size_t count;
+    size_t capacity;
+} slot_list_t;
+
 // The storage instance
 struct storage_t {
     FILE *base_fp; // Original image, read-only, kept open
     FILE *delta_fp; // Delta file, read-write, kept open
     FILE *journal_fp; // Preimage journal, append+read, kept open
+    int base_fd; // Descriptors of the three files for block I/O (-1 = none)
+    int delta_fd;
+    int journal_fd;
+    char *delta_path; // Needed to replace the delta when compacting
 
     uint8_t *bitmap; // Current modification bitmap (in memory)
     uint8_t *committed_bitmap; // Bitmap at last successful checkpoint
@@ -79,16 +189,32 @@ struct storage_t {
     size_t bitmap_bytes; // ceil(block_count / 8)
 
     size_t base_data_offset; // Byte offset to data in base file
-    size_t bitmap_offset; // Byte offset to bitmaps in delta (= DELTA_HEADER_SIZE)
-    size_t data_offset; // Byte offset to block data in delta
+    storage_base_read_t base_read; // Decoded base (instead of base_fd), or NULL
+    void *base_context;
+
+    uint32_t **slot_pages; // LBA → slot + 1 (0 = no slot), SLOT_PAGE_SIZE entries per page
+    size_t slot_page_count;
+    uint64_t mapped; // LBAs with a slot
+    uint64_t slot_count; // Slots in the extent area
+    slot_list_t free_slots; // Unreferenced slots, reused before the area grows (highest first)
+    slot_list_t pending_slots; // Slots the on-disk index may still reference; free after the next commit
+    uint64_t index_slot; // Location and size of the committed index
+    uint64_t index_entries;
+    uint32_t index_checksum;
+    bool map_dirty; // LBAs were given slots since the index was written
 
     uint32_t *journal_lbas; // In-memory index of captured LBAs
     size_t journal_count;
     size_t journal_capacity;
 
     bool bitmap_dirty; // True if bitmap changed since last flush
+
+    block_cache_t cache;
 };
 
+// Cache size given to new instances
+static size_t g_default_cache_blocks = STORAGE_CACHE_DEFAULT_BLOCKS;
+
 // ============================================================================
 // Bitmap helpers
 // ============================================================================
@@ -101,6 +227,101 @@ static inline void bitmap_set(uint8_t *bm, uint32_t bit) {
     bm[bit >> 3] |= (uint8_t)(1u << (bit & 7));
 }
 
+static inline void bitmap_clear(uint8_t *bm, uint32_t bit) {
+    bm[bit >> 3] &= (uint8_t)~(1u << (bit & 7));
+}
+
+// True if any of the count bits from first is set
+static bool bitmap_any(const uint8_t *bm, uint64_t first, uint64_t count) {
+    for (uint64_t bit = first; bit < first + count; bit++) {
+        if ((bit & 7) == 0 && bit + 8 <= first + count) {
+            if (bm[bit >> 3])
+                return true;
+            bit += 7;
+        } else if (bitmap_test(bm, (uint32_t)bit)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Raw file I/O helpers
+// ============================================================================
+
+// pread until count bytes arrived or EOF.  Returns the bytes read, -1 on error.
+static ssize_t pread_full(int fd, void *buffer, size_t count, off_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = pread(fd, (uint8_t *)buffer + done, count - done, offset + (off_t)done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+        done += (size_t)n;
+    }
+    return (ssize_t)done;
+}
+
+// pwrite all count bytes
+static int pwrite_full(int fd, const void *buffer, size_t count, off_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = pwrite(fd, (const uint8_t *)buffer + done, count - done, offset + (off_t)done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return GS_ERROR;
+        done += (size_t)n;
+    }
+    return GS_SUCCESS;
+}
+
+// Flush fd's data and metadata to stable storage
+static int sync_full(int fd) {
+    while (fsync(fd) != 0) {
+        if (errno != EINTR)
+            return GS_ERROR;
+    }
+    return GS_SUCCESS;
+}
+
+// Make a rename into the directory holding path durable
+static int sync_parent_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    char *dir = slash ? strndup(path, slash == path ? 1 : (size_t)(slash - path)) : strdup(".");
+    int fd = dir ? open(dir, O_RDONLY) : -1;
+    free(dir);
+    if (fd < 0)
+        return GS_ERROR;
+    int rc = sync_full(fd);
+    close(fd);
+    return rc;
+}
+
+// writev all of iov[0..iovcnt), advancing past partial writes
+static int writev_full(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return GS_ERROR;
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return GS_SUCCESS;
+}
+
 // ============================================================================
 // Journal helpers
 // ============================================================================
@@ -126,17 +347,31 @@ static int journal_index_add(storage_t *s, uint32_t lba) {
     return GS_SUCCESS;
 }
 
-// Append a preimage entry to the journal file and index.
-static int journal_append(storage_t *s, uint32_t lba, const uint8_t *data) {
-    // Write LBA (little-endian uint32_t)
-    if (fwrite(&lba, sizeof(lba), 1, s->journal_fp) != 1)
-        return GS_ERROR;
-    // Write block data
-    if (fwrite(data, s->block_size, 1, s->journal_fp) != 1)
-        return GS_ERROR;
-    fflush(s->journal_fp);
-
-    return journal_index_add(s, lba);
+// Append preimage entries for the count consecutive blocks from lba to the
+// journal file and index.  The journal is opened for appending, so each
+// writev lands at its end.
+static int journal_append(storage_t *s, uint32_t lba, const uint8_t *data, size_t count) {
+    uint32_t lbas[JOURNAL_BATCH];
+    struct iovec iov[2 * JOURNAL_BATCH];
+    for (size_t done = 0; done < count;) {
+        size_t n = count - done < JOURNAL_BATCH ? count - done : JOURNAL_BATCH;
+        for (size_t i = 0; i < n; i++) {
+            // LBA (little-endian uint32_t), then the block data
+            lbas[i] = lba + (uint32_t)(done + i);
+            iov[2 * i].iov_base = &lbas[i];
+            iov[2 * i].iov_len = sizeof(lbas[i]);
+            iov[2 * i + 1].iov_base = (void *)(data + (done + i) * s->block_size);
+            iov[2 * i + 1].iov_len = s->block_size;
+        }
+        if (writev_full(s->journal_fd, iov, (int)(2 * n)) != GS_SUCCESS)
+            return GS_ERROR;
+        for (size_t i = 0; i < n; i++) {
+            if (journal_index_add(s, lbas[i]) != GS_SUCCESS)
+                return GS_ERROR;
+        }
+        done += n;
+    }
+    return GS_SUCCESS;
 }
 
 // Scan the journal file and rebuild the in-memory index.
@@ -179,86 +414,488 @@ static int journal_load_index(storage_t *s) {
 }
 
 // ============================================================================
-// Delta file I/O helpers
+// Slot map
 // ============================================================================
 
-// Write the delta file header (called on creation).
-static int delta_write_header(storage_t *s) {
-    fseek(s->delta_fp, 0, SEEK_SET);
+// Slot holding lba plus one, 0 when it has none
+static inline uint32_t slot_lookup(const storage_t *s, uint32_t lba) {
+    const uint32_t *page = s->slot_pages[lba >> SLOT_PAGE_BITS];
+    return page ? page[lba & (SLOT_PAGE_SIZE - 1)] : 0;
+}
 
-    // Magic
-    if (fwrite(DELTA_MAGIC, DELTA_MAGIC_SIZE, 1, s->delta_fp) != 1)
-        return GS_ERROR;
-    // Version
-    uint32_t version = DELTA_VERSION;
-    if (fwrite(&version, sizeof(version), 1, s->delta_fp) != 1)
-        return GS_ERROR;
-    // Block count
-    if (fwrite(&s->block_count, sizeof(s->block_count), 1, s->delta_fp) != 1)
-        return GS_ERROR;
-    // Block size
-    if (fwrite(&s->block_size, sizeof(s->block_size), 1, s->delta_fp) != 1)
-        return GS_ERROR;
-    // Reserved
-    uint32_t reserved = 0;
-    if (fwrite(&reserved, sizeof(reserved), 1, s->delta_fp) != 1)
+// Give lba the slot (replacing any previous one)
+static int slot_map(storage_t *s, uint32_t lba, uint32_t slot) {
+    uint32_t **page = &s->slot_pages[lba >> SLOT_PAGE_BITS];
+    if (!*page && !(*page = (uint32_t *)calloc(SLOT_PAGE_SIZE, sizeof(uint32_t))))
         return GS_ERROR;
+    uint32_t *entry = &(*page)[lba & (SLOT_PAGE_SIZE - 1)];
+    if (!*entry)
+        s->mapped++;
+    *entry = slot + 1;
+    return GS_SUCCESS;
+}
 
+static void slot_unmap(storage_t *s, uint32_t lba) {
+    uint32_t *page = s->slot_pages[lba >> SLOT_PAGE_BITS];
+    if (page && page[lba & (SLOT_PAGE_SIZE - 1)]) {
+        page[lba & (SLOT_PAGE_SIZE - 1)] = 0;
+        s->mapped--;
+    }
+}
+
+static int slot_list_push(slot_list_t *list, uint32_t slot) {
+    if (list->count == list->capacity) {
+        size_t cap = list->capacity ? list->capacity * 2 : 64;
+        uint32_t *items = (uint32_t *)realloc(list->items, cap * sizeof(uint32_t));
+        if (!items)
+            return GS_ERROR;
+        list->items = items;
+        list->capacity = cap;
+    }
+    list->items[list->count++] = slot;
     return GS_SUCCESS;
 }
 
-// Read and validate the delta file header.
-static int delta_read_header(storage_t *s) {
-    fseek(s->delta_fp, 0, SEEK_SET);
+static int slot_compare_desc(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x < y) - (x > y);
+}
 
-    char magic[DELTA_MAGIC_SIZE];
-    if (fread(magic, DELTA_MAGIC_SIZE, 1, s->delta_fp) != 1)
-        return GS_ERROR;
-    if (memcmp(magic, DELTA_MAGIC, DELTA_MAGIC_SIZE) != 0)
+// Take a slot for new data: the lowest free one, else a new one at the end of the extent area
+static int slot_alloc(storage_t *s, uint32_t *slot) {
+    if (s->free_slots.count) {
+        *slot = s->free_slots.items[--s->free_slots.count];
+        return GS_SUCCESS;
+    }
+    if (s->slot_count >= UINT32_MAX)
         return GS_ERROR;
+    *slot = (uint32_t)s->slot_count++;
+    return GS_SUCCESS;
+}
 
-    uint32_t version;
-    if (fread(&version, sizeof(version), 1, s->delta_fp) != 1)
-        return GS_ERROR;
-    if (version != DELTA_VERSION)
+// Byte offset of a slot in the delta
+static inline off_t delta_slot_offset(const storage_t *s, uint64_t slot) {
+    return (off_t)DELTA_DATA_OFFSET + (off_t)slot * (off_t)s->block_size;
+}
+
+// Slots taken by an index of entries entries
+static uint64_t index_slots(const storage_t *s, uint64_t entries) {
+    return (entries * sizeof(delta_entry_t) + s->block_size - 1) / s->block_size;
+}
+
+// ============================================================================
+// Delta file I/O helpers
+// ============================================================================
+
+static uint32_t index_checksum(const delta_entry_t *entries, size_t count) {
+    const uint8_t *p = (const uint8_t *)entries;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < count * sizeof(delta_entry_t); i++)
+        hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+// Write a version 2 header describing an extent area and index to fd
+static int delta_write_header(const storage_t *s, int fd, uint64_t slot_count, uint64_t index_slot,
+                              uint64_t index_entries, uint32_t checksum) {
+    delta_header_t header = {0};
+    memcpy(header.magic, DELTA_MAGIC, DELTA_MAGIC_SIZE);
+    header.version = DELTA_VERSION;
+    header.block_count = s->block_count;
+    header.block_size = s->block_size;
+    header.slot_count = slot_count;
+    header.index_slot = index_slot;
+    header.index_entries = index_entries;
+    header.index_checksum = checksum;
+    return pwrite_full(fd, &header, sizeof(header), 0);
+}
+
+// Every mapped LBA with its slot, in LBA order (malloc'd; *count receives the length)
+static delta_entry_t *delta_entries(const storage_t *s, size_t *count) {
+    delta_entry_t *entries = (delta_entry_t *)malloc(s->mapped ? (size_t)s->mapped * sizeof(delta_entry_t) : 1);
+    size_t n = 0;
+    for (size_t p = 0; entries && p < s->slot_page_count; p++) {
+        const uint32_t *page = s->slot_pages[p];
+        for (uint32_t i = 0; page && i < SLOT_PAGE_SIZE; i++) {
+            if (page[i])
+                entries[n++] = (delta_entry_t){(uint32_t)(p << SLOT_PAGE_BITS) + i, page[i] - 1};
+        }
+    }
+    *count = n;
+    return entries;
+}
+
+// Write the blocks of entries (sorted by LBA; slot = source block at
+// src_base in src_fd) to a fresh delta in LBA order, followed by its index,
+// and put it in place of the delta.  On success the slot map describes the
+// new file; on failure nothing changed.
+static int delta_rewrite(storage_t *s, delta_entry_t *entries, size_t count, int src_fd, off_t src_base) {
+    size_t path_len = strlen(s->delta_path) + sizeof(".compact");
+    char *tmp_path = (char *)malloc(path_len);
+    uint8_t *run = (uint8_t *)malloc(STORAGE_CHECKPOINT_RUN);
+    FILE *fp = tmp_path ? (snprintf(tmp_path, path_len, "%s.compact", s->delta_path), fopen(tmp_path, "w+b")) : NULL;
+    int fd = fp ? fileno(fp) : -1;
+    int rc = fp && run ? GS_SUCCESS : GS_ERROR;
+
+    // Copy the blocks, one read per run of consecutive source blocks
+    size_t per_run = STORAGE_CHECKPOINT_RUN / s->block_size;
+    for (size_t i = 0; rc == GS_SUCCESS && i < count;) {
+        size_t n = 1;
+        while (i + n < count && n < per_run && entries[i + n].slot == entries[i].slot + n)
+            n++;
+        size_t len = n * s->block_size;
+        off_t from = src_base + (off_t)entries[i].slot * (off_t)s->block_size;
+        if (pread_full(src_fd, run, len, from) != (ssize_t)len ||
+            pwrite_full(fd, run, len, delta_slot_offset(s, i)) != GS_SUCCESS)
+            rc = GS_ERROR;
+        i += n;
+    }
+
+    // Index after the blocks, then the header
+    uint64_t slots = count + index_slots(s, count);
+    uint32_t checksum = 0;
+    if (rc == GS_SUCCESS) {
+        for (size_t i = 0; i < count; i++)
+            entries[i].slot = (uint32_t)i;
+        checksum = index_checksum(entries, count);
+        if ((count && pwrite_full(fd, entries, count * sizeof(delta_entry_t), delta_slot_offset(s, count)) !=
+                          GS_SUCCESS) ||
+            delta_write_header(s, fd, slots, count, count, checksum) != GS_SUCCESS)
+            rc = GS_ERROR;
+    }
+    if (rc == GS_SUCCESS && ftruncate(fd, delta_slot_offset(s, slots)) != 0)
+        rc = GS_ERROR;
+    // The new file must be complete on disk before its name replaces the delta
+    if (rc == GS_SUCCESS)
+        rc = sync_full(fd);
+    if (rc == GS_SUCCESS && rename(tmp_path, s->delta_path) != 0) {
+        LOG(0, "storage: cannot replace %s (errno=%d)", s->delta_path, errno);
+        rc = GS_ERROR;
+    }
+    // Past the rename there is no going back; a failed directory sync only
+    // means a power loss may still find the old delta under the name
+    if (rc == GS_SUCCESS && sync_parent_dir(s->delta_path) != GS_SUCCESS)
+        LOG(0, "storage: cannot sync the directory of %s (errno=%d)", s->delta_path, errno);
+    free(run);
+    if (rc != GS_SUCCESS) {
+        if (fp) {
+            fclose(fp);
+            remove(tmp_path);
+        }
+        free(tmp_path);
         return GS_ERROR;
+    }
+    free(tmp_path);
+
+    // Switch to the new file.  entries are the blocks already mapped (or, when
+    // migrating, the map is still empty), so only migration allocates pages.
+    if (s->delta_fp)
+        fclose(s->delta_fp);
+    s->delta_fp = fp;
+    s->delta_fd = fd;
+    for (size_t i = 0; i < count; i++) {
+        if (slot_map(s, entries[i].lba, entries[i].slot) != GS_SUCCESS)
+            return GS_ERROR;
+    }
+    s->slot_count = slots;
+    s->index_slot = count;
+    s->index_entries = count;
+    s->index_checksum = checksum;
+    s->free_slots.count = 0;
+    s->pending_slots.count = 0;
+    s->map_dirty = false;
+    return GS_SUCCESS;
+}
 
-    uint64_t block_count;
-    if (fread(&block_count, sizeof(block_count), 1, s->delta_fp) != 1)
+// Make the committed bitmap durable: drop the slots of blocks outside it,
+// append a new index to the extent area (or compact the delta when it is
+// mostly dead slots), then point the header at the index.
+static int delta_commit(storage_t *s) {
+    // Slots of blocks no longer in the delta stay untouched until the header has moved on
+    for (size_t p = 0; p < s->slot_page_count; p++) {
+        uint32_t *page = s->slot_pages[p];
+        for (uint32_t i = 0; page && i < SLOT_PAGE_SIZE; i++) {
+            uint32_t lba = (uint32_t)(p << SLOT_PAGE_BITS) + i;
+            if (page[i] && !bitmap_test(s->committed_bitmap, lba)) {
+                if (slot_list_push(&s->pending_slots, page[i] - 1) != GS_SUCCESS)
+                    return GS_ERROR;
+                slot_unmap(s, lba);
+            }
+        }
+    }
+
+    size_t count = 0;
+    delta_entry_t *entries = delta_entries(s, &count);
+    if (!entries)
         return GS_ERROR;
-    if (block_count != s->block_count)
+
+    uint64_t dead = s->slot_count - count - index_slots(s, s->index_entries);
+    if (dead >= DELTA_COMPACT_MIN_SLOTS && dead > count) {
+        LOG(1, "storage: compacting %s (%" PRIu64 " of %" PRIu64 " slots dead)", s->delta_path, dead, s->slot_count);
+        if (delta_rewrite(s, entries, count, s->delta_fd, DELTA_DATA_OFFSET) == GS_SUCCESS) {
+            free(entries);
+            return GS_SUCCESS;
+        }
+        // Keep the file as it is; the plain commit below is still valid
+    }
+
+    uint64_t at = s->slot_count;
+    uint64_t slots = index_slots(s, count);
+    uint32_t checksum = index_checksum(entries, count);
+    int rc = at + slots <= UINT32_MAX ? GS_SUCCESS : GS_ERROR;
+    if (rc == GS_SUCCESS && count)
+        rc = pwrite_full(s->delta_fd, entries, count * sizeof(delta_entry_t), delta_slot_offset(s, at));
+    // Blocks and index reach the disk before the header points at them, and
+    // the header before any slot the old index references is reused
+    if (rc == GS_SUCCESS)
+        rc = sync_full(s->delta_fd);
+    if (rc == GS_SUCCESS)
+        rc = delta_write_header(s, s->delta_fd, at + slots, at, count, checksum);
+    if (rc == GS_SUCCESS)
+        rc = sync_full(s->delta_fd);
+    free(entries);
+    if (rc != GS_SUCCESS)
         return GS_ERROR;
 
-    uint32_t block_size;
-    if (fread(&block_size, sizeof(block_size), 1, s->delta_fp) != 1)
+    // The header has moved on: the previous index and the dropped blocks are free
+    for (uint64_t i = 0; i < index_slots(s, s->index_entries); i++)
+        slot_list_push(&s->pending_slots, (uint32_t)(s->index_slot + i));
+    for (size_t i = 0; i < s->pending_slots.count; i++)
+        slot_list_push(&s->free_slots, s->pending_slots.items[i]);
+    s->pending_slots.count = 0;
+    if (s->free_slots.count)
+        qsort(s->free_slots.items, s->free_slots.count, sizeof(uint32_t), slot_compare_desc);
+
+    s->slot_count = at + slots;
+    s->index_slot = at;
+    s->index_entries = count;
+    s->index_checksum = checksum;
+    s->map_dirty = false;
+    return GS_SUCCESS;
+}
+
+// Load a version 2 delta: header, index, and the free slots around them
+static int delta_load(storage_t *s) {
+    delta_header_t header;
+    if (pread_full(s->delta_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
         return GS_ERROR;
-    if (block_size != s->block_size)
+    uint64_t slots = index_slots(s, header.index_entries);
+    if (header.slot_count > UINT32_MAX || header.index_entries > s->block_count ||
+        header.index_slot + slots > header.slot_count)
         return GS_ERROR;
 
-    // Skip reserved
-    fseek(s->delta_fp, 4, SEEK_CUR);
+    size_t count = (size_t)header.index_entries;
+    delta_entry_t *entries = (delta_entry_t *)malloc(count ? count * sizeof(delta_entry_t) : 1);
+    uint8_t *used = (uint8_t *)calloc(1, (size_t)(header.slot_count + 7) / 8 + 1);
+    int rc = entries && used ? GS_SUCCESS : GS_ERROR;
+    if (rc == GS_SUCCESS && count &&
+        pread_full(s->delta_fd, entries, count * sizeof(delta_entry_t), delta_slot_offset(s, header.index_slot)) !=
+            (ssize_t)(count * sizeof(delta_entry_t)))
+        rc = GS_ERROR;
+    if (rc == GS_SUCCESS && index_checksum(entries, count) != header.index_checksum) {
+        LOG(0, "storage: delta index checksum mismatch");
+        rc = GS_ERROR;
+    }
 
-    return GS_SUCCESS;
+    // Entries must be in LBA order, inside the disk, and own distinct slots outside the index
+    for (uint64_t i = 0; rc == GS_SUCCESS && i < slots; i++)
+        bitmap_set(used, (uint32_t)(header.index_slot + i));
+    for (size_t i = 0; rc == GS_SUCCESS && i < count; i++) {
+        const delta_entry_t *e = &entries[i];
+        if (e->lba >= s->block_count || (i && e->lba <= entries[i - 1].lba) || e->slot >= header.slot_count ||
+            bitmap_test(used, e->slot)) {
+            rc = GS_ERROR;
+            break;
+        }
+        bitmap_set(used, e->slot);
+        rc = slot_map(s, e->lba, e->slot);
+        bitmap_set(s->bitmap, e->lba);
+        bitmap_set(s->committed_bitmap, e->lba);
+    }
+    for (uint64_t slot = header.slot_count; rc == GS_SUCCESS && slot-- > 0;) {
+        if (!bitmap_test(used, (uint32_t)slot))
+            rc = slot_list_push(&s->free_slots, (uint32_t)slot);
+    }
+
+    s->slot_count = header.slot_count;
+    s->index_slot = header.index_slot;
+    s->index_entries = header.index_entries;
+    s->index_checksum = header.index_checksum;
+    free(entries);
+    free(used);
+    return rc;
 }
 
-// Flush both bitmaps to the delta file header.
-static int delta_flush_bitmaps(storage_t *s) {
-    fseek(s->delta_fp, (long)s->bitmap_offset, SEEK_SET);
-    if (fwrite(s->bitmap, s->bitmap_bytes, 1, s->delta_fp) != 1)
+// Convert a version 1 delta (bitmaps, then a block area addressed by LBA) by
+// rewriting its committed blocks into a version 2 delta
+static int delta_migrate_v1(storage_t *s) {
+    off_t committed_at = DELTA_V1_HEADER + (off_t)s->bitmap_bytes;
+    off_t data_at = DELTA_V1_HEADER + 2 * (off_t)s->bitmap_bytes;
+    if (pread_full(s->delta_fd, s->committed_bitmap, s->bitmap_bytes, committed_at) != (ssize_t)s->bitmap_bytes)
         return GS_ERROR;
-    if (fwrite(s->committed_bitmap, s->bitmap_bytes, 1, s->delta_fp) != 1)
+
+    size_t count = 0;
+    for (uint64_t lba = 0; lba < s->block_count; lba++)
+        count += bitmap_test(s->committed_bitmap, (uint32_t)lba);
+    delta_entry_t *entries = (delta_entry_t *)malloc(count ? count * sizeof(delta_entry_t) : 1);
+    if (!entries)
         return GS_ERROR;
-    fflush(s->delta_fp);
+    size_t n = 0;
+    for (uint64_t lba = 0; lba < s->block_count; lba++) {
+        if (bitmap_test(s->committed_bitmap, (uint32_t)lba))
+            entries[n++] = (delta_entry_t){(uint32_t)lba, (uint32_t)lba};
+    }
+
+    int rc = delta_rewrite(s, entries, count, s->delta_fd, data_at);
+    free(entries);
+    if (rc != GS_SUCCESS)
+        return GS_ERROR;
+    memcpy(s->bitmap, s->committed_bitmap, s->bitmap_bytes);
+    LOG(1, "storage: migrated %s to delta version %d (%zu blocks)", s->delta_path, DELTA_VERSION, count);
     return GS_SUCCESS;
 }
 
-// Read both bitmaps from the delta file header.
-static int delta_read_bitmaps(storage_t *s) {
-    fseek(s->delta_fp, (long)s->bitmap_offset, SEEK_SET);
-    if (fread(s->bitmap, s->bitmap_bytes, 1, s->delta_fp) != 1)
+// Open an existing delta: check its geometry, then load or migrate it
+static int delta_open(storage_t *s) {
+    uint8_t head[DELTA_V1_HEADER];
+    if (pread_full(s->delta_fd, head, sizeof(head), 0) != (ssize_t)sizeof(head))
         return GS_ERROR;
-    if (fread(s->committed_bitmap, s->bitmap_bytes, 1, s->delta_fp) != 1)
+    uint32_t version, block_size;
+    uint64_t block_count;
+    memcpy(&version, head + 4, sizeof(version));
+    memcpy(&block_count, head + 8, sizeof(block_count));
+    memcpy(&block_size, head + 16, sizeof(block_size));
+    if (memcmp(head, DELTA_MAGIC, DELTA_MAGIC_SIZE) != 0 || block_count != s->block_count ||
+        block_size != s->block_size)
         return GS_ERROR;
+    if (version == DELTA_V1_VERSION)
+        return delta_migrate_v1(s);
+    if (version == DELTA_VERSION)
+        return delta_load(s);
+    return GS_ERROR;
+}
+
+// ============================================================================
+// Block cache
+// ============================================================================
+
+// Bucket of lba in the cache's hash table
+static inline uint32_t cache_bucket(const block_cache_t *c, uint32_t lba) {
+    return (lba * 2654435761u) & c->bucket_mask;
+}
+
+static inline uint8_t *cache_data(const storage_t *s, uint32_t idx) {
+    return s->cache.data + (size_t)idx * s->block_size;
+}
+
+// Entry holding lba, or CACHE_NONE
+static uint32_t cache_find(const block_cache_t *c, uint32_t lba) {
+    if (!c->capacity)
+        return CACHE_NONE;
+    for (uint32_t idx = c->buckets[cache_bucket(c, lba)]; idx != CACHE_NONE; idx = c->entries[idx].hash_next) {
+        if (c->entries[idx].lba == lba)
+            return idx;
+    }
+    return CACHE_NONE;
+}
+
+static void cache_lru_unlink(block_cache_t *c, uint32_t idx) {
+    cache_entry_t *e = &c->entries[idx];
+    if (e->prev != CACHE_NONE)
+        c->entries[e->prev].next = e->next;
+    else
+        c->head = e->next;
+    if (e->next != CACHE_NONE)
+        c->entries[e->next].prev = e->prev;
+    else
+        c->tail = e->prev;
+}
+
+// Make idx the most recently used entry
+static void cache_lru_push(block_cache_t *c, uint32_t idx) {
+    cache_entry_t *e = &c->entries[idx];
+    e->prev = CACHE_NONE;
+    e->next = c->head;
+    if (c->head != CACHE_NONE)
+        c->entries[c->head].prev = idx;
+    c->head = idx;
+    if (c->tail == CACHE_NONE)
+        c->tail = idx;
+}
+
+static void cache_hash_unlink(block_cache_t *c, uint32_t idx) {
+    uint32_t *link = &c->buckets[cache_bucket(c, c->entries[idx].lba)];
+    while (*link != idx)
+        link = &c->entries[*link].hash_next;
+    *link = c->entries[idx].hash_next;
+}
+
+// Store a block, evicting the least recently used one when the cache is full
+static void cache_insert(storage_t *s, uint32_t lba, const uint8_t *data) {
+    block_cache_t *c = &s->cache;
+    if (!c->capacity)
+        return;
+    uint32_t idx = cache_find(c, lba);
+    if (idx != CACHE_NONE) {
+        cache_lru_unlink(c, idx);
+    } else {
+        if (c->used < c->capacity) {
+            idx = c->used++;
+        } else {
+            idx = c->tail;
+            cache_lru_unlink(c, idx);
+            cache_hash_unlink(c, idx);
+        }
+        uint32_t bucket = cache_bucket(c, lba);
+        c->entries[idx].lba = lba;
+        c->entries[idx].hash_next = c->buckets[bucket];
+        c->buckets[bucket] = idx;
+    }
+    memcpy(cache_data(s, idx), data, s->block_size);
+    cache_lru_push(c, idx);
+}
+
+// Forget every block (their contents changed behind the cache's back)
+static void cache_invalidate(storage_t *s) {
+    block_cache_t *c = &s->cache;
+    c->used = 0;
+    c->head = c->tail = CACHE_NONE;
+    for (uint32_t i = 0; c->buckets && i <= c->bucket_mask; i++)
+        c->buckets[i] = CACHE_NONE;
+    c->ra_count = 0;
+}
+
+static void cache_free(block_cache_t *c) {
+    free(c->entries);
+    free(c->data);
+    free(c->buckets);
+    c->entries = NULL;
+    c->data = NULL;
+    c->buckets = NULL;
+    c->capacity = 0;
+}
+
+// Give the cache room for blocks blocks (0 turns it off), dropping its contents
+static int cache_resize(storage_t *s, size_t blocks) {
+    block_cache_t *c = &s->cache;
+    if (blocks > STORAGE_CACHE_MAX_BLOCKS)
+        return GS_ERROR;
+    cache_free(c);
+    if (blocks) {
+        uint32_t buckets = 1;
+        while (buckets < blocks)
+            buckets <<= 1;
+        c->entries = (cache_entry_t *)malloc(blocks * sizeof(cache_entry_t));
+        c->data = (uint8_t *)malloc(blocks * s->block_size);
+        c->buckets = (uint32_t *)malloc(buckets * sizeof(uint32_t));
+        if (!c->entries || !c->data || !c->buckets) {
+            cache_free(c);
+            return GS_ERROR;
+        }
+        c->capacity = (uint32_t)blocks;
+        c->bucket_mask = buckets - 1;
+    }
+    cache_invalidate(s);
     return GS_SUCCESS;
 }
 
@@ -266,18 +903,51 @@ static int delta_read_bitmaps(storage_t *s) {
 // Checkpoint stream callbacks
 // ============================================================================
 
+// Set up a run buffer for a stream of block_count blocks of block_size bytes
+static int checkpoint_stream_open(checkpoint_stream_ctx_t *c, checkpoint_t *checkpoint, uint64_t block_count,
+                                  uint32_t block_size) {
+    memset(c, 0, sizeof(*c));
+    c->checkpoint = checkpoint;
+    c->run_cap = (STORAGE_CHECKPOINT_RUN / block_size) * block_size;
+    c->remaining = block_count * block_size;
+    c->run = (uint8_t *)malloc(c->run_cap);
+    return c->run ? GS_SUCCESS : GS_ERROR;
+}
+
+// Write out the gathered part of the current run
+static int checkpoint_stream_flush(checkpoint_stream_ctx_t *c) {
+    if (c->run_used) {
+        system_write_checkpoint_data(c->checkpoint, c->run, c->run_used);
+        c->run_used = 0;
+    }
+    return checkpoint_has_error(c->checkpoint) ? GS_ERROR : GS_SUCCESS;
+}
+
 static int checkpoint_storage_write_cb(void *ctx, const void *data, size_t size) {
     checkpoint_stream_ctx_t *c = (checkpoint_stream_ctx_t *)ctx;
-    system_write_checkpoint_data(c->checkpoint, data, size);
-    return checkpoint_has_error(c->checkpoint) ? -1 : 0;
+    memcpy(c->run + c->run_used, data, size);
+    c->run_used += size;
+    if (c->run_used >= c->run_cap)
+        return checkpoint_stream_flush(c) == GS_SUCCESS ? 0 : -1;
+    return 0;
 }
 
 static int checkpoint_storage_read_cb(void *ctx, void *data, size_t size) {
     checkpoint_stream_ctx_t *c = (checkpoint_stream_ctx_t *)ctx;
-    system_read_checkpoint_data(c->checkpoint, data, size);
+    if (c->run_pos == c->run_used) {
+        // Next run: the writer cut them at the same boundaries
+        c->run_used = c->remaining < c->run_cap ? (size_t)c->remaining : c->run_cap;
+        c->run_pos = 0;
+        c->remaining -= c->run_used;
+        system_read_checkpoint_data(c->checkpoint, c->run, c->run_used);
+    }
     // Negative on error so read_exact can distinguish "I/O error" from
     // "EOF / zero-byte read".
-    return checkpoint_has_error(c->checkpoint) ? -1 : (int)size;
+    if (checkpoint_has_error(c->checkpoint) || c->run_used - c->run_pos < size)
+        return -1;
+    memcpy(data, c->run + c->run_pos, size);
+    c->run_pos += size;
+    return (int)size;
 }
 
 // ============================================================================
@@ -303,24 +973,31 @@ int storage_new(const storage_config_t *config, storage_t **out_storage) {
     storage_t *s = calloc(1, sizeof(storage_t));
     if (!s)
         return GS_ERROR;
+    s->base_fd = s->delta_fd = s->journal_fd = -1;
 
     s->block_count = config->block_count;
     s->block_size = config->block_size;
     s->bitmap_bytes = (size_t)((config->block_count + 7) / 8);
-    s->bitmap_offset = DELTA_HEADER_SIZE;
-    s->data_offset = DELTA_HEADER_SIZE + 2 * s->bitmap_bytes;
     s->base_data_offset = config->base_data_offset;
+    s->slot_page_count = (size_t)((config->block_count + SLOT_PAGE_SIZE - 1) >> SLOT_PAGE_BITS);
 
-    // Allocate bitmaps
+    // Allocate bitmaps and the slot page table
     s->bitmap = calloc(1, s->bitmap_bytes);
     s->committed_bitmap = calloc(1, s->bitmap_bytes);
-    if (!s->bitmap || !s->committed_bitmap)
+    s->slot_pages = calloc(s->slot_page_count, sizeof(uint32_t *));
+    s->delta_path = strdup(config->delta_path);
+    if (!s->bitmap || !s->committed_bitmap || !s->slot_pages || !s->delta_path)
         goto fail;
 
-    // Open base file (read-only, optional — NULL for brand-new images)
-    if (config->base_path) {
+    // Open base file (read-only, optional — NULL for brand-new images).  A
+    // decoded base is read through its callback instead.
+    s->base_read = config->base_read;
+    s->base_context = config->base_context;
+    if (config->base_path && !s->base_read) {
         s->base_fp = fopen(config->base_path, "rb");
         // base_fp can be NULL if base doesn't exist yet (new image)
+        if (s->base_fp)
+            s->base_fd = fileno(s->base_fp);
     }
 
     // Open or create delta file. Try the "existing" path first so an
@@ -336,18 +1013,15 @@ int storage_new(const storage_config_t *config, storage_t **out_storage) {
     }
     if (!s->delta_fp)
         goto fail;
+    s->delta_fd = fileno(s->delta_fp);
 
     if (delta_exists) {
-        // Read and validate existing header + bitmaps
-        if (delta_read_header(s) != GS_SUCCESS)
-            goto fail;
-        if (delta_read_bitmaps(s) != GS_SUCCESS)
+        // Validate the header, then load the index (or migrate a version 1 delta)
+        if (delta_open(s) != GS_SUCCESS)
             goto fail;
     } else {
-        // Write fresh header + empty bitmaps
-        if (delta_write_header(s) != GS_SUCCESS)
-            goto fail;
-        if (delta_flush_bitmaps(s) != GS_SUCCESS)
+        // Fresh header: empty extent area, empty index
+        if (delta_write_header(s, s->delta_fd, 0, 0, 0, index_checksum(NULL, 0)) != GS_SUCCESS)
             goto fail;
     }
 
@@ -355,10 +1029,14 @@ int storage_new(const storage_config_t *config, storage_t **out_storage) {
     s->journal_fp = fopen(config->journal_path, "a+b");
     if (!s->journal_fp)
         goto fail;
+    s->journal_fd = fileno(s->journal_fp);
 
     // Load journal index (does not replay — caller decides)
     journal_load_index(s);
 
+    if (cache_resize(s, g_default_cache_blocks) != GS_SUCCESS)
+        goto fail;
+
     *out_storage = s;
     return GS_SUCCESS;
 
@@ -379,7 +1057,14 @@ int storage_delete(storage_t *storage) {
         fclose(storage->journal_fp);
     free(storage->bitmap);
     free(storage->committed_bitmap);
+    for (size_t i = 0; storage->slot_pages && i < storage->slot_page_count; i++)
+        free(storage->slot_pages[i]);
+    free(storage->slot_pages);
+    free(storage->free_slots.items);
+    free(storage->pending_slots.items);
+    free(storage->delta_path);
     free(storage->journal_lbas);
+    cache_free(&storage->cache);
     free(storage);
     return GS_SUCCESS;
 }
@@ -388,72 +1073,252 @@ int storage_delete(storage_t *storage) {
 // Public API: Block I/O
 // ============================================================================
 
-int storage_read_block(storage_t *storage, size_t offset, void *buffer) {
-    if (!storage || !buffer)
-        return GS_ERROR;
+// Validate a request for count blocks at byte offset; *lba receives the first block
+static int block_range(const storage_t *storage, size_t offset, size_t count, uint32_t *lba) {
     if (offset % storage->block_size != 0)
         return GS_ERROR;
-
-    uint64_t lba64 = offset / storage->block_size;
-    if (lba64 >= storage->block_count)
+    uint64_t first = offset / storage->block_size;
+    if (first >= storage->block_count || count > storage->block_count - first)
         return GS_ERROR;
-    uint32_t lba = (uint32_t)lba64;
+    *lba = (uint32_t)first;
+    return GS_SUCCESS;
+}
 
-    if (bitmap_test(storage->bitmap, lba)) {
-        // Modified block — read from delta
-        fseek(storage->delta_fp, (long)(storage->data_offset + (size_t)lba * storage->block_size), SEEK_SET);
-        if (fread(buffer, storage->block_size, 1, storage->delta_fp) != 1) {
-            memset(buffer, 0, storage->block_size);
-            return GS_ERROR;
-        }
-    } else if (storage->base_fp) {
-        // Unmodified block — read from base image
-        fseek(storage->base_fp, (long)(storage->base_data_offset + (size_t)lba * storage->block_size), SEEK_SET);
-        if (fread(buffer, storage->block_size, 1, storage->base_fp) != 1) {
-            memset(buffer, 0, storage->block_size);
+// Length of the run of blocks from lba (at most count) whose bit in bm equals that of lba
+static size_t bitmap_run(const uint8_t *bm, uint32_t lba, size_t count) {
+    bool set = bitmap_test(bm, lba);
+    size_t n = 1;
+    while (n < count && bitmap_test(bm, lba + (uint32_t)n) == set)
+        n++;
+    return n;
+}
+
+// Length of the run of blocks from lba (at most count) that one pread can
+// serve: all from the base, or all in consecutive delta slots
+static size_t read_run(const storage_t *s, uint32_t lba, size_t count) {
+    size_t n = bitmap_run(s->bitmap, lba, count);
+    if (!bitmap_test(s->bitmap, lba))
+        return n;
+    uint32_t slot = slot_lookup(s, lba);
+    size_t run = 1;
+    while (run < n && slot && slot_lookup(s, lba + (uint32_t)run) == slot + run)
+        run++;
+    return run;
+}
+
+// Read count blocks from the delta and base files, bypassing the cache
+static int read_blocks_direct(storage_t *storage, uint32_t lba, uint8_t *out, size_t count) {
+    size_t bs = storage->block_size;
+    while (count > 0) {
+        // One pread per run of blocks that are contiguous in one file
+        size_t n = read_run(storage, lba, count);
+        size_t len = n * bs;
+        if (bitmap_test(storage->bitmap, lba)) {
+            // Modified blocks — read from delta
+            uint32_t slot = slot_lookup(storage, lba);
+            if (!slot ||
+                pread_full(storage->delta_fd, out, len, delta_slot_offset(storage, slot - 1)) != (ssize_t)len) {
+                memset(out, 0, len);
+                return GS_ERROR;
+            }
+        } else if (storage->base_read) {
+            // Unmodified blocks of a decoded base (e.g. compressed chunks)
+            if (storage->base_read(storage->base_context, (uint64_t)lba * bs, out, len) != GS_SUCCESS) {
+                memset(out, 0, len);
+                return GS_ERROR;
+            }
+        } else if (storage->base_fd >= 0) {
+            // Unmodified blocks — read from base image; blocks past its end read as zeros
+            off_t at = (off_t)storage->base_data_offset + (off_t)lba * (off_t)bs;
+            ssize_t got = pread_full(storage->base_fd, out, len, at);
+            size_t whole = got > 0 ? (size_t)got - (size_t)got % bs : 0;
+            if (whole < len)
+                memset(out + whole, 0, len - whole);
+        } else {
+            // No base file — unwritten blocks are zeros
+            memset(out, 0, len);
         }
-    } else {
-        // No base file — unwritten block is zeros
-        memset(buffer, 0, storage->block_size);
+        out += len;
+        lba += (uint32_t)n;
+        count -= n;
     }
 
     return GS_SUCCESS;
 }
 
-int storage_write_block(storage_t *storage, size_t offset, const void *buffer) {
+// Note a read of count blocks at lba.  Once a reader has gone
+// READAHEAD_TRIGGER blocks in sequence, the blocks ahead of it are queued
+// for storage_tick and the host is told they will be needed.
+static void readahead_track(storage_t *s, uint32_t lba, size_t count) {
+    block_cache_t *c = &s->cache;
+    uint64_t run = lba == c->seq_next ? (uint64_t)c->seq_blocks + count : count;
+    c->seq_blocks = run < UINT32_MAX ? (uint32_t)run : UINT32_MAX;
+    c->seq_next = lba + (uint32_t)count;
+    if (c->seq_blocks < READAHEAD_TRIGGER || c->seq_next >= s->block_count)
+        return;
+
+    // Stay up to a window ahead of the reader, not re-queuing what is queued already
+    uint64_t window = c->capacity / 4 < READAHEAD_MAX ? c->capacity / 4 : READAHEAD_MAX;
+    uint64_t start = c->ra_end > c->seq_next ? c->ra_end : c->seq_next;
+    uint64_t end = (uint64_t)c->seq_next + window;
+    if (end > s->block_count)
+        end = s->block_count;
+    if (start >= end)
+        return;
+    if (c->ra_count && (uint64_t)c->ra_lba + c->ra_count == start && end - c->ra_lba <= 2 * READAHEAD_MAX)
+        c->ra_count = (uint32_t)(end - c->ra_lba);
+    else
+        c->ra_lba = (uint32_t)start, c->ra_count = (uint32_t)(end - start);
+    c->ra_end = (uint32_t)end;
+#ifdef POSIX_FADV_WILLNEED
+    if (s->base_fd >= 0)
+        posix_fadvise(s->base_fd, (off_t)s->base_data_offset + (off_t)start * s->block_size,
+                      (off_t)(end - start) * s->block_size, POSIX_FADV_WILLNEED);
+#endif
+}
+
+// Load the queued readahead blocks that are not cached yet
+static void readahead_fill(storage_t *s) {
+    block_cache_t *c = &s->cache;
+    uint32_t lba = c->ra_lba, end = c->ra_lba + c->ra_count;
+    c->ra_count = 0;
+    uint8_t *run = (uint8_t *)malloc((size_t)READAHEAD_MAX * s->block_size);
+    while (run && lba < end) {
+        if (cache_find(c, lba) != CACHE_NONE) {
+            lba++;
+            continue;
+        }
+        uint32_t n = 1;
+        while (lba + n < end && n < READAHEAD_MAX && cache_find(c, lba + n) == CACHE_NONE)
+            n++;
+        if (read_blocks_direct(s, lba, run, n) != GS_SUCCESS)
+            break;
+        for (uint32_t i = 0; i < n; i++)
+            cache_insert(s, lba + i, run + (size_t)i * s->block_size);
+        c->readahead += n;
+        lba += n;
+    }
+    free(run);
+}
+
+int storage_read_blocks(storage_t *storage, size_t offset, void *buffer, size_t count) {
     if (!storage || !buffer)
         return GS_ERROR;
-    if (offset % storage->block_size != 0)
+    uint32_t lba;
+    if (block_range(storage, offset, count, &lba) != GS_SUCCESS)
         return GS_ERROR;
+    block_cache_t *c = &storage->cache;
+    if (!c->capacity)
+        return read_blocks_direct(storage, lba, (uint8_t *)buffer, count);
+
+    // Cached blocks are copied out, each run of missing ones is a single read
+    uint8_t *out = (uint8_t *)buffer;
+    size_t bs = storage->block_size;
+    for (size_t i = 0; i < count;) {
+        uint32_t idx = cache_find(c, lba + (uint32_t)i);
+        if (idx != CACHE_NONE) {
+            memcpy(out + i * bs, cache_data(storage, idx), bs);
+            cache_lru_unlink(c, idx);
+            cache_lru_push(c, idx);
+            c->hits++;
+            i++;
+            continue;
+        }
+        size_t n = 1;
+        while (i + n < count && cache_find(c, lba + (uint32_t)(i + n)) == CACHE_NONE)
+            n++;
+        if (read_blocks_direct(storage, lba + (uint32_t)i, out + i * bs, n) != GS_SUCCESS)
+            return GS_ERROR;
+        for (size_t k = 0; k < n; k++)
+            cache_insert(storage, lba + (uint32_t)(i + k), out + (i + k) * bs);
+        c->misses += n;
+        i += n;
+    }
+    readahead_track(storage, lba, count);
+    return GS_SUCCESS;
+}
 
-    uint64_t lba64 = offset / storage->block_size;
-    if (lba64 >= storage->block_count)
+int storage_write_blocks(storage_t *storage, size_t offset, const void *buffer, size_t count) {
+    if (!storage || !buffer)
         return GS_ERROR;
-    uint32_t lba = (uint32_t)lba64;
+    uint32_t lba;
+    if (block_range(storage, offset, count, &lba) != GS_SUCCESS)
+        return GS_ERROR;
+    if (count == 0)
+        return GS_SUCCESS;
 
-    // Capture preimage if this block was committed and not yet journaled
-    if (bitmap_test(storage->committed_bitmap, lba) && !journal_has_lba(storage, lba)) {
-        uint8_t old[STORAGE_MAX_BLOCK_SIZE];
-        fseek(storage->delta_fp, (long)(storage->data_offset + (size_t)lba * storage->block_size), SEEK_SET);
-        if (fread(old, storage->block_size, 1, storage->delta_fp) != 1) {
+    // Capture preimages of committed blocks not yet journaled, a run of
+    // consecutive slots at a time (committed blocks always have a slot)
+    uint8_t *old = NULL;
+    size_t bs = storage->block_size;
+    for (size_t i = 0; i < count;) {
+        uint32_t at = lba + (uint32_t)i;
+        uint32_t slot = slot_lookup(storage, at);
+        if (!bitmap_test(storage->committed_bitmap, at) || journal_has_lba(storage, at)) {
+            i++;
+            continue;
+        }
+        size_t n = 1;
+        while (i + n < count && n < PREIMAGE_BATCH && bitmap_test(storage->committed_bitmap, at + (uint32_t)n) &&
+               !journal_has_lba(storage, at + (uint32_t)n) && slot_lookup(storage, at + (uint32_t)n) == slot + n)
+            n++;
+        if (!old && !(old = (uint8_t *)malloc(PREIMAGE_BATCH * bs)))
+            return GS_ERROR;
+        if (!slot ||
+            pread_full(storage->delta_fd, old, n * bs, delta_slot_offset(storage, slot - 1)) != (ssize_t)(n * bs) ||
+            journal_append(storage, at, old, n) != GS_SUCCESS) {
+            free(old);
             return GS_ERROR;
         }
-        if (journal_append(storage, lba, old) != GS_SUCCESS)
+        i += n;
+    }
+    free(old);
+
+    // Blocks new to the delta get slots; a run into fresh slots is contiguous
+    for (size_t i = 0; i < count; i++) {
+        uint32_t at = lba + (uint32_t)i, slot;
+        if (slot_lookup(storage, at))
+            continue;
+        if (slot_alloc(storage, &slot) != GS_SUCCESS || slot_map(storage, at, slot) != GS_SUCCESS)
             return GS_ERROR;
+        storage->map_dirty = true;
     }
 
-    // Write new data to delta
-    fseek(storage->delta_fp, (long)(storage->data_offset + (size_t)lba * storage->block_size), SEEK_SET);
-    if (fwrite(buffer, storage->block_size, 1, storage->delta_fp) != 1)
-        return GS_ERROR;
+    // Write new data to delta, one pwrite per run of consecutive slots
+    const uint8_t *in = (const uint8_t *)buffer;
+    for (size_t i = 0; i < count;) {
+        uint32_t slot = slot_lookup(storage, lba + (uint32_t)i);
+        size_t n = 1;
+        while (i + n < count && slot_lookup(storage, lba + (uint32_t)(i + n)) == slot + n)
+            n++;
+        if (pwrite_full(storage->delta_fd, in + i * bs, n * bs, delta_slot_offset(storage, slot - 1)) != GS_SUCCESS) {
+            cache_invalidate(storage); // some of the range may have been written
+            return GS_ERROR;
+        }
+        i += n;
+    }
 
-    // Update bitmap in memory (flushed to disk at checkpoint time)
-    bitmap_set(storage->bitmap, lba);
+    // Update bitmap in memory (the index is written at checkpoint time), and
+    // the cached copies of the blocks (write-through, no allocation)
+    for (size_t i = 0; i < count; i++) {
+        bitmap_set(storage->bitmap, lba + (uint32_t)i);
+        uint32_t idx = cache_find(&storage->cache, lba + (uint32_t)i);
+        if (idx != CACHE_NONE)
+            memcpy(cache_data(storage, idx), in + i * bs, bs);
+    }
     storage->bitmap_dirty = true;
 
     return GS_SUCCESS;
 }
 
+int storage_read_block(storage_t *storage, size_t offset, void *buffer) {
+    return storage_read_blocks(storage, offset, buffer, 1);
+}
+
+int storage_write_block(storage_t *storage, size_t offset, const void *buffer) {
+    return storage_write_blocks(storage, offset, buffer, 1);
+}
+
 // ============================================================================
 // Public API: Rollback
 // ============================================================================
@@ -461,11 +1326,14 @@ int storage_write_block(storage_t *storage, size_t offset, const void *buffer) {
 int storage_apply_rollback(storage_t *storage) {
     if (!storage)
         return GS_ERROR;
-    if (storage->journal_count == 0)
+    // Blocks first mapped since the commit have no preimage, so an empty
+    // journal alone does not mean there is nothing to undo
+    if (storage->journal_count == 0 && memcmp(storage->bitmap, storage->committed_bitmap, storage->bitmap_bytes) == 0)
         return GS_SUCCESS;
 
     // Replay journal: restore preimages to delta
-    fseek(storage->journal_fp, 0, SEEK_SET);
+    if (storage->journal_count > 0)
+        fseek(storage->journal_fp, 0, SEEK_SET);
     for (size_t i = 0; i < storage->journal_count; i++) {
         uint32_t lba;
         uint8_t data[STORAGE_MAX_BLOCK_SIZE];
@@ -475,17 +1343,19 @@ int storage_apply_rollback(storage_t *storage) {
         if (fread(data, storage->block_size, 1, storage->journal_fp) != 1)
             return GS_ERROR;
 
-        // Write preimage back to delta
-        fseek(storage->delta_fp, (long)(storage->data_offset + (size_t)lba * storage->block_size), SEEK_SET);
-        if (fwrite(data, storage->block_size, 1, storage->delta_fp) != 1)
+        // Write preimage back to the block's slot
+        uint32_t slot = lba < storage->block_count ? slot_lookup(storage, lba) : 0;
+        if (!slot || pwrite_full(storage->delta_fd, data, storage->block_size, delta_slot_offset(storage, slot - 1)) !=
+                         GS_SUCCESS)
             return GS_ERROR;
     }
 
     // Restore bitmap to committed state
     memcpy(storage->bitmap, storage->committed_bitmap, storage->bitmap_bytes);
+    cache_invalidate(storage);
 
-    // Flush bitmaps and truncate journal
-    if (delta_flush_bitmaps(storage) != GS_SUCCESS)
+    // Release the slots of blocks written since the commit, then truncate journal
+    if (storage->map_dirty && delta_commit(storage) != GS_SUCCESS)
         return GS_ERROR;
 
     // Truncate journal. If ftruncate fails, leave journal_count alone so the
@@ -510,12 +1380,15 @@ int storage_clear_rollback(storage_t *storage) {
         return GS_ERROR;
 
     // Update in-memory committed bitmap
+    bool changed = storage->map_dirty || memcmp(storage->committed_bitmap, storage->bitmap, storage->bitmap_bytes) != 0;
     memcpy(storage->committed_bitmap, storage->bitmap, storage->bitmap_bytes);
 
     // Only do OPFS I/O if something changed since last commit.
-    // This makes back-to-back checkpoints with no intervening writes free.
+    // This makes back-to-back checkpoints with no intervening writes free,
+    // and blocks rewritten in place need no new index.
     if (storage->bitmap_dirty || storage->journal_count > 0) {
-        delta_flush_bitmaps(storage);
+        if (changed && delta_commit(storage) != GS_SUCCESS)
+            return GS_ERROR;
         storage->bitmap_dirty = false;
 
         if (storage->journal_count > 0 && storage->journal_fp) {
@@ -530,6 +1403,89 @@ int storage_clear_rollback(storage_t *storage) {
     return GS_SUCCESS;
 }
 
+// ============================================================================
+// History snapshots
+// ============================================================================
+
+// Write the current bitmap, then every run of STORAGE_CHECKPOINT_RUN bytes
+// that holds a modified block (unmodified blocks in it as zeros).  Runs that
+// did not change since the previous snapshot share their pool objects.
+static int storage_save_delta(storage_t *storage, checkpoint_t *checkpoint) {
+    system_write_checkpoint_data(checkpoint, storage->bitmap, storage->bitmap_bytes);
+    uint32_t per_run = STORAGE_CHECKPOINT_RUN / storage->block_size;
+    uint8_t *run = (uint8_t *)malloc((size_t)per_run * storage->block_size);
+    if (!run)
+        return GS_ERROR;
+    for (uint64_t first = 0; first < storage->block_count && !checkpoint_has_error(checkpoint); first += per_run) {
+        uint64_t n = storage->block_count - first < per_run ? storage->block_count - first : per_run;
+        if (!bitmap_any(storage->bitmap, first, n))
+            continue;
+        // Modified blocks a run at a time, the others as zeros
+        for (size_t i = 0; i < n;) {
+            uint32_t lba = (uint32_t)(first + i);
+            size_t len = bitmap_run(storage->bitmap, lba, (size_t)n - i);
+            uint8_t *dst = run + i * storage->block_size;
+            if (bitmap_test(storage->bitmap, lba))
+                read_blocks_direct(storage, lba, dst, len);
+            else
+                memset(dst, 0, len * storage->block_size);
+            i += len;
+        }
+        system_write_checkpoint_data(checkpoint, run, (size_t)n * storage->block_size);
+    }
+    free(run);
+    return checkpoint_has_error(checkpoint) ? GS_ERROR : GS_SUCCESS;
+}
+
+// Read a history snapshot (storage NULL = discard it).  Blocks it modified
+// are written back where they differ, through storage_write_block so a later
+// quick-checkpoint rollback still finds their preimages; blocks modified only
+// since the snapshot fall back to the base image.
+static int storage_load_delta(storage_t *storage, checkpoint_t *checkpoint, const storage_snapshot_header_t *header) {
+    if (header->block_size == 0 || header->block_size > STORAGE_MAX_BLOCK_SIZE || header->block_count > UINT32_MAX)
+        return GS_ERROR;
+    size_t bitmap_bytes = (size_t)((header->block_count + 7) / 8);
+    uint32_t per_run = STORAGE_CHECKPOINT_RUN / header->block_size;
+    uint8_t *bitmap = (uint8_t *)malloc(bitmap_bytes ? bitmap_bytes : 1);
+    uint8_t *run = (uint8_t *)malloc((size_t)per_run * header->block_size);
+    uint8_t current[STORAGE_MAX_BLOCK_SIZE];
+    int rc = bitmap && run ? GS_SUCCESS : GS_ERROR;
+    if (rc == GS_SUCCESS)
+        system_read_checkpoint_data(checkpoint, bitmap, bitmap_bytes);
+    for (uint64_t first = 0; rc == GS_SUCCESS && first < header->block_count; first += per_run) {
+        if (checkpoint_has_error(checkpoint)) {
+            rc = GS_ERROR;
+            break;
+        }
+        uint64_t n = header->block_count - first < per_run ? header->block_count - first : per_run;
+        if (!bitmap_any(bitmap, first, n))
+            continue;
+        system_read_checkpoint_data(checkpoint, run, (size_t)n * header->block_size);
+        for (uint64_t i = 0; storage && rc == GS_SUCCESS && i < n; i++) {
+            uint32_t lba = (uint32_t)(first + i);
+            const uint8_t *data = run + i * header->block_size;
+            size_t offset = (size_t)lba * header->block_size;
+            if (!bitmap_test(bitmap, lba))
+                continue;
+            if (bitmap_test(storage->bitmap, lba) && storage_read_block(storage, offset, current) == GS_SUCCESS &&
+                memcmp(current, data, header->block_size) == 0)
+                continue;
+            rc = storage_write_block(storage, offset, data);
+        }
+    }
+    if (rc == GS_SUCCESS && checkpoint_has_error(checkpoint))
+        rc = GS_ERROR;
+    if (rc == GS_SUCCESS && storage && memcmp(storage->bitmap, bitmap, bitmap_bytes) != 0) {
+        // Blocks modified only since the snapshot read from the base again
+        memcpy(storage->bitmap, bitmap, bitmap_bytes);
+        storage->bitmap_dirty = true;
+        cache_invalidate(storage);
+    }
+    free(bitmap);
+    free(run);
+    return rc;
+}
+
 // ============================================================================
 // Public API: Checkpointing
 // ============================================================================
@@ -545,17 +1501,29 @@ int storage_checkpoint(storage_t *storage, checkpoint_t *checkpoint) {
     // Write snapshot header
     storage_snapshot_header_t header = {0};
     header.version = STORAGE_SNAPSHOT_VERSION;
-    header.has_data = (checkpoint_get_kind(checkpoint) == CHECKPOINT_KIND_CONSOLIDATED) ? 1 : 0;
+    checkpoint_kind_t kind = checkpoint_get_kind(checkpoint);
+    header.has_data = kind == CHECKPOINT_KIND_CONSOLIDATED ? SNAPSHOT_BLOCKS
+                      : kind == CHECKPOINT_KIND_HISTORY    ? SNAPSHOT_DELTA
+                                                           : SNAPSHOT_BITMAP;
     header.block_count = storage->block_count;
     header.block_size = storage->block_size;
     system_write_checkpoint_data(checkpoint, &header, sizeof(header));
     if (checkpoint_has_error(checkpoint))
         return GS_ERROR;
 
-    if (header.has_data) {
+    // History: nothing is committed, the quick checkpoint's rollback stays intact
+    if (header.has_data == SNAPSHOT_DELTA)
+        return storage_save_delta(storage, checkpoint);
+
+    if (header.has_data == SNAPSHOT_BLOCKS) {
         // Consolidated: stream all blocks
-        checkpoint_stream_ctx_t ctx = {checkpoint};
+        checkpoint_stream_ctx_t ctx;
+        if (checkpoint_stream_open(&ctx, checkpoint, storage->block_count, storage->block_size) != GS_SUCCESS)
+            return GS_ERROR;
         int rc = storage_save_state(storage, &ctx, checkpoint_storage_write_cb);
+        if (rc == GS_SUCCESS)
+            rc = checkpoint_stream_flush(&ctx);
+        free(ctx.run);
         if (rc != GS_SUCCESS)
             return rc;
     } else {
@@ -570,14 +1538,23 @@ int storage_checkpoint(storage_t *storage, checkpoint_t *checkpoint) {
 
 // Helper: skip/discard snapshot data from a checkpoint stream
 static int storage_skip_snapshot(checkpoint_t *checkpoint, const storage_snapshot_header_t *header) {
-    if (header->has_data) {
-        // Skip all block data
-        uint8_t discard[STORAGE_MAX_BLOCK_SIZE];
-        for (uint64_t i = 0; i < header->block_count; i++) {
-            system_read_checkpoint_data(checkpoint, discard, header->block_size);
-            if (checkpoint_has_error(checkpoint))
-                return GS_ERROR;
+    if (header->has_data == SNAPSHOT_DELTA)
+        return storage_load_delta(NULL, checkpoint, header);
+    if (header->has_data == SNAPSHOT_BLOCKS) {
+        // Skip all block data, a run at a time
+        if (header->block_size == 0 || header->block_size > STORAGE_MAX_BLOCK_SIZE)
+            return GS_ERROR;
+        checkpoint_stream_ctx_t ctx;
+        if (checkpoint_stream_open(&ctx, checkpoint, header->block_count, header->block_size) != GS_SUCCESS)
+            return GS_ERROR;
+        while (ctx.remaining > 0 && !checkpoint_has_error(checkpoint)) {
+            size_t n = ctx.remaining < ctx.run_cap ? (size_t)ctx.remaining : ctx.run_cap;
+            system_read_checkpoint_data(checkpoint, ctx.run, n);
+            ctx.remaining -= n;
         }
+        free(ctx.run);
+        if (checkpoint_has_error(checkpoint))
+            return GS_ERROR;
     } else {
         // Skip bitmap
         size_t bm = (size_t)((header->block_count + 7) / 8);
@@ -617,10 +1594,17 @@ int storage_restore_from_checkpoint(storage_t *storage, checkpoint_t *checkpoint
         return GS_ERROR;
     }
 
-    if (header.has_data) {
+    if (header.has_data == SNAPSHOT_DELTA)
+        return storage_load_delta(storage, checkpoint, &header);
+
+    if (header.has_data == SNAPSHOT_BLOCKS) {
         // Consolidated: load all blocks
-        checkpoint_stream_ctx_t ctx = {checkpoint};
-        return storage_load_state(storage, &ctx, checkpoint_storage_read_cb);
+        checkpoint_stream_ctx_t ctx;
+        if (checkpoint_stream_open(&ctx, checkpoint, storage->block_count, storage->block_size) != GS_SUCCESS)
+            return GS_ERROR;
+        int rc = storage_load_state(storage, &ctx, checkpoint_storage_read_cb);
+        free(ctx.run);
+        return rc;
     }
 
     // Quick checkpoint: the delta may have been modified AFTER the checkpoint
@@ -636,9 +1620,18 @@ int storage_restore_from_checkpoint(storage_t *storage, checkpoint_t *checkpoint
     if (checkpoint_has_error(checkpoint))
         return GS_ERROR;
 
+    // Blocks without a slot were dropped from the delta since the checkpoint
+    // was taken; they read from the base again
+    for (uint64_t lba = 0; lba < storage->block_count; lba++) {
+        if (bitmap_test(storage->bitmap, (uint32_t)lba) && !slot_lookup(storage, (uint32_t)lba))
+            bitmap_clear(storage->bitmap, (uint32_t)lba);
+    }
+
     // Commit: the delta data now matches this bitmap
     memcpy(storage->committed_bitmap, storage->bitmap, storage->bitmap_bytes);
-    delta_flush_bitmaps(storage);
+    cache_invalidate(storage);
+    if (delta_commit(storage) != GS_SUCCESS)
+        return GS_ERROR;
 
     // Truncate journal. If ftruncate fails, leave journal_count alone so the
     // in-memory index still matches whatever stayed on disk; otherwise reset.
@@ -665,16 +1658,63 @@ int storage_save_state(storage_t *storage, void *context, storage_write_callback
     if (!storage || !context || !write_cb)
         return GS_ERROR;
 
-    uint8_t buffer[STORAGE_MAX_BLOCK_SIZE];
-    for (uint64_t block = 0; block < storage->block_count; block++) {
-        size_t offset = (size_t)block * storage->block_size;
-        int rc = storage_read_block(storage, offset, buffer);
-        if (rc != GS_SUCCESS)
-            return rc;
-        if (write_cb(context, buffer, storage->block_size) != 0)
-            return GS_ERROR;
+    // Read a run of blocks at a time, hand them to write_cb one by one
+    size_t per_run = STORAGE_CHECKPOINT_RUN / storage->block_size;
+    uint8_t *run = (uint8_t *)malloc(per_run * storage->block_size);
+    if (!run)
+        return GS_ERROR;
+    int rc = GS_SUCCESS;
+    for (uint64_t block = 0; rc == GS_SUCCESS && block < storage->block_count; block += per_run) {
+        size_t n = storage->block_count - block < per_run ? (size_t)(storage->block_count - block) : per_run;
+        rc = read_blocks_direct(storage, (uint32_t)block, run, n);
+        for (size_t i = 0; rc == GS_SUCCESS && i < n; i++) {
+            if (write_cb(context, run + i * storage->block_size, storage->block_size) != 0)
+                rc = GS_ERROR;
+        }
     }
-    return GS_SUCCESS;
+    free(run);
+    return rc;
+}
+
+int storage_changed_runs(storage_t *storage, void *context, storage_run_callback_t run_cb) {
+    if (!storage || !run_cb)
+        return GS_ERROR;
+
+    // Changed = mapped since the commit, plus committed blocks rewritten since
+    // (those are exactly the ones with a preimage in the journal)
+    uint8_t *changed = (uint8_t *)malloc(storage->bitmap_bytes ? storage->bitmap_bytes : 1);
+    size_t per_run = STORAGE_CHECKPOINT_RUN / storage->block_size;
+    uint8_t *run = (uint8_t *)malloc(per_run * storage->block_size);
+    if (!changed || !run) {
+        free(changed);
+        free(run);
+        return GS_ERROR;
+    }
+    for (size_t i = 0; i < storage->bitmap_bytes; i++)
+        changed[i] = storage->bitmap[i] & (uint8_t)~storage->committed_bitmap[i];
+    for (size_t i = 0; i < storage->journal_count; i++) {
+        if (storage->journal_lbas[i] < storage->block_count)
+            bitmap_set(changed, storage->journal_lbas[i]);
+    }
+
+    int rc = GS_SUCCESS;
+    for (uint64_t lba = 0; rc == GS_SUCCESS && lba < storage->block_count;) {
+        if (!changed[lba >> 3] && (lba & 7) == 0) {
+            lba += 8;
+            continue;
+        }
+        uint64_t left = storage->block_count - lba;
+        size_t n = bitmap_run(changed, (uint32_t)lba, left < per_run ? (size_t)left : per_run);
+        if (bitmap_test(changed, (uint32_t)lba)) {
+            rc = read_blocks_direct(storage, (uint32_t)lba, run, n);
+            if (rc == GS_SUCCESS && run_cb(context, lba, run, n) != 0)
+                rc = GS_ERROR;
+        }
+        lba += n;
+    }
+    free(changed);
+    free(run);
+    return rc;
 }
 
 static int read_exact(storage_read_callback_t read_cb, void *context, void *buf, size_t size) {
@@ -692,17 +1732,25 @@ int storage_load_state(storage_t *storage, void *context, storage_read_callback_
             return GS_ERROR;
 
         // Write to delta
-        size_t off = storage->data_offset + (size_t)block * storage->block_size;
-        fseek(storage->delta_fp, (long)off, SEEK_SET);
-        if (fwrite(buffer, storage->block_size, 1, storage->delta_fp) != 1)
+        uint32_t slot = slot_lookup(storage, (uint32_t)block);
+        if (!slot) {
+            if (slot_alloc(storage, &slot) != GS_SUCCESS || slot_map(storage, (uint32_t)block, slot) != GS_SUCCESS)
+                return GS_ERROR;
+            storage->map_dirty = true;
+            slot++;
+        }
+        if (pwrite_full(storage->delta_fd, buffer, storage->block_size, delta_slot_offset(storage, slot - 1)) !=
+            GS_SUCCESS)
             return GS_ERROR;
 
         bitmap_set(storage->bitmap, (uint32_t)block);
     }
 
-    // Commit: bitmaps → delta, clear journal
+    // Commit: index → delta, clear journal
     memcpy(storage->committed_bitmap, storage->bitmap, storage->bitmap_bytes);
-    delta_flush_bitmaps(storage);
+    cache_invalidate(storage);
+    if (delta_commit(storage) != GS_SUCCESS)
+        return GS_ERROR;
 
     if (storage->journal_fp) {
         int fd = fileno(storage->journal_fp);
@@ -720,6 +1768,58 @@ int storage_load_state(storage_t *storage, void *context, storage_read_callback_
 // ============================================================================
 
 int storage_tick(storage_t *storage) {
-    (void)storage;
+    if (storage && storage->cache.ra_count)
+        readahead_fill(storage);
     return GS_SUCCESS;
 }
+
+int storage_compact(storage_t *storage) {
+    if (!storage)
+        return GS_ERROR;
+    // Only committed blocks may move: the new index is written as committed
+    if (storage->map_dirty || memcmp(storage->committed_bitmap, storage->bitmap, storage->bitmap_bytes) != 0)
+        return GS_ERROR;
+    size_t count = 0;
+    delta_entry_t *entries = delta_entries(storage, &count);
+    if (!entries)
+        return GS_ERROR;
+    int rc = delta_rewrite(storage, entries, count, storage->delta_fd, DELTA_DATA_OFFSET);
+    free(entries);
+    return rc;
+}
+
+int storage_set_cache_size(storage_t *storage, size_t blocks) {
+    if (!storage)
+        return GS_ERROR;
+    return cache_resize(storage, blocks);
+}
+
+void storage_cache_stats(const storage_t *storage, storage_cache_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!storage)
+        return;
+    stats->capacity = storage->cache.capacity;
+    stats->used = storage->cache.used;
+    stats->hits = storage->cache.hits;
+    stats->misses = storage->cache.misses;
+    stats->readahead = storage->cache.readahead;
+}
+
+void storage_set_default_cache_size(size_t blocks) {
+    g_default_cache_blocks = blocks;
+}
+
+size_t storage_default_cache_size(void) {
+    return g_default_cache_blocks;
+}
+
+int storage_flush(storage_t *storage) {
+    if (!storage)
+        return GS_ERROR;
+    int rc = GS_SUCCESS;
+    if (storage->delta_fp && fflush(storage->delta_fp) != 0)
+        rc = GS_ERROR;
+    if (storage->journal_fp && fflush(storage->journal_fp) != 0)
+        rc = GS_ERROR;
+    return rc;
+}
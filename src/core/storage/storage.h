@@ -6,12 +6,12 @@
 //
 // Each disk image is backed by three files:
 //   base   — the original image, opened read-only, never modified
-//   delta  — header (magic + bitmaps) + block data area for modified blocks
+//   delta  — header + extent area holding modified blocks and their index
 //   journal — append-only preimage log for crash recovery
 //
 // Reads check a bitmap: bit set → read from delta, bit clear → read from base.
-// Writes go to the delta; the bitmap is updated in memory and flushed at
-// checkpoint time.  A preimage journal captures old data before overwriting
+// Writes go to the delta; the bitmap and the block index are updated in
+// memory and the index is written at checkpoint time.  A preimage journal captures old data before overwriting
 // committed blocks, enabling crash recovery without a full sync step.
 
 #ifndef STORAGE_H
@@ -37,9 +37,18 @@ extern "C" {
 // 512 (flat disks) and 532 (Lisa ProFile: 512 data + 20 inline tag) both fit.
 #define STORAGE_MAX_BLOCK_SIZE 1024
 
+// Block cache size given to new instances, and the largest one accepted
+// (in blocks: 1 MB and 128 MB of 512-byte blocks).
+#define STORAGE_CACHE_DEFAULT_BLOCKS 2048
+#define STORAGE_CACHE_MAX_BLOCKS     (1u << 18)
+
 // Opaque handle to a storage instance.
 typedef struct storage_t storage_t;
 
+// Reads len bytes at byte offset of a decoded base image (see
+// storage_config_t.base_read).  Returns GS_SUCCESS or GS_ERROR.
+typedef int (*storage_base_read_t)(void *context, uint64_t offset, void *buffer, size_t len);
+
 // Configuration passed to storage_new().
 typedef struct {
     const char *base_path; // Path to original image (read-only)
@@ -48,12 +57,26 @@ typedef struct {
     uint64_t block_count; // Number of logical blocks
     uint32_t block_size; // Bytes per block: a multiple of 4 in [512, STORAGE_MAX_BLOCK_SIZE] (512 default, 532 ProFile)
     size_t base_data_offset; // Byte offset to data in base file (e.g. DiskCopy header)
+    storage_base_read_t base_read; // Decoder for a base that is not a flat file (base_path is then ignored), or NULL
+    void *base_context; // Passed to base_read; owned by the caller, kept alive until storage_delete
 } storage_config_t;
 
+// Block cache counters (see storage_cache_stats).
+typedef struct {
+    size_t capacity; // Blocks the cache can hold (0 = off)
+    size_t used; // Blocks it holds
+    uint64_t hits; // Blocks read served from the cache
+    uint64_t misses; // Blocks read from the files
+    uint64_t readahead; // Blocks loaded ahead of a sequential reader
+} storage_cache_stats_t;
+
 // Callback signatures for streaming block data.
 typedef int (*storage_write_callback_t)(void *context, const void *data, size_t size);
 typedef int (*storage_read_callback_t)(void *context, void *data, size_t size);
 
+// Receives count consecutive blocks starting at lba (see storage_changed_runs).
+typedef int (*storage_run_callback_t)(void *context, uint64_t lba, const void *data, size_t count);
+
 // === Lifecycle ===
 
 // Creates or opens a delta-file storage instance.
@@ -71,12 +94,15 @@ int storage_delete(storage_t *storage);
 // Serializes storage metadata into a checkpoint stream.
 // Quick checkpoints: writes the current bitmap.
 // Consolidated checkpoints: streams all block data via storage_save_state().
+// History snapshots: writes the current bitmap and the modified blocks, and
+// commits nothing.
 // When checkpoint is NULL, behaves as a flush (clears rollback).
 int storage_checkpoint(storage_t *storage, checkpoint_t *checkpoint);
 
 // Restores storage state from a checkpoint stream.
 // Quick checkpoints: reads bitmap, sets as current, clears journal.
 // Consolidated checkpoints: loads all block data via storage_load_state().
+// History snapshots: writes back the blocks that differ, resets the bitmap.
 // If storage is NULL, the serialized data is consumed and discarded.
 int storage_restore_from_checkpoint(storage_t *storage, checkpoint_t *checkpoint);
 
@@ -88,6 +114,16 @@ int storage_read_block(storage_t *storage, size_t offset, void *buffer);
 // Writes one block (block_size bytes) at the given byte offset.
 int storage_write_block(storage_t *storage, size_t offset, const void *buffer);
 
+// Reads count consecutive blocks starting at the given byte offset.  Blocks
+// in the cache are copied from it; each run of the others that is contiguous
+// in one file (delta or base) is a single pread.
+int storage_read_blocks(storage_t *storage, size_t offset, void *buffer, size_t count);
+
+// Writes count consecutive blocks starting at the given byte offset: the
+// preimages of committed blocks are journaled in batches, then the whole
+// range goes to the delta in a single pwrite.
+int storage_write_blocks(storage_t *storage, size_t offset, const void *buffer, size_t count);
+
 // === Rollback ===
 
 // Replays the preimage journal: restores committed blocks in the delta,
@@ -106,11 +142,41 @@ int storage_save_state(storage_t *storage, void *context, storage_write_callback
 // Replaces all storage data from read_cb, sets all bitmap bits, commits.
 int storage_load_state(storage_t *storage, void *context, storage_read_callback_t read_cb);
 
+// Streams the blocks written since the last commit (storage_clear_rollback)
+// to run_cb, in LBA order, as runs of consecutive blocks.  Commits nothing.
+int storage_changed_runs(storage_t *storage, void *context, storage_run_callback_t run_cb);
+
 // === Maintenance ===
 
-// No-op (consolidation is not needed with the delta model).
+// Periodic work: loads the readahead queued by sequential reads into the cache.
 int storage_tick(storage_t *storage);
 
+// Rewrites the delta with only its live blocks, in LBA order, and shrinks the
+// file to fit.  Commits do this on their own once dead slots outnumber live
+// ones; fails when there are uncommitted block mappings.
+int storage_compact(storage_t *storage);
+
+// Pushes buffered delta and journal writes to the files, so another
+// instance opened on the same files sees them.
+int storage_flush(storage_t *storage);
+
+// === Block cache ===
+//
+// An LRU cache of block contents in front of the delta and base files.
+// Writes update cached blocks in place; rollback and restores empty it.  A
+// reader going through the disk in sequence gets the blocks ahead of it
+// queued for storage_tick (and the host is advised it will need them).
+
+// Resizes the cache of one instance, dropping its contents (0 turns it off).
+int storage_set_cache_size(storage_t *storage, size_t blocks);
+
+// Fills *stats with the instance's cache counters.
+void storage_cache_stats(const storage_t *storage, storage_cache_stats_t *stats);
+
+// Cache size of instances created from now on (STORAGE_CACHE_DEFAULT_BLOCKS initially).
+void storage_set_default_cache_size(size_t blocks);
+size_t storage_default_cache_size(void);
+
 // Object-model lifecycle hooks for storage.images indexed children.
 // Called by root_install / root_uninstall.
 struct config;
@@ -97,6 +97,42 @@ static value_t storage_image_attr_type(struct object *self, const member_t *m) {
     return val_enum(t, STORAGE_IMAGE_TYPE_NAMES, (size_t)max);
 }
 
+// Block cache of the image's storage instance: size and counters
+static storage_cache_stats_t storage_image_cache_stats(struct object *self) {
+    image_t *img = storage_image_at(self);
+    storage_cache_stats_t stats = {0};
+    if (img && img->storage)
+        storage_cache_stats(img->storage, &stats);
+    return stats;
+}
+static value_t storage_image_attr_cache_blocks(struct object *self, const member_t *m) {
+    (void)m;
+    return val_uint(8, storage_image_cache_stats(self).capacity);
+}
+static value_t storage_image_attr_cache_blocks_set(struct object *self, const member_t *m, value_t in) {
+    (void)m;
+    image_t *img = storage_image_at(self);
+    if (!img || !img->storage)
+        return val_err("cache_blocks: image has no storage");
+    if (in.u > STORAGE_CACHE_MAX_BLOCKS)
+        return val_err("cache_blocks: %llu out of range (0..%u)", (unsigned long long)in.u, STORAGE_CACHE_MAX_BLOCKS);
+    if (storage_set_cache_size(img->storage, (size_t)in.u) != GS_SUCCESS)
+        return val_err("cache_blocks: out of memory");
+    return val_none();
+}
+static value_t storage_image_attr_cache_hits(struct object *self, const member_t *m) {
+    (void)m;
+    return val_uint(8, storage_image_cache_stats(self).hits);
+}
+static value_t storage_image_attr_cache_misses(struct object *self, const member_t *m) {
+    (void)m;
+    return val_uint(8, storage_image_cache_stats(self).misses);
+}
+static value_t storage_image_attr_cache_readahead(struct object *self, const member_t *m) {
+    (void)m;
+    return val_uint(8, storage_image_cache_stats(self).readahead);
+}
+
 static const member_t storage_image_members[] = {
     {.kind = M_ATTR,
      .name = "index",
@@ -122,6 +158,26 @@ static const member_t storage_image_members[] = {
      .name = "type",
      .flags = VAL_RO,
      .attr = {.type = V_ENUM, .get = storage_image_attr_type, .set = NULL}      },
+    {.kind = M_ATTR,
+     .name = "cache_blocks",
+     .doc = "Block cache size in blocks (0 = off)",
+     .flags = 0,
+     .attr = {.type = V_UINT, .get = storage_image_attr_cache_blocks, .set = storage_image_attr_cache_blocks_set}},
+    {.kind = M_ATTR,
+     .name = "cache_hits",
+     .doc = "Blocks read served from the block cache",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = storage_image_attr_cache_hits, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "cache_misses",
+     .doc = "Blocks read from the image files",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = storage_image_attr_cache_misses, .set = NULL}},
+    {.kind = M_ATTR,
+     .name = "cache_readahead",
+     .doc = "Blocks loaded ahead of sequential reads",
+     .flags = VAL_RO,
+     .attr = {.type = V_UINT, .get = storage_image_attr_cache_readahead, .set = NULL}},
 };
 
 const class_desc_t storage_image_class = {
@@ -708,6 +764,26 @@ static const arg_decl_t storage_partmap_args[] = {
     {.name = "flag", .kind = V_STRING, .validation_flags = OBJ_ARG_OPTIONAL, .doc = "Optional output flag (--json)"},
 };
 
+// Default block cache size; setting it also resizes every open image's cache
+static value_t storage_attr_cache_blocks(struct object *self, const member_t *m) {
+    (void)self;
+    (void)m;
+    return val_uint(8, storage_default_cache_size());
+}
+static value_t storage_attr_cache_blocks_set(struct object *self, const member_t *m, value_t in) {
+    (void)m;
+    if (in.u > STORAGE_CACHE_MAX_BLOCKS)
+        return val_err("storage.cache_blocks: %llu out of range (0..%u)", (unsigned long long)in.u,
+                       STORAGE_CACHE_MAX_BLOCKS);
+    storage_set_default_cache_size((size_t)in.u);
+    config_t *cfg = (config_t *)object_data(self);
+    for (int i = 0; cfg && i < cfg->n_images; i++)
+        if (cfg->images[i] && cfg->images[i]->storage &&
+            storage_set_cache_size(cfg->images[i]->storage, (size_t)in.u) != GS_SUCCESS)
+            return val_err("storage.cache_blocks: out of memory");
+    return val_none();
+}
+
 static const member_t storage_members[] = {
     {.kind = M_METHOD,
      .name = "import",
@@ -778,6 +854,11 @@ static const member_t storage_members[] = {
      .name = "path_size",
      .doc = "File size in bytes (0 on stat failure)",
      .method = {.args = storage_path_arg, .nargs = 1, .result = V_UINT, .fn = storage_method_path_size}          },
+    {.kind = M_ATTR,
+     .name = "cache_blocks",
+     .doc = "Block cache size (in blocks) for every image; 0 turns caching off",
+     .flags = 0,
+     .attr = {.type = V_UINT, .get = storage_attr_cache_blocks, .set = storage_attr_cache_blocks_set}},
 };
 
 const class_desc_t storage_class_real = {
@@ -15,6 +15,7 @@
 #include "display.h"
 #include "drive_catalog.h"
 #include "floppy.h"
+#include "history.h"
 #include "image.h"
 #include "image_vfs.h"
 #include "jmfb.h" // restored-record sense seeding on checkpoint load
@@ -92,8 +93,13 @@ void config_add_image(config_t *cfg, image_t *image) {
         LOG(1, "config_add_image: image table full (max %d), dropping image", MAX_IMAGES);
         return;
     }
+    history_forget(cfg, "media inserted");
     cfg->images[cfg->n_images] = image;
     cfg->n_images++;
+    // Block the VFS auto-mount cache from mounting (and writing) the same
+    // file while the emulator holds it (§2.9).
+    if (image->filename)
+        image_vfs_notify_attached(image->filename);
 }
 
 // Find an image object by its filename path
@@ -113,6 +119,7 @@ image_t *setup_get_image_by_filename(const char *filename) {
 void system_mouse_update(bool button, int dx, int dy) {
     if (!global_emulator)
         return;
+    history_discard("mouse input");
     if (global_emulator->adb)
         adb_mouse_event(global_emulator->adb, button, dx, dy);
     else if (global_emulator->mouse)
@@ -125,6 +132,7 @@ void system_mouse_update(bool button, int dx, int dy) {
 bool system_mouse_move(int dx, int dy) {
     if (!global_emulator)
         return false;
+    history_discard("mouse input");
     if (global_emulator->adb) {
         adb_mouse_move(global_emulator->adb, dx, dy);
         return true;
@@ -144,6 +152,7 @@ bool system_mouse_move(int dx, int dy) {
 bool system_mouse_move_adb(int dx, int dy) {
     if (!global_emulator || !global_emulator->adb)
         return false;
+    history_discard("mouse input");
     adb_mouse_move(global_emulator->adb, dx, dy);
     return true;
 }
@@ -152,6 +161,7 @@ bool system_mouse_move_adb(int dx, int dy) {
 void system_keyboard_update(key_event_t event, int key) {
     if (!global_emulator)
         return;
+    history_discard("keyboard input");
     if (global_emulator->adb)
         adb_keyboard_event(global_emulator->adb, event, key);
     else if (global_emulator->keyboard)
@@ -212,23 +222,27 @@ config_t *system_config(void) {
 // substrate implements these — Macs route to the shared mac_input_* helpers
 // (keyboard / Toolbox cursor), the Lisa to its COPS — so there is one uniform
 // path and no caller-side fallback.  Each returns 0 on success, <0 on failure
-// (unknown key/mode, uninitialised memory, no machine).
+// (unknown key/mode, uninitialised memory, no machine).  Host input cannot be
+// replayed, so each one ends the reverse-execution history.
 int system_input_key(const char *key, bool down) {
     config_t *cfg = global_emulator;
     if (!cfg || !cfg->machine || !cfg->machine->substrate->input_key)
         return -1;
+    history_discard("keyboard input");
     return cfg->machine->substrate->input_key(cfg, key, down);
 }
 int system_input_mouse_move(int x, int y, const char *mode) {
     config_t *cfg = global_emulator;
     if (!cfg || !cfg->machine || !cfg->machine->substrate->input_mouse_move)
         return -1;
+    history_discard("mouse input");
     return cfg->machine->substrate->input_mouse_move(cfg, x, y, mode);
 }
 int system_input_mouse_button(bool down, const char *mode) {
     config_t *cfg = global_emulator;
     if (!cfg || !cfg->machine || !cfg->machine->substrate->input_mouse_button)
         return -1;
+    history_discard("mouse input");
     return cfg->machine->substrate->input_mouse_button(cfg, down, mode);
 }
 
@@ -668,6 +682,7 @@ void system_destroy(config_t *config) {
     // system_destroy(old) runs *after* system_create(new) has already
     // pinned a fresh emulator that still references the rom object.
     root_uninstall_if(config);
+    history_forget(config, "machine destroyed");
 
     // Tear down NuBus before peripherals so cards (which hold device
     // pointers via cfg->via2 etc.) free cleanly first.  No-op when nubus
@@ -685,6 +700,8 @@ void system_destroy(config_t *config) {
     // Free all tracked images (managed at the system level)
     for (int i = 0; i < config->n_images; ++i) {
         if (config->images[i]) {
+            if (config->images[i]->filename)
+                image_vfs_notify_detached(config->images[i]->filename);
             image_close(config->images[i]);
             config->images[i] = NULL;
         }
@@ -729,9 +746,6 @@ void add_scsi_drive(struct config *restrict config, const char *filename, int sc
 
     add_image(config, img);
     scsi_add_device(config->scsi, scsi_id, best->vendor, best->product, "1.0", img, scsi_dev_hd, 512, false);
-    // Block the VFS auto-mount cache from serving reads on the same file
-    // while the emulator holds writable handles against it (§2.9).
-    image_vfs_notify_attached(filename);
     free(persistent_path);
 }
 
@@ -757,74 +771,105 @@ void add_scsi_cdrom(struct config *restrict config, const char *filename, int sc
 
     add_image(config, img);
     scsi_add_device(config->scsi, scsi_id, "SONY", "CD-ROM CDU-8002", "1.8g", img, scsi_dev_cdrom, 2048, true);
-    image_vfs_notify_attached(filename);
     free(persistent_path);
 }
 
-// Save current machine state to a checkpoint file.
-// Returns GS_SUCCESS on success, GS_ERROR on failure.
-int system_checkpoint(const char *filename, checkpoint_kind_t kind) {
-    if (!global_emulator) {
-        printf("Error: No emulator instance to checkpoint\n");
+// Serialise the running machine into an open checkpoint: the built-from
+// record, then everything the machine profile saves.  Quick and history
+// checkpoints store files as references (paths only), never content.
+int system_checkpoint_write(checkpoint_t *checkpoint) {
+    if (!global_emulator || !global_emulator->machine || !global_emulator->machine->substrate->checkpoint_save) {
+        checkpoint_set_error(checkpoint);
         return GS_ERROR;
     }
-    if (!global_emulator->machine || !global_emulator->machine->substrate->checkpoint_save) {
-        printf("Error: Machine has no checkpoint_save callback\n");
+    bool prev_files_mode = checkpoint_get_files_as_refs();
+    checkpoint_kind_t kind = checkpoint_get_kind(checkpoint);
+    if (kind == CHECKPOINT_KIND_QUICK || kind == CHECKPOINT_KIND_HISTORY)
+        checkpoint_set_files_as_refs(true);
+
+    // Built-from record first (fixed-size POD; the stream is build-ID-gated
+    // so the layout may change freely between builds). Restore reads it
+    // symmetrically in system_restore_from before machine construction.
+    system_write_checkpoint_data(checkpoint, machine_config_record(), sizeof(machine_config_record_t));
+
+    // Delegate all state serialisation to the machine profile
+    global_emulator->machine->substrate->checkpoint_save(global_emulator, checkpoint);
+
+    checkpoint_set_files_as_refs(prev_files_mode);
+    return checkpoint_has_error(checkpoint) ? GS_ERROR : GS_SUCCESS;
+}
+
+// Capture the machine into a checkpoint; an asynchronous save returns once
+// the state is captured and leaves the file to the checkpoint writer thread.
+// done (asynchronous saves only) runs exactly once, however the save ends.
+static int checkpoint_machine(const char *filename, checkpoint_kind_t kind, bool async, checkpoint_done_fn done,
+                              void *ctx) {
+    const char *error = NULL;
+    if (!global_emulator)
+        error = "No emulator instance to checkpoint";
+    else if (!global_emulator->machine || !global_emulator->machine->substrate->checkpoint_save)
+        error = "Machine has no checkpoint_save callback";
+    if (error) {
+        printf("Error: %s\n", error);
+        if (done)
+            done(false, ctx);
         return GS_ERROR;
     }
 
     double start_time = host_time_ms();
 
-    // Quick checkpoints store files as references (paths only), never content.
-    bool prev_files_mode = checkpoint_get_files_as_refs();
-    if (kind == CHECKPOINT_KIND_QUICK) {
-        checkpoint_set_files_as_refs(true);
-    }
-
     // Pass the machine model ID and RAM size so they're stored in the checkpoint header
     const char *model_id = global_emulator->machine->id;
     uint32_t ram_size_kb = global_emulator->ram_size / 1024;
-    checkpoint_t *checkpoint = checkpoint_open_write(filename, kind, model_id, ram_size_kb);
+    checkpoint_t *checkpoint = async ? checkpoint_open_write_async(filename, kind, model_id, ram_size_kb)
+                                     : checkpoint_open_write(filename, kind, model_id, ram_size_kb);
     if (!checkpoint) {
         printf("Error: Failed to open checkpoint file for writing: %s\n", filename);
+        if (done)
+            done(false, ctx);
         return GS_ERROR;
     }
 
-    // Built-from record first (fixed-size POD; the stream is build-ID-gated
-    // so the layout may change freely between builds). Restore reads it
-    // symmetrically in system_restore before machine construction.
-    system_write_checkpoint_data(checkpoint, machine_config_record(), sizeof(machine_config_record_t));
-
-    // Delegate all state serialisation to the machine profile
-    global_emulator->machine->substrate->checkpoint_save(global_emulator, checkpoint);
-
-    if (checkpoint_has_error(checkpoint)) {
+    if (system_checkpoint_write(checkpoint) != GS_SUCCESS) {
         printf("Error: Failed to write checkpoint\n");
-        checkpoint_close(checkpoint);
-        checkpoint_set_files_as_refs(prev_files_mode);
+        if (async)
+            checkpoint_close_async(checkpoint, done, ctx); // reports the failure
+        else
+            checkpoint_close(checkpoint);
         return GS_ERROR;
     }
 
-    checkpoint_close(checkpoint);
-    checkpoint_set_files_as_refs(prev_files_mode);
+    if (async)
+        checkpoint_close_async(checkpoint, done, ctx);
+    else
+        checkpoint_close(checkpoint);
 
     double elapsed_ms = host_time_ms() - start_time;
-    printf("Checkpoint saved to %s (%.2f ms)\n", filename, elapsed_ms);
+    if (async)
+        printf("Checkpoint captured for %s (%.2f ms), writing in the background\n", filename, elapsed_ms);
+    else
+        printf("Checkpoint saved to %s (%.2f ms)\n", filename, elapsed_ms);
     return GS_SUCCESS;
 }
 
-// Restore machine state from a checkpoint file.
-config_t *system_restore(const char *filename) {
-    checkpoint_t *checkpoint = checkpoint_open_read(filename);
-    if (!checkpoint) {
-        printf("Error: Failed to open checkpoint file for reading: %s\n", filename);
-        return NULL;
-    }
+// Save current machine state to a checkpoint file.
+// Returns GS_SUCCESS on success, GS_ERROR on failure.
+int system_checkpoint(const char *filename, checkpoint_kind_t kind) {
+    return checkpoint_machine(filename, kind, false, NULL, NULL);
+}
 
+// Capture the machine state and write the checkpoint file in the background.
+// Returns GS_SUCCESS once captured, GS_ERROR if the capture failed.
+int system_checkpoint_async(const char *filename, checkpoint_kind_t kind, checkpoint_done_fn done, void *ctx) {
+    return checkpoint_machine(filename, kind, true, done, ctx);
+}
+
+// Build a machine from an open checkpoint; the caller closes it.
+config_t *system_restore_from(checkpoint_t *checkpoint) {
     // Save the current global emulator so we can restore it on error.
     config_t *prev = global_emulator;
 
-    // Read the built-from record (mirrors the write in system_checkpoint).
+    // Read the built-from record (mirrors the write in system_checkpoint_write).
     // It is installed only after the restore succeeds, so a failed restore
     // leaves the previous machine's record intact.
     machine_config_record_t restored_record;
@@ -872,15 +917,12 @@ config_t *system_restore(const char *filename) {
 
     if (checkpoint_has_error(checkpoint)) {
         printf("Error: Failed to read checkpoint\n");
-        checkpoint_close(checkpoint);
         global_emulator = prev;
         if (config)
             system_destroy(config);
         return NULL;
     }
 
-    checkpoint_close(checkpoint);
-
     // Install the restored built-from record so machine.config answers for
     // the restored machine and argument-less reboots inherit it. The vROM
     // pick list reflects THIS construction (the loaders re-reported during
@@ -892,32 +934,54 @@ config_t *system_restore(const char *filename) {
     *rec = restored_record;
     memcpy(rec->vroms, fresh_vroms, sizeof(rec->vroms));
     rec->n_vroms = fresh_n;
+    return config;
+}
 
-    printf("Checkpoint restored from %s\n", filename);
+// Restore machine state from a checkpoint file.
+config_t *system_restore(const char *filename) {
+    checkpoint_t *checkpoint = checkpoint_open_read(filename);
+    if (!checkpoint) {
+        printf("Error: Failed to open checkpoint file for reading: %s\n", filename);
+        return NULL;
+    }
+    config_t *config = system_restore_from(checkpoint);
+    checkpoint_close(checkpoint);
+    if (config)
+        printf("Checkpoint restored from %s\n", filename);
     return config;
 }
 
 // Command handlers for checkpoint operations
 uint64_t cmd_save_checkpoint(int argc, char *argv[]) {
     if (argc < 2) {
-        printf("Usage: checkpoint --save <filename> [content|refs]\n");
+        printf("Usage: checkpoint --save <filename> [content|refs] [--mapped] [--async]\n");
         return -1;
     }
     const char *filename = argv[1];
     bool prev_mode = checkpoint_get_files_as_refs();
-    if (argc >= 3) {
-        const char *mode = argv[2];
-        if (strcmp(mode, "refs") == 0 || strcmp(mode, "reference") == 0 || strcmp(mode, "names") == 0) {
+    bool prev_mapped = checkpoint_get_ram_mapped();
+    bool async = false;
+    for (int i = 2; i < argc; i++) {
+        const char *mode = argv[i];
+        if (strcmp(mode, "--async") == 0 || strcmp(mode, "async") == 0) {
+            async = true;
+        } else if (strcmp(mode, "--mapped") == 0 || strcmp(mode, "mapped") == 0) {
+            checkpoint_set_ram_mapped(true);
+        } else if (strcmp(mode, "refs") == 0 || strcmp(mode, "reference") == 0 || strcmp(mode, "names") == 0) {
             checkpoint_set_files_as_refs(true);
         } else if (strcmp(mode, "content") == 0 || strcmp(mode, "inline") == 0) {
             checkpoint_set_files_as_refs(false);
         } else {
             printf("checkpoint --save: unknown mode '%s' (use 'content' or 'refs')\n", mode);
+            checkpoint_set_files_as_refs(prev_mode);
+            checkpoint_set_ram_mapped(prev_mapped);
             return -1;
         }
     }
-    int result = system_checkpoint(filename, CHECKPOINT_KIND_CONSOLIDATED);
+    int result = async ? system_checkpoint_async(filename, CHECKPOINT_KIND_CONSOLIDATED, NULL, NULL)
+                       : system_checkpoint(filename, CHECKPOINT_KIND_CONSOLIDATED);
     checkpoint_set_files_as_refs(prev_mode); // restore previous setting
+    checkpoint_set_ram_mapped(prev_mapped);
     return result;
 }
 
@@ -93,10 +93,26 @@ void trigger_vbl(config_t *restrict config);
 // Returns GS_SUCCESS on success, GS_ERROR on failure.
 int system_checkpoint(const char *filename, checkpoint_kind_t kind);
 
+// Capture the machine state now and write the checkpoint file on a background
+// thread (see checkpoint_close_async).  done may be NULL; otherwise it runs
+// exactly once, also when the capture itself fails.  Returns GS_SUCCESS once
+// the state is captured; the outcome of the write is reported through
+// checkpoint_save_state and done.
+int system_checkpoint_async(const char *filename, checkpoint_kind_t kind, checkpoint_done_fn done, void *ctx);
+
 // Restore machine state from a checkpoint file.
 // Returns a new config on success, NULL on failure.
 config_t *system_restore(const char *filename);
 
+// Write the running machine into an open checkpoint (what system_checkpoint
+// stores after the header).  Returns GS_SUCCESS or GS_ERROR.
+int system_checkpoint_write(checkpoint_t *checkpoint);
+
+// Build a machine from an open checkpoint written by system_checkpoint_write;
+// the caller closes the checkpoint.  Returns the new config (already current)
+// or NULL, leaving the previous machine current.
+config_t *system_restore_from(checkpoint_t *checkpoint);
+
 // Command handlers for checkpoint operations
 uint64_t cmd_save_checkpoint(int argc, char *argv[]);
 uint64_t cmd_load_checkpoint(int argc, char *argv[]);
@@ -10,6 +10,12 @@
 // records the file's device+inode+mtime so a subsequent stat mismatch
 // triggers reprobe; the coarse path key is still enough to detect most
 // same-file aliasing (symlinks aside).
+//
+// Classic HFS partitions are writable (mkdir / unlink / put_file, via
+// image_hfs_write.c): each operation is staged in the mount's storage delta,
+// then written back to the image file and committed, or rolled back on
+// failure.  Files attached to the emulator are never mounted, so a write
+// cannot race the guest.
 
 #include "image_vfs.h"
 
@@ -42,6 +48,8 @@ typedef struct partition_fs {
     enum apm_fs_kind kind; // copy of parent apm_partition_t.fs_kind
     hfs_volume_t *hfs; // non-NULL iff kind == APM_FS_HFS and open succeeded
     ufs_volume_t *ufs; // non-NULL iff kind == APM_FS_UFS and open succeeded
+    bool write_checked; // true once `writable` is known
+    bool writable; // classic HFS volume that image_hfs_write can modify
 } partition_fs_t;
 
 struct image_mount {
@@ -64,14 +72,24 @@ struct image_mount {
 
 static image_mount_t g_mounts[IMAGE_VFS_MAX_MOUNTS];
 
+// Canonical paths of the files attached to the emulator (hd / cdrom /
+// floppy), with a count per path.  Mounting one is refused with -EBUSY.
+#define IMAGE_VFS_MAX_ATTACHED 16
+
+typedef struct attached_file {
+    char *host_path; // NULL = slot empty
+    uint32_t count;
+} attached_file_t;
+
+static attached_file_t g_attached[IMAGE_VFS_MAX_ATTACHED];
+
 // ---- Resource-fork LRU cache ---------------------------------------------
 // Parsed resource maps are held here so repeated reads through the
 // synthetic /rsrc/<TYPE>/<id> tree don't re-parse the fork each time.
 // Capacity is intentionally small — typical workflows touch one app at a
 // time, occasionally a handful, so eight slots cover the common cases
 // without holding entire fork buffers around forever.  The cache is
-// invalidated when the parent mount is destroyed; image_vfs is otherwise
-// read-only, so no other invalidation hooks are needed today.
+// invalidated when the parent mount is destroyed or written to.
 
 #define RSRC_CACHE_CAPACITY 8
 
@@ -96,7 +114,8 @@ static void rsrc_cache_evict(rsrc_cache_entry_t *e) {
     memset(e, 0, sizeof(*e));
 }
 
-// Drop every entry associated with `m`.  Called from mount_destroy().
+// Drop every entry associated with `m`.  Called from mount_destroy() and
+// after every write to the mount.
 static void rsrc_cache_drop_for_mount(const image_mount_t *m) {
     for (size_t i = 0; i < RSRC_CACHE_CAPACITY; i++) {
         if (g_rsrc_cache[i].mount == m)
@@ -301,12 +320,23 @@ static void capture_identity(image_mount_t *m, const char *path) {
     }
 }
 
+// Registry slot of an attached file (by canonical path), or NULL.
+static attached_file_t *find_attached(const char *canon) {
+    for (int i = 0; i < IMAGE_VFS_MAX_ATTACHED; i++) {
+        if (g_attached[i].host_path && strcmp(g_attached[i].host_path, canon) == 0)
+            return &g_attached[i];
+    }
+    return NULL;
+}
+
 int image_vfs_acquire_mount(const char *host_path_in, image_mount_t **out_mount) {
     if (!host_path_in || !out_mount)
         return -EINVAL;
 
     char host_path[PATH_MAX];
     canonicalise(host_path_in, host_path, sizeof(host_path));
+    if (find_attached(host_path))
+        return -EBUSY;
 
     // Existing cache entry?  Honour stale-identity detection: if the file
     // was swapped, evict.
@@ -425,6 +455,13 @@ void image_vfs_notify_attached(const char *host_path) {
     // keyed on `/bar/disk.img`.
     char canon[PATH_MAX];
     canonicalise(host_path, canon, sizeof(canon));
+    attached_file_t *a = find_attached(canon);
+    for (int i = 0; !a && i < IMAGE_VFS_MAX_ATTACHED; i++) {
+        if (!g_attached[i].host_path && (g_attached[i].host_path = strdup(canon)) != NULL)
+            a = &g_attached[i];
+    }
+    if (a)
+        a->count++;
     image_mount_t *m = find_mount_by_path(canon);
     if (m)
         m->conflicted = true;
@@ -435,6 +472,13 @@ void image_vfs_notify_detached(const char *host_path) {
         return;
     char canon[PATH_MAX];
     canonicalise(host_path, canon, sizeof(canon));
+    attached_file_t *a = find_attached(canon);
+    if (a && --a->count > 0)
+        return;
+    if (a) {
+        free(a->host_path);
+        memset(a, 0, sizeof(*a));
+    }
     image_mount_t *m = find_mount_by_path(canon);
     if (m && m->refcount == 0) {
         // Simplest recovery: drop the cached mount entirely so the next
@@ -452,6 +496,10 @@ void image_vfs_reset(void) {
         if (m->in_use)
             mount_destroy(m);
     }
+    for (int i = 0; i < IMAGE_VFS_MAX_ATTACHED; i++) {
+        free(g_attached[i].host_path);
+        memset(&g_attached[i], 0, sizeof(g_attached[i]));
+    }
 }
 
 // ---- Partition-level FS state (lazy init) --------------------------------
@@ -477,6 +525,20 @@ static hfs_volume_t *get_partition_hfs(image_mount_t *m, uint32_t idx_1based) {
     return pfs->hfs;
 }
 
+// True if partition N (1-based) is a classic HFS volume on an image whose
+// file can take writes.  Checked once per mount.
+static bool partition_writable(image_mount_t *m, uint32_t idx_1based) {
+    hfs_volume_t *hfs = get_partition_hfs(m, idx_1based);
+    if (!hfs)
+        return false;
+    partition_fs_t *pfs = &m->parts_fs[idx_1based - 1];
+    if (!pfs->write_checked) {
+        pfs->write_checked = true;
+        pfs->writable = image_base_writable(m->img) && hfs_writable(hfs);
+    }
+    return pfs->writable;
+}
+
 // Lazy-open the UFS filesystem for partition N (1-based).  Returns NULL if
 // this partition isn't UFS or the superblock was unreadable.
 static ufs_volume_t *get_partition_ufs(image_mount_t *m, uint32_t idx_1based) {
@@ -684,6 +746,7 @@ struct vfs_dir {
     uint32_t next_partition;
     // HFS directory
     hfs_dir_iter_t *hfs_iter;
+    bool writable; // entries can be written (see partition_writable)
     // UFS directory
     ufs_dir_iter_t *ufs_iter;
     // Synthetic resource tree (DIR_RSRC_ROOT / DIR_RSRC_TYPE)
@@ -739,7 +802,9 @@ static void img_closedir(vfs_dir_t *d);
 static int img_open(void *ctx, const char *path, vfs_file_t **out);
 static int img_read(vfs_file_t *f, uint64_t off, void *buf, size_t n, size_t *nread);
 static void img_close(vfs_file_t *f);
-static int img_readonly(void *ctx, const char *path);
+static int img_mkdir(void *ctx, const char *path);
+static int img_unlink(void *ctx, const char *path);
+static int img_put_file(void *ctx, const char *path, const vfs_put_t *put);
 static int img_readonly2(void *ctx, const char *a, const char *b);
 
 // stat: understand partition roots, HFS directories/files, fork sub-paths.
@@ -877,6 +942,7 @@ static int img_stat(void *ctx, const char *path, vfs_stat_t *out) {
 
     out->mode = d.is_dir ? VFS_MODE_DIR : VFS_MODE_FILE;
     out->size = d.is_dir ? 0 : d.data_fork.logical_size;
+    out->readonly = !partition_writable(m, ip.partition_idx);
     return 0;
 }
 
@@ -1020,6 +1086,7 @@ static int img_opendir(void *ctx, const char *path, vfs_dir_t **out) {
         parent_cnid = de.cnid;
     }
     d->kind = DIR_HFS;
+    d->writable = partition_writable(m, ip.partition_idx);
     d->hfs_iter = hfs_opendir_cnid(hfs, parent_cnid);
     if (!d->hfs_iter) {
         free(d);
@@ -1062,7 +1129,7 @@ static int img_readdir(vfs_dir_t *d, vfs_dirent_t *out) {
         snprintf(out->name, sizeof(out->name), "%s", hde.name);
         out->st.mode = hde.is_dir ? VFS_MODE_DIR : VFS_MODE_FILE;
         out->st.size = hde.is_dir ? 0 : hde.data_fork.logical_size;
-        out->st.readonly = true;
+        out->st.readonly = !d->writable;
         out->has_stat = true;
         return 1;
     }
@@ -1351,13 +1418,87 @@ static void img_close(vfs_file_t *f) {
     free(f);
 }
 
-// Writable operations — always refused for image paths.
-static int img_readonly(void *ctx, const char *path) {
-    (void)ctx;
-    (void)path;
-    return -EROFS;
+// ---- Writes (classic HFS) -------------------------------------------------
+
+// Resolve the HFS volume a write to `path` goes to.  -EROFS unless the
+// partition is writable (see partition_writable).
+static int write_target(image_mount_t *m, const char *path, image_path_t *ip, hfs_volume_t **out) {
+    if (!m)
+        return -EINVAL;
+    if (m->conflicted)
+        return -EBUSY;
+    int rc = parse_image_path(path, ip);
+    if (rc < 0)
+        return rc;
+    // The mount root and the partition roots are not entries that can change
+    if (rc == 1 || ip->n_components == 0)
+        return -EPERM;
+    if (!mount_get_partition(m, ip->partition_idx))
+        return -ENOENT;
+    if (!partition_writable(m, ip->partition_idx))
+        return -EROFS;
+    *out = get_partition_hfs(m, ip->partition_idx);
+    return 0;
+}
+
+// Finish a write: copy the changed blocks to the image file and commit them
+// (rc == 0), or drop them and re-read the volume.  Either way cached
+// resource maps of the mount may be stale.
+static int finish_write(image_mount_t *m, hfs_volume_t *hfs, int rc) {
+    if (rc == 0 && image_write_back(m->img) != 0)
+        rc = -EIO;
+    if (rc < 0) {
+        image_discard_changes(m->img);
+        hfs_refresh(hfs);
+    } else {
+        // Our own write moved the mtime; keep the mount from looking swapped
+        capture_identity(m, m->host_path);
+    }
+    rsrc_cache_drop_for_mount(m);
+    return rc;
+}
+
+static int img_mkdir(void *ctx, const char *path) {
+    image_mount_t *m = (image_mount_t *)ctx;
+    image_path_t ip;
+    hfs_volume_t *hfs = NULL;
+    int rc = write_target(m, path, &ip, &hfs);
+    if (rc < 0)
+        return rc == -EPERM ? -EEXIST : rc;
+    return finish_write(m, hfs, hfs_mkdir(hfs, ip.components, ip.n_components));
+}
+
+// unlink: removes a file (both forks) or an empty folder.
+static int img_unlink(void *ctx, const char *path) {
+    image_mount_t *m = (image_mount_t *)ctx;
+    image_path_t ip;
+    hfs_volume_t *hfs = NULL;
+    int rc = write_target(m, path, &ip, &hfs);
+    if (rc < 0)
+        return rc;
+    return finish_write(m, hfs, hfs_remove(hfs, ip.components, ip.n_components));
+}
+
+static int img_put_file(void *ctx, const char *path, const vfs_put_t *put) {
+    image_mount_t *m = (image_mount_t *)ctx;
+    image_path_t ip;
+    hfs_volume_t *hfs = NULL;
+    if (!put)
+        return -EINVAL;
+    int rc = write_target(m, path, &ip, &hfs);
+    if (rc < 0)
+        return rc == -EPERM ? -EISDIR : rc;
+    hfs_put_t hp = {
+        .data = put->data,
+        .data_len = put->data_len,
+        .rsrc = put->rsrc,
+        .rsrc_len = put->rsrc_len,
+        .finder_info = put->finder_info,
+    };
+    return finish_write(m, hfs, hfs_put_file(hfs, ip.components, ip.n_components, &hp));
 }
 
+// rename is not supported inside images.
 static int img_readonly2(void *ctx, const char *a, const char *b) {
     (void)ctx;
     (void)a;
@@ -1588,9 +1729,10 @@ static const vfs_backend_t image_backend = {
     .open = img_open,
     .read = img_read,
     .close = img_close,
-    .mkdir = img_readonly,
-    .unlink = img_readonly,
+    .mkdir = img_mkdir,
+    .unlink = img_unlink,
     .rename = img_readonly2,
+    .put_file = img_put_file,
 };
 
 const vfs_backend_t *vfs_image_backend(void) {
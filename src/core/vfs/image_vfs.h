@@ -9,8 +9,10 @@
 // in-image path is what backend methods (stat/opendir/readdir/...)
 // consume — identical to how host_vfs handles ordinary POSIX paths.
 //
-// Read-only: mkdir/unlink/rename slots in the backend vtable are static
-// `-EROFS` rejecters, never conditionally writable.
+// Classic HFS partitions of flat image files are writable through mkdir /
+// unlink / put_file; each call is written back to the image file before it
+// returns.  Everything else (HFS+, UFS, DiskCopy and NDIF images, rename)
+// is refused with -EROFS.
 
 #pragma once
 
@@ -35,8 +37,9 @@ const vfs_backend_t *vfs_image_backend(void);
 // success and sets *out_mount; returns -ENOTDIR if the file is not a
 // recognised image, or a negated errno on other failure.
 //
-// -EBUSY is returned if the file is currently attached via hd/cdrom; the
-// caller must fall through to "cannot descend" behaviour.
+// -EBUSY is returned if the file is currently attached (see
+// image_vfs_notify_attached); the caller must fall through to "cannot
+// descend" behaviour.
 int image_vfs_acquire_mount(const char *host_path, image_mount_t **out_mount);
 
 // Explicit force-close.  Drops the cache entry for the given absolute
@@ -60,10 +63,10 @@ typedef void (*image_vfs_list_cb)(const char *host_path, const char *format_name
                                   uint32_t refcount, bool conflicted, void *user);
 void image_vfs_list(image_vfs_list_cb cb, void *user);
 
-// Notify the mount cache that `host_path` is now attached to the SCSI
-// bus.  Any existing mount for that file is marked conflicted; subsequent
-// backend calls return -EBUSY.  A subsequent image_vfs_notify_detached
-// clears the flag so fresh mounts can proceed.
+// Notify the mount cache that `host_path` is now attached to the emulator
+// (counted, so paired calls nest).  Any existing mount for that file is
+// marked conflicted and new mounts are refused; backend calls return
+// -EBUSY.  The last matching image_vfs_notify_detached lifts both.
 void image_vfs_notify_attached(const char *host_path);
 void image_vfs_notify_detached(const char *host_path);
 
@@ -393,6 +393,19 @@ int vfs_unlink(const char *path) {
     return be->unlink(ctx, tail);
 }
 
+int vfs_put_file(const char *path, const vfs_put_t *put) {
+    char resolved[VFS_PATH_MAX];
+    const vfs_backend_t *be = NULL;
+    void *ctx = NULL;
+    const char *tail = NULL;
+    int rc = vfs_resolve(path, resolved, sizeof(resolved), &be, &ctx, &tail);
+    if (rc)
+        return rc;
+    if (!be->put_file)
+        return -EROFS;
+    return be->put_file(ctx, tail, put);
+}
+
 int vfs_rename(const char *src, const char *dst) {
     char src_resolved[VFS_PATH_MAX];
     char dst_resolved[VFS_PATH_MAX];
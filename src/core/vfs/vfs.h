@@ -44,6 +44,16 @@ typedef struct vfs_dirent {
 typedef struct vfs_file vfs_file_t;
 typedef struct vfs_dir vfs_dir_t;
 
+// Whole-file contents for vfs_put_file: data fork, resource fork and the
+// 32-byte Finder info (NULL = zeroed on create, unchanged on replace).
+typedef struct vfs_put {
+    const void *data;
+    size_t data_len;
+    const void *rsrc;
+    size_t rsrc_len;
+    const uint8_t *finder_info;
+} vfs_put_t;
+
 // Backend vtable.  Every method receives the backend's own ctx pointer
 // (which is NULL for the host backend since it is stateless).
 typedef struct vfs_backend {
@@ -57,12 +67,14 @@ typedef struct vfs_backend {
     int (*read)(vfs_file_t *f, uint64_t off, void *buf, size_t n, size_t *nread);
     void (*close)(vfs_file_t *f);
 
-    // Writable operations. Image-backed paths reject these (the image
-    // backend installs static `-EROFS` rejecters); only the host backend
-    // actually mutates the filesystem.
+    // Writable operations.  The image backend implements mkdir / unlink /
+    // put_file on classic HFS partitions and returns -EROFS elsewhere (and
+    // for rename); put_file is NULL for the host backend, where files are
+    // written with stdio.
     int (*mkdir)(void *ctx, const char *path);
     int (*unlink)(void *ctx, const char *path);
     int (*rename)(void *ctx, const char *src, const char *dst);
+    int (*put_file)(void *ctx, const char *path, const vfs_put_t *put); // create or replace
 } vfs_backend_t;
 
 // Host backend accessor.  Returns a pointer to a static vtable; the ctx
@@ -104,6 +116,10 @@ int vfs_mkdir(const char *path);
 int vfs_unlink(const char *path);
 int vfs_rename(const char *src, const char *dst);
 
+// Create or replace the file at `path` with both forks and its Finder info
+// in one step.  -EROFS when the backend has no put_file.
+int vfs_put_file(const char *path, const vfs_put_t *put);
+
 // Export a disk image referenced by a VFS path as a flat **raw** image on
 // the host.  `src` may be a plain host image (raw / Disk Copy 4.2) or a disk
 // image nested inside a mounted image (e.g. an NDIF `.img` inside a Toast CD);
@@ -2,7 +2,7 @@
 // Copyright (c) pappadf
 
 // vfs_class.c
-// Object-model class descriptor for `vfs` (vfs.ls / .mkdir / .cat).
+// Object-model class descriptor for `vfs` (vfs.ls / .mkdir / .rm / .cat).
 // Split out from vfs.c so unit tests linking the core path-resolver
 // don't pull in object-model dependencies.
 
@@ -19,7 +19,7 @@
 
 // === Object-model class descriptor =========================================
 //
-// Wraps the shell's filesystem commands (ls, mkdir, cat) under a single
+// Wraps the shell's filesystem commands (ls, mkdir, rm, cat) under a single
 // object so scripts have a typed entry point. Each method delegates to
 // the vfs core API.
 
@@ -123,6 +123,22 @@ static value_t vfs_method_mkdir(struct object *self, const member_t *m, int argc
     return val_bool(false);
 }
 
+static value_t vfs_method_rm(struct object *self, const member_t *m, int argc, const value_t *argv) {
+    (void)self;
+    (void)m;
+    (void)argc;
+    const char *path = argv[0].s;
+    if (!path || !*path)
+        return val_err("vfs.rm: expected a non-empty path");
+    int rc = vfs_unlink(path);
+    if (rc == 0) {
+        printf("Removed '%s'\n", path);
+        return val_bool(true);
+    }
+    printf("rm: cannot remove '%s': %s\n", path, strerror(-rc));
+    return val_bool(false);
+}
+
 static value_t vfs_method_cat(struct object *self, const member_t *m, int argc, const value_t *argv) {
     (void)self;
     (void)m;
@@ -183,6 +199,10 @@ static const member_t vfs_members[] = {
      .name = "mkdir",
      .doc = "Create a directory",
      .method = {.args = vfs_path_arg, .nargs = 1, .result = V_BOOL, .fn = vfs_method_mkdir}        },
+    {.kind = M_METHOD,
+     .name = "rm",
+     .doc = "Remove a file (inside an image: a file or an empty folder)",
+     .method = {.args = vfs_path_arg, .nargs = 1, .result = V_BOOL, .fn = vfs_method_rm}           },
     {.kind = M_METHOD,
      .name = "cat",
      .doc = "Print the raw bytes of a file (data fork, rsrc, finder_info)",
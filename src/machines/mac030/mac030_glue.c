@@ -150,21 +150,23 @@ void mac030_build_core(config_t *cfg, checkpoint_t *cp) {
 void mac030_fill_page(uint32_t page_index, uint8_t *host_ptr, bool writable) {
     if ((int)page_index >= g_page_count)
         return;
-    g_page_table[page_index].host_base = host_ptr;
-    g_page_table[page_index].dev = NULL;
-    g_page_table[page_index].dev_context = NULL;
-    g_page_table[page_index].writable = writable;
+    page_entry_t *pe = memory_page_mut(page_index);
+    pe->host_base = host_ptr;
+    pe->dev = NULL;
+    pe->dev_context = NULL;
+    pe->writable = writable;
     uint32_t guest_base = page_index << PAGE_SHIFT;
     uintptr_t adjusted = (uintptr_t)host_ptr - guest_base;
+    memory_code_window_drop(page_index);
     if (g_supervisor_read)
-        g_supervisor_read[page_index] = adjusted;
+        memory_soa_set(g_supervisor_read, page_index, adjusted);
     if (g_user_read)
-        g_user_read[page_index] = adjusted;
+        memory_soa_set(g_user_read, page_index, adjusted);
     if (writable) {
         if (g_supervisor_write)
-            g_supervisor_write[page_index] = adjusted;
+            memory_soa_set(g_supervisor_write, page_index, adjusted);
         if (g_user_write)
-            g_user_write[page_index] = adjusted;
+            memory_soa_set(g_user_write, page_index, adjusted);
     }
 }
 
@@ -179,7 +181,7 @@ void mac030_glue_set_rom_overlay(config_t *cfg, bool *overlay_flag, uint32_t rom
     uint32_t rom_start_page = rom_start >> PAGE_SHIFT;
     if (on) {
         for (uint32_t p = 0; p < rom_pages && (int)p < g_page_count; p++)
-            mac030_fill_page(p, g_page_table[rom_start_page + p].host_base, false);
+            mac030_fill_page(p, memory_page(rom_start_page + p)->host_base, false);
     } else {
         uint8_t *ram_base = ram_native_pointer(cfg->mem_map, 0);
         for (uint32_t p = 0; p < rom_pages && (int)p < g_page_count; p++)
@@ -298,26 +298,28 @@ static void iifx_trigger_vbl(config_t *cfg);
 static void iifx_fill_page(uint32_t page_index, uint8_t *host_ptr, bool writable) {
     if ((int)page_index >= g_page_count)
         return;
-    g_page_table[page_index].host_base = host_ptr;
-    g_page_table[page_index].dev = NULL;
-    g_page_table[page_index].dev_context = NULL;
-    g_page_table[page_index].writable = writable;
+    page_entry_t *pe = memory_page_mut(page_index);
+    pe->host_base = host_ptr;
+    pe->dev = NULL;
+    pe->dev_context = NULL;
+    pe->writable = writable;
     uint32_t guest_base = page_index << PAGE_SHIFT;
     uintptr_t adjusted = (uintptr_t)host_ptr - guest_base;
+    memory_code_window_drop(page_index);
     if (g_supervisor_read)
-        g_supervisor_read[page_index] = adjusted;
+        memory_soa_set(g_supervisor_read, page_index, adjusted);
     if (g_user_read)
-        g_user_read[page_index] = adjusted;
+        memory_soa_set(g_user_read, page_index, adjusted);
     if (writable) {
         if (g_supervisor_write)
-            g_supervisor_write[page_index] = adjusted;
+            memory_soa_set(g_supervisor_write, page_index, adjusted);
         if (g_user_write)
-            g_user_write[page_index] = adjusted;
+            memory_soa_set(g_user_write, page_index, adjusted);
     } else {
         if (g_supervisor_write)
-            g_supervisor_write[page_index] = 0;
+            memory_soa_set(g_supervisor_write, page_index, 0);
         if (g_user_write)
-            g_user_write[page_index] = 0;
+            memory_soa_set(g_user_write, page_index, 0);
     }
 }
 
@@ -435,19 +437,21 @@ static void iifx_apply_fmc_rom_invert(config_t *cfg, bool enable) {
 static void iifx_arm_rom_trap_page(iifx_state_t *st, config_t *cfg, uint32_t page_index) {
     if ((int)page_index >= g_page_count)
         return;
-    g_page_table[page_index].host_base = NULL;
-    g_page_table[page_index].dev = &st->rom_interface;
-    g_page_table[page_index].dev_context = cfg;
-    g_page_table[page_index].base_addr = (uint32_t)IIFX_ROM_START;
-    g_page_table[page_index].writable = false;
+    page_entry_t *pe = memory_page_mut(page_index);
+    pe->host_base = NULL;
+    pe->dev = &st->rom_interface;
+    pe->dev_context = cfg;
+    pe->base_addr = (uint32_t)IIFX_ROM_START;
+    pe->writable = false;
+    memory_code_window_drop(page_index);
     if (g_supervisor_read)
-        g_supervisor_read[page_index] = 0;
+        memory_soa_set(g_supervisor_read, page_index, 0);
     if (g_supervisor_write)
-        g_supervisor_write[page_index] = 0;
+        memory_soa_set(g_supervisor_write, page_index, 0);
     if (g_user_read)
-        g_user_read[page_index] = 0;
+        memory_soa_set(g_user_read, page_index, 0);
     if (g_user_write)
-        g_user_write[page_index] = 0;
+        memory_soa_set(g_user_write, page_index, 0);
 }
 
 // Sets or clears the reset-time ROM overlay at physical zero.
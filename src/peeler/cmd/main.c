@@ -5,10 +5,11 @@
 // CLI entry point for the `peeler` tool.
 //
 // Usage:  peeler <archive> [<output-dir>]
+//         peeler - [<output-dir>]      (archive read from stdin)
 //
-// Reads the archive, peels all layers, and writes each extracted file to
-// the output directory.  Resource forks are emitted as AppleDouble (._)
-// sidecar files.
+// Streams the archive through all layers and writes each extracted file to
+// the output directory as it comes out.  Resource forks are emitted as
+// AppleDouble (._) sidecar files.
 
 #include "peeler.h"
 
@@ -84,38 +85,27 @@ static bool ensure_parent_dirs(const char *path) {
     return true;
 }
 
-// Write raw bytes to a file.  Returns true on success.
-static bool write_blob(const char *path, const uint8_t *data, size_t len) {
-    FILE *fp = fopen(path, "wb");
-    if (!fp) {
-        return false;
-    }
-    bool ok = (fwrite(data, 1, len, fp) == len);
-    fclose(fp);
-    return ok;
-}
-
-// Write the data fork of a file to the output directory.
-static bool write_data_fork(const char *dir, const peel_file_t *f) {
-    const char *name = f->meta.name[0] ? f->meta.name : "unnamed";
+// Open the data-fork file for name under dir, creating parent directories.
+static FILE *open_data_fork(const char *dir, const char *name) {
     char path[1024];
     if (!build_path(path, sizeof(path), dir, name)) {
         fprintf(stderr, "peeler: path too long for '%s'\n", name);
-        return false;
+        return NULL;
     }
     if (!ensure_parent_dirs(path)) {
         fprintf(stderr, "peeler: cannot create directories for '%s'\n", name);
-        return false;
+        return NULL;
     }
-    return write_blob(path, f->data_fork.data, f->data_fork.size);
+    return fopen(path, "wb");
 }
 
-// Build an AppleDouble header file containing Finder info and the resource
-// fork.  Layout: [header][finder_entry_desc][rsrc_entry_desc][finder_data][rsrc_data]
+// Open the ._<name> AppleDouble sidecar for name under dir and write its
+// header and Finder info, leaving the file positioned where the resource
+// fork data goes.
+// Layout: [header][finder_entry_desc][rsrc_entry_desc][finder_data][rsrc_data]
 // appledouble.md § "Writing & Updating Rules"
-static bool write_appledouble(const char *dir, const peel_file_t *f) {
-    const char *name = f->meta.name[0] ? f->meta.name : "unnamed";
-
+static FILE *open_appledouble(const char *dir, const char *name, const peel_file_meta_t *meta,
+                              uint64_t rsrc_len) {
     // Build ._<name> sidecar path, inserting ._ before the filename
     // component (e.g. "dir/subdir/._file" not "dir/._ subdir/file").
     char path[1024];
@@ -130,27 +120,25 @@ static bool write_appledouble(const char *dir, const peel_file_t *f) {
     }
     if (n <= 0 || (size_t)n >= sizeof(path)) {
         fprintf(stderr, "peeler: path too long for '._%s'\n", name);
-        return false;
+        return NULL;
     }
     if (!ensure_parent_dirs(path)) {
         fprintf(stderr, "peeler: cannot create directories for '._%s'\n", name);
-        return false;
+        return NULL;
+    }
+    if (rsrc_len > UINT32_MAX) {
+        fprintf(stderr, "peeler: resource fork of '%s' is too large\n", name);
+        return NULL;
     }
 
     // Layout depends on whether resource fork data is present:
     //   - With rsrc: header(26) + 2 descriptors(24) + FinderInfo(32) + rsrc data
     //   - Without:   header(26) + 1 descriptor(12)  + FinderInfo(32)
-    bool has_rsrc = (f->resource_fork.size > 0);
+    bool has_rsrc = (rsrc_len > 0);
     size_t num_entries = has_rsrc ? 2 : 1;
     uint32_t finder_offset = (uint32_t)(AD_HEADER_SIZE + num_entries * AD_ENTRY_SIZE);
     uint32_t rsrc_offset = finder_offset + AD_FINDER_LEN;
-    size_t total = has_rsrc ? rsrc_offset + f->resource_fork.size
-                            : finder_offset + AD_FINDER_LEN;
-
-    uint8_t *buf = calloc(1, total);
-    if (!buf) {
-        return false;
-    }
+    uint8_t buf[AD_HEADER_SIZE + 2 * AD_ENTRY_SIZE + AD_FINDER_LEN] = {0};
 
     // Fixed header — appledouble.md § "Fixed Header"
     uint8_t *p = buf;
@@ -158,7 +146,7 @@ static bool write_appledouble(const char *dir, const peel_file_t *f) {
     p += 4;
     put_be32(p, APPLEDOUBLE_VERSION);
     p += 4;
-    // 16 bytes filler (already zero from calloc)
+    // 16 bytes filler (already zero)
     p += 16;
     put_be16(p, (uint16_t)num_entries);
     p += 2;
@@ -177,31 +165,118 @@ static bool write_appledouble(const char *dir, const peel_file_t *f) {
         p += 4;
         put_be32(p, rsrc_offset);
         p += 4;
-        put_be32(p, (uint32_t)f->resource_fork.size);
+        put_be32(p, (uint32_t)rsrc_len);
         p += 4;
     }
 
     // Finder Info payload: type(4) + creator(4) + flags(2) + padding(22)
     // appledouble.md § "Finder Info"
     uint8_t *finder = buf + finder_offset;
-    put_be32(finder, f->meta.mac_type);
-    put_be32(finder + 4, f->meta.mac_creator);
-    put_be16(finder + 8, f->meta.finder_flags);
-    // Remaining 22 bytes are zero (from calloc)
+    put_be32(finder, meta->mac_type);
+    put_be32(finder + 4, meta->mac_creator);
+    put_be16(finder + 8, meta->finder_flags);
+    // Remaining 22 bytes are zero
 
-    // Resource fork payload (only if present)
-    if (has_rsrc) {
-        memcpy(buf + rsrc_offset, f->resource_fork.data, f->resource_fork.size);
+    // The resource fork data follows as the sink receives it
+    FILE *fp = fopen(path, "wb");
+    if (fp && fwrite(buf, 1, rsrc_offset, fp) != rsrc_offset) {
+        fclose(fp);
+        fp = NULL;
     }
+    return fp;
+}
+
+// ============================================================================
+// Output Sink
+//
+// Each file is written as it is extracted: the data fork to <dir>/<name> and
+// the resource fork into the ._<name> sidecar.  A file that cannot be written
+// is reported and counted, and extraction carries on with the next one.
+// ============================================================================
 
-    bool ok = write_blob(path, buf, total);
-    free(buf);
-    return ok;
+// Per-run state of the disk sink.
+typedef struct {
+    const char *dir;
+    char name[512];
+    FILE *fork[2];   // Indexed by peel_fork_t
+    bool failed[2];  // Reported already
+    int failures;
+} disk_sink_t;
+
+// Report a write failure for one of the current file's outputs (once).
+static void disk_fail(disk_sink_t *d, peel_fork_t fork) {
+    if (!d->failed[fork]) {
+        fprintf(stderr, "peeler: failed to write '%s%s'\n",
+                fork == PEEL_RESOURCE_FORK ? "._" : "", d->name);
+        d->failed[fork] = true;
+        d->failures++;
+    }
+    if (d->fork[fork]) {
+        fclose(d->fork[fork]);
+        d->fork[fork] = NULL;
+    }
+}
+
+// Sink callback: open the outputs for a new file.
+static int disk_begin(void *ctx, const peel_file_meta_t *meta, uint64_t data_len, uint64_t rsrc_len) {
+    disk_sink_t *d = ctx;
+    (void)data_len;
+    snprintf(d->name, sizeof(d->name), "%s", meta->name[0] ? meta->name : "unnamed");
+    d->failed[PEEL_DATA_FORK] = d->failed[PEEL_RESOURCE_FORK] = false;
+
+    // Write data fork (always, even if empty — Mac archives track
+    // files that have only a resource fork or metadata).
+    d->fork[PEEL_DATA_FORK] = open_data_fork(d->dir, d->name);
+    if (!d->fork[PEEL_DATA_FORK]) {
+        disk_fail(d, PEEL_DATA_FORK);
+    }
+
+    // Write resource fork as AppleDouble sidecar.  Create a sidecar
+    // whenever there is resource fork data OR Finder metadata
+    // (type/creator/flags), since the sidecar carries both.
+    if (rsrc_len > 0 || meta->mac_type != 0 || meta->mac_creator != 0 || meta->finder_flags != 0) {
+        d->fork[PEEL_RESOURCE_FORK] = open_appledouble(d->dir, d->name, meta, rsrc_len);
+        if (!d->fork[PEEL_RESOURCE_FORK]) {
+            disk_fail(d, PEEL_RESOURCE_FORK);
+        }
+    }
+    return 0;
+}
+
+// Sink callback: append fork bytes to the matching output.
+static int disk_write(void *ctx, peel_fork_t fork, const uint8_t *buf, size_t len) {
+    disk_sink_t *d = ctx;
+    if (d->fork[fork] && fwrite(buf, 1, len, d->fork[fork]) != len) {
+        disk_fail(d, fork);
+    }
+    return 0;
+}
+
+// Sink callback: close the current file's outputs.
+static int disk_end(void *ctx) {
+    disk_sink_t *d = ctx;
+    for (int i = 0; i < 2; i++) {
+        if (d->fork[i] && fclose(d->fork[i]) != 0) {
+            d->fork[i] = NULL;
+            disk_fail(d, (peel_fork_t)i);
+        }
+        d->fork[i] = NULL;
+    }
+    return 0;
+}
+
+// Reader callback over stdin: forward-only, so peel_stream() gets no seek.
+static ptrdiff_t stdin_read(void *ctx, uint8_t *buf, size_t len) {
+    size_t n = fread(buf, 1, len, (FILE *)ctx);
+    if (n == 0 && ferror((FILE *)ctx)) {
+        return -1;
+    }
+    return (ptrdiff_t)n;
 }
 
 // Print usage text and exit.
 static void usage(const char *progname) {
-    fprintf(stderr, "usage: %s <archive> [<output-dir>]\n", progname);
+    fprintf(stderr, "usage: %s <archive|-> [<output-dir>]\n", progname);
 }
 
 // ============================================================================
@@ -223,40 +298,22 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    // Peel the archive
+    // Peel the archive, writing each file as it comes out
+    disk_sink_t disk = {.dir = output_dir};
+    peel_sink_t sink = {.begin = disk_begin, .write = disk_write, .end = disk_end, .ctx = &disk};
     peel_err_t *err = NULL;
-    peel_file_list_t files = peel_path(input_path, &err);
-    if (err) {
+    int files;
+    if (strcmp(input_path, "-") == 0) {
+        peel_reader_t in = {.read = stdin_read, .ctx = stdin};
+        files = peel_stream(&in, &sink, &err);
+    } else {
+        files = peel_stream_path(input_path, &sink, &err);
+    }
+    if (files < 0) {
+        disk_end(&disk);
         fprintf(stderr, "peeler: %s\n", peel_err_msg(err));
         peel_err_free(err);
         return 1;
     }
-
-    // Write each extracted file to disk
-    int failures = 0;
-    for (int i = 0; i < files.count; i++) {
-        const peel_file_t *f = &files.files[i];
-
-        // Write data fork (always, even if empty — Mac archives track
-        // files that have only a resource fork or metadata).
-        if (!write_data_fork(output_dir, f)) {
-            fprintf(stderr, "peeler: failed to write '%s'\n", f->meta.name);
-            failures++;
-        }
-
-        // Write resource fork as AppleDouble sidecar.  Create a sidecar
-        // whenever there is resource fork data OR Finder metadata
-        // (type/creator/flags), since the sidecar carries both.
-        if (f->resource_fork.size > 0 ||
-            f->meta.mac_type != 0 || f->meta.mac_creator != 0 ||
-            f->meta.finder_flags != 0) {
-            if (!write_appledouble(output_dir, f)) {
-                fprintf(stderr, "peeler: failed to write '._%s'\n", f->meta.name);
-                failures++;
-            }
-        }
-    }
-
-    peel_file_list_free(&files);
-    return failures > 0 ? 1 : 0;
+    return disk.failures > 0 ? 1 : 0;
 }
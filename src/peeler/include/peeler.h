@@ -47,7 +47,7 @@ void peel_free(peel_buf_t *buf);
 // Metadata for a single file extracted from an archive.
 // Fields are best-effort; zeroed when the format does not provide them.
 typedef struct {
-    char name[256]; // Original Mac filename (null-terminated)
+    char name[512]; // Original Mac filename, folder path for nested entries (null-terminated)
     uint32_t mac_type; // Classic Mac file type  (e.g. 'TEXT')
     uint32_t mac_creator; // Classic Mac creator    (e.g. 'ttxt')
     uint16_t finder_flags; // Finder flags
@@ -92,15 +92,68 @@ peel_buf_t peel_buf_wrap(const void *src, size_t len);
 // Returns a short name ("hqx", "bin", "sit", "cpt") or NULL if unknown.
 const char *peel_detect(const uint8_t *src, size_t len);
 
+// Identify the outermost format of a file from its first 64 KiB (the bytes
+// peel_stream() detects from).  NULL if unknown or unreadable.
+const char *peel_detect_path(const char *path);
+
 // === Main Entry Points ===
 
 // Detect, peel all layers, return extracted files.
 // Handles arbitrarily nested formats (e.g. .sit.hqx).
 peel_file_list_t peel(const uint8_t *src, size_t len, peel_err_t **err);
 
-// Convenience: read the file at path, then peel().
+// Convenience: stream the file at path through peel_stream(), collecting
+// the extracted files in memory.
 peel_file_list_t peel_path(const char *path, peel_err_t **err);
 
+// === Streaming ===
+//
+// peel_stream() pulls the input through a reader and pushes each extracted
+// file through a sink, one fork at a time, so memory stays bounded by the
+// decoders' windows rather than the size of the archive or its files.
+// Layers are chained the same way: a .sit.hqx is decoded by a StuffIt layer
+// reading from a BinHex layer reading from the caller's reader.
+
+// Length of a fork (or input) that is not known up front.
+#define PEEL_SIZE_UNKNOWN UINT64_MAX
+
+// Input: read fills buf with up to len bytes and returns how many (0 at the
+// end of the input, -1 on error).  seek moves to an absolute offset and
+// returns 0, or -1 on error; NULL for a forward-only input.  Compact Pro keeps
+// its directory at the end of the archive, so a forward-only .cpt input is
+// buffered in memory.
+typedef struct {
+    ptrdiff_t (*read)(void *ctx, uint8_t *buf, size_t len);
+    int (*seek)(void *ctx, uint64_t offset);
+    void *ctx;
+} peel_reader_t;
+
+// The two forks of a Macintosh file.
+typedef enum {
+    PEEL_DATA_FORK,
+    PEEL_RESOURCE_FORK,
+} peel_fork_t;
+
+// Output: for every file, begin (with both fork lengths, PEEL_SIZE_UNKNOWN
+// for data passed through from an input of unknown length), then the bytes
+// of each non-empty fork via write — each fork contiguously and exactly its
+// announced length, resource fork first when the archive stores it first —
+// then end.  A non-zero return aborts peeling.  Any callback may be NULL.
+typedef struct {
+    int (*begin)(void *ctx, const peel_file_meta_t *meta, uint64_t data_len, uint64_t rsrc_len);
+    int (*write)(void *ctx, peel_fork_t fork, const uint8_t *buf, size_t len);
+    int (*end)(void *ctx);
+    void *ctx;
+} peel_sink_t;
+
+// Detect and peel all layers of the input, delivering files to out.
+// Returns the number of files delivered, or -1 with *err set (files already
+// delivered stay delivered).
+int peel_stream(const peel_reader_t *in, const peel_sink_t *out, peel_err_t **err);
+
+// peel_stream() over the file at path (seekable).
+int peel_stream_path(const char *path, const peel_sink_t *out, peel_err_t **err);
+
 // === Per-Format Entry Points (Wrappers: buf → buf) ===
 
 // BinHex 4.0 (.hqx) — peel wrapper, return data fork only.
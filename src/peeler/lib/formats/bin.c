@@ -50,6 +50,22 @@ typedef struct {
     uint16_t sec_hdr_len;       // Secondary header length (offset 120)
 } bin_header_t;
 
+// A parsed file record and where its forks lie in the input.
+typedef struct {
+    bin_header_t hdr;
+    uint64_t data_off;          // Input offset of the data fork
+    uint64_t rsrc_off;          // Input offset of the resource fork
+} bin_file_t;
+
+// Reader over one fork's bytes in the input.
+typedef struct {
+    peel_in_t *in;
+    uint64_t start;             // Input offset of the fork
+    uint64_t len;               // Fork length
+    uint64_t pos;               // Next fork byte to read
+    const char *fork_name;      // For truncation errors
+} bin_region_t;
+
 // ============================================================================
 // Static Helpers
 // ============================================================================
@@ -152,15 +168,19 @@ static bin_header_t bin_parse_header(const uint8_t *hdr) {
 }
 
 // ============================================================================
-// Static Helpers — Full Decode Pipeline
+// Static Helpers — Stream Setup
 // ============================================================================
 
-// Decode a MacBinary file into a peel_file_t with both forks and metadata.
-// This is the shared implementation for both peel_bin and peel_bin_file.
-// bin.md § 14.1 — decoding steps for a MacBinary II file record.
-static peel_file_t bin_decode(const uint8_t *src, size_t len,
-                              decode_ctx_t *ctx) {
+// Read and validate the header of the file record at the input's position,
+// and locate its forks.  bin.md § 14.1 — decoding steps for a MacBinary II
+// file record.
+static bin_file_t bin_start(peel_in_t *in) {
+    decode_ctx_t *ctx = in->ctx;
+    uint64_t start = in_tell(in);
+
     // bin.md § 14.1 step 1 — need at least 128 bytes for the header
+    const uint8_t *src;
+    size_t len = in_peek(in, MB_BLOCK, &src);
     if (len < MB_BLOCK) {
         decode_abort(ctx, "MacBinary: input too short (%zu bytes)", len);
     }
@@ -171,77 +191,94 @@ static peel_file_t bin_decode(const uint8_t *src, size_t len,
     }
 
     // Parse header metadata
-    bin_header_t hdr = bin_parse_header(src);
+    bin_file_t f;
+    f.hdr = bin_parse_header(src);
 
     // bin.md § 6.3 — bounds-check fork lengths
-    if (hdr.data_len > 0x7FFFFFFFu || hdr.rsrc_len > 0x7FFFFFFFu) {
+    if (f.hdr.data_len > 0x7FFFFFFFu || f.hdr.rsrc_len > 0x7FFFFFFFu) {
         decode_abort(ctx, "MacBinary: fork length exceeds maximum");
     }
 
     // bin.md § 14.1 step 3 — advance past header and optional secondary header
-    size_t pos = MB_BLOCK;
-    if (hdr.sec_hdr_len > 0) {
+    f.data_off = start + MB_BLOCK;
+    if (f.hdr.sec_hdr_len > 0) {
         // bin.md § 9.2 — skip secondary header + alignment padding
-        pos += hdr.sec_hdr_len + pad128(hdr.sec_hdr_len);
-    }
-
-    // bin.md § 14.1 step 4 — read the data fork
-    if (pos + hdr.data_len > len) {
-        decode_abort(ctx, "MacBinary: data fork truncated");
-    }
-
-    peel_buf_t data_fork = {0};
-    if (hdr.data_len > 0) {
-        peel_err_t *copy_err = NULL;
-        data_fork = peel_buf_copy(src + pos, hdr.data_len, &copy_err);
-        if (copy_err) {
-            peel_err_free(copy_err);
-            decode_abort(ctx, "MacBinary: out of memory for data fork");
-        }
+        f.data_off += f.hdr.sec_hdr_len + pad128(f.hdr.sec_hdr_len);
     }
 
     // bin.md § 10.1 — skip data fork + padding to reach resource fork
-    pos += hdr.data_len + pad128(hdr.data_len);
-
-    // bin.md § 14.1 step 5 — read the resource fork
-    if (pos + hdr.rsrc_len > len) {
-        peel_free(&data_fork);
-        decode_abort(ctx, "MacBinary: resource fork truncated");
-    }
+    f.rsrc_off = f.data_off + f.hdr.data_len + pad128(f.hdr.data_len);
 
-    peel_buf_t rsrc_fork = {0};
-    if (hdr.rsrc_len > 0) {
-        peel_err_t *copy_err = NULL;
-        rsrc_fork = peel_buf_copy(src + pos, hdr.rsrc_len, &copy_err);
-        if (copy_err) {
-            peel_err_free(copy_err);
-            peel_free(&data_fork);
-            decode_abort(ctx, "MacBinary: out of memory for resource fork");
+    // bin.md § 14.1 steps 4–5 — when the input length is known, reject
+    // truncated forks up front; otherwise the region readers catch them
+    if (in->size != PEEL_SIZE_UNKNOWN) {
+        if (f.data_off + f.hdr.data_len > in->size) {
+            decode_abort(ctx, "MacBinary: data fork truncated");
+        }
+        if (f.rsrc_off + f.hdr.rsrc_len > in->size) {
+            decode_abort(ctx, "MacBinary: resource fork truncated");
         }
     }
+    return f;
+}
 
-    // Assemble the result file
-    peel_file_t file;
-    memset(&file, 0, sizeof(file));
+// Metadata for the decoded file.
+static peel_file_meta_t bin_meta(const bin_header_t *hdr) {
+    peel_file_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    memcpy(meta.name, hdr->name, hdr->name_len);
+    meta.name[hdr->name_len] = '\0';
+    meta.mac_type = hdr->mac_type;
+    meta.mac_creator = hdr->mac_creator;
 
-    // Copy filename into metadata
-    size_t nl = hdr.name_len;
-    if (nl > sizeof(file.meta.name) - 1) {
-        nl = sizeof(file.meta.name) - 1;
-    }
-    memcpy(file.meta.name, hdr.name, nl);
-    file.meta.name[nl] = '\0';
+    // bin.md § 14.1 step 8 / § 8.1 — sanitize Finder flags
+    meta.finder_flags = hdr->finder_flags & (uint16_t)~FINDER_CLEAR_MASK;
+    return meta;
+}
 
-    file.meta.mac_type = hdr.mac_type;
-    file.meta.mac_creator = hdr.mac_creator;
+// ============================================================================
+// Static Helpers — Fork Readers
+// ============================================================================
 
-    // bin.md § 14.1 step 8 / § 8.1 — sanitize Finder flags
-    file.meta.finder_flags = hdr.finder_flags & (uint16_t)~FINDER_CLEAR_MASK;
+// Allocate a reader over one fork.
+static bin_region_t *bin_region(peel_in_t *in, uint64_t start, uint32_t len,
+                                const char *fork_name) {
+    bin_region_t *r = ctx_alloc(in->ctx, sizeof(*r));
+    r->in = in;
+    r->start = start;
+    r->len = len;
+    r->fork_name = fork_name;
+    return r;
+}
 
-    file.data_fork = data_fork;
-    file.resource_fork = rsrc_fork;
+// Reader callback: the next bytes of the fork.
+static ptrdiff_t bin_region_read(void *ctx, uint8_t *buf, size_t len) {
+    bin_region_t *r = ctx;
+    if (len > r->len - r->pos) {
+        len = (size_t)(r->len - r->pos);
+    }
+    if (len == 0) {
+        return 0;
+    }
+    if (in_tell(r->in) != r->start + r->pos) {
+        in_seek(r->in, r->start + r->pos);
+    }
+    size_t n = in_read(r->in, buf, len);
+    if (n == 0) {
+        decode_abort(r->in->ctx, "MacBinary: %s fork truncated", r->fork_name);
+    }
+    r->pos += n;
+    return (ptrdiff_t)n;
+}
 
-    return file;
+// Seek callback: move within the fork.
+static int bin_region_seek(void *ctx, uint64_t offset) {
+    bin_region_t *r = ctx;
+    if (offset > r->len) {
+        return -1;
+    }
+    r->pos = offset;
+    return 0;
 }
 
 // ============================================================================
@@ -257,52 +294,75 @@ bool bin_detect(const uint8_t *src, size_t len) {
 }
 
 // ============================================================================
-// Operations (Public API) — Wrapper Peel
+// Operations — Stream Handlers
 // ============================================================================
 
-// Decode a MacBinary file and return a single fork as a flat buffer.
-// bin.md § 10.3 — if the data fork does not begin with a recognized StuffIt
-// signature and a resource fork exists, prefer the resource fork (common
-// pattern for .sea.bin self-extracting archives).
-peel_buf_t peel_bin(const uint8_t *src, size_t len, peel_err_t **err) {
-    *err = NULL;
-
-    // Use setjmp/longjmp for deep-error abort throughout the decode pipeline
-    decode_ctx_t ctx;
-    if (setjmp(ctx.jmp) != 0) {
-        *err = make_err("%s", ctx.errmsg);
-        return (peel_buf_t){0};
+// Open a single fork as this wrapper's payload.  bin.md § 10.3 — if the
+// data fork does not begin with a recognized StuffIt signature and a
+// resource fork exists, prefer the resource fork (common pattern for
+// .sea.bin self-extracting archives).
+uint64_t bin_open(peel_in_t *in, peel_reader_t *payload) {
+    bin_file_t f = bin_start(in);
+
+    // bin.md § 10.3 — apply fork selection heuristic to the data fork's head
+    const uint8_t *head;
+    in_seek(in, f.data_off);
+    size_t n = in_peek(in, 80, &head);
+    if (n > f.hdr.data_len) {
+        n = f.hdr.data_len;
     }
+    bool data_is_sit = n > 0 && looks_like_sit(head, n);
 
-    peel_file_t file = bin_decode(src, len, &ctx);
-
-    // bin.md § 10.3 — apply fork selection heuristic
-    peel_buf_t result;
-    bool data_is_sit = file.data_fork.data &&
-                       looks_like_sit(file.data_fork.data, file.data_fork.size);
-
-    if (data_is_sit || file.resource_fork.size == 0) {
+    bin_region_t *r;
+    if (data_is_sit || f.hdr.rsrc_len == 0) {
         // Data fork is a StuffIt archive, or no resource fork — use data fork
-        result = file.data_fork;
-        peel_free(&file.resource_fork);
+        r = bin_region(in, f.data_off, f.hdr.data_len, "data");
     } else {
         // bin.md § 16.2 — prefer resource fork for downstream processing
-        result = file.resource_fork;
-        peel_free(&file.data_fork);
+        r = bin_region(in, f.rsrc_off, f.hdr.rsrc_len, "resource");
     }
+    *payload = (peel_reader_t){
+        .read = bin_region_read,
+        .seek = in_seekable(in) ? bin_region_seek : NULL,
+        .ctx = r,
+    };
+    return r->len;
+}
 
-    return result;
+// Deliver the wrapped file with both forks and its metadata.
+void bin_extract(peel_in_t *in, peel_out_t *out) {
+    bin_file_t f = bin_start(in);
+    peel_file_meta_t meta = bin_meta(&f.hdr);
+    bin_region_t *data = bin_region(in, f.data_off, f.hdr.data_len, "data");
+    bin_region_t *rsrc =
+        bin_region(in, f.rsrc_off, f.hdr.rsrc_len, "resource");
+
+    out_begin(out, &meta, f.hdr.data_len, f.hdr.rsrc_len);
+    out_fork(out, PEEL_DATA_FORK,
+             &(peel_reader_t){.read = bin_region_read, .ctx = data});
+    out_fork(out, PEEL_RESOURCE_FORK,
+             &(peel_reader_t){.read = bin_region_read, .ctx = rsrc});
+    out_end(out);
+    ctx_free(in->ctx, data);
+    ctx_free(in->ctx, rsrc);
+}
+
+// ============================================================================
+// Operations (Public API) — Wrapper Peel
+// ============================================================================
+
+// Decode a MacBinary file and return a single fork as a flat buffer.
+peel_buf_t peel_bin(const uint8_t *src, size_t len, peel_err_t **err) {
+    return collect_payload(src, len, bin_open, err);
 }
 
 // Decode a MacBinary file and return both forks plus metadata.
 peel_file_t peel_bin_file(const uint8_t *src, size_t len, peel_err_t **err) {
-    *err = NULL;
-
-    decode_ctx_t ctx;
-    if (setjmp(ctx.jmp) != 0) {
-        *err = make_err("%s", ctx.errmsg);
+    peel_file_list_t list = collect_files(src, len, bin_extract, err);
+    if (*err) {
         return (peel_file_t){0};
     }
-
-    return bin_decode(src, len, &ctx);
+    peel_file_t file = list.files[0];
+    free(list.files);
+    return file;
 }
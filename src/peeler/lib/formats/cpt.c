@@ -10,6 +10,8 @@
 
 #include "internal.h"
 
+#include <limits.h>
+
 // ============================================================================
 // Constants and Macros
 //
@@ -401,36 +403,19 @@ static int cp_lzh_next(cp_lzh_t *lz, int *out) {
 }
 
 // ============================================================================
-// Memory-backed byte source
+// Span-backed byte source
 //
-// cpt.md § 9.1 "Memory Model" — the entire archive is kept in memory so fork data can be
-// accessed at arbitrary offsets; this adapter feeds bytes sequentially
-// to the bit reader.
+// cpt.md § 9.1 "Memory Model" — fork data is read at arbitrary offsets; this
+// adapter feeds the bytes of one fork's compressed span sequentially to the
+// bit reader.
 // ============================================================================
 
-// Memory-backed byte source for sequential archive reads.
-typedef struct {
-    const uint8_t *base;
-    size_t         pos;
-    size_t         end;
-} cp_memsrc_t;
-
-// Set up a memory source over a byte range within the archive buffer.
-static int cp_memsrc_init(cp_memsrc_t *m, const uint8_t *data, size_t archive_len,
-                          size_t offset, size_t length) {
-    if (!m || !data) return -1;
-    if (offset > archive_len || length > archive_len - offset) return -1;
-    m->base = data;
-    m->pos = offset;
-    m->end = offset + length;
-    return 0;
-}
-
-// Supply the next byte from the memory source; returns 1 on success, 0 at end.
-static int cp_memsrc_next(void *ctx, int *out) {
-    cp_memsrc_t *m = (cp_memsrc_t *)ctx;
-    if (m->pos >= m->end) return 0;
-    *out = m->base[m->pos++];
+// Supply the next byte of a fork's compressed span; returns 1 on success,
+// 0 at end.
+static int cp_span_next(void *ctx, int *out) {
+    int c = span_getc((peel_span_t *)ctx);
+    if (c < 0) return 0;
+    *out = c;
     return 1;
 }
 
@@ -545,9 +530,9 @@ static int cp_rle_read(cp_rle_t *r, uint8_t *dst, size_t max) {
 
 // Fork decompression stream: optional LZH chained into mandatory RLE.
 typedef struct {
-    int        use_lzh;
-    cp_lzh_t   lzh;        // only used when use_lzh is set
-    cp_memsrc_t memsrc;     // raw byte source from archive memory
+    int         use_lzh;
+    cp_lzh_t    lzh;        // only used when use_lzh is set
+    peel_span_t src;        // compressed bytes of this fork
     cp_rle_t    rle;
     size_t      remain;     // uncompressed bytes left to produce
     int         done;
@@ -558,28 +543,23 @@ static int cp_lzh_adapter(void *ctx, int *out) {
     return cp_lzh_next((cp_lzh_t *)ctx, out);
 }
 
-// Initialize a fork stream for RLE-only decompression.
-static void cp_fork_init_rle(cp_fork_t *f, const uint8_t *archive, size_t archive_len,
-                             size_t comp_offset, size_t comp_len, size_t uncomp_len) {
-    memset(f, 0, sizeof(*f));
-    f->use_lzh = 0;
-    f->remain = uncomp_len;
-    f->done = (uncomp_len == 0);
-    cp_memsrc_init(&f->memsrc, archive, archive_len, comp_offset, comp_len);
-    cp_rle_init(&f->rle, cp_memsrc_next, &f->memsrc);
-}
-
+// Initialize a fork stream over comp_len bytes at the input's cursor.
 // cpt.md § 9.5 "Fork Stream Composition" — LZH output is piped through
-// an adapter callback into the RLE decoder.
-static void cp_fork_init_lzh(cp_fork_t *f, const uint8_t *archive, size_t archive_len,
-                             size_t comp_offset, size_t comp_len, size_t uncomp_len) {
+// an adapter callback into the RLE decoder; RLE-only forks read the span
+// directly.
+static void cp_fork_init(cp_fork_t *f, peel_in_t *in, size_t comp_len,
+                         size_t uncomp_len, bool use_lzh) {
     memset(f, 0, sizeof(*f));
-    f->use_lzh = 1;
+    f->use_lzh = use_lzh;
     f->remain = uncomp_len;
     f->done = (uncomp_len == 0);
-    cp_memsrc_init(&f->memsrc, archive, archive_len, comp_offset, comp_len);
-    cp_lzh_init(&f->lzh, cp_memsrc_next, &f->memsrc);
-    cp_rle_init(&f->rle, cp_lzh_adapter, &f->lzh);
+    f->src = (peel_span_t){.in = in, .left = comp_len};
+    if (use_lzh) {
+        cp_lzh_init(&f->lzh, cp_span_next, &f->src);
+        cp_rle_init(&f->rle, cp_lzh_adapter, &f->lzh);
+    } else {
+        cp_rle_init(&f->rle, cp_span_next, &f->src);
+    }
 }
 
 // cpt.md § 9.5 "Fork Stream Composition" — each fork reads decompressed
@@ -587,6 +567,7 @@ static void cp_fork_init_lzh(cp_fork_t *f, const uint8_t *archive, size_t archiv
 static int cp_fork_read(cp_fork_t *f, uint8_t *dst, size_t max) {
     if (f->done || f->remain == 0) return 0;
     if (max > f->remain) max = f->remain;
+    if (max > INT_MAX) max = INT_MAX;
     int n = cp_rle_read(&f->rle, dst, max);
     if (n <= 0) { f->done = 1; return n; }
     f->remain -= (size_t)n;
@@ -594,6 +575,11 @@ static int cp_fork_read(cp_fork_t *f, uint8_t *dst, size_t max) {
     return n;
 }
 
+// Reader callback: the next decompressed bytes of a fork.
+static ptrdiff_t cp_fork_reader(void *ctx, uint8_t *buf, size_t len) {
+    return (ptrdiff_t)cp_fork_read((cp_fork_t *)ctx, buf, len);
+}
+
 // ============================================================================
 // CPT directory entry (file)
 //
@@ -636,16 +622,14 @@ typedef struct {
 // ============================================================================
 
 // Append a file entry to the archive's entry list, growing as needed.
-static int cp_push_entry(cp_archive_t *ar, const cp_entry_t *e) {
+static void cp_push_entry(cp_archive_t *ar, const cp_entry_t *e,
+                          decode_ctx_t *ctx) {
     if (ar->count >= ar->cap) {
         size_t ncap = ar->cap ? ar->cap * 2 : 16;
-        void *tmp = realloc(ar->entries, ncap * sizeof(cp_entry_t));
-        if (!tmp) return -1;
-        ar->entries = (cp_entry_t *)tmp;
+        ar->entries = ctx_realloc(ctx, ar->entries, ncap * sizeof(cp_entry_t));
         ar->cap = ncap;
     }
     ar->entries[ar->count++] = *e;
-    return 0;
 }
 
 // Concatenate parent and name into dst (max 256).
@@ -672,7 +656,8 @@ static void cp_join_path(char dst[256], const char *parent, const char *seg, siz
 // count C is followed by C depth-first entries.  Consumes C+1 entries
 // from the parent's remaining total.
 static int cp_walk_entries(cp_archive_t *ar, const uint8_t *data, size_t size,
-                           size_t *cursor, int remaining, const char *parent) {
+                           size_t *cursor, int remaining, const char *parent,
+                           decode_ctx_t *ctx) {
     while (remaining > 0) {
         if (*cursor >= size) return -1;
 
@@ -701,7 +686,8 @@ static int cp_walk_entries(cp_archive_t *ar, const uint8_t *data, size_t size,
             if (*cursor + 2 > size) return -1;
             uint16_t child_cnt = rd16be(data + *cursor);
             *cursor += 2;
-            int rc = cp_walk_entries(ar, data, size, cursor, (int)child_cnt, full);
+            int rc = cp_walk_entries(ar, data, size, cursor, (int)child_cnt,
+                                     full, ctx);
             if (rc < 0) return rc;
             remaining -= (int)child_cnt + 1;
             continue;
@@ -737,7 +723,7 @@ static int cp_walk_entries(cp_archive_t *ar, const uint8_t *data, size_t size,
         (void)off;
 
         // Add this file entry to the archive's entry list
-        if (cp_push_entry(ar, &fe) < 0) return -1;
+        cp_push_entry(ar, &fe, ctx);
 
         *cursor += 45;
         remaining -= 1;
@@ -745,56 +731,54 @@ static int cp_walk_entries(cp_archive_t *ar, const uint8_t *data, size_t size,
     return 0;
 }
 
-// Parse the directory at the given offset.
+// Parse the directory held in dir[0..size).
 // cpt.md § 3.2.1 "Second Header" — 4-byte CRC, 2-byte total entry count,
 // 1-byte comment length, then the recursive entry tree.
-static int cp_parse_directory(cp_archive_t *ar, const uint8_t *data,
-                              size_t size, uint32_t dir_off) {
-    if ((size_t)dir_off + 7 > size) return -1;
+static int cp_parse_directory(cp_archive_t *ar, const uint8_t *dir,
+                              size_t size, decode_ctx_t *ctx) {
+    if (size < 7) return -1;
 
     // Skip the 4-byte directory CRC (not validated)
-    uint16_t total = rd16be(data + dir_off + 4);
-    uint8_t comment_len = data[dir_off + 6];
-    size_t cursor = (size_t)dir_off + 7 + comment_len;
+    uint16_t total = rd16be(dir + 4);
+    uint8_t comment_len = dir[6];
+    size_t cursor = 7 + (size_t)comment_len;
     if (cursor > size) return -1;
 
-    return cp_walk_entries(ar, data, size, &cursor, (int)total, "");
+    return cp_walk_entries(ar, dir, size, &cursor, (int)total, "", ctx);
 }
 
 // ============================================================================
-// Static Helpers — Fork Decompression
+// Static Helpers — Archive Input
 // ============================================================================
 
-// Decompress a single fork into an owned buffer.
-// cpt.md § 2.2 "Compression Pipeline" — RLE-only forks go straight
-// through the RLE decoder; LZH forks pass through LZH then RLE.
-static peel_buf_t cp_decompress_fork(const uint8_t *archive, size_t archive_len,
-                                     size_t comp_offset, size_t comp_len,
-                                     size_t uncomp_len, bool use_lzh,
-                                     decode_ctx_t *ctx) {
-    // Set up the fork stream
-    cp_fork_t fork;
-    if (use_lzh) {
-        cp_fork_init_lzh(&fork, archive, archive_len,
-                         comp_offset, comp_len, uncomp_len);
-    } else {
-        cp_fork_init_rle(&fork, archive, archive_len,
-                         comp_offset, comp_len, uncomp_len);
-    }
-
-    // Allocate output buffer to exact uncompressed size
-    grow_buf_t out;
-    grow_init(&out, uncomp_len, ctx);
-
-    // Read decompressed bytes in chunks
-    uint8_t chunk[8192];
+// Read everything from the input's cursor to its end into a context buffer.
+static uint8_t *cp_read_rest(peel_in_t *in, size_t *out_len) {
+    size_t len = 0, cap = 0;
+    uint8_t *buf = NULL;
     for (;;) {
-        int n = cp_fork_read(&fork, chunk, sizeof(chunk));
-        if (n <= 0) break;
-        grow_append(&out, chunk, (size_t)n, ctx);
+        if (len == cap) {
+            cap = cap ? cap * 2 : PEEL_WINDOW;
+            buf = ctx_realloc(in->ctx, buf, cap);
+        }
+        size_t n = in_read(in, buf + len, cap - len);
+        if (n == 0) break;
+        len += n;
     }
+    *out_len = len;
+    return buf;
+}
 
-    return grow_finish(&out);
+// Decompress one fork to the output stage.
+// cpt.md § 2.2 "Compression Pipeline" — RLE-only forks go straight
+// through the RLE decoder; LZH forks pass through LZH then RLE.
+static void cp_emit_fork(peel_in_t *in, peel_out_t *out, peel_fork_t which,
+                         uint64_t offset, size_t comp_len, bool use_lzh,
+                         size_t uncomp_len) {
+    in_seek(in, offset);
+    cp_fork_t *f = ctx_alloc(in->ctx, sizeof(*f));
+    cp_fork_init(f, in, comp_len, uncomp_len, use_lzh);
+    out_fork(out, which, &(peel_reader_t){.read = cp_fork_reader, .ctx = f});
+    ctx_free(in->ctx, f);
 }
 
 // ============================================================================
@@ -817,130 +801,111 @@ bool cpt_detect(const uint8_t *src, size_t len) {
 }
 
 // ============================================================================
-// Operations (Public API) — Archive Extraction
+// Operations — Stream Handler
 // ============================================================================
 
-// Detect, parse, and extract all files from a Compact Pro archive.
-// Returns a flat list of extracted files with both forks decompressed.
-peel_file_list_t peel_cpt(const uint8_t *src, size_t len, peel_err_t **err) {
-    *err = NULL;
+// Parse the directory and deliver each file, resource fork first as the
+// archive stores it.  The directory sits at the end of the archive, after
+// every fork, so a forward-only input is buffered in memory first.
+void cpt_extract(peel_in_t *in, peel_out_t *out) {
+    decode_ctx_t *ctx = in->ctx;
+    uint64_t base = in_tell(in);
+    peel_in_t *spool = NULL;
+    uint8_t *spool_buf = NULL;
+
+    if (!in_seekable(in)) {
+        size_t n;
+        spool_buf = cp_read_rest(in, &n);
+        in = spool = in_open_mem(ctx, spool_buf, n);
+        base = 0;
+    }
 
     // Validate header
-    if (!src || len < 8) {
-        *err = make_err("CPT: input too short (%zu bytes)", len);
-        return (peel_file_list_t){0};
-    }
-    if (src[0] != CP_MAGIC || src[1] != CP_VOLUME_SINGLE) {
-        *err = make_err("CPT: bad magic (0x%02X 0x%02X)", src[0], src[1]);
-        return (peel_file_list_t){0};
-    }
+    const uint8_t *hdr;
+    if (in_peek(in, 8, &hdr) < 8)
+        decode_abort(ctx, "CPT: input too short");
+    if (hdr[0] != CP_MAGIC || hdr[1] != CP_VOLUME_SINGLE)
+        decode_abort(ctx, "CPT: bad magic (0x%02X 0x%02X)", hdr[0], hdr[1]);
 
     // cpt.md § 3.1 "Initial Archive Header" — directory offset at bytes 4..7
-    uint32_t dir_off = rd32be(src + 4);
-    if (dir_off < 8 || dir_off > 0x10000000 || (size_t)dir_off >= len) {
-        *err = make_err("CPT: directory offset out of range (%u)", dir_off);
-        return (peel_file_list_t){0};
-    }
+    uint32_t dir_off = rd32be(hdr + 4);
+    uint64_t size = in->size;
+    if (size != PEEL_SIZE_UNKNOWN && size >= base)
+        size -= base;
+    if (dir_off < 8 || dir_off > 0x10000000 ||
+        (size != PEEL_SIZE_UNKNOWN && dir_off >= size))
+        decode_abort(ctx, "CPT: directory offset out of range (%u)", dir_off);
 
     // Parse directory into a flat entry list
+    size_t dir_len;
+    in_seek(in, base + dir_off);
+    uint8_t *dir = cp_read_rest(in, &dir_len);
+    if (dir_len == 0)
+        decode_abort(ctx, "CPT: directory offset out of range (%u)", dir_off);
+    size = (uint64_t)dir_off + dir_len;
+
     cp_archive_t ar;
     memset(&ar, 0, sizeof(ar));
-    if (cp_parse_directory(&ar, src, len, dir_off) < 0) {
-        free(ar.entries);
-        *err = make_err("CPT: failed to parse directory");
-        return (peel_file_list_t){0};
-    }
-
-    if (ar.count == 0) {
-        free(ar.entries);
-        return (peel_file_list_t){.files = NULL, .count = 0};
-    }
-
-    // Count entries that have at least one non-empty fork
-    int file_count = 0;
-    for (size_t i = 0; i < ar.count; i++) {
-        const cp_entry_t *e = &ar.entries[i];
-        if (e->data_uncomp > 0 || e->rsrc_uncomp > 0) {
-            file_count++;
-        }
-    }
-
-    // Allocate the output file array
-    peel_file_t *files = calloc((size_t)file_count, sizeof(peel_file_t));
-    if (!files) {
-        free(ar.entries);
-        *err = make_err("CPT: out of memory for %d files", file_count);
-        return (peel_file_list_t){0};
-    }
-
-    // Use setjmp/longjmp for deep-error abort in decompressors
-    decode_ctx_t ctx;
-    memset(&ctx, 0, sizeof(ctx));
-    if (setjmp(ctx.jmp) != 0) {
-        // Decompression failure — clean up and report
-        for (int j = 0; j < file_count; j++) {
-            peel_free(&files[j].data_fork);
-            peel_free(&files[j].resource_fork);
-        }
-        free(files);
-        free(ar.entries);
-        *err = make_err("CPT: %s", ctx.errmsg);
-        return (peel_file_list_t){0};
-    }
+    if (cp_parse_directory(&ar, dir, dir_len, ctx) < 0)
+        decode_abort(ctx, "CPT: failed to parse directory");
+    ctx_free(ctx, dir);
 
     // Decompress each file's forks
-    int fi = 0;
-    for (size_t i = 0; i < ar.count && fi < file_count; i++) {
+    for (size_t i = 0; i < ar.count; i++) {
         const cp_entry_t *e = &ar.entries[i];
 
         // Skip entries with no non-empty forks
         if (e->data_uncomp == 0 && e->rsrc_uncomp == 0) continue;
 
         // Check for encrypted files (cpt.md § 3.2.3 — flag bit 0)
-        if (e->flags & CP_FLAG_ENCRYPT) {
-            decode_abort(&ctx, "file '%s' is encrypted (unsupported)", e->name);
-        }
-
-        peel_file_t *f = &files[fi];
-
-        // Copy metadata
-        strncpy(f->meta.name, e->name, sizeof(f->meta.name) - 1);
-        f->meta.mac_type     = e->type;
-        f->meta.mac_creator  = e->creator;
-        f->meta.finder_flags = e->finder_flags;
+        if (e->flags & CP_FLAG_ENCRYPT)
+            decode_abort(ctx, "CPT: file '%s' is encrypted (unsupported)",
+                         e->name);
 
         // cpt.md § 3.4 "Fork Data Layout" — resource fork at file_offset,
         // data fork at file_offset + rsrc_comp.
-        size_t rsrc_offset = (size_t)e->file_offset;
-        size_t data_offset = rsrc_offset + (size_t)e->rsrc_comp;
+        uint64_t rsrc_offset = e->file_offset;
+        uint64_t data_offset = rsrc_offset + e->rsrc_comp;
 
         // Validate fork data fits within the archive
-        if (rsrc_offset + e->rsrc_comp > len) {
-            decode_abort(&ctx, "resource fork of '%s' extends past archive", e->name);
-        }
-        if (data_offset + e->data_comp > len) {
-            decode_abort(&ctx, "data fork of '%s' extends past archive", e->name);
-        }
-
-        // Decompress resource fork
-        if (e->rsrc_uncomp > 0) {
-            bool lzh = (e->flags & CP_FLAG_RSRC_LZH) != 0;
-            f->resource_fork = cp_decompress_fork(
-                src, len, rsrc_offset, e->rsrc_comp,
-                e->rsrc_uncomp, lzh, &ctx);
-        }
-
-        // Decompress data fork
-        if (e->data_uncomp > 0) {
-            bool lzh = (e->flags & CP_FLAG_DATA_LZH) != 0;
-            f->data_fork = cp_decompress_fork(
-                src, len, data_offset, e->data_comp,
-                e->data_uncomp, lzh, &ctx);
-        }
+        if (rsrc_offset + e->rsrc_comp > size)
+            decode_abort(ctx, "CPT: resource fork of '%s' extends past archive",
+                         e->name);
+        if (data_offset + e->data_comp > size)
+            decode_abort(ctx, "CPT: data fork of '%s' extends past archive",
+                         e->name);
+
+        peel_file_meta_t meta;
+        memset(&meta, 0, sizeof(meta));
+        strncpy(meta.name, e->name, sizeof(meta.name) - 1);
+        meta.mac_type     = e->type;
+        meta.mac_creator  = e->creator;
+        meta.finder_flags = e->finder_flags;
+
+        out_begin(out, &meta, e->data_uncomp, e->rsrc_uncomp);
+        if (e->rsrc_uncomp > 0)
+            cp_emit_fork(in, out, PEEL_RESOURCE_FORK, base + rsrc_offset,
+                         e->rsrc_comp, (e->flags & CP_FLAG_RSRC_LZH) != 0,
+                         e->rsrc_uncomp);
+        if (e->data_uncomp > 0)
+            cp_emit_fork(in, out, PEEL_DATA_FORK, base + data_offset,
+                         e->data_comp, (e->flags & CP_FLAG_DATA_LZH) != 0,
+                         e->data_uncomp);
+        out_end(out);
+    }
 
-        fi++;
+    ctx_free(ctx, ar.entries);
+    if (spool) {
+        in_close(spool);
+        ctx_free(ctx, spool_buf);
     }
+}
+
+// ============================================================================
+// Operations (Public API) — Archive Extraction
+// ============================================================================
 
-    free(ar.entries);
-    return (peel_file_list_t){.files = files, .count = file_count};
+// Extract all files from a Compact Pro archive in memory.
+peel_file_list_t peel_cpt(const uint8_t *src, size_t len, peel_err_t **err) {
+    return collect_files(src, len, cpt_extract, err);
 }
@@ -51,10 +51,8 @@ static const char hqx_alphabet[] =
 // State for the three-layer pull-based decoder pipeline.
 // hqx.md § 10.1 describes the layered architecture.
 typedef struct {
-    // Source input buffer (borrowed, not owned)
-    const uint8_t *src;
-    size_t src_len;
-    size_t src_pos;
+    // Source input, read through its window
+    peel_in_t *in;
 
     // hqx.md § 4.1 / Appendix A.2 — reverse alphabet lookup table.
     uint8_t rev[256];
@@ -84,6 +82,26 @@ typedef struct {
     uint32_t rsrc_len;
 } hqx_header_t;
 
+// Which fork a stream is positioned in.
+typedef enum {
+    HQX_IN_DATA,
+    HQX_IN_RSRC,
+    HQX_IN_DONE,
+} hqx_fork_state_t;
+
+// A decode positioned within one fork, plus the decoder as it stood at the
+// start of the data fork so the payload can be re-read from there.
+typedef struct {
+    hqx_decoder_t dec;
+    hqx_decoder_t data_start; // Decoder snapshot at data fork offset 0
+    uint64_t data_start_off; // Input offset matching data_start
+    hqx_header_t hdr;
+    hqx_fork_state_t fork;
+    uint32_t pos; // Bytes of the current fork already read
+    uint32_t left; // Bytes of the current fork still to read
+    uint16_t crc; // Running CRC over the current fork
+} hqx_stream_t;
+
 // ============================================================================
 // Static Helpers — Text Envelope
 // ============================================================================
@@ -114,32 +132,16 @@ static size_t hqx_find_preamble(const uint8_t *src, size_t len) {
     return (size_t)-1;
 }
 
-// hqx.md § 3.2 — find the starting colon that begins the encoded payload.
-// Returns the offset of the byte immediately after the colon, or (size_t)-1.
-static size_t hqx_find_start_colon(const uint8_t *src, size_t len,
-                                   size_t from) {
-    for (size_t i = from; i < len; i++) {
-        if (src[i] == ':') {
-            return i + 1;
-        }
-    }
-    return (size_t)-1;
-}
-
 // ============================================================================
 // Static Helpers — Decoder Pipeline
 // ============================================================================
 
-// Initialise a decoder from the source buffer positioned at the start of
-// the encoded payload (just past the opening colon).
-static void hqx_decoder_init(hqx_decoder_t *dec, const uint8_t *src,
-                              size_t len, size_t payload_start,
-                              decode_ctx_t *ctx) {
+// Initialise a decoder over an input positioned at the start of the
+// encoded payload (just past the opening colon).
+static void hqx_decoder_init(hqx_decoder_t *dec, peel_in_t *in) {
     memset(dec, 0, sizeof(*dec));
-    dec->src = src;
-    dec->src_len = len;
-    dec->src_pos = payload_start;
-    dec->ctx = ctx;
+    dec->in = in;
+    dec->ctx = in->ctx;
 
     // hqx.md § Appendix A.2 — build reverse lookup table.
     memset(dec->rev, 0xFF, sizeof(dec->rev));
@@ -151,8 +153,8 @@ static void hqx_decoder_init(hqx_decoder_t *dec, const uint8_t *src,
 // hqx.md § 3.4 — fetch the next encoded character, skipping whitespace.
 // Returns the character, or -1 at the terminating colon or EOF.
 static int hqx_next_char(hqx_decoder_t *dec) {
-    while (dec->src_pos < dec->src_len) {
-        uint8_t ch = dec->src[dec->src_pos++];
+    int ch;
+    while ((ch = in_getc(dec->in)) >= 0) {
         // hqx.md § 3.2 — terminating colon marks end of payload
         if (ch == ':') {
             return -1;
@@ -161,7 +163,7 @@ static int hqx_next_char(hqx_decoder_t *dec) {
         if (ch == '\r' || ch == '\n' || ch == '\t' || ch == ' ') {
             continue;
         }
-        return (int)ch;
+        return ch;
     }
     return -1;
 }
@@ -319,106 +321,158 @@ static hqx_header_t hqx_parse_header(hqx_decoder_t *dec) {
 // Static Helpers — Fork Reading with CRC
 // ============================================================================
 
-// hqx.md § 6.4 / § 6.5 — read a fork of `fork_len` bytes from the decoded
-// stream, verify the trailing 2-byte CRC, and return the data.
-// hqx.md § 7.2 — uses the CRC placeholder rule for verification.
-static peel_buf_t hqx_read_fork(hqx_decoder_t *dec, uint32_t fork_len,
-                                const char *fork_name) {
-    if (fork_len == 0) {
-        // hqx.md § 6.6 — zero-length fork: still must read and verify CRC
-        uint8_t crc_bytes[2];
-        hqx_read_bytes(dec, crc_bytes, 2);
-        uint16_t stored_crc = rd16be(crc_bytes);
-        if (stored_crc != 0x0000) {
-            decode_abort(dec->ctx, "BinHex: %s fork CRC mismatch "
+// hqx.md § 7.2 — read a fork's trailing 2-byte CRC and verify it using the
+// self-checking property: CRC(content + stored CRC) yields zero.
+static void hqx_fork_check(hqx_stream_t *st, const char *fork_name) {
+    uint8_t crc_bytes[2];
+    hqx_read_bytes(&st->dec, crc_bytes, 2);
+    if (st->pos == 0) {
+        // hqx.md § 6.6 — zero-length fork: the stored CRC must be zero
+        if (rd16be(crc_bytes) != 0x0000) {
+            decode_abort(st->dec.ctx, "BinHex: %s fork CRC mismatch "
                          "(empty fork, expected 0x0000)", fork_name);
         }
-        return (peel_buf_t){0};
+        return;
     }
-
-    // Allocate and read fork content
-    grow_buf_t gbuf;
-    grow_init(&gbuf, fork_len, dec->ctx);
-
-    uint8_t chunk[4096];
-    uint32_t remaining = fork_len;
-    while (remaining > 0) {
-        size_t batch = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
-        hqx_read_bytes(dec, chunk, batch);
-        grow_append(&gbuf, chunk, batch, dec->ctx);
-        remaining -= (uint32_t)batch;
+    if (crc16_ccitt_update(st->crc, crc_bytes, 2) != 0) {
+        decode_abort(st->dec.ctx, "BinHex: %s fork CRC mismatch", fork_name);
     }
+}
 
-    // hqx.md § 7.2 — verify using self-checking property:
-    // CRC(content + stored_crc) should yield zero.
-    uint8_t crc_bytes[2];
-    hqx_read_bytes(dec, crc_bytes, 2);
+// Position the stream at the start of a fork (hqx.md § 6.4 / § 6.5).  An
+// empty fork is verified at once.
+static void hqx_fork_start(hqx_stream_t *st, hqx_fork_state_t fork) {
+    st->fork = fork;
+    st->pos = 0;
+    st->left = fork == HQX_IN_DATA ? st->hdr.data_len : st->hdr.rsrc_len;
+    st->crc = 0;
+    if (st->left == 0) {
+        hqx_fork_check(st, fork == HQX_IN_DATA ? "data" : "resource");
+    }
+}
 
-    // Compute CRC over fork content then over the stored CRC bytes
-    uint16_t crc = crc16_ccitt(gbuf.data, gbuf.len);
-    crc = crc16_ccitt_update(crc, crc_bytes, 2);
-    if (crc != 0) {
-        grow_free(&gbuf);
-        decode_abort(dec->ctx, "BinHex: %s fork CRC mismatch", fork_name);
+// Read up to n bytes of the current fork, verifying its CRC as the last
+// byte is read.  Returns 0 once the fork is exhausted.
+static size_t hqx_fork_read(hqx_stream_t *st, uint8_t *buf, size_t n) {
+    if (st->fork == HQX_IN_DONE) {
+        return 0;
+    }
+    if (n > st->left) {
+        n = st->left;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    hqx_read_bytes(&st->dec, buf, n);
+    st->crc = crc16_ccitt_update(st->crc, buf, n);
+    st->pos += (uint32_t)n;
+    st->left -= (uint32_t)n;
+    if (st->left == 0) {
+        hqx_fork_check(st, st->fork == HQX_IN_DATA ? "data" : "resource");
     }
+    return n;
+}
 
-    return grow_finish(&gbuf);
+// Read and verify the rest of the current fork, discarding it.
+static void hqx_fork_skip(hqx_stream_t *st) {
+    uint8_t chunk[4096];
+    while (hqx_fork_read(st, chunk, sizeof(chunk)) > 0) {
+    }
 }
 
 // ============================================================================
-// Static Helpers — Full Decode Pipeline
+// Static Helpers — Stream Setup
 // ============================================================================
 
-// Decode a BinHex 4.0 file into a peel_file_t with both forks and metadata.
-// This is the shared implementation for both peel_hqx and peel_hqx_file.
-static peel_file_t hqx_decode(const uint8_t *src, size_t len,
-                               decode_ctx_t *ctx) {
-    // hqx.md § 3.1 — locate the preamble identification string
-    size_t after_preamble = hqx_find_preamble(src, len);
+// hqx.md § 3.1 / § 3.2 — find the preamble and the starting colon, parse
+// the header, and position a new stream at the start of the data fork.
+static hqx_stream_t *hqx_start(peel_in_t *in) {
+    // The preamble was detected within the leading window
+    const uint8_t *head;
+    size_t n = in_peek(in, SIZE_MAX, &head);
+    size_t after_preamble = hqx_find_preamble(head, n);
     if (after_preamble == (size_t)-1) {
-        decode_abort(ctx, "BinHex: preamble not found");
+        decode_abort(in->ctx, "BinHex: preamble not found");
     }
+    in_seek(in, in_tell(in) + after_preamble);
 
     // hqx.md § 3.2 — find the starting colon
-    size_t payload_start = hqx_find_start_colon(src, len, after_preamble);
-    if (payload_start == (size_t)-1) {
-        decode_abort(ctx, "BinHex: no starting colon found");
+    int ch;
+    while ((ch = in_getc(in)) >= 0 && ch != ':') {
+    }
+    if (ch < 0) {
+        decode_abort(in->ctx, "BinHex: no starting colon found");
     }
 
-    // Initialise the three-layer decoder pipeline
-    hqx_decoder_t dec;
-    hqx_decoder_init(&dec, src, len, payload_start, ctx);
-
-    // hqx.md § 6.3 — parse the header
-    hqx_header_t hdr = hqx_parse_header(&dec);
+    // Initialise the three-layer decoder pipeline and parse the header
+    hqx_stream_t *st = ctx_alloc(in->ctx, sizeof(*st));
+    hqx_decoder_init(&st->dec, in);
+    st->hdr = hqx_parse_header(&st->dec);
 
-    // hqx.md § 6.4 — read the data fork and verify its CRC
-    peel_buf_t data_fork = hqx_read_fork(&dec, hdr.data_len, "data");
+    st->data_start = st->dec;
+    st->data_start_off = in_tell(in);
+    hqx_fork_start(st, HQX_IN_DATA);
+    return st;
+}
 
-    // hqx.md § 6.5 — read the resource fork and verify its CRC
-    peel_buf_t rsrc_fork = hqx_read_fork(&dec, hdr.rsrc_len, "resource");
+// Metadata for the decoded file.
+static peel_file_meta_t hqx_meta(const hqx_header_t *hdr) {
+    peel_file_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    memcpy(meta.name, hdr->name, hdr->name_len);
+    meta.name[hdr->name_len] = '\0';
+    meta.mac_type    = hdr->mac_type;
+    meta.mac_creator = hdr->mac_creator;
 
-    // Assemble the result
-    peel_file_t file;
-    memset(&file, 0, sizeof(file));
+    // hqx.md § 8.2 — clear Finder flag bits that should not persist on decode
+    meta.finder_flags = hdr->finder_flags & (uint16_t)~FINDER_CLEAR_MASK;
+    return meta;
+}
 
-    // Populate metadata from the parsed header
-    size_t nl = hdr.name_len;
-    if (nl > sizeof(file.meta.name) - 1) {
-        nl = sizeof(file.meta.name) - 1;
-    }
-    memcpy(file.meta.name, hdr.name, nl);
-    file.meta.name[nl] = '\0';
-    file.meta.mac_type    = hdr.mac_type;
-    file.meta.mac_creator = hdr.mac_creator;
+// ============================================================================
+// Static Helpers — Readers
+// ============================================================================
 
-    // hqx.md § 8.2 — clear Finder flag bits that should not persist on decode
-    file.meta.finder_flags = hdr.finder_flags & (uint16_t)~FINDER_CLEAR_MASK;
+// Reader over the current fork.
+static ptrdiff_t hqx_fork_reader(void *ctx, uint8_t *buf, size_t len) {
+    return (ptrdiff_t)hqx_fork_read(ctx, buf, len);
+}
 
-    file.data_fork = data_fork;
-    file.resource_fork = rsrc_fork;
+// Payload reader: the data fork.  Once it is exhausted the resource fork is
+// read through too, so its CRC is verified just as a full decode would.
+static ptrdiff_t hqx_payload_read(void *ctx, uint8_t *buf, size_t len) {
+    hqx_stream_t *st = ctx;
+    if (st->fork != HQX_IN_DATA) {
+        return 0;
+    }
+    size_t n = hqx_fork_read(st, buf, len);
+    if (st->left == 0) {
+        hqx_fork_start(st, HQX_IN_RSRC);
+        hqx_fork_skip(st);
+        st->fork = HQX_IN_DONE;
+    }
+    return (ptrdiff_t)n;
+}
 
-    return file;
+// Payload seek: restart from the data fork snapshot when moving backwards,
+// then decode forward to the target.
+static int hqx_payload_seek(void *ctx, uint64_t offset) {
+    hqx_stream_t *st = ctx;
+    if (offset > st->hdr.data_len) {
+        return -1;
+    }
+    if (st->fork != HQX_IN_DATA || offset < st->pos) {
+        in_seek(st->dec.in, st->data_start_off);
+        st->dec = st->data_start;
+        hqx_fork_start(st, HQX_IN_DATA);
+    }
+    uint8_t chunk[4096];
+    while (st->pos < offset) {
+        uint64_t want = offset - st->pos;
+        hqx_payload_read(st, chunk, want < sizeof(chunk) ? (size_t)want
+                                                          : sizeof(chunk));
+    }
+    return 0;
 }
 
 // ============================================================================
@@ -431,39 +485,52 @@ bool hqx_detect(const uint8_t *src, size_t len) {
 }
 
 // ============================================================================
-// Operations (Public API) — Wrapper Peel
+// Operations — Stream Handlers
 // ============================================================================
 
-// Decode a BinHex 4.0 file and return the data fork as a flat buffer.
-// hqx.md § 2.1 — the full decoding pipeline is reversed: strip text
-// envelope, decode 6-bit ASCII, expand RLE, parse binary stream.
-peel_buf_t peel_hqx(const uint8_t *src, size_t len, peel_err_t **err) {
-    *err = NULL;
+// Open the data fork as this wrapper's payload.  hqx.md § 2.1 — the full
+// decoding pipeline is reversed: strip text envelope, decode 6-bit ASCII,
+// expand RLE, parse binary stream.
+uint64_t hqx_open(peel_in_t *in, peel_reader_t *payload) {
+    hqx_stream_t *st = hqx_start(in);
+    *payload = (peel_reader_t){
+        .read = hqx_payload_read,
+        .seek = in_seekable(in) ? hqx_payload_seek : NULL,
+        .ctx = st,
+    };
+    return st->hdr.data_len;
+}
 
-    // Use setjmp/longjmp for deep-error abort throughout the decode pipeline
-    decode_ctx_t ctx;
-    if (setjmp(ctx.jmp) != 0) {
-        *err = make_err("%s", ctx.errmsg);
-        return (peel_buf_t){0};
-    }
+// Deliver the encoded file with both forks and its metadata.
+void hqx_extract(peel_in_t *in, peel_out_t *out) {
+    hqx_stream_t *st = hqx_start(in);
+    peel_file_meta_t meta = hqx_meta(&st->hdr);
+    peel_reader_t rd = {.read = hqx_fork_reader, .ctx = st};
+
+    out_begin(out, &meta, st->hdr.data_len, st->hdr.rsrc_len);
+    out_fork(out, PEEL_DATA_FORK, &rd);
+    hqx_fork_start(st, HQX_IN_RSRC);
+    out_fork(out, PEEL_RESOURCE_FORK, &rd);
+    out_end(out);
+    ctx_free(in->ctx, st);
+}
 
-    peel_file_t file = hqx_decode(src, len, &ctx);
+// ============================================================================
+// Operations (Public API) — Wrapper Peel
+// ============================================================================
 
-    // Return the data fork; free the resource fork
-    peel_buf_t result = file.data_fork;
-    peel_free(&file.resource_fork);
-    return result;
+// Decode a BinHex 4.0 file and return the data fork as a flat buffer.
+peel_buf_t peel_hqx(const uint8_t *src, size_t len, peel_err_t **err) {
+    return collect_payload(src, len, hqx_open, err);
 }
 
 // Decode a BinHex 4.0 file and return both forks plus metadata.
 peel_file_t peel_hqx_file(const uint8_t *src, size_t len, peel_err_t **err) {
-    *err = NULL;
-
-    decode_ctx_t ctx;
-    if (setjmp(ctx.jmp) != 0) {
-        *err = make_err("%s", ctx.errmsg);
+    peel_file_list_t list = collect_files(src, len, hqx_extract, err);
+    if (*err) {
         return (peel_file_t){0};
     }
-
-    return hqx_decode(src, len, &ctx);
+    peel_file_t file = list.files[0];
+    free(list.files);
+    return file;
 }
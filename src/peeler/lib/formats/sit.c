@@ -10,8 +10,9 @@
 //   - Classic (versions 1.x–4.x): sequential 112-byte entry headers.
 //   - SIT5 (version 5.x): linked-list entry headers with 80-byte ASCII magic.
 //
-// Both layouts are parsed by this file and exposed through a single
-// peel_sit() entry point that returns a peel_file_list_t.
+// Both layouts are parsed by this file and streamed through sit_extract(),
+// which walks the entry headers in archive order and decodes each fork as
+// the output stage pulls it; peel_sit() collects the result in memory.
 //
 // Supported compression methods (sit.md § 6 "Compression Methods"):
 //   0  = raw copy                    (sit.md § 7 "Method 0: None")
@@ -26,20 +27,32 @@
 #include "internal.h"
 
 // ============================================================================
-// Forward Declarations — sit13 / sit15 helpers
+// Forward Declarations — sit3 / sit13 / sit15 helpers
 // ============================================================================
 
-// Decompress a method-3 fork into a freshly allocated buffer.
-peel_buf_t peel_sit3(const uint8_t *src, size_t len, size_t uncomp_len,
-                     peel_err_t **err);
-
-// Decompress a method-13 fork into a freshly allocated buffer.
-peel_buf_t peel_sit13(const uint8_t *src, size_t len, size_t uncomp_len,
-                      peel_err_t **err);
-
-// Decompress a method-15 fork into a freshly allocated buffer.
-peel_buf_t peel_sit15(const uint8_t *src, size_t len, size_t uncomp_len,
-                      peel_err_t **err);
+// Each decoder reads a fork's compressed bytes from a span and yields the
+// decompressed bytes on demand; state is owned by the decode context.
+typedef struct sit3_state sit3_state_t;
+typedef struct sit13_state sit13_state_t;
+typedef struct arsenic_state sit15_state_t;
+
+// Method 3 (static Huffman): sit3.c.
+sit3_state_t *sit3_open(peel_span_t *src, uint32_t uncomp_len,
+                        decode_ctx_t *ctx);
+size_t sit3_read(sit3_state_t *st, uint8_t *dst, size_t n);
+void sit3_close(sit3_state_t *st);
+
+// Method 13 (LZSS + Huffman): sit13.c.
+sit13_state_t *sit13_open(peel_span_t *src, uint32_t uncomp_len,
+                          decode_ctx_t *ctx);
+size_t sit13_read(sit13_state_t *st, uint8_t *dst, size_t n);
+void sit13_close(sit13_state_t *st);
+
+// Method 15 (Arsenic): sit15.c.
+sit15_state_t *sit15_open(peel_span_t *src, uint32_t uncomp_len,
+                          decode_ctx_t *ctx);
+size_t sit15_read(sit15_state_t *st, uint8_t *dst, size_t n);
+void sit15_close(sit15_state_t *st);
 
 // ============================================================================
 // Constants and Macros
@@ -90,7 +103,7 @@ typedef struct {
     uint32_t       packed_len;  // Compressed length
     uint16_t       crc;         // CRC-16 from header
     uint8_t        method;      // Compression method ID (low nibble)
-    const uint8_t *data;        // Pointer to compressed bytes in archive
+    uint64_t       offset;      // Input offset of the compressed bytes
 } sit_fork_info_t;
 
 // A single parsed file entry (metadata + fork info + path).
@@ -104,19 +117,14 @@ typedef struct {
     bool             has_rsrc;     // Resource fork present
 } sit_entry_t;
 
-// Growable list of parsed file entries.
-typedef struct {
-    sit_entry_t *items;
-    int          count;
-    int          cap;
-} sit_entry_list_t;
-
 // LZW decoder state.
 // sit.md § 9.3 "Dictionary Structure" — struct-of-arrays layout.
 typedef struct {
-    const uint8_t *src;        // Compressed bytestream
+    peel_span_t   *src;        // Compressed bytestream
     size_t         src_bytes;  // Length of compressed data
     size_t         bit_pos;    // Current bit position in stream
+    uint32_t       acc;        // Bits read ahead of bit_pos, LSB first
+    int            acc_bits;   // Valid bits in acc
 
     uint16_t prev_code[LZW_TABLE_CAP]; // Back-link to parent code
     uint8_t  suffix[LZW_TABLE_CAP];    // Byte appended at this entry
@@ -133,6 +141,29 @@ typedef struct {
     size_t   stage_len;            // Valid bytes in staging buffer
 } lzw_state_t;
 
+// One fork being decompressed: reads its packed bytes from a span of the
+// input and yields up to raw_len bytes, verifying the CRC as the last one
+// is produced.  sit.md § 6 "Compression Methods" — state by method ID.
+typedef struct {
+    peel_span_t    src;         // The fork's compressed bytes
+    decode_ctx_t  *ctx;
+    uint8_t        method;
+    uint32_t       left;        // Bytes still to produce
+    uint16_t       crc;         // Running CRC over produced bytes
+    uint16_t       expect_crc;  // CRC from the entry header
+    bool           check_crc;   // False for method 15 (sit.md § 6.3)
+
+    // Method 1 (RLE90)
+    uint8_t        rle_last;    // Last literal byte
+    uint32_t       rle_repeat;  // Pending copies of rle_last
+
+    // Methods 2, 3, 13, 15
+    lzw_state_t   *lzw;
+    sit3_state_t  *m3;
+    sit13_state_t *m13;
+    sit15_state_t *m15;
+} sit_fork_t;
+
 // SIT5 directory map entry for path construction.
 // sit.md § 5.7 "Iteration Rules"
 typedef struct {
@@ -194,48 +225,6 @@ static inline uint16_t sit_crc(const uint8_t *buf, size_t len) {
     return sit_crc_update(0, buf, len);
 }
 
-// ============================================================================
-// Static Helpers — Entry List
-// ============================================================================
-
-// Initialize an empty entry list.
-static void entry_list_init(sit_entry_list_t *list) {
-    list->items = NULL;
-    list->count = 0;
-    list->cap   = 0;
-}
-
-// Append one entry, growing the backing array if needed.
-static sit_entry_t *entry_list_push(sit_entry_list_t *list, peel_err_t **err) {
-    if (list->count >= SIT_MAX_FILES) {
-        *err = make_err("SIT: too many files in archive (limit %d)", SIT_MAX_FILES);
-        return NULL;
-    }
-    if (list->count == list->cap) {
-        // Double the capacity (start at 16)
-        int new_cap = list->cap ? list->cap * 2 : 16;
-        sit_entry_t *tmp = realloc(list->items,
-                                   (size_t)new_cap * sizeof(sit_entry_t));
-        if (!tmp) {
-            *err = make_err("SIT: out of memory growing entry list");
-            return NULL;
-        }
-        list->items = tmp;
-        list->cap   = new_cap;
-    }
-    sit_entry_t *e = &list->items[list->count++];
-    memset(e, 0, sizeof(*e));
-    return e;
-}
-
-// Release the entry list backing storage.
-static void entry_list_free(sit_entry_list_t *list) {
-    free(list->items);
-    list->items = NULL;
-    list->count = 0;
-    list->cap   = 0;
-}
-
 // ============================================================================
 // Static Helpers — Path Construction
 // ============================================================================
@@ -271,9 +260,9 @@ static void build_path(char *dst, size_t cap, const char *dir, const char *name)
 
 // sit.md § 9.3 "Dictionary Structure" — initialize the LZW decoder with
 // root entries 0–255, code width 9, first free slot at 257.
-static lzw_state_t *lzw_create(const uint8_t *src, size_t src_bytes) {
-    lzw_state_t *z = calloc(1, sizeof(*z));
-    if (!z) return NULL;
+static lzw_state_t *lzw_create(peel_span_t *src, size_t src_bytes,
+                               decode_ctx_t *ctx) {
+    lzw_state_t *z = ctx_alloc(ctx, sizeof(*z));
     z->src       = src;
     z->src_bytes = src_bytes;
     z->code_bits = 9;
@@ -289,20 +278,38 @@ static lzw_state_t *lzw_create(const uint8_t *src, size_t src_bytes) {
     return z;
 }
 
+// Make at least n bits available in the accumulator.  Bits past the end
+// of the compressed data read as zero.
+static void lzw_fill(lzw_state_t *z, int n) {
+    while (z->acc_bits < n) {
+        int c = span_getc(z->src);
+        z->acc |= (uint32_t)(c < 0 ? 0 : c) << z->acc_bits;
+        z->acc_bits += 8;
+    }
+}
+
+// Drop n bits from the bitstream.
+static void lzw_skip_bits(lzw_state_t *z, size_t n) {
+    z->bit_pos += n;
+    while (n > 0) {
+        lzw_fill(z, 1);
+        int k = n < (size_t)z->acc_bits ? (int)n : z->acc_bits;
+        z->acc = k < 32 ? z->acc >> k : 0;
+        z->acc_bits -= k;
+        n -= (size_t)k;
+    }
+}
+
 // sit.md § 9.4 "Bit Packing" — read one code from the LE bitstream.
 // Returns -1 on input exhaustion.
 static int lzw_next_code(lzw_state_t *z) {
-    size_t byte_off = z->bit_pos >> 3;
-    if (byte_off >= z->src_bytes)
+    if ((z->bit_pos >> 3) >= z->src_bytes)
         return -1;
-    // Read up to 4 bytes starting at the byte boundary (little-endian)
-    uint32_t acc = 0;
-    size_t avail = z->src_bytes - byte_off;
-    if (avail > 4) avail = 4;
-    memcpy(&acc, z->src + byte_off, avail);
-    int shift = (int)(z->bit_pos & 7);
+    lzw_fill(z, z->code_bits);
     int mask  = (1 << z->code_bits) - 1;
-    int code  = (int)((acc >> shift) & (uint32_t)mask);
+    int code  = (int)(z->acc & (uint32_t)mask);
+    z->acc >>= z->code_bits;
+    z->acc_bits -= z->code_bits;
     z->bit_pos += (size_t)z->code_bits;
     z->block_count++;
     return code;
@@ -369,8 +376,8 @@ static size_t lzw_decode(lzw_state_t *z, uint8_t *dst, size_t want) {
         // resets dictionary and skips remaining 8-code block
         if (code == LZW_CLEAR_CODE) {
             if (z->block_count & 7)
-                z->bit_pos += (size_t)(z->code_bits *
-                                       (8 - (z->block_count & 7)));
+                lzw_skip_bits(z, (size_t)(z->code_bits *
+                                          (8 - (z->block_count & 7))));
             z->tbl_next    = LZW_FIRST_NEW;
             z->code_bits   = 9;
             z->prev        = -1;
@@ -420,146 +427,170 @@ static size_t lzw_decode(lzw_state_t *z, uint8_t *dst, size_t want) {
 }
 
 // Free an LZW decoder.
-static void lzw_destroy(lzw_state_t *z) {
-    free(z);
+static void lzw_destroy(lzw_state_t *z, decode_ctx_t *ctx) {
+    ctx_free(ctx, z);
 }
 
 // ============================================================================
 // Static Helpers — Fork Decompression
 // ============================================================================
 
-// Decompress a single fork using the specified compression method.
-// Returns an owned buffer on success, or a zero buffer with *err set.
-// sit.md § 6 "Compression Methods" — dispatch by method ID.
-static peel_buf_t decompress_fork(const sit_fork_info_t *fi, peel_err_t **err) {
-    uint32_t raw_len    = fi->raw_len;
-    uint32_t packed_len = fi->packed_len;
-    uint16_t expect_crc = fi->crc;
-    uint8_t  method     = fi->method;
-    const uint8_t *src  = fi->data;
-
-    // sit.md § 10.A "Method 3" — delegated to sit3.c (static Huffman)
-    if (method == 3) {
-        peel_buf_t result = peel_sit3(src, packed_len, raw_len, err);
-        if (*err) return (peel_buf_t){0};
-        // sit.md § 6.3 "CRC Verification Rule" — verify CRC over decompressed
-        uint16_t actual = sit_crc(result.data, result.size);
-        if (actual != expect_crc) {
-            *err = make_err("SIT: fork CRC mismatch (expected 0x%04X, got 0x%04X)",
-                            expect_crc, actual);
-            peel_free(&result);
-            return (peel_buf_t){0};
+// sit.md § 8 "Method 1: RLE90" — escape-based run-length encoding.
+// sit.md § 8.2 "State" — last_byte initialized to 0.
+static size_t rle90_read(sit_fork_t *f, uint8_t *dst, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        if (f->rle_repeat > 0) {
+            size_t k = f->rle_repeat;
+            if (k > n - got) k = n - got;
+            memset(dst + got, f->rle_last, k);
+            f->rle_repeat -= (uint32_t)k;
+            got += k;
+            continue;
         }
-        return result;
-    }
-
-    // sit.md § 10 "Method 13" — delegated to sit13.c
-    if (method == 13) {
-        peel_buf_t result = peel_sit13(src, packed_len, raw_len, err);
-        if (*err) return (peel_buf_t){0};
-        // sit.md § 6.3 "CRC Verification Rule" — verify CRC over decompressed
-        uint16_t actual = sit_crc(result.data, result.size);
-        if (actual != expect_crc) {
-            *err = make_err("SIT: fork CRC mismatch (expected 0x%04X, got 0x%04X)",
-                            expect_crc, actual);
-            peel_free(&result);
-            return (peel_buf_t){0};
+        int b = span_getc(&f->src);
+        if (b < 0) break;
+        if (b != 0x90) {
+            // Literal byte
+            dst[got++] = (uint8_t)b;
+            f->rle_last = (uint8_t)b;
+            continue;
+        }
+        // sit.md § 8.3 "Algorithm" — escape marker 0x90
+        int c = span_getc(&f->src);
+        if (c < 0) break;
+        if (c == 0) {
+            // Literal 0x90 (do not update last_byte)
+            dst[got++] = 0x90;
+        } else if (c > 1) {
+            // Repeat last_byte (n-1) additional times
+            f->rle_repeat = (uint32_t)(c - 1);
         }
-        return result;
+        // c == 1 means zero additional copies
     }
+    return got;
+}
 
-    // sit.md § 11 "Method 15" — delegated to sit15.c
+// Start decompressing a fork whose compressed bytes begin at the input's
+// position.  sit.md § 6 "Compression Methods" — dispatch by method ID.
+static sit_fork_t *sit_fork_open(peel_in_t *in, const sit_fork_info_t *fi) {
+    decode_ctx_t *ctx = in->ctx;
+    sit_fork_t *f = ctx_alloc(ctx, sizeof(*f));
+    f->src = (peel_span_t){.in = in, .left = fi->packed_len};
+    f->ctx = ctx;
+    f->method = fi->method;
+    f->left = fi->raw_len;
+    f->expect_crc = fi->crc;
     // sit.md § 6.3 — method 15 handles integrity internally; skip CRC check.
-    if (method == 15) {
-        return peel_sit15(src, packed_len, raw_len, err);
-    }
-
-    // Allocate output buffer for methods 0, 1, 2
-    uint8_t *out = malloc(raw_len);
-    if (!out) {
-        *err = make_err("SIT: out of memory allocating %u bytes for fork",
-                        raw_len);
-        return (peel_buf_t){0};
-    }
-
-    size_t produced = 0;
+    f->check_crc = fi->method != 15;
 
-    switch (method) {
-    case 0: {
+    switch (fi->method) {
+    case 0:
         // sit.md § 7 "Method 0: None" — raw copy
-        if (packed_len < raw_len) {
-            *err = make_err("SIT: method 0 packed (%u) < raw (%u)",
-                            packed_len, raw_len);
-            free(out);
-            return (peel_buf_t){0};
-        }
-        memcpy(out, src, raw_len);
-        produced = raw_len;
+        if (fi->packed_len < fi->raw_len)
+            decode_abort(ctx, "SIT: method 0 packed (%u) < raw (%u)",
+                         fi->packed_len, fi->raw_len);
         break;
-    }
-
-    case 1: {
-        // sit.md § 8 "Method 1: RLE90" — escape-based run-length encoding
-        // sit.md § 8.2 "State" — last_byte initialized to 0
-        uint8_t last_byte = 0;
-        size_t  src_off = 0;
-        while (produced < raw_len && src_off < packed_len) {
-            uint8_t b = src[src_off++];
-            if (b != 0x90) {
-                // Literal byte
-                out[produced++] = b;
-                last_byte = b;
-            } else {
-                // sit.md § 8.3 "Algorithm" — escape marker 0x90
-                if (src_off >= packed_len) break;
-                uint8_t n = src[src_off++];
-                if (n == 0) {
-                    // Literal 0x90 (do not update last_byte)
-                    out[produced++] = 0x90;
-                } else if (n > 1) {
-                    // Repeat last_byte (n-1) additional times
-                    size_t repeats = (size_t)(n - 1);
-                    if (produced + repeats > raw_len)
-                        repeats = raw_len - produced;
-                    memset(out + produced, last_byte, repeats);
-                    produced += repeats;
-                }
-                // n == 1 means zero additional copies
-            }
-        }
+    case 1:
         break;
-    }
-
-    case 2: {
+    case 2:
         // sit.md § 9 "Method 2: LZW" — 14-bit max, LE bit packing
-        lzw_state_t *lzw = lzw_create(src, packed_len);
-        if (!lzw) {
-            *err = make_err("SIT: out of memory creating LZW decoder");
-            free(out);
-            return (peel_buf_t){0};
-        }
-        produced = lzw_decode(lzw, out, raw_len);
-        lzw_destroy(lzw);
+        f->lzw = lzw_create(&f->src, fi->packed_len, ctx);
+        break;
+    case 3:
+        // sit.md § 10.A "Method 3" — delegated to sit3.c (static Huffman)
+        f->m3 = sit3_open(&f->src, fi->raw_len, ctx);
+        break;
+    case 13:
+        // sit.md § 10 "Method 13" — delegated to sit13.c
+        f->m13 = sit13_open(&f->src, fi->raw_len, ctx);
+        break;
+    case 15:
+        // sit.md § 11 "Method 15" — delegated to sit15.c
+        f->m15 = sit15_open(&f->src, fi->raw_len, ctx);
         break;
-    }
-
     default:
         // sit.md § 12 "Unsupported Methods" — fatal error
-        *err = make_err("SIT: unsupported compression method %d", method);
-        free(out);
-        return (peel_buf_t){0};
+        decode_abort(ctx, "SIT: unsupported compression method %d",
+                     fi->method);
     }
+    return f;
+}
 
-    // sit.md § 6.3 "CRC Verification Rule" — verify CRC over decompressed data
-    uint16_t actual_crc = sit_crc(out, produced);
-    if (actual_crc != expect_crc) {
-        *err = make_err("SIT: fork CRC mismatch (expected 0x%04X, got 0x%04X)",
-                        expect_crc, actual_crc);
-        free(out);
-        return (peel_buf_t){0};
+// Reader callback: the next decompressed bytes of a fork.
+static ptrdiff_t sit_fork_read(void *ctx, uint8_t *buf, size_t len) {
+    sit_fork_t *f = ctx;
+    if (len > f->left) len = f->left;
+    if (len == 0) return 0;
+
+    size_t got = 0;
+    switch (f->method) {
+    case 0:  got = span_read(&f->src, buf, len);   break;
+    case 1:  got = rle90_read(f, buf, len);        break;
+    case 2:  got = lzw_decode(f->lzw, buf, len);   break;
+    case 3:  got = sit3_read(f->m3, buf, len);     break;
+    case 13: got = sit13_read(f->m13, buf, len);   break;
+    case 15: got = sit15_read(f->m15, buf, len);   break;
     }
 
-    return (peel_buf_t){.data = out, .size = produced, .owned = true};
+    // sit.md § 6.3 "CRC Verification Rule" — verify CRC over decompressed
+    f->crc = sit_crc_update(f->crc, buf, got);
+    f->left -= (uint32_t)got;
+    if (f->left == 0 && f->check_crc && f->crc != f->expect_crc)
+        decode_abort(f->ctx,
+                     "SIT: fork CRC mismatch (expected 0x%04X, got 0x%04X)",
+                     f->expect_crc, f->crc);
+    return (ptrdiff_t)got;
+}
+
+// Release a fork decoder.
+static void sit_fork_close(sit_fork_t *f) {
+    lzw_destroy(f->lzw, f->ctx);
+    sit3_close(f->m3);
+    sit13_close(f->m13);
+    sit15_close(f->m15);
+    ctx_free(f->ctx, f);
+}
+
+// Decompress one fork to the output stage.
+static void emit_fork(peel_in_t *in, peel_out_t *out, peel_fork_t which,
+                      const sit_fork_info_t *fi) {
+    in_seek(in, fi->offset);
+    sit_fork_t *f = sit_fork_open(in, fi);
+    out_fork(out, which, &(peel_reader_t){.read = sit_fork_read, .ctx = f});
+    sit_fork_close(f);
+}
+
+// Deliver one parsed entry, resource fork first as the archive stores it.
+// Entries with no non-empty fork are skipped.
+static void emit_entry(peel_in_t *in, peel_out_t *out, const sit_entry_t *ent) {
+    bool has_data = ent->data_fork.raw_len > 0;
+    bool has_rsrc = ent->has_rsrc && ent->rsrc_fork.raw_len > 0;
+    if (!has_data && !has_rsrc)
+        return;
+
+    peel_file_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    snprintf(meta.name, sizeof(meta.name), "%s", ent->name);
+    meta.mac_type     = ent->mac_type;
+    meta.mac_creator  = ent->mac_creator;
+    meta.finder_flags = ent->finder_flags;
+
+    out_begin(out, &meta, has_data ? ent->data_fork.raw_len : 0,
+              has_rsrc ? ent->rsrc_fork.raw_len : 0);
+    if (has_rsrc)
+        emit_fork(in, out, PEEL_RESOURCE_FORK, &ent->rsrc_fork);
+    if (has_data)
+        emit_fork(in, out, PEEL_DATA_FORK, &ent->data_fork);
+    out_end(out);
+}
+
+// Count one more entry against the per-archive limit.
+static void count_entry(decode_ctx_t *ctx, int *count) {
+    if (*count >= SIT_MAX_FILES)
+        decode_abort(ctx, "SIT: too many files in archive (limit %d)",
+                     SIT_MAX_FILES);
+    (*count)++;
 }
 
 // ============================================================================
@@ -591,32 +622,32 @@ static int64_t find_classic_magic(const uint8_t *src, size_t len) {
     return -1;
 }
 
-// Parse all file entries from a classic StuffIt archive.
+// Walk a classic StuffIt archive and deliver each file as it is reached.
 // sit.md § 4.7 "Classic Iteration Rules" and Appendix B
-static bool parse_classic(const uint8_t *blob, size_t blob_len,
-                          size_t archive_off, sit_entry_list_t *entries,
-                          peel_err_t **err) {
-    const uint8_t *base = blob + archive_off;
-    size_t avail = blob_len - archive_off;
-
-    if (avail < SIT_CLASSIC_HDR_SIZE) {
-        *err = make_err("SIT classic: archive too small");
-        return false;
-    }
+static void extract_classic(peel_in_t *in, uint64_t archive_off,
+                            peel_out_t *out) {
+    decode_ctx_t *ctx = in->ctx;
+    uint8_t mh[SIT_CLASSIC_HDR_SIZE];
+
+    in_seek(in, archive_off);
+    if (in_read(in, mh, sizeof(mh)) < sizeof(mh))
+        decode_abort(ctx, "SIT classic: archive too small");
 
     // sit.md § 4.2 "Main Archive Header" — file_count at offset 4
-    uint16_t file_count = rd16be(base + 4);
-    uint32_t cursor = SIT_CLASSIC_HDR_SIZE;
+    uint16_t file_count = rd16be(mh + 4);
+    uint64_t cursor = archive_off + SIT_CLASSIC_HDR_SIZE;
     uint32_t done = 0;
+    int entries = 0;
 
     // sit.md § 4.7 — folder stack of up to 10 nesting levels
     char dirs[SIT_MAX_DEPTH][64];
     int  depth = 0;
 
     while (done < file_count) {
-        if ((size_t)cursor + SIT_ENTRY_HDR_SIZE > avail) break;
+        uint8_t hdr[SIT_ENTRY_HDR_SIZE];
+        in_seek(in, cursor);
+        if (in_read(in, hdr, sizeof(hdr)) < sizeof(hdr)) break;
 
-        const uint8_t *hdr = base + cursor;
         uint8_t rm = hdr[0];
         uint8_t dm = hdr[1];
 
@@ -688,19 +719,17 @@ static bool parse_classic(const uint8_t *blob, size_t blob_len,
         uint16_t dcrc  = rd16be(hdr + 102);
 
         // sit.md § 4.5 "Fork Data Layout" — rsrc first, then data
-        const uint8_t *rsrc_ptr = base + cursor + SIT_ENTRY_HDR_SIZE;
-        const uint8_t *data_ptr = rsrc_ptr + rclen;
-
-        // Bounds check
-        if ((size_t)(data_ptr - blob) + dclen > blob_len) {
-            *err = make_err("SIT classic: fork data extends past archive end");
-            return false;
-        }
+        uint64_t rsrc_off = cursor + SIT_ENTRY_HDR_SIZE;
+        uint64_t data_off = rsrc_off + rclen;
 
-        // Add entry to the list
-        sit_entry_t *ent = entry_list_push(entries, err);
-        if (!ent) return false;
+        // Bounds check (streams of unknown length stop at their end instead)
+        if (in->size != PEEL_SIZE_UNKNOWN && data_off + dclen > in->size)
+            decode_abort(ctx, "SIT classic: fork data extends past archive end");
 
+        count_entry(ctx, &entries);
+        sit_entry_t entry;
+        sit_entry_t *ent = &entry;
+        memset(ent, 0, sizeof(*ent));
         strncpy(ent->name, path, sizeof(ent->name) - 1);
         ent->mac_type     = ftype;
         ent->mac_creator  = fcreator;
@@ -710,23 +739,22 @@ static bool parse_classic(const uint8_t *blob, size_t blob_len,
             .packed_len = dclen,
             .crc        = dcrc,
             .method     = (uint8_t)(dm & 0x0F),
-            .data       = data_ptr
+            .offset     = data_off
         };
         ent->rsrc_fork = (sit_fork_info_t){
             .raw_len    = rulen,
             .packed_len = rclen,
             .crc        = rcrc,
             .method     = (uint8_t)(rm & 0x0F),
-            .data       = rsrc_ptr
+            .offset     = rsrc_off
         };
         ent->has_rsrc = (rulen > 0);
+        emit_entry(in, out, ent);
 
         // Advance past both fork data regions
-        cursor = (uint32_t)((size_t)(data_ptr - base) + dclen);
+        cursor = data_off + dclen;
         if (depth == 0) done++;
     }
-
-    return true;
 }
 
 // ============================================================================
@@ -752,88 +780,86 @@ static int64_t find_sit5_magic(const uint8_t *src, size_t len) {
     return -1;
 }
 
-// Parse all file entries from a SIT5 archive.
-// sit.md § 5.7 "Iteration Rules" and Appendix C
-static bool parse_sit5(const uint8_t *blob, size_t blob_len,
-                       size_t archive_off, sit_entry_list_t *entries,
-                       peel_err_t **err) {
-    const uint8_t *base = blob + archive_off;
-    size_t avail = blob_len - archive_off;
-
-    if (avail < SIT5_MIN_SIZE) {
-        *err = make_err("SIT5: archive too small (%zu bytes)", avail);
-        return false;
+// Look up the path of a folder recorded in the directory map.
+static void sit5_parent_path(const sit5_dir_entry_t *dmap, int dmap_cnt,
+                             uint32_t parent_off, char *ppath, size_t cap) {
+    ppath[0] = '\0';
+    if (parent_off == 0) return;
+    for (int i = 0; i < dmap_cnt; ++i) {
+        if (dmap[i].offset == parent_off) {
+            snprintf(ppath, cap, "%s", dmap[i].path);
+            return;
+        }
     }
+}
+
+// Walk a SIT5 archive and deliver each file as it is reached.
+// sit.md § 5.7 "Iteration Rules" and Appendix C
+static void extract_sit5(peel_in_t *in, uint64_t archive_off,
+                         peel_out_t *out) {
+    decode_ctx_t *ctx = in->ctx;
+    uint8_t top[SIT5_MIN_SIZE];
+
+    in_seek(in, archive_off);
+    size_t top_len = in_read(in, top, sizeof(top));
+    if (top_len < SIT5_MIN_SIZE)
+        decode_abort(ctx, "SIT5: archive too small (%zu bytes)", top_len);
 
     // sit.md § 5.2 "Top Header" — entry count at offset 92, cursor at 94
-    uint16_t entry_count = rd16be(base + 92);
-    uint32_t cursor      = rd32be(base + 94);
+    uint16_t entry_count = rd16be(top + 92);
+    uint32_t cursor      = rd32be(top + 94);
     uint32_t remaining   = entry_count;
+    int      entries     = 0;
 
     // Directory map for path resolution
     sit5_dir_entry_t dmap[SIT5_MAX_DIRS];
     int dmap_cnt = 0;
 
-    while (remaining > 0 && cursor != 0 &&
-           (size_t)cursor + 48 <= avail) {
-        const uint8_t *h1 = base + cursor;
+    // Header 1 (up to 64 KiB), plus a name that may run past its end
+    uint8_t *h1 = ctx_alloc(ctx, 0x10000 + 48 + 256);
+
+    while (remaining > 0 && cursor != 0) {
+        in_seek(in, archive_off + cursor);
+        size_t avail = in_read(in, h1, 48);
+        if (avail < 48) break;
 
         // sit.md § 5.3 "Entry Header" — validate entry magic
-        if (rd32be(h1) != SIT5_ENTRY_MAGIC) {
-            *err = make_err("SIT5: invalid entry magic at offset %u", cursor);
-            return false;
-        }
+        if (rd32be(h1) != SIT5_ENTRY_MAGIC)
+            decode_abort(ctx, "SIT5: invalid entry magic at offset %u", cursor);
 
         // sit.md § 5.3 — only version 1 is supported
-        if (h1[4] != 1) {
-            *err = make_err("SIT5: unsupported entry version %d", h1[4]);
-            return false;
-        }
+        if (h1[4] != 1)
+            decode_abort(ctx, "SIT5: unsupported entry version %d", h1[4]);
 
-        uint16_t h1_len = rd16be(h1 + 6);
-        if ((size_t)cursor + h1_len > avail) {
-            *err = make_err("SIT5: header1 extends past archive end");
-            return false;
-        }
+        uint16_t h1_len  = rd16be(h1 + 6);
+        uint16_t namelen = rd16be(h1 + 30);
+        size_t   name_cl = namelen < 255 ? namelen : 255;
+        size_t   want    = h1_len > 48 + name_cl ? h1_len : 48 + name_cl;
+        avail += in_read(in, h1 + 48, want - 48);
+        if (avail < h1_len)
+            decode_abort(ctx, "SIT5: header1 extends past archive end");
 
         // sit.md § 3.5 "Where CRCs Are Used" — verify header 1 CRC
         // (bytes 32–33 zeroed before computation)
-        {
-            uint8_t *tmp = malloc(h1_len);
-            if (!tmp) {
-                *err = make_err("SIT5: out of memory for header CRC");
-                return false;
-            }
-            memcpy(tmp, h1, h1_len);
-            tmp[32] = tmp[33] = 0;
-            uint16_t computed = sit_crc(tmp, h1_len);
-            uint16_t stored   = rd16be(h1 + 32);
-            free(tmp);
-            if (computed != stored) {
-                *err = make_err("SIT5: header CRC mismatch at offset %u",
-                                cursor);
-                return false;
-            }
-        }
+        uint16_t stored = rd16be(h1 + 32);
+        h1[32] = h1[33] = 0;
+        uint16_t computed = sit_crc(h1, h1_len);
+        wr16be(h1 + 32, stored);
+        if (computed != stored)
+            decode_abort(ctx, "SIT5: header CRC mismatch at offset %u", cursor);
 
         uint32_t h2_off       = cursor + h1_len;
         uint8_t  flags        = h1[9];
         uint32_t parent_off   = rd32be(h1 + 26);
-        uint16_t namelen      = rd16be(h1 + 30);
         uint32_t d_raw_len    = rd32be(h1 + 34);
         uint32_t d_packed_len = rd32be(h1 + 38);
         uint16_t d_crc        = rd16be(h1 + 42);
 
-
         // Read entry name (starts at byte 48 of header 1)
         char namebuf[256];
-        {
-            size_t cl = namelen;
-            if (cl > sizeof(namebuf) - 1) cl = sizeof(namebuf) - 1;
-            if ((size_t)cursor + 48 + cl > avail) cl = avail - (size_t)cursor - 48;
-            memcpy(namebuf, h1 + 48, cl);
-            namebuf[cl] = '\0';
-        }
+        if (name_cl > avail - 48) name_cl = avail - 48;
+        memcpy(namebuf, h1 + 48, name_cl);
+        namebuf[name_cl] = '\0';
 
         // sit.md § 5.6 "Special Markers" — 0xFFFFFFFF entries are skipped
         // before header 2 parsing, since header 2 may not exist.
@@ -847,11 +873,10 @@ static bool parse_sit5(const uint8_t *blob, size_t blob_len,
 
         // Parse header 2
         // sit.md § 5.4 "Secondary Header (Header 2)"
-        if ((size_t)h2_off + 32 > avail) {
-            *err = make_err("SIT5: header2 extends past archive end");
-            return false;
-        }
-        const uint8_t *h2 = base + h2_off;
+        uint8_t h2[36] = {0};
+        in_seek(in, archive_off + h2_off);
+        if (in_read(in, h2, sizeof(h2)) < 32)
+            decode_abort(ctx, "SIT5: header2 extends past archive end");
         uint16_t flags2   = rd16be(h2 + 0);
         uint32_t ftype    = rd32be(h2 + 4);
         uint32_t fcreator = rd32be(h2 + 8);
@@ -860,24 +885,24 @@ static bool parse_sit5(const uint8_t *blob, size_t blob_len,
         // sit.md § 5.4 — version-dependent skip past header 2 prefix
         uint32_t skip_extra = (h1[4] == 1) ? 22 : 18;
         bool     rsrc_present = (flags2 & 0x01) != 0;
-        const uint8_t *after_prefix = h2 + 14 + skip_extra;
-        const uint8_t *payload_ptr  = after_prefix;
+        uint64_t after_prefix = (uint64_t)h2_off + 14 + skip_extra;
+        uint64_t payload      = after_prefix;
 
         // sit.md § 5.4 — resource fork fields (conditional)
         uint32_t r_raw_len = 0, r_packed_len = 0;
         uint16_t r_crc     = 0;
         uint8_t  r_algo    = 0;
         if (rsrc_present) {
-            if ((size_t)(after_prefix - blob) + 14 > blob_len) {
-                *err = make_err("SIT5: resource info past archive end");
-                return false;
-            }
-            r_raw_len    = rd32be(after_prefix + 0);
-            r_packed_len = rd32be(after_prefix + 4);
-            r_crc        = rd16be(after_prefix + 8);
-            r_algo       = after_prefix[12];
-            uint8_t rpass = after_prefix[13];
-            payload_ptr  = after_prefix + 14 + rpass;
+            uint8_t ri[14];
+            in_seek(in, archive_off + after_prefix);
+            if (in_read(in, ri, sizeof(ri)) < sizeof(ri))
+                decode_abort(ctx, "SIT5: resource info past archive end");
+            r_raw_len    = rd32be(ri + 0);
+            r_packed_len = rd32be(ri + 4);
+            r_crc        = rd16be(ri + 8);
+            r_algo       = ri[12];
+            uint8_t rpass = ri[13];
+            payload      = after_prefix + 14 + rpass;
         }
 
         // sit.md § 5.3 — folder entries (flags bit 6)
@@ -885,16 +910,8 @@ static bool parse_sit5(const uint8_t *blob, size_t blob_len,
             uint16_t child_count = rd16be(h1 + 46);
 
             // Build parent path
-            char ppath[512] = "";
-            if (parent_off != 0) {
-                for (int i = 0; i < dmap_cnt; ++i) {
-                    if (dmap[i].offset == parent_off) {
-                        strncpy(ppath, dmap[i].path, sizeof(ppath) - 1);
-                        ppath[sizeof(ppath) - 1] = '\0';
-                        break;
-                    }
-                }
-            }
+            char ppath[512];
+            sit5_parent_path(dmap, dmap_cnt, parent_off, ppath, sizeof(ppath));
 
             // Record folder in directory map
             char folder_full[512];
@@ -909,7 +926,7 @@ static bool parse_sit5(const uint8_t *blob, size_t blob_len,
 
             // sit.md § 5.7 — add child count, advance into children
             remaining += child_count;
-            cursor = (uint32_t)(payload_ptr - base);
+            cursor = (uint32_t)payload;
             continue;
         }
 
@@ -919,37 +936,26 @@ static bool parse_sit5(const uint8_t *blob, size_t blob_len,
         uint8_t d_passlen = h1[47];
 
         // sit.md § 13.2 "Decompression Errors" — reject encrypted entries
-        if ((flags & 0x20) && d_raw_len && d_passlen) {
-            *err = make_err("SIT5: encrypted entries are not supported");
-            return false;
-        }
+        if ((flags & 0x20) && d_raw_len && d_passlen)
+            decode_abort(ctx, "SIT5: encrypted entries are not supported");
 
         // Build full path from parent
-        char ppath[512] = "";
-        if (parent_off != 0) {
-            for (int i = 0; i < dmap_cnt; ++i) {
-                if (dmap[i].offset == parent_off) {
-                    strncpy(ppath, dmap[i].path, sizeof(ppath) - 1);
-                    ppath[sizeof(ppath) - 1] = '\0';
-                    break;
-                }
-            }
-        }
+        char ppath[512];
+        sit5_parent_path(dmap, dmap_cnt, parent_off, ppath, sizeof(ppath));
         char full_name[512];
         build_path(full_name, sizeof(full_name), ppath, namebuf);
 
         // sit.md § 5.5 "Fork Data Layout" — resource fork first, then data
-        const uint8_t *r_base = payload_ptr;
-        const uint8_t *d_base = payload_ptr + (rsrc_present ? r_packed_len : 0);
-        if ((size_t)(d_base - blob) + d_packed_len > blob_len) {
-            *err = make_err("SIT5: data fork extends past archive end");
-            return false;
-        }
-
-        // Add entry to the list
-        sit_entry_t *ent = entry_list_push(entries, err);
-        if (!ent) return false;
-
+        uint64_t r_base = payload;
+        uint64_t d_base = payload + (rsrc_present ? r_packed_len : 0);
+        if (in->size != PEEL_SIZE_UNKNOWN &&
+            archive_off + d_base + d_packed_len > in->size)
+            decode_abort(ctx, "SIT5: data fork extends past archive end");
+
+        count_entry(ctx, &entries);
+        sit_entry_t entry;
+        sit_entry_t *ent = &entry;
+        memset(ent, 0, sizeof(*ent));
         strncpy(ent->name, full_name, sizeof(ent->name) - 1);
         ent->mac_type     = ftype;
         ent->mac_creator  = fcreator;
@@ -960,7 +966,7 @@ static bool parse_sit5(const uint8_t *blob, size_t blob_len,
             .packed_len = d_packed_len,
             .crc        = d_crc,
             .method     = (uint8_t)(d_algo & 0x0F),
-            .data       = d_base
+            .offset     = archive_off + d_base
         };
         ent->has_rsrc = rsrc_present && r_raw_len > 0;
         if (ent->has_rsrc) {
@@ -969,96 +975,17 @@ static bool parse_sit5(const uint8_t *blob, size_t blob_len,
                 .packed_len = r_packed_len,
                 .crc        = r_crc,
                 .method     = (uint8_t)(r_algo & 0x0F),
-                .data       = r_base
+                .offset     = archive_off + r_base
             };
         }
+        emit_entry(in, out, ent);
 
         // Advance cursor past the fork data
-        cursor = (uint32_t)((size_t)(d_base - base) + d_packed_len);
+        cursor = (uint32_t)(d_base + d_packed_len);
         remaining--;
     }
 
-    return true;
-}
-
-// ============================================================================
-// Static Helpers — Build File List from Entries
-// ============================================================================
-
-// Decompress all forks and produce the final peel_file_list_t.
-static peel_file_list_t build_file_list(const sit_entry_list_t *entries,
-                                        peel_err_t **err) {
-    if (entries->count == 0) {
-        return (peel_file_list_t){.files = NULL, .count = 0};
-    }
-
-    // Count entries with at least one non-empty fork
-    int file_count = 0;
-    for (int i = 0; i < entries->count; ++i) {
-        const sit_entry_t *e = &entries->items[i];
-        if (e->data_fork.raw_len > 0 ||
-            (e->has_rsrc && e->rsrc_fork.raw_len > 0)) {
-            file_count++;
-        }
-    }
-
-    peel_file_t *files = calloc((size_t)file_count, sizeof(peel_file_t));
-    if (!files) {
-        *err = make_err("SIT: out of memory for file list (%d files)",
-                        file_count);
-        return (peel_file_list_t){0};
-    }
-
-    int fi = 0;
-    for (int i = 0; i < entries->count && fi < file_count; ++i) {
-        const sit_entry_t *ent = &entries->items[i];
-
-        // Skip entries with no non-empty forks
-        if (ent->data_fork.raw_len == 0 &&
-            !(ent->has_rsrc && ent->rsrc_fork.raw_len > 0))
-            continue;
-
-        peel_file_t *f = &files[fi];
-
-        // Copy metadata
-        strncpy(f->meta.name, ent->name, sizeof(f->meta.name) - 1);
-        f->meta.mac_type     = ent->mac_type;
-        f->meta.mac_creator  = ent->mac_creator;
-        f->meta.finder_flags = ent->finder_flags;
-
-        // Decompress data fork
-        if (ent->data_fork.raw_len > 0) {
-            f->data_fork = decompress_fork(&ent->data_fork, err);
-            if (*err) {
-                // Clean up previously allocated files
-                for (int j = 0; j < fi; ++j) {
-                    peel_free(&files[j].data_fork);
-                    peel_free(&files[j].resource_fork);
-                }
-                free(files);
-                return (peel_file_list_t){0};
-            }
-        }
-
-        // Decompress resource fork
-        if (ent->has_rsrc && ent->rsrc_fork.raw_len > 0) {
-            f->resource_fork = decompress_fork(&ent->rsrc_fork, err);
-            if (*err) {
-                // Clean up this file's data fork and all prior files
-                peel_free(&f->data_fork);
-                for (int j = 0; j < fi; ++j) {
-                    peel_free(&files[j].data_fork);
-                    peel_free(&files[j].resource_fork);
-                }
-                free(files);
-                return (peel_file_list_t){0};
-            }
-        }
-
-        fi++;
-    }
-
-    return (peel_file_list_t){.files = files, .count = file_count};
+    ctx_free(ctx, h1);
 }
 
 // ============================================================================
@@ -1073,40 +1000,35 @@ bool sit_detect(const uint8_t *src, size_t len) {
 }
 
 // ============================================================================
-// Operations (Public API) — Archive Extraction
+// Operations — Stream Handler
 // ============================================================================
 
-// Detect, parse, and extract all files from a StuffIt archive.
+// Detect, parse, and deliver all files from a StuffIt archive.
 // Supports both classic (1.x–4.x) and SIT5 (5.x) formats.
-// sit.md § 2.3 "Detection Strategy" — prefer earliest match.
-peel_file_list_t peel_sit(const uint8_t *src, size_t len, peel_err_t **err) {
-    *err = NULL;
-
-    int64_t classic_off = find_classic_magic(src, len);
-    int64_t sit5_off    = find_sit5_magic(src, len);
+// sit.md § 2.3 "Detection Strategy" — prefer earliest match within the
+// leading window (all of a memory input).
+void sit_extract(peel_in_t *in, peel_out_t *out) {
+    const uint8_t *head;
+    size_t len = in_peek(in, SIZE_MAX, &head);
+    uint64_t base = in_tell(in);
 
-    sit_entry_list_t entries;
-    entry_list_init(&entries);
+    int64_t classic_off = find_classic_magic(head, len);
+    int64_t sit5_off    = find_sit5_magic(head, len);
 
     // Prefer the earliest match
-    if (classic_off >= 0 && (sit5_off < 0 || classic_off <= sit5_off)) {
-        if (!parse_classic(src, len, (size_t)classic_off, &entries, err)) {
-            entry_list_free(&entries);
-            return (peel_file_list_t){0};
-        }
-    } else if (sit5_off >= 0) {
-        if (!parse_sit5(src, len, (size_t)sit5_off, &entries, err)) {
-            entry_list_free(&entries);
-            return (peel_file_list_t){0};
-        }
-    } else {
-        *err = make_err("SIT: no valid StuffIt signature found");
-        entry_list_free(&entries);
-        return (peel_file_list_t){0};
-    }
+    if (classic_off >= 0 && (sit5_off < 0 || classic_off <= sit5_off))
+        extract_classic(in, base + (uint64_t)classic_off, out);
+    else if (sit5_off >= 0)
+        extract_sit5(in, base + (uint64_t)sit5_off, out);
+    else
+        decode_abort(in->ctx, "SIT: no valid StuffIt signature found");
+}
 
-    // Decompress all forks and build the result
-    peel_file_list_t result = build_file_list(&entries, err);
-    entry_list_free(&entries);
-    return result;
+// ============================================================================
+// Operations (Public API) — Archive Extraction
+// ============================================================================
+
+// Extract all files from a StuffIt archive in memory.
+peel_file_list_t peel_sit(const uint8_t *src, size_t len, peel_err_t **err) {
+    return collect_files(src, len, sit_extract, err);
 }
@@ -184,18 +184,14 @@ static const int predefined_dist_nsym[5] = {11, 13, 14, 11, 11};
 // sit13.md § 3.1 "Bit Order" — bits are consumed LSB-first within each byte.
 // Bytes are loaded one at a time into the low bits of the accumulator.
 typedef struct {
-    const uint8_t *src;
-    size_t         src_len;
-    size_t         pos;       // Next byte position to read
+    peel_span_t   *src;       // Compressed bytes of the fork
     uint32_t       acc;       // Bit accumulator
     int            avail;     // Valid bit count in acc
 } m13_bitrd_t;
 
-// Initialise the bit reader over a byte buffer.
-static void m13_br_init(m13_bitrd_t *r, const uint8_t *data, size_t len) {
-    r->src   = data;
-    r->src_len = len;
-    r->pos   = 0;
+// Initialise the bit reader over a fork's compressed span.
+static void m13_br_init(m13_bitrd_t *r, peel_span_t *src) {
+    r->src   = src;
     r->acc   = 0;
     r->avail = 0;
 }
@@ -203,8 +199,9 @@ static void m13_br_init(m13_bitrd_t *r, const uint8_t *data, size_t len) {
 // Ensure at least 25 valid bits in the accumulator.
 // sit13.md § 3.2 "Bitstream Reader" — refill while avail ≤ 24.
 static void m13_br_refill(m13_bitrd_t *r) {
-    while (r->avail <= 24 && r->pos < r->src_len) {
-        r->acc |= (uint32_t)r->src[r->pos++] << r->avail;
+    int c;
+    while (r->avail <= 24 && (c = span_getc(r->src)) >= 0) {
+        r->acc |= (uint32_t)c << r->avail;
         r->avail += 8;
     }
 }
@@ -422,8 +419,10 @@ static void m13_decode_lengths(m13_hnode_t *pool, int meta_root,
 // shared across all trees.
 
 // Full decoder context for one method-13 stream.
-typedef struct {
+typedef struct sit13_state m13_state_t;
+struct sit13_state {
     m13_bitrd_t br;
+    decode_ctx_t *ctx;
 
     // Node pool shared by all Huffman trees
     m13_hnode_t pool[M13_POOL_CAP];
@@ -444,7 +443,11 @@ typedef struct {
     int match_from;
 
     bool ready;
-} m13_state_t;
+
+    // Progress, for error messages
+    size_t produced;
+    size_t uncomp_len;
+};
 
 // ============================================================================
 // Static Helpers
@@ -602,60 +605,46 @@ static int m13_output(m13_state_t *st, uint8_t *dst, size_t cap) {
 }
 
 // ============================================================================
-// Entry Point (Internal)
+// Internal Entry Points — called from sit.c's fork readers
 // ============================================================================
 
-// Decompress method-13 (LZSS + Huffman) compressed data into a freshly
-// allocated buffer.  Called by sit.c for entries using compression method 13.
+// Start decoding a method-13 (LZSS + Huffman) fork of uncomp_len bytes.
 //
 // sit13.md § "Appendix A: Complete Decompression Walkthrough"
 //   1. Read header, build (or select) Huffman trees.
-//   2. Main decode loop: literals + matches into sliding window.
-//   3. Return the output buffer.
-peel_buf_t peel_sit13(const uint8_t *src, size_t len, size_t uncomp_len, peel_err_t **err) {
-    *err = NULL;
-
-    // Handle degenerate case: zero-length output
-    if (uncomp_len == 0) {
-        return (peel_buf_t){.data = NULL, .size = 0, .owned = false};
-    }
-
-    // Allocate the output buffer up front (known size from container metadata)
-    uint8_t *out = malloc(uncomp_len);
-    if (!out) {
-        *err = make_err("sit13: out of memory allocating %zu-byte output buffer", uncomp_len);
-        return (peel_buf_t){0};
-    }
-
-    // The decoder state is large (~70 KiB), so heap-allocate to avoid stack overflow
-    m13_state_t *st = calloc(1, sizeof(*st));
-    if (!st) {
-        free(out);
-        *err = make_err("sit13: out of memory allocating decoder state");
-        return (peel_buf_t){0};
-    }
+//   2. Main decode loop: literals + matches into sliding window
+//      (sit13_read, as the caller pulls bytes).
+m13_state_t *sit13_open(peel_span_t *src, uint32_t uncomp_len,
+                        decode_ctx_t *ctx) {
+    // The decoder state is large (~70 KiB), so it lives on the heap
+    m13_state_t *st = ctx_alloc(ctx, sizeof(*st));
+    st->ctx = ctx;
+    st->uncomp_len = uncomp_len;
 
     // Initialise bit reader over the compressed input
-    m13_br_init(&st->br, src, len);
+    m13_br_init(&st->br, src);
 
     // Parse header and build Huffman trees
     if (m13_setup(st) < 0) {
-        free(out);
-        free(st);
-        *err = make_err("sit13: invalid header or tree construction failed");
-        return (peel_buf_t){0};
+        decode_abort(ctx, "sit13: invalid header or tree construction failed");
     }
+    return st;
+}
 
-    // Decode uncomp_len bytes through the main loop
-    int produced = m13_output(st, out, uncomp_len);
-    free(st);
-
-    if (produced < 0 || (size_t)produced != uncomp_len) {
-        free(out);
-        *err = make_err("sit13: decompression failed (produced %d of %zu bytes)",
-                        produced, uncomp_len);
-        return (peel_buf_t){0};
+// Decode the next n bytes of the fork.
+size_t sit13_read(m13_state_t *st, uint8_t *dst, size_t n) {
+    int produced = m13_output(st, dst, n);
+    if (produced < 0) {
+        decode_abort(st->ctx, "sit13: decompression failed (produced %zu of %zu bytes)",
+                     st->produced, st->uncomp_len);
     }
+    st->produced += (size_t)produced;
+    return (size_t)produced;
+}
 
-    return (peel_buf_t){.data = out, .size = uncomp_len, .owned = true};
+// Release a method-13 decoder.
+void sit13_close(m13_state_t *st) {
+    if (st) {
+        ctx_free(st->ctx, st);
+    }
 }
@@ -19,11 +19,9 @@
 // Bitstream Reader — sit15.md §3.1 "Byte-to-Bit Extraction"
 // ============================================================================
 
-// Bitstream state — MSB-first extraction from a byte buffer.
+// Bitstream state — MSB-first extraction from a fork's compressed span.
 typedef struct {
-    const uint8_t *data;
-    size_t         len;
-    size_t         pos;          // next byte to consume
+    peel_span_t   *src;
     uint32_t       window;       // left-aligned shift register
     int            avail;        // valid bits in window (MSB end)
 } bs_reader;
@@ -32,12 +30,10 @@ typedef struct {
 typedef struct arsenic_state arsenic_state;
 static void arsenic_abort(arsenic_state *s, const char *fmt, ...);
 
-// Initialise a bitstream reader over a byte buffer.
-static void bs_init(bs_reader *r, const uint8_t *buf, size_t len)
+// Initialise a bitstream reader over a fork's compressed span.
+static void bs_init(bs_reader *r, peel_span_t *src)
 {
-    r->data   = buf;
-    r->len    = len;
-    r->pos    = 0;
+    r->src    = src;
     r->window = 0;
     r->avail  = 0;
 }
@@ -45,8 +41,9 @@ static void bs_init(bs_reader *r, const uint8_t *buf, size_t len)
 // Pull whole bytes into the shift register until we have ≥24 bits or exhausted input.
 static void bs_refill(bs_reader *r)
 {
-    while (r->avail <= 24 && r->pos < r->len) {
-        r->window |= (uint32_t)r->data[r->pos++] << (24 - r->avail);
+    int c;
+    while (r->avail <= 24 && (c = span_getc(r->src)) >= 0) {
+        r->window |= (uint32_t)c << (24 - r->avail);
         r->avail  += 8;
     }
 }
@@ -582,11 +579,10 @@ static bool parse_header(arsenic_state *s)
     // Initial end-of-stream flag.
     s->eos = ac_decode_sym(s, &s->m_primary) != 0;
 
-    // Allocate block buffers.
-    s->blk_buf = malloc((size_t)s->blk_cap);
-    s->lf_map  = malloc((size_t)s->blk_cap * sizeof(uint32_t));
-    if (!s->blk_buf || !s->lf_map)
-        arsenic_abort(s, "sit15: out of memory allocating block buffers");
+    // Allocate block buffers (owned by the decode context, so an abort
+    // mid-stream releases them too).
+    s->blk_buf = ctx_alloc(s->ctx, (size_t)s->blk_cap);
+    s->lf_map  = ctx_alloc(s->ctx, (size_t)s->blk_cap * sizeof(uint32_t));
 
     return true;
 }
@@ -595,72 +591,55 @@ static bool parse_header(arsenic_state *s)
 // sit15.md §11.2 "Memory Allocation" — releases blk_buf + lf_map.
 static void free_buffers(arsenic_state *s)
 {
-    free(s->blk_buf);
-    free(s->lf_map);
+    ctx_free(s->ctx, s->blk_buf);
+    ctx_free(s->ctx, s->lf_map);
     s->blk_buf = NULL;
     s->lf_map  = NULL;
 }
 
 // ============================================================================
-// Entry Point (Internal)
+// Internal Entry Points — called from sit.c's fork readers
 // ============================================================================
 
-// Decompress method-15 (Arsenic) compressed data into a freshly allocated buffer.
-// Called by sit.c for entries using compression method 15.
+// Start decoding a method-15 (Arsenic) fork.
 //
 // sit15.md § "Appendix A: Complete Decompression Walkthrough"
 //   1. Parse stream header, bootstrap arithmetic decoder.
-//   2. Decode blocks (selector loop → MTF → inverse BWT).
+//   2. Decode blocks (selector loop → MTF → inverse BWT) as the caller
+//      pulls bytes through sit15_read.
 //   3. Expand via randomization + final RLE.
-//   4. Return the output buffer.
-peel_buf_t peel_sit15(const uint8_t *src, size_t len, size_t uncomp_len, peel_err_t **err) {
-    *err = NULL;
-
-    // Handle degenerate case: zero-length output
-    if (uncomp_len == 0) {
-        return (peel_buf_t){.data = NULL, .size = 0, .owned = false};
-    }
-
-    // Allocate the output buffer up front (known size from container metadata)
-    uint8_t *out = malloc(uncomp_len);
-    if (!out) {
-        *err = make_err("sit15: out of memory allocating %zu-byte output buffer", uncomp_len);
-        return (peel_buf_t){0};
-    }
+arsenic_state *sit15_open(peel_span_t *src, uint32_t uncomp_len,
+                          decode_ctx_t *ctx)
+{
+    (void)uncomp_len; // The caller stops reading at the fork's length
 
-    // Use setjmp/longjmp for deep-error abort during decompression
-    decode_ctx_t dctx;
-    if (setjmp(dctx.jmp) != 0) {
-        // Arrived here via arsenic_abort — propagate the error message
-        free(out);
-        *err = make_err("%s", dctx.errmsg);
-        return (peel_buf_t){0};
-    }
-
-    // The decoder state is large, so heap-allocate to avoid stack overflow.
-    arsenic_state *s = calloc(1, sizeof *s);
-    if (!s) {
-        free(out);
-        *err = make_err("sit15: out of memory allocating decoder state");
-        return (peel_buf_t){0};
-    }
+    // The decoder state is large, so it lives on the heap.
+    arsenic_state *s = ctx_alloc(ctx, sizeof *s);
 
     // Wire up the decode context for longjmp error handling
-    s->ctx = &dctx;
+    s->ctx = ctx;
 
     // Initialise the bit reader over the compressed input
-    bs_init(&s->bits, src, len);
+    bs_init(&s->bits, src);
 
     // Parse the Arsenic stream header (signature, block size, initial EOS)
     parse_header(s);
+    return s;
+}
 
-    // Decompress uncomp_len bytes through the full pipeline
-    for (size_t i = 0; i < uncomp_len; i++)
-        out[i] = produce_byte(s);
+// Decode the next n bytes of the fork through the full pipeline.
+size_t sit15_read(arsenic_state *s, uint8_t *dst, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = produce_byte(s);
+    return n;
+}
 
-    // Clean up decoder state
+// Release a method-15 decoder and its block buffers.
+void sit15_close(arsenic_state *s)
+{
+    if (!s)
+        return;
     free_buffers(s);
-    free(s);
-
-    return (peel_buf_t){.data = out, .size = uncomp_len, .owned = true};
+    ctx_free(s->ctx, s);
 }
@@ -30,12 +30,11 @@ typedef struct {
     uint8_t symbol;  // valid only when zero == -1 && one == -1
 } m3_node_t;
 
-// MSB-first bit reader over a fixed input buffer.
+// MSB-first bit reader over a fork's compressed span.
 typedef struct {
-    const uint8_t *src;
-    size_t         len;
-    size_t         byte_pos;  // index of byte currently being drained
-    unsigned       bit_pos;   // 0..7, position of *next* bit within byte (0 = MSB)
+    peel_span_t   *src;
+    unsigned       byte;      // byte currently being drained
+    unsigned       bits_left; // 0..8, bits of `byte` not yet read
     decode_ctx_t  *ctx;
 } m3_bits_t;
 
@@ -45,18 +44,16 @@ typedef struct {
 
 // sit3.md § 2.1 — MSB-first within each byte, bytes consumed in order.
 static int m3_read_bit(m3_bits_t *b) {
-    if (b->byte_pos >= b->len) {
-        decode_abort(b->ctx, "SIT3: premature end of compressed stream");
-    }
-    uint8_t byte = b->src[b->byte_pos];
-    unsigned shift = 7u - b->bit_pos;
-    int bit = (byte >> shift) & 1;
-    b->bit_pos++;
-    if (b->bit_pos == 8) {
-        b->bit_pos = 0;
-        b->byte_pos++;
+    if (b->bits_left == 0) {
+        int c = span_getc(b->src);
+        if (c < 0) {
+            decode_abort(b->ctx, "SIT3: premature end of compressed stream");
+        }
+        b->byte = (unsigned)c;
+        b->bits_left = 8;
     }
-    return bit;
+    b->bits_left--;
+    return (int)((b->byte >> b->bits_left) & 1u);
 }
 
 // Read N bits MSB-first as an unsigned integer.
@@ -114,78 +111,80 @@ static int m3_read_node(m3_bits_t *b, m3_tree_t *t) {
     return idx;
 }
 
+// ============================================================================
+// Decoder State
+// ============================================================================
+
+// One method-3 fork being decoded: the bit reader and the tree read from
+// the head of its stream.
+typedef struct sit3_state sit3_state_t;
+struct sit3_state {
+    m3_bits_t bits;
+    m3_tree_t tree;
+    int       root;
+};
+
 // ============================================================================
 // Decode Loop
 // ============================================================================
 
 // Walk the tree one bit per branch.  At a leaf, emit the symbol.
-// sit3.md § 2.3 — repeat until uncomp_len bytes have been produced;
-// trailing bits in the final compressed byte are discarded.
-static void m3_decode(m3_bits_t *b, const m3_tree_t *t, int root,
-                      uint8_t *out, size_t uncomp_len) {
+// sit3.md § 2.3 — the caller stops once uncomp_len bytes have been
+// produced; trailing bits in the final compressed byte are discarded.
+static void m3_decode(sit3_state_t *st, uint8_t *out, size_t n) {
+    const m3_tree_t *t = &st->tree;
+    int root = st->root;
     // Degenerate single-leaf tree: the code for the only symbol is the
-    // empty bit string.  Emit `uncomp_len` copies without reading bits.
+    // empty bit string.  Emit copies without reading bits.
     if (t->nodes[root].zero == -1 && t->nodes[root].one == -1) {
-        memset(out, t->nodes[root].symbol, uncomp_len);
+        memset(out, t->nodes[root].symbol, n);
         return;
     }
-    for (size_t i = 0; i < uncomp_len; i++) {
-        int n = root;
-        while (t->nodes[n].zero != -1 || t->nodes[n].one != -1) {
-            int bit = m3_read_bit(b);
-            n = (bit == 1) ? t->nodes[n].one : t->nodes[n].zero;
-            if (n < 0) {
+    for (size_t i = 0; i < n; i++) {
+        int node = root;
+        while (t->nodes[node].zero != -1 || t->nodes[node].one != -1) {
+            int bit = m3_read_bit(&st->bits);
+            node = (bit == 1) ? t->nodes[node].one : t->nodes[node].zero;
+            if (node < 0) {
                 // Defensive: malformed tree pointer.  read_node() should
                 // never leave -1 on an internal node, but guard anyway.
-                decode_abort(b->ctx, "SIT3: corrupt Huffman tree (NULL child)");
+                decode_abort(st->bits.ctx,
+                             "SIT3: corrupt Huffman tree (NULL child)");
             }
         }
-        out[i] = t->nodes[n].symbol;
+        out[i] = t->nodes[node].symbol;
     }
 }
 
 // ============================================================================
-// Public Entry Point — called from sit.c decompress_fork() dispatch
+// Internal Entry Points — called from sit.c's fork readers
 // ============================================================================
 
-// Decompress a method-3 (static Huffman) fork.  Returns an owned buffer
-// of exactly `uncomp_len` bytes on success, or a zero buffer with *err
-// set on failure.  CRC verification against the stored fork CRC is the
-// caller's responsibility (sit.c does this for all classic methods).
-peel_buf_t peel_sit3(const uint8_t *src, size_t len, size_t uncomp_len,
-                     peel_err_t **err) {
-    *err = NULL;
-
-    decode_ctx_t ctx;
-    if (setjmp(ctx.jmp) != 0) {
-        *err = make_err("%s", ctx.errmsg);
-        return (peel_buf_t){0};
-    }
-
-    // Empty fork — nothing to decode, but the spec still requires us to
-    // not consume any bits.  Return an empty owned buffer.
-    if (uncomp_len == 0) {
-        return (peel_buf_t){.data = NULL, .size = 0, .owned = false};
+// Start decoding a method-3 (static Huffman) fork of uncomp_len (> 0)
+// bytes: reads the tree from the head of src.  CRC verification against
+// the stored fork CRC is the caller's responsibility (sit.c does this for
+// all classic methods).
+sit3_state_t *sit3_open(peel_span_t *src, uint32_t uncomp_len,
+                        decode_ctx_t *ctx) {
+    if (src->left == 0) {
+        decode_abort(ctx, "SIT3: zero-length compressed stream but "
+                          "uncomp_len=%u", uncomp_len);
     }
+    sit3_state_t *st = ctx_alloc(ctx, sizeof(*st));
+    st->bits = (m3_bits_t){.src = src, .ctx = ctx};
+    st->root = m3_read_node(&st->bits, &st->tree);
+    return st;
+}
 
-    if (len == 0) {
-        decode_abort(&ctx, "SIT3: zero-length compressed stream but "
-                           "uncomp_len=%zu", uncomp_len);
-    }
+// Decode the next n bytes of the fork.
+size_t sit3_read(sit3_state_t *st, uint8_t *dst, size_t n) {
+    m3_decode(st, dst, n);
+    return n;
+}
 
-    uint8_t *out = malloc(uncomp_len);
-    if (!out) {
-        *err = make_err("SIT3: out of memory allocating %zu bytes for fork",
-                        uncomp_len);
-        return (peel_buf_t){0};
+// Release a method-3 decoder.
+void sit3_close(sit3_state_t *st) {
+    if (st) {
+        ctx_free(st->bits.ctx, st);
     }
-
-    m3_bits_t bits = {.src = src, .len = len, .byte_pos = 0, .bit_pos = 0,
-                      .ctx = &ctx};
-    m3_tree_t tree = {.next_node = 0};
-
-    int root = m3_read_node(&bits, &tree);
-    m3_decode(&bits, &tree, root, out, uncomp_len);
-
-    return (peel_buf_t){.data = out, .size = uncomp_len, .owned = true};
 }
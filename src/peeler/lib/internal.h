@@ -31,10 +31,14 @@ peel_err_t *make_err(const char *fmt, ...)
 // setjmp/longjmp Abort Context — architecture.md § "setjmp/longjmp"
 // ============================================================================
 
+// Heap block owned by a decode context (see ctx_alloc).
+typedef struct ctx_block ctx_block_t;
+
 // Jump-target context for deep-error abort in decompressors.
 typedef struct {
     jmp_buf jmp;
     char errmsg[256];
+    ctx_block_t *blocks; // Live ctx_alloc() blocks, released by ctx_free_all()
 } decode_ctx_t;
 
 // Format a message into ctx->errmsg and longjmp back to the setjmp site.
@@ -44,6 +48,30 @@ void decode_abort(decode_ctx_t *ctx, const char *fmt, ...)
 #endif
     ;
 
+// ============================================================================
+// Context-Owned Allocations — architecture.md § "Streaming Session"
+// ============================================================================
+
+// Allocate a zeroed block owned by ctx.  Aborts via ctx on failure.  Blocks
+// still live when a decode aborts are released by ctx_free_all(), so decoder
+// state never leaks across a longjmp.
+void *ctx_alloc(decode_ctx_t *ctx, size_t size);
+
+// Resize a ctx-owned block (NULL allocates).  Bytes past the old size are
+// not zeroed.  Aborts via ctx on failure.
+void *ctx_realloc(decode_ctx_t *ctx, void *p, size_t size);
+
+// Release one ctx-owned block.  Safe to call with NULL.
+void ctx_free(decode_ctx_t *ctx, void *p);
+
+// Mark the current point in ctx's allocations.  ctx_release() then frees the
+// marker and everything allocated after it — one nested layer's state.
+void *ctx_mark(decode_ctx_t *ctx);
+void ctx_release(decode_ctx_t *ctx, void *mark);
+
+// Release every block still owned by ctx.
+void ctx_free_all(decode_ctx_t *ctx);
+
 // ============================================================================
 // Big-Endian Read Helpers
 // ============================================================================
@@ -113,37 +141,171 @@ peel_buf_t grow_finish(grow_buf_t *g);
 // Release a growable buffer without producing a peel_buf_t (for error paths).
 void grow_free(grow_buf_t *g);
 
+// ============================================================================
+// Streaming Input — architecture.md § "Streaming Input"
+// ============================================================================
+
+// Bytes an input buffers ahead of its consumer, and so the most that can be
+// peeked at once.  Formats are detected from this many leading bytes.
+#define PEEL_WINDOW 65536
+
+// A bounded window over a peel_reader_t; every layer reads through one.  A
+// memory input borrows the caller's buffer whole, so peeks see all of it.
+typedef struct {
+    peel_reader_t rd; // Upstream reader (unused for memory inputs)
+    decode_ctx_t *ctx; // Read failures abort here
+    uint8_t *buf; // Window storage (the caller's buffer for memory inputs)
+    size_t cap; // Window capacity
+    size_t pos; // Next unread byte in buf
+    size_t len; // Valid bytes in buf
+    uint64_t base; // Input offset of buf[0]
+    uint64_t size; // Total input length, or PEEL_SIZE_UNKNOWN
+    bool eof; // Upstream has reported its end
+    bool borrowed; // buf belongs to the caller (memory input)
+} peel_in_t;
+
+// Open a windowed input over rd; size is its length if known.
+peel_in_t *in_open(decode_ctx_t *ctx, const peel_reader_t *rd, uint64_t size);
+
+// Open an input over a caller-owned buffer (no copy).
+peel_in_t *in_open_mem(decode_ctx_t *ctx, const uint8_t *src, size_t len);
+
+// Release an input (not its upstream reader).
+void in_close(peel_in_t *in);
+
+// Make up to want bytes readable without consuming them (fewer at the end of
+// the input or beyond PEEL_WINDOW).  Returns the count; *out points at them.
+size_t in_peek(peel_in_t *in, size_t want, const uint8_t **out);
+
+// Consume up to n bytes into dst.  Returns fewer only at the end of input.
+size_t in_read(peel_in_t *in, uint8_t *dst, size_t n);
+
+// Slow path of in_getc(): refill the window.
+int in_getc_refill(peel_in_t *in);
+
+// Consume one byte; -1 at the end of input.
+static inline int in_getc(peel_in_t *in) {
+    if (in->pos < in->len) {
+        return in->buf[in->pos++];
+    }
+    return in_getc_refill(in);
+}
+
+// Input offset of the next byte in_read() would return.
+static inline uint64_t in_tell(const peel_in_t *in) {
+    return in->base + in->pos;
+}
+
+// True if in_seek() can move backwards (memory input or seekable reader).
+bool in_seekable(const peel_in_t *in);
+
+// Move to an absolute input offset.  Forward moves on a forward-only input
+// read and drop the bytes in between; backward ones abort.
+void in_seek(peel_in_t *in, uint64_t off);
+
+// At most `left` further bytes of an input — one fork's compressed bytes.
+typedef struct {
+    peel_in_t *in;
+    uint64_t left;
+} peel_span_t;
+
+// Consume one byte of the span; -1 once it (or the input) is exhausted.
+static inline int span_getc(peel_span_t *s) {
+    if (s->left == 0) {
+        return -1;
+    }
+    int c = in_getc(s->in);
+    if (c >= 0) {
+        s->left--;
+    }
+    return c;
+}
+
+// Consume up to n bytes of the span into dst.
+size_t span_read(peel_span_t *s, uint8_t *dst, size_t n);
+
+// Wrap an input as a reader, so it can feed a nested input.
+peel_reader_t in_reader(peel_in_t *in);
+
+// Reader and size of a file opened for streaming (see peel_stream_path).
+bool file_reader_open(const char *path, peel_reader_t *rd, uint64_t *size, peel_err_t **err);
+
+// Close a reader returned by file_reader_open().
+void file_reader_close(peel_reader_t *rd);
+
+// ============================================================================
+// Streaming Output — architecture.md § "Streaming Output"
+// ============================================================================
+
+// Where an archive layer delivers its files (defined in peeler.c).  Errors,
+// including a rejecting sink, abort via the session's decode context.
+typedef struct peel_out peel_out_t;
+
+// Start a file.  Each fork's length is fixed here and enforced by out_fork().
+void out_begin(peel_out_t *out, const peel_file_meta_t *meta, uint64_t data_len, uint64_t rsrc_len);
+
+// Deliver one fork of the current file by draining rd (reads never fail
+// softly; decoders abort instead).  Forks may come in either order.
+void out_fork(peel_out_t *out, peel_fork_t fork, const peel_reader_t *rd);
+
+// Finish the current file.
+void out_end(peel_out_t *out);
+
 // ============================================================================
 // Format Handler Registration — architecture.md § "Format Handler Registration"
 // ============================================================================
 
 // Classification of a format handler.
 typedef enum {
-    PEEL_FMT_WRAPPER, // One buffer in, one buffer out (e.g. HQX, MacBinary)
-    PEEL_FMT_ARCHIVE, // One buffer in, file list out  (e.g. StuffIt, CPT)
+    PEEL_FMT_WRAPPER, // One stream in, one stream out (e.g. HQX, MacBinary)
+    PEEL_FMT_ARCHIVE, // One stream in, files out     (e.g. StuffIt, CPT)
 } peel_fmt_kind_t;
 
+// Open a wrapper's payload: fills *payload with a reader over the unwrapped
+// bytes (it reads from in, which must stay open) and returns their length.
+typedef uint64_t (*peel_open_fn)(peel_in_t *in, peel_reader_t *payload);
+
+// Deliver every file of an archive (or a wrapper's single file) to out.
+typedef void (*peel_extract_fn)(peel_in_t *in, peel_out_t *out);
+
 // A registered format handler entry in the detection table.
 typedef struct {
     const char *name;
     peel_fmt_kind_t kind;
     bool (*detect)(const uint8_t *src, size_t len);
-    peel_buf_t (*peel_wrapper)(const uint8_t *src, size_t len, peel_err_t **err);
-    peel_file_list_t (*peel_archive)(const uint8_t *src, size_t len, peel_err_t **err);
+    peel_open_fn open; // PEEL_FMT_WRAPPER
+    peel_extract_fn extract; // PEEL_FMT_ARCHIVE
 } peel_format_t;
 
 // ============================================================================
-// Per-Format Detect Functions
+// Buffer Entry Points over the Streaming Core
+// ============================================================================
+
+// Run extract over a memory buffer and collect its files (no nested peeling).
+peel_file_list_t collect_files(const uint8_t *src, size_t len, peel_extract_fn extract, peel_err_t **err);
+
+// Run a wrapper's open over a memory buffer and collect its payload.
+peel_buf_t collect_payload(const uint8_t *src, size_t len, peel_open_fn open, peel_err_t **err);
+
+// ============================================================================
+// Per-Format Handlers
 // ============================================================================
 
-// Each format source file defines its own detect function for the handler table.
+// Each format source file defines its own detect function and stream
+// handlers for the handler table.
 
 bool hqx_detect(const uint8_t *src, size_t len);
+uint64_t hqx_open(peel_in_t *in, peel_reader_t *payload);
+void hqx_extract(peel_in_t *in, peel_out_t *out);
 
 bool bin_detect(const uint8_t *src, size_t len);
+uint64_t bin_open(peel_in_t *in, peel_reader_t *payload);
+void bin_extract(peel_in_t *in, peel_out_t *out);
 
 bool sit_detect(const uint8_t *src, size_t len);
+void sit_extract(peel_in_t *in, peel_out_t *out);
 
 bool cpt_detect(const uint8_t *src, size_t len);
+void cpt_extract(peel_in_t *in, peel_out_t *out);
 
 #endif // PEELER_INTERNAL_H
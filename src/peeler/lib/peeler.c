@@ -2,8 +2,9 @@
 // Copyright (c) pappadf
 
 // peeler.c
-// Core library entry points: peel(), peel_path(), format detection, and
-// buffer/file-list lifecycle helpers.
+// Core library entry points: the streaming session that chains format layers
+// from a reader to a sink, peel()/peel_path() collecting its output in
+// memory, format detection, and buffer/file-list lifecycle helpers.
 
 #include "internal.h"
 
@@ -17,6 +18,9 @@
 // degenerate or malicious inputs that detect as wrappers in a loop).
 #define MAX_PEEL_DEPTH 32
 
+// Bytes moved per sink write.
+#define PEEL_CHUNK 16384
+
 // ============================================================================
 // Format Handler Table — architecture.md § "Static Registration"
 // ============================================================================
@@ -24,14 +28,63 @@
 // Detection order matters: wrappers first so outer encodings are stripped
 // before probing for archive signatures buried inside.
 static const peel_format_t g_formats[] = {
-    {"hqx", PEEL_FMT_WRAPPER, hqx_detect, peel_hqx, NULL    },
-    {"bin", PEEL_FMT_WRAPPER, bin_detect, peel_bin, NULL    },
-    {"sit", PEEL_FMT_ARCHIVE, sit_detect, NULL,     peel_sit},
-    {"cpt", PEEL_FMT_ARCHIVE, cpt_detect, NULL,     peel_cpt},
+    {"hqx", PEEL_FMT_WRAPPER, hqx_detect, hqx_open, hqx_extract},
+    {"bin", PEEL_FMT_WRAPPER, bin_detect, bin_open, bin_extract},
+    {"sit", PEEL_FMT_ARCHIVE, sit_detect, NULL,     sit_extract},
+    {"cpt", PEEL_FMT_ARCHIVE, cpt_detect, NULL,     cpt_extract},
 };
 
 static const int g_num_formats = (int)(sizeof(g_formats) / sizeof(g_formats[0]));
 
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+// One peeling run: the abort context every layer and decoder shares, where
+// files go, and the chunk buffer forks are moved through.  Heap-allocated so
+// nothing the setjmp site needs lives in a clobberable local.
+typedef struct {
+    decode_ctx_t ctx;
+    const peel_sink_t *sink;
+    uint8_t *chunk; // PEEL_CHUNK bytes
+    int files; // Files delivered so far
+} peel_session_t;
+
+// Output stage of one archive layer (see out_begin/out_fork/out_end).
+struct peel_out {
+    peel_session_t *s;
+    int depth; // Layers above this one; bounds nested peeling
+    bool nested; // Peel data forks that are themselves wrapped
+    peel_file_meta_t meta; // Current file
+    uint64_t len[2]; // Announced fork lengths, by peel_fork_t
+    bool begun; // begin() has reached the sink
+    bool replaced; // Data fork was peeled into files of its own
+};
+
+// What one session runs: its input (a reader, or with rd NULL a memory
+// buffer), its sink, and with extract/open set just that one handler rather
+// than every layer.
+typedef struct {
+    const peel_reader_t *rd;
+    uint64_t size;
+    const uint8_t *src;
+    size_t len;
+    const peel_sink_t *sink;
+    peel_extract_fn extract;
+    peel_open_fn open;
+    decode_ctx_t **ctx_slot; // If set, receives the session's abort context
+} peel_run_t;
+
+// Buffer-API collector: gathers streamed files into a peel_file_list_t.
+typedef struct {
+    peel_file_t *files;
+    int count;
+    int cap;
+    uint64_t len[2]; // Current file's fork lengths, by peel_fork_t
+    grow_buf_t fork[2]; // Current file's forks, by peel_fork_t
+    decode_ctx_t *ctx; // Session context (grow_* abort here)
+} collector_t;
+
 // ============================================================================
 // Static Helpers
 // ============================================================================
@@ -46,243 +99,380 @@ static const peel_format_t *detect_format(const uint8_t *src, size_t len) {
     return NULL;
 }
 
-// Wrap a raw buffer as a single-file result with no metadata.
-// If `owned_data` is non-NULL, ownership of that allocation is transferred
-// into the result.  Otherwise the data at `src` is copied.
-static peel_file_list_t wrap_single_file(const uint8_t *src, size_t len, uint8_t *owned_data, peel_err_t **err) {
-    peel_file_t *files = calloc(1, sizeof(peel_file_t));
-    if (!files) {
-        *err = make_err("out of memory allocating single-file result");
-        // Caller is responsible for freeing owned_data if we fail
-        return (peel_file_list_t){0};
-    }
+// Printable name of the current file for error messages.
+static const char *out_name(const peel_out_t *out) {
+    return out->meta.name[0] ? out->meta.name : "(unnamed)";
+}
 
-    if (owned_data) {
-        // Transfer ownership of the existing allocation
-        files[0].data_fork = (peel_buf_t){.data = owned_data, .size = len, .owned = true};
-    } else {
-        // Copy the borrowed input into a fresh buffer
-        files[0].data_fork = peel_buf_copy(src, len, err);
-        if (*err) {
-            free(files);
-            return (peel_file_list_t){0};
-        }
+// Pass the current file's begin() to the sink, once.
+static void sink_begin(peel_out_t *out) {
+    const peel_sink_t *sink = out->s->sink;
+    if (out->begun) {
+        return;
+    }
+    out->begun = true;
+    if (sink->begin && sink->begin(sink->ctx, &out->meta, out->len[PEEL_DATA_FORK], out->len[PEEL_RESOURCE_FORK])) {
+        decode_abort(&out->s->ctx, "output rejected '%s'", out_name(out));
     }
-
-    return (peel_file_list_t){.files = files, .count = 1};
 }
 
-// ============================================================================
-// Operations (Public API) — Format Detection
-// ============================================================================
-
-// Identify the outermost format without peeling.
-const char *peel_detect(const uint8_t *src, size_t len) {
-    const peel_format_t *fmt = detect_format(src, len);
-    return fmt ? fmt->name : NULL;
+// Drain rd into the sink as one fork of the current file, holding it to
+// the length announced in out_begin().
+static void pump_fork(peel_out_t *out, peel_fork_t fork, const peel_reader_t *rd) {
+    peel_session_t *s = out->s;
+    const char *which = fork == PEEL_DATA_FORK ? "data" : "resource";
+    uint64_t want = out->len[fork];
+    uint64_t done = 0;
+    for (;;) {
+        size_t n = PEEL_CHUNK;
+        if (want != PEEL_SIZE_UNKNOWN && want - done < n) {
+            n = (size_t)(want - done);
+        }
+        if (n == 0) {
+            n = 1; // Probe: the fork must end here
+        }
+        ptrdiff_t got = rd->read(rd->ctx, s->chunk, n);
+        if (got < 0) {
+            decode_abort(&s->ctx, "read error in %s fork of '%s'", which, out_name(out));
+        }
+        if (got == 0) {
+            break;
+        }
+        if (want != PEEL_SIZE_UNKNOWN && (uint64_t)got > want - done) {
+            decode_abort(&s->ctx, "%s fork of '%s' is longer than %llu bytes", which, out_name(out),
+                         (unsigned long long)want);
+        }
+        sink_begin(out);
+        if (s->sink->write && s->sink->write(s->sink->ctx, fork, s->chunk, (size_t)got)) {
+            decode_abort(&s->ctx, "output rejected '%s'", out_name(out));
+        }
+        done += (uint64_t)got;
+    }
+    if (want != PEEL_SIZE_UNKNOWN && done != want) {
+        decode_abort(&s->ctx, "%s fork of '%s' ends after %llu of %llu bytes", which, out_name(out),
+                     (unsigned long long)done, (unsigned long long)want);
+    }
 }
 
-// ============================================================================
-// Operations (Public API) — Main Entry Points
-// ============================================================================
-
-// Forward declaration for recursive peeling.
-static peel_file_list_t peel_depth(const uint8_t *src, size_t len, int depth, peel_err_t **err);
-
-// Recursively peel extracted files whose data forks contain recognized
-// formats.  This handles archives-inside-archives (e.g. .sit containing
-// a .sit.hqx file).
-// architecture.md § "Recursive Peeling"
-static peel_file_list_t recursive_peel_files(peel_file_list_t list, int depth, peel_err_t **err) {
-    if (list.count == 0) {
-        return list;
-    }
-
-    // Collect results in a new list.  Most files will pass through unchanged,
-    // but some may expand into multiple files.
-    int result_cap = list.count;
-    int result_count = 0;
-    peel_file_t *result = calloc((size_t)result_cap, sizeof(peel_file_t));
-    if (!result) {
-        *err = make_err("out of memory in recursive peel");
-        peel_file_list_free(&list);
-        return (peel_file_list_t){0};
+// True if a wrapper opens cleanly on the head of a data fork.  Checked before
+// a nested fork is committed to peeling: once its bytes are consumed there is
+// no falling back to delivering the fork as it is.
+static bool wrapper_opens(const peel_format_t *fmt, const uint8_t *head, size_t n, uint64_t size) {
+    decode_ctx_t *probe = calloc(1, sizeof(*probe));
+    if (!probe) {
+        return false;
     }
+    bool ok = setjmp(probe->jmp) == 0;
+    if (ok) {
+        peel_in_t *in = in_open_mem(probe, head, n);
+        peel_reader_t payload;
+        in->size = size; // Length checks see the whole fork, not the window
+        fmt->open(in, &payload);
+    }
+    ctx_free_all(probe);
+    free(probe);
+    return ok;
+}
 
-    for (int i = 0; i < list.count; i++) {
-        peel_file_t *f = &list.files[i];
+// Deliver an input no format claimed as one unnamed file.
+static void emit_whole(peel_out_t *out, peel_in_t *in) {
+    peel_file_meta_t meta = {0};
+    peel_reader_t rd = in_reader(in);
+    out_begin(out, &meta, in->size, 0);
+    pump_fork(out, PEEL_DATA_FORK, &rd);
+    out_end(out);
+}
 
-        // Check if this file's data fork is itself a recognized wrapper or
-        // archive format.  Only peel further through WRAPPER formats to
-        // avoid false positives on large binary files (e.g. disk images)
-        // that may incidentally contain archive signatures.
-        const peel_format_t *fmt = NULL;
-        if (f->data_fork.data && f->data_fork.size > 0) {
-            fmt = detect_format(f->data_fork.data, f->data_fork.size);
-            if (fmt && fmt->kind != PEEL_FMT_WRAPPER) {
-                fmt = NULL; // Only recurse through wrappers
+// Strip wrapper layers until an archive turns up and extract it; whatever no
+// format claims becomes one unnamed file.  Everything the layers allocate is
+// released on the way out, so nested archives do not accumulate state.
+// architecture.md § "peel Implementation Sketch"
+static void peel_layers(peel_session_t *s, peel_in_t *in, int depth) {
+    peel_out_t out = {.s = s, .depth = depth, .nested = true};
+    void *mark = ctx_mark(&s->ctx);
+
+    if (depth < MAX_PEEL_DEPTH) {
+        for (int wrap_depth = 0; wrap_depth < MAX_PEEL_DEPTH; wrap_depth++) {
+            // Memory inputs detect over the whole buffer, streams over the window
+            const uint8_t *head;
+            size_t n = in_peek(in, SIZE_MAX, &head);
+            const peel_format_t *fmt = detect_format(head, n);
+            if (!fmt) {
+                break;
             }
-        }
-        if (!fmt) {
-            // Not a recognized format — keep as-is
-            // Grow result if needed
-            if (result_count >= result_cap) {
-                result_cap = result_cap * 2;
-                peel_file_t *tmp = realloc(result, (size_t)result_cap * sizeof(peel_file_t));
-                if (!tmp) {
-                    *err = make_err("out of memory growing recursive peel list");
-                    goto fail;
-                }
-                result = tmp;
+            if (fmt->kind == PEEL_FMT_ARCHIVE) {
+                fmt->extract(in, &out);
+                ctx_release(&s->ctx, mark);
+                return;
             }
-            result[result_count++] = *f;
-            // Clear the source so peel_file_list_free won't double-free
-            memset(f, 0, sizeof(*f));
-            continue;
+            // Chain the next layer onto this wrapper's payload
+            peel_reader_t payload;
+            uint64_t size = fmt->open(in, &payload);
+            in = in_open(&s->ctx, &payload, size);
         }
+    }
+    emit_whole(&out, in);
+    ctx_release(&s->ctx, mark);
+}
 
-        // Recursively peel this file's data fork
-        peel_err_t *sub_err = NULL;
-        peel_file_list_t sub = peel_depth(f->data_fork.data, f->data_fork.size, depth + 1, &sub_err);
-        if (sub_err) {
-            // Recursive peel failed — keep the original file as-is
-            peel_err_free(sub_err);
-            if (result_count >= result_cap) {
-                result_cap = result_cap * 2;
-                peel_file_t *tmp = realloc(result, (size_t)result_cap * sizeof(peel_file_t));
-                if (!tmp) {
-                    *err = make_err("out of memory growing recursive peel list");
-                    goto fail;
-                }
-                result = tmp;
-            }
-            result[result_count++] = *f;
-            memset(f, 0, sizeof(*f));
-            continue;
-        }
+// Run one session and return the number of files delivered, or -1.
+static int run_session(const peel_run_t *run, peel_err_t **err) {
+    peel_session_t *s = calloc(1, sizeof(*s));
+    if (!s) {
+        *err = make_err("out of memory starting session");
+        return -1;
+    }
+    s->sink = run->sink;
+    if (run->ctx_slot) {
+        *run->ctx_slot = &s->ctx;
+    }
 
-        // Replace this file with the sub-results
-        int need = result_count + sub.count;
-        if (need > result_cap) {
-            result_cap = need * 2;
-            peel_file_t *tmp = realloc(result, (size_t)result_cap * sizeof(peel_file_t));
-            if (!tmp) {
-                *err = make_err("out of memory growing recursive peel list");
-                peel_file_list_free(&sub);
-                goto fail;
-            }
-            result = tmp;
+    int files = -1;
+    if (setjmp(s->ctx.jmp) == 0) {
+        s->chunk = ctx_alloc(&s->ctx, PEEL_CHUNK);
+        peel_in_t *in = run->rd ? in_open(&s->ctx, run->rd, run->size) : in_open_mem(&s->ctx, run->src, run->len);
+        if (run->extract) {
+            peel_out_t out = {.s = s};
+            run->extract(in, &out);
+        } else if (run->open) {
+            peel_out_t out = {.s = s};
+            peel_file_meta_t meta = {0};
+            peel_reader_t payload;
+            uint64_t payload_len = run->open(in, &payload);
+            out_begin(&out, &meta, payload_len, 0);
+            pump_fork(&out, PEEL_DATA_FORK, &payload);
+            out_end(&out);
+        } else {
+            peel_layers(s, in, 0);
         }
-        for (int j = 0; j < sub.count; j++) {
-            result[result_count++] = sub.files[j];
+        files = s->files;
+    } else {
+        *err = make_err("%s", s->ctx.errmsg);
+    }
+    ctx_free_all(&s->ctx);
+    free(s);
+    return files;
+}
+
+// Collector begin(): start a new file entry.
+static int collect_begin(void *ctx, const peel_file_meta_t *meta, uint64_t data_len, uint64_t rsrc_len) {
+    collector_t *c = ctx;
+    if (c->count == c->cap) {
+        int cap = c->cap ? c->cap * 2 : 8;
+        peel_file_t *tmp = realloc(c->files, (size_t)cap * sizeof(peel_file_t));
+        if (!tmp) {
+            return -1;
         }
-        // Free the sub-list array (but not the individual file buffers,
-        // which have been moved into result)
-        free(sub.files);
+        c->files = tmp;
+        c->cap = cap;
+    }
+    memset(&c->files[c->count], 0, sizeof(peel_file_t));
+    c->files[c->count].meta = *meta;
+    c->count++;
+    c->len[PEEL_DATA_FORK] = data_len;
+    c->len[PEEL_RESOURCE_FORK] = rsrc_len;
+    return 0;
+}
 
-        // Free the original file's buffers (replaced by sub-results)
-        peel_free(&f->data_fork);
-        peel_free(&f->resource_fork);
+// Collector write(): append to the current file's fork.
+static int collect_write(void *ctx, peel_fork_t fork, const uint8_t *buf, size_t len) {
+    collector_t *c = ctx;
+    grow_buf_t *g = &c->fork[fork];
+    if (!g->data) {
+        // Known lengths size the buffer exactly
+        uint64_t hint = c->len[fork];
+        grow_init(g, hint == PEEL_SIZE_UNKNOWN || hint > SIZE_MAX / 2 ? 0 : (size_t)hint, c->ctx);
     }
+    grow_append(g, buf, len, c->ctx);
+    return 0;
+}
 
-    // Free the original list's file array (individual entries already freed/moved)
-    free(list.files);
-    return (peel_file_list_t){.files = result, .count = result_count};
+// Collector end(): hand the gathered forks to the current file.
+static int collect_end(void *ctx) {
+    collector_t *c = ctx;
+    peel_file_t *f = &c->files[c->count - 1];
+    f->data_fork = c->fork[PEEL_DATA_FORK].len ? grow_finish(&c->fork[PEEL_DATA_FORK]) : (peel_buf_t){0};
+    f->resource_fork =
+        c->fork[PEEL_RESOURCE_FORK].len ? grow_finish(&c->fork[PEEL_RESOURCE_FORK]) : (peel_buf_t){0};
+    grow_free(&c->fork[PEEL_DATA_FORK]);
+    grow_free(&c->fork[PEEL_RESOURCE_FORK]);
+    return 0;
+}
 
-fail:
-    // Clean up partial results and original list
-    for (int j = 0; j < result_count; j++) {
-        peel_free(&result[j].data_fork);
-        peel_free(&result[j].resource_fork);
+// Run a session into a collector and return what it gathered (nothing, with
+// every partial buffer released, on error).
+static peel_file_list_t collect(peel_run_t *run, peel_err_t **err) {
+    collector_t c = {0};
+    peel_sink_t sink = {.begin = collect_begin, .write = collect_write, .end = collect_end, .ctx = &c};
+    run->sink = &sink;
+    run->ctx_slot = &c.ctx;
+
+    int files = run_session(run, err);
+    grow_free(&c.fork[PEEL_DATA_FORK]);
+    grow_free(&c.fork[PEEL_RESOURCE_FORK]);
+    peel_file_list_t list = {.files = c.files, .count = c.count};
+    if (files < 0) {
+        peel_file_list_free(&list);
+        return (peel_file_list_t){0};
     }
-    free(result);
-    peel_file_list_free(&list);
-    return (peel_file_list_t){0};
+    return list;
 }
 
-// Detect all layers, peel wrappers, then extract the archive.
-// architecture.md § "peel Implementation Sketch"
-peel_file_list_t peel(const uint8_t *src, size_t len, peel_err_t **err) {
-    return peel_depth(src, len, 0, err);
+// ============================================================================
+// Operations — Output Stage
+// ============================================================================
+
+// Start a file.
+void out_begin(peel_out_t *out, const peel_file_meta_t *meta, uint64_t data_len, uint64_t rsrc_len) {
+    out->meta = *meta;
+    out->len[PEEL_DATA_FORK] = data_len;
+    out->len[PEEL_RESOURCE_FORK] = rsrc_len;
+    out->begun = false;
+    out->replaced = false;
 }
 
-// Internal implementation with depth tracking for recursion limiting.
-static peel_file_list_t peel_depth(const uint8_t *src, size_t len, int depth, peel_err_t **err) {
-    *err = NULL;
+// Deliver one fork of the current file.  A data fork that is itself wrapped
+// (a .sit.hqx inside a .sit) is peeled in place of its file; files that also
+// carry a resource fork are kept whole.
+// architecture.md § "Recursive Peeling"
+void out_fork(peel_out_t *out, peel_fork_t fork, const peel_reader_t *rd) {
+    peel_session_t *s = out->s;
+    uint64_t len = out->len[PEEL_DATA_FORK];
+    if (fork != PEEL_DATA_FORK || !out->nested || out->len[PEEL_RESOURCE_FORK] != 0 || len == 0 ||
+        len == PEEL_SIZE_UNKNOWN || out->depth + 1 >= MAX_PEEL_DEPTH) {
+        pump_fork(out, fork, rd);
+        return;
+    }
 
-    if (depth >= MAX_PEEL_DEPTH) {
-        // Recursion limit reached — return data as a single unnamed file
-        return wrap_single_file(src, len, NULL, err);
+    // Only peel further through wrappers, to avoid false positives on large
+    // binary files (e.g. disk images) that incidentally contain signatures
+    peel_in_t *in = in_open(&s->ctx, rd, len);
+    const uint8_t *head;
+    size_t n = in_peek(in, PEEL_WINDOW, &head);
+    const peel_format_t *fmt = detect_format(head, n);
+    if (fmt && fmt->kind == PEEL_FMT_WRAPPER && wrapper_opens(fmt, head, n, len)) {
+        out->replaced = true;
+        peel_layers(s, in, out->depth + 1);
+        in_seek(in, len); // Drain the rest so the fork's own checks run
+    } else {
+        peel_reader_t whole = in_reader(in);
+        pump_fork(out, fork, &whole);
     }
+    in_close(in);
+}
 
-    // `owned` holds the most recent intermediate buffer (heap-allocated by a
-    // wrapper peeler).  NULL while we are still working from the caller's
-    // original input pointer.
-    uint8_t *owned = NULL;
-    const uint8_t *cur = src;
-    size_t cur_len = len;
+// Finish the current file.
+void out_end(peel_out_t *out) {
+    peel_session_t *s = out->s;
+    if (out->replaced) {
+        return;
+    }
+    sink_begin(out);
+    if (s->sink->end && s->sink->end(s->sink->ctx)) {
+        decode_abort(&s->ctx, "output rejected '%s'", out_name(out));
+    }
+    s->files++;
+}
 
-    // Repeatedly strip wrapper layers until an archive or unknown data is found.
-    for (int wrap_depth = 0; wrap_depth < MAX_PEEL_DEPTH; wrap_depth++) {
-        const peel_format_t *fmt = detect_format(cur, cur_len);
-        if (!fmt) {
-            break; // Nothing recognised — fall through to single-file wrap
-        }
+// ============================================================================
+// Operations — Buffer Entry Points over the Streaming Core
+// ============================================================================
 
-        if (fmt->kind == PEEL_FMT_WRAPPER) {
-            // Peel one wrapper layer and replace the working buffer
-            peel_buf_t decoded = fmt->peel_wrapper(cur, cur_len, err);
-            if (*err) {
-                free(owned);
-                return (peel_file_list_t){0};
-            }
-            free(owned); // Release previous intermediate (NULL-safe)
-            owned = decoded.data;
-            cur = owned;
-            cur_len = decoded.size;
-            continue;
-        }
+// Run extract over a memory buffer and collect its files.
+peel_file_list_t collect_files(const uint8_t *src, size_t len, peel_extract_fn extract, peel_err_t **err) {
+    *err = NULL;
+    return collect(&(peel_run_t){.src = src, .len = len, .extract = extract}, err);
+}
 
-        if (fmt->kind == PEEL_FMT_ARCHIVE) {
-            // Terminal format — extract files and return
-            peel_file_list_t result = fmt->peel_archive(cur, cur_len, err);
-            free(owned);
-            if (*err) {
-                return (peel_file_list_t){0};
-            }
-            // Recursively peel extracted files that contain nested archives
-            return recursive_peel_files(result, depth, err);
-        }
+// Run a wrapper's open over a memory buffer and collect its payload.
+peel_buf_t collect_payload(const uint8_t *src, size_t len, peel_open_fn open, peel_err_t **err) {
+    *err = NULL;
+    peel_file_list_t list = collect(&(peel_run_t){.src = src, .len = len, .open = open}, err);
+    if (*err) {
+        return (peel_buf_t){0};
     }
+    peel_buf_t payload = list.files[0].data_fork;
+    list.files[0].data_fork = (peel_buf_t){0};
+    peel_file_list_free(&list);
+    return payload;
+}
 
-    // No archive found.  Wrap whatever we have as a single unnamed file.
-    // Transfer ownership of `owned` if we peeled any wrappers.
-    peel_file_list_t result = wrap_single_file(cur, cur_len, owned, err);
-    if (*err) {
-        // wrap_single_file failed; it did NOT take ownership on failure
-        free(owned);
-        return (peel_file_list_t){0};
+// ============================================================================
+// Operations (Public API) — Format Detection
+// ============================================================================
+
+// Identify the outermost format without peeling.
+const char *peel_detect(const uint8_t *src, size_t len) {
+    const peel_format_t *fmt = detect_format(src, len);
+    return fmt ? fmt->name : NULL;
+}
+
+// Identify the outermost format of a file from its leading window.
+const char *peel_detect_path(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return NULL;
     }
-    // `owned` pointer is now inside the result — do not free it
-    return result;
+    uint8_t *head = malloc(PEEL_WINDOW);
+    if (!head) {
+        fclose(fp);
+        return NULL;
+    }
+    size_t n = fread(head, 1, PEEL_WINDOW, fp);
+    fclose(fp);
+    const char *name = peel_detect(head, n);
+    free(head);
+    return name;
 }
 
-// Read a file from disk, then peel() its contents.
-peel_file_list_t peel_path(const char *path, peel_err_t **err) {
+// ============================================================================
+// Operations (Public API) — Main Entry Points
+// ============================================================================
+
+// Detect all layers, peel wrappers, then extract the archive.
+peel_file_list_t peel(const uint8_t *src, size_t len, peel_err_t **err) {
     *err = NULL;
+    return collect(&(peel_run_t){.src = src, .len = len}, err);
+}
 
-    // Slurp the entire file into memory
-    peel_buf_t file_buf = peel_read_file(path, err);
-    if (*err) {
+// Stream a file from disk through the layers, collecting the results.
+peel_file_list_t peel_path(const char *path, peel_err_t **err) {
+    *err = NULL;
+    peel_reader_t rd;
+    uint64_t size;
+    if (!file_reader_open(path, &rd, &size, err)) {
         return (peel_file_list_t){0};
     }
+    peel_file_list_t result = collect(&(peel_run_t){.rd = &rd, .size = size}, err);
+    file_reader_close(&rd);
+    return result;
+}
 
-    // Run the main peeling loop
-    peel_file_list_t result = peel(file_buf.data, file_buf.size, err);
+// Detect and peel all layers of a stream, delivering files to a sink.
+int peel_stream(const peel_reader_t *in, const peel_sink_t *out, peel_err_t **err) {
+    *err = NULL;
+    if (!in || !in->read || !out) {
+        *err = make_err("peel_stream: missing reader or sink");
+        return -1;
+    }
+    return run_session(&(peel_run_t){.rd = in, .size = PEEL_SIZE_UNKNOWN, .sink = out}, err);
+}
 
-    // Release the input buffer regardless of success
-    peel_free(&file_buf);
-    return result;
+// Stream the file at path to a sink.
+int peel_stream_path(const char *path, const peel_sink_t *out, peel_err_t **err) {
+    *err = NULL;
+    if (!out) {
+        *err = make_err("peel_stream_path: missing sink");
+        return -1;
+    }
+    peel_reader_t rd;
+    uint64_t size;
+    if (!file_reader_open(path, &rd, &size, err)) {
+        return -1;
+    }
+    int files = run_session(&(peel_run_t){.rd = &rd, .size = size, .sink = out}, err);
+    file_reader_close(&rd);
+    return files;
 }
 
 // ============================================================================
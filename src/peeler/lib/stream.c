@@ -0,0 +1,272 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) pappadf
+
+// stream.c
+// Streaming input: the bounded window every format layer reads through,
+// byte spans over it, and the file-backed reader behind peel_stream_path().
+
+// Ensure fseeko/ftello are declared under strict C99 mode.
+#define _POSIX_C_SOURCE 200809L
+
+#include "internal.h"
+
+#include <errno.h>
+#include <sys/types.h>
+
+// ============================================================================
+// Static Helpers
+// ============================================================================
+
+// Read more of the upstream into the window until at least want bytes are
+// unread (or the window is full, or the input ends).  Unread bytes slide to
+// the front first, so the window never holds more than PEEL_WINDOW.
+static void in_fill(peel_in_t *in, size_t want) {
+    if (want > in->cap) {
+        want = in->cap;
+    }
+    if (in->len - in->pos >= want || in->eof) {
+        return;
+    }
+    if (in->pos > 0) {
+        memmove(in->buf, in->buf + in->pos, in->len - in->pos);
+        in->base += in->pos;
+        in->len -= in->pos;
+        in->pos = 0;
+    }
+    while (in->len < want && !in->eof) {
+        ptrdiff_t n = in->rd.read(in->rd.ctx, in->buf + in->len, in->cap - in->len);
+        if (n < 0) {
+            decode_abort(in->ctx, "read error at offset %llu", (unsigned long long)(in->base + in->len));
+        }
+        if (n == 0) {
+            in->eof = true;
+            break;
+        }
+        in->len += (size_t)n;
+    }
+}
+
+// ============================================================================
+// Operations — Windowed Input
+// ============================================================================
+
+// Open a windowed input over an upstream reader.
+peel_in_t *in_open(decode_ctx_t *ctx, const peel_reader_t *rd, uint64_t size) {
+    peel_in_t *in = ctx_alloc(ctx, sizeof(*in));
+    in->rd = *rd;
+    in->ctx = ctx;
+    in->cap = PEEL_WINDOW;
+    in->buf = ctx_alloc(ctx, in->cap);
+    in->size = size;
+    return in;
+}
+
+// Open an input that borrows a caller-owned buffer.
+peel_in_t *in_open_mem(decode_ctx_t *ctx, const uint8_t *src, size_t len) {
+    peel_in_t *in = ctx_alloc(ctx, sizeof(*in));
+    in->ctx = ctx;
+    in->buf = (uint8_t *)(uintptr_t)src; // Never written through
+    in->cap = len;
+    in->len = len;
+    in->size = len;
+    in->eof = true;
+    in->borrowed = true;
+    return in;
+}
+
+// Release an input's window and the input itself.
+void in_close(peel_in_t *in) {
+    if (!in) {
+        return;
+    }
+    if (!in->borrowed) {
+        ctx_free(in->ctx, in->buf);
+    }
+    ctx_free(in->ctx, in);
+}
+
+// Make up to want bytes readable without consuming them.
+size_t in_peek(peel_in_t *in, size_t want, const uint8_t **out) {
+    in_fill(in, want);
+    size_t n = in->len - in->pos;
+    if (n > want) {
+        n = want;
+    }
+    *out = in->buf + in->pos;
+    return n;
+}
+
+// Consume up to n bytes into dst.  Large reads on an empty window go
+// straight to the upstream instead of through the window.
+size_t in_read(peel_in_t *in, uint8_t *dst, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        if (in->pos == in->len) {
+            if (in->eof) {
+                break;
+            }
+            if (n - got >= in->cap) {
+                in->base += in->len;
+                in->pos = in->len = 0;
+                ptrdiff_t r = in->rd.read(in->rd.ctx, dst + got, n - got);
+                if (r < 0) {
+                    decode_abort(in->ctx, "read error at offset %llu", (unsigned long long)in->base);
+                }
+                if (r == 0) {
+                    in->eof = true;
+                    break;
+                }
+                in->base += (uint64_t)r;
+                got += (size_t)r;
+                continue;
+            }
+            in_fill(in, 1);
+            if (in->pos == in->len) {
+                break;
+            }
+        }
+        size_t k = in->len - in->pos;
+        if (k > n - got) {
+            k = n - got;
+        }
+        memcpy(dst + got, in->buf + in->pos, k);
+        in->pos += k;
+        got += k;
+    }
+    return got;
+}
+
+// Refill the window for in_getc().
+int in_getc_refill(peel_in_t *in) {
+    in_fill(in, 1);
+    if (in->pos < in->len) {
+        return in->buf[in->pos++];
+    }
+    return -1;
+}
+
+// True if the input can move backwards.
+bool in_seekable(const peel_in_t *in) {
+    return in->borrowed || in->rd.seek != NULL;
+}
+
+// Move to an absolute input offset.
+void in_seek(peel_in_t *in, uint64_t off) {
+    // Inside the window (always, for memory inputs): just move the cursor
+    if (off >= in->base && off - in->base <= in->len) {
+        in->pos = (size_t)(off - in->base);
+        return;
+    }
+    if (in->borrowed) {
+        in->pos = in->len; // Past the end: reads return nothing
+        return;
+    }
+    if (in->rd.seek) {
+        if (in->rd.seek(in->rd.ctx, off) != 0) {
+            decode_abort(in->ctx, "cannot seek to offset %llu", (unsigned long long)off);
+        }
+        in->base = off;
+        in->pos = in->len = 0;
+        in->eof = false;
+        return;
+    }
+    if (off < in->base) {
+        decode_abort(in->ctx, "input cannot seek backwards (to offset %llu)", (unsigned long long)off);
+    }
+    // Forward-only: read and drop everything up to off
+    while (in->base + in->len < off && !in->eof) {
+        in->base += in->len;
+        in->pos = in->len = 0;
+        in_fill(in, in->cap);
+    }
+    uint64_t rel = off - in->base;
+    in->pos = rel < in->len ? (size_t)rel : in->len;
+}
+
+// ============================================================================
+// Operations — Spans and Adapters
+// ============================================================================
+
+// Consume up to n bytes of a span.
+size_t span_read(peel_span_t *s, uint8_t *dst, size_t n) {
+    if (n > s->left) {
+        n = (size_t)s->left;
+    }
+    size_t got = in_read(s->in, dst, n);
+    s->left -= got;
+    return got;
+}
+
+// Reader callback over a windowed input.
+static ptrdiff_t in_reader_read(void *ctx, uint8_t *buf, size_t len) {
+    return (ptrdiff_t)in_read((peel_in_t *)ctx, buf, len);
+}
+
+// Seek callback over a windowed input.
+static int in_reader_seek(void *ctx, uint64_t offset) {
+    in_seek((peel_in_t *)ctx, offset);
+    return 0;
+}
+
+// Wrap an input as a reader.
+peel_reader_t in_reader(peel_in_t *in) {
+    return (peel_reader_t){
+        .read = in_reader_read,
+        .seek = in_seekable(in) ? in_reader_seek : NULL,
+        .ctx = in,
+    };
+}
+
+// ============================================================================
+// Operations — File Reader
+// ============================================================================
+
+// Reader callback over a stdio stream.
+static ptrdiff_t file_read(void *ctx, uint8_t *buf, size_t len) {
+    FILE *fp = ctx;
+    if (len > PTRDIFF_MAX) {
+        len = PTRDIFF_MAX;
+    }
+    size_t n = fread(buf, 1, len, fp);
+    if (n == 0 && ferror(fp)) {
+        return -1;
+    }
+    return (ptrdiff_t)n;
+}
+
+// Seek callback over a stdio stream.
+static int file_seek(void *ctx, uint64_t offset) {
+    if (offset > (uint64_t)INT64_MAX) {
+        return -1;
+    }
+    return fseeko((FILE *)ctx, (off_t)offset, SEEK_SET) == 0 ? 0 : -1;
+}
+
+// Open a file for streaming and report its size.
+bool file_reader_open(const char *path, peel_reader_t *rd, uint64_t *size, peel_err_t **err) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        *err = make_err("cannot open '%s': %s", path, strerror(errno));
+        return false;
+    }
+    off_t end = -1;
+    if (fseeko(fp, 0, SEEK_END) == 0) {
+        end = ftello(fp);
+    }
+    if (end < 0 || fseeko(fp, 0, SEEK_SET) != 0) {
+        *err = make_err("cannot determine size of '%s': %s", path, strerror(errno));
+        fclose(fp);
+        return false;
+    }
+    *rd = (peel_reader_t){.read = file_read, .seek = file_seek, .ctx = fp};
+    *size = (uint64_t)end;
+    return true;
+}
+
+// Close a file reader.
+void file_reader_close(peel_reader_t *rd) {
+    if (rd->ctx) {
+        fclose((FILE *)rd->ctx);
+    }
+    memset(rd, 0, sizeof(*rd));
+}
@@ -2,7 +2,8 @@
 // Copyright (c) pappadf
 
 // util.c
-// Shared utility implementations: CRC routines and growable output buffers.
+// Shared utility implementations: CRC routines, context-owned allocations
+// and growable output buffers.
 
 #include "internal.h"
 
@@ -70,6 +71,123 @@ uint16_t crc16_ccitt(const uint8_t *data, size_t len) {
     return crc16_ccitt_update(0, data, len);
 }
 
+// ============================================================================
+// Context-Owned Allocations
+// ============================================================================
+
+// Header threading a ctx-owned block onto its context's list.  Padded so the
+// payload that follows keeps malloc's alignment.
+struct ctx_block {
+    ctx_block_t *prev;
+    ctx_block_t *next;
+    union {
+        long double ld;
+        uint64_t u64;
+        void *ptr;
+    } align;
+};
+
+// Payload pointer of a block, and back.
+#define CTX_PAYLOAD(b) ((void *)((b) + 1))
+#define CTX_BLOCK(p)   ((ctx_block_t *)(p) - 1)
+
+// Link a fresh block at the head of ctx's list.
+static void *ctx_link(decode_ctx_t *ctx, ctx_block_t *b) {
+    b->prev = NULL;
+    b->next = ctx->blocks;
+    if (ctx->blocks) {
+        ctx->blocks->prev = b;
+    }
+    ctx->blocks = b;
+    return CTX_PAYLOAD(b);
+}
+
+// Unlink a block from ctx's list.
+static void ctx_unlink(decode_ctx_t *ctx, ctx_block_t *b) {
+    if (b->prev) {
+        b->prev->next = b->next;
+    } else {
+        ctx->blocks = b->next;
+    }
+    if (b->next) {
+        b->next->prev = b->prev;
+    }
+}
+
+// Allocate a zeroed block owned by ctx.
+void *ctx_alloc(decode_ctx_t *ctx, size_t size) {
+    ctx_block_t *b = NULL;
+    if (size <= SIZE_MAX - sizeof(*b)) {
+        b = calloc(1, sizeof(*b) + size);
+    }
+    if (!b) {
+        decode_abort(ctx, "out of memory (%zu bytes)", size);
+    }
+    return ctx_link(ctx, b);
+}
+
+// Resize a ctx-owned block, keeping its place in ctx's list (see ctx_mark).
+void *ctx_realloc(decode_ctx_t *ctx, void *p, size_t size) {
+    if (!p) {
+        return ctx_alloc(ctx, size);
+    }
+    ctx_block_t *b = CTX_BLOCK(p);
+    ctx_block_t *nb = NULL;
+    if (size <= SIZE_MAX - sizeof(*b)) {
+        nb = realloc(b, sizeof(*b) + size);
+    }
+    if (!nb) {
+        decode_abort(ctx, "out of memory (%zu bytes)", size);
+    }
+    if (nb->prev) {
+        nb->prev->next = nb;
+    } else {
+        ctx->blocks = nb;
+    }
+    if (nb->next) {
+        nb->next->prev = nb;
+    }
+    return CTX_PAYLOAD(nb);
+}
+
+// Release one ctx-owned block.
+void ctx_free(decode_ctx_t *ctx, void *p) {
+    if (!p) {
+        return;
+    }
+    ctx_block_t *b = CTX_BLOCK(p);
+    ctx_unlink(ctx, b);
+    free(b);
+}
+
+// Place a marker block: blocks allocated after it sit above it in the list.
+void *ctx_mark(decode_ctx_t *ctx) {
+    return ctx_alloc(ctx, 0);
+}
+
+// Release the marker and every block allocated after it.
+void ctx_release(decode_ctx_t *ctx, void *mark) {
+    ctx_block_t *stop = CTX_BLOCK(mark);
+    while (ctx->blocks && ctx->blocks != stop) {
+        ctx_block_t *b = ctx->blocks;
+        ctx->blocks = b->next;
+        free(b);
+    }
+    if (ctx->blocks) {
+        ctx->blocks->prev = NULL;
+    }
+    ctx_free(ctx, mark);
+}
+
+// Release every block still owned by ctx.
+void ctx_free_all(decode_ctx_t *ctx) {
+    while (ctx->blocks) {
+        ctx_block_t *b = ctx->blocks;
+        ctx->blocks = b->next;
+        free(b);
+    }
+}
+
 // ============================================================================
 // Growable Buffer
 // ============================================================================
@@ -25,6 +25,7 @@
 #   --output-dir <dir>   Temp directory for outputs (default: /tmp/peeler_test)
 #   --verbose            Print peeler output on failure
 #   --keep-files         Keep extracted files after testing
+#   --stdin              Pipe each input to `peeler -` (forward-only stream)
 #   <name>               Run a single named test case
 
 set -uo pipefail
@@ -44,6 +45,7 @@ declare -a TEST_DIRS=()
 OUTPUT_DIR="/tmp/peeler_test"
 VERBOSE=false
 KEEP_FILES=false
+STDIN=false
 SINGLE_TEST=""
 
 # ============================================================================
@@ -73,6 +75,7 @@ Options:
     --output-dir <dir>   Temp directory for outputs (default: /tmp/peeler_test)
     --verbose            Print peeler output on failure
     --keep-files         Keep extracted files after testing
+    --stdin              Pipe each input to \`peeler -\` (forward-only stream)
     <test-name>          Run only the named test case
 EOF
 }
@@ -84,6 +87,7 @@ while [[ $# -gt 0 ]]; do
         --output-dir) OUTPUT_DIR="$2"; shift 2 ;;
         --verbose)   VERBOSE=true;    shift ;;
         --keep-files) KEEP_FILES=true; shift ;;
+        --stdin)     STDIN=true;      shift ;;
         --help)      usage; exit 0 ;;
         --*)         echo "Unknown option: $1"; usage; exit 1 ;;
         *)
@@ -199,6 +203,10 @@ if [[ ${#test_cases[@]} -eq 0 ]]; then
     continue
 fi
 
+if $STDIN; then
+    suite_label="$suite_label, stdin"
+fi
+
 echo "[$suite_label] Running ${#test_cases[@]} test(s)..."
 
 # ============================================================================
@@ -238,7 +246,12 @@ for name in "${test_cases[@]}"; do
     mkdir -p "$test_out"
 
     # Run peeler
-    if ! output=$("$PEELER" "$input_file" "$test_out" 2>&1); then
+    if $STDIN; then
+        output=$("$PEELER" - "$test_out" <"$input_file" 2>&1)
+    else
+        output=$("$PEELER" "$input_file" "$test_out" 2>&1)
+    fi
+    if [[ $? -ne 0 ]]; then
         echo -e "${RED}  FAIL: $name — peeler exited with error${NC}"
         if $VERBOSE; then
             echo "$output"
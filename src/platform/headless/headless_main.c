@@ -151,6 +151,7 @@ static void print_usage(const char *program) {
     printf("                  aliases realtime/hardware map to paced, max to turbo). Headless\n");
     printf("                  runs are budget-driven; only 'accelerated' changes execution\n");
     printf("                  (more instructions per frame-unit, scheduler.speed multiplier).\n");
+    printf("  --idle=MODE     Idle-loop fast-forward: off (default), on, verify\n");
     printf("  --cycles=N      Run for N CPU cycles then exit (for testing)\n");
     printf("  --quiet, -q     Suppress startup messages\n");
     printf("  --daemon        Start in daemon mode (TCP socket interface for AI agents)\n");
@@ -709,6 +710,7 @@ int main(int argc, char *argv[]) {
     const char *fd_explicit[2] = {NULL}; // fd0= and fd1= explicit drive assignments
     const char *script_file = NULL;
     const char *speed_mode = "paced";
+    const char *idle_mode = NULL;
     uint64_t max_cycles = 0;
     uint32_t ram_kb = 0;
     const char *model_override = NULL;
@@ -771,6 +773,15 @@ int main(int argc, char *argv[]) {
             continue;
         }
 
+        if (strncmp(arg, "--idle=", 7) == 0) {
+            idle_mode = arg + 7;
+            if (strcmp(idle_mode, "off") != 0 && strcmp(idle_mode, "on") != 0 && strcmp(idle_mode, "verify") != 0) {
+                fprintf(stderr, "Error: Invalid idle mode: %s (valid: off, on, verify)\n", idle_mode);
+                return 1;
+            }
+            continue;
+        }
+
         if (strncmp(arg, "--cycles=", 9) == 0) {
             max_cycles = strtoull(arg + 9, NULL, 10);
             continue;
@@ -1090,6 +1101,10 @@ int main(int argc, char *argv[]) {
                    strcmp(speed_mode, "hw") == 0) {
             scheduler_set_mode(sched, schedule_paced);
         }
+        if (idle_mode)
+            scheduler_set_idle_mode(sched, strcmp(idle_mode, "on") == 0       ? idle_on
+                                           : strcmp(idle_mode, "verify") == 0 ? idle_verify
+                                                                              : idle_off);
     }
 
     // Run startup script if provided
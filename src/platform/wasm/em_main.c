@@ -627,7 +627,7 @@ static void setup_pointer_lock(void) {
 #define CHECKPOINT_INTERVAL  900 // Background checkpoint every 900 ticks (~15 seconds at 60 ticks/sec)
 
 // Forward declaration
-static int save_quick_checkpoint(const char *reason, bool verbose, bool rate_limit);
+static int save_quick_checkpoint(const char *reason, bool verbose, bool rate_limit, bool async);
 
 // Global state variables
 static int tick_counter = 0;
@@ -763,7 +763,7 @@ void em_main_tick(void) {
             checkpoint_tick_counter++;
             if (checkpoint_tick_counter >= CHECKPOINT_INTERVAL) {
                 checkpoint_tick_counter = 0;
-                save_quick_checkpoint("tick-auto", false, true);
+                save_quick_checkpoint("tick-auto", false, true, true);
             }
         }
 
@@ -1062,8 +1062,36 @@ const char *find_valid_checkpoint_path(void) {
     return path_buf;
 }
 
+// One quick checkpoint save: a fresh base is written to tmp_path and renamed
+// over final_path once complete; a delta is appended to final_path in place
+typedef struct {
+    char final_path[BACKGROUND_CHECKPOINT_PATH_MAX];
+    char tmp_path[BACKGROUND_CHECKPOINT_PATH_MAX];
+    bool append;
+    bool verbose;
+    double start_ms;
+} quick_save_job_t;
+
+// Finish a quick checkpoint save (on the checkpoint writer thread for an
+// asynchronous save): publish a base under its final name, or drop the tmp
+static bool quick_save_done(bool ok, void *ctx) {
+    quick_save_job_t *job = (quick_save_job_t *)ctx;
+    if (!job->append && ok && checkpoint_quick_rename(job->tmp_path, job->final_path) != 0) {
+        printf("[checkpoint] rename %s -> %s failed: %s\n", job->tmp_path, job->final_path, strerror(errno));
+        ok = false;
+    }
+    if (!job->append && !ok)
+        unlink(job->tmp_path);
+    if (ok && job->verbose)
+        printf("Checkpoint saved to %s (%.2f ms)\n", job->final_path, emscripten_get_now() - job->start_ms);
+    free(job);
+    return ok;
+}
+
 // Save a quick checkpoint via tmp+rename inside the per-machine directory.
-static int save_quick_checkpoint(const char *reason, bool verbose, bool rate_limit) {
+// An async save returns once the machine is captured; the checkpoint writer
+// thread writes, syncs and renames the file while the guest runs on.
+static int save_quick_checkpoint(const char *reason, bool verbose, bool rate_limit, bool async) {
     scheduler_t *sched = system_scheduler();
     if (!sched)
         return GS_ERROR;
@@ -1087,13 +1115,23 @@ static int save_quick_checkpoint(const char *reason, bool verbose, bool rate_lim
             return GS_SUCCESS;
     }
 
-    char final_path[BACKGROUND_CHECKPOINT_PATH_MAX];
-    char tmp_path[BACKGROUND_CHECKPOINT_PATH_MAX];
-    if (build_state_checkpoint_path(final_path, sizeof(final_path)) != GS_SUCCESS)
+    // A periodic save never queues up behind one still being written
+    if (rate_limit && async && checkpoint_save_state() == CHECKPOINT_SAVE_PENDING)
+        return GS_SUCCESS;
+
+    quick_save_job_t *job = (quick_save_job_t *)malloc(sizeof(*job));
+    if (!job)
+        return GS_ERROR;
+    if (build_state_checkpoint_path(job->final_path, sizeof(job->final_path)) != GS_SUCCESS) {
+        free(job);
         return GS_ERROR;
-    int wn = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", final_path);
-    if (wn <= 0 || (size_t)wn >= sizeof(tmp_path))
+    }
+    int wn = snprintf(job->tmp_path, sizeof(job->tmp_path), "%s.tmp", job->final_path);
+    if (wn <= 0 || (size_t)wn >= sizeof(job->tmp_path)) {
+        free(job);
         return GS_ERROR;
+    }
+    job->verbose = verbose;
 
     // Record running state before stopping - this will be saved in the checkpoint
     bool was_running = scheduler_is_running(sched);
@@ -1104,27 +1142,26 @@ static int save_quick_checkpoint(const char *reason, bool verbose, bool rate_lim
     if (was_running && sched)
         scheduler_set_running(sched, true);
 
-    double checkpoint_start_time = emscripten_get_now();
-
-    // Drop any stale tmp from a crashed prior run.
-    unlink(tmp_path);
-    int rc = system_checkpoint(tmp_path, CHECKPOINT_KIND_QUICK);
-    if (rc == GS_SUCCESS) {
-        if (rename(tmp_path, final_path) != 0) {
-            printf("[checkpoint] rename %s -> %s failed: %s\n", tmp_path, final_path, strerror(errno));
-            unlink(tmp_path);
-            rc = GS_ERROR;
-        }
-    } else {
-        unlink(tmp_path);
-    }
-
-    double checkpoint_elapsed_ms = emscripten_get_now() - checkpoint_start_time;
+    job->start_ms = emscripten_get_now();
+
+    // Drop any stale tmp from a crashed prior run (once the previous save,
+    // which may still own it, has finished).
+    checkpoint_async_wait();
+    unlink(job->tmp_path);
+    // A delta record is appended to state.checkpoint in place (a torn append
+    // is ignored on load); a fresh base goes through tmp+rename.
+    job->append = checkpoint_quick_appends(job->final_path);
+    const char *target = job->append ? job->final_path : job->tmp_path;
+    // quick_save_done runs (and frees job) exactly once either way
+    int rc;
+    if (async)
+        rc = system_checkpoint_async(target, CHECKPOINT_KIND_QUICK, quick_save_done, job);
+    else
+        rc = quick_save_done(system_checkpoint(target, CHECKPOINT_KIND_QUICK) == GS_SUCCESS, job) ? GS_SUCCESS
+                                                                                                   : GS_ERROR;
 
     if (rc == GS_SUCCESS) {
         g_last_background_checkpoint_ms = now;
-        if (verbose)
-            printf("Checkpoint saved to %s (%.2f ms)\n", final_path, checkpoint_elapsed_ms);
     } else if (verbose) {
         printf("[checkpoint] quick checkpoint failed (%s)\n", reason ? reason : "background");
     }
@@ -1132,8 +1169,8 @@ static int save_quick_checkpoint(const char *reason, bool verbose, bool rate_lim
 }
 
 // Request background checkpoint (with rate limiting)
-static void maybe_request_background_checkpoint(const char *reason, bool rate_limit) {
-    int rc = save_quick_checkpoint(reason, false, rate_limit);
+static void maybe_request_background_checkpoint(const char *reason, bool rate_limit, bool async) {
+    int rc = save_quick_checkpoint(reason, false, rate_limit, async);
     if (rc != GS_SUCCESS) {
         printf("[checkpoint] background checkpoint failed (%s)\n", reason ? reason : "background");
     }
@@ -1145,7 +1182,7 @@ static EM_BOOL background_visibility_callback(int eventType, const EmscriptenVis
     (void)eventType;
     if (!event || !event->hidden)
         return EM_FALSE;
-    maybe_request_background_checkpoint((const char *)userData, true);
+    maybe_request_background_checkpoint((const char *)userData, true, true);
     return EM_FALSE;
 }
 
@@ -1153,7 +1190,8 @@ static EM_BOOL background_visibility_callback(int eventType, const EmscriptenVis
 static const char *background_beforeunload_callback(int eventType, const void *reserved, void *userData) {
     (void)eventType;
     (void)reserved;
-    maybe_request_background_checkpoint((const char *)userData, true);
+    // The page may be gone before a background write finishes: save in place
+    maybe_request_background_checkpoint((const char *)userData, true, false);
     return NULL;
 }
 
@@ -1170,7 +1208,7 @@ static void install_background_checkpoint_handlers(void) {
 // Platform impl of gs_background_checkpoint (weak default in system.c
 // stubs out for headless).
 int gs_background_checkpoint(const char *reason) {
-    int rc = save_quick_checkpoint(reason ? reason : "manual", true, false);
+    int rc = save_quick_checkpoint(reason ? reason : "manual", true, false, true);
     return (rc == GS_SUCCESS) ? 0 : -1;
 }
 
@@ -1181,6 +1219,8 @@ static int clear_checkpoint_files(void);
 // only mean something on WASM (where OPFS hosts per-machine
 // checkpoint directories); headless gets the weak no-op stubs.
 int gs_checkpoint_clear(void) {
+    // A save still in flight would otherwise recreate a file removed here
+    checkpoint_async_wait();
     int removed = clear_checkpoint_files();
     printf("Cleared %d checkpoint file(s)\n", removed);
     return 0;
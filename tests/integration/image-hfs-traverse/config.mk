@@ -1,8 +1,9 @@
-# Integration test: image HFS traversal + auto-mount + EBUSY + EROFS
+# Integration test: image HFS traversal + auto-mount + EBUSY + HFS writes
 # Exercises Phase 2 of proposal-image-vfs.md: implicit descent into an HFS
-# disk image, recursive cp out of the image, and the hd-attach conflict rule.
+# disk image, recursive cp out of the image, writes into a copy of it, and
+# the hd-attach conflict rule.
 
 TEST_NAME := Image HFS traverse
-TEST_DESC := Traverse a System 6 HFS floppy via VFS descent; verify cp, EROFS, EBUSY
+TEST_DESC := Traverse a System 6 HFS floppy via VFS descent; verify cp, writes, EBUSY
 
 TEST_ROM := roms/iix-iicx-se30-97221136.rom
@@ -183,6 +183,33 @@ TEST(parse_rejects_truncated_header) {
     free(buf);
 }
 
+TEST(sidecar_header_plus_rsrc_matches_sidecar) {
+    uint8_t rsrc[5] = {9, 8, 7, 6, 5};
+    uint8_t finder[AD_FINDER_INFO_SIZE] = {'A', 'P', 'P', 'L', 'M', 'A', 'C', 'S', 0x01, 0x00};
+    const uint8_t *finders[2] = {finder, NULL};
+    for (int i = 0; i < 2; i++) {
+        uint8_t *whole = NULL, *hdr = NULL;
+        size_t whole_len = 0, hdr_len = 0;
+        ASSERT_EQ_INT(0, ad_build_sidecar(rsrc, sizeof(rsrc), finders[i], &whole, &whole_len));
+        ASSERT_EQ_INT(0, ad_build_sidecar_header(sizeof(rsrc), finders[i], &hdr, &hdr_len));
+        ASSERT_EQ_INT((int)whole_len, (int)(hdr_len + sizeof(rsrc)));
+        ASSERT_TRUE(memcmp(whole, hdr, hdr_len) == 0);
+        ASSERT_TRUE(memcmp(whole + hdr_len, rsrc, sizeof(rsrc)) == 0);
+        free(whole);
+        free(hdr);
+    }
+    // Finder-only: the header is the whole sidecar
+    uint8_t *whole = NULL, *hdr = NULL;
+    size_t whole_len = 0, hdr_len = 0;
+    ASSERT_EQ_INT(0, ad_build_sidecar(NULL, 0, finder, &whole, &whole_len));
+    ASSERT_EQ_INT(0, ad_build_sidecar_header(0, finder, &hdr, &hdr_len));
+    ASSERT_EQ_INT((int)whole_len, (int)hdr_len);
+    ASSERT_TRUE(memcmp(whole, hdr, hdr_len) == 0);
+    free(whole);
+    free(hdr);
+    ASSERT_EQ_INT(-EINVAL, ad_build_sidecar_header(0, NULL, &hdr, &hdr_len));
+}
+
 int main(void) {
     RUN(sidecar_roundtrip_rsrc_and_finder);
     RUN(sidecar_rsrc_only_when_finder_null);
@@ -194,6 +221,7 @@ int main(void) {
     RUN(detect_false_on_wrong_version);
     RUN(parse_rejects_out_of_bounds_entry);
     RUN(parse_rejects_truncated_header);
+    RUN(sidecar_header_plus_rsrc_matches_sidecar);
     fprintf(stderr, "All appledouble tests passed.\n");
     return 0;
 }
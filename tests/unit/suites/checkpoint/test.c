@@ -0,0 +1,815 @@
+// Quick-checkpoint (v4) and consolidated-block unit tests.
+// Verifies that repeated quick saves to the same path append delta records
+// holding only the dirty RAM pages, that the reader replays base + deltas
+// into the exact RAM image, that a torn tail falls back to the last complete
+// record, and that long or heavy chains are compacted into a fresh base.
+// Consolidated checkpoints store large blocks as chunked LZ streams.
+// Asynchronous saves write the RAM snapshot taken at capture, not the live
+// RAM, and report pending / done / failed through the save state.
+// The mapped layout stores RAM raw and page-aligned so a restore maps it
+// copy-on-write, and falls back to reading where mapping does not apply.
+// Pooled checkpoints keep pages and file contents in a shared content-addressed
+// pool, so a second snapshot adds only what changed, and a sweep keeps exactly
+// the objects the remaining snapshots reference.  In-memory checkpoints share
+// a reference-counted pool the same way and free pages with their last user.
+
+#include "checkpoint.h"
+#include "snapshot_pool.h"
+#include "test_assert.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PAGE      4096u
+#define RAM_PAGES 64u
+#define RAM_SIZE  (RAM_PAGES * PAGE + 1024u) // partial last page on purpose
+#define RAM_KB    (RAM_SIZE / 1024u)
+#define MAP_SIZE  (RAM_PAGES * PAGE) // whole pages, so the mapped layout can be mapped
+#define MODEL     "test-model"
+
+#define CKPT_FILE "_ckpt_test.checkpoint"
+#define TMP_FILE  "_ckpt_test.checkpoint.tmp"
+
+// ============================================================================
+// Stubs for the system hooks checkpoint.c references
+// ============================================================================
+
+const char *get_build_id(void) {
+    return "unit-test-build-id-0";
+}
+
+const char *find_valid_checkpoint_path(void) {
+    return NULL;
+}
+
+int gs_checkpoint_clear(void) {
+    return 0;
+}
+
+int gs_background_checkpoint(const char *reason) {
+    (void)reason;
+    return 0;
+}
+
+bool gs_checkpoint_auto_get(void) {
+    return false;
+}
+
+void gs_checkpoint_auto_set(bool enabled) {
+    (void)enabled;
+}
+
+uint64_t cmd_load_checkpoint(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    return 0;
+}
+
+uint64_t cmd_save_checkpoint(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    return 0;
+}
+
+struct object *object_new(const struct class_desc *cls, void *instance_data, const char *name) {
+    (void)cls;
+    (void)instance_data;
+    (void)name;
+    return NULL;
+}
+
+struct object *object_root(void) {
+    return NULL;
+}
+
+void object_attach(struct object *parent, struct object *child) {
+    (void)parent;
+    (void)child;
+}
+
+void object_detach(struct object *obj) {
+    (void)obj;
+}
+
+void object_delete(struct object *obj) {
+    (void)obj;
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+// Machine state stand-in: a block before RAM and one after it
+typedef struct {
+    uint32_t pc;
+    uint32_t counter;
+} fake_state_t;
+
+static uint8_t g_ram[RAM_SIZE];
+static uint8_t g_dirty[RAM_PAGES + 1];
+
+// Return the file size, or -1 when it does not exist
+static long file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+// Save one quick checkpoint of state + RAM + trailer, then clear the dirty map
+static void save(const char *path, const fake_state_t *state) {
+    checkpoint_t *cp = checkpoint_open_write(path, CHECKPOINT_KIND_QUICK, MODEL, RAM_KB);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, state, sizeof(*state));
+    checkpoint_write_ram(cp, g_ram, RAM_SIZE, g_dirty);
+    uint32_t trailer = state->counter ^ 0xA5A5A5A5u;
+    system_write_checkpoint_data(cp, &trailer, sizeof(trailer));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    memset(g_dirty, 0, sizeof(g_dirty));
+}
+
+// Load a checkpoint and check it matches the given state and the live RAM
+static void expect_load(const char *path, const fake_state_t *state, const uint8_t *ram) {
+    static uint8_t loaded[RAM_SIZE];
+    checkpoint_t *cp = checkpoint_open_read(path);
+    ASSERT_TRUE(cp != NULL);
+    ASSERT_EQ_INT(CHECKPOINT_KIND_QUICK, checkpoint_get_kind(cp));
+    ASSERT_EQ_INT((int)RAM_KB, (int)checkpoint_get_ram_size_kb(cp));
+    fake_state_t got = {0};
+    uint32_t trailer = 0;
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    system_read_checkpoint_data(cp, loaded, RAM_SIZE);
+    system_read_checkpoint_data(cp, &trailer, sizeof(trailer));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_EQ_INT((int)state->pc, (int)got.pc);
+    ASSERT_EQ_INT((int)state->counter, (int)got.counter);
+    ASSERT_EQ_INT((int)(state->counter ^ 0xA5A5A5A5u), (int)trailer);
+    ASSERT_TRUE(memcmp(loaded, ram, RAM_SIZE) == 0);
+}
+
+// Store a byte into the fake RAM and mark its page dirty
+static void poke(uint32_t offset, uint8_t value) {
+    g_ram[offset] = value;
+    g_dirty[offset / PAGE] = 1;
+}
+
+// Stand-in for the memory layer's copy-on-write snapshot: a copy of RAM taken
+// at capture, served to the writer thread once the gate is open
+static struct {
+    uint8_t ram[RAM_SIZE];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool open;
+    bool fail;
+    int releases;
+} g_snap = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+
+// checkpoint_ram_read_fn over g_snap (blocks while the gate is closed)
+static bool snap_read(void *ctx, size_t off, uint8_t *dst, size_t len) {
+    (void)ctx;
+    pthread_mutex_lock(&g_snap.lock);
+    while (!g_snap.open)
+        pthread_cond_wait(&g_snap.cond, &g_snap.lock);
+    bool ok = !g_snap.fail;
+    pthread_mutex_unlock(&g_snap.lock);
+    if (ok)
+        memcpy(dst, g_snap.ram + off, len);
+    return ok;
+}
+
+// checkpoint_ram_release_fn over g_snap
+static void snap_release(void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&g_snap.lock);
+    g_snap.releases++;
+    pthread_mutex_unlock(&g_snap.lock);
+}
+
+// Let the writer read the snapshot
+static void snap_open(void) {
+    pthread_mutex_lock(&g_snap.lock);
+    g_snap.open = true;
+    pthread_cond_broadcast(&g_snap.cond);
+    pthread_mutex_unlock(&g_snap.lock);
+}
+
+// Capture one quick checkpoint asynchronously (the counterpart of save);
+// with gated set the writer stalls on RAM until snap_open
+static void save_async(const char *path, const fake_state_t *state, bool gated, checkpoint_done_fn done, void *ctx) {
+    memcpy(g_snap.ram, g_ram, RAM_SIZE);
+    g_snap.open = !gated;
+    g_snap.releases = 0;
+    checkpoint_t *cp = checkpoint_open_write_async(path, CHECKPOINT_KIND_QUICK, MODEL, RAM_KB);
+    ASSERT_TRUE(cp != NULL);
+    ASSERT_TRUE(checkpoint_is_async(cp));
+    system_write_checkpoint_data(cp, state, sizeof(*state));
+    checkpoint_write_ram_deferred(cp, RAM_SIZE, g_dirty, snap_read, snap_release, NULL);
+    uint32_t trailer = state->counter ^ 0xA5A5A5A5u;
+    system_write_checkpoint_data(cp, &trailer, sizeof(trailer));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    memset(g_dirty, 0, sizeof(g_dirty));
+    checkpoint_close_async(cp, done, ctx);
+}
+
+// Completion hook: count the calls and keep the outcome
+static int g_done_calls;
+static bool g_done_ok;
+static bool count_done(bool ok, void *ctx) {
+    (void)ctx;
+    g_done_calls++;
+    g_done_ok = ok;
+    return ok;
+}
+
+// Completion hook: publish the tmp file as well
+static bool rename_done(bool ok, void *ctx) {
+    return count_done(ok, ctx) && checkpoint_quick_rename(TMP_FILE, CKPT_FILE) == 0;
+}
+
+// Fresh RAM pattern, everything dirty, no files left over.  The pattern is
+// pseudo-random so record sizes do not depend on how well it compresses.
+static void setup(void) {
+    uint32_t x = 0x12345678u;
+    for (uint32_t i = 0; i < RAM_SIZE; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        g_ram[i] = (uint8_t)x;
+    }
+    memset(g_dirty, 1, sizeof(g_dirty));
+    remove(CKPT_FILE);
+    remove(TMP_FILE);
+}
+
+// Remove the files a test created
+static void teardown(void) {
+    remove(CKPT_FILE);
+    remove(TMP_FILE);
+}
+
+// Count the regular files under dir (recursively); with rm set, delete
+// everything under it and dir itself
+static int walk_tree(const char *dir, bool rm) {
+    DIR *d = opendir(dir);
+    if (!d)
+        return 0;
+    int files = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+            continue;
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode)) {
+            files += walk_tree(path, rm);
+        } else {
+            files++;
+            if (rm)
+                remove(path);
+        }
+    }
+    closedir(d);
+    if (rm)
+        rmdir(dir);
+    return files;
+}
+
+// Write one pooled consolidated checkpoint of state + RAM + a file block
+static void save_pooled(const char *path, const fake_state_t *state, const char *file) {
+    checkpoint_set_pooled(true);
+    checkpoint_t *cp = checkpoint_open_write(path, CHECKPOINT_KIND_CONSOLIDATED, MODEL, RAM_KB);
+    checkpoint_set_pooled(false);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, state, sizeof(*state));
+    checkpoint_write_ram(cp, g_ram, RAM_SIZE, NULL);
+    checkpoint_write_file(cp, file);
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+}
+
+// Read a checkpoint written by save_pooled; true if it read back cleanly and
+// matches state, the live RAM and the file contents
+static bool load_pooled(const char *path, const fake_state_t *state, const uint8_t *content, size_t size) {
+    static uint8_t loaded[RAM_SIZE];
+    static uint8_t file_buf[RAM_SIZE];
+    checkpoint_t *cp = checkpoint_open_read(path);
+    ASSERT_TRUE(cp != NULL);
+    fake_state_t got = {0};
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    system_read_checkpoint_data(cp, loaded, RAM_SIZE);
+    char *name = NULL;
+    size_t got_size = checkpoint_read_file(cp, file_buf, sizeof(file_buf), &name);
+    bool ok = !checkpoint_has_error(cp);
+    checkpoint_close(cp);
+    free(name);
+    return ok && got.counter == state->counter && memcmp(loaded, g_ram, RAM_SIZE) == 0 && got_size == size &&
+           memcmp(file_buf, content, size) == 0;
+}
+
+// Write an in-memory history checkpoint of state + RAM into pool
+static void save_mem(snapshot_mem_pool_t *pool, const fake_state_t *state, void **data, size_t *size,
+                     snapshot_hash_set_t **refs) {
+    checkpoint_t *cp = checkpoint_open_write_mem(CHECKPOINT_KIND_HISTORY, MODEL, RAM_KB, pool);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, state, sizeof(*state));
+    checkpoint_write_ram(cp, g_ram, RAM_SIZE, NULL);
+    ASSERT_TRUE(checkpoint_close_mem(cp, data, size, refs));
+}
+
+// Read back a stream from save_mem; true if it matches state and ram
+static bool load_mem(snapshot_mem_pool_t *pool, const void *data, size_t size, const fake_state_t *state,
+                     const uint8_t *ram) {
+    static uint8_t loaded[RAM_SIZE];
+    checkpoint_t *cp = checkpoint_open_read_mem(data, size, CHECKPOINT_KIND_HISTORY, MODEL, RAM_KB, pool);
+    ASSERT_TRUE(cp != NULL);
+    ASSERT_EQ_INT(CHECKPOINT_KIND_HISTORY, (int)checkpoint_get_kind(cp));
+    fake_state_t got = {0};
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    system_read_checkpoint_data(cp, loaded, RAM_SIZE);
+    bool ok = !checkpoint_has_error(cp);
+    checkpoint_close(cp);
+    return ok && got.counter == state->counter && memcmp(loaded, ram, RAM_SIZE) == 0;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+TEST(test_base_roundtrip) {
+    setup();
+    fake_state_t st = {.pc = 0x400100, .counter = 1};
+    ASSERT_TRUE(!checkpoint_quick_appends(CKPT_FILE));
+    save(CKPT_FILE, &st);
+    ASSERT_TRUE(file_size(CKPT_FILE) > (long)RAM_SIZE);
+    ASSERT_TRUE(checkpoint_validate_build_id(CKPT_FILE));
+    expect_load(CKPT_FILE, &st, g_ram);
+    teardown();
+}
+
+TEST(test_delta_holds_dirty_pages) {
+    setup();
+    fake_state_t st = {.pc = 0x400100, .counter = 1};
+    save(CKPT_FILE, &st);
+    long base = file_size(CKPT_FILE);
+
+    // Two dirty pages, one of them the partial tail page
+    poke(5 * PAGE + 17, 0xEE);
+    poke(RAM_SIZE - 1, 0x42);
+    st.counter = 2;
+    ASSERT_TRUE(checkpoint_quick_appends(CKPT_FILE));
+    save(CKPT_FILE, &st);
+    long grown = file_size(CKPT_FILE) - base;
+    ASSERT_TRUE(grown > (long)(2 * PAGE) - 3072);
+    ASSERT_TRUE(grown < (long)(3 * PAGE));
+    expect_load(CKPT_FILE, &st, g_ram);
+
+    // A save with nothing dirty only carries the non-RAM blocks
+    st.pc = 0x400200;
+    st.counter = 3;
+    long before = file_size(CKPT_FILE);
+    save(CKPT_FILE, &st);
+    ASSERT_TRUE(file_size(CKPT_FILE) - before < 256);
+    expect_load(CKPT_FILE, &st, g_ram);
+    teardown();
+}
+
+TEST(test_torn_tail_falls_back) {
+    setup();
+    fake_state_t st = {.pc = 0x1000, .counter = 1};
+    save(CKPT_FILE, &st);
+    poke(3 * PAGE, 0x11);
+    st.counter = 2;
+    save(CKPT_FILE, &st);
+    static uint8_t committed[RAM_SIZE];
+    memcpy(committed, g_ram, RAM_SIZE);
+    fake_state_t good = st;
+    long good_size = file_size(CKPT_FILE);
+
+    // Interrupted third save: cut its record short
+    poke(9 * PAGE, 0x22);
+    st.counter = 3;
+    save(CKPT_FILE, &st);
+    ASSERT_EQ_INT(0, truncate(CKPT_FILE, file_size(CKPT_FILE) - 8));
+    expect_load(CKPT_FILE, &good, committed);
+
+    // The chain no longer matches the file, so the next save starts a base
+    ASSERT_TRUE(!checkpoint_quick_appends(CKPT_FILE));
+    memset(g_dirty, 0, sizeof(g_dirty));
+    st.counter = 4;
+    save(CKPT_FILE, &st);
+    ASSERT_TRUE(file_size(CKPT_FILE) > (long)RAM_SIZE);
+    ASSERT_TRUE(file_size(CKPT_FILE) < good_size);
+    expect_load(CKPT_FILE, &st, g_ram);
+    teardown();
+}
+
+TEST(test_compaction_after_many_deltas) {
+    setup();
+    fake_state_t st = {.pc = 0x2000, .counter = 0};
+    save(CKPT_FILE, &st);
+    long base = file_size(CKPT_FILE);
+
+    // Small deltas append until the chain length cap forces a fresh base
+    int appended = 0;
+    while (checkpoint_quick_appends(CKPT_FILE)) {
+        poke((uint32_t)(appended % RAM_PAGES) * PAGE, (uint8_t)appended);
+        st.counter++;
+        save(CKPT_FILE, &st);
+        appended++;
+        ASSERT_TRUE(appended < 1000);
+    }
+    ASSERT_TRUE(appended > 1);
+    ASSERT_TRUE(file_size(CKPT_FILE) > base);
+    st.counter++;
+    save(CKPT_FILE, &st);
+    ASSERT_TRUE(file_size(CKPT_FILE) <= base);
+    ASSERT_TRUE(checkpoint_quick_appends(CKPT_FILE));
+    expect_load(CKPT_FILE, &st, g_ram);
+    teardown();
+}
+
+TEST(test_compaction_after_heavy_deltas) {
+    setup();
+    fake_state_t st = {.pc = 0x3000, .counter = 0};
+    save(CKPT_FILE, &st);
+
+    // Each delta rewrites a third of RAM; the second one pushes the chain
+    // past half the base size and the next save compacts
+    int appended = 0;
+    while (checkpoint_quick_appends(CKPT_FILE)) {
+        for (uint32_t p = 0; p < RAM_PAGES / 3; p++)
+            poke(p * PAGE + (uint32_t)appended, (uint8_t)(0x80 + appended));
+        st.counter++;
+        save(CKPT_FILE, &st);
+        appended++;
+        ASSERT_TRUE(appended < 10);
+    }
+    ASSERT_EQ_INT(2, appended);
+    expect_load(CKPT_FILE, &st, g_ram);
+    teardown();
+}
+
+TEST(test_rename_carries_chain) {
+    setup();
+    fake_state_t st = {.pc = 0x4000, .counter = 1};
+    save(TMP_FILE, &st);
+    ASSERT_EQ_INT(0, checkpoint_quick_rename(TMP_FILE, CKPT_FILE));
+    ASSERT_TRUE(!checkpoint_quick_appends(TMP_FILE));
+    ASSERT_TRUE(checkpoint_quick_appends(CKPT_FILE));
+
+    poke(0, 0x99);
+    st.counter = 2;
+    save(CKPT_FILE, &st);
+    expect_load(CKPT_FILE, &st, g_ram);
+
+    // Anything else touching the file breaks the chain
+    FILE *f = fopen(CKPT_FILE, "ab");
+    ASSERT_TRUE(f != NULL);
+    fputc(0, f);
+    fclose(f);
+    ASSERT_TRUE(!checkpoint_quick_appends(CKPT_FILE));
+    teardown();
+}
+
+TEST(test_consolidated_blocks_compress) {
+    setup();
+    // Mostly-zero RAM with a few patterned pages, like a freshly booted machine
+    memset(g_ram, 0, RAM_SIZE);
+    for (uint32_t i = 0; i < 8 * PAGE; i++)
+        g_ram[PAGE + i] = (uint8_t)(i % 251);
+    fake_state_t st = {.pc = 0x5000, .counter = 9};
+    checkpoint_t *cp = checkpoint_open_write(CKPT_FILE, CHECKPOINT_KIND_CONSOLIDATED, MODEL, RAM_KB);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, &st, sizeof(st));
+    checkpoint_write_ram(cp, g_ram, RAM_SIZE, NULL);
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_TRUE(file_size(CKPT_FILE) < (long)(RAM_SIZE / 8));
+
+    static uint8_t loaded[RAM_SIZE];
+    fake_state_t got = {0};
+    cp = checkpoint_open_read(CKPT_FILE);
+    ASSERT_TRUE(cp != NULL);
+    ASSERT_EQ_INT(CHECKPOINT_KIND_CONSOLIDATED, checkpoint_get_kind(cp));
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    system_read_checkpoint_data(cp, loaded, RAM_SIZE);
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_EQ_INT(9, (int)got.counter);
+    ASSERT_TRUE(memcmp(loaded, g_ram, RAM_SIZE) == 0);
+    teardown();
+}
+
+TEST(test_async_quick_save) {
+    setup();
+    static uint8_t captured[RAM_SIZE];
+    memcpy(captured, g_ram, RAM_SIZE);
+    fake_state_t st = {.pc = 0x6000, .counter = 1};
+    g_done_calls = 0;
+    save_async(TMP_FILE, &st, true, rename_done, NULL);
+    ASSERT_EQ_INT(CHECKPOINT_SAVE_PENDING, checkpoint_save_state());
+
+    // The guest runs on while the file is written; its stores stay out of it
+    poke(7 * PAGE, (uint8_t)~g_ram[7 * PAGE]);
+    snap_open();
+    checkpoint_async_wait();
+    ASSERT_EQ_INT(CHECKPOINT_SAVE_DONE, checkpoint_save_state());
+    ASSERT_EQ_INT(0, (int)strlen(checkpoint_last_error()));
+    ASSERT_EQ_INT(1, g_done_calls);
+    ASSERT_EQ_INT(1, g_snap.releases);
+    ASSERT_TRUE(file_size(TMP_FILE) < 0);
+    expect_load(CKPT_FILE, &st, captured);
+
+    // The renamed chain takes the next asynchronous save as a small delta
+    ASSERT_TRUE(checkpoint_quick_appends(CKPT_FILE));
+    long base = file_size(CKPT_FILE);
+    st.counter = 2;
+    save_async(CKPT_FILE, &st, false, NULL, NULL);
+    checkpoint_async_wait();
+    ASSERT_EQ_INT(CHECKPOINT_SAVE_DONE, checkpoint_save_state());
+    ASSERT_TRUE(file_size(CKPT_FILE) - base < (long)(2 * PAGE));
+    expect_load(CKPT_FILE, &st, g_ram);
+    teardown();
+}
+
+TEST(test_async_consolidated_save) {
+    setup();
+    fake_state_t st = {.pc = 0x7000, .counter = 5};
+    uint32_t trailer = 0xC0DEC0DEu;
+    memcpy(g_snap.ram, g_ram, RAM_SIZE);
+    g_snap.open = true;
+    g_snap.releases = 0;
+    checkpoint_t *cp = checkpoint_open_write_async(CKPT_FILE, CHECKPOINT_KIND_CONSOLIDATED, MODEL, RAM_KB);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, &st, sizeof(st));
+    checkpoint_write_ram_deferred(cp, RAM_SIZE, NULL, snap_read, snap_release, NULL);
+    system_write_checkpoint_data(cp, &trailer, sizeof(trailer));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close_async(cp, NULL, NULL);
+    checkpoint_async_wait();
+    ASSERT_EQ_INT(CHECKPOINT_SAVE_DONE, checkpoint_save_state());
+    ASSERT_EQ_INT(1, g_snap.releases);
+
+    // The RAM block sits between the blocks captured around it
+    static uint8_t loaded[RAM_SIZE];
+    fake_state_t got = {0};
+    uint32_t got_trailer = 0;
+    cp = checkpoint_open_read(CKPT_FILE);
+    ASSERT_TRUE(cp != NULL);
+    ASSERT_EQ_INT(CHECKPOINT_KIND_CONSOLIDATED, checkpoint_get_kind(cp));
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    system_read_checkpoint_data(cp, loaded, RAM_SIZE);
+    system_read_checkpoint_data(cp, &got_trailer, sizeof(got_trailer));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_EQ_INT(5, (int)got.counter);
+    ASSERT_TRUE(got_trailer == trailer);
+    ASSERT_TRUE(memcmp(loaded, g_ram, RAM_SIZE) == 0);
+    teardown();
+}
+
+TEST(test_async_failure_reported) {
+    setup();
+    fake_state_t st = {.pc = 0x8000, .counter = 1};
+    save(CKPT_FILE, &st);
+    ASSERT_TRUE(checkpoint_quick_appends(CKPT_FILE));
+
+    // A snapshot that cannot be read fails the save and breaks the chain
+    g_snap.fail = true;
+    g_done_calls = 0;
+    st.counter = 2;
+    poke(2 * PAGE, 0x22);
+    save_async(CKPT_FILE, &st, false, count_done, NULL);
+    checkpoint_async_wait();
+    g_snap.fail = false;
+    ASSERT_EQ_INT(CHECKPOINT_SAVE_FAILED, checkpoint_save_state());
+    ASSERT_TRUE(strstr(checkpoint_last_error(), "RAM") != NULL);
+    ASSERT_EQ_INT(1, g_done_calls);
+    ASSERT_TRUE(!g_done_ok);
+    ASSERT_EQ_INT(1, g_snap.releases);
+    ASSERT_TRUE(!checkpoint_quick_appends(CKPT_FILE));
+    teardown();
+}
+
+TEST(test_mapped_layout_restore) {
+    setup();
+    fake_state_t st = {.pc = 0x9000, .counter = 3};
+    uint32_t trailer = 0x600DF00Du;
+    checkpoint_set_ram_mapped(true);
+    checkpoint_t *cp = checkpoint_open_write(CKPT_FILE, CHECKPOINT_KIND_CONSOLIDATED, MODEL, RAM_KB);
+    checkpoint_set_ram_mapped(false);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, &st, sizeof(st));
+    checkpoint_write_ram(cp, g_ram, MAP_SIZE, NULL);
+    system_write_checkpoint_data(cp, &trailer, sizeof(trailer));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_TRUE(file_size(CKPT_FILE) > (long)MAP_SIZE);
+
+    // RAM is mapped over anonymous pages; the blocks around it still read
+    uint8_t *ram = mmap(NULL, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_TRUE(ram != MAP_FAILED);
+    fake_state_t got = {0};
+    uint32_t got_trailer = 0;
+    cp = checkpoint_open_read(CKPT_FILE);
+    ASSERT_TRUE(cp != NULL);
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    ASSERT_TRUE(checkpoint_read_ram(cp, ram, MAP_SIZE, true));
+    system_read_checkpoint_data(cp, &got_trailer, sizeof(got_trailer));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_EQ_INT(3, (int)got.counter);
+    ASSERT_TRUE(got_trailer == trailer);
+    ASSERT_TRUE(memcmp(ram, g_ram, MAP_SIZE) == 0);
+
+    // Guest stores are private, and saving over the file leaves the mapping intact
+    ram[5 * PAGE] ^= 0xFF;
+    static uint8_t saved[MAP_SIZE];
+    memcpy(saved, g_ram, MAP_SIZE);
+    saved[5 * PAGE] ^= 0xFF;
+    memset(g_ram, 0x5A, MAP_SIZE);
+    cp = checkpoint_open_write(CKPT_FILE, CHECKPOINT_KIND_CONSOLIDATED, MODEL, RAM_KB);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, &st, sizeof(st));
+    checkpoint_write_ram(cp, g_ram, MAP_SIZE, NULL);
+    checkpoint_close(cp);
+    ASSERT_TRUE(memcmp(ram, saved, MAP_SIZE) == 0);
+    munmap(ram, MAP_SIZE);
+    teardown();
+}
+
+TEST(test_mapped_layout_fallbacks) {
+    setup();
+    // Written asynchronously, with a partial last page that cannot be mapped
+    fake_state_t st = {.pc = 0xA000, .counter = 4};
+    memcpy(g_snap.ram, g_ram, RAM_SIZE);
+    g_snap.open = true;
+    g_snap.releases = 0;
+    checkpoint_set_ram_mapped(true);
+    checkpoint_t *cp = checkpoint_open_write_async(CKPT_FILE, CHECKPOINT_KIND_CONSOLIDATED, MODEL, RAM_KB);
+    checkpoint_set_ram_mapped(false);
+    ASSERT_TRUE(cp != NULL);
+    system_write_checkpoint_data(cp, &st, sizeof(st));
+    checkpoint_write_ram_deferred(cp, RAM_SIZE, NULL, snap_read, snap_release, NULL);
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close_async(cp, NULL, NULL);
+    checkpoint_async_wait();
+    ASSERT_EQ_INT(CHECKPOINT_SAVE_DONE, checkpoint_save_state());
+
+    // Both the mapping-aware and the plain reader copy it
+    static uint8_t loaded[RAM_SIZE];
+    fake_state_t got = {0};
+    cp = checkpoint_open_read(CKPT_FILE);
+    ASSERT_TRUE(cp != NULL);
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    ASSERT_TRUE(!checkpoint_read_ram(cp, loaded, RAM_SIZE, true));
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_TRUE(memcmp(loaded, g_ram, RAM_SIZE) == 0);
+
+    memset(loaded, 0, RAM_SIZE);
+    cp = checkpoint_open_read(CKPT_FILE);
+    ASSERT_TRUE(cp != NULL);
+    system_read_checkpoint_data(cp, &got, sizeof(got));
+    system_read_checkpoint_data(cp, loaded, RAM_SIZE);
+    ASSERT_TRUE(!checkpoint_has_error(cp));
+    checkpoint_close(cp);
+    ASSERT_EQ_INT(4, (int)got.counter);
+    ASSERT_TRUE(memcmp(loaded, g_ram, RAM_SIZE) == 0);
+    teardown();
+}
+
+TEST(test_pooled_snapshots_dedup) {
+    setup();
+    char dir[] = "/tmp/ckpt_pool_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != NULL);
+    char a[64], b[64], file[64], pool[64];
+    snprintf(a, sizeof(a), "%s/a.snap", dir);
+    snprintf(b, sizeof(b), "%s/b.snap", dir);
+    snprintf(file, sizeof(file), "%s/rom.bin", dir);
+    snprintf(pool, sizeof(pool), "%s/pool", dir);
+
+    // Half the pages are zero and share one object; the file is 5 pages of RAM
+    memset(g_ram, 0, RAM_PAGES / 2 * PAGE);
+    FILE *f = fopen(file, "wb");
+    ASSERT_TRUE(f != NULL);
+    fwrite(g_ram + 40 * PAGE, 1, 5 * PAGE, f);
+    fclose(f);
+    static uint8_t content[5 * PAGE];
+    memcpy(content, g_ram + 40 * PAGE, sizeof(content));
+
+    fake_state_t st = {.pc = 0xB000, .counter = 5};
+    save_pooled(a, &st, file);
+    ASSERT_TRUE(file_size(a) < (long)(RAM_SIZE / 16));
+    int objects = walk_tree(pool, false);
+    ASSERT_EQ_INT((int)(RAM_PAGES / 2 + 2 + 1), objects); // random pages + tail + zero page + file
+    ASSERT_TRUE(load_pooled(a, &st, content, sizeof(content)));
+
+    snapshot_hash_set_t *refs = snapshot_hash_set_new();
+    ASSERT_TRUE(checkpoint_pool_refs(a, refs));
+    ASSERT_EQ_INT(objects, (int)snapshot_hash_set_count(refs));
+    snapshot_hash_set_free(refs);
+
+    // A second snapshot adds only the two pages that changed
+    poke(3 * PAGE, 0x11);
+    poke(50 * PAGE + 7, 0x22);
+    st.counter = 6;
+    save_pooled(b, &st, file);
+    ASSERT_EQ_INT(objects + 2, walk_tree(pool, false));
+    ASSERT_TRUE(load_pooled(b, &st, content, sizeof(content)));
+
+    // Dropping the first snapshot frees the old page 50; page 3 was the shared zero page
+    remove(a);
+    snapshot_hash_set_t *live = snapshot_hash_set_new();
+    ASSERT_TRUE(checkpoint_pool_refs(b, live));
+    uint64_t freed = 0;
+    ASSERT_EQ_INT(1, (int)snapshot_pool_sweep(pool, live, &freed));
+    ASSERT_TRUE(freed > 0);
+    ASSERT_EQ_INT(0, (int)snapshot_pool_sweep(pool, live, NULL));
+    snapshot_hash_set_free(live);
+    ASSERT_TRUE(load_pooled(b, &st, content, sizeof(content)));
+
+    // A plain checkpoint has no refs trailer, and a missing object fails the read
+    ASSERT_TRUE(!checkpoint_pool_refs(file, NULL));
+    snapshot_hash_t zero;
+    snapshot_hash(g_ram, PAGE, &zero);
+    char hex[SNAPSHOT_HASH_LEN * 2 + 1], obj[128];
+    snapshot_hash_hex(&zero, hex);
+    snprintf(obj, sizeof(obj), "%s/%.2s/%s", pool, hex, hex + 2);
+    ASSERT_EQ_INT(0, remove(obj));
+    ASSERT_TRUE(!load_pooled(b, &st, content, sizeof(content)));
+
+    walk_tree(dir, true);
+    teardown();
+}
+
+TEST(test_mem_snapshots_share_pages) {
+    setup();
+    snapshot_mem_pool_t *pool = snapshot_mem_pool_new();
+    ASSERT_TRUE(pool != NULL);
+    memset(g_ram, 0, RAM_PAGES / 2 * PAGE);
+    static uint8_t first_ram[RAM_SIZE];
+    memcpy(first_ram, g_ram, RAM_SIZE);
+
+    fake_state_t st1 = {.pc = 0xC000, .counter = 7};
+    void *a = NULL, *b = NULL;
+    size_t a_size = 0, b_size = 0;
+    snapshot_hash_set_t *a_refs = NULL, *b_refs = NULL;
+    save_mem(pool, &st1, &a, &a_size, &a_refs);
+    size_t objects = snapshot_mem_pool_count(pool);
+    ASSERT_EQ_INT((int)(RAM_PAGES / 2 + 2), (int)objects); // random pages + tail + zero page
+    ASSERT_TRUE(a_size < RAM_SIZE / 16);
+    ASSERT_TRUE(snapshot_mem_pool_bytes(pool) > 0);
+
+    // The next snapshot adds only the page that changed
+    poke(50 * PAGE + 9, 0x5A);
+    fake_state_t st2 = {.pc = 0xC010, .counter = 8};
+    save_mem(pool, &st2, &b, &b_size, &b_refs);
+    ASSERT_EQ_INT((int)(objects + 1), (int)snapshot_mem_pool_count(pool));
+    ASSERT_TRUE(load_mem(pool, a, a_size, &st1, first_ram));
+    ASSERT_TRUE(load_mem(pool, b, b_size, &st2, g_ram));
+
+    // Dropping the first frees just its old page 50
+    snapshot_mem_pool_release(pool, snapshot_hash_set_items(a_refs), snapshot_hash_set_count(a_refs));
+    ASSERT_EQ_INT((int)objects, (int)snapshot_mem_pool_count(pool));
+    ASSERT_TRUE(load_mem(pool, b, b_size, &st2, g_ram));
+    snapshot_mem_pool_release(pool, snapshot_hash_set_items(b_refs), snapshot_hash_set_count(b_refs));
+    ASSERT_EQ_INT(0, (int)snapshot_mem_pool_count(pool));
+    ASSERT_TRUE(snapshot_mem_pool_bytes(pool) == 0);
+
+    snapshot_hash_set_free(a_refs);
+    snapshot_hash_set_free(b_refs);
+    free(a);
+    free(b);
+    snapshot_mem_pool_free(pool);
+    teardown();
+}
+
+int main(void) {
+    RUN(test_base_roundtrip);
+    RUN(test_delta_holds_dirty_pages);
+    RUN(test_torn_tail_falls_back);
+    RUN(test_compaction_after_many_deltas);
+    RUN(test_compaction_after_heavy_deltas);
+    RUN(test_rename_carries_chain);
+    RUN(test_consolidated_blocks_compress);
+    RUN(test_async_quick_save);
+    RUN(test_async_consolidated_save);
+    RUN(test_async_failure_reported);
+    RUN(test_mapped_layout_restore);
+    RUN(test_mapped_layout_fallbacks);
+    RUN(test_pooled_snapshots_dedup);
+    RUN(test_mem_snapshots_share_pages);
+    printf("[PASS] All checkpoint tests passed\n");
+    return 0;
+}
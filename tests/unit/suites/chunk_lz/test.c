@@ -0,0 +1,200 @@
+// Chunked LZ codec unit tests.
+// Verifies that chunk_lz streams round-trip for empty, tiny, compressible,
+// overlapping-match and incompressible inputs, that the thread pool produces
+// byte-identical streams to the serial path, and that truncated, corrupted
+// or mis-sized streams are rejected.
+
+#include "chunk_lz.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BIG_SIZE (CHUNK_LZ_CHUNK_SIZE * 9 + 1234) // several chunks plus a partial one
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static uint32_t g_seed;
+
+// xorshift32 byte
+static uint8_t rnd(void) {
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return (uint8_t)g_seed;
+}
+
+// Fill buf with something RAM-like: zero runs, repeated records, text and noise
+static void fill_mixed(uint8_t *buf, size_t size) {
+    g_seed = 0xC0FFEEu;
+    size_t i = 0;
+    while (i < size) {
+        size_t n = 64 + rnd() * 16u;
+        if (n > size - i)
+            n = size - i;
+        switch (rnd() & 3) {
+        case 0:
+            memset(buf + i, 0, n);
+            break;
+        case 1:
+            for (size_t k = 0; k < n; k++)
+                buf[i + k] = (uint8_t)("\x4E\x75\x20\x6F\x00\x04\x4E\x56"[k & 7]);
+            break;
+        case 2:
+            for (size_t k = 0; k < n; k++)
+                buf[i + k] = (uint8_t)("The quick brown fox jumps over the lazy dog. "[k % 45]);
+            break;
+        default:
+            for (size_t k = 0; k < n; k++)
+                buf[i + k] = rnd();
+            break;
+        }
+        i += n;
+    }
+}
+
+// Encode, check the size bound, decode and compare; returns the stream size
+static size_t roundtrip(const uint8_t *in, size_t size) {
+    size_t cap = chunk_lz_bound(size);
+    uint8_t *stream = malloc(cap);
+    uint8_t *out = malloc(size ? size : 1);
+    ASSERT_TRUE(stream && out);
+    size_t n = chunk_lz_encode(in, size, stream, cap);
+    ASSERT_TRUE(n > 0 && n <= cap);
+    uint64_t raw = 0;
+    ASSERT_TRUE(chunk_lz_raw_size(stream, n, &raw));
+    ASSERT_EQ_INT((int)size, (int)raw);
+    ASSERT_TRUE(chunk_lz_decode(stream, n, out, size));
+    ASSERT_TRUE(size == 0 || memcmp(in, out, size) == 0);
+    free(stream);
+    free(out);
+    return n;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+TEST(test_small_inputs) {
+    uint8_t buf[16] = "abcabcabcabcabc";
+    roundtrip(buf, 0);
+    roundtrip(buf, 1);
+    roundtrip(buf, 3);
+    roundtrip(buf, 4);
+    roundtrip(buf, sizeof(buf));
+}
+
+TEST(test_zero_block_compresses) {
+    uint8_t *buf = calloc(1, BIG_SIZE);
+    ASSERT_TRUE(buf != NULL);
+    size_t n = roundtrip(buf, BIG_SIZE);
+    ASSERT_TRUE(n < BIG_SIZE / 100);
+    free(buf);
+}
+
+TEST(test_overlapping_matches) {
+    // Short periods exercise the overlapping match copy
+    uint8_t *buf = malloc(BIG_SIZE);
+    ASSERT_TRUE(buf != NULL);
+    for (size_t period = 1; period <= 19; period += 3) {
+        for (size_t i = 0; i < BIG_SIZE; i++)
+            buf[i] = (uint8_t)(i % period * 37 + 1);
+        size_t n = roundtrip(buf, BIG_SIZE);
+        ASSERT_TRUE(n < BIG_SIZE / 20);
+    }
+    free(buf);
+}
+
+TEST(test_mixed_data_ratio) {
+    uint8_t *buf = malloc(BIG_SIZE);
+    ASSERT_TRUE(buf != NULL);
+    fill_mixed(buf, BIG_SIZE);
+    size_t n = roundtrip(buf, BIG_SIZE);
+    // A quarter of the input is noise; everything else should fold away
+    ASSERT_TRUE(n < BIG_SIZE / 3);
+    free(buf);
+}
+
+TEST(test_incompressible_stored_raw) {
+    uint8_t *buf = malloc(BIG_SIZE);
+    ASSERT_TRUE(buf != NULL);
+    g_seed = 0xBADC0DEu;
+    for (size_t i = 0; i < BIG_SIZE; i++)
+        buf[i] = rnd();
+    size_t n = roundtrip(buf, BIG_SIZE);
+    ASSERT_EQ_INT((int)chunk_lz_bound(BIG_SIZE), (int)n);
+    free(buf);
+}
+
+TEST(test_parallel_matches_serial) {
+    uint8_t *buf = malloc(BIG_SIZE);
+    size_t cap = chunk_lz_bound(BIG_SIZE);
+    uint8_t *serial = malloc(cap);
+    uint8_t *parallel = malloc(cap);
+    ASSERT_TRUE(buf && serial && parallel);
+    fill_mixed(buf, BIG_SIZE);
+
+    chunk_lz_set_threads(1);
+    size_t a = chunk_lz_encode(buf, BIG_SIZE, serial, cap);
+    chunk_lz_set_threads(4);
+    size_t b = chunk_lz_encode(buf, BIG_SIZE, parallel, cap);
+    ASSERT_EQ_INT((int)a, (int)b);
+    ASSERT_TRUE(memcmp(serial, parallel, a) == 0);
+
+    // Repeated pool batches stay correct
+    for (int round = 0; round < 20; round++)
+        roundtrip(buf, BIG_SIZE - (size_t)round * 4099);
+    chunk_lz_set_threads(0);
+    free(buf);
+    free(serial);
+    free(parallel);
+}
+
+TEST(test_malformed_streams_rejected) {
+    uint8_t *buf = malloc(BIG_SIZE);
+    uint8_t *out = malloc(BIG_SIZE);
+    size_t cap = chunk_lz_bound(BIG_SIZE);
+    uint8_t *stream = malloc(cap);
+    uint8_t *bad = malloc(cap);
+    ASSERT_TRUE(buf && out && stream && bad);
+    fill_mixed(buf, BIG_SIZE);
+    size_t n = chunk_lz_encode(buf, BIG_SIZE, stream, cap);
+    ASSERT_TRUE(n > 0);
+
+    // Wrong output size, truncation, and an encoder cap that is too small
+    ASSERT_TRUE(!chunk_lz_decode(stream, n, out, BIG_SIZE - 1));
+    ASSERT_TRUE(!chunk_lz_decode(stream, n - 1, out, BIG_SIZE));
+    ASSERT_TRUE(!chunk_lz_decode(stream, 8, out, BIG_SIZE));
+    ASSERT_EQ_INT(0, (int)chunk_lz_encode(buf, BIG_SIZE, bad, cap - 1));
+
+    // Random byte flips must never crash; most are caught
+    g_seed = 0x5EEDu;
+    int rejected = 0;
+    for (int trial = 0; trial < 200; trial++) {
+        memcpy(bad, stream, n);
+        size_t pos = ((size_t)rnd() << 16 | (size_t)rnd() << 8 | rnd()) % n;
+        bad[pos] ^= (uint8_t)(rnd() | 1);
+        rejected += !chunk_lz_decode(bad, n, out, BIG_SIZE);
+    }
+    ASSERT_TRUE(rejected > 0);
+    free(buf);
+    free(out);
+    free(stream);
+    free(bad);
+}
+
+int main(void) {
+    RUN(test_small_inputs);
+    RUN(test_zero_block_compresses);
+    RUN(test_overlapping_matches);
+    RUN(test_mixed_data_ratio);
+    RUN(test_incompressible_stored_raw);
+    RUN(test_parallel_matches_serial);
+    RUN(test_malformed_streams_rejected);
+    printf("[PASS] All chunk_lz tests passed\n");
+    return 0;
+}
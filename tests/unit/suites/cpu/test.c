@@ -276,20 +276,21 @@ static bool init_test_memory(void) {
     // This makes the full 24-bit address space accessible
     if (g_page_table) {
         for (int p = 0; p < (TEST_MEM_SIZE >> PAGE_SHIFT); p++) {
-            g_page_table[p].host_base = test_memory_buffer + (p << PAGE_SHIFT);
-            g_page_table[p].dev = NULL;
-            g_page_table[p].dev_context = NULL;
-            g_page_table[p].writable = true;
+            page_entry_t *pe = memory_page_mut(p);
+            pe->host_base = test_memory_buffer + (p << PAGE_SHIFT);
+            pe->dev = NULL;
+            pe->dev_context = NULL;
+            pe->writable = true;
             // Update SoA fast-path arrays with adjusted base
             uintptr_t adjusted = (uintptr_t)(test_memory_buffer + (p << PAGE_SHIFT)) - ((uint32_t)p << PAGE_SHIFT);
             if (g_supervisor_read)
-                g_supervisor_read[p] = adjusted;
+                memory_soa_set(g_supervisor_read, p, adjusted);
             if (g_supervisor_write)
-                g_supervisor_write[p] = adjusted;
+                memory_soa_set(g_supervisor_write, p, adjusted);
             if (g_user_read)
-                g_user_read[p] = adjusted;
+                memory_soa_set(g_user_read, p, adjusted);
             if (g_user_write)
-                g_user_write[p] = adjusted;
+                memory_soa_set(g_user_write, p, adjusted);
         }
     }
 
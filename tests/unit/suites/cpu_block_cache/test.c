@@ -0,0 +1,260 @@
+// Decoded-page cache (memory.h, cpu_dispatch.h).
+//
+// The table decoder keeps a block per host page it executes from; a warm slot
+// supplies the opcode/extension longword and the OP site without touching
+// memory.  These tests make that visible with host stores that are NOT
+// announced through memory_ram_mark_dirty: a warm slot keeps running the old
+// instruction.  Against that, they check that every legitimate change drops
+// the block before the next fetch: a guest store into the running page, a
+// store reaching the page through another logical alias, an announced host
+// store, and a change of decoder; that a read refill after the SoA tables are
+// flushed keeps the block; and that a page rewritten over and over ends up
+// uncached and still runs correctly.
+//
+// Each test uses its own RAM page, since drop counts are kept per page.
+
+#include "cpu.h"
+#include "cpu_internal.h"
+#include "harness.h"
+#include "memory.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define DATA_ADDR 0x8000u
+#define STACK_TOP 0x9F00u
+
+// Announced host store (drops the page's block)
+static void store_be16(uint8_t *p, uint16_t val) {
+    memory_ram_mark_dirty(p, 2);
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)(val);
+}
+
+// Unannounced host store: bypasses every invalidation path on purpose
+static void poke_be16(uint8_t *p, uint16_t val) {
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)(val);
+}
+
+// Reset the register file and place the CPU in supervisor mode at pc
+static void reset_cpu(cpu_t *cpu, uint32_t pc) {
+    memset(cpu->d, 0, sizeof(cpu->d));
+    memset(cpu->a, 0, sizeof(cpu->a));
+    cpu->a[7] = STACK_TOP;
+    cpu->supervisor = 1;
+    cpu->trace = 0;
+    cpu->interrupt_mask = 7;
+    cpu->pc = pc;
+}
+
+// Run exactly n instructions on the 68000 decoder
+static void run_68000(cpu_t *cpu, uint32_t n) {
+    extern void cpu_run_68000(cpu_t * cpu, uint32_t * instructions);
+    cpu_run_68000(cpu, &n);
+}
+
+// Run exactly n instructions on the 68030 decoder
+static void run_68030(cpu_t *cpu, uint32_t n) {
+    extern void cpu_run_68030(cpu_t * cpu, uint32_t * instructions);
+    cpu_run_68030(cpu, &n);
+}
+
+// Run MOVEQ #?,D1 at pc on the 68000 and return D1
+static uint32_t run_moveq(cpu_t *cpu, uint32_t pc) {
+    reset_cpu(cpu, pc);
+    run_68000(cpu, 1);
+    ASSERT_EQ_INT((int)cpu->pc, (int)pc + 2);
+    return cpu->d[1];
+}
+
+// Slot of the block for the RAM page holding addr (NULL if none or cold)
+static const void *block_site(uint32_t addr) {
+    code_block_t *block = g_code_blocks[addr >> PAGE_SHIFT];
+    return block ? block->site[(addr & PAGE_MASK) >> 1] : NULL;
+}
+
+TEST(warm_slot_skips_fetch) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    store_be16(ram + 0x1000, 0x7201); // MOVEQ #1,D1
+    uint32_t d1 = run_moveq(cpu, 0x1000);
+    ASSERT_EQ_INT(1, (int)d1);
+    ASSERT_TRUE(block_site(0x1000) != NULL);
+
+    // The warm slot still holds MOVEQ #1 ...
+    poke_be16(ram + 0x1000, 0x7209);
+    d1 = run_moveq(cpu, 0x1000);
+    ASSERT_EQ_INT(1, (int)d1);
+
+    // ... until the store is announced
+    memory_ram_mark_dirty(ram + 0x1000, 2);
+    ASSERT_TRUE(g_code_blocks[1] == NULL);
+    d1 = run_moveq(cpu, 0x1000);
+    ASSERT_EQ_INT(9, (int)d1);
+}
+
+TEST(guest_store_drops_running_page) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // MOVE.W #$7205,$2008.W ; NOP ; MOVEQ #1,D1
+    store_be16(ram + 0x2000, 0x31FC);
+    store_be16(ram + 0x2002, 0x7205);
+    store_be16(ram + 0x2004, 0x2008);
+    store_be16(ram + 0x2006, 0x4E71);
+    store_be16(ram + 0x2008, 0x7201);
+
+    // Warm the slots at $2006 and $2008
+    reset_cpu(cpu, 0x2006);
+    run_68000(cpu, 2);
+    ASSERT_EQ_INT(1, (int)cpu->d[1]);
+    ASSERT_TRUE(block_site(0x2008) != NULL);
+
+    // The store two instructions earlier rewrites the warm slot
+    reset_cpu(cpu, 0x2000);
+    run_68000(cpu, 3);
+    ASSERT_EQ_INT(5, (int)cpu->d[1]);
+    ASSERT_EQ_INT(0x7205, (int)memory_read_uint16(0x2008));
+}
+
+TEST(aliases_share_one_block) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // Guest page 9 reads host RAM page 3
+    uintptr_t saved = memory_soa_get(g_supervisor_read, 9);
+    memory_soa_set(g_supervisor_read, 9, (uintptr_t)(ram + 0x3000) - 0x9000);
+    memory_code_window_flush();
+
+    store_be16(ram + 0x3000, 0x7201);
+    uint32_t d1 = run_moveq(cpu, 0x3000);
+    ASSERT_EQ_INT(1, (int)d1);
+
+    // Warmed through page 3, served through page 9 from the same block
+    poke_be16(ram + 0x3000, 0x7209);
+    d1 = run_moveq(cpu, 0x9000);
+    ASSERT_EQ_INT(1, (int)d1);
+    ASSERT_TRUE(g_code_blocks[9] == NULL);
+
+    // A guest store through page 3 drops it for page 9 too
+    memory_write_uint16(0x3000, 0x7203);
+    d1 = run_moveq(cpu, 0x9000);
+    ASSERT_EQ_INT(3, (int)d1);
+
+    memory_soa_set(g_supervisor_read, 9, saved);
+    memory_code_window_flush();
+}
+
+TEST(read_refill_keeps_block) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    store_be16(ram + 0x4000, 0x7201);
+    uint32_t d1 = run_moveq(cpu, 0x4000);
+    ASSERT_EQ_INT(1, (int)d1);
+
+    // Flush every SoA table, as a TLB invalidation does.  The fetch refills
+    // the page by a read, which must not reinstall its write entries.
+    memory_code_window_flush();
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_clear(g_supervisor_write);
+    memory_soa_clear(g_user_read);
+    memory_soa_clear(g_user_write);
+    d1 = run_moveq(cpu, 0x4000);
+    ASSERT_EQ_INT(1, (int)d1);
+    ASSERT_EQ_INT(0, (int)memory_soa_get(g_supervisor_write, 4));
+    poke_be16(ram + 0x4000, 0x7209);
+    d1 = run_moveq(cpu, 0x4000);
+    ASSERT_EQ_INT(1, (int)d1);
+
+    // The first guest store still takes the slow path and drops the block
+    memory_write_uint16(0x4000, 0x7204);
+    d1 = run_moveq(cpu, 0x4000);
+    ASSERT_EQ_INT(4, (int)d1);
+}
+
+TEST(moves_slot_keeps_extension_word) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    uint32_t saved_model = cpu->cpu_model;
+    cpu->cpu_model = CPU_MODEL_68030;
+
+    // MOVES.L D0,(A0): the opcode table never caches MOVES, a block slot does
+    store_be16(ram + 0x5000, 0x0E90);
+    store_be16(ram + 0x5002, 0x0800);
+    for (int i = 0; i < 2; i++) {
+        memory_write_uint32(DATA_ADDR, 0);
+        reset_cpu(cpu, 0x5000);
+        cpu->a[0] = DATA_ADDR;
+        cpu->d[0] = 0x12345678;
+        run_68030(cpu, 1);
+        ASSERT_EQ_INT(0x12345678, (int)memory_read_uint32(DATA_ADDR));
+    }
+    ASSERT_TRUE(block_site(0x5000) != NULL);
+
+    // A new extension word (MOVES.L (A0),D1) reaches the other OP site
+    store_be16(ram + 0x5002, 0x1000);
+    memory_write_uint32(DATA_ADDR, 0xCAFEF00D);
+    reset_cpu(cpu, 0x5000);
+    cpu->a[0] = DATA_ADDR;
+    run_68030(cpu, 1);
+    ASSERT_EQ_INT((int)0xCAFEF00Du, (int)cpu->d[1]);
+    ASSERT_EQ_INT(0x5004, (int)cpu->pc);
+
+    cpu->cpu_model = saved_model;
+}
+
+TEST(decoder_switch_drops_blocks) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    uint32_t saved_model = cpu->cpu_model;
+
+    store_be16(ram + 0x6000, 0x7201);
+    uint32_t d1 = run_moveq(cpu, 0x6000);
+    ASSERT_EQ_INT(1, (int)d1);
+    poke_be16(ram + 0x6000, 0x7206);
+
+    // The 68030 cannot use the 68000's entry points
+    cpu->cpu_model = CPU_MODEL_68030;
+    reset_cpu(cpu, 0x6000);
+    run_68030(cpu, 1);
+    ASSERT_EQ_INT(6, (int)cpu->d[1]);
+    cpu->cpu_model = saved_model;
+}
+
+TEST(rewritten_page_falls_back_to_table) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+
+    // Every guest store drops the block; past CODE_BLOCK_MAX_DROPS the page
+    // runs uncached, and the fresh word is still fetched every time
+    for (int i = 0; i < CODE_BLOCK_MAX_DROPS + 4; i++) {
+        memory_write_uint16(0x7000, (uint16_t)(0x7200 | i));
+        uint32_t d1 = run_moveq(cpu, 0x7000);
+        ASSERT_EQ_INT(i, (int)d1);
+        d1 = run_moveq(cpu, 0x7000);
+        ASSERT_EQ_INT(i, (int)d1);
+    }
+    ASSERT_TRUE(g_code_blocks[7] == NULL);
+}
+
+int main(void) {
+    test_context_t *ctx = test_harness_init();
+    if (!ctx) {
+        fprintf(stderr, "Failed to initialize test harness\n");
+        return 1;
+    }
+
+    RUN(warm_slot_skips_fetch);
+    RUN(guest_store_drops_running_page);
+    RUN(aliases_share_one_block);
+    RUN(read_refill_keeps_block);
+    RUN(moves_slot_keeps_extension_word);
+    RUN(decoder_switch_drops_blocks);
+    RUN(rewritten_page_falls_back_to_table);
+
+    test_harness_destroy(ctx);
+    return 0;
+}
@@ -0,0 +1,155 @@
+// Instruction-fetch code window (memory.h).
+//
+// Instruction fetches reuse the SoA base of the current code page until the
+// PC leaves the page, g_active_read switches, or an SoA writer drops the
+// window.  These tests alias pages in the SoA tables so that a stale window
+// would fetch different code than a fresh lookup, and check that crossing a
+// page, a supervisor-to-user switch and a logpoint install each take effect
+// on the very next fetch.
+
+#include "cpu.h"
+#include "cpu_internal.h"
+#include "harness.h"
+#include "memory.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CODE_BASE 0x1000u
+#define STACK_TOP 0x9F00u
+
+// Host stores into guest RAM are announced like any other store that bypasses
+// the write tables, so a decoded block of the page is dropped (memory.h)
+static void store_be16(uint8_t *p, uint16_t val) {
+    memory_ram_mark_dirty(p, 2);
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)(val);
+}
+
+// Reset the register file and place the CPU in supervisor mode at pc
+static void reset_cpu(cpu_t *cpu, uint32_t pc) {
+    memset(cpu->d, 0, sizeof(cpu->d));
+    memset(cpu->a, 0, sizeof(cpu->a));
+    cpu->a[7] = STACK_TOP;
+    cpu->supervisor = 1;
+    cpu->trace = 0;
+    cpu->interrupt_mask = 7;
+    cpu->pc = pc;
+}
+
+// Run exactly n instructions on the 68000 decoder
+static void run_68000(cpu_t *cpu, uint32_t n) {
+    extern void cpu_run_68000(cpu_t * cpu, uint32_t * instructions);
+    cpu_run_68000(cpu, &n);
+}
+
+// SoA entry that makes guest page `page` read host RAM at guest page `target`
+static uintptr_t alias_entry(uint8_t *ram, uint32_t page, uint32_t target) {
+    return (uintptr_t)(ram + (target << PAGE_SHIFT)) - (page << PAGE_SHIFT);
+}
+
+TEST(page_crossing_refills_window) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // MOVEQ #1,D0 ; MOVEQ #2,D1 at the end of page 1, MOVEQ #3,D2 at $2000.
+    // Page 2 is aliased to RAM page 5, which holds MOVEQ #5,D2 instead.
+    store_be16(ram + 0x1FFC, 0x7001);
+    store_be16(ram + 0x1FFE, 0x7202);
+    store_be16(ram + 0x2000, 0x7403);
+    store_be16(ram + 0x5000, 0x7405);
+    uintptr_t saved = memory_soa_get(g_supervisor_read, 2);
+    memory_soa_set(g_supervisor_read, 2, alias_entry(ram, 2, 5));
+
+    reset_cpu(cpu, 0x1FFC);
+    run_68000(cpu, 3);
+    ASSERT_EQ_INT((int)cpu->d[0], 1);
+    ASSERT_EQ_INT((int)cpu->d[1], 2);
+    ASSERT_EQ_INT((int)cpu->d[2], 5);
+
+    memory_soa_set(g_supervisor_read, 2, saved);
+    memory_code_window_flush();
+}
+
+TEST(long_fetch_straddling_page) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // MOVE.L #$12345678,D3 with the immediate split across $3000 ; NOP
+    store_be16(ram + 0x2FFC, 0x263C);
+    store_be16(ram + 0x2FFE, 0x1234);
+    store_be16(ram + 0x3000, 0x5678);
+    store_be16(ram + 0x3002, 0x4E71);
+
+    for (int i = 0; i < 2; i++) {
+        reset_cpu(cpu, 0x2FFC);
+        run_68000(cpu, 2);
+        ASSERT_EQ_INT((int)cpu->d[3], 0x12345678);
+        ASSERT_EQ_INT((int)cpu->pc, 0x3004);
+    }
+}
+
+TEST(user_switch_uses_user_table) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // MOVE #$0000,SR drops to user mode; the next instruction is MOVEQ #1,D0
+    // in the supervisor view and MOVEQ #7,D0 in the user view (page 6).
+    store_be16(ram + CODE_BASE + 0, 0x46FC);
+    store_be16(ram + CODE_BASE + 2, 0x0000);
+    store_be16(ram + CODE_BASE + 4, 0x7001);
+    store_be16(ram + 0x6004, 0x7007);
+    uintptr_t saved = memory_soa_get(g_user_read, 1);
+    memory_soa_set(g_user_read, 1, alias_entry(ram, 1, 6));
+
+    reset_cpu(cpu, CODE_BASE);
+    run_68000(cpu, 2);
+    ASSERT_EQ_INT((int)cpu->supervisor, 0);
+    ASSERT_EQ_INT((int)cpu->d[0], 7);
+
+    memory_soa_set(g_user_read, 1, saved);
+    g_active_read = g_supervisor_read;
+    g_active_write = g_supervisor_write;
+    memory_code_window_flush();
+}
+
+TEST(logpoint_install_drops_window) {
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    store_be16(ram + CODE_BASE, 0x4E71);
+
+    // Two fetches from a mapped page: the second is served by the window
+    memory_code_window_flush();
+    uint64_t slow = g_mem_slowpath_count;
+    ASSERT_EQ_INT(memory_fetch_uint16(CODE_BASE), 0x4E71);
+    ASSERT_EQ_INT(memory_fetch_uint16(CODE_BASE + 2), 0);
+    ASSERT_EQ_INT((int)g_code_page, (int)(CODE_BASE >> PAGE_SHIFT));
+    ASSERT_TRUE(g_mem_slowpath_count == slow);
+
+    // A logpoint zeroes the SoA entry: the window must not outlive it
+    memory_logpoint_install(CODE_BASE >> PAGE_SHIFT, CODE_BASE >> PAGE_SHIFT);
+    ASSERT_TRUE(g_code_page == CODE_PAGE_NONE);
+    ASSERT_EQ_INT(memory_fetch_uint16(CODE_BASE), 0x4E71);
+    ASSERT_TRUE(g_mem_slowpath_count == slow + 1);
+
+    // Uninstall rebuilds the entry; fetches are back on the fast path
+    memory_logpoint_uninstall(CODE_BASE >> PAGE_SHIFT, CODE_BASE >> PAGE_SHIFT);
+    ASSERT_EQ_INT(memory_fetch_uint16(CODE_BASE), 0x4E71);
+    ASSERT_TRUE(g_mem_slowpath_count == slow + 1);
+}
+
+int main(void) {
+    test_context_t *ctx = test_harness_init();
+    if (!ctx) {
+        fprintf(stderr, "Failed to initialize test harness\n");
+        return 1;
+    }
+
+    RUN(page_crossing_refills_window);
+    RUN(long_fetch_straddling_page);
+    RUN(user_switch_uses_user_table);
+    RUN(logpoint_install_drops_window);
+
+    test_harness_destroy(ctx);
+    return 0;
+}
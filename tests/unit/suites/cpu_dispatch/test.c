@@ -0,0 +1,191 @@
+// Table-driven opcode dispatch (cpu_dispatch.h, default back end).
+//
+// Each decoder fills a 64K-entry table with the OP site every opcode word
+// decodes to, the first time that opcode executes, and jumps through it from
+// then on.  A warm entry skips the whole decode tree, so these tests pin down
+// what must not be decided there: the model (each decoder keeps its own
+// table), the privilege level and the instruction address (entries are keyed
+// by opcode alone), and the extension word (MOVES never gets an entry).
+
+#include "cpu.h"
+#include "cpu_internal.h"
+#include "harness.h"
+#include "memory.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CODE_BASE    0x1000u
+#define CODE_ALT     0x3000u
+#define HANDLER_ADDR 0x2000u
+#define DATA_ADDR    0x8000u
+#define STACK_TOP    0x9F00u
+
+// Host stores into guest RAM are announced like any other store that bypasses
+// the write tables, so a decoded block of the page is dropped (memory.h)
+static void store_be16(uint8_t *p, uint16_t val) {
+    memory_ram_mark_dirty(p, 2);
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)(val);
+}
+
+static void store_be32(uint8_t *p, uint32_t val) {
+    memory_ram_mark_dirty(p, 4);
+    p[0] = (uint8_t)(val >> 24);
+    p[1] = (uint8_t)(val >> 16);
+    p[2] = (uint8_t)(val >> 8);
+    p[3] = (uint8_t)(val);
+}
+
+// Exception vectors used below (vector number * 4)
+#define VEC_ILLEGAL   0x10u
+#define VEC_PRIVILEGE 0x20u
+// Reset the register file and place the CPU in supervisor mode at pc
+static void reset_cpu(cpu_t *cpu, uint32_t pc) {
+    memset(cpu->d, 0, sizeof(cpu->d));
+    memset(cpu->a, 0, sizeof(cpu->a));
+    cpu->a[7] = STACK_TOP;
+    cpu->supervisor = 1;
+    cpu->trace = 0;
+    cpu->interrupt_mask = 7;
+    cpu->pc = pc;
+}
+
+// Run exactly n instructions on the 68000 decoder
+static void run_68000(cpu_t *cpu, uint32_t n) {
+    extern void cpu_run_68000(cpu_t * cpu, uint32_t * instructions);
+    cpu_run_68000(cpu, &n);
+}
+
+// Run exactly n instructions on the 68030 decoder
+static void run_68030(cpu_t *cpu, uint32_t n) {
+    extern void cpu_run_68030(cpu_t * cpu, uint32_t * instructions);
+    cpu_run_68030(cpu, &n);
+}
+
+TEST(tables_are_per_decoder) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    uint32_t saved_model = cpu->cpu_model;
+
+    // EXTB.L D0 is a 68020+ instruction; the 68000 decodes the same word as
+    // an illegal LEA D0,A4
+    store_be16(ram + CODE_BASE, 0x49C0);
+    store_be32(ram + VEC_ILLEGAL, HANDLER_ADDR);
+    store_be16(ram + HANDLER_ADDR, 0x4E71);
+
+    for (int i = 0; i < 2; i++) {
+        cpu->cpu_model = CPU_MODEL_68030;
+        reset_cpu(cpu, CODE_BASE);
+        cpu->d[0] = 0x12345680;
+        run_68030(cpu, 1);
+        ASSERT_EQ_INT((int)cpu->d[0], (int)0xFFFFFF80u);
+        ASSERT_EQ_INT((int)cpu->pc, CODE_BASE + 2);
+
+        cpu->cpu_model = saved_model;
+        reset_cpu(cpu, CODE_BASE);
+        cpu->d[0] = 0x12345680;
+        run_68000(cpu, 1);
+        ASSERT_EQ_INT((int)cpu->pc, HANDLER_ADDR);
+        ASSERT_EQ_INT((int)cpu->d[0], 0x12345680);
+    }
+}
+
+TEST(privilege_checked_after_entry_is_warm) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // MOVE #$2700,SR: warm the entry in supervisor mode
+    store_be16(ram + CODE_BASE + 0, 0x46FC);
+    store_be16(ram + CODE_BASE + 2, 0x2700);
+    store_be32(ram + VEC_PRIVILEGE, HANDLER_ADDR);
+    store_be16(ram + HANDLER_ADDR, 0x4E71);
+    for (int i = 0; i < 2; i++) {
+        reset_cpu(cpu, CODE_BASE);
+        run_68000(cpu, 1);
+        ASSERT_EQ_INT((int)cpu->pc, CODE_BASE + 4);
+    }
+
+    // The same opcode from user mode takes the privilege violation
+    reset_cpu(cpu, CODE_BASE);
+    cpu->usp = STACK_TOP - 0x100;
+    cpu->ssp = STACK_TOP;
+    cpu->supervisor = 0;
+    cpu->a[7] = cpu->usp;
+    run_68000(cpu, 1);
+    ASSERT_EQ_INT((int)cpu->pc, HANDLER_ADDR);
+    ASSERT_TRUE(cpu->supervisor);
+    ASSERT_EQ_INT((int)memory_read_uint32(STACK_TOP - 4), CODE_BASE);
+}
+
+TEST(entry_shared_across_addresses_and_rewrites) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // ADDQ.L #1,D0 warmed at one address runs from another: the table is
+    // keyed by opcode, so no per-address state can go stale
+    store_be16(ram + CODE_BASE, 0x5280);
+    store_be16(ram + CODE_ALT, 0x5280);
+    reset_cpu(cpu, CODE_BASE);
+    run_68000(cpu, 1);
+    reset_cpu(cpu, CODE_ALT);
+    cpu->d[0] = 41;
+    run_68000(cpu, 1);
+    ASSERT_EQ_INT((int)cpu->d[0], 42);
+    ASSERT_EQ_INT((int)cpu->pc, CODE_ALT + 2);
+
+    // Rewriting the warm address dispatches on the new opcode word
+    memory_write_uint16(CODE_BASE, 0x4680); // NOT.L D0
+    reset_cpu(cpu, CODE_BASE);
+    cpu->d[0] = 0x0F0F0F0F;
+    run_68000(cpu, 1);
+    ASSERT_EQ_INT((int)cpu->d[0], (int)0xF0F0F0F0u);
+}
+
+TEST(moves_dispatches_on_extension_word) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    uint32_t saved_model = cpu->cpu_model;
+    cpu->cpu_model = CPU_MODEL_68030;
+
+    // Alternate MOVES.L D0,(A0) (0x0E90 0x0800) and MOVES.L (A0),D1
+    // (0x0E90 0x1000): one opcode word, two OP sites.
+    store_be16(ram + CODE_BASE + 0, 0x0E90);
+    store_be16(ram + CODE_BASE + 4, 0x4E71);
+    for (int i = 0; i < 3; i++) {
+        store_be16(ram + CODE_BASE + 2, 0x0800);
+        store_be32(ram + DATA_ADDR, 0);
+        reset_cpu(cpu, CODE_BASE);
+        cpu->a[0] = DATA_ADDR;
+        cpu->d[0] = 0x12345678;
+        run_68030(cpu, 1);
+        ASSERT_EQ_INT((int)memory_read_uint32(DATA_ADDR), 0x12345678);
+
+        store_be16(ram + CODE_BASE + 2, 0x1000);
+        store_be32(ram + DATA_ADDR, 0xCAFEF00D);
+        reset_cpu(cpu, CODE_BASE);
+        cpu->a[0] = DATA_ADDR;
+        run_68030(cpu, 1);
+        ASSERT_EQ_INT((int)cpu->d[1], (int)0xCAFEF00Du);
+        ASSERT_EQ_INT((int)cpu->pc, CODE_BASE + 4);
+    }
+
+    cpu->cpu_model = saved_model;
+}
+
+int main(void) {
+    test_context_t *ctx = test_harness_init();
+    if (!ctx) {
+        fprintf(stderr, "Failed to initialize test harness\n");
+        return 1;
+    }
+
+    RUN(tables_are_per_decoder);
+    RUN(privilege_checked_after_entry_is_warm);
+    RUN(entry_shared_across_addresses_and_rewrites);
+    RUN(moves_dispatches_on_extension_word);
+
+    test_harness_destroy(ctx);
+    return 0;
+}
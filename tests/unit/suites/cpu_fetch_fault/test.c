@@ -42,7 +42,10 @@
 #define LEVEL_A_BASE 0x10000u
 #define LEVEL_B_BASE 0x11000u
 
+// Host stores into guest RAM are announced like any other store that bypasses
+// the write tables, so a decoded block of the page is dropped (memory.h)
 static void store_be32(uint8_t *p, uint32_t val) {
+    memory_ram_mark_dirty(p, 4);
     p[0] = (uint8_t)(val >> 24);
     p[1] = (uint8_t)(val >> 16);
     p[2] = (uint8_t)(val >> 8);
@@ -50,6 +53,7 @@ static void store_be32(uint8_t *p, uint32_t val) {
 }
 
 static void store_be16(uint8_t *p, uint16_t val) {
+    memory_ram_mark_dirty(p, 2);
     p[0] = (uint8_t)(val >> 8);
     p[1] = (uint8_t)(val);
 }
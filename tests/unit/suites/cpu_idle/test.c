@@ -0,0 +1,135 @@
+// Idle-loop detection (cpu_idle_mark / cpu_idle_step in cpu.c).
+//
+// The scheduler single-steps a candidate loop from a mark and fast-forwards
+// it once cpu_idle_step reports CPU_IDLE_LOOP.  These tests check that a
+// flag-polling loop is recognised after exactly one pass, and that loops
+// which store to memory, touch the slow path, or change a register each pass
+// are never reported as idle.
+
+#include "cpu.h"
+#include "cpu_internal.h"
+#include "harness.h"
+#include "memory.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CODE_BASE 0x1000u
+#define FLAG_ADDR 0x8000u
+#define STACK_TOP 0x9F00u
+
+// Host stores into guest RAM are announced like any other store that bypasses
+// the write tables, so a decoded block of the page is dropped (memory.h)
+static void store_be16(uint8_t *p, uint16_t val) {
+    memory_ram_mark_dirty(p, 2);
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)(val);
+}
+
+// Reset the register file and place the CPU in supervisor mode at pc
+static void reset_cpu(cpu_t *cpu, uint32_t pc) {
+    memset(cpu->d, 0, sizeof(cpu->d));
+    memset(cpu->a, 0, sizeof(cpu->a));
+    cpu->a[7] = STACK_TOP;
+    cpu->supervisor = 1;
+    cpu->trace = 0;
+    cpu->interrupt_mask = 7;
+    cpu->pc = pc;
+}
+
+// Mark, then single-step up to max_steps; returns the step count at which
+// the loop was confirmed, or -1 if the detector gave up
+static int probe(cpu_t *cpu, int max_steps) {
+    if (cpu_idle_mark(cpu) == CPU_IDLE_NO)
+        return -1;
+    for (int i = 1; i <= max_steps; i++) {
+        uint32_t one = 1;
+        cpu_run_sprint(cpu, &one);
+        cpu_idle_t r = cpu_idle_step(cpu);
+        if (r == CPU_IDLE_LOOP)
+            return i;
+        if (r == CPU_IDLE_NO)
+            return -1;
+    }
+    return -1;
+}
+
+TEST(flag_poll_loop_is_idle) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // loop: MOVE.W (A0),D0 ; CMP.W D1,D0 ; BNE.S loop
+    store_be16(ram + CODE_BASE + 0, 0x3010);
+    store_be16(ram + CODE_BASE + 2, 0xB041);
+    store_be16(ram + CODE_BASE + 4, 0x66FA);
+    store_be16(ram + FLAG_ADDR, 0x0000);
+
+    reset_cpu(cpu, CODE_BASE);
+    cpu->a[0] = FLAG_ADDR;
+    cpu->d[1] = 1;
+    // First pass settles D0/flags; the next one is a fixed point
+    uint32_t n = 3;
+    cpu_run_sprint(cpu, &n);
+    ASSERT_EQ_INT(probe(cpu, 32), 3);
+    ASSERT_EQ_INT((int)cpu->pc, CODE_BASE);
+}
+
+TEST(storing_loop_is_not_idle) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // loop: TST.W (A0) ; CLR.W (A0) ; BEQ.S loop — registers repeat, memory is written
+    store_be16(ram + CODE_BASE + 0, 0x4A50);
+    store_be16(ram + CODE_BASE + 2, 0x4250);
+    store_be16(ram + CODE_BASE + 4, 0x67FA);
+
+    reset_cpu(cpu, CODE_BASE);
+    cpu->a[0] = FLAG_ADDR;
+    uint32_t n = 3;
+    cpu_run_sprint(cpu, &n);
+    ASSERT_EQ_INT(probe(cpu, 32), -1);
+}
+
+TEST(slow_path_read_is_not_idle) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // loop: TST.B (A0) ; BRA.S loop — A0 points outside RAM (slow path)
+    store_be16(ram + CODE_BASE + 0, 0x4A10);
+    store_be16(ram + CODE_BASE + 2, 0x60FC);
+
+    reset_cpu(cpu, CODE_BASE);
+    cpu->a[0] = 0x00F00000;
+    ASSERT_EQ_INT(probe(cpu, 32), -1);
+}
+
+TEST(counting_loop_is_not_idle) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+
+    // loop: DBF D0,loop — D0 changes every pass
+    store_be16(ram + CODE_BASE + 0, 0x51C8);
+    store_be16(ram + CODE_BASE + 2, 0xFFFE);
+
+    reset_cpu(cpu, CODE_BASE);
+    cpu->d[0] = 1000;
+    ASSERT_EQ_INT(probe(cpu, 32), -1);
+    ASSERT_EQ_INT((int)(cpu->d[0] & 0xFFFF), 1000 - 32);
+}
+
+int main(void) {
+    test_context_t *ctx = test_harness_init();
+    if (!ctx) {
+        fprintf(stderr, "Failed to initialize test harness\n");
+        return 1;
+    }
+
+    RUN(flag_poll_loop_is_idle);
+    RUN(storing_loop_is_not_idle);
+    RUN(slow_path_read_is_not_idle);
+    RUN(counting_loop_is_not_idle);
+
+    test_harness_destroy(ctx);
+    return 0;
+}
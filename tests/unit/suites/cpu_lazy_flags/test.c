@@ -0,0 +1,199 @@
+// Lazy condition codes (GS_LAZY_FLAGS, see cpu_internal.h).
+//
+// The suite is built with -DGS_LAZY_FLAGS so ADD/SUB/CMP and the MOVE/TST
+// family only record their operands.  Each test runs a short 68000 sequence
+// and checks the flags where the guest consumes them (MOVE from SR, Scc,
+// Bcc, ADDX) and where the host does (struct cpu after the sprint), against
+// values worked out by hand from the M68000PRM — the same values the eager
+// build produces.
+
+#include "cpu.h"
+#include "cpu_internal.h"
+#include "harness.h"
+#include "memory.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CODE_BASE 0x1000u
+#define STACK_TOP 0x9F00u
+
+// Supervisor, interrupt mask 7
+#define SR_SYSTEM 0x2700
+
+// Host stores into guest RAM are announced like any other store that bypasses
+// the write tables, so a decoded block of the page is dropped (memory.h)
+static void store_be16(uint8_t *p, uint16_t val) {
+    memory_ram_mark_dirty(p, 2);
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)(val);
+}
+
+// Place `count` instruction words at CODE_BASE and reset the CPU to run them
+static cpu_t *load_program(const uint16_t *words, int count) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    for (int i = 0; i < count; i++)
+        store_be16(ram + CODE_BASE + 2 * i, words[i]);
+    memset(cpu->d, 0, sizeof(cpu->d));
+    memset(cpu->a, 0, sizeof(cpu->a));
+    cpu->a[7] = STACK_TOP;
+    cpu->supervisor = 1;
+    cpu->trace = 0;
+    cpu->interrupt_mask = 7;
+    cpu_set_sr(cpu, SR_SYSTEM);
+    cpu->pc = CODE_BASE;
+    return cpu;
+}
+
+// Run exactly n instructions on the 68000 decoder
+static void run(cpu_t *cpu, uint32_t n) {
+    extern void cpu_run_68000(cpu_t * cpu, uint32_t * instructions);
+    cpu_run_68000(cpu, &n);
+}
+
+// Run exactly n instructions on the 68030 decoder
+static void run_68030(cpu_t *cpu, uint32_t n) {
+    extern void cpu_run_68030(cpu_t * cpu, uint32_t * instructions);
+    cpu_run_68030(cpu, &n);
+}
+
+// Flags in struct cpu as 0/1 CCR bits, read without going through read_ccr
+static int raw_ccr(cpu_t *cpu) {
+    return (cpu->extend ? 0x10 : 0) | (cpu->negative ? 0x08 : 0) | (cpu->zero ? 0x04 : 0) |
+           (cpu->overflow ? 0x02 : 0) | (cpu->carry ? 0x01 : 0);
+}
+
+TEST(add_overflow_seen_by_move_sr_and_scc) {
+    // ADDQ.B #1,D0 ; MOVE SR,D1 ; SCS D2 ; SVS D3
+    const uint16_t prog[] = {0x5200, 0x40C1, 0x55C2, 0x59C3};
+    cpu_t *cpu = load_program(prog, 4);
+    cpu->d[0] = 0x7F;
+    run(cpu, 4);
+
+    ASSERT_EQ_INT((int)(cpu->d[0] & 0xFF), 0x80);
+    ASSERT_EQ_INT((int)(cpu->d[1] & 0xFFFF), SR_SYSTEM | 0x0A); // N V
+    ASSERT_EQ_INT((int)(cpu->d[2] & 0xFF), 0x00); // C clear
+    ASSERT_EQ_INT((int)(cpu->d[3] & 0xFF), 0xFF); // V set
+    ASSERT_EQ_INT(raw_ccr(cpu), 0x0A);
+}
+
+TEST(cmp_and_tst_preserve_pending_extend) {
+    // ADDQ.L #1,D0 ; CMP.L D1,D2 ; MOVE SR,D4 ; TST.L D3
+    const uint16_t prog[] = {0x5280, 0xB481, 0x40C4, 0x4A83};
+    cpu_t *cpu = load_program(prog, 4);
+    cpu->d[0] = 0xFFFFFFFF;
+    cpu->d[1] = 1;
+    cpu->d[2] = 5;
+    cpu->d[3] = 0x80000000;
+    run(cpu, 4);
+
+    ASSERT_EQ_INT((int)cpu->d[0], 0);
+    ASSERT_EQ_INT((int)(cpu->d[4] & 0xFFFF), SR_SYSTEM | 0x10); // X from the ADD, CMP clean
+    ASSERT_EQ_INT(raw_ccr(cpu), 0x18); // X N
+    ASSERT_EQ_INT((int)cpu_get_sr(cpu), SR_SYSTEM | 0x18);
+}
+
+TEST(moveq_after_sub_keeps_extend) {
+    // SUBQ.L #1,D0 ; MOVEQ #0,D1
+    const uint16_t prog[] = {0x5380, 0x7200};
+    cpu_t *cpu = load_program(prog, 2);
+    run(cpu, 2);
+
+    ASSERT_EQ_INT((int)cpu->d[0], -1);
+    ASSERT_EQ_INT(raw_ccr(cpu), 0x14); // X Z
+}
+
+TEST(addx_consumes_pending_sub) {
+    // SUBQ.L #1,D0 ; ADDX.L D1,D2
+    const uint16_t prog[] = {0x5380, 0xD581};
+    cpu_t *cpu = load_program(prog, 2);
+    cpu->d[1] = 1;
+    cpu->d[2] = 2;
+    run(cpu, 2);
+
+    ASSERT_EQ_INT((int)cpu->d[2], 4); // 2 + 1 + X
+    ASSERT_EQ_INT(raw_ccr(cpu), 0x00);
+}
+
+TEST(move_to_ccr_discards_pending_record) {
+    // ADDQ.B #1,D0 ; MOVE #0,CCR ; NOP
+    const uint16_t prog[] = {0x5200, 0x44FC, 0x0000, 0x4E71};
+    cpu_t *cpu = load_program(prog, 4);
+    cpu->d[0] = 0x7F;
+    run(cpu, 3);
+
+    ASSERT_EQ_INT(raw_ccr(cpu), 0x00);
+    ASSERT_EQ_INT((int)cpu_get_sr(cpu), SR_SYSTEM);
+}
+
+TEST(branch_on_pending_zero) {
+    // SUBQ.L #1,D0 ; BEQ.S *+4 ; MOVEQ #1,D5 ; MOVEQ #2,D6
+    const uint16_t prog[] = {0x5380, 0x6702, 0x7A01, 0x7C02};
+    cpu_t *cpu = load_program(prog, 4);
+    cpu->d[0] = 1;
+    run(cpu, 3);
+
+    ASSERT_EQ_INT((int)cpu->d[5], 0);
+    ASSERT_EQ_INT((int)cpu->d[6], 2);
+    ASSERT_EQ_INT(raw_ccr(cpu), 0x00);
+}
+
+TEST(word_sizes_use_their_own_sign_bit) {
+    // CMP.W D1,D2 ; MOVE SR,D3 ; SUB.W D1,D2 ; MOVE SR,D4
+    const uint16_t prog[] = {0xB441, 0x40C3, 0x9441, 0x40C4};
+    cpu_t *cpu = load_program(prog, 4);
+    cpu->d[1] = 0x0001;
+    cpu->d[2] = 0x12348000; // 0x8000 - 1 = 0x7FFF: signed overflow, no borrow
+    run(cpu, 4);
+
+    ASSERT_EQ_INT((int)(cpu->d[3] & 0xFFFF), SR_SYSTEM | 0x02); // V
+    ASSERT_EQ_INT((int)(cpu->d[4] & 0xFFFF), SR_SYSTEM | 0x02); // V, X = C = 0
+    ASSERT_EQ_INT((int)cpu->d[2], 0x12347FFF);
+}
+
+TEST(chk_n_survives_pending_cmp_on_68030) {
+    // CMP.L D1,D2 ; CHK.W D3,D0   (vector 6 -> NOP at HANDLER)
+    const uint16_t prog[] = {0xB481, 0x4183};
+    const uint32_t handler = 0x2000;
+    cpu_t *cpu = load_program(prog, 2);
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    store_be16(ram + 6 * 4, (uint16_t)(handler >> 16));
+    store_be16(ram + 6 * 4 + 2, (uint16_t)handler);
+    store_be16(ram + handler, 0x4E71);
+    uint32_t saved_model = cpu->cpu_model;
+    cpu->cpu_model = CPU_MODEL_68030;
+    cpu->d[0] = 0xFFFF; // -1.W: below the lower bound
+    cpu->d[1] = 1;
+    cpu->d[2] = 5; // 5 - 1: CMP leaves N clear in its pending record
+    cpu->d[3] = 10;
+    run_68030(cpu, 2);
+    cpu->cpu_model = saved_model;
+
+    ASSERT_EQ_INT((int)cpu->pc, (int)handler);
+    uint32_t sp = cpu->a[7];
+    int stacked_sr = (ram[sp] << 8) | ram[sp + 1];
+    ASSERT_EQ_INT(stacked_sr, SR_SYSTEM | 0x08); // N from CHK, not the CMP
+    ASSERT_EQ_INT(raw_ccr(cpu), 0x08);
+}
+
+int main(void) {
+    test_context_t *ctx = test_harness_init();
+    if (!ctx) {
+        fprintf(stderr, "Failed to initialize test harness\n");
+        return 1;
+    }
+
+    RUN(add_overflow_seen_by_move_sr_and_scc);
+    RUN(cmp_and_tst_preserve_pending_extend);
+    RUN(moveq_after_sub_keeps_extend);
+    RUN(addx_consumes_pending_sub);
+    RUN(move_to_ccr_discards_pending_record);
+    RUN(branch_on_pending_zero);
+    RUN(word_sizes_use_their_own_sign_bit);
+    RUN(chk_n_survives_pending_cmp_on_68030);
+
+    test_harness_destroy(ctx);
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Debugger PC watch hook in the decoder loop (debug.h).
+//
+// While g_debug_pc_hook is set the decoders call debug_pc_hook before every
+// instruction.  This suite installs its own hook (the stub one is weak) and
+// checks that it sees each executed PC once and in order, that returning
+// true ends the sprint before the instruction runs, and that a clear flag
+// keeps the hook out of the loop entirely.  A 68030 case checks that an MMU
+// flush mid-sprint is visible to the hook's translation cache at once.
+
+#include "cpu.h"
+#include "cpu_internal.h"
+#include "harness.h"
+#include "memory.h"
+#include "mmu.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CODE_BASE 0x1000u
+#define STACK_TOP 0x9F00u
+#define MAX_SEEN  64
+
+static uint32_t g_seen[MAX_SEEN]; // PCs the hook was called with
+static int g_num_seen;
+static uint32_t g_stop_pc = UINT32_MAX; // hook ends the sprint here
+static uint32_t *g_budget; // burndown of the sprint in flight
+
+// Page translation cache keyed like debug.c's physical PC watch
+static bool g_xlate_cache; // hook models the cache
+static uint32_t g_xlate_page;
+static uint32_t g_xlate_gen;
+static int g_num_xlates; // translations the cache had to redo
+
+// Test hook: record the PC; at g_stop_pc close the sprint like cpu_reschedule
+bool debug_pc_hook(uint32_t pc) {
+    if (g_xlate_cache && (pc >> PAGE_SHIFT != g_xlate_page || g_mmu_generation != g_xlate_gen)) {
+        g_xlate_page = pc >> PAGE_SHIFT;
+        g_xlate_gen = g_mmu_generation;
+        g_num_xlates++;
+    }
+    if (pc == g_stop_pc) {
+        *g_budget = 0;
+        return true;
+    }
+    if (g_num_seen < MAX_SEEN)
+        g_seen[g_num_seen++] = pc;
+    return false;
+}
+
+// Host stores into guest RAM are announced like any other store that bypasses
+// the write tables, so a decoded block of the page is dropped (memory.h)
+static void store_be16(uint8_t *p, uint16_t val) {
+    memory_ram_mark_dirty(p, 2);
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)(val);
+}
+
+// MOVEQ #1..#4 into D0..D3, then NOPs; CPU in supervisor mode at CODE_BASE
+static cpu_t *setup(void) {
+    cpu_t *cpu = test_get_cpu(test_get_active_context());
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    store_be16(ram + CODE_BASE + 0, 0x7001);
+    store_be16(ram + CODE_BASE + 2, 0x7202);
+    store_be16(ram + CODE_BASE + 4, 0x7403);
+    store_be16(ram + CODE_BASE + 6, 0x7604);
+    for (uint32_t i = 8; i < 64; i += 2)
+        store_be16(ram + CODE_BASE + i, 0x4E71);
+
+    memset(cpu->d, 0, sizeof(cpu->d));
+    memset(cpu->a, 0, sizeof(cpu->a));
+    cpu->a[7] = STACK_TOP;
+    cpu->supervisor = 1;
+    cpu->trace = 0;
+    cpu->interrupt_mask = 7;
+    cpu->pc = CODE_BASE;
+    g_num_seen = 0;
+    g_stop_pc = UINT32_MAX;
+    return cpu;
+}
+
+// Run one sprint of n instructions; returns the instructions left unexecuted
+static uint32_t sprint(cpu_t *cpu, uint32_t n) {
+    g_budget = &n;
+    cpu_run_sprint(cpu, &n);
+    g_budget = NULL;
+    return n;
+}
+
+TEST(hook_sees_every_pc_in_order) {
+    cpu_t *cpu = setup();
+    g_debug_pc_hook = true;
+    ASSERT_EQ_INT((int)sprint(cpu, 6), 0);
+    g_debug_pc_hook = false;
+
+    ASSERT_EQ_INT(g_num_seen, 6);
+    for (int i = 0; i < 6; i++)
+        ASSERT_EQ_INT((int)g_seen[i], (int)(CODE_BASE + 2 * i));
+    ASSERT_EQ_INT((int)cpu->pc, CODE_BASE + 12);
+}
+
+TEST(hook_stop_ends_sprint_before_instruction) {
+    cpu_t *cpu = setup();
+    g_stop_pc = CODE_BASE + 4;
+    g_debug_pc_hook = true;
+    sprint(cpu, 100);
+    g_debug_pc_hook = false;
+
+    // The first two MOVEQs ran; the third did not
+    ASSERT_EQ_INT((int)cpu->pc, CODE_BASE + 4);
+    ASSERT_EQ_INT((int)cpu->d[0], 1);
+    ASSERT_EQ_INT((int)cpu->d[1], 2);
+    ASSERT_EQ_INT((int)cpu->d[2], 0);
+    ASSERT_EQ_INT(g_num_seen, 2);
+
+    // Resuming past the stop runs the instruction
+    g_stop_pc = UINT32_MAX;
+    g_debug_pc_hook = true;
+    sprint(cpu, 1);
+    g_debug_pc_hook = false;
+    ASSERT_EQ_INT((int)cpu->d[2], 3);
+    ASSERT_EQ_INT((int)g_seen[2], CODE_BASE + 4);
+}
+
+TEST(clear_flag_skips_hook) {
+    cpu_t *cpu = setup();
+    g_stop_pc = CODE_BASE + 2;
+    ASSERT_EQ_INT((int)sprint(cpu, 4), 0);
+    ASSERT_EQ_INT(g_num_seen, 0);
+    ASSERT_EQ_INT((int)cpu->d[3], 4);
+}
+
+TEST(mmu_flush_mid_sprint_drops_cached_translation) {
+    cpu_t *cpu = setup();
+    uint8_t *ram = ram_native_pointer(test_get_memory(test_get_active_context()), 0);
+    store_be16(ram + CODE_BASE + 2, 0xF000); // PFLUSHA
+    store_be16(ram + CODE_BASE + 4, 0x2400);
+    store_be16(ram + CODE_BASE + 6, 0x4E71);
+    mmu_state_t *mmu = mmu_init(ram, 0x400000, 0x400000, NULL, 0, 0, 0);
+    uint32_t saved_model = cpu->cpu_model;
+    cpu->cpu_model = CPU_MODEL_68030;
+    cpu->mmu = mmu;
+
+    g_xlate_page = UINT32_MAX;
+    g_num_xlates = 0;
+    g_xlate_cache = true;
+    g_debug_pc_hook = true;
+    sprint(cpu, 3);
+    g_debug_pc_hook = false;
+    g_xlate_cache = false;
+
+    cpu->mmu = NULL;
+    cpu->cpu_model = saved_model;
+    mmu_delete(mmu);
+
+    // MOVEQ and PFLUSHA share one translation; the NOP after the flush,
+    // still on the same page, has to translate again
+    ASSERT_EQ_INT(g_num_seen, 3);
+    ASSERT_EQ_INT((int)g_seen[2], CODE_BASE + 6);
+    ASSERT_EQ_INT(g_num_xlates, 2);
+}
+
+int main(void) {
+    test_context_t *ctx = test_harness_init();
+    if (!ctx) {
+        fprintf(stderr, "Failed to initialize test harness\n");
+        return 1;
+    }
+
+    RUN(hook_sees_every_pc_in_order);
+    RUN(hook_stop_ends_sprint_before_instruction);
+    RUN(clear_flag_skips_hook);
+    RUN(mmu_flush_mid_sprint_drops_cached_translation);
+
+    test_harness_destroy(ctx);
+    return 0;
+}
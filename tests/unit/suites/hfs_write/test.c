@@ -0,0 +1,549 @@
+// Classic HFS writer unit tests.
+//
+// image_hfs_write.c reaches the disk only through disk_read_data() /
+// disk_write_data(), so both are backed by an in-memory buffer holding a
+// freshly formatted classic HFS volume, and the public API is driven
+// directly.  After every step the catalog and extents B-trees are checked
+// structurally: leaf chain sorted and linked both ways, index keys equal to
+// their child's first key, header record / map / free counts consistent,
+// and the volume bitmap matching drFreeBks.
+//
+// Volume layout (512-byte allocation blocks, drAlBlSt = 4 sectors):
+//   sector 2        MDB
+//   sector 3        volume bitmap
+//   ablocks 0..7    extents overflow B-tree (8 nodes)
+//   ablocks 8..263  catalog B-tree (256 nodes; node 1 = the only leaf)
+//   ablocks 264..   free
+
+#include "image_hfs.h"
+#include "test_assert.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---- In-memory image backing ----------------------------------------------
+
+#define SECT      512u
+#define AL_BL_ST  4u
+#define N_AB      4000u
+#define EXT_START 0u
+#define EXT_NODES 8u
+#define CAT_START 8u
+#define CAT_NODES 256u
+#define FIRST_FREE (CAT_START + CAT_NODES)
+#define IMG_SIZE  ((AL_BL_ST + N_AB) * SECT)
+#define MDB       1024u
+
+static uint8_t g_img[IMG_SIZE];
+static image_t *const DUMMY = (image_t *)1;
+
+size_t disk_read_data(image_t *disk, size_t offset, uint8_t *buf, size_t size) {
+    (void)disk;
+    if (offset % 512 || size % 512 || offset + size > IMG_SIZE)
+        return 0;
+    memcpy(buf, g_img + offset, size);
+    return size;
+}
+
+size_t disk_write_data(image_t *disk, size_t offset, uint8_t *buf, size_t size) {
+    (void)disk;
+    if (offset % 512 || size % 512 || offset + size > IMG_SIZE)
+        return 0;
+    memcpy(g_img + offset, buf, size);
+    return size;
+}
+
+// ---- Big-endian access ------------------------------------------------------
+
+static void w16(size_t off, uint32_t v) {
+    g_img[off] = (uint8_t)(v >> 8);
+    g_img[off + 1] = (uint8_t)v;
+}
+static void w32(size_t off, uint32_t v) {
+    w16(off, v >> 16);
+    w16(off + 2, v & 0xFFFF);
+}
+static uint32_t r16(const uint8_t *p) {
+    return (uint32_t)(p[0] << 8 | p[1]);
+}
+static uint32_t r32(const uint8_t *p) {
+    return r16(p) << 16 | r16(p + 2);
+}
+
+// ---- Fixture builder -------------------------------------------------------
+
+// Byte offset of node `idx` of a tree starting at allocation block `start`.
+static size_t node_off(uint32_t start, uint32_t idx) {
+    return (AL_BL_ST + start + idx) * SECT;
+}
+
+// Header node: header record, 128-byte user record, 256-byte map record with
+// the first `used` nodes marked.
+static void build_header_node(uint32_t start, uint32_t depth, uint32_t root, uint32_t nrecs, uint32_t leaf,
+                              uint32_t max_key, uint32_t total, uint32_t used) {
+    size_t n = node_off(start, 0);
+    g_img[n + 8] = 1; // kind = header
+    w16(n + 10, 3);
+    w16(n + 14 + 0, depth);
+    w32(n + 14 + 2, root);
+    w32(n + 14 + 6, nrecs);
+    w32(n + 14 + 10, leaf);
+    w32(n + 14 + 14, leaf);
+    w16(n + 14 + 18, 512);
+    w16(n + 14 + 20, max_key);
+    w32(n + 14 + 22, total);
+    w32(n + 14 + 26, total - used);
+    w16(n + 510, 14);
+    w16(n + 508, 120);
+    w16(n + 506, 248);
+    w16(n + 504, 504);
+    for (uint32_t i = 0; i < used; i++)
+        g_img[n + 248 + i / 8] |= (uint8_t)(0x80 >> (i % 8));
+}
+
+// Format an empty volume named "TestVol".
+static void build_volume(void) {
+    memset(g_img, 0, sizeof(g_img));
+    w16(MDB + 0, 0x4244); // "BD"
+    w16(MDB + 10, 0x0100); // cleanly unmounted
+    w16(MDB + 14, 3); // drVBMSt
+    w16(MDB + 18, N_AB);
+    w32(MDB + 20, 512);
+    w32(MDB + 24, 2048);
+    w16(MDB + 28, AL_BL_ST);
+    w32(MDB + 30, 16); // drNxtCNID
+    w16(MDB + 34, N_AB - FIRST_FREE);
+    g_img[MDB + 36] = 7;
+    memcpy(g_img + MDB + 37, "TestVol", 7);
+    w32(MDB + 130, EXT_NODES * 512);
+    w16(MDB + 134, EXT_START);
+    w16(MDB + 136, EXT_NODES);
+    w32(MDB + 146, CAT_NODES * 512);
+    w16(MDB + 150, CAT_START);
+    w16(MDB + 152, CAT_NODES);
+    for (uint32_t i = 0; i < FIRST_FREE; i++)
+        g_img[3 * SECT + i / 8] |= (uint8_t)(0x80 >> (i % 8));
+
+    build_header_node(EXT_START, 0, 0, 0, 0, 7, EXT_NODES, 1);
+    build_header_node(CAT_START, 1, 1, 2, 1, 37, CAT_NODES, 2);
+
+    // Catalog leaf: root folder record (1, "TestVol") and its thread (2, "")
+    size_t n = node_off(CAT_START, 1);
+    g_img[n + 8] = 0xFF;
+    g_img[n + 9] = 1;
+    w16(n + 10, 2);
+    size_t p = n + 14;
+    g_img[p] = 13;
+    w32(p + 2, 1);
+    g_img[p + 6] = 7;
+    memcpy(g_img + p + 7, "TestVol", 7);
+    g_img[p + 14] = 1; // folder
+    w32(p + 14 + 6, 2); // dirID
+    p += 14 + 70;
+    g_img[p] = 6;
+    w32(p + 2, 2);
+    g_img[p + 8] = 3; // folder thread
+    w32(p + 8 + 10, 1);
+    g_img[p + 8 + 14] = 7;
+    memcpy(g_img + p + 8 + 15, "TestVol", 7);
+    w16(n + 510, 14);
+    w16(n + 508, 98);
+    w16(n + 506, 152);
+}
+
+// ---- Structural checks -----------------------------------------------------
+
+static int fold(uint8_t c) {
+    return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
+// Key order for ASCII names (the writer's order restricted to ASCII).
+static int cat_cmp(const uint8_t *a, const uint8_t *b) {
+    if (r32(a + 2) != r32(b + 2))
+        return r32(a + 2) < r32(b + 2) ? -1 : 1;
+    for (int i = 0; i < a[6] && i < b[6]; i++) {
+        if (fold(a[7 + i]) != fold(b[7 + i]))
+            return fold(a[7 + i]) < fold(b[7 + i]) ? -1 : 1;
+    }
+    return a[6] == b[6] ? 0 : a[6] < b[6] ? -1 : 1;
+}
+
+static int ext_cmp(const uint8_t *a, const uint8_t *b) {
+    if (r32(a + 2) != r32(b + 2))
+        return r32(a + 2) < r32(b + 2) ? -1 : 1;
+    if (a[1] != b[1])
+        return a[1] < b[1] ? -1 : 1;
+    return r16(a + 6) == r16(b + 6) ? 0 : r16(a + 6) < r16(b + 6) ? -1 : 1;
+}
+
+static const uint8_t *node_at(uint32_t start, uint32_t idx) {
+    return g_img + node_off(start, idx);
+}
+
+static const uint8_t *rec_at(const uint8_t *node, uint32_t i) {
+    return node + r16(node + 510 - 2 * i);
+}
+
+// Walk the subtree at `idx`; returns the nodes in it.
+static uint32_t check_subtree(uint32_t start, uint32_t idx, uint32_t height, int (*cmp)(const uint8_t *,
+                                                                                          const uint8_t *)) {
+    const uint8_t *n = node_at(start, idx);
+    ASSERT_EQ_INT(height, n[9]);
+    ASSERT_TRUE(r16(n + 10) > 0);
+    if (height == 1) {
+        ASSERT_EQ_INT(0xFF, n[8]);
+        return 1;
+    }
+    ASSERT_EQ_INT(0, n[8]);
+    uint32_t nodes = 1;
+    for (uint32_t i = 0; i < r16(n + 10); i++) {
+        const uint8_t *r = rec_at(n, i);
+        uint32_t child = r32(r + ((r[0] + 2) & ~1));
+        ASSERT_EQ_INT(0, cmp(r, rec_at(node_at(start, child), 0)));
+        nodes += check_subtree(start, child, height - 1, cmp);
+    }
+    return nodes;
+}
+
+// Check one B-tree; returns its leaf record count.
+static uint32_t check_tree(uint32_t start, int (*cmp)(const uint8_t *, const uint8_t *)) {
+    const uint8_t *h = node_at(start, 0) + 14;
+    uint32_t depth = r16(h), root = r32(h + 2), nrecs = r32(h + 6);
+    uint32_t first = r32(h + 10), last = r32(h + 14), total = r32(h + 22), free_nodes = r32(h + 26);
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < total; i++)
+        used += (node_at(start, 0)[248 + i / 8] >> (7 - i % 8)) & 1;
+    ASSERT_EQ_INT(total - used, free_nodes);
+    if (depth == 0) {
+        ASSERT_EQ_INT(0, root);
+        ASSERT_EQ_INT(0, nrecs);
+        ASSERT_EQ_INT(1, used);
+        return 0;
+    }
+    ASSERT_EQ_INT(used - 1, check_subtree(start, root, depth, cmp));
+
+    uint32_t count = 0, prev = 0;
+    const uint8_t *prev_rec = NULL;
+    for (uint32_t idx = first; idx; idx = r32(node_at(start, idx))) {
+        const uint8_t *n = node_at(start, idx);
+        ASSERT_EQ_INT(prev, r32(n + 4));
+        for (uint32_t i = 0; i < r16(n + 10); i++) {
+            if (prev_rec)
+                ASSERT_TRUE(cmp(prev_rec, rec_at(n, i)) < 0);
+            prev_rec = rec_at(n, i);
+            count++;
+        }
+        prev = idx;
+    }
+    ASSERT_EQ_INT(last, prev);
+    ASSERT_EQ_INT(nrecs, count);
+    return count;
+}
+
+// Check both trees and the bitmap; returns the catalog record count.
+static uint32_t check_volume(void) {
+    uint32_t free_blocks = 0;
+    for (uint32_t i = 0; i < N_AB; i++)
+        free_blocks += !((g_img[3 * SECT + i / 8] >> (7 - i % 8)) & 1);
+    ASSERT_EQ_INT(free_blocks, r16(g_img + MDB + 34));
+    check_tree(EXT_START, ext_cmp);
+    return check_tree(CAT_START, cat_cmp);
+}
+
+static uint32_t ext_records(void) {
+    return r32(node_at(EXT_START, 0) + 14 + 6);
+}
+
+// ---- Helpers ---------------------------------------------------------------
+
+static hfs_volume_t *open_volume(void) {
+    build_volume();
+    hfs_volume_t *vol = hfs_open(DUMMY, 0, IMG_SIZE);
+    ASSERT_TRUE(vol != NULL);
+    return vol;
+}
+
+// Read a whole fork and compare it with `expect`.
+static void expect_fork(hfs_volume_t *vol, const hfs_fork_t *fork, const uint8_t *expect, size_t len) {
+    ASSERT_EQ_INT(len, fork->logical_size);
+    uint8_t *buf = malloc(len + 1);
+    size_t got = 0;
+    ASSERT_EQ_INT(0, hfs_read_fork(vol, fork, 0, buf, len, &got));
+    ASSERT_EQ_INT(len, got);
+    ASSERT_EQ_INT(0, memcmp(buf, expect, len));
+    free(buf);
+}
+
+static void fill_pattern(uint8_t *buf, size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++)
+        buf[i] = (uint8_t)((i * 31 + seed) ^ (i >> 9));
+}
+
+// ---- Tests -----------------------------------------------------------------
+
+TEST(test_mkdir_and_put) {
+    hfs_volume_t *vol = open_volume();
+    ASSERT_TRUE(hfs_writable(vol));
+    const char *dir[] = {"Docs"};
+    ASSERT_EQ_INT(0, hfs_mkdir(vol, dir, 1));
+    ASSERT_EQ_INT(-EEXIST, hfs_mkdir(vol, dir, 1));
+
+    uint8_t data[1500], rsrc[700], finder[32] = "TEXTttxt";
+    fill_pattern(data, sizeof(data), 1);
+    fill_pattern(rsrc, sizeof(rsrc), 2);
+    hfs_put_t put = {data, sizeof(data), rsrc, sizeof(rsrc), finder};
+    const char *file[] = {"Docs", "Read Me"};
+    ASSERT_EQ_INT(0, hfs_put_file(vol, file, 2, &put));
+    ASSERT_EQ_INT(5, check_volume());
+
+    hfs_dirent_t d;
+    ASSERT_EQ_INT(0, hfs_lookup(vol, file, 2, &d));
+    ASSERT_TRUE(!d.is_dir);
+    expect_fork(vol, &d.data_fork, data, sizeof(data));
+    expect_fork(vol, &d.rsrc_fork, rsrc, sizeof(rsrc));
+    ASSERT_EQ_INT(0, memcmp(d.finder_info, "TEXTttxt", 8));
+    ASSERT_EQ_INT(0, hfs_lookup(vol, dir, 1, &d));
+    ASSERT_EQ_INT(1, d.valence);
+
+    // Counters: one folder and no file in the root, one file overall
+    ASSERT_EQ_INT(0, r16(g_img + MDB + 12));
+    ASSERT_EQ_INT(1, r16(g_img + MDB + 82));
+    ASSERT_EQ_INT(1, r32(g_img + MDB + 84));
+    ASSERT_EQ_INT(1, r32(g_img + MDB + 88));
+    ASSERT_EQ_INT(N_AB - FIRST_FREE - 3 - 2, r16(g_img + MDB + 34));
+
+    // Finder info can be changed on its own
+    uint8_t finder2[32] = "APPLgsmt";
+    ASSERT_EQ_INT(0, hfs_set_finder_info(vol, file, 2, finder2));
+    ASSERT_EQ_INT(0, hfs_lookup(vol, file, 2, &d));
+    ASSERT_EQ_INT(0, memcmp(d.finder_info, "APPLgsmt", 8));
+
+    // A fresh handle sees the same volume
+    hfs_close(vol);
+    vol = hfs_open(DUMMY, 0, IMG_SIZE);
+    ASSERT_TRUE(vol != NULL);
+    ASSERT_EQ_INT(0, hfs_lookup(vol, file, 2, &d));
+    expect_fork(vol, &d.data_fork, data, sizeof(data));
+    hfs_close(vol);
+}
+
+TEST(test_replace_and_remove) {
+    hfs_volume_t *vol = open_volume();
+    uint32_t free0 = r16(g_img + MDB + 34);
+    const char *dir[] = {"Dir"};
+    const char *file[] = {"Dir", "File"};
+    uint8_t big[5000], small[10] = "tiny file";
+    fill_pattern(big, sizeof(big), 3);
+    ASSERT_EQ_INT(0, hfs_mkdir(vol, dir, 1));
+    hfs_put_t put = {big, sizeof(big), NULL, 0, NULL};
+    ASSERT_EQ_INT(0, hfs_put_file(vol, file, 2, &put));
+    ASSERT_EQ_INT(free0 - 10, r16(g_img + MDB + 34));
+
+    // Replacing keeps the CNID and returns the old blocks
+    hfs_dirent_t d;
+    ASSERT_EQ_INT(0, hfs_lookup(vol, file, 2, &d));
+    uint32_t cnid = d.cnid;
+    put = (hfs_put_t){small, sizeof(small), NULL, 0, NULL};
+    ASSERT_EQ_INT(0, hfs_put_file(vol, file, 2, &put));
+    ASSERT_EQ_INT(0, hfs_lookup(vol, file, 2, &d));
+    ASSERT_EQ_INT(cnid, d.cnid);
+    expect_fork(vol, &d.data_fork, small, sizeof(small));
+    ASSERT_EQ_INT(free0 - 1, r16(g_img + MDB + 34));
+    ASSERT_EQ_INT(5, check_volume());
+
+    ASSERT_EQ_INT(-EISDIR, hfs_put_file(vol, dir, 1, &put));
+    ASSERT_EQ_INT(-ENOTEMPTY, hfs_remove(vol, dir, 1));
+    ASSERT_EQ_INT(0, hfs_remove(vol, file, 2));
+    ASSERT_EQ_INT(-ENOENT, hfs_lookup(vol, file, 2, &d));
+    ASSERT_EQ_INT(0, hfs_remove(vol, dir, 1));
+    ASSERT_EQ_INT(-ENOENT, hfs_remove(vol, dir, 1));
+    ASSERT_EQ_INT(2, check_volume());
+    ASSERT_EQ_INT(free0, r16(g_img + MDB + 34));
+    ASSERT_EQ_INT(0, r16(g_img + MDB + 82));
+    ASSERT_EQ_INT(0, r32(g_img + MDB + 84));
+    ASSERT_EQ_INT(0, r32(g_img + MDB + 88));
+    hfs_close(vol);
+}
+
+TEST(test_bad_names_and_targets) {
+    hfs_volume_t *vol = open_volume();
+    hfs_put_t put = {"x", 1, NULL, 0, NULL};
+    const char *too_long[] = {"This name is much longer than HFS allows"};
+    ASSERT_EQ_INT(-ENAMETOOLONG, hfs_put_file(vol, too_long, 1, &put));
+    const char *unmappable[] = {"snow \xe2\x98\x83"};
+    ASSERT_EQ_INT(-EILSEQ, hfs_put_file(vol, unmappable, 1, &put));
+    const char *no_parent[] = {"Missing", "File"};
+    ASSERT_EQ_INT(-ENOENT, hfs_put_file(vol, no_parent, 2, &put));
+    const char *file[] = {"File"};
+    const char *under_file[] = {"File", "Child"};
+    ASSERT_EQ_INT(0, hfs_put_file(vol, file, 1, &put));
+    ASSERT_EQ_INT(-ENOTDIR, hfs_mkdir(vol, under_file, 2));
+
+    // "a:b" is stored as "a/b" and found again under its VFS name
+    const char *colon[] = {"a:b"};
+    hfs_dirent_t d;
+    ASSERT_EQ_INT(0, hfs_put_file(vol, colon, 1, &put));
+    ASSERT_EQ_INT(0, hfs_lookup(vol, colon, 1, &d));
+    ASSERT_EQ_INT(4, check_volume());
+
+    // Too big for the free space: refused up front, nothing changes
+    uint8_t *huge = calloc(N_AB, 512);
+    put = (hfs_put_t){huge, (uint64_t)N_AB * 512, NULL, 0, NULL};
+    uint32_t free0 = r16(g_img + MDB + 34);
+    ASSERT_EQ_INT(-ENOSPC, hfs_put_file(vol, file, 1, &put));
+    ASSERT_EQ_INT(free0, r16(g_img + MDB + 34));
+    free(huge);
+    hfs_close(vol);
+}
+
+TEST(test_refuses_locked_and_hfsplus_wrapper) {
+    hfs_volume_t *vol = open_volume();
+    const char *dir[] = {"Dir"};
+    w16(MDB + 10, 0x8100); // software lock
+    ASSERT_TRUE(!hfs_writable(vol));
+    ASSERT_EQ_INT(-EROFS, hfs_mkdir(vol, dir, 1));
+    w16(MDB + 10, 0x0100);
+    w16(MDB + 0x7C, 0x482B); // embedded HFS+ volume
+    ASSERT_TRUE(!hfs_writable(vol));
+    ASSERT_EQ_INT(-EROFS, hfs_mkdir(vol, dir, 1));
+    w16(MDB + 0x7C, 0);
+    ASSERT_TRUE(hfs_writable(vol));
+    hfs_close(vol);
+}
+
+// Enough files to split the catalog into several levels, then remove them
+// all again in a different order; checked against both catalog readers.
+static void many_files(size_t eager_limit) {
+    enum { N = 300 };
+    hfs_set_eager_catalog_limit(eager_limit);
+    hfs_volume_t *vol = open_volume();
+    uint32_t free0 = r16(g_img + MDB + 34);
+    char names[N][16];
+    const char *path[1];
+    for (int i = 0; i < N; i++) {
+        int k = (i * 7919) % N; // scattered insertion order
+        snprintf(names[k], sizeof(names[k]), k % 2 ? "file %03d" : "File %03d", k);
+        uint8_t data[8];
+        memcpy(data, names[k], 8);
+        hfs_put_t put = {data, sizeof(data), NULL, 0, NULL};
+        path[0] = names[k];
+        ASSERT_EQ_INT(0, hfs_put_file(vol, path, 1, &put));
+        if (i % 50 == 0)
+            check_volume();
+    }
+    ASSERT_EQ_INT(N + 2, check_volume());
+    ASSERT_TRUE(r16(node_at(CAT_START, 0) + 14) >= 3);
+    ASSERT_EQ_INT(N, r16(g_img + MDB + 12));
+
+    hfs_dirent_t d;
+    for (int k = 0; k < N; k++) {
+        path[0] = names[k];
+        ASSERT_EQ_INT(0, hfs_lookup(vol, path, 1, &d));
+        expect_fork(vol, &d.data_fork, (const uint8_t *)names[k], 8);
+    }
+    hfs_dir_iter_t *it = hfs_opendir_cnid(vol, 2);
+    int count = 0;
+    while (hfs_readdir_next(it, &d) == 1)
+        count++;
+    hfs_closedir_iter(it);
+    ASSERT_EQ_INT(N, count);
+
+    for (int i = 0; i < N; i++) {
+        int k = (i * 4391 + 17) % N;
+        path[0] = names[k];
+        ASSERT_EQ_INT(0, hfs_remove(vol, path, 1));
+        if (i % 50 == 0)
+            check_volume();
+    }
+    ASSERT_EQ_INT(2, check_volume());
+    ASSERT_EQ_INT(1, r16(node_at(CAT_START, 0) + 14));
+    ASSERT_EQ_INT(CAT_NODES - 2, r32(node_at(CAT_START, 0) + 14 + 26));
+    ASSERT_EQ_INT(free0, r16(g_img + MDB + 34));
+    hfs_close(vol);
+    hfs_set_eager_catalog_limit(HFS_EAGER_CATALOG_MAX);
+}
+
+TEST(test_many_files_split_and_merge) {
+    many_files(HFS_EAGER_CATALOG_MAX);
+}
+
+TEST(test_many_files_on_demand_catalog) {
+    many_files(0);
+}
+
+TEST(test_fragmented_fork_uses_overflow_extents) {
+    hfs_volume_t *vol = open_volume();
+    uint32_t free0 = r16(g_img + MDB + 34);
+    char names[40][8];
+    const char *path[1];
+    uint8_t one[512] = {0};
+    hfs_put_t put = {one, sizeof(one), NULL, 0, NULL};
+    for (int i = 0; i < 40; i++) {
+        snprintf(names[i], sizeof(names[i]), "F%02d", i);
+        path[0] = names[i];
+        ASSERT_EQ_INT(0, hfs_put_file(vol, path, 1, &put));
+    }
+    // Punch 20 one-block holes, then ask for more than the tail run holds
+    for (int i = 0; i < 40; i += 2) {
+        path[0] = names[i];
+        ASSERT_EQ_INT(0, hfs_remove(vol, path, 1));
+    }
+    uint32_t tail = N_AB - FIRST_FREE - 40;
+    size_t len = (size_t)(tail + 10) * 512 - 100;
+    uint8_t *big = malloc(len);
+    fill_pattern(big, len, 4);
+    put = (hfs_put_t){NULL, 0, big, len, NULL};
+    const char *big_path[] = {"Big"};
+    ASSERT_EQ_INT(0, hfs_put_file(vol, big_path, 1, &put));
+    check_volume();
+    ASSERT_EQ_INT(6, ext_records()); // 20 holes + the tail run: 3 inline + 6 x 3 overflow
+
+    hfs_dirent_t d;
+    ASSERT_EQ_INT(0, hfs_lookup(vol, big_path, 1, &d));
+    ASSERT_EQ_INT(0, d.data_fork.logical_size);
+    expect_fork(vol, &d.rsrc_fork, big, len);
+    ASSERT_EQ_INT(10, r16(g_img + MDB + 34));
+
+    ASSERT_EQ_INT(0, hfs_remove(vol, big_path, 1));
+    ASSERT_EQ_INT(0, ext_records());
+    check_volume();
+    ASSERT_EQ_INT(free0 - 20, r16(g_img + MDB + 34));
+    free(big);
+    hfs_close(vol);
+}
+
+TEST(test_accented_names_sort_with_base_letter) {
+    hfs_volume_t *vol = open_volume();
+    const char *names[] = {"Zed", "\xc3\x89" "clair", "ezra", "Eagle", "apple"};
+    hfs_put_t put = {"x", 1, NULL, 0, NULL};
+    for (int i = 0; i < 5; i++) {
+        const char *path[] = {names[i]};
+        ASSERT_EQ_INT(0, hfs_put_file(vol, path, 1, &put));
+    }
+    const char *expect[] = {"apple", "Eagle", "ezra", "\xc3\x89" "clair", "Zed"};
+    hfs_dir_iter_t *it = hfs_opendir_cnid(vol, 2);
+    hfs_dirent_t d;
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ_INT(1, hfs_readdir_next(it, &d));
+        ASSERT_EQ_INT(0, strcmp(d.name, expect[i]));
+    }
+    ASSERT_EQ_INT(0, hfs_readdir_next(it, &d));
+    hfs_closedir_iter(it);
+    hfs_close(vol);
+}
+
+int main(void) {
+    RUN(test_mkdir_and_put);
+    RUN(test_replace_and_remove);
+    RUN(test_bad_names_and_targets);
+    RUN(test_refuses_locked_and_hfsplus_wrapper);
+    RUN(test_many_files_split_and_merge);
+    RUN(test_many_files_on_demand_catalog);
+    RUN(test_fragmented_fork_uses_overflow_extents);
+    RUN(test_accented_names_sort_with_base_letter);
+    fprintf(stderr, "All hfs_write tests passed.\n");
+    return 0;
+}
@@ -20,6 +20,7 @@
 #include "image_hfs.h"
 #include "test_assert.h"
 
+#include <errno.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -304,6 +305,55 @@ TEST(test_bad_signature_rejected) {
     ASSERT_TRUE(hfs_open(DUMMY, 0, IMG_SIZE) == NULL);
 }
 
+TEST(test_lazy_catalog) {
+    build_volume(0x482B);
+    hfs_set_eager_catalog_limit(0); // walk even this catalog on disk
+    hfs_volume_t *vol = hfs_open(DUMMY, 0, IMG_SIZE);
+    hfs_set_eager_catalog_limit(HFS_EAGER_CATALOG_MAX);
+    ASSERT_TRUE(vol != NULL);
+    ASSERT_EQ_INT(0, strcmp(hfs_volume_name(vol), "TestVol"));
+
+    hfs_dirent_t de;
+    ASSERT_EQ_INT(0, hfs_lookup(vol, NULL, 0, &de));
+    ASSERT_EQ_INT(3, (int)de.valence);
+
+    // Enumeration yields the root's children in catalog order.
+    hfs_dir_iter_t *it = hfs_opendir_cnid(vol, HFS_ROOT_CNID);
+    ASSERT_TRUE(it != NULL);
+    const char *want[] = {"Sub", "Hello", "Bullet\xe2\x80\xa2"};
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ_INT(1, hfs_readdir_next(it, &de));
+        ASSERT_EQ_INT(0, strcmp(de.name, want[i]));
+    }
+    ASSERT_EQ_INT(0, hfs_readdir_next(it, &de));
+    ASSERT_EQ_INT(0, hfs_readdir_next(it, &de)); // EOF is sticky
+    hfs_closedir_iter(it);
+
+    it = hfs_opendir_cnid(vol, 16); // "Sub" is empty
+    ASSERT_TRUE(it != NULL);
+    ASSERT_EQ_INT(0, hfs_readdir_next(it, &de));
+    hfs_closedir_iter(it);
+
+    // Lookups fold case, and miss cleanly.
+    const char *hello[] = {"HELLO"};
+    ASSERT_EQ_INT(0, hfs_lookup(vol, hello, 1, &de));
+    ASSERT_EQ_INT(17, (int)de.cnid);
+    char buf[16] = {0};
+    size_t got = 0;
+    ASSERT_EQ_INT(0, hfs_read_fork(vol, &de.data_fork, 0, buf, sizeof(buf), &got));
+    ASSERT_EQ_INT(11, (int)got);
+    ASSERT_EQ_INT(0, memcmp(buf, "Hello World", 11));
+    const char *bullet[] = {"Bullet\xe2\x80\xa2"};
+    ASSERT_EQ_INT(0, hfs_lookup(vol, bullet, 1, &de));
+    ASSERT_EQ_INT(18, (int)de.cnid);
+    const char *missing[] = {"Nope"};
+    ASSERT_EQ_INT(-ENOENT, hfs_lookup(vol, missing, 1, &de));
+    const char *under_file[] = {"Hello", "x"};
+    ASSERT_EQ_INT(-ENOTDIR, hfs_lookup(vol, under_file, 2, &de));
+
+    hfs_close(vol);
+}
+
 int main(void) {
     RUN(test_open_and_volume_name);
     RUN(test_readdir_root);
@@ -311,6 +361,7 @@ int main(void) {
     RUN(test_lookup_nested_and_missing);
     RUN(test_hfsx_signature_accepted);
     RUN(test_bad_signature_rejected);
+    RUN(test_lazy_catalog);
     fprintf(stderr, "All hfsplus tests passed.\n");
     return 0;
 }
@@ -0,0 +1,194 @@
+// image_write_back unit tests.
+//
+// Host-side edits of a read-only mount are staged in its scratch delta and
+// then copied into the base image file.  The copy must be all or nothing: a
+// successful write-back leaves exactly the changed blocks updated (and the
+// file's mode alone), and a failed one leaves the base byte-for-byte as it
+// was, with the changes still uncommitted so they can be discarded.  The
+// failure is forced with RLIMIT_FSIZE, which stops writes past a small size
+// even for root; an in-place write-back would have updated the blocks below
+// the limit and lost the rest.
+
+#include "image.h"
+#include "test_assert.h"
+
+#include <dirent.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SANDBOX_DIR "_image_wb_sandbox"
+#define BASE_FILE   SANDBOX_DIR "/disk.img"
+#define BLOCK       512u
+#define BLOCKS      256u // 128 KB
+#define LOW_LBA     1u // below the RLIMIT_FSIZE used by the failure test
+#define HIGH_LBA    200u // above it
+#define FSIZE_LIMIT (16u * 1024u)
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static void fill_block(uint32_t lba, uint8_t salt, uint8_t *out) {
+    for (uint32_t i = 0; i < BLOCK; i++)
+        out[i] = (uint8_t)(salt + lba + i);
+}
+
+// Remove every file in the sandbox, then the sandbox itself
+static void clear_sandbox(void) {
+    DIR *dir = opendir(SANDBOX_DIR);
+    if (dir) {
+        struct dirent *e;
+        char path[512];
+        while ((e = readdir(dir)) != NULL) {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            snprintf(path, sizeof(path), "%s/%s", SANDBOX_DIR, e->d_name);
+            unlink(path);
+        }
+        closedir(dir);
+    }
+    rmdir(SANDBOX_DIR);
+}
+
+// Fresh sandbox holding a base image whose block lba is fill_block(lba, 0)
+static void setup_base(mode_t mode) {
+    clear_sandbox();
+    ASSERT_TRUE(mkdir(SANDBOX_DIR, 0777) == 0);
+    FILE *f = fopen(BASE_FILE, "wb");
+    ASSERT_TRUE(f != NULL);
+    uint8_t block[BLOCK];
+    for (uint32_t lba = 0; lba < BLOCKS; lba++) {
+        fill_block(lba, 0, block);
+        ASSERT_TRUE(fwrite(block, 1, BLOCK, f) == BLOCK);
+    }
+    fclose(f);
+    ASSERT_TRUE(chmod(BASE_FILE, mode) == 0);
+}
+
+// Number of sandbox entries (the base alone when no scratch copy is left over)
+static int sandbox_entries(void) {
+    DIR *dir = opendir(SANDBOX_DIR);
+    ASSERT_TRUE(dir != NULL);
+    int n = 0;
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL)
+        if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0)
+            n++;
+    closedir(dir);
+    return n;
+}
+
+// True when block lba of the base file on disk holds fill_block(lba, salt)
+static bool base_block_is(uint32_t lba, uint8_t salt) {
+    FILE *f = fopen(BASE_FILE, "rb");
+    ASSERT_TRUE(f != NULL);
+    uint8_t got[BLOCK], want[BLOCK];
+    fseek(f, (long)(lba * BLOCK), SEEK_SET);
+    size_t n = fread(got, 1, BLOCK, f);
+    fclose(f);
+    fill_block(lba, salt, want);
+    return n == BLOCK && memcmp(got, want, BLOCK) == 0;
+}
+
+// True when block lba as seen through the image holds fill_block(lba, salt)
+static bool image_block_is(image_t *img, uint32_t lba, uint8_t salt) {
+    uint8_t got[BLOCK], want[BLOCK];
+    fill_block(lba, salt, want);
+    return disk_read_data(img, lba * BLOCK, got, BLOCK) == BLOCK && memcmp(got, want, BLOCK) == 0;
+}
+
+// Stage fill_block(lba, salt) for both test blocks in the image's delta
+static void stage_edits(image_t *img, uint8_t salt) {
+    uint8_t block[BLOCK];
+    fill_block(LOW_LBA, salt, block);
+    ASSERT_TRUE(disk_write_data(img, LOW_LBA * BLOCK, block, BLOCK) == BLOCK);
+    fill_block(HIGH_LBA, salt, block);
+    ASSERT_TRUE(disk_write_data(img, HIGH_LBA * BLOCK, block, BLOCK) == BLOCK);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+TEST(test_write_back_updates_base) {
+    setup_base(0640);
+    image_t *img = image_open_readonly(BASE_FILE);
+    ASSERT_TRUE(img != NULL);
+    ASSERT_TRUE(image_base_writable(img));
+
+    stage_edits(img, 7);
+    ASSERT_TRUE(base_block_is(LOW_LBA, 0)); // staged only
+    ASSERT_EQ_INT(0, image_write_back(img));
+
+    ASSERT_TRUE(base_block_is(LOW_LBA, 7));
+    ASSERT_TRUE(base_block_is(HIGH_LBA, 7));
+    ASSERT_TRUE(base_block_is(0, 0));
+    ASSERT_TRUE(base_block_is(LOW_LBA + 1, 0));
+    ASSERT_TRUE(base_block_is(BLOCKS - 1, 0));
+    struct stat st;
+    ASSERT_TRUE(stat(BASE_FILE, &st) == 0);
+    ASSERT_EQ_INT(0640, (int)(st.st_mode & 07777));
+    ASSERT_EQ_INT((int)(BLOCKS * BLOCK), (int)st.st_size);
+    ASSERT_EQ_INT(1, sandbox_entries());
+
+    // Committed: discarding keeps them, and an empty write-back is a no-op
+    ASSERT_EQ_INT(0, image_discard_changes(img));
+    ASSERT_TRUE(image_block_is(img, HIGH_LBA, 7));
+    ASSERT_EQ_INT(0, image_write_back(img));
+    ASSERT_TRUE(base_block_is(HIGH_LBA, 7));
+
+    image_close(img);
+    clear_sandbox();
+}
+
+TEST(test_failed_write_back_leaves_base_unchanged) {
+    setup_base(0644);
+    image_t *img = image_open_readonly(BASE_FILE);
+    ASSERT_TRUE(img != NULL);
+    stage_edits(img, 9);
+
+    // Writes past FSIZE_LIMIT fail with EFBIG instead of raising SIGXFSZ
+    struct rlimit saved, limit;
+    ASSERT_TRUE(getrlimit(RLIMIT_FSIZE, &saved) == 0);
+    limit = saved;
+    limit.rlim_cur = FSIZE_LIMIT;
+    void (*old_handler)(int) = signal(SIGXFSZ, SIG_IGN);
+    ASSERT_TRUE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+    int rc = image_write_back(img);
+    ASSERT_TRUE(setrlimit(RLIMIT_FSIZE, &saved) == 0);
+    signal(SIGXFSZ, old_handler);
+    ASSERT_EQ_INT(-1, rc);
+
+    // Neither block reached the base, not even the one below the limit
+    for (uint32_t lba = 0; lba < BLOCKS; lba++)
+        ASSERT_TRUE(base_block_is(lba, 0));
+    ASSERT_EQ_INT(1, sandbox_entries());
+
+    // The edits are still pending in the delta and can be dropped ...
+    ASSERT_TRUE(image_block_is(img, LOW_LBA, 9));
+    ASSERT_EQ_INT(0, image_discard_changes(img));
+    ASSERT_TRUE(image_block_is(img, LOW_LBA, 0));
+    ASSERT_TRUE(image_block_is(img, HIGH_LBA, 0));
+
+    // ... or written back once the limit is gone
+    stage_edits(img, 11);
+    ASSERT_EQ_INT(0, image_write_back(img));
+    ASSERT_TRUE(base_block_is(LOW_LBA, 11));
+    ASSERT_TRUE(base_block_is(HIGH_LBA, 11));
+
+    image_close(img);
+    clear_sandbox();
+}
+
+int main(void) {
+    RUN(test_write_back_updates_base);
+    RUN(test_failed_write_back_leaves_base_unchanged);
+    printf("[PASS] All image write-back tests passed\n");
+    return 0;
+}
@@ -0,0 +1,241 @@
+// Lisa segment MMU SoA fast-path tests.
+// Verifies that plain RAM/ROM pages are filled into the SoA tables for the
+// current mode, that I/O, faulting and parity-test pages stay on the slow
+// path, and that SETUP strobes, context strobes and descriptor writes drop
+// the fills they affect.
+
+#include "lisa_mmu.h"
+#include "memory.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAM_SIZE 0x100000u // 1 MB, based at $80000 (Lisa 2 layout)
+#define ROM_SIZE 0x4000u
+#define RAM_MIN  0x80000u
+
+#define SLR_MEM_RW 0x700 // read/write memory, full 128 KB segment
+#define SLR_MEM_RO 0x500 // read-only memory, full segment
+#define SLR_IO     0x900 // I/O space, full segment
+#define SEG_IO     126 // $FC0000: control strobes at $FCE000
+
+#define STROBE_SEG1OFF 0x08
+#define STROBE_SEG1ON  0x0A
+#define STROBE_SETUPON 0x10
+#define STROBE_SETUP   0x12
+#define STROBE_DG2OFF  0x04
+#define STROBE_DG2ON   0x06
+
+// The scheduler is not wired (retrace bit unused here)
+uint64_t scheduler_cpu_cycles(struct scheduler *s) {
+    (void)s;
+    return 0;
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static memory_map_t *g_mem;
+static lisa_mmu_t *g_lm;
+
+// Run accesses in supervisor (true) or user (false) mode
+static void set_supervisor(bool supervisor) {
+    g_active_read = supervisor ? g_supervisor_read : g_user_read;
+    g_active_write = supervisor ? g_supervisor_write : g_user_write;
+}
+
+// Write a descriptor register for `seg` in the current latch context (START mode)
+static void desc_write(int seg, uint16_t sor, uint16_t slr) {
+    memory_write_uint16(((uint32_t)seg << 17) | 0x8008, sor);
+    memory_write_uint16(((uint32_t)seg << 17) | 0x8000, slr);
+}
+
+// Fire a control strobe through the I/O segment (supervisor context 0)
+static void strobe(uint32_t off) {
+    bool supervisor = g_active_read == g_supervisor_read;
+    set_supervisor(true);
+    memory_write_uint16(((uint32_t)SEG_IO << 17) | 0xE000 | off, 0);
+    set_supervisor(supervisor);
+}
+
+// Fresh Lisa: RAM/ROM patterns, segment 1 -> RAM+$00000, segment 2 -> RAM+$20000
+// (read-only) and the I/O segment programmed in context 0, then map land
+static void setup(void) {
+    g_mem = memory_map_init(24, RAM_SIZE, ROM_SIZE, NULL);
+    uint8_t *ram = ram_native_pointer(g_mem, 0);
+    for (uint32_t i = 0; i < RAM_SIZE; i += 4)
+        STORE_BE32(ram + i, RAM_MIN + i);
+    uint8_t *rom = (uint8_t *)memory_rom_bytes(g_mem);
+    for (uint32_t i = 0; i < ROM_SIZE; i++)
+        rom[i] = (uint8_t)(i ^ 0x5A);
+    g_lm = lisa_mmu_init(ram, RAM_SIZE, rom, ROM_SIZE, true, NULL);
+    set_supervisor(true);
+    desc_write(SEG_IO, 0, SLR_IO);
+    desc_write(1, RAM_MIN >> 9, SLR_MEM_RW);
+    desc_write(2, (RAM_MIN + 0x20000) >> 9, SLR_MEM_RO);
+    strobe(STROBE_SETUP);
+}
+
+// Tear down the Lisa MMU and memory map
+static void teardown(void) {
+    lisa_mmu_delete(g_lm);
+    memory_map_delete(g_mem);
+    g_bus_error_pending = false;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+TEST(test_ram_pages_fill_supervisor_tables) {
+    setup();
+    uint32_t page = 0x20000 >> PAGE_SHIFT;
+    ASSERT_EQ_INT(0, (int)(memory_soa_get(g_supervisor_read, page) != 0));
+
+    // First read misses and fills; the fill maps the whole page
+    ASSERT_EQ_INT((int)RAM_MIN, (int)memory_read_uint32(0x20000));
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, page) != 0);
+    ASSERT_EQ_INT((int)(RAM_MIN + 0xFFC), (int)memory_read_uint32(0x20FFC));
+    ASSERT_TRUE(memory_soa_get(g_user_read, page) == 0);
+
+    // Writes fill the write table and land in RAM
+    memory_write_uint32(0x20010, 0xDEADBEEF);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, page) != 0);
+    memory_write_uint32(0x20014, 0x12345678);
+    uint8_t *ram = ram_native_pointer(g_mem, 0);
+    ASSERT_EQ_INT((int)0xDEADBEEF, (int)LOAD_BE32(ram + 0x10));
+    ASSERT_EQ_INT(0x12345678, (int)LOAD_BE32(ram + 0x14));
+    teardown();
+}
+
+TEST(test_slow_pages_stay_unfilled) {
+    setup();
+    // Read-only segment: reads fill, writes fault and fill nothing
+    uint32_t ro_page = 0x40000 >> PAGE_SHIFT;
+    ASSERT_EQ_INT((int)(RAM_MIN + 0x20000), (int)memory_read_uint32(0x40000));
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, ro_page) != 0);
+    memory_write_uint32(0x40000, 0);
+    ASSERT_TRUE(g_bus_error_pending);
+    g_bus_error_pending = false;
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, ro_page) == 0);
+
+    // I/O (status register) and unprogrammed segments
+    memory_read_uint8(((uint32_t)SEG_IO << 17) | 0xF800);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, ((uint32_t)SEG_IO << 17 | 0xF000) >> PAGE_SHIFT) == 0);
+    memory_read_uint32(0x60000);
+    ASSERT_TRUE(g_bus_error_pending);
+    g_bus_error_pending = false;
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x60000 >> PAGE_SHIFT) == 0);
+
+    // Write-wrong-parity mode drops fills and keeps every write slow
+    memory_read_uint32(0x20000);
+    strobe(STROBE_DG2ON);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) == 0);
+    memory_write_uint32(0x20000, 1);
+    memory_read_uint32(0x20000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 0x20) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) == 0);
+
+    // The bad granule stays slow after DG2OFF until a normal write repairs it
+    strobe(STROBE_DG2OFF);
+    memory_read_uint32(0x20000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) == 0);
+    memory_write_uint32(0x20000, 2);
+    memory_read_uint32(0x20000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) != 0);
+    teardown();
+}
+
+TEST(test_start_mode_rom_and_setup_strobe) {
+    setup();
+    strobe(STROBE_SETUPON);
+    // START with bit14=0, bit15=0: boot ROM at addr & $3FFF
+    ASSERT_EQ_INT(0x5A ^ 0x10, (int)memory_read_uint8(0x1010));
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) != 0);
+    ASSERT_EQ_INT(0x5A ^ 0x20, (int)memory_read_uint8(0x1020)); // now via the fast path
+    memory_write_uint8(0x1010, 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 1) == 0);
+    ASSERT_EQ_INT(0x5A ^ 0x10, (int)memory_read_uint8(0x1010));
+
+    // Descriptor-RAM pages never fill
+    memory_read_uint16(0x28000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x28) == 0);
+
+    // Leaving START drops the ROM fill; page 1 is now unprogrammed segment 0
+    strobe(STROBE_SETUP);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) == 0);
+    memory_read_uint8(0x1010);
+    ASSERT_TRUE(g_bus_error_pending);
+    g_bus_error_pending = false;
+    teardown();
+}
+
+TEST(test_descriptor_write_drops_fills) {
+    setup();
+    memory_read_uint32(0x20000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) != 0);
+
+    // Rewriting a descriptor with its current value keeps the fills
+    strobe(STROBE_SETUPON);
+    memory_read_uint32(0x20000);
+    desc_write(1, RAM_MIN >> 9, SLR_MEM_RW);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) != 0);
+
+    // Moving segment 1 drops them and the next access sees the new origin
+    desc_write(1, (RAM_MIN + 0x40000) >> 9, SLR_MEM_RW);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) == 0);
+    strobe(STROBE_SETUP);
+    ASSERT_EQ_INT((int)(RAM_MIN + 0x40000), (int)memory_read_uint32(0x20000));
+    teardown();
+}
+
+TEST(test_user_context_switch) {
+    setup();
+    // Context 1 maps segment 1 onto RAM+$60000
+    strobe(STROBE_SETUPON);
+    strobe(STROBE_SEG1ON);
+    desc_write(1, (RAM_MIN + 0x60000) >> 9, SLR_MEM_RW);
+    strobe(STROBE_SEG1OFF);
+    strobe(STROBE_SETUP);
+
+    // User mode with latch context 0 shares context 0's translation
+    set_supervisor(false);
+    ASSERT_EQ_INT((int)RAM_MIN, (int)memory_read_uint32(0x20000));
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0x20) != 0);
+    set_supervisor(true);
+    memory_read_uint32(0x20000);
+
+    // Switching the latch to context 1 drops only the user fills
+    strobe(STROBE_SEG1ON);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0x20) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) != 0);
+    set_supervisor(false);
+    ASSERT_EQ_INT((int)(RAM_MIN + 0x60000), (int)memory_read_uint32(0x20000));
+    set_supervisor(true);
+    ASSERT_EQ_INT((int)RAM_MIN, (int)memory_read_uint32(0x20000));
+
+    // A context-1 descriptor write drops user fills, not supervisor ones
+    strobe(STROBE_SETUPON);
+    set_supervisor(false);
+    memory_read_uint32(0x20000);
+    set_supervisor(true);
+    memory_read_uint32(0x20000);
+    desc_write(1, (RAM_MIN + 0x80000) >> 9, SLR_MEM_RW);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0x20) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x20) != 0);
+    teardown();
+}
+
+int main(void) {
+    RUN(test_ram_pages_fill_supervisor_tables);
+    RUN(test_slow_pages_stay_unfilled);
+    RUN(test_start_mode_rom_and_setup_strobe);
+    RUN(test_descriptor_write_drops_fills);
+    RUN(test_user_context_switch);
+    printf("[PASS] All Lisa MMU fast-path tests passed\n");
+    return 0;
+}
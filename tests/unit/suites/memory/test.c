@@ -53,18 +53,18 @@ TEST(test_24bit_ram_pages) {
     memory_populate_pages(mem, 0x400000, 0x580000);
 
     // First RAM page (addr 0x000000)
-    page_entry_t *p0 = &g_page_table[0x000000 >> 12];
+    const page_entry_t *p0 = memory_page(0x000000 >> 12);
     ASSERT_TRUE(p0->host_base != NULL);
     ASSERT_TRUE(p0->writable);
     ASSERT_TRUE(p0->dev == NULL);
 
     // Last RAM page (addr 0x3FF000)
-    page_entry_t *p_last_ram = &g_page_table[0x3FF000 >> 12];
+    const page_entry_t *p_last_ram = memory_page(0x3FF000 >> 12);
     ASSERT_TRUE(p_last_ram->host_base != NULL);
     ASSERT_TRUE(p_last_ram->writable);
 
     // RAM page at 0x001000 should follow the first by one page worth of bytes
-    page_entry_t *p1 = &g_page_table[0x001000 >> 12];
+    const page_entry_t *p1 = memory_page(0x001000 >> 12);
     ASSERT_EQ_INT((int)(p1->host_base - p0->host_base), 0x1000);
 
     cleanup(mem);
@@ -78,23 +78,23 @@ TEST(test_24bit_rom_pages) {
     memory_populate_pages(mem, 0x400000, 0x580000);
 
     // Primary ROM page (addr 0x400000)
-    page_entry_t *p_rom0 = &g_page_table[0x400000 >> 12];
+    const page_entry_t *p_rom0 = memory_page(0x400000 >> 12);
     ASSERT_TRUE(p_rom0->host_base != NULL);
     ASSERT_TRUE(!p_rom0->writable);
     ASSERT_TRUE(p_rom0->dev == NULL);
 
     // ROM mirror at 0x440000 should map to the same host data as 0x400000
-    page_entry_t *p_mirror = &g_page_table[0x440000 >> 12];
+    const page_entry_t *p_mirror = memory_page(0x440000 >> 12);
     ASSERT_TRUE(p_mirror->host_base != NULL);
     ASSERT_TRUE(!p_mirror->writable);
     ASSERT_EQ_INT((int)(p_mirror->host_base - p_rom0->host_base), 0);
 
     // ROM page inside primary region: 0x401000 → one page into ROM
-    page_entry_t *p_rom1 = &g_page_table[0x401000 >> 12];
+    const page_entry_t *p_rom1 = memory_page(0x401000 >> 12);
     ASSERT_EQ_INT((int)(p_rom1->host_base - p_rom0->host_base), 0x1000);
 
     // Interleaved I/O range (A17=1 relative to ROM base) must be unmapped, not ROM
-    page_entry_t *p_io = &g_page_table[0x420000 >> 12];
+    const page_entry_t *p_io = memory_page(0x420000 >> 12);
     ASSERT_TRUE(p_io->host_base == NULL);
     ASSERT_TRUE(p_io->dev == NULL);
 
@@ -113,6 +113,111 @@ TEST(test_delete_clears_globals) {
     ASSERT_EQ_INT(0, g_page_count);
 }
 
+// Verify an SoA clear hides every populated entry and a refill brings back
+// only what it stores (default flat layout; memory_sparse covers GS_SPARSE_SOA)
+TEST(test_soa_clear_and_refill) {
+    memory_map_t *mem = memory_map_init(32, 0x400000, 0x020000, NULL);
+    ASSERT_TRUE(mem != NULL);
+    memory_populate_pages(mem, 0x40000000, 0x40080000);
+    uint32_t rom = 0x40000000 >> 12;
+    uintptr_t ram0 = memory_soa_get(g_supervisor_read, 0);
+    ASSERT_TRUE(ram0 != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, rom) != 0);
+
+    memory_soa_clear(g_supervisor_read);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0x3FF) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, rom) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0) == ram0); // other tables untouched
+
+    // Zero stores leave a chunk unlisted; the next clear still wipes real ones
+    memory_soa_set(g_supervisor_read, 0x100, 0);
+    memory_soa_set(g_supervisor_read, 0xFFFFF, 0x5000);
+    memory_soa_set(g_supervisor_read, 1, 0x2000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) == 0x2000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == 0);
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_clear(g_supervisor_read);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0xFFFFF) == 0);
+
+    // The slow path lazily reinstalls RAM
+    g_active_read = g_supervisor_read;
+    g_active_write = g_supervisor_write;
+    memory_write_uint32(0x10, 0xCAFEF00D);
+    ASSERT_EQ_INT((int)0xCAFEF00D, (int)memory_read_uint32(0x10));
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == ram0);
+
+    cleanup(mem);
+}
+
+// Verify rearm drops RAM write entries and the next store marks its page
+TEST(test_ram_dirty_tracking) {
+    memory_map_t *mem = memory_map_init(24, 0x400000, 0x020000, NULL);
+    ASSERT_TRUE(mem != NULL);
+    memory_populate_pages(mem, 0x400000, 0x580000);
+    g_active_read = g_supervisor_read;
+    g_active_write = g_supervisor_write;
+
+    // Everything starts dirty; rearm clears the map and the RAM write entries
+    ASSERT_EQ_INT(1, g_ram_dirty[0]);
+    memory_write_uint8(0x3000, 0x11);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 3) != 0);
+    memory_ram_dirty_rearm();
+    ASSERT_EQ_INT(0, g_ram_dirty[3]);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 3) == 0);
+
+    // Reads keep their fast path and leave the page clean
+    ASSERT_EQ_INT(0x11, memory_read_uint8(0x3000));
+    ASSERT_EQ_INT(0, g_ram_dirty[3]);
+
+    // The first store refills the write entry and marks only its own page
+    memory_write_uint32(0x3FFC, 0xCAFEBABE);
+    ASSERT_EQ_INT(1, g_ram_dirty[3]);
+    ASSERT_EQ_INT(0, g_ram_dirty[4]);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 3) != 0);
+    ASSERT_EQ_INT((int)0xCAFEBABE, (int)memory_read_uint32(0x3FFC));
+
+    // Debug pokes bypass the tables but still mark the page
+    memory_debug_write_uint16(0x7000, 0x1234);
+    ASSERT_EQ_INT(1, g_ram_dirty[7]);
+    ASSERT_EQ_INT(0, g_ram_dirty[6]);
+
+    cleanup(mem);
+}
+
+TEST(test_ram_cow_snapshot) {
+    memory_map_t *mem = memory_map_init(24, 0x400000, 0x020000, NULL);
+    ASSERT_TRUE(mem != NULL);
+    memory_populate_pages(mem, 0x400000, 0x580000);
+    g_active_read = g_supervisor_read;
+    g_active_write = g_supervisor_write;
+
+    memory_write_uint32(0x3000, 0x11111111);
+    memory_write_uint32(0x5000, 0x55555555);
+    ASSERT_TRUE(memory_ram_cow_begin());
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 3) == 0);
+
+    // Fast-path stores and debug pokes after begin leave the snapshot alone
+    memory_write_uint32(0x3000, 0x22222222);
+    memory_write_uint32(0x3004, 0x33333333);
+    memory_debug_write_uint16(0x5000, 0x6666);
+    ASSERT_EQ_INT(0x22222222, (int)memory_read_uint32(0x3000));
+    uint8_t snap[8];
+    ASSERT_TRUE(memory_ram_cow_read(NULL, 0x3000, snap, 8));
+    ASSERT_EQ_INT(0x11, snap[0]);
+    ASSERT_EQ_INT(0x11, snap[3]);
+    ASSERT_TRUE(memory_ram_cow_read(NULL, 0x4FFE, snap, 4));
+    ASSERT_EQ_INT(0x55, snap[2]);
+
+    // Once closed, no snapshot is left to read
+    memory_ram_cow_end(NULL);
+    ASSERT_TRUE(!memory_ram_cow_read(NULL, 0x3000, snap, 1));
+    ASSERT_EQ_INT(0x6666, (int)memory_read_uint16(0x5000));
+
+    cleanup(mem);
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -123,6 +228,9 @@ int main(void) {
     RUN(test_24bit_ram_pages);
     RUN(test_24bit_rom_pages);
     RUN(test_delete_clears_globals);
+    RUN(test_soa_clear_and_refill);
+    RUN(test_ram_dirty_tracking);
+    RUN(test_ram_cow_snapshot);
     printf("[PASS] All memory tests passed\n");
     return 0;
 }
@@ -0,0 +1,251 @@
+// Sparse page-table tests and benchmark (memory.h two-level layout, built
+// with GS_SPARSE_SOA).
+//
+// Checks that a 32-bit map only materialises the leaves it populates, that
+// zero stores into unpopulated leaves allocate nothing, and that a full SoA
+// clear keeps leaves but hides their stale entries, including after a refill
+// reattaches them.  The benchmarks time the real memory_read_uint32 path and
+// a full invalidation against an equivalent flat array (the default
+// layout), and the invalidation with one page versus all of RAM populated;
+// they print the figures and assert only that the layouts read the same data.
+
+#include "memory.h"
+#include "test_assert.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RAM_SIZE  0x800000u // 8 MB, a typical SE/30 configuration
+#define ROM_SIZE  0x040000u
+#define ROM_START 0x40000000u
+#define ROM_END   0x40080000u
+
+#define BENCH_READS   (1u << 24)
+#define BENCH_CLEARS  64u
+#define BENCH_FLUSHES 4096u
+#define FLAT_BYTES(n) ((size_t)(n) * (sizeof(page_entry_t) + 4 * sizeof(uintptr_t)))
+
+// Monotonic time in nanoseconds
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 32-bit map with RAM at 0 and ROM mirrored at ROM_START
+static memory_map_t *make_map(void) {
+    memory_map_t *mem = memory_map_init(32, RAM_SIZE, ROM_SIZE, NULL);
+    memory_populate_pages(mem, ROM_START, ROM_END);
+    return mem;
+}
+
+// Time BENCH_READS memory_read_uint32 calls at pseudo-random offsets below span
+static uint64_t bench_reads_sparse(uint32_t span, uint32_t *sum_out) {
+    uint32_t seed = 1, sum = 0;
+    uint64_t t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        sum += memory_read_uint32((seed >> 8) & (span - 4));
+    }
+    *sum_out = sum;
+    return now_ns() - t0;
+}
+
+// Same reads through the default flat accessor over a flat SoA array
+static uint64_t bench_reads_flat(uintptr_t *flat, uint32_t span, uint32_t *sum_out) {
+    uint32_t seed = 1, sum = 0;
+    uint64_t t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t masked = ((seed >> 8) & (span - 4)) & g_address_mask;
+        // volatile: reload the table pointer each access, as the real path reloads g_active_read
+        uintptr_t base = ((uintptr_t *volatile)flat)[masked >> PAGE_SHIFT];
+        if (__builtin_expect(base != 0 && (masked & PAGE_MASK) <= MEM_PAGE_SIZE - 4, 1))
+            sum += LOAD_BE32((uint8_t *)(base + masked));
+        else
+            sum += memory_read_uint32_slow(masked);
+    }
+    *sum_out = sum;
+    return now_ns() - t0;
+}
+
+TEST(test_32bit_footprint_is_sparse) {
+    memory_map_t *mem = make_map();
+    size_t sparse = memory_page_tables_bytes();
+    size_t flat = FLAT_BYTES(g_page_count);
+    printf("[INFO] page tables: two-level %zu KB, flat %zu KB\n", sparse >> 10, flat >> 10);
+    ASSERT_TRUE(sparse * 64 < flat);
+
+    // Populated and unpopulated pages read as before
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, ROM_START >> PAGE_SHIFT) != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, ROM_START >> PAGE_SHIFT) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0x80000000u >> PAGE_SHIFT) == 0);
+    ASSERT_TRUE(memory_page(0x80000000u >> PAGE_SHIFT)->host_base == NULL);
+    ASSERT_TRUE(memory_page(0)->host_base != NULL);
+
+    memory_map_delete(mem);
+    ASSERT_TRUE(g_page_table == NULL);
+}
+
+TEST(test_zero_store_allocates_nothing) {
+    memory_map_t *mem = make_map();
+    uint32_t page = 0xF0000000u >> PAGE_SHIFT;
+    size_t before = memory_page_tables_bytes();
+
+    memory_soa_set(g_user_write, page, 0);
+    ASSERT_TRUE(memory_page_tables_bytes() == before);
+
+    // First non-zero store materialises exactly one leaf; neighbours stay zero
+    memory_soa_set(g_user_write, page, 0x1000);
+    ASSERT_TRUE(memory_page_tables_bytes() == before + PAGE_LEAF_SIZE * sizeof(uintptr_t));
+    ASSERT_TRUE(memory_soa_get(g_user_write, page) == 0x1000);
+    ASSERT_TRUE(memory_soa_get(g_user_write, page + 1) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, page) == 0);
+
+    // Same for the AoS
+    memory_page_mut(page)->writable = true;
+    ASSERT_TRUE(memory_page_tables_bytes() == before + PAGE_LEAF_SIZE * (sizeof(uintptr_t) + sizeof(page_entry_t)));
+    ASSERT_TRUE(memory_page(page)->writable);
+    ASSERT_TRUE(!memory_page(page + PAGE_LEAF_SIZE)->writable);
+
+    memory_map_delete(mem);
+}
+
+TEST(test_soa_clear_zeroes_populated_leaves) {
+    memory_map_t *mem = make_map();
+    size_t before = memory_page_tables_bytes();
+
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_clear(g_user_write);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, ROM_START >> PAGE_SHIFT) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_write, (RAM_SIZE >> PAGE_SHIFT) - 1) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0) != 0); // other tables untouched
+    ASSERT_TRUE(memory_page_tables_bytes() == before); // leaves are kept for refill
+
+    memory_map_delete(mem);
+}
+
+TEST(test_soa_refill_hides_stale_entries) {
+    memory_map_t *mem = make_map();
+    uint32_t last = (RAM_SIZE >> PAGE_SHIFT) - 1;
+    uintptr_t ram0 = memory_soa_get(g_supervisor_read, 0);
+
+    // A refill reattaches the leaf; only the refilled entry comes back
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_set(g_supervisor_read, 1, 0x2000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) == 0x2000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, last) == 0);
+
+    // A zero store into a detached leaf stays a no-op
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_set(g_supervisor_read, 0, 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) == 0);
+
+    // Repeated clears without a refill in between still wipe the leaf once
+    memory_soa_set(g_supervisor_read, 0, ram0);
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_clear(g_supervisor_read);
+    memory_soa_set(g_supervisor_read, last, 0x3000);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, last) == 0x3000);
+
+    // The slow path lazily reinstalls RAM after the clear
+    memory_soa_clear(g_supervisor_read);
+    g_active_read = g_supervisor_read;
+    memory_write_uint32(0x10, 0xCAFEF00D);
+    ASSERT_TRUE(memory_read_uint32(0x10) == 0xCAFEF00D);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == ram0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, last) == 0);
+
+    memory_map_delete(mem);
+}
+
+// Time BENCH_FLUSHES invalidations of all four tables, refilling `pages`
+// RAM pages (and the read-path slow install) before each one
+static uint64_t bench_flush(uint32_t pages) {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < BENCH_FLUSHES; i++) {
+        for (uint32_t p = 0; p < pages; p++)
+            memory_soa_set(g_supervisor_read, p, memory_soa_get(g_user_read, p) | 1);
+        uint64_t t0 = now_ns();
+        memory_soa_clear(g_supervisor_read);
+        memory_soa_clear(g_supervisor_write);
+        memory_soa_clear(g_user_read);
+        memory_soa_clear(g_user_write);
+        total += now_ns() - t0;
+    }
+    return total;
+}
+
+TEST(test_bench_flush_independent_of_population) {
+    memory_map_t *mem = make_map();
+    uint64_t t_one = bench_flush(1);
+    uint64_t t_all = bench_flush(RAM_SIZE >> PAGE_SHIFT);
+    printf("[BENCH] invalidate: 1 page filled %.1f ns, %u pages filled %.1f ns\n", (double)t_one / BENCH_FLUSHES,
+           RAM_SIZE >> PAGE_SHIFT, (double)t_all / BENCH_FLUSHES);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == 0);
+    memory_map_delete(mem);
+}
+
+TEST(test_bench_flat_vs_two_level) {
+    memory_map_t *mem = make_map();
+    uint8_t *ram = ram_native_pointer(mem, 0);
+    for (uint32_t i = 0; i < RAM_SIZE; i += 4)
+        STORE_BE32(ram + i, i * 2654435761u);
+
+    // Flat replica of the supervisor read table (the default layout)
+    uintptr_t *flat = (uintptr_t *)calloc(g_page_count, sizeof(uintptr_t));
+    ASSERT_TRUE(flat != NULL);
+    for (uint32_t p = 0; p < g_page_count; p++)
+        flat[p] = memory_soa_get(g_supervisor_read, p);
+
+    // Aligned long reads, the same sequence for both layouts: scattered over
+    // all of RAM (TLB/cache hostile), then within a 64 KB hot region
+    uint32_t spans[2] = {RAM_SIZE, 0x10000};
+    uint64_t t_sparse[2], t_flat[2];
+    for (int k = 0; k < 2; k++) {
+        uint32_t sum_sparse, sum_flat;
+        t_sparse[k] = bench_reads_sparse(spans[k], &sum_sparse);
+        t_flat[k] = bench_reads_flat(flat, spans[k], &sum_flat);
+        ASSERT_TRUE(sum_sparse == sum_flat);
+    }
+
+    // Full invalidation, against the memset a flat table needs
+    uint64_t t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CLEARS; i++) {
+        memset(flat, 0, (size_t)g_page_count * sizeof(uintptr_t));
+        __asm__ volatile("" : : "r"(flat) : "memory"); // keep the dead stores
+    }
+    uint64_t c_flat = now_ns() - t0;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CLEARS; i++)
+        memory_soa_clear(g_supervisor_read);
+    uint64_t c_sparse = now_ns() - t0;
+
+    for (int k = 0; k < 2; k++)
+        printf("[BENCH] read32 over %u KB: two-level %.2f ns, flat %.2f ns\n", spans[k] >> 10,
+               (double)t_sparse[k] / BENCH_READS, (double)t_flat[k] / BENCH_READS);
+    printf("[BENCH] full SoA clear: two-level %.2f us, flat %.1f us\n", (double)c_sparse / BENCH_CLEARS / 1000.0,
+           (double)c_flat / BENCH_CLEARS / 1000.0);
+
+    free(flat);
+    memory_map_delete(mem);
+}
+
+int main(void) {
+    RUN(test_32bit_footprint_is_sparse);
+    RUN(test_zero_store_allocates_nothing);
+    RUN(test_soa_clear_zeroes_populated_leaves);
+    RUN(test_soa_refill_hides_stale_entries);
+    RUN(test_bench_flush_independent_of_population);
+    RUN(test_bench_flat_vs_two_level);
+    printf("[PASS] All sparse page-table tests passed\n");
+    return 0;
+}
@@ -52,25 +52,25 @@ TEST(test_soa_identity_mapping) {
     memory_populate_pages(mem, 0x40000000, 0x40080000);
 
     // RAM page 0: should have non-zero entries in all 4 SoA arrays
-    ASSERT_TRUE(g_supervisor_read[0] != 0);
-    ASSERT_TRUE(g_supervisor_write[0] != 0);
-    ASSERT_TRUE(g_user_read[0] != 0);
-    ASSERT_TRUE(g_user_write[0] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_user_write, 0) != 0);
 
     // RAM page 1 (0x1000): should also be populated
-    ASSERT_TRUE(g_supervisor_read[1] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) != 0);
 
     // ROM page at 0x40000000: read-only (read entries non-zero, write entries zero)
     uint32_t rom_page = 0x40000000 >> PAGE_SHIFT;
-    ASSERT_TRUE(g_supervisor_read[rom_page] != 0);
-    ASSERT_TRUE(g_supervisor_write[rom_page] == 0); // ROM is read-only
-    ASSERT_TRUE(g_user_read[rom_page] != 0);
-    ASSERT_TRUE(g_user_write[rom_page] == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, rom_page) != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, rom_page) == 0); // ROM is read-only
+    ASSERT_TRUE(memory_soa_get(g_user_read, rom_page) != 0);
+    ASSERT_TRUE(memory_soa_get(g_user_write, rom_page) == 0);
 
     // Unmapped page (e.g., 0x80000000): should have zero entries
     uint32_t unmapped_page = 0x80000000 >> PAGE_SHIFT;
-    ASSERT_TRUE(g_supervisor_read[unmapped_page] == 0);
-    ASSERT_TRUE(g_supervisor_write[unmapped_page] == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, unmapped_page) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, unmapped_page) == 0);
 
     // Verify read/write through SoA fast path
     // Active pointers should be set to supervisor arrays by default
@@ -117,18 +117,18 @@ TEST(test_tlb_invalidation) {
     memory_populate_pages(mem, 0x40000000, 0x40080000);
 
     // Verify some entries are non-zero before invalidation
-    ASSERT_TRUE(g_supervisor_read[0] != 0);
-    ASSERT_TRUE(g_supervisor_write[0] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 0) != 0);
 
     mmu_state_t *mmu = mmu_init(ram_native_pointer(mem, 0), 0x400000, 0x8000000, NULL, 0, 0, 0);
     mmu->enabled = true; // TLB invalidation only zeroes when MMU is enabled
     mmu_invalidate_tlb(mmu);
 
     // After invalidation, all entries should be zero
-    ASSERT_TRUE(g_supervisor_read[0] == 0);
-    ASSERT_TRUE(g_supervisor_write[0] == 0);
-    ASSERT_TRUE(g_user_read[0] == 0);
-    ASSERT_TRUE(g_user_write[0] == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_write, 0) == 0);
 
     cleanup(mem, mmu);
 }
@@ -191,7 +191,7 @@ TEST(test_two_level_translation) {
     ASSERT_TRUE(ok);
 
     // Verify SoA entry was populated for page 0
-    ASSERT_TRUE(g_supervisor_read[0] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) != 0);
 
     // Test PTEST for logical address 0x00001000
     uint16_t mmusr = mmu_test_address(mmu, 0x00001000, false, true, NULL);
@@ -202,7 +202,7 @@ TEST(test_two_level_translation) {
     ok = mmu_handle_fault(mmu, 0x00001042, false, true);
     ASSERT_TRUE(ok);
     // SoA entry for page at 0x00001000 should be populated
-    ASSERT_TRUE(g_supervisor_read[1] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) != 0);
 
     cleanup(mem, mmu);
 }
@@ -345,7 +345,7 @@ TEST(test_transparent_translation) {
     bool ok = mmu_handle_fault(mmu, 0x00001000, false, true);
     ASSERT_TRUE(ok);
     // SoA entry should be populated
-    ASSERT_TRUE(g_supervisor_read[1] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 1) != 0);
 
     // PTEST should report transparent translation
     uint16_t mmusr = mmu_test_address(mmu, 0x00002000, false, true, NULL);
@@ -384,10 +384,10 @@ TEST(test_write_protection) {
     // Read should succeed
     bool ok = mmu_handle_fault(mmu, 0x00000000, false, true);
     ASSERT_TRUE(ok);
-    ASSERT_TRUE(g_supervisor_read[0] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) != 0);
 
     // Write array should remain 0 (write-protected)
-    ASSERT_TRUE(g_supervisor_write[0] == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 0) == 0);
 
     // Write fault should fail
     mmu_invalidate_tlb(mmu);
@@ -439,10 +439,10 @@ TEST(test_supervisor_only_pages) {
     bool ok = mmu_handle_fault(mmu, 0x00000000, false, true);
     ASSERT_TRUE(ok);
     // Supervisor read should be populated
-    ASSERT_TRUE(g_supervisor_read[0] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) != 0);
     // User read should NOT be populated (supervisor-only)
-    ASSERT_TRUE(g_user_read[0] == 0);
-    ASSERT_TRUE(g_user_write[0] == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0) == 0);
+    ASSERT_TRUE(memory_soa_get(g_user_write, 0) == 0);
 
     // User access should fail
     mmu_invalidate_tlb(mmu);
@@ -464,10 +464,10 @@ TEST(test_24bit_soa_compatibility) {
     memory_populate_pages(mem, 0x400000, 0x580000);
 
     // RAM page 0: all four SoA arrays populated
-    ASSERT_TRUE(g_supervisor_read[0] != 0);
-    ASSERT_TRUE(g_supervisor_write[0] != 0);
-    ASSERT_TRUE(g_user_read[0] != 0);
-    ASSERT_TRUE(g_user_write[0] != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_user_read, 0) != 0);
+    ASSERT_TRUE(memory_soa_get(g_user_write, 0) != 0);
 
     // Active pointers default to supervisor
     ASSERT_TRUE(g_active_read == g_supervisor_read);
@@ -478,8 +478,8 @@ TEST(test_24bit_soa_compatibility) {
 
     // ROM page: read-only
     uint32_t rom_page_idx = 0x400000 >> PAGE_SHIFT;
-    ASSERT_TRUE(g_supervisor_read[rom_page_idx] != 0);
-    ASSERT_TRUE(g_supervisor_write[rom_page_idx] == 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_read, rom_page_idx) != 0);
+    ASSERT_TRUE(memory_soa_get(g_supervisor_write, rom_page_idx) == 0);
 
     cleanup(mem, NULL);
 }
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 static void w_u16(uint8_t *p, uint16_t v) {
     p[0] = (uint8_t)(v >> 8);
@@ -270,6 +271,117 @@ TEST(ndif_decode_rejects_unsupported_type) {
     ASSERT_EQ_INT(-EINVAL, ndif_decode_chunk(&c, src, sizeof(src), dst, sizeof(dst)));
 }
 
+// ---- On-demand reader -------------------------------------------------------
+
+// Write a data fork to a temporary host file; returns its path in `path`.
+static void write_data_fork(char *path, const uint8_t *data, size_t len) {
+    strcpy(path, "/tmp/gs-ndif-test-XXXXXX");
+    int fd = mkstemp(path);
+    ASSERT_TRUE(fd >= 0);
+    ASSERT_EQ_INT((int)len, (int)write(fd, data, len));
+    close(fd);
+}
+
+TEST(ndif_reader_decodes_on_demand) {
+    // Sectors 0..11: one ADC chunk each, filled with the sector number.
+    // Sector 12: COPY of 0x11.  Sectors 13..14: ZERO.  sectors = 15.
+    enum { ADC_CHUNKS = 12 };
+    uint8_t fork_data[ADC_CHUNKS * 64 + 512];
+    uint32_t words[ADC_CHUNKS + 3], offs[ADC_CHUNKS + 3], lens[ADC_CHUNKS + 3];
+    size_t at = 0;
+    for (uint32_t i = 0; i < ADC_CHUNKS; i++) {
+        size_t n = adc_fill(fork_data + at, (uint8_t)(0xA0 + i), 512);
+        words[i] = (i << 8) | NDIF_CHUNK_ADC;
+        offs[i] = (uint32_t)at;
+        lens[i] = (uint32_t)n;
+        at += n;
+    }
+    memset(fork_data + at, 0x11, 512);
+    words[ADC_CHUNKS] = (ADC_CHUNKS << 8) | NDIF_CHUNK_COPY;
+    offs[ADC_CHUNKS] = (uint32_t)at;
+    lens[ADC_CHUNKS] = 512;
+    at += 512;
+    words[ADC_CHUNKS + 1] = ((ADC_CHUNKS + 1) << 8) | NDIF_CHUNK_ZERO;
+    offs[ADC_CHUNKS + 1] = lens[ADC_CHUNKS + 1] = 0;
+    words[ADC_CHUNKS + 2] = ((ADC_CHUNKS + 3) << 8) | NDIF_CHUNK_END;
+    offs[ADC_CHUNKS + 2] = lens[ADC_CHUNKS + 2] = 0;
+
+    size_t blen = 0, flen = 0;
+    uint8_t *bcem = build_bcem(ADC_CHUNKS + 3, 0, "Lazy", words, offs, lens, ADC_CHUNKS + 3, &blen);
+    uint8_t *fork = build_bcem_fork(bcem, blen, &flen);
+    char path[64];
+    write_data_fork(path, fork_data, at);
+
+    ndif_map_t *m = NULL;
+    ASSERT_EQ_INT(0, ndif_parse(fork, flen, &m));
+    ndif_reader_t *r = NULL;
+    ASSERT_EQ_INT(0, ndif_reader_open(path, m, &r));
+    ASSERT_EQ_INT((ADC_CHUNKS + 3) * 512, (int)ndif_reader_size(r));
+    ASSERT_EQ_INT(0, (int)ndif_reader_decodes(r)); // nothing decoded up front
+
+    // A read across two ADC chunks decodes just those two
+    uint8_t buf[1024];
+    ASSERT_EQ_INT(0, ndif_reader_read(r, 5 * 512 + 256, buf, 512));
+    for (int i = 0; i < 256; i++) {
+        ASSERT_EQ_INT(0xA5, buf[i]);
+        ASSERT_EQ_INT(0xA6, buf[256 + i]);
+    }
+    ASSERT_EQ_INT(2, (int)ndif_reader_decodes(r));
+    ASSERT_EQ_INT(0, ndif_reader_read(r, 5 * 512, buf, 512));
+    ASSERT_EQ_INT(2, (int)ndif_reader_decodes(r)); // cached
+
+    // COPY and ZERO chunks, and the end of the image, need no decoding
+    ASSERT_EQ_INT(0, ndif_reader_read(r, ADC_CHUNKS * 512, buf, 1024));
+    for (int i = 0; i < 512; i++) {
+        ASSERT_EQ_INT(0x11, buf[i]);
+        ASSERT_EQ_INT(0, buf[512 + i]);
+    }
+    memset(buf, 0xFF, sizeof(buf));
+    ASSERT_EQ_INT(0, ndif_reader_read(r, (ADC_CHUNKS + 2) * 512, buf, 1024));
+    for (int i = 0; i < 1024; i++)
+        ASSERT_EQ_INT(0, buf[i]);
+    ASSERT_EQ_INT(2, (int)ndif_reader_decodes(r));
+
+    // Touching every ADC chunk evicts the least recently used ones
+    for (uint32_t i = 0; i < ADC_CHUNKS; i++) {
+        ASSERT_EQ_INT(0, ndif_reader_read(r, (uint64_t)i * 512, buf, 512));
+        ASSERT_EQ_INT(0xA0 + (int)i, buf[511]);
+    }
+    ASSERT_EQ_INT(ADC_CHUNKS, (int)ndif_reader_decodes(r));
+    ASSERT_EQ_INT(0, ndif_reader_read(r, (ADC_CHUNKS - 1) * 512, buf, 512));
+    ASSERT_EQ_INT(ADC_CHUNKS, (int)ndif_reader_decodes(r));
+    ASSERT_EQ_INT(0, ndif_reader_read(r, 0, buf, 512));
+    ASSERT_EQ_INT(ADC_CHUNKS + 1, (int)ndif_reader_decodes(r));
+    ASSERT_EQ_INT(0xA0, buf[0]);
+
+    ndif_reader_close(r);
+    unlink(path);
+    free(bcem);
+    free(fork);
+}
+
+TEST(ndif_reader_rejects_unsupported_chunks) {
+    uint32_t words[] = {(0u << 8) | NDIF_CHUNK_COPY, (1u << 8) | NDIF_CHUNK_LZH, (2u << 8) | NDIF_CHUNK_END};
+    uint32_t offs[] = {0, 512, 0};
+    uint32_t lens[] = {512, 16, 0};
+    size_t blen = 0, flen = 0;
+    uint8_t *bcem = build_bcem(2, 0, "LZH", words, offs, lens, 3, &blen);
+    uint8_t *fork = build_bcem_fork(bcem, blen, &flen);
+    uint8_t data[528] = {0};
+    char path[64];
+    write_data_fork(path, data, sizeof(data));
+
+    ndif_map_t *m = NULL;
+    ASSERT_EQ_INT(0, ndif_parse(fork, flen, &m));
+    ndif_reader_t *r = NULL;
+    ASSERT_EQ_INT(-EINVAL, ndif_reader_open(path, m, &r)); // frees m
+    ASSERT_TRUE(r == NULL);
+
+    unlink(path);
+    free(bcem);
+    free(fork);
+}
+
 int main(void) {
     RUN(adc_literal_run);
     RUN(adc_short_match_rle);
@@ -280,6 +392,8 @@ int main(void) {
     RUN(ndif_detect_false_on_plain_fork);
     RUN(ndif_decode_copy_zero_adc);
     RUN(ndif_decode_rejects_unsupported_type);
+    RUN(ndif_reader_decodes_on_demand);
+    RUN(ndif_reader_rejects_unsupported_chunks);
     fprintf(stderr, "All ndif tests passed.\n");
     return 0;
 }
@@ -52,6 +52,18 @@
 //   - max_speed caps both the governor and pinned speeds
 //   - pin/unpin: writing a speed pins (governor off), 0 returns to auto and
 //     restarts from the authentic floor
+//
+// Idle-loop fast-forward (scheduler.idle; the stub CPU can pretend to sit in
+// a polling loop of a given length):
+//   - 'on' reaches the same cycles, instruction and event counts as 'off'
+//     while actually executing far fewer instructions
+//   - 'verify' executes everything, with the same timeline
+//   - busy code (no loop found) is unaffected
+//
+// Event queue (binary heap with per-event positions), thousands pending:
+//   - fire order matches a stable sort by timestamp (ties first-in first-out)
+//   - cancel by handle, remove_event_by_data and remove_event by source
+//   - a checkpoint round trip re-creates the same fire order
 
 #include "object.h"
 #include "scheduler.h"
@@ -105,19 +117,54 @@ bool debug_active(debug_t *debug) {
 int debug_break_and_trace(void) {
     return 0;
 }
+void debug_pc_watch_arm(uint32_t pc) {
+    (void)pc;
+}
 
 void trigger_vbl(config_t *restrict config) {
     (void)config;
     g_vbls++;
 }
 
+void history_frame_begin(config_t *config) {
+    (void)config;
+}
+void history_frame_end(config_t *config) {
+    (void)config;
+}
+
+// Stub idle loop: with g_idle_loop_len > 0 the CPU state repeats every
+// g_idle_loop_len executed instructions (g_idle_pos is the position in the
+// loop); with 0 the code is busy and never repeats.
+static uint32_t g_idle_loop_len;
+static uint32_t g_idle_pos, g_idle_mark_pos;
+static uint64_t g_executed; // instructions the stub CPU actually ran
+
 // Stub CPU: every sprint retires all its instructions instantly, advancing
 // the fake host clock by the configured per-instruction cost.
 void cpu_run_sprint(cpu_t *restrict cpu, uint32_t *instructions) {
     (void)cpu;
     g_now += (double)*instructions * g_secs_per_instr;
+    g_executed += *instructions;
+    if (g_idle_loop_len != 0)
+        g_idle_pos = (uint32_t)((g_idle_pos + *instructions) % g_idle_loop_len);
     *instructions = 0;
 }
+cpu_idle_t cpu_idle_mark(cpu_t *restrict cpu) {
+    (void)cpu;
+    g_idle_mark_pos = g_idle_pos;
+    return g_idle_loop_len != 0 ? CPU_IDLE_MAYBE : CPU_IDLE_NO;
+}
+cpu_idle_t cpu_idle_step(cpu_t *restrict cpu) {
+    (void)cpu;
+    if (g_idle_loop_len == 0)
+        return CPU_IDLE_NO;
+    return g_idle_pos == g_idle_mark_pos ? CPU_IDLE_LOOP : CPU_IDLE_MAYBE;
+}
+uint32_t cpu_get_pc(cpu_t *restrict cpu) {
+    (void)cpu;
+    return 0;
+}
 bool cpu_is_stopped(cpu_t *restrict cpu) {
     (void)cpu;
     return false;
@@ -138,21 +185,27 @@ uint32_t g_sprint_frac_x256 = 0;
 uint32_t g_sprint_total_slots = 0;
 uint32_t g_esync_period_x256 = 0;
 
-// Checkpointing is not exercised here (integration checkpoint tests cover it).
+// Checkpoint stream: a flat in-memory buffer, written and then read back in
+// order (the queue round-trip test; integration checkpoint tests cover the rest).
+static uint8_t g_ckpt_buf[1 << 20];
+static size_t g_ckpt_len, g_ckpt_pos;
+
 void system_read_checkpoint_data_loc(checkpoint_t *checkpoint, void *data, size_t size, const char *file, int line) {
     (void)checkpoint;
-    (void)data;
-    (void)size;
     (void)file;
     (void)line;
+    ASSERT_TRUE(g_ckpt_pos + size <= g_ckpt_len);
+    memcpy(data, g_ckpt_buf + g_ckpt_pos, size);
+    g_ckpt_pos += size;
 }
 void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data, size_t size, const char *file,
                                       int line) {
     (void)checkpoint;
-    (void)data;
-    (void)size;
     (void)file;
     (void)line;
+    ASSERT_TRUE(g_ckpt_len + size <= sizeof(g_ckpt_buf));
+    memcpy(g_ckpt_buf + g_ckpt_len, data, size);
+    g_ckpt_len += size;
 }
 
 // Object tree: the scheduler tolerates a NULL binding (object_new failure
@@ -818,6 +871,213 @@ TEST(test_governor_pin_unpin) {
     teardown(s);
 }
 
+// Run 200 headless frame-units (with the ping event in flight) under the
+// given idle mode and stub loop length; reports the timeline and how many
+// instructions the stub CPU really executed.
+static void idle_run(enum idle_mode mode, uint32_t loop_len, uint64_t *cycles, uint64_t *instr, uint64_t *pings,
+                     uint64_t *executed) {
+    scheduler_t *s = fresh_scheduler(true);
+    scheduler_set_idle_mode(s, mode);
+    g_idle_loop_len = loop_len;
+    g_idle_pos = 0;
+    g_executed = 0;
+    for (int f = 0; f < 200; f++)
+        scheduler_run_frame(s, TEST_CFG);
+    *cycles = scheduler_cpu_cycles(s);
+    *instr = cpu_instr_count();
+    *pings = g_pings;
+    *executed = g_executed;
+    scheduler_set_idle_mode(s, idle_off);
+    g_idle_loop_len = 0;
+    teardown(s);
+}
+
+// A proven idle loop is fast-forwarded without changing the guest timeline;
+// verify mode runs every instruction on the same timeline.
+TEST(test_idle_fast_forward_timeline) {
+    uint64_t c_off, i_off, p_off, x_off;
+    uint64_t c_on, i_on, p_on, x_on;
+    uint64_t c_ver, i_ver, p_ver, x_ver;
+    idle_run(idle_off, 3, &c_off, &i_off, &p_off, &x_off);
+    idle_run(idle_on, 3, &c_on, &i_on, &p_on, &x_on);
+    idle_run(idle_verify, 3, &c_ver, &i_ver, &p_ver, &x_ver);
+
+    ASSERT_TRUE(x_off == i_off);
+    ASSERT_TRUE(c_on == c_off);
+    ASSERT_TRUE(i_on == i_off);
+    ASSERT_TRUE(p_on == p_off);
+    ASSERT_TRUE(x_on * 20 < x_off); // only probes and loop remainders ran
+
+    ASSERT_TRUE(c_ver == c_off);
+    ASSERT_TRUE(i_ver == i_off);
+    ASSERT_TRUE(p_ver == p_off);
+    ASSERT_TRUE(x_ver == x_off);
+}
+
+// Busy code never confirms a loop, so everything executes as usual
+TEST(test_idle_busy_code_unaffected) {
+    uint64_t c_off, i_off, p_off, x_off;
+    uint64_t c_on, i_on, p_on, x_on;
+    idle_run(idle_off, 0, &c_off, &i_off, &p_off, &x_off);
+    idle_run(idle_on, 0, &c_on, &i_on, &p_on, &x_on);
+    ASSERT_TRUE(c_on == c_off);
+    ASSERT_TRUE(i_on == i_off);
+    ASSERT_TRUE(p_on == p_off);
+    ASSERT_TRUE(x_on == x_off);
+}
+
+// --- Event queue stress ------------------------------------------------------
+//
+// The queue is a binary heap ordered on (timestamp, insertion order).  These
+// cases pin the fire order to that of a stable sort by timestamp — the order
+// the original sorted list produced — with thousands of events pending.
+
+#define STRESS_EVENTS 4000
+
+static uint32_t g_fired[STRESS_EVENTS]; // event ids (the data word) in fire order
+static int g_num_fired;
+static int g_src_a, g_src_b; // two event sources sharing one callback
+
+static void record_event(void *source, uint64_t data) {
+    (void)source;
+    ASSERT_TRUE(g_num_fired < STRESS_EVENTS);
+    g_fired[g_num_fired++] = (uint32_t)data;
+}
+
+// Deterministic timestamp generator; few distinct values so ties abound
+static uint64_t stress_delay(uint32_t *state) {
+    *state = *state * 1103515245u + 12345u;
+    return 1 + ((*state >> 16) % 97) * 1000;
+}
+
+// A scheduler with the record_event types registered for both sources
+static scheduler_t *stress_scheduler(void) {
+    scheduler_t *s = fresh_scheduler(false);
+    scheduler_new_event_type(s, "test", &g_src_a, "record_a", record_event);
+    scheduler_new_event_type(s, "test", &g_src_b, "record_b", record_event);
+    g_num_fired = 0;
+    return s;
+}
+
+// Run until every stress event is due (delays stay below 100,000 cycles)
+static void stress_drain(scheduler_t *s) {
+    scheduler_run_instructions(s, 200000 / DEFAULT_CPI);
+}
+
+// Stable insertion sort of ids by delay: the reference fire order
+static void reference_order(const uint64_t *delay, const bool *live, int n, uint32_t *out, int *out_n) {
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        if (!live[i])
+            continue;
+        int j = m;
+        while (j > 0 && delay[out[j - 1]] > delay[i]) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = (uint32_t)i;
+        m++;
+    }
+    *out_n = m;
+}
+
+static uint64_t g_delay[STRESS_EVENTS];
+static bool g_live[STRESS_EVENTS];
+static uint32_t g_expect[STRESS_EVENTS];
+
+// Thousands of pending events with heavily duplicated timestamps fire in
+// timestamp order, first-in first-out among equals
+TEST(test_event_queue_fire_order_stress) {
+    scheduler_t *s = stress_scheduler();
+    uint32_t rng = 1;
+    for (int i = 0; i < STRESS_EVENTS; i++) {
+        g_delay[i] = stress_delay(&rng);
+        g_live[i] = true;
+        scheduler_new_cpu_event(s, record_event, (i & 1) ? &g_src_b : &g_src_a, (uint64_t)i, g_delay[i], 0);
+    }
+    ASSERT_TRUE(has_event(s, record_event));
+
+    stress_drain(s);
+    int n;
+    reference_order(g_delay, g_live, STRESS_EVENTS, g_expect, &n);
+    ASSERT_EQ_INT(n, g_num_fired);
+    ASSERT_TRUE(memcmp(g_fired, g_expect, (size_t)n * sizeof(uint32_t)) == 0);
+    ASSERT_TRUE(!has_event(s, record_event));
+    teardown(s);
+}
+
+// Cancelling by handle, by data and by source leaves the survivors in order
+TEST(test_event_queue_cancel_stress) {
+    scheduler_t *s = stress_scheduler();
+    static event_t *handles[STRESS_EVENTS];
+    uint32_t rng = 7;
+    for (int i = 0; i < STRESS_EVENTS; i++) {
+        g_delay[i] = stress_delay(&rng);
+        g_live[i] = true;
+        // Every tenth event goes to source B; the rest to A
+        handles[i] = scheduler_new_cpu_event(s, record_event, (i % 10 == 9) ? &g_src_b : &g_src_a, (uint64_t)i,
+                                             g_delay[i], 0);
+    }
+
+    // Cancel every third source-A event by handle
+    for (int i = 0; i < STRESS_EVENTS; i += 3) {
+        if (i % 10 == 9)
+            continue;
+        scheduler_cancel_event(s, handles[i]);
+        g_live[i] = false;
+    }
+    // Drop a few by data, then all of source B
+    for (int i = 1; i < STRESS_EVENTS; i += 97) {
+        remove_event_by_data(s, record_event, (i % 10 == 9) ? &g_src_b : &g_src_a, (uint64_t)i);
+        g_live[i] = false;
+    }
+    remove_event(s, record_event, &g_src_b);
+    for (int i = 9; i < STRESS_EVENTS; i += 10)
+        g_live[i] = false;
+    ASSERT_TRUE(has_event(s, record_event));
+
+    stress_drain(s);
+    int n;
+    reference_order(g_delay, g_live, STRESS_EVENTS, g_expect, &n);
+    ASSERT_EQ_INT(n, g_num_fired);
+    ASSERT_TRUE(memcmp(g_fired, g_expect, (size_t)n * sizeof(uint32_t)) == 0);
+    teardown(s);
+}
+
+// Events re-inserted from a checkpoint keep their fire order, ties included
+TEST(test_event_queue_checkpoint_order) {
+    scheduler_t *s = stress_scheduler();
+    uint32_t rng = 3;
+    for (int i = 0; i < STRESS_EVENTS / 2; i++) {
+        g_delay[i] = stress_delay(&rng);
+        scheduler_new_cpu_event(s, record_event, (i % 3 == 0) ? &g_src_b : &g_src_a, (uint64_t)i, g_delay[i], 0);
+    }
+    // Cancel a scattered handful so the heap layout is not insertion order
+    for (int i = 0; i < STRESS_EVENTS / 2; i += 37)
+        remove_event_by_data(s, record_event, (i % 3 == 0) ? &g_src_b : &g_src_a, (uint64_t)i);
+
+    int dummy_checkpoint;
+    g_ckpt_len = g_ckpt_pos = 0;
+    scheduler_checkpoint(s, (checkpoint_t *)&dummy_checkpoint);
+    stress_drain(s);
+    int n = g_num_fired;
+    memcpy(g_expect, g_fired, (size_t)n * sizeof(uint32_t));
+    teardown(s);
+
+    s = scheduler_init(TEST_CPU, (checkpoint_t *)&dummy_checkpoint);
+    ASSERT_TRUE(s != NULL);
+    g_sched = s;
+    ASSERT_TRUE(g_ckpt_pos == g_ckpt_len);
+    scheduler_new_event_type(s, "test", &g_src_a, "record_a", record_event);
+    scheduler_new_event_type(s, "test", &g_src_b, "record_b", record_event);
+    scheduler_start(s);
+    g_num_fired = 0;
+    stress_drain(s);
+    ASSERT_EQ_INT(n, g_num_fired);
+    ASSERT_TRUE(memcmp(g_fired, g_expect, (size_t)n * sizeof(uint32_t)) == 0);
+    teardown(s);
+}
+
 int main(void) {
     RUN(test_paced_rate_60hz);
     RUN(test_paced_rate_5994hz);
@@ -839,6 +1099,11 @@ int main(void) {
     RUN(test_governor_audio_pressure);
     RUN(test_governor_max_speed_cap);
     RUN(test_governor_pin_unpin);
+    RUN(test_idle_fast_forward_timeline);
+    RUN(test_idle_busy_code_unaffected);
+    RUN(test_event_queue_fire_order_stress);
+    RUN(test_event_queue_cancel_stress);
+    RUN(test_event_queue_checkpoint_order);
     fprintf(stderr, "[OK  ] scheduler suite passed\n");
     return 0;
 }
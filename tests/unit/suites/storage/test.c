@@ -5,6 +5,7 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -278,6 +279,352 @@ TEST(storage_rollback) {
     ASSERT_OK(storage_read_block(storage, 5 * STORAGE_BLOCK_SIZE, verify));
     expect_block(5, 0x10, verify);
 
+    // A block first written since the commit has no preimage (the journal
+    // stays empty) and rolls back to the base
+    fill_block(9, 0x50, block);
+    ASSERT_OK(storage_write_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    ASSERT_OK(storage_apply_rollback(storage));
+    ASSERT_OK(storage_read_block(storage, 9 * STORAGE_BLOCK_SIZE, verify));
+    expect_block(9, 0xBB, verify);
+    ASSERT_OK(storage_read_block(storage, 5 * STORAGE_BLOCK_SIZE, verify));
+    expect_block(5, 0x10, verify);
+
+    ASSERT_OK(storage_delete(storage));
+    teardown_sandbox();
+}
+
+TEST(storage_multi_block_io) {
+    setup_sandbox();
+    create_base_image(BASE_FILE, TEST_BLOCKS, 0xCC);
+    storage_config_t config = make_config(BASE_FILE, DELTA_FILE, JOURNAL_FILE, TEST_BLOCKS);
+    storage_t *storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+
+    // Blocks 10..13 and 16 modified and committed
+    uint8_t buffer[16 * STORAGE_BLOCK_SIZE];
+    for (size_t i = 0; i < 4; i++)
+        fill_block(10 + i, 0x10, buffer + i * STORAGE_BLOCK_SIZE);
+    ASSERT_OK(storage_write_blocks(storage, 10 * STORAGE_BLOCK_SIZE, buffer, 4));
+    fill_block(16, 0x10, buffer);
+    ASSERT_OK(storage_write_block(storage, 16 * STORAGE_BLOCK_SIZE, buffer));
+    ASSERT_OK(storage_clear_rollback(storage));
+
+    // A read spanning base and delta runs sees each block from the right file
+    ASSERT_OK(storage_read_blocks(storage, 8 * STORAGE_BLOCK_SIZE, buffer, 12));
+    for (size_t lba = 8; lba < 20; lba++) {
+        bool modified = (lba >= 10 && lba < 14) || lba == 16;
+        expect_block(lba, modified ? 0x10 : 0xCC, buffer + (lba - 8) * STORAGE_BLOCK_SIZE);
+    }
+
+    // Overwrite 12..17: committed blocks get preimages, the rest do not need any
+    for (size_t lba = 12; lba < 18; lba++)
+        fill_block(lba, 0x50, buffer + (lba - 12) * STORAGE_BLOCK_SIZE);
+    ASSERT_OK(storage_write_blocks(storage, 12 * STORAGE_BLOCK_SIZE, buffer, 6));
+    ASSERT_OK(storage_read_blocks(storage, 10 * STORAGE_BLOCK_SIZE, buffer, 8));
+    for (size_t lba = 10; lba < 18; lba++)
+        expect_block(lba, lba < 12 ? 0x10 : 0x50, buffer + (lba - 10) * STORAGE_BLOCK_SIZE);
+
+    // Rollback restores the committed blocks and drops the new ones
+    ASSERT_OK(storage_apply_rollback(storage));
+    ASSERT_OK(storage_read_blocks(storage, 10 * STORAGE_BLOCK_SIZE, buffer, 8));
+    for (size_t lba = 10; lba < 18; lba++) {
+        bool committed = lba < 14 || lba == 16;
+        expect_block(lba, committed ? 0x10 : 0xCC, buffer + (lba - 10) * STORAGE_BLOCK_SIZE);
+    }
+
+    // Ranges must stay inside the disk
+    ASSERT_ERR(storage_read_blocks(storage, (TEST_BLOCKS - 2) * STORAGE_BLOCK_SIZE, buffer, 3), GS_ERROR);
+    ASSERT_ERR(storage_write_blocks(storage, (TEST_BLOCKS - 1) * STORAGE_BLOCK_SIZE, buffer, 2), GS_ERROR);
+
+    ASSERT_OK(storage_delete(storage));
+    teardown_sandbox();
+}
+
+// --- Sparse delta (format 2) ---------------------------------------------
+// Modified blocks are appended to an extent area and found through an index,
+// so the delta's size follows the blocks written, not the disk.
+
+#define DELTA_DATA_OFFSET 512 // extent area start in a format 2 delta
+
+static long file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+TEST(storage_sparse_delta) {
+    setup_sandbox();
+    const uint64_t blocks = 4u << 20; // a 2 GB disk
+    storage_config_t config = make_config(NULL, DELTA_FILE, JOURNAL_FILE, blocks);
+    storage_t *storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+
+    // A run of 60 blocks in the middle plus four far-apart ones
+    uint8_t buffer[60 * STORAGE_BLOCK_SIZE];
+    for (size_t i = 0; i < 60; i++)
+        fill_block((2u << 20) + i, 0x21, buffer + i * STORAGE_BLOCK_SIZE);
+    ASSERT_OK(storage_write_blocks(storage, (size_t)(2u << 20) * STORAGE_BLOCK_SIZE, buffer, 60));
+    const size_t scattered[] = {0, 1u << 20, 3u << 20, (4u << 20) - 1};
+    for (size_t i = 0; i < 4; i++) {
+        fill_block(scattered[i], 0x21, buffer);
+        ASSERT_OK(storage_write_block(storage, scattered[i] * STORAGE_BLOCK_SIZE, buffer));
+    }
+    ASSERT_OK(storage_clear_rollback(storage));
+    ASSERT_OK(storage_delete(storage));
+
+    // 64 blocks plus a one-block index, not 2 GB
+    ASSERT_EQ_INT(DELTA_DATA_OFFSET + 65 * STORAGE_BLOCK_SIZE, file_size(DELTA_FILE));
+
+    storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+    ASSERT_OK(storage_read_blocks(storage, (size_t)((2u << 20) - 2) * STORAGE_BLOCK_SIZE, buffer, 60));
+    for (size_t i = 0; i < 2; i++)
+        for (size_t b = 0; b < STORAGE_BLOCK_SIZE; b++)
+            ASSERT_TRUE(buffer[i * STORAGE_BLOCK_SIZE + b] == 0); // never written
+    for (size_t i = 2; i < 60; i++)
+        expect_block((2u << 20) - 2 + i, 0x21, buffer + i * STORAGE_BLOCK_SIZE);
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_OK(storage_read_block(storage, scattered[i] * STORAGE_BLOCK_SIZE, buffer));
+        expect_block(scattered[i], 0x21, buffer);
+    }
+    ASSERT_OK(storage_delete(storage));
+    teardown_sandbox();
+}
+
+TEST(storage_delta_v1_migration) {
+    setup_sandbox();
+    create_base_image(BASE_FILE, TEST_BLOCKS, 0x44);
+
+    // A version 1 delta: header, current and committed bitmaps, then the
+    // block area addressed by LBA; blocks 3 and 70 modified and committed
+    const size_t bm = TEST_BLOCKS / 8;
+    uint8_t header[24] = {'G', 'S', 'D', 'L', 1};
+    uint64_t count = TEST_BLOCKS;
+    uint32_t bsize = STORAGE_BLOCK_SIZE;
+    memcpy(header + 8, &count, sizeof(count));
+    memcpy(header + 16, &bsize, sizeof(bsize));
+    uint8_t bitmap[TEST_BLOCKS / 8] = {0};
+    bitmap[3 / 8] |= 1u << (3 % 8);
+    bitmap[70 / 8] |= 1u << (70 % 8);
+    FILE *f = fopen(DELTA_FILE, "wb");
+    ASSERT_TRUE(f != NULL);
+    ASSERT_TRUE(fwrite(header, sizeof(header), 1, f) == 1);
+    ASSERT_TRUE(fwrite(bitmap, bm, 1, f) == 1);
+    ASSERT_TRUE(fwrite(bitmap, bm, 1, f) == 1);
+    uint8_t block[STORAGE_BLOCK_SIZE];
+    for (size_t lba = 0; lba <= 70; lba++) {
+        fill_block(lba, 0x70, block);
+        ASSERT_TRUE(fwrite(block, sizeof(block), 1, f) == 1);
+    }
+    fclose(f);
+
+    storage_config_t config = make_config(BASE_FILE, DELTA_FILE, JOURNAL_FILE, TEST_BLOCKS);
+    storage_t *storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+    for (size_t lba = 0; lba < TEST_BLOCKS; lba++) {
+        ASSERT_OK(storage_read_block(storage, lba * STORAGE_BLOCK_SIZE, block));
+        expect_block(lba, lba == 3 || lba == 70 ? 0x70 : 0x44, block);
+    }
+    ASSERT_OK(storage_delete(storage));
+
+    // Rewritten as format 2: two blocks and their index
+    f = fopen(DELTA_FILE, "rb");
+    ASSERT_TRUE(f != NULL);
+    ASSERT_TRUE(fread(header, sizeof(header), 1, f) == 1);
+    fclose(f);
+    ASSERT_EQ_INT(2, header[4]);
+    ASSERT_EQ_INT(DELTA_DATA_OFFSET + 3 * STORAGE_BLOCK_SIZE, file_size(DELTA_FILE));
+
+    storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+    ASSERT_OK(storage_read_block(storage, 70 * STORAGE_BLOCK_SIZE, block));
+    expect_block(70, 0x70, block);
+    ASSERT_OK(storage_delete(storage));
+    teardown_sandbox();
+}
+
+TEST(storage_delta_compaction) {
+    setup_sandbox();
+    const uint64_t blocks = 4096;
+    create_base_image(BASE_FILE, blocks, 0x33);
+    storage_config_t config = make_config(BASE_FILE, DELTA_FILE, JOURNAL_FILE, blocks);
+    storage_t *storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+
+    // Blocks written in descending order land in ascending slots
+    uint8_t block[STORAGE_BLOCK_SIZE];
+    for (size_t lba = 100; lba-- > 0;) {
+        fill_block(lba, 0x60, block);
+        ASSERT_OK(storage_write_block(storage, lba * STORAGE_BLOCK_SIZE, block));
+    }
+    ASSERT_OK(storage_clear_rollback(storage));
+
+    // A committed block overwritten and 3000 new ones, then rolled back: the
+    // new blocks' slots are dead, so the commit made by the rollback compacts
+    // the delta
+    static uint8_t big[3000 * STORAGE_BLOCK_SIZE];
+    memset(big, 0xEE, sizeof(big));
+    ASSERT_OK(storage_write_block(storage, 5 * STORAGE_BLOCK_SIZE, big));
+    ASSERT_OK(storage_write_blocks(storage, 1000 * STORAGE_BLOCK_SIZE, big, 3000));
+    ASSERT_TRUE(file_size(DELTA_FILE) > 3000 * STORAGE_BLOCK_SIZE);
+    ASSERT_OK(storage_apply_rollback(storage));
+    ASSERT_EQ_INT(DELTA_DATA_OFFSET + 102 * STORAGE_BLOCK_SIZE, file_size(DELTA_FILE));
+
+    // Explicit compaction refuses uncommitted blocks, and keeps the data
+    fill_block(200, 0x61, block);
+    ASSERT_OK(storage_write_block(storage, 200 * STORAGE_BLOCK_SIZE, block));
+    ASSERT_ERR(storage_compact(storage), GS_ERROR);
+    ASSERT_OK(storage_clear_rollback(storage));
+    ASSERT_OK(storage_compact(storage));
+    ASSERT_EQ_INT(DELTA_DATA_OFFSET + 103 * STORAGE_BLOCK_SIZE, file_size(DELTA_FILE));
+    ASSERT_OK(storage_delete(storage));
+
+    storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+    for (size_t lba = 0; lba < 1100; lba++) {
+        ASSERT_OK(storage_read_block(storage, lba * STORAGE_BLOCK_SIZE, block));
+        expect_block(lba, lba < 100 ? 0x60 : lba == 200 ? 0x61 : 0x33, block);
+    }
+    ASSERT_OK(storage_delete(storage));
+    teardown_sandbox();
+}
+
+// --- Block cache ------------------------------------------------------------
+
+TEST(storage_block_cache) {
+    setup_sandbox();
+    create_base_image(BASE_FILE, TEST_BLOCKS, 0x5A);
+    storage_config_t config = make_config(BASE_FILE, DELTA_FILE, JOURNAL_FILE, TEST_BLOCKS);
+    storage_t *storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+    storage_cache_stats_t stats;
+    storage_cache_stats(storage, &stats);
+    ASSERT_EQ_INT(STORAGE_CACHE_DEFAULT_BLOCKS, (int)stats.capacity);
+
+    // The first read misses, the second is served from the cache
+    uint8_t block[STORAGE_BLOCK_SIZE];
+    ASSERT_OK(storage_read_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    ASSERT_OK(storage_read_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    expect_block(9, 0x5A, block);
+    storage_cache_stats(storage, &stats);
+    ASSERT_EQ_INT(1, (int)stats.misses);
+    ASSERT_EQ_INT(1, (int)stats.hits);
+
+    // Writes go through to cached copies
+    fill_block(9, 0x01, block);
+    ASSERT_OK(storage_write_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    ASSERT_OK(storage_clear_rollback(storage));
+    memset(block, 0, sizeof(block));
+    ASSERT_OK(storage_read_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    expect_block(9, 0x01, block);
+
+    // Rollback drops them: the preimage is read back, not the cached data
+    fill_block(9, 0x02, block);
+    ASSERT_OK(storage_write_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    ASSERT_OK(storage_read_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    expect_block(9, 0x02, block);
+    ASSERT_OK(storage_apply_rollback(storage));
+    ASSERT_OK(storage_read_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    expect_block(9, 0x01, block);
+
+    // A cache of four blocks evicts the least recently used one
+    ASSERT_OK(storage_set_cache_size(storage, 4));
+    for (size_t lba = 20; lba < 24; lba++)
+        ASSERT_OK(storage_read_block(storage, lba * STORAGE_BLOCK_SIZE, block));
+    ASSERT_OK(storage_read_block(storage, 20 * STORAGE_BLOCK_SIZE, block)); // 21 is now the oldest
+    ASSERT_OK(storage_read_block(storage, 24 * STORAGE_BLOCK_SIZE, block));
+    storage_cache_stats(storage, &stats);
+    uint64_t misses = stats.misses;
+    ASSERT_OK(storage_read_block(storage, 20 * STORAGE_BLOCK_SIZE, block));
+    storage_cache_stats(storage, &stats);
+    ASSERT_EQ_INT((int)misses, (int)stats.misses);
+    ASSERT_OK(storage_read_block(storage, 21 * STORAGE_BLOCK_SIZE, block));
+    expect_block(21, 0x5A, block);
+    storage_cache_stats(storage, &stats);
+    ASSERT_EQ_INT((int)misses + 1, (int)stats.misses);
+    ASSERT_EQ_INT(4, (int)stats.used);
+
+    // Off: every read goes to the files
+    ASSERT_OK(storage_set_cache_size(storage, 0));
+    ASSERT_OK(storage_read_block(storage, 9 * STORAGE_BLOCK_SIZE, block));
+    expect_block(9, 0x01, block);
+    storage_cache_stats(storage, &stats);
+    ASSERT_EQ_INT(0, (int)stats.capacity);
+
+    ASSERT_OK(storage_delete(storage));
+    teardown_sandbox();
+}
+
+TEST(storage_readahead) {
+    setup_sandbox();
+    create_base_image(BASE_FILE, TEST_BLOCKS, 0x3C);
+    storage_config_t config = make_config(BASE_FILE, DELTA_FILE, JOURNAL_FILE, TEST_BLOCKS);
+    storage_t *storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+
+    // Scattered reads queue nothing
+    uint8_t buffer[8 * STORAGE_BLOCK_SIZE];
+    ASSERT_OK(storage_read_blocks(storage, 40 * STORAGE_BLOCK_SIZE, buffer, 8));
+    ASSERT_OK(storage_read_blocks(storage, 4 * STORAGE_BLOCK_SIZE, buffer, 8));
+    ASSERT_OK(storage_tick(storage));
+    storage_cache_stats_t stats;
+    storage_cache_stats(storage, &stats);
+    ASSERT_EQ_INT(0, (int)stats.readahead);
+
+    // Two sequential 8-block reads make a stream; the tick loads what follows
+    ASSERT_OK(storage_read_blocks(storage, 12 * STORAGE_BLOCK_SIZE, buffer, 8));
+    ASSERT_OK(storage_tick(storage));
+    storage_cache_stats(storage, &stats);
+    ASSERT_TRUE(stats.readahead >= 8);
+    uint64_t misses = stats.misses;
+    ASSERT_OK(storage_read_blocks(storage, 20 * STORAGE_BLOCK_SIZE, buffer, 8));
+    for (size_t i = 0; i < 8; i++)
+        expect_block(20 + i, 0x3C, buffer + i * STORAGE_BLOCK_SIZE);
+    storage_cache_stats(storage, &stats);
+    ASSERT_EQ_INT((int)misses, (int)stats.misses);
+
+    // Readahead stops at the end of the disk
+    ASSERT_OK(storage_read_blocks(storage, (TEST_BLOCKS - 16) * STORAGE_BLOCK_SIZE, buffer, 8));
+    ASSERT_OK(storage_read_blocks(storage, (TEST_BLOCKS - 8) * STORAGE_BLOCK_SIZE, buffer, 8));
+    ASSERT_OK(storage_read_blocks(storage, (TEST_BLOCKS - 8) * STORAGE_BLOCK_SIZE, buffer, 8));
+    ASSERT_OK(storage_tick(storage));
+
+    ASSERT_OK(storage_delete(storage));
+    teardown_sandbox();
+}
+
+// --- Decoded base ---------------------------------------------------------
+
+// Base reader generating fill_block(lba, 0x70) contents; counts its calls
+static int pattern_base_read(void *context, uint64_t offset, void *buffer, size_t len) {
+    (*(int *)context)++;
+    for (size_t i = 0; i < len; i += STORAGE_BLOCK_SIZE)
+        fill_block((size_t)((offset + i) / STORAGE_BLOCK_SIZE), 0x70, (uint8_t *)buffer + i);
+    return GS_SUCCESS;
+}
+
+TEST(storage_decoded_base) {
+    setup_sandbox();
+    int calls = 0;
+    storage_config_t config = make_config(BASE_FILE, DELTA_FILE, JOURNAL_FILE, TEST_BLOCKS);
+    config.base_read = pattern_base_read; // BASE_FILE does not exist and is not opened
+    config.base_context = &calls;
+    storage_t *storage = NULL;
+    ASSERT_OK(storage_new(&config, &storage));
+    ASSERT_OK(storage_set_cache_size(storage, 0));
+
+    // Unmodified blocks come from the reader, modified ones from the delta
+    uint8_t block[STORAGE_BLOCK_SIZE];
+    fill_block(3, 0x01, block);
+    ASSERT_OK(storage_write_block(storage, 3 * STORAGE_BLOCK_SIZE, block));
+    uint8_t buffer[6 * STORAGE_BLOCK_SIZE];
+    ASSERT_OK(storage_read_blocks(storage, 1 * STORAGE_BLOCK_SIZE, buffer, 6));
+    expect_block(1, 0x70, buffer);
+    expect_block(2, 0x70, buffer + STORAGE_BLOCK_SIZE);
+    expect_block(3, 0x01, buffer + 2 * STORAGE_BLOCK_SIZE);
+    for (size_t i = 3; i < 6; i++)
+        expect_block(1 + i, 0x70, buffer + i * STORAGE_BLOCK_SIZE);
+    ASSERT_EQ_INT(2, calls); // one call per run of base blocks
+
     ASSERT_OK(storage_delete(storage));
     teardown_sandbox();
 }
@@ -404,6 +751,13 @@ int main(void) {
     RUN(storage_state_roundtrip);
     RUN(storage_delta_persistence);
     RUN(storage_rollback);
+    RUN(storage_multi_block_io);
+    RUN(storage_sparse_delta);
+    RUN(storage_delta_v1_migration);
+    RUN(storage_delta_compaction);
+    RUN(storage_block_cache);
+    RUN(storage_readahead);
+    RUN(storage_decoded_base);
     RUN(storage_block_size_532);
     RUN(storage_block_size_other);
     RUN(storage_block_size_validation);
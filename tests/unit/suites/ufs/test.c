@@ -0,0 +1,368 @@
+// UFS-1 walker unit tests.
+//
+// Like the hfsplus suite, image_ufs.c is driven through its public API over
+// an in-memory volume served by a disk_read_data() stub.  The fixture is a
+// hand-built 4.3BSD-Tahoe FFS (one cylinder group, 4 KB blocks, 1 KB
+// fragments, 1024 pointers per indirect block):
+//
+//   /sub/file0000 .. file0999   one-fragment files "file NNNN\n" (ino 10..)
+//   /big                        5.3 MB, reaching into the double-indirect
+//                               range, with a hole at logical block 5
+//
+// The stub counts disk_read_data calls, so the tests can check what the
+// inode, directory and block-map caches save.
+
+#include "image_ufs.h"
+#include "test_assert.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ---- In-memory image backing ----------------------------------------------
+
+#define FSIZE     1024u
+#define BSIZE     4096u
+#define NFRAGS    12288u // the whole volume: 12 MB
+#define IPG       2048u
+#define IBLKNO    16u // inode table at fragment 16
+#define N_FILES   1000u
+#define FILE_INO0 10u
+#define BIG_INO   4u
+#define SUB_INO   3u
+#define BIG_HOLE  5u // logical block of /big left unallocated
+#define BIG_SIZE  ((12u + 1024u + 300u) * BSIZE - 1000u)
+
+static uint8_t *g_img;
+static uint32_t g_next_frag; // fragment allocator
+static uint64_t g_reads; // disk_read_data calls
+
+size_t disk_read_data(image_t *disk, size_t offset, uint8_t *buf, size_t size) {
+    (void)disk;
+    if (offset + size > (size_t)NFRAGS * FSIZE)
+        return 0;
+    g_reads++;
+    memcpy(buf, g_img + offset, size);
+    return size;
+}
+
+// ---- Big-endian writers ----------------------------------------------------
+
+static void w16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void w32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// ---- Fixture builder -------------------------------------------------------
+
+static uint8_t *dinode(uint32_t ino) {
+    return g_img + (size_t)IBLKNO * FSIZE + (size_t)ino * 128;
+}
+
+// Allocate `n` fragments (whole blocks stay block-aligned)
+static uint32_t alloc_frags(uint32_t n) {
+    if (n == BSIZE / FSIZE)
+        g_next_frag = (g_next_frag + 3) & ~3u;
+    uint32_t f = g_next_frag;
+    g_next_frag += n;
+    return f;
+}
+
+// Expected byte of /big at offset `off`
+static uint8_t big_byte(uint64_t off) {
+    if (off / BSIZE == BIG_HOLE)
+        return 0;
+    return (uint8_t)(off * 7 + (off >> 12));
+}
+
+// Directory writer: entries packed into 512-byte chunks, as FFS lays them out
+typedef struct {
+    uint8_t buf[32 * 1024];
+    size_t len; // bytes of finished chunks plus the open one
+    size_t last; // offset of the last entry
+} dir_writer_t;
+
+static void dir_add(dir_writer_t *d, uint32_t ino, const char *name) {
+    size_t nl = strlen(name);
+    size_t rec = 8 + ((nl + 1 + 3) & ~(size_t)3);
+    if (d->len / 512 != (d->len + rec - 1) / 512) {
+        // Pad the open chunk with the previous entry's reclen
+        size_t end = (d->len + 511) & ~(size_t)511;
+        w16(d->buf + d->last + 4, (uint16_t)(end - d->last));
+        d->len = end;
+    }
+    uint8_t *e = d->buf + d->len;
+    w32(e, ino);
+    w16(e + 4, (uint16_t)rec);
+    w16(e + 6, (uint16_t)nl);
+    memcpy(e + 8, name, nl);
+    d->last = d->len;
+    d->len += rec;
+}
+
+// Finish a directory into data blocks and its dinode (direct blocks only)
+static void dir_finish(dir_writer_t *d, uint32_t ino) {
+    size_t end = (d->len + 511) & ~(size_t)511;
+    w16(d->buf + d->last + 4, (uint16_t)(end - d->last));
+    uint8_t *di = dinode(ino);
+    w16(di + 0, 0x4000 | 0755);
+    w16(di + 2, 2);
+    w32(di + 12, (uint32_t)end);
+    for (size_t b = 0; b * BSIZE < end; b++) {
+        uint32_t f = alloc_frags(BSIZE / FSIZE);
+        memcpy(g_img + (size_t)f * FSIZE, d->buf + b * BSIZE, end - b * BSIZE < BSIZE ? end - b * BSIZE : BSIZE);
+        w32(di + 40 + b * 4, f);
+    }
+}
+
+static void build_volume(void) {
+    free(g_img);
+    g_img = calloc(NFRAGS, FSIZE);
+    ASSERT_TRUE(g_img != NULL);
+    g_next_frag = IBLKNO + IPG * 128 / FSIZE;
+
+    uint8_t *sb = g_img + 8192;
+    w32(sb + 16, IBLKNO);
+    w32(sb + 24, 0); // cgoffset
+    w32(sb + 28, 0xFFFFFFFFu); // cgmask
+    w32(sb + 44, 1); // ncg
+    w32(sb + 48, BSIZE);
+    w32(sb + 52, FSIZE);
+    w32(sb + 56, BSIZE / FSIZE);
+    w32(sb + 100, 1); // fsbtodb
+    w32(sb + 116, BSIZE / 4); // nindir
+    w32(sb + 120, BSIZE / 128); // inopb
+    w32(sb + 184, IPG);
+    w32(sb + 188, NFRAGS);
+    w32(sb + 1372, UFS_FS_MAGIC);
+
+    // Small files, one fragment each
+    char name[32];
+    static dir_writer_t sub, root;
+    memset(&sub, 0, sizeof(sub));
+    memset(&root, 0, sizeof(root));
+    dir_add(&sub, SUB_INO, ".");
+    dir_add(&sub, UFS_ROOT_INO, "..");
+    for (uint32_t i = 0; i < N_FILES; i++) {
+        uint32_t ino = FILE_INO0 + i;
+        snprintf(name, sizeof(name), "file%04u", i);
+        dir_add(&sub, ino, name);
+        uint32_t f = alloc_frags(1);
+        int len = snprintf((char *)g_img + (size_t)f * FSIZE, FSIZE, "file %04u\n", i);
+        uint8_t *di = dinode(ino);
+        w16(di + 0, 0x8000 | 0644);
+        w16(di + 2, 1);
+        w32(di + 12, (uint32_t)len);
+        w32(di + 40, f);
+    }
+    dir_finish(&sub, SUB_INO);
+
+    // /big: direct, single- and double-indirect blocks
+    uint8_t *di = dinode(BIG_INO);
+    w16(di + 0, 0x8000 | 0644);
+    w16(di + 2, 1);
+    w32(di + 12, BIG_SIZE);
+    uint32_t nblk = (BIG_SIZE + BSIZE - 1) / BSIZE;
+    uint32_t ib1 = alloc_frags(4), ib2 = alloc_frags(4), l2 = 0;
+    w32(di + 88, ib1);
+    w32(di + 92, ib2);
+    for (uint32_t lbn = 0; lbn < nblk; lbn++) {
+        uint32_t f = 0;
+        if (lbn != BIG_HOLE) {
+            f = alloc_frags(4);
+            for (uint32_t i = 0; i < BSIZE; i++)
+                g_img[(size_t)f * FSIZE + i] = big_byte((uint64_t)lbn * BSIZE + i);
+        }
+        if (lbn < 12) {
+            w32(di + 40 + lbn * 4, f);
+        } else if (lbn < 12 + 1024) {
+            w32(g_img + (size_t)ib1 * FSIZE + (lbn - 12) * 4, f);
+        } else {
+            uint32_t rel = lbn - 12 - 1024;
+            if (rel % 1024 == 0) {
+                l2 = alloc_frags(4);
+                w32(g_img + (size_t)ib2 * FSIZE + (rel / 1024) * 4, l2);
+            }
+            w32(g_img + (size_t)l2 * FSIZE + (rel % 1024) * 4, f);
+        }
+    }
+    ASSERT_TRUE(g_next_frag <= NFRAGS);
+
+    dir_add(&root, UFS_ROOT_INO, ".");
+    dir_add(&root, UFS_ROOT_INO, "..");
+    dir_add(&root, SUB_INO, "sub");
+    dir_add(&root, BIG_INO, "big");
+    dir_finish(&root, UFS_ROOT_INO);
+}
+
+// ---- Tests ----------------------------------------------------------------
+
+// A non-NULL dummy image handle; disk_read_data ignores it.
+static image_t *const DUMMY = (image_t *)1;
+
+TEST(test_lookup_and_read) {
+    build_volume();
+    ufs_volume_t *vol = ufs_open(DUMMY, 0, (uint64_t)NFRAGS * FSIZE);
+    ASSERT_TRUE(vol != NULL);
+
+    ufs_dirent_t de;
+    const char *path[] = {"sub", "file0123"};
+    ASSERT_EQ_INT(0, ufs_lookup(vol, path, 2, &de));
+    ASSERT_EQ_INT(FILE_INO0 + 123, (int)de.ino);
+    ASSERT_EQ_INT(10, (int)de.size);
+    char buf[16] = {0};
+    size_t got = 0;
+    ASSERT_EQ_INT(0, ufs_read_file(vol, de.ino, 0, buf, sizeof(buf), &got));
+    ASSERT_EQ_INT(10, (int)got);
+    ASSERT_EQ_INT(0, memcmp(buf, "file 0123\n", 10));
+
+    const char *missing[] = {"sub", "file1000"};
+    ASSERT_EQ_INT(-ENOENT, ufs_lookup(vol, missing, 2, &de));
+    const char *folded[] = {"SUB"}; // UFS is case-sensitive
+    ASSERT_EQ_INT(-ENOENT, ufs_lookup(vol, folded, 1, &de));
+    const char *under_file[] = {"big", "x"};
+    ASSERT_EQ_INT(-ENOTDIR, ufs_lookup(vol, under_file, 2, &de));
+    ufs_close(vol);
+}
+
+TEST(test_readdir_loads_inodes_by_sector) {
+    build_volume();
+    ufs_volume_t *vol = ufs_open(DUMMY, 0, (uint64_t)NFRAGS * FSIZE);
+    ASSERT_TRUE(vol != NULL);
+
+    ufs_dir_iter_t *it = ufs_opendir_ino(vol, SUB_INO);
+    ASSERT_TRUE(it != NULL);
+    ufs_dirent_t de;
+    char name[32];
+    uint32_t n = 0;
+    for (; ufs_readdir_next(it, &de) == 1; n++) {
+        snprintf(name, sizeof(name), "file%04u", n);
+        ASSERT_EQ_INT(0, strcmp(de.name, name));
+        ASSERT_EQ_INT((int)(FILE_INO0 + n), (int)de.ino);
+    }
+    ufs_closedir_iter(it);
+    ASSERT_EQ_INT(N_FILES, (int)n);
+
+    // Four dinodes per sector: one miss brings in the next three
+    ufs_cache_stats_t st;
+    ufs_cache_stats(vol, &st);
+    ASSERT_TRUE(st.inode_misses <= N_FILES / 4 + 2);
+    ASSERT_TRUE(st.inode_hits >= N_FILES - N_FILES / 4 - 2);
+    ufs_close(vol);
+}
+
+TEST(test_big_file_block_map) {
+    build_volume();
+    ufs_volume_t *vol = ufs_open(DUMMY, 0, (uint64_t)NFRAGS * FSIZE);
+    ASSERT_TRUE(vol != NULL);
+    const char *path[] = {"big"};
+    ufs_dirent_t de;
+    ASSERT_EQ_INT(0, ufs_lookup(vol, path, 1, &de));
+    ASSERT_EQ_INT(BIG_SIZE, (int)de.size);
+
+    // Sequential read in odd-sized chunks, through the hole and every
+    // indirection level
+    static uint8_t buf[65536 + 123];
+    uint64_t off = 0;
+    uint32_t calls = 0;
+    for (;; calls++) {
+        size_t got = 0;
+        ASSERT_EQ_INT(0, ufs_read_file(vol, BIG_INO, off, buf, sizeof(buf), &got));
+        for (size_t i = 0; i < got; i++)
+            if (buf[i] != big_byte(off + i))
+                ASSERT_EQ_INT(big_byte(off + i), buf[i]);
+        if (got == 0)
+            break;
+        off += got;
+    }
+    ASSERT_EQ_INT(BIG_SIZE, (int)off);
+
+    // One block map serves every call
+    ufs_cache_stats_t st;
+    ufs_cache_stats(vol, &st);
+    ASSERT_EQ_INT(1, (int)st.bmap_misses);
+    ASSERT_EQ_INT((int)calls, (int)st.bmap_hits);
+
+    // Reads straddling the direct / single / double indirect boundaries
+    const uint64_t edges[] = {12 * BSIZE - 100, (12 + 1024) * BSIZE - 100, BIG_HOLE * BSIZE - 1, BIG_SIZE - 50};
+    for (size_t e = 0; e < sizeof(edges) / sizeof(edges[0]); e++) {
+        size_t got = 0;
+        ASSERT_EQ_INT(0, ufs_read_file(vol, BIG_INO, edges[e], buf, 200, &got));
+        ASSERT_EQ_INT((int)(edges[e] + 200 > BIG_SIZE ? BIG_SIZE - edges[e] : 200), (int)got);
+        for (size_t i = 0; i < got; i++)
+            ASSERT_EQ_INT(big_byte(edges[e] + i), buf[i]);
+    }
+    ufs_close(vol);
+}
+
+// Monotonic time in nanoseconds
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Extract every file of /sub the way image_vfs does (lookup, then read)
+static void extract_all(ufs_volume_t *vol) {
+    char name[32], buf[64];
+    const char *path[2] = {"sub", name};
+    for (uint32_t i = 0; i < N_FILES; i++) {
+        snprintf(name, sizeof(name), "file%04u", i);
+        ufs_dirent_t de;
+        ASSERT_EQ_INT(0, ufs_lookup(vol, path, 2, &de));
+        size_t got = 0;
+        ASSERT_EQ_INT(0, ufs_read_file(vol, de.ino, 0, buf, sizeof(buf), &got));
+        ASSERT_EQ_INT(10, (int)got);
+    }
+}
+
+TEST(test_extract_tree_bench) {
+    build_volume();
+    ufs_volume_t *vol = ufs_open(DUMMY, 0, (uint64_t)NFRAGS * FSIZE);
+    ASSERT_TRUE(vol != NULL);
+
+    g_reads = 0;
+    uint64_t t0 = now_ns();
+    extract_all(vol);
+    uint64_t t_cold = now_ns() - t0;
+    uint64_t reads_cold = g_reads;
+
+    g_reads = 0;
+    t0 = now_ns();
+    extract_all(vol);
+    uint64_t t_warm = now_ns() - t0;
+    uint64_t reads_warm = g_reads;
+
+    // Warm, the only image reads left are the files' data
+    ASSERT_EQ_INT(N_FILES, (int)reads_warm);
+    ufs_cache_stats_t st;
+    ufs_cache_stats(vol, &st);
+    ASSERT_EQ_INT(2, (int)st.dir_misses); // / and /sub, once each
+    printf("[BENCH] UFS extract of %u files: cold %.2f us/file (%.2f reads), warm %.2f us/file (%.2f reads); "
+           "inode %llu/%llu dir %llu/%llu hits/misses\n",
+           N_FILES, (double)t_cold / 1e3 / N_FILES, (double)reads_cold / N_FILES, (double)t_warm / 1e3 / N_FILES,
+           (double)reads_warm / N_FILES, (unsigned long long)st.inode_hits, (unsigned long long)st.inode_misses,
+           (unsigned long long)st.dir_hits, (unsigned long long)st.dir_misses);
+    ufs_close(vol);
+    free(g_img);
+    g_img = NULL;
+}
+
+int main(void) {
+    RUN(test_lookup_and_read);
+    RUN(test_readdir_loads_inodes_by_sector);
+    RUN(test_big_file_block_map);
+    RUN(test_extract_tree_bench);
+    fprintf(stderr, "All ufs tests passed.\n");
+    return 0;
+}
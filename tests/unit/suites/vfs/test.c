@@ -1,9 +1,11 @@
 // Unit tests for the VFS layer and APM parser.
 // The APM tests drive image_apm_parse_buffer with synthetic bytes to avoid
 // pulling in the full image/storage stack.  The VFS tests exercise the
-// host backend against a temporary sandbox directory.
+// host backend against a temporary sandbox directory, and the HFS catalog
+// benchmark drives image_hfs.c over a synthetic in-memory volume.
 
 #include "image_apm.h"
+#include "image_hfs.h"
 #include "test_assert.h"
 #include "vfs.h"
 
@@ -15,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #define SANDBOX_DIR "_test_sandbox_vfs"
@@ -370,6 +373,246 @@ TEST(vfs_resolve_normalises_relative) {
     ASSERT_TRUE(tail == resolved);
 }
 
+// ============================================================================
+// HFS+ catalog index benchmark
+// ============================================================================
+//
+// A synthetic HFS+ volume with BENCH_DIRS folders of BENCH_FILES files each,
+// built in memory and served to image_hfs.c through a disk_read_data stub.
+// Path lookups and `ls -R`-style walks must cost per entry, not per catalog
+// record.
+
+#define HFS_BLK      4096u
+#define BENCH_DIRS   40u
+#define BENCH_FILES  500u
+#define BENCH_LOOKUP 100000u
+
+static uint8_t *g_hfs_img;
+static size_t g_hfs_size;
+static size_t g_hfs_read; // bytes served by disk_read_data
+
+// The one storage entry point image_hfs.c uses, backed by g_hfs_img.
+size_t disk_read_data(image_t *disk, size_t offset, uint8_t *buf, size_t size) {
+    (void)disk;
+    if (offset + size > g_hfs_size)
+        return 0;
+    g_hfs_read += size;
+    memcpy(buf, g_hfs_img + offset, size);
+    return size;
+}
+
+// Monotonic time in nanoseconds
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Node writer: packs catalog records into consecutive 4 KB nodes of one
+// B-tree level, catalog nodes base, base + 1, ...
+typedef struct {
+    uint32_t base; // catalog node number of the level's first node
+    uint8_t kind; // 0xFF leaf, 0 index
+    uint8_t height;
+    size_t node; // byte offset of the node being filled
+    size_t used; // bytes of records in it (after the 14-byte descriptor)
+    uint16_t nrecs;
+    uint16_t offs[HFS_BLK / 2];
+    uint32_t nodes; // nodes started
+} node_writer_t;
+
+// Close the current node: record count and the offset table at its end
+static void node_finish(node_writer_t *w) {
+    uint8_t *n = g_hfs_img + w->node;
+    put_be16(n + 10, w->nrecs);
+    w->offs[w->nrecs] = (uint16_t)(14 + w->used);
+    for (uint16_t i = 0; i <= w->nrecs; i++)
+        put_be16(n + HFS_BLK - (size_t)(i + 1) * 2, w->offs[i]);
+}
+
+// Append a record (key parent + ASCII name, `data_len` bytes of record data
+// or child pointer filled by the caller through the returned pointer)
+static uint8_t *node_add(node_writer_t *w, uint32_t parent, const char *name, size_t data_len) {
+    size_t nl = strlen(name);
+    size_t len = 8 + nl * 2 + data_len;
+    if (w->nodes == 0 || 14 + w->used + len + (size_t)(w->nrecs + 2) * 2 > HFS_BLK) {
+        if (w->nodes > 0) {
+            node_finish(w);
+            put_be32(g_hfs_img + w->node, w->base + w->nodes); // fLink to the next node
+        }
+        w->node = (size_t)(w->base + w->nodes++ + 1) * HFS_BLK; // catalog node k is volume block k + 1
+        w->used = 0;
+        w->nrecs = 0;
+        g_hfs_img[w->node + 8] = w->kind;
+        g_hfs_img[w->node + 9] = w->height;
+    }
+    uint8_t *r = g_hfs_img + w->node + 14 + w->used;
+    w->offs[w->nrecs++] = (uint16_t)(14 + w->used);
+    w->used += len;
+    put_be16(r, (uint16_t)(6 + nl * 2)); // keyLength
+    put_be32(r + 2, parent);
+    put_be16(r + 6, (uint16_t)nl);
+    for (size_t i = 0; i < nl; i++)
+        put_be16(r + 8 + i * 2, (uint8_t)name[i]);
+    return r + 8 + nl * 2;
+}
+
+// Build the volume: root "Bench" holding dirNNN folders (CNID 16 + d), each
+// holding fileNNNNN files (CNID 1000 + d * BENCH_FILES + f), in key order,
+// under index levels up to a single root node.
+static void build_bench_volume(void) {
+    size_t max_nodes = (BENCH_DIRS * (BENCH_FILES + 1) + 1) / 10 + 64;
+    g_hfs_size = (max_nodes + 2) * HFS_BLK;
+    g_hfs_img = calloc(1, g_hfs_size);
+    ASSERT_TRUE(g_hfs_img != NULL);
+
+    node_writer_t w = {.base = 1, .kind = 0xFF, .height = 1};
+    char name[32];
+    uint8_t *d = node_add(&w, 1, "Bench", 88);
+    put_be16(d, 1); // folder
+    put_be32(d + 4, BENCH_DIRS); // valence
+    put_be32(d + 8, 2); // folderID = root
+    for (uint32_t i = 0; i < BENCH_DIRS; i++) {
+        snprintf(name, sizeof(name), "dir%03u", i);
+        d = node_add(&w, 2, name, 88);
+        put_be16(d, 1);
+        put_be32(d + 4, BENCH_FILES);
+        put_be32(d + 8, 16 + i);
+    }
+    for (uint32_t i = 0; i < BENCH_DIRS; i++) {
+        for (uint32_t f = 0; f < BENCH_FILES; f++) {
+            snprintf(name, sizeof(name), "file%05u", f);
+            d = node_add(&w, 16 + i, name, 248);
+            put_be16(d, 2); // file
+            put_be32(d + 8, 1000 + i * BENCH_FILES + f); // fileID
+        }
+    }
+    node_finish(&w);
+    uint32_t leaves = w.nodes;
+
+    // Index levels: one record per node below, keyed by its first key
+    uint32_t level = 1, level_nodes = leaves, next = 1 + leaves;
+    for (uint8_t height = 2; level_nodes > 1; height++) {
+        node_writer_t x = {.base = next, .kind = 0, .height = height};
+        for (uint32_t c = level; c < level + level_nodes; c++) {
+            const uint8_t *k = g_hfs_img + (size_t)(c + 1) * HFS_BLK + 14; // first record
+            uint32_t parent = ((uint32_t)k[2] << 24) | ((uint32_t)k[3] << 16) | ((uint32_t)k[4] << 8) | k[5];
+            size_t nl = ((size_t)k[6] << 8) | k[7];
+            for (size_t i = 0; i < nl; i++)
+                name[i] = (char)k[9 + i * 2];
+            name[nl] = 0;
+            put_be32(node_add(&x, parent, name, 4), c);
+        }
+        node_finish(&x);
+        level = next;
+        level_nodes = x.nodes;
+        next += x.nodes;
+    }
+    ASSERT_TRUE(next + 1 <= max_nodes + 2);
+
+    // Volume Header at 1024; the catalog file is header node 0 (block 1),
+    // the leaves, then the index nodes
+    uint32_t cat_nodes = next;
+    uint8_t *vh = g_hfs_img + 1024;
+    put_be16(vh + 0x00, 0x482B); // "H+"
+    put_be16(vh + 0x02, 4);
+    put_be32(vh + 0x28, HFS_BLK); // blockSize
+    put_be32(vh + 0x2C, (uint32_t)(g_hfs_size / HFS_BLK)); // totalBlocks
+    uint8_t *cat = vh + 0x110; // catalogFile fork
+    put_be32(cat + 0x04, cat_nodes * HFS_BLK); // logicalSize (low word)
+    put_be32(cat + 0x0C, cat_nodes); // totalBlocks
+    put_be32(cat + 0x10, 1); // extents[0].startBlock
+    put_be32(cat + 0x14, cat_nodes); // extents[0].blockCount
+
+    uint8_t *hdr = g_hfs_img + HFS_BLK;
+    hdr[8] = 1; // kind = header
+    put_be16(hdr + 10, 3);
+    put_be16(hdr + 14, g_hfs_img[(size_t)(level + 1) * HFS_BLK + 9]); // treeDepth
+    put_be32(hdr + 14 + 2, level); // rootNode
+    put_be32(hdr + 14 + 10, 1); // firstLeafNode
+    put_be32(hdr + 14 + 14, leaves); // lastLeafNode
+    put_be16(hdr + 14 + 18, HFS_BLK); // nodeSize
+}
+
+// Open the bench volume and check it: root valence, random path lookups
+// (`lookups` of them), a miss, and an `ls -R` walk.  Returns the bytes
+// read by hfs_open.
+static size_t bench_catalog(const char *mode, uint32_t lookups) {
+    static image_t *const img = (image_t *)1; // disk_read_data ignores it
+
+    g_hfs_read = 0;
+    uint64_t t0 = now_ns();
+    hfs_volume_t *vol = hfs_open(img, 0, g_hfs_size);
+    uint64_t t_open = now_ns() - t0;
+    size_t open_read = g_hfs_read;
+    ASSERT_TRUE(vol != NULL);
+    ASSERT_TRUE(strcmp(hfs_volume_name(vol), "Bench") == 0);
+
+    hfs_dirent_t ent;
+    ASSERT_EQ_INT(0, hfs_lookup(vol, NULL, 0, &ent));
+    ASSERT_EQ_INT(BENCH_DIRS, (int)ent.valence);
+
+    // Random path lookups, including case-folded ones
+    char dir[16], file[16];
+    const char *path[2] = {dir, file};
+    uint32_t seed = 1;
+    t0 = now_ns();
+    for (uint32_t i = 0; i < lookups; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t di = (seed >> 8) % BENCH_DIRS, fi = (seed >> 16) % BENCH_FILES;
+        snprintf(dir, sizeof(dir), (i & 1) ? "DIR%03u" : "dir%03u", di);
+        snprintf(file, sizeof(file), "file%05u", fi);
+        ASSERT_EQ_INT(0, hfs_lookup(vol, path, 2, &ent));
+        ASSERT_EQ_INT((int)(1000 + di * BENCH_FILES + fi), (int)ent.cnid);
+    }
+    uint64_t t_lookup = now_ns() - t0;
+    snprintf(file, sizeof(file), "file%05u", BENCH_FILES);
+    ASSERT_EQ_INT(-ENOENT, hfs_lookup(vol, path, 2, &ent));
+
+    // ls -R: every folder, every child, in catalog order
+    t0 = now_ns();
+    size_t seen = 0;
+    hfs_dir_iter_t *root = hfs_opendir_cnid(vol, HFS_ROOT_CNID);
+    ASSERT_TRUE(root != NULL);
+    hfs_dirent_t sub;
+    for (uint32_t i = 0; hfs_readdir_next(root, &sub) == 1; i++) {
+        ASSERT_TRUE(sub.is_dir);
+        ASSERT_EQ_INT((int)(16 + i), (int)sub.cnid);
+        hfs_dir_iter_t *it = hfs_opendir_cnid(vol, sub.cnid);
+        ASSERT_TRUE(it != NULL);
+        for (uint32_t f = 0; hfs_readdir_next(it, &ent) == 1; f++) {
+            snprintf(file, sizeof(file), "file%05u", f);
+            ASSERT_TRUE(strcmp(ent.name, file) == 0);
+            seen++;
+        }
+        hfs_closedir_iter(it);
+    }
+    hfs_closedir_iter(root);
+    uint64_t t_walk = now_ns() - t0;
+    ASSERT_EQ_INT(BENCH_DIRS * BENCH_FILES, (int)seen);
+
+    printf("[BENCH] HFS+ catalog of %u records, %s: open %.2f ms (%zu KB read), lookup %.0f ns/path, "
+           "ls -R %.0f ns/entry\n",
+           BENCH_DIRS * (BENCH_FILES + 1) + 1, mode, (double)t_open / 1e6, open_read / 1024,
+           (double)t_lookup / lookups, (double)t_walk / (double)seen);
+    hfs_close(vol);
+    return open_read;
+}
+
+TEST(vfs_hfs_catalog_index_bench) {
+    build_bench_volume();
+
+    hfs_set_eager_catalog_limit(SIZE_MAX);
+    size_t eager_read = bench_catalog("loaded", BENCH_LOOKUP);
+    hfs_set_eager_catalog_limit(HFS_EAGER_CATALOG_MAX);
+    size_t lazy_read = bench_catalog("on demand", BENCH_LOOKUP / 10);
+
+    // Opening on demand reads the header and the root folder's leaf, not the catalog
+    ASSERT_TRUE(lazy_read <= 8 * HFS_BLK);
+    ASSERT_TRUE(eager_read > 100 * lazy_read);
+    free(g_hfs_img);
+}
+
 int main(void) {
     RUN(apm_parse_valid);
     RUN(apm_bad_signature);
@@ -382,5 +625,6 @@ int main(void) {
     RUN(vfs_resolve_descent_not_image);
     RUN(vfs_resolve_bare_file_strict);
     RUN(vfs_resolve_normalises_relative);
+    RUN(vfs_hfs_catalog_index_bench);
     return 0;
 }
@@ -29,6 +29,34 @@ void system_write_checkpoint_data_loc(checkpoint_t *checkpoint, const void *data
     (void)checkpoint; (void)data; (void)size; (void)file; (void)line;
 }
 
+void checkpoint_write_ram_loc(checkpoint_t *checkpoint, const uint8_t *ram, size_t size, const uint8_t *dirty,
+                              const char *file, int line) {
+    (void)checkpoint; (void)ram; (void)size; (void)dirty; (void)file; (void)line;
+}
+
+bool checkpoint_read_ram_loc(checkpoint_t *checkpoint, uint8_t *ram, size_t size, bool may_map, const char *file,
+                             int line) {
+    (void)checkpoint; (void)ram; (void)size; (void)may_map; (void)file; (void)line;
+    return false;
+}
+
+// Stub handles are never asynchronous, so memory_map_checkpoint takes the
+// synchronous RAM path
+bool checkpoint_is_async(checkpoint_t *checkpoint) {
+    (void)checkpoint;
+    return false;
+}
+
+void checkpoint_write_ram_deferred_loc(checkpoint_t *checkpoint, size_t size, const uint8_t *dirty,
+                                       bool (*read)(void *, size_t, uint8_t *, size_t), void (*release)(void *),
+                                       void *ctx, const char *file, int line) {
+    (void)checkpoint; (void)size; (void)dirty; (void)read; (void)file; (void)line;
+    if (release)
+        release(ctx);
+}
+
+void checkpoint_async_wait(void) {}
+
 bool checkpoint_has_error(checkpoint_t *checkpoint) {
     (void)checkpoint;
     return false;
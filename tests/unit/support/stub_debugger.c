@@ -1,6 +1,7 @@
 // Debugger stubs for unit tests
 // Provides no-op implementations of debugger functions.
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -15,6 +16,15 @@ int debug_break_and_trace(void) {
     return 0;
 }
 
+// Decoder PC watch: never engaged without the real debugger (weak so a suite
+// can install its own hook)
+bool g_debug_pc_hook = false;
+
+bool __attribute__((weak)) debug_pc_hook(uint32_t pc) {
+    (void)pc;
+    return false;
+}
+
 int debugger_disasm(char *buf, size_t buf_size, uint32_t addr) {
     (void)addr;
     if (buf && buf_size > 0)
@@ -7,9 +7,12 @@
 // Sound offset symbol referenced by inline functions in sound.h
 int snd_offset = 0;
 
-// Static stub page table so inline accessors in memory.h have a valid backing store
-static page_entry_t stub_page_table[1 << 16]; // zero-initialized for safe no-op access
-page_entry_t *g_page_table = stub_page_table;
+// Static stub page table so inline accessors in memory.h have a valid backing store:
+// every directory slot points at the same zero-initialized leaf (safe no-op access)
+static page_entry_t stub_page_leaf[PAGE_LEAF_SIZE];
+static page_entry_t *stub_page_table[(1 << 16) >> PAGE_LEAF_BITS] = {
+    [0 ... ((1 << 16) >> PAGE_LEAF_BITS) - 1] = stub_page_leaf};
+page_entry_t **g_page_table = stub_page_table;
 uint32_t g_address_mask = 0x00FFFFFFUL;
 uint32_t g_page_count = 1 << 16;
 